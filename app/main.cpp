@@ -4,43 +4,86 @@
  * 
  * Usage:
  *   rapid_doc_cli --input <pdf_path> --output <dir> [options]
+ *   rapid_doc_cli --input-dir <dir> | --input-list <file> --output <dir> [options]
  * 
  * Options:
  *   --input, -i     Input PDF file path
+ *   --input-dir     Process every PDF under a directory with one initialized pipeline
+ *   --input-list    Process the PDFs listed in a file, one path per line
+ *   --device-ids    Batch mode: one pipeline per DXRT device
+ *   --prefetch      Batch mode: files read ahead of the pipelines
+ *   --skip-existing Batch mode: skip documents whose content list already exists
  *   --output, -o    Output directory (default: ./output)
  *   --dpi           PDF rendering DPI (default: 200)
+ *   --layout-dpi    Render pages for layout at this DPI, OCR/table regions at --dpi
+ *   --layout-fast-resize  Box-filter layout resize instead of bicubic
  *   --max-pages     Max pages to process (0 = all)
+ *   --skip-blank-pages  Skip layout/OCR on pages below an ink coverage
  *   --no-table      Disable table recognition
  *   --no-ocr        Disable OCR
+ *   --text-layer    Read text regions from the PDF text layer, OCR the rest
  *   --json-only     Output JSON content list only (no Markdown)
+ *   --format        Content list as json (default) or cbor
+ *   --trace-out     Write a Chrome trace of the run to a file
+ *   --record        Record engine outputs and latencies to a directory
+ *   --replay        Replay recorded engine outputs (no NPU, no models)
  *   --verbose, -v   Verbose logging
  */
 
 #include "pipeline/doc_pipeline.h"
+#include "common/bounded_queue.h"
 #include "common/config.h"
 #include "common/logger.h"
+#include "common/perf_utils.h"
+#include "common/trace.h"
 #include "output/detail_report.h"
+#include "output/result_json.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <vector>
 #include <getopt.h>
 
 namespace fs = std::filesystem;
 
 void printUsage(const char* programName) {
     std::cout << "RapidDoc C++ - Document Analysis Pipeline (DEEPX NPU)\n\n";
-    std::cout << "Usage: " << programName << " -i <pdf_path> -o <dir> [options]\n\n";
+    std::cout << "Usage: " << programName << " -i <pdf_path> -o <dir> [options]\n";
+    std::cout << "       " << programName << " --input-dir <dir> | --input-list <file> -o <dir> [options]\n\n";
     std::cout << "Options:\n";
-    std::cout << "  -i, --input <path>      Input PDF file path (required)\n";
+    std::cout << "  -i, --input <path>      Input PDF file path\n";
+    std::cout << "      --input-dir <dir>   Process every PDF under <dir>; outputs mirror its layout\n";
+    std::cout << "      --input-list <file> Process the PDFs listed in <file>, one per line\n";
+    std::cout << "      --device-ids <a,b>  Batch mode: one pipeline per DXRT device (default: one pipeline)\n";
+    std::cout << "      --prefetch <num>    Batch mode: files read ahead of the pipelines (default: 2)\n";
+    std::cout << "      --skip-existing     Batch mode: skip documents whose content list already exists\n";
     std::cout << "  -o, --output <dir>      Output directory (default: ./output)\n";
     std::cout << "  -d, --dpi <num>         PDF rendering DPI (default: 200)\n";
+    std::cout << "      --layout-dpi <num>  Render pages at <num> for layout, OCR/table regions at --dpi\n";
+    std::cout << "      --layout-fast-resize  Box-filter layout resize instead of Python-exact bicubic\n";
     std::cout << "  -m, --max-pages <num>   Max pages to process (0 = all)\n";
+    std::cout << "      --skip-blank-pages <x>  Skip layout/OCR for pages with ink coverage <= x (e.g. 0.001)\n";
     std::cout << "      --no-table          Disable table recognition\n";
     std::cout << "      --no-ocr            Disable OCR\n";
+    std::cout << "      --text-layer        Read text regions from the PDF text layer, OCR the rest\n";
     std::cout << "      --json-only         Output JSON only (no Markdown)\n";
+    std::cout << "      --format <fmt>      Content list as json (default) or cbor\n";
     std::cout << "      --detail            Print and save a human-readable detail report\n";
     std::cout << "      --detail-file <p>   Override detail report output path\n";
+    std::cout << "      --trace-out <p>     Write a Chrome trace (chrome://tracing, Perfetto)\n";
+    std::cout << "      --record <dir>      Record layout/table/OCR outputs and latencies to <dir>\n";
+    std::cout << "      --replay <dir>      Answer layout/table/OCR from a --record directory (no NPU)\n";
+    std::cout << "      --replay-latency-scale <x>  Multiply replayed latencies (default: 1.0)\n";
     std::cout << "  -v, --verbose           Verbose logging\n";
     std::cout << "  -h, --help              Show this help\n";
     std::cout << "\n";
@@ -50,15 +93,31 @@ void printUsage(const char* programName) {
 
 struct CliArgs {
     std::string inputPath;
+    std::string inputDir;
+    std::string inputList;
+    std::vector<int> deviceIds;
+    int prefetch = 2;
+    bool skipExisting = false;
     std::string outputDir = "./output";
     int dpi = 200;
+    int layoutDpi = 0;
+    bool layoutFastResize = false;
     int maxPages = 0;
+    double blankPageInkRatio = 0.0;
     bool enableTable = true;
     bool enableOcr = true;
+    bool useTextLayer = false;
     bool jsonOnly = false;
+    rapid_doc::ResultFormat format = rapid_doc::ResultFormat::JSON;
     bool detail = false;
     std::string detailPath;
+    std::string traceOutPath;
+    std::string recordDir;
+    std::string replayDir;
+    double replayLatencyScale = 1.0;
     bool verbose = false;
+
+    bool batchMode() const { return !inputDir.empty() || !inputList.empty(); }
 };
 
 enum LongOnlyOpt {
@@ -67,19 +126,59 @@ enum LongOnlyOpt {
     OPT_JSON_ONLY,
     OPT_DETAIL,
     OPT_DETAIL_FILE,
+    OPT_TRACE_OUT,
+    OPT_RECORD,
+    OPT_REPLAY,
+    OPT_REPLAY_LATENCY_SCALE,
+    OPT_LAYOUT_DPI,
+    OPT_TEXT_LAYER,
+    OPT_LAYOUT_FAST_RESIZE,
+    OPT_FORMAT,
+    OPT_SKIP_BLANK_PAGES,
+    OPT_INPUT_DIR,
+    OPT_INPUT_LIST,
+    OPT_DEVICE_IDS,
+    OPT_PREFETCH,
+    OPT_SKIP_EXISTING,
 };
 
+std::vector<int> parseDeviceIds(const std::string& raw) {
+    std::vector<int> ids;
+    std::stringstream stream(raw);
+    std::string token;
+    while (std::getline(stream, token, ',')) {
+        if (!token.empty()) {
+            ids.push_back(std::atoi(token.c_str()));
+        }
+    }
+    return ids;
+}
+
 bool parseArgs(int argc, char* argv[], CliArgs& args) {
     static const struct option longOpts[] = {
         {"input",     required_argument, nullptr, 'i'},
+        {"input-dir", required_argument, nullptr, OPT_INPUT_DIR},
+        {"input-list", required_argument, nullptr, OPT_INPUT_LIST},
+        {"device-ids", required_argument, nullptr, OPT_DEVICE_IDS},
+        {"prefetch",  required_argument, nullptr, OPT_PREFETCH},
+        {"skip-existing", no_argument,   nullptr, OPT_SKIP_EXISTING},
         {"output",    required_argument, nullptr, 'o'},
         {"dpi",       required_argument, nullptr, 'd'},
         {"max-pages", required_argument, nullptr, 'm'},
+        {"layout-dpi", required_argument, nullptr, OPT_LAYOUT_DPI},
+        {"layout-fast-resize", no_argument, nullptr, OPT_LAYOUT_FAST_RESIZE},
         {"no-table",  no_argument,       nullptr, OPT_NO_TABLE},
         {"no-ocr",    no_argument,       nullptr, OPT_NO_OCR},
+        {"text-layer", no_argument,      nullptr, OPT_TEXT_LAYER},
         {"json-only", no_argument,       nullptr, OPT_JSON_ONLY},
+        {"format",    required_argument, nullptr, OPT_FORMAT},
+        {"skip-blank-pages", required_argument, nullptr, OPT_SKIP_BLANK_PAGES},
         {"detail",    no_argument,       nullptr, OPT_DETAIL},
         {"detail-file", required_argument, nullptr, OPT_DETAIL_FILE},
+        {"trace-out", required_argument, nullptr, OPT_TRACE_OUT},
+        {"record",    required_argument, nullptr, OPT_RECORD},
+        {"replay",    required_argument, nullptr, OPT_REPLAY},
+        {"replay-latency-scale", required_argument, nullptr, OPT_REPLAY_LATENCY_SCALE},
         {"verbose",   no_argument,       nullptr, 'v'},
         {"help",      no_argument,       nullptr, 'h'},
         {nullptr,     0,                 nullptr, 0}
@@ -89,22 +188,42 @@ bool parseArgs(int argc, char* argv[], CliArgs& args) {
     while ((opt = getopt_long(argc, argv, "i:o:d:m:vh", longOpts, nullptr)) != -1) {
         switch (opt) {
             case 'i': args.inputPath = optarg; break;
+            case OPT_INPUT_DIR: args.inputDir = optarg; break;
+            case OPT_INPUT_LIST: args.inputList = optarg; break;
+            case OPT_DEVICE_IDS: args.deviceIds = parseDeviceIds(optarg); break;
+            case OPT_PREFETCH: args.prefetch = std::max(1, std::atoi(optarg)); break;
+            case OPT_SKIP_EXISTING: args.skipExisting = true; break;
             case 'o': args.outputDir = optarg; break;
             case 'd': args.dpi = std::atoi(optarg); break;
             case 'm': args.maxPages = std::atoi(optarg); break;
+            case OPT_LAYOUT_DPI: args.layoutDpi = std::atoi(optarg); break;
+            case OPT_LAYOUT_FAST_RESIZE: args.layoutFastResize = true; break;
+            case OPT_SKIP_BLANK_PAGES: args.blankPageInkRatio = std::max(0.0, std::atof(optarg)); break;
             case OPT_NO_TABLE: args.enableTable = false; break;
             case OPT_NO_OCR:   args.enableOcr = false; break;
+            case OPT_TEXT_LAYER: args.useTextLayer = true; break;
             case OPT_JSON_ONLY: args.jsonOnly = true; break;
+            case OPT_FORMAT:
+                if (!rapid_doc::parseResultFormat(optarg, args.format)) {
+                    std::cerr << "Error: --format must be json or cbor\n";
+                    return false;
+                }
+                break;
             case OPT_DETAIL: args.detail = true; break;
             case OPT_DETAIL_FILE: args.detailPath = optarg; break;
+            case OPT_TRACE_OUT: args.traceOutPath = optarg; break;
+            case OPT_RECORD: args.recordDir = optarg; break;
+            case OPT_REPLAY: args.replayDir = optarg; break;
+            case OPT_REPLAY_LATENCY_SCALE: args.replayLatencyScale = std::atof(optarg); break;
             case 'v': args.verbose = true; break;
             case 'h': printUsage(argv[0]); return false;
             default:  printUsage(argv[0]); return false;
         }
     }
 
-    if (args.inputPath.empty()) {
-        std::cerr << "Error: --input is required\n";
+    const int inputs = !args.inputPath.empty() + !args.inputDir.empty() + !args.inputList.empty();
+    if (inputs != 1) {
+        std::cerr << "Error: exactly one of --input, --input-dir or --input-list is required\n";
         printUsage(argv[0]);
         return false;
     }
@@ -112,6 +231,288 @@ bool parseArgs(int argc, char* argv[], CliArgs& args) {
     return true;
 }
 
+// ---------------------------------------------------------------------------
+// Batch mode: many documents through pipelines initialized once
+// ---------------------------------------------------------------------------
+
+struct BatchInput {
+    fs::path path;
+    fs::path outputDir;     // this document's Markdown, content list and images
+    std::string baseName;
+};
+
+/// PDFs of --input-dir (recursive, sorted) or --input-list, each with its own output directory
+std::vector<BatchInput> collectBatchInputs(const CliArgs& args) {
+    std::vector<BatchInput> inputs;
+    const fs::path outputRoot(args.outputDir);
+    if (!args.inputDir.empty()) {
+        const fs::path root(args.inputDir);
+        std::vector<fs::path> pdfs;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+             !ec && it != end; it.increment(ec)) {
+            std::string extension = it->path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                           [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            if (extension == ".pdf" && it->is_regular_file(ec)) {
+                pdfs.push_back(it->path());
+            }
+        }
+        std::sort(pdfs.begin(), pdfs.end());
+        for (const auto& pdf : pdfs) {
+            const fs::path relative = pdf.lexically_relative(root);
+            inputs.push_back({pdf, outputRoot / relative.parent_path() / pdf.stem(), pdf.stem().string()});
+        }
+        return inputs;
+    }
+
+    std::ifstream list(args.inputList);
+    std::string line;
+    std::vector<fs::path> seen;
+    for (size_t lineNo = 1; std::getline(list, line); ++lineNo) {
+        while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const fs::path pdf(line);
+        fs::path outputDir = outputRoot / pdf.stem();
+        if (std::find(seen.begin(), seen.end(), outputDir) != seen.end()) {
+            // Same file name from another directory; the line number keeps it stable across resumes.
+            outputDir = outputRoot / (pdf.stem().string() + "_" + std::to_string(lineNo));
+        }
+        seen.push_back(outputDir);
+        inputs.push_back({pdf, outputDir, pdf.stem().string()});
+    }
+    return inputs;
+}
+
+fs::path contentListPath(const BatchInput& input, rapid_doc::ResultFormat format) {
+    return input.outputDir / (input.baseName + "_content" + rapid_doc::resultFormatExtension(format));
+}
+
+bool readFileBytes(const fs::path& path, std::string& bytes) {
+    std::error_code ec;
+    const auto size = fs::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    if (ec || !in) {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(size));
+    return static_cast<bool>(in.read(bytes.data(), static_cast<std::streamsize>(bytes.size())));
+}
+
+/**
+ * @brief Run one document with its outputs streamed to .part files
+ *
+ * The files take their final names only once the document is complete, and
+ * the content list goes last, so --skip-existing never mistakes an
+ * interrupted document for a finished one.
+ */
+rapid_doc::DocumentResult processBatchDocument(
+    rapid_doc::DocPipeline& pipeline,
+    const BatchInput& input,
+    const std::string& bytes,
+    const CliArgs& args)
+{
+    fs::create_directories(input.outputDir);
+    const fs::path mdPath = input.outputDir / (input.baseName + ".md");
+    const fs::path contentPath = contentListPath(input, args.format);
+    const fs::path mdPart = mdPath.string() + ".part";
+    const fs::path contentPart = contentPath.string() + ".part";
+
+    rapid_doc::PipelineRunOverrides overrides;
+    overrides.outputDir = input.outputDir.string();
+    overrides.traceId = input.baseName;
+    std::ofstream mdFile;
+    if (!args.jsonOnly) {
+        mdFile.open(mdPart);
+        overrides.markdownSink = rapid_doc::makeStreamSink(mdFile);
+    }
+    std::ofstream contentFile(contentPart, std::ios::binary);
+    if (args.format == rapid_doc::ResultFormat::JSON) {
+        overrides.contentListSink = rapid_doc::makeStreamSink(contentFile);
+    }
+
+    try {
+        rapid_doc::DocumentResult result = pipeline.processPdfFromMemoryWithOverrides(
+            reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), overrides);
+        if (result.totalPages == 0) {
+            throw std::runtime_error("no pages rendered (not a readable PDF?)");
+        }
+        if (args.format == rapid_doc::ResultFormat::CBOR) {
+            contentFile << rapid_doc::encodeResult(
+                rapid_doc::buildContentListJson(result), rapid_doc::ResultFormat::CBOR);
+        }
+        mdFile.close();
+        contentFile.close();
+        if (!contentFile || (!args.jsonOnly && !mdFile)) {
+            throw std::runtime_error("failed to write outputs under " + input.outputDir.string());
+        }
+        if (!args.jsonOnly) {
+            fs::rename(mdPart, mdPath);
+        }
+        fs::rename(contentPart, contentPath);
+        return result;
+    } catch (...) {
+        std::error_code ec;
+        fs::remove(mdPart, ec);
+        fs::remove(contentPart, ec);
+        throw;
+    }
+}
+
+struct PrefetchedInput {
+    size_t index = 0;
+    std::string bytes;
+};
+
+int runBatch(const CliArgs& args, const rapid_doc::PipelineConfig& config) {
+    const std::vector<BatchInput> inputs = collectBatchInputs(args);
+    if (inputs.empty()) {
+        LOG_ERROR("No PDF files in {}", args.inputDir.empty() ? args.inputList : args.inputDir);
+        return 1;
+    }
+    if (args.detail) {
+        LOG_WARN("--detail reports are not written in batch mode");
+    }
+
+    // One pipeline per device; models load once for the whole batch.
+    const std::vector<int> deviceIds =
+        args.deviceIds.empty() ? std::vector<int>{config.runtime.deviceId} : args.deviceIds;
+    const auto initStart = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<rapid_doc::DocPipeline>> pipelines;
+    std::vector<std::future<bool>> inits;
+    for (int deviceId : deviceIds) {
+        rapid_doc::PipelineConfig pipelineConfig = config;
+        pipelineConfig.runtime.deviceId = deviceId;
+        if (deviceIds.size() > 1) {
+            pipelineConfig.runtime.layoutOrtGlobalThreadPool = true;
+        }
+        pipelines.push_back(std::make_unique<rapid_doc::DocPipeline>(pipelineConfig));
+        inits.push_back(std::async(std::launch::async, [pipeline = pipelines.back().get()]() {
+            return pipeline->initialize();
+        }));
+    }
+    bool initialized = true;
+    for (size_t i = 0; i < inits.size(); ++i) {
+        if (!inits[i].get()) {
+            LOG_ERROR("Failed to initialize pipeline for device {}", deviceIds[i]);
+            initialized = false;
+        }
+    }
+    if (!initialized) {
+        return 1;
+    }
+    const double initMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - initStart).count();
+    LOG_INFO("{} pipeline(s) ready in {:.1f} ms; {} document(s) queued",
+             pipelines.size(), initMs, inputs.size());
+
+    // The reader keeps the next files in memory so pipelines never wait on disk.
+    rapid_doc::BoundedQueue<PrefetchedInput> prefetched(static_cast<size_t>(args.prefetch));
+    std::mutex totalsMutex;
+    std::vector<double> documentMs;
+    size_t processed = 0;
+    size_t skipped = 0;
+    size_t failed = 0;
+    int pages = 0;
+    auto finishedCount = [&]() { return processed + skipped + failed; };
+
+    const auto batchStart = std::chrono::steady_clock::now();
+    std::thread reader([&]() {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (args.skipExisting && fs::exists(contentListPath(inputs[i], args.format))) {
+                std::lock_guard<std::mutex> lock(totalsMutex);
+                ++skipped;
+                continue;
+            }
+            PrefetchedInput item;
+            item.index = i;
+            if (!readFileBytes(inputs[i].path, item.bytes)) {
+                std::lock_guard<std::mutex> lock(totalsMutex);
+                ++failed;
+                LOG_ERROR("[{}/{}] Cannot read {}", finishedCount(), inputs.size(), inputs[i].path.string());
+                continue;
+            }
+            if (!prefetched.push(std::move(item))) {
+                break;
+            }
+        }
+        prefetched.close();
+    });
+
+    std::vector<std::thread> workers;
+    for (auto& pipeline : pipelines) {
+        workers.emplace_back([&, pipeline = pipeline.get()]() {
+            PrefetchedInput item;
+            while (prefetched.pop(item)) {
+                const BatchInput& input = inputs[item.index];
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    const rapid_doc::DocumentResult result =
+                        processBatchDocument(*pipeline, input, item.bytes, args);
+                    const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count();
+                    std::lock_guard<std::mutex> lock(totalsMutex);
+                    ++processed;
+                    pages += result.processedPages;
+                    documentMs.push_back(ms);
+                    LOG_INFO("[{}/{}] {}: {} page(s) in {:.0f} ms", finishedCount(), inputs.size(),
+                             input.path.string(), result.processedPages, ms);
+                } catch (const std::exception& e) {
+                    std::lock_guard<std::mutex> lock(totalsMutex);
+                    ++failed;
+                    LOG_ERROR("[{}/{}] {} failed: {}", finishedCount(), inputs.size(),
+                              input.path.string(), e.what());
+                }
+            }
+        });
+    }
+    reader.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    const double wallSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - batchStart).count();
+    const rapid_doc::PercentileSummary latency = rapid_doc::summarizeSamples(documentMs);
+    const double perSecond = wallSeconds > 0.0 ? 1.0 / wallSeconds : 0.0;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "\n========================================\n";
+    std::cout << "Batch Complete\n";
+    std::cout << "========================================\n";
+    std::cout << "  Documents: " << processed << " processed, " << skipped << " skipped, "
+              << failed << " failed (of " << inputs.size() << ")\n";
+    std::cout << "  Pages processed: " << pages << "\n";
+    std::cout << "  Model init: " << initMs << " ms (" << pipelines.size() << " pipeline(s))\n";
+    std::cout << "  Wall time: " << wallSeconds << " s\n";
+    std::cout << "  Throughput: " << std::setprecision(2) << processed * perSecond << " docs/s, "
+              << pages * perSecond << " pages/s\n";
+    std::cout << std::setprecision(1);
+    std::cout << "  Document latency: p50 " << latency.p50Ms << " / p95 " << latency.p95Ms
+              << " / p99 " << latency.p99Ms << " / max " << latency.maxMs << " ms\n";
+    std::cout << "  Output: " << args.outputDir << "\n";
+    std::cout << "========================================\n";
+
+    return failed == 0 ? 0 : 1;
+}
+
+bool saveTrace(const CliArgs& args) {
+    if (args.traceOutPath.empty()) {
+        return true;
+    }
+    rapid_doc::Tracer::disable();
+    if (!rapid_doc::Tracer::writeChromeTrace(args.traceOutPath)) {
+        LOG_ERROR("Failed to write trace: {}", args.traceOutPath);
+        return false;
+    }
+    LOG_INFO("Saved trace: {}", args.traceOutPath);
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     CliArgs args;
     if (!parseArgs(argc, argv, args)) {
@@ -125,21 +526,37 @@ int main(int argc, char* argv[]) {
         spdlog::set_level(spdlog::level::info);
     }
 
-    // Check input file exists
-    if (!fs::exists(args.inputPath)) {
-        LOG_ERROR("Input file not found: {}", args.inputPath);
-        return 1;
-    }
-
     // Configure pipeline
     rapid_doc::PipelineConfig config = rapid_doc::PipelineConfig::Default(PROJECT_ROOT_DIR);
     config.runtime.outputDir = args.outputDir;
     config.runtime.pdfDpi = args.dpi;
+    config.runtime.layoutDpi = args.layoutDpi;
+    config.runtime.layoutFastResize = args.layoutFastResize;
+    config.runtime.blankPageInkRatio = args.blankPageInkRatio;
+    config.runtime.useTextLayer = args.useTextLayer;
     config.runtime.maxPages = args.maxPages;
     config.stages.enableWiredTable = args.enableTable;
     config.stages.enableOcr = args.enableOcr;
     config.stages.enableMarkdownOutput = !args.jsonOnly;
     config.runtime.saveVisualization = args.detail;
+    config.runtime.recordDir = args.recordDir;
+    config.runtime.replayDir = args.replayDir;
+    config.runtime.replayLatencyScale = args.replayLatencyScale;
+
+    if (!args.traceOutPath.empty()) {
+        rapid_doc::Tracer::enable();
+    }
+
+    if (args.batchMode()) {
+        const int status = runBatch(args, config);
+        return saveTrace(args) ? status : 1;
+    }
+
+    // Check input file exists
+    if (!fs::exists(args.inputPath)) {
+        LOG_ERROR("Input file not found: {}", args.inputPath);
+        return 1;
+    }
 
     // Create and initialize pipeline
     rapid_doc::DocPipeline pipeline(config);
@@ -153,32 +570,42 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Process document
-    LOG_INFO("Processing: {}", args.inputPath);
-    auto result = pipeline.processPdf(args.inputPath);
-    std::cout << "\n";  // New line after progress
-
     // Create output directory
     fs::create_directories(args.outputDir);
-
-    // Save results
     std::string baseName = fs::path(args.inputPath).stem().string();
+    const std::string mdPath = args.outputDir + "/" + baseName + ".md";
+    const std::string jsonPath = args.outputDir + "/" + baseName + "_content" +
+        rapid_doc::resultFormatExtension(args.format);
 
-    // Save Markdown
-    if (!args.jsonOnly && !result.markdown.empty()) {
-        std::string mdPath = args.outputDir + "/" + baseName + ".md";
-        std::ofstream mdFile(mdPath);
-        mdFile << result.markdown;
-        LOG_INFO("Saved Markdown: {}", mdPath);
+    // Markdown and the JSON content list are written page by page as pages finish
+    rapid_doc::PipelineRunOverrides overrides;
+    overrides.traceId = baseName;
+    std::ofstream mdFile;
+    if (!args.jsonOnly) {
+        mdFile.open(mdPath);
+        overrides.markdownSink = rapid_doc::makeStreamSink(mdFile);
+    }
+    // CBOR is encoded from the finished result instead.
+    std::ofstream jsonFile(jsonPath, std::ios::binary);
+    if (args.format == rapid_doc::ResultFormat::JSON) {
+        overrides.contentListSink = rapid_doc::makeStreamSink(jsonFile);
     }
 
-    // Save JSON content list
-    if (!result.contentListJson.empty()) {
-        std::string jsonPath = args.outputDir + "/" + baseName + "_content.json";
-        std::ofstream jsonFile(jsonPath);
-        jsonFile << result.contentListJson;
-        LOG_INFO("Saved JSON: {}", jsonPath);
+    // Process document
+    LOG_INFO("Processing: {}", args.inputPath);
+    auto result = pipeline.processPdfWithOverrides(args.inputPath, overrides);
+    std::cout << "\n";  // New line after progress
+
+    if (mdFile.is_open()) {
+        mdFile.close();
+        LOG_INFO("Saved Markdown: {}", mdPath);
+    }
+    if (args.format == rapid_doc::ResultFormat::CBOR) {
+        jsonFile << rapid_doc::encodeResult(
+            rapid_doc::buildContentListJson(result), rapid_doc::ResultFormat::CBOR);
     }
+    jsonFile.close();
+    LOG_INFO("Saved content list: {}", jsonPath);
 
     if (args.detail) {
         std::string detailPath = args.detailPath;
@@ -192,12 +619,10 @@ int main(int argc, char* argv[]) {
         detailOptions.saveImages = config.runtime.saveImages;
         detailOptions.saveVisualization = config.runtime.saveVisualization;
         detailOptions.artifacts.outputDir = args.outputDir;
-        if (!args.jsonOnly && !result.markdown.empty()) {
-            detailOptions.artifacts.markdownPath = args.outputDir + "/" + baseName + ".md";
-        }
-        if (!result.contentListJson.empty()) {
-            detailOptions.artifacts.contentListPath = args.outputDir + "/" + baseName + "_content.json";
+        if (!args.jsonOnly) {
+            detailOptions.artifacts.markdownPath = mdPath;
         }
+        detailOptions.artifacts.contentListPath = jsonPath;
         if (config.runtime.saveVisualization) {
             detailOptions.artifacts.layoutDir = args.outputDir + "/layout";
         }
@@ -222,5 +647,5 @@ int main(int argc, char* argv[]) {
     std::cout << "  Output: " << args.outputDir << "\n";
     std::cout << "========================================\n";
 
-    return 0;
+    return saveTrace(args) ? 0 : 1;
 }
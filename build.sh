@@ -1,11 +1,12 @@
 #!/bin/bash
-# Build script - Usage: ./build.sh [release|debug] [clean] [test]
+# Build script - Usage: ./build.sh [release|debug] [clean] [test] [python]
 
 set -e
 
 BUILD_TYPE="Release"
 CLEAN_BUILD=false
 BUILD_TESTS=false
+BUILD_PYTHON=false
 
 for arg in "$@"; do
     case $arg in
@@ -13,7 +14,8 @@ for arg in "$@"; do
         debug) BUILD_TYPE="Debug" ;;
         release) BUILD_TYPE="Release" ;;
         test) BUILD_TESTS=true ;;
-        *) echo "Usage: ./build.sh [release|debug] [clean] [test]"; exit 1 ;;
+        python) BUILD_PYTHON=true ;;
+        *) echo "Usage: ./build.sh [release|debug] [clean] [test] [python]"; exit 1 ;;
     esac
 done
 
@@ -40,6 +42,11 @@ else
     CMAKE_EXTRA_ARGS="${CMAKE_EXTRA_ARGS} -DBUILD_TESTS=OFF"
 fi
 
+if [ "$BUILD_PYTHON" = true ]; then
+    CMAKE_EXTRA_ARGS="${CMAKE_EXTRA_ARGS} -DBUILD_PYTHON=ON"
+    echo "Building Python bindings"
+fi
+
 INSTALL_PREFIX="$(pwd)"
 
 if [ "$BUILD_TYPE" = "Debug" ]; then
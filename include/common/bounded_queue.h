@@ -0,0 +1,107 @@
+#pragma once
+
+/**
+ * @file bounded_queue.h
+ * @brief Blocking FIFO with a fixed capacity, used between pipeline stages.
+ *
+ * Producers block in push() while the queue is full; consumers block in pop()
+ * until an item arrives or the queue is closed. close() lets consumers drain
+ * what is already queued, close(true) also discards pending items so an
+ * upstream failure stops downstream stages promptly.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace rapid_doc {
+
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(std::max<size_t>(1, capacity))
+    {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Enqueue one item, blocking while the queue is full.
+     * @return false if the queue was closed (the item is dropped)
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Dequeue one item, blocking until one is available.
+     * @return false once the queue is closed and drained
+     */
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        out = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Dequeue one item only if one is already queued; never blocks.
+     * @return false if the queue is currently empty
+     */
+    bool tryPop(T& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        out = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Reject further pushes and wake all waiters.
+     * @param discardPending Drop queued items instead of letting consumers drain them
+     */
+    void close(bool discardPending = false) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        if (discardPending) {
+            items_.clear();
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+} // namespace rapid_doc
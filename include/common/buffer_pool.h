@@ -0,0 +1,160 @@
+#pragma once
+
+/**
+ * @file buffer_pool.h
+ * @brief Recycled 8-bit image buffers for per-page transient Mats.
+ *
+ * Crops, model inputs and line masks are allocated and dropped for every
+ * page; under sustained load that is allocator contention and RSS creep.
+ * acquire() hands out a continuous Mat over a pooled buffer (capacity
+ * rounded up to a power of two, so differently sized crops share buckets).
+ * Nothing is released explicitly: the pool keeps a reference to every
+ * buffer it handed out and takes it back once that is the last reference,
+ * i.e. once the page (or an OCR task still holding a crop) is done with it.
+ * Buffers beyond the retained budget are freed instead.
+ */
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace rapid_doc {
+
+class BufferPool {
+public:
+    struct Stats {
+        uint64_t hits = 0;              // acquire() served from a recycled buffer
+        uint64_t misses = 0;            // acquire() that allocated
+        size_t inUseBytes = 0;          // capacity of buffers still referenced
+        size_t inUseHighWaterBytes = 0;
+        size_t retainedBytes = 0;       // capacity of idle buffers kept for reuse
+    };
+
+    /// @param maxRetainedBytes Idle capacity kept for reuse (0 = never recycle)
+    explicit BufferPool(size_t maxRetainedBytes) : maxRetained_(maxRetainedBytes) {}
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Uninitialized continuous rows x cols Mat of @p type
+     *
+     * Only 8-bit depths are pooled; other types are allocated normally.
+     */
+    cv::Mat acquire(int rows, int cols, int type) {
+        const size_t bytes = static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type);
+        if (CV_MAT_DEPTH(type) != CV_8U || bytes == 0 || maxRetained_ == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++misses_;
+            return cv::Mat(rows, cols, type);
+        }
+        const size_t capacity = bucketBytes(bytes);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv::Mat backing;
+        bool recycled = takeIdleLocked(capacity, backing);
+        if (!recycled) {
+            // Sweep only on a miss, so a warm pool does not scan per acquire.
+            reclaimLocked();
+            recycled = takeIdleLocked(capacity, backing);
+        }
+        if (recycled) {
+            ++hits_;
+        } else {
+            backing = cv::Mat(1, static_cast<int>(capacity), CV_8UC1);
+            ++misses_;
+        }
+        inUse_.push_back(backing);
+        inUseBytes_ += capacity;
+        inUseHighWater_ = std::max(inUseHighWater_, inUseBytes_);
+        // A view sharing the backing's reference count.
+        return backing.colRange(0, static_cast<int>(bytes)).reshape(CV_MAT_CN(type), rows);
+    }
+
+    /// Capacity one acquire(rows, cols, type) takes, for sizing budgets
+    static size_t capacityFor(int rows, int cols, int type) {
+        return bucketBytes(static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type));
+    }
+
+    /// Pooled deep copy of @p src (continuous, unlike a clone of an ROI's parent)
+    cv::Mat copyOf(const cv::Mat& src) {
+        cv::Mat out = acquire(src.rows, src.cols, src.type());
+        src.copyTo(out);
+        return out;
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reclaimLocked();
+        return Stats{hits_, misses_, inUseBytes_, inUseHighWater_, retainedBytes_};
+    }
+
+private:
+    static size_t bucketBytes(size_t bytes) {
+        size_t capacity = 4096;
+        while (capacity < bytes) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    bool takeIdleLocked(size_t capacity, cv::Mat& backing) {
+        auto it = idle_.find(capacity);
+        if (it == idle_.end() || it->second.empty()) {
+            return false;
+        }
+        backing = std::move(it->second.back());
+        it->second.pop_back();
+        retainedBytes_ -= capacity;
+        return true;
+    }
+
+    // References to @p backing's buffer. Owners on other threads change the
+    // count with CV_XADD, so it is read the same way: an atomic
+    // read-modify-write that also orders the last owner's writes to the
+    // buffer before the buffer is handed out again.
+    static int referencesOf(const cv::Mat& backing) {
+        return CV_XADD(&backing.u->refcount, 0);
+    }
+
+    // Move every handed-out buffer nobody else references back to idle.
+    void reclaimLocked() {
+        size_t kept = 0;
+        for (size_t i = 0; i < inUse_.size(); ++i) {
+            cv::Mat& backing = inUse_[i];
+            if (referencesOf(backing) > 1) {
+                if (kept != i) {
+                    inUse_[kept] = std::move(backing);
+                }
+                ++kept;
+                continue;
+            }
+            const size_t capacity = backing.total();
+            inUseBytes_ -= capacity;
+            if (retainedBytes_ + capacity <= maxRetained_) {
+                idle_[capacity].push_back(std::move(backing));
+                retainedBytes_ += capacity;
+            }
+            backing.release();
+        }
+        inUse_.resize(kept);
+    }
+
+    const size_t maxRetained_;
+
+    std::mutex mutex_;
+    std::vector<cv::Mat> inUse_;
+    std::map<size_t, std::vector<cv::Mat>> idle_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    size_t inUseBytes_ = 0;
+    size_t inUseHighWater_ = 0;
+    size_t retainedBytes_ = 0;
+};
+
+} // namespace rapid_doc
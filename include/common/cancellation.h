@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file cancellation.h
+ * @brief Cooperative cancellation flag shared by a request and its pipeline run.
+ *
+ * The caller keeps the token and cancels it (for the server: when an async
+ * job is stopped); the pipeline polls it between pages and between NPU
+ * submissions, so a cancelled run stops after at most the page stages
+ * already under way and returns the pages it completed.
+ */
+
+#include <atomic>
+
+namespace rapid_doc {
+
+class CancellationToken {
+public:
+    void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const noexcept { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,219 @@
+#pragma once
+
+/**
+ * @file completion_table.h
+ * @brief Slot-indexed completion records for tasks that finish out of order.
+ *
+ * An async backend with one shared output queue (the OCR pipeline) hands
+ * results back in completion order, not in the order callers wait for them.
+ * Each task id owns the slot id % capacity, and each slot has its own lock,
+ * so delivering or collecting one result never contends with the others.
+ * A waiter registers a Waiter on its slots and sleeps on that alone; the
+ * thread that delivers a result wakes only the waiter it belongs to.
+ *
+ * The id stored in a slot is its generation. Ids only grow, so a result for
+ * an id older than the slot's is stale (its waiter gave up, or the slot was
+ * recycled) and is dropped, and a result that arrives before anyone waits
+ * for it claims its slot and is kept until collected. Ids capacity apart
+ * share a slot; the newer one wins and the older is reported lost.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace rapid_doc {
+
+template <typename Result>
+class CompletionTable {
+public:
+    /// Per-wait notifier; lives on the waiting thread's stack.
+    class Waiter {
+    public:
+        /**
+         * @brief Sleep until a registered slot completes or @p timeout passes
+         * @return true if woken by a completion
+         */
+        template <typename Duration>
+        bool waitFor(Duration timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const bool woken = cv_.wait_for(lock, timeout, [this] { return signals_ > 0; });
+            signals_ = 0;
+            return woken;
+        }
+
+    private:
+        friend class CompletionTable;
+
+        void signal() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++signals_;
+            }
+            cv_.notify_one();
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        size_t signals_ = 0;
+    };
+
+    enum class Status {
+        PENDING,    // registered, no result yet
+        READY,      // result moved out
+        LOST,       // stale id: already collected, abandoned, or its slot was recycled
+    };
+
+    explicit CompletionTable(size_t capacity = 4096)
+        : capacity_(capacity > 0 ? capacity : 1)
+        , slots_(std::make_unique<Slot[]>(capacity_))
+    {}
+
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Register @p waiter for @p id's result
+     * @return READY if the result already arrived (the waiter is then not
+     *         registered), LOST if the id is stale, else PENDING
+     */
+    Status watch(int64_t id, Waiter& waiter) {
+        Slot& slot = slotFor(id);
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.id > id) {
+            return Status::LOST;
+        }
+        if (slot.id < id) {
+            reclaim(slot, id);
+            slot.state = State::WAITING;
+        }
+        switch (slot.state) {
+        case State::READY:
+            return Status::READY;
+        case State::WAITING:
+            slot.waiter = &waiter;
+            return Status::PENDING;
+        default:
+            return Status::LOST;
+        }
+    }
+
+    /**
+     * @brief Deliver @p id's result and wake its waiter
+     * @return false if the result is stale or a duplicate and was dropped
+     */
+    bool complete(int64_t id, Result result) {
+        Slot& slot = slotFor(id);
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.id > id) {
+            return false;
+        }
+        if (slot.id < id) {
+            reclaim(slot, id);
+        } else if (slot.state != State::WAITING) {
+            return false;
+        }
+        slot.result = std::move(result);
+        slot.state = State::READY;
+        // Signalled under the slot lock: once a waiter has collected or
+        // abandoned this slot, nothing here can still reach it.
+        if (slot.waiter != nullptr) {
+            slot.waiter->signal();
+            slot.waiter = nullptr;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Non-blocking check of @p id; moves the result into @p out when READY
+     */
+    Status take(int64_t id, Result& out) {
+        Slot& slot = slotFor(id);
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.id != id || slot.state == State::DONE) {
+            return Status::LOST;
+        }
+        if (slot.state != State::READY) {
+            return Status::PENDING;
+        }
+        out = std::move(slot.result);
+        slot.result = Result{};
+        slot.state = State::DONE;
+        slot.waiter = nullptr;
+        return Status::READY;
+    }
+
+    /**
+     * @brief Give up on @p id: detach its waiter and drop its result, now or when it arrives
+     */
+    void abandon(int64_t id) {
+        Slot& slot = slotFor(id);
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.id > id) {
+            return;
+        }
+        slot.id = id;
+        slot.state = State::DONE;
+        slot.result = Result{};
+        slot.waiter = nullptr;
+    }
+
+    /**
+     * @brief Let one caller at a time poll the backend's output queue
+     * @return true if the caller now drains and must call endDrain()
+     */
+    bool tryBeginDrain() { return !draining_.exchange(true, std::memory_order_acquire); }
+    void endDrain() { draining_.store(false, std::memory_order_release); }
+
+    /// Forget every slot. Only safe while nobody is waiting.
+    void clear() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            Slot& slot = slots_[i];
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.id = -1;
+            slot.state = State::DONE;
+            slot.result = Result{};
+            slot.waiter = nullptr;
+        }
+    }
+
+private:
+    enum class State {
+        DONE,       // collected, abandoned, or never used
+        WAITING,
+        READY,
+    };
+
+    struct Slot {
+        std::mutex mutex;
+        int64_t id = -1;    // generation
+        State state = State::DONE;
+        Result result{};
+        Waiter* waiter = nullptr;
+    };
+
+    Slot& slotFor(int64_t id) {
+        const uint64_t key = static_cast<uint64_t>(id);
+        return slots_[static_cast<size_t>(key % capacity_)];
+    }
+
+    /// Hand @p slot to newer @p id; an older task still waiting on it is lost.
+    static void reclaim(Slot& slot, int64_t id) {
+        if (slot.waiter != nullptr) {
+            slot.waiter->signal();
+            slot.waiter = nullptr;
+        }
+        slot.id = id;
+        slot.state = State::DONE;
+        slot.result = Result{};
+    }
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<bool> draining_{false};
+};
+
+} // namespace rapid_doc
@@ -54,15 +54,34 @@ struct PipelineStages {
  */
 struct RuntimeConfig {
     int pdfDpi = 200;                   // PDF rendering DPI
+    int layoutDpi = 0;                  // >0: rasterize pages at this DPI for layout, re-render OCR/table regions at pdfDpi
+    bool useTextLayer = false;          // Text regions from the PDF text layer; OCR only where it is missing or garbled
     int maxPages = 0;                   // Max pages to process (0 = all)
+    double blankPageInkRatio = 0.0;     // Pages with at most this ink coverage skip layout and OCR (0 = off)
     int startPageId = 0;                // Inclusive start page (0-based)
     int endPageId = -1;                 // Inclusive end page (-1 = all)
     int maxConcurrentPages = 4;         // Parallel PDF rendering limit
+    int pipelineQueueDepth = 2;         // Pages buffered between PDF pipeline stages (0 = serial)
+    int postprocessStageThreads = 1;    // Pipelined post-processing workers (crops, reading order); pages stay in order
+    int renderLookaheadPages = 2;       // Rendered pages allowed to wait for layout
+    int npuLayoutConcurrency = 1;       // Concurrent layout inferences admitted to the NPU
+    int npuOcrConcurrency = 1;          // Concurrent OCR det/rec batches admitted to the NPU
+    int npuTableConcurrency = 1;        // Concurrent table UNET batches admitted to the NPU
     int deviceId = -1;                  // DXRT device affinity (-1 = runtime default)
+    std::string cpuAffinity;            // cpulist ("0-15,32-47") fan-out threads are pinned to ("" = any)
+    int postprocessThreads = -1;        // CPU post-processing pool workers (-1 = hardware threads, 0 = inline)
     
     // Layout detection
     float layoutConfThreshold = 0.5f;   // Layout detection confidence threshold
     int layoutInputSize = 640;          // Layout model input size (pp_doclayout_l)
+    int layoutBatchSize = 1;            // Pages coalesced per layout batch (1 = no batching)
+    int layoutBatchMaxDelayMs = 2;      // Max wait for a layout batch to fill
+    bool layoutFastResize = false;      // Box-filter layout resize instead of Python-exact INTER_CUBIC
+    int layoutOrtIntraOpThreads = 1;    // Layout NMS intra-op threads
+    int layoutOrtInterOpThreads = 1;    // Layout NMS inter-op threads
+    std::string layoutOrtOptLevel = "all";      // disable | basic | extended | all
+    std::string layoutOrtOptimizedModelPath;    // Optimized NMS model cache ("" = off)
+    bool layoutOrtGlobalThreadPool = false;     // One ORT thread pool for all pipelines in the process
 
     // Table recognition
     float tableConfThreshold = 0.5f;    // Table detection confidence threshold
@@ -71,6 +90,23 @@ struct RuntimeConfig {
     std::string outputDir = "./output"; // Output directory
     bool saveImages = true;             // Save extracted images
     bool saveVisualization = false;     // Save layout visualization
+    std::string imageFormat = "png";    // png | jpg | webp for crops and visualization
+    int imageQuality = -1;              // PNG zlib level 0-9, JPEG/WebP quality 1-100 (-1 = fast default)
+    int imageWriteThreads = 2;          // Async image encode/write workers (0 = on the page thread)
+    int imageCacheMb = 16;              // Encoded crops reused across runs for identical pixels (0 = off)
+
+    // Memoization
+    int recognitionCacheMb = 0;         // Layout/OCR memo for repeated pages and crops (0 = off)
+    int pageBufferPoolMb = 64;          // Idle crop buffers kept for reuse across pages (0 = off)
+
+    // Startup
+    bool parallelModelInit = true;      // Load layout/table/OCR models concurrently
+    bool warmupOnInit = false;          // Run one synthetic page through each engine in initialize()
+
+    // Record / replay (see pipeline/replay_store.h)
+    std::string recordDir;              // Append every engine output and its latency here ("" = off)
+    std::string replayDir;              // Answer layout/table/OCR from a recording; loads no models ("" = off)
+    double replayLatencyScale = 1.0;    // Multiplier on replayed latencies (0 = no sleep)
 };
 
 /**
@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * @file content_hash.h
+ * @brief Fast 128-bit content digest for cache keys.
+ *
+ * Two independent 64-bit lanes over 8-byte words; every update() folds its
+ * own tail and length, so the same sequence of updates always gives the
+ * same digest. Good for de-duplicating inputs, not a cryptographic hash.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace rapid_doc {
+
+struct ContentDigest {
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    bool operator==(const ContentDigest& other) const { return a == other.a && b == other.b; }
+    bool operator!=(const ContentDigest& other) const { return !(*this == other); }
+
+    /// 32 lowercase hex digits
+    std::string hex() const {
+        static const char kDigits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            out[15 - i] = kDigits[(a >> (i * 4)) & 0xf];
+            out[31 - i] = kDigits[(b >> (i * 4)) & 0xf];
+        }
+        return out;
+    }
+};
+
+struct ContentDigestHash {
+    size_t operator()(const ContentDigest& digest) const {
+        return static_cast<size_t>(digest.a ^ (digest.b * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+class ContentHasher {
+public:
+    void update(const void* data, size_t size) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        const size_t words = size / 8;
+        for (size_t i = 0; i < words; ++i, p += 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            digest_.a = rotl(digest_.a ^ mix(word), 27) * 0x9e3779b185ebca87ULL;
+            digest_.b = rotl(digest_.b + mix(word ^ 0xc2b2ae3d27d4eb4fULL), 31) * 0x165667b19e3779f9ULL;
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, p, size % 8);
+        digest_.a = mix(digest_.a ^ tail ^ size);
+        digest_.b = mix(digest_.b + tail + (static_cast<uint64_t>(size) << 1));
+    }
+
+    void update(const std::string& data) { update(data.data(), data.size()); }
+
+    void update(uint64_t value) { update(&value, sizeof(value)); }
+
+    ContentDigest digest() const { return digest_; }
+
+private:
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    ContentDigest digest_{0x9e3779b97f4a7c15ULL, 0x6a09e667f3bcc909ULL};
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,109 @@
+#pragma once
+
+/**
+ * @file cpu_affinity.h
+ * @brief CPU sets of NPU devices' NUMA nodes and thread pinning.
+ *
+ * A DEEPX card sits behind the PCIe root of one socket; its driver's class
+ * device (/sys/class/dxrt/dxrt<N>) links to the PCI function, whose
+ * numa_node names that socket. Threads pinned to the node's CPUs keep the
+ * shard's host buffers and DMA traffic local, and since Linux allocates on
+ * first touch from the toucher's node, buffers the pinned threads fill need
+ * no explicit NUMA policy. Threads inherit the affinity of the thread that
+ * creates them, so pinning a shard's worker and init threads also places
+ * the runtime and ORT threads spawned from them.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace rapid_doc {
+
+/// CPUs in a kernel cpulist such as "0-3,8,10-11" (sorted, without duplicates)
+inline std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream in(text);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        const size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = std::max(0, first); cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (...) {
+            continue;   // blank or malformed entry
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+/// Inverse of parseCpuList(), with consecutive CPUs folded into ranges
+inline std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += std::to_string(cpus[i]);
+        if (j > i) {
+            text += '-' + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return text;
+}
+
+/// NUMA node of DXRT device @p deviceId, or -1 when sysfs does not say
+inline int deviceNumaNode(int deviceId, const std::string& sysfsRoot = "/sys") {
+    if (deviceId < 0) {
+        return -1;
+    }
+    std::ifstream in(sysfsRoot + "/class/dxrt/dxrt" + std::to_string(deviceId) + "/device/numa_node");
+    int node = -1;
+    if (!(in >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+/// CPUs of NUMA node @p node (empty when unknown)
+inline std::vector<int> numaNodeCpus(int node, const std::string& sysfsRoot = "/sys") {
+    if (node < 0) {
+        return {};
+    }
+    std::ifstream in(sysfsRoot + "/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string text;
+    std::getline(in, text);
+    return parseCpuList(text);
+}
+
+/// Restrict the calling thread to @p cpus; an empty set leaves it alone.
+inline bool pinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace rapid_doc
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * @file memo_cache.h
+ * @brief Thread-safe LRU memo of values keyed by content digest.
+ *
+ * Each entry is charged the byte weight its caller passes to put(); the
+ * least recently used entries are dropped once the total exceeds the
+ * budget. get() copies the value out, so callers never hold a reference
+ * into the cache.
+ */
+
+#include "common/content_hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace rapid_doc {
+
+template <typename Value>
+class MemoCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    explicit MemoCache(size_t budgetBytes) : budget_(budgetBytes) {}
+
+    MemoCache(const MemoCache&) = delete;
+    MemoCache& operator=(const MemoCache&) = delete;
+
+    bool get(const ContentDigest& key, Value& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++misses_;
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        out = it->second->value;
+        ++hits_;
+        return true;
+    }
+
+    void put(const ContentDigest& key, Value value, size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = index_.find(key);
+        if (it != index_.end()) {
+            bytes_ -= it->second->bytes;
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        if (bytes > budget_) {
+            return;
+        }
+        lru_.push_front(Entry{key, std::move(value), bytes});
+        index_[key] = lru_.begin();
+        bytes_ += bytes;
+        while (bytes_ > budget_) {
+            bytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return Stats{hits_, misses_, index_.size(), bytes_};
+    }
+
+private:
+    struct Entry {
+        ContentDigest key;
+        Value value;
+        size_t bytes;
+    };
+
+    const size_t budget_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;
+    std::unordered_map<ContentDigest, typename std::list<Entry>::iterator, ContentDigestHash> index_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // namespace rapid_doc
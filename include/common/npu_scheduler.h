@@ -0,0 +1,198 @@
+#pragma once
+
+/**
+ * @file npu_scheduler.h
+ * @brief Per-engine NPU admission control.
+ *
+ * Layout, OCR (det + rec) and table UNET each run on their own DX-RT
+ * InferenceEngine. Instead of one mutex around every NPU section, each engine
+ * gets its own admission lane with a concurrency limit, so e.g. page N+1's
+ * layout can run while page N is still in OCR. A limit of 1 per lane keeps
+ * each engine strictly serialized.
+ */
+
+#include "common/config.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace rapid_doc {
+
+enum class NpuEngine {
+    LAYOUT = 0,
+    OCR,
+    TABLE,
+};
+
+constexpr size_t kNpuEngineCount = 3;
+
+inline const char* npuEngineName(NpuEngine engine) {
+    switch (engine) {
+        case NpuEngine::LAYOUT: return "layout";
+        case NpuEngine::OCR: return "ocr";
+        case NpuEngine::TABLE: return "table";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Concurrency limit per NPU engine (values < 1 are treated as 1)
+ */
+struct NpuSchedulerConfig {
+    int layoutConcurrency = 1;
+    int ocrConcurrency = 1;
+    int tableConcurrency = 1;
+};
+
+inline NpuSchedulerConfig makeNpuSchedulerConfig(const RuntimeConfig& runtime) {
+    NpuSchedulerConfig config;
+    config.layoutConcurrency = runtime.npuLayoutConcurrency;
+    config.ocrConcurrency = runtime.npuOcrConcurrency;
+    config.tableConcurrency = runtime.npuTableConcurrency;
+    return config;
+}
+
+class NpuScheduler {
+public:
+    /**
+     * @brief RAII admission slot; releases the lane on destruction.
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+        ~Ticket() { release(); }
+
+        Ticket(Ticket&& other) noexcept : owner_(other.owner_), engine_(other.engine_) {
+            other.owner_ = nullptr;
+        }
+        Ticket& operator=(Ticket&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner_ = other.owner_;
+                engine_ = other.engine_;
+                other.owner_ = nullptr;
+            }
+            return *this;
+        }
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        void release() {
+            if (owner_ != nullptr) {
+                owner_->leave(engine_);
+                owner_ = nullptr;
+            }
+        }
+
+    private:
+        friend class NpuScheduler;
+        Ticket(NpuScheduler* owner, NpuEngine engine) : owner_(owner), engine_(engine) {}
+
+        NpuScheduler* owner_ = nullptr;
+        NpuEngine engine_ = NpuEngine::LAYOUT;
+    };
+
+    explicit NpuScheduler(const NpuSchedulerConfig& config = {}) {
+        lanes_[index(NpuEngine::LAYOUT)].limit = std::max(1, config.layoutConcurrency);
+        lanes_[index(NpuEngine::OCR)].limit = std::max(1, config.ocrConcurrency);
+        lanes_[index(NpuEngine::TABLE)].limit = std::max(1, config.tableConcurrency);
+    }
+
+    NpuScheduler(const NpuScheduler&) = delete;
+    NpuScheduler& operator=(const NpuScheduler&) = delete;
+
+    /**
+     * @brief Block until @p engine has a free slot, then occupy it.
+     */
+    Ticket admit(NpuEngine engine) {
+        Lane& lane = lanes_[index(engine)];
+        std::unique_lock<std::mutex> lock(lane.mutex);
+        lane.slotFree.wait(lock, [&lane]() { return lane.active < lane.limit; });
+        ++lane.active;
+        lock.unlock();
+        trackOccupancy(+1);
+        return Ticket(this, engine);
+    }
+
+    int limit(NpuEngine engine) const {
+        const Lane& lane = lanes_[index(engine)];
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        return lane.limit;
+    }
+
+    /**
+     * @brief Change @p engine's limit at runtime (values < 1 are treated as 1)
+     *
+     * Slots already admitted above a lowered limit finish normally; new ones
+     * wait until the lane is back under it.
+     */
+    void setLimit(NpuEngine engine, int limit) {
+        Lane& lane = lanes_[index(engine)];
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            lane.limit = std::max(1, limit);
+        }
+        lane.slotFree.notify_all();
+    }
+
+    int active(NpuEngine engine) const {
+        const Lane& lane = lanes_[index(engine)];
+        std::lock_guard<std::mutex> lock(lane.mutex);
+        return lane.active;
+    }
+
+    /// Time at least one slot of any lane was occupied, since construction
+    std::chrono::steady_clock::duration busyTime() const {
+        std::lock_guard<std::mutex> lock(busyMutex_);
+        auto total = busyTotal_;
+        if (occupied_ > 0) {
+            total += std::chrono::steady_clock::now() - busySince_;
+        }
+        return total;
+    }
+
+private:
+    struct Lane {
+        mutable std::mutex mutex;
+        std::condition_variable slotFree;
+        int limit = 1;
+        int active = 0;
+    };
+
+    static size_t index(NpuEngine engine) {
+        return static_cast<size_t>(engine);
+    }
+
+    void leave(NpuEngine engine) {
+        Lane& lane = lanes_[index(engine)];
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            --lane.active;
+        }
+        lane.slotFree.notify_one();
+        trackOccupancy(-1);
+    }
+
+    void trackOccupancy(int delta) {
+        std::lock_guard<std::mutex> lock(busyMutex_);
+        const auto now = std::chrono::steady_clock::now();
+        if (occupied_ == 0 && delta > 0) {
+            busySince_ = now;
+        } else if (occupied_ + delta == 0) {
+            busyTotal_ += now - busySince_;
+        }
+        occupied_ += delta;
+    }
+
+    std::array<Lane, kNpuEngineCount> lanes_;
+    mutable std::mutex busyMutex_;
+    int occupied_ = 0;
+    std::chrono::steady_clock::time_point busySince_;
+    std::chrono::steady_clock::duration busyTotal_{0};
+};
+
+} // namespace rapid_doc
@@ -14,9 +14,11 @@ struct PercentileSummary {
     double maxMs = 0.0;
     double p50Ms = 0.0;
     double p95Ms = 0.0;
+    double p99Ms = 0.0;
 };
 
 PercentileSummary summarizeSamples(std::vector<double> samples);
+void accumulatePageStats(PageStageStats& target, const PageStageStats& source);
 DocumentStageStats accumulateDocumentStageStats(const std::vector<PageResult>& pages);
 double totalTrackedStageTimeMs(const PageStageStats& stats);
 double totalTrackedStageTimeMs(const DocumentStageStats& stats);
@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file result_cache.h
+ * @brief Content-addressed cache of finished parses.
+ *
+ * An entry is the file tree one parse left in its output directory plus an
+ * opaque meta blob, stored under a key derived from the input bytes and a
+ * caller-supplied salt (the options and model versions that shape the
+ * output). Entries live in an in-memory LRU tier with a byte budget and,
+ * optionally, in an on-disk tier that survives restarts; a disk hit is
+ * promoted back into memory.
+ *
+ * Keys come from a fast non-cryptographic 128-bit hash, which is fine for
+ * de-duplicating uploads but not a defence against crafted collisions.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rapid_doc {
+
+struct CachedFile {
+    std::string path;   // relative, '/'-separated
+    std::string data;
+};
+
+struct CachedParse {
+    std::vector<CachedFile> files;
+    std::string meta;
+
+    size_t byteSize() const;
+};
+
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        size_t memoryEntries = 0;
+        size_t memoryBytes = 0;
+        size_t diskEntries = 0;
+        size_t diskBytes = 0;
+    };
+
+    /**
+     * @param memoryBudgetBytes In-memory tier size (0 = no memory tier)
+     * @param diskDir Directory of the on-disk tier ("" = no disk tier)
+     * @param diskBudgetBytes On-disk tier size (0 = no disk tier)
+     */
+    ResultCache(size_t memoryBudgetBytes, const std::string& diskDir, size_t diskBudgetBytes);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const { return memoryBudget_ > 0 || diskBudget_ > 0; }
+
+    /// 32 hex digits identifying @p bytes under @p salt
+    static std::string makeKey(const std::string& bytes, const std::string& salt);
+
+    /// @return The entry, or nullptr on a miss
+    std::shared_ptr<const CachedParse> lookup(const std::string& key);
+
+    /// Insert (or replace) @p key in both tiers, evicting the least recently used.
+    void store(const std::string& key, std::shared_ptr<const CachedParse> parse);
+
+    Stats stats() const;
+
+private:
+    struct DiskEntry {
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    using LruList = std::list<std::pair<std::string, std::shared_ptr<const CachedParse>>>;
+
+    // Callers hold mutex_.
+    void insertMemoryLocked(const std::string& key, std::shared_ptr<const CachedParse> parse);
+    std::vector<std::string> evictDiskLocked();
+
+    void loadDiskIndex();
+
+    const size_t memoryBudget_;
+    const size_t diskBudget_;
+    const std::string diskDir_;
+
+    mutable std::mutex mutex_;
+    LruList lru_;
+    std::unordered_map<std::string, LruList::iterator> memoryIndex_;
+    size_t memoryBytes_ = 0;
+    std::unordered_map<std::string, DiskEntry> diskIndex_;
+    size_t diskBytes_ = 0;
+    uint64_t useTick_ = 0;
+    Stats counters_;
+};
+
+} // namespace rapid_doc
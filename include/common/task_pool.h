@@ -0,0 +1,174 @@
+#pragma once
+
+/**
+ * @file task_pool.h
+ * @brief Fixed-size worker pool for CPU-bound per-region post-processing.
+ *
+ * parallelFor() is the only entry point: the calling thread works through
+ * the index range alongside at most threadCount() pool workers and returns
+ * once every index is done, so callers simply join on their own fan-out.
+ * Because the caller always participates, a saturated (or zero-thread) pool
+ * degrades to running the range inline rather than blocking.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rapid_doc {
+
+/**
+ * @brief Worker count for a configured pool size (-1 = one per hardware
+ * thread, leaving one for the joining caller).
+ */
+inline size_t resolveTaskPoolThreads(int configured) {
+    if (configured >= 0) {
+        return static_cast<size_t>(configured);
+    }
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw > 1 ? static_cast<size_t>(hw - 1) : 0;
+}
+
+class TaskPool {
+public:
+    /**
+     * @param threads Worker threads (0 = none; every parallelFor runs inline)
+     */
+    explicit TaskPool(size_t threads) {
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        taskReady_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    size_t threadCount() const { return workers_.size(); }
+
+    /**
+     * @brief Run fn(0) ... fn(count - 1), possibly concurrently, and wait for all.
+     *
+     * The first exception thrown by @p fn stops further indices from being
+     * claimed and is rethrown here after in-flight calls finish.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1 || workers_.empty()) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        auto state = std::make_shared<ForState>();
+        state->count = count;
+        state->fn = fn;
+
+        const size_t helpers = std::min(count - 1, workers_.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < helpers; ++i) {
+                tasks_.emplace_back([state]() { runRange(*state); });
+            }
+        }
+        taskReady_.notify_all();
+
+        runRange(*state);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->idle.wait(lock, [&state]() {
+            return state->running == 0 && (state->next >= state->count || state->error);
+        });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+private:
+    struct ForState {
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t next = 0;
+        size_t count = 0;
+        size_t running = 0;
+        std::exception_ptr error;
+        std::function<void(size_t)> fn;
+    };
+
+    // Helpers that start after the range is exhausted return without touching
+    // fn, so the caller's captures only need to outlive parallelFor().
+    static void runRange(ForState& state) {
+        while (true) {
+            size_t index = 0;
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.next >= state.count || state.error) {
+                    return;
+                }
+                index = state.next++;
+                ++state.running;
+            }
+
+            std::exception_ptr error;
+            try {
+                state.fn(index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (error && !state.error) {
+                state.error = error;
+            }
+            --state.running;
+            if (state.running == 0) {
+                state.idle.notify_all();
+            }
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                taskReady_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * @file text_layer.h
+ * @brief Layout-box text read from a PDF's embedded text layer.
+ *
+ * Born-digital pages carry their own text: reading it back is exact and
+ * costs no NPU time. TextLayerIndex bins one page's words in a uniform grid
+ * so each layout box only tests the words near it. Boxes with no words, or
+ * with garbled ones (glyphs from fonts without a usable ToUnicode map come
+ * out as U+FFFD or private-use code points), are left to OCR.
+ */
+
+#include "common/types.h"
+
+#include <string>
+#include <vector>
+
+namespace rapid_doc {
+
+class TextLayerIndex {
+public:
+    /// @param spans One page's words; must outlive the index
+    explicit TextLayerIndex(const std::vector<TextSpan>& spans);
+
+    bool empty() const { return spans_.empty(); }
+
+    /**
+     * @brief Text of the words whose centre lies inside @p box
+     *
+     * Words are grouped into lines by vertical position; lines are joined
+     * with '\n' like OCR lines, and words within a line with a space where
+     * the layer leaves a gap between them.
+     * @return false if the box has no words or its text is not usable
+     */
+    bool textIn(const LayoutBox& box, std::string& text) const;
+
+private:
+    std::vector<const TextSpan*> spans_;
+    std::vector<std::vector<int>> bins_;
+    float originX_ = 0.0f;
+    float originY_ = 0.0f;
+    float binW_ = 1.0f;
+    float binH_ = 1.0f;
+    int cols_ = 0;
+    int rows_ = 0;
+};
+
+/**
+ * @brief Whether @p text reads as real text
+ *
+ * False for empty text, invalid UTF-8, or when more than a tenth of the
+ * code points are U+FFFD, private-use or control characters.
+ */
+bool isUsableText(const std::string& text);
+
+} // namespace rapid_doc
@@ -0,0 +1,118 @@
+#pragma once
+
+/**
+ * @file trace.h
+ * @brief Scoped trace spans for finding where one slow request spent its time.
+ *
+ * TRACE_SPAN marks a scope; once Tracer::enable() has been called, every
+ * span that closes is appended to a ring buffer owned by the calling thread
+ * (so recording never contends across threads), and the buffers can be
+ * exported as Chrome trace_event JSON for chrome://tracing or Perfetto.
+ * While tracing is off a span costs one relaxed atomic load.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rapid_doc {
+
+/// One closed span; names point at string literals, the detail is a copy.
+struct TraceEvent {
+    const char* name = nullptr;
+    const char* category = nullptr;
+    std::string detail;             // optional, exported as args.detail
+    int64_t startUs = 0;
+    int64_t durationUs = 0;
+    uint32_t threadId = 0;
+};
+
+class Tracer {
+public:
+    static constexpr size_t kDefaultEventsPerThread = 1 << 16;
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /// Start recording; each thread then keeps its last @p eventsPerThread spans.
+    static void enable(size_t eventsPerThread = kDefaultEventsPerThread);
+    static void disable();
+    /// Drop everything recorded so far.
+    static void clear();
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void record(
+        const char* name, const char* category, const char* detail,
+        int64_t startUs, int64_t durationUs);
+
+    /// Chrome trace_event JSON of every buffered span, oldest first per thread
+    static std::string chromeTraceJson();
+    /// @return false when @p path could not be written
+    static bool writeChromeTrace(const std::string& path);
+
+private:
+    inline static std::atomic<bool> enabled_{false};
+};
+
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category, const char* detail = nullptr)
+        : name_(name)
+        , category_(category)
+        , detail_(detail)
+        , startUs_(Tracer::enabled() ? Tracer::nowUs() : -1)
+    {}
+
+    /// Detail built at run time, e.g. by traceDetail(); empty = none
+    TraceSpan(const char* name, const char* category, std::string detail)
+        : TraceSpan(name, category)
+    {
+        if (startUs_ >= 0 && !detail.empty()) {
+            ownedDetail_ = std::move(detail);
+            detail_ = ownedDetail_.c_str();
+        }
+    }
+
+    ~TraceSpan() {
+        if (startUs_ >= 0) {
+            Tracer::record(name_, category_, detail_, startUs_, Tracer::nowUs() - startUs_);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    const char* detail_;
+    int64_t startUs_;
+    std::string ownedDetail_;
+};
+
+/**
+ * @brief "<id> page <n>" span detail naming the request or document
+ *
+ * Empty while tracing is off (or without an id), so callers pay no
+ * formatting for spans that are not recorded.
+ */
+inline std::string traceDetail(const std::string& id, int pageNo = -1) {
+    if (!Tracer::enabled() || id.empty()) {
+        return {};
+    }
+    return pageNo < 0 ? id : id + " page " + std::to_string(pageNo);
+}
+
+} // namespace rapid_doc
+
+#define RAPIDDOC_TRACE_CONCAT_(a, b) a##b
+#define RAPIDDOC_TRACE_CONCAT(a, b) RAPIDDOC_TRACE_CONCAT_(a, b)
+
+/// Trace the enclosing scope: TRACE_SPAN("name", "category"[, detail])
+#define TRACE_SPAN(...) \
+    ::rapid_doc::TraceSpan RAPIDDOC_TRACE_CONCAT(traceSpan_, __COUNTER__)(__VA_ARGS__)
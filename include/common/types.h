@@ -9,9 +9,14 @@
  */
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <cstddef>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 namespace rapid_doc {
@@ -61,6 +66,29 @@ const char* layoutCategoryToString(LayoutCategory cat);
  */
 bool isCategorySupported(LayoutCategory cat);
 
+/**
+ * @brief Pipeline stage that handles a layout category; every category has exactly one
+ */
+enum class LayoutBucket : int {
+    TEXT = 0,       // OCR (text, titles, captions, headers/footers, ...)
+    TABLE,          // Table recognition
+    FIGURE,         // Image crops
+    EQUATION,       // Formula image fallback
+    UNSUPPORTED,    // Placeholder elements (see isCategorySupported)
+};
+constexpr size_t kLayoutBucketCount = 5;
+
+LayoutBucket layoutBucket(LayoutCategory cat);
+
+/**
+ * @brief Stable storage for a layout label.
+ *
+ * LayoutBox::label only views its text; labels the model emits are static,
+ * and any other label (e.g. read back from a recording) is copied here once
+ * for the life of the process.
+ */
+std::string_view internLayoutLabel(std::string_view label);
+
 /**
  * @brief Single detected region in a page
  */
@@ -70,7 +98,7 @@ struct LayoutBox {
     float confidence;            // Detection confidence [0, 1]
     int index;                   // Original detection order
     int clsId = -1;             // Original model class ID
-    std::string label;          // Original model label (e.g. "doc_title", "paragraph_title")
+    std::string_view label;     // Original model label (e.g. "doc_title"); interned, see internLayoutLabel()
 
     // Convenience methods
     float width() const { return x1 - x0; }
@@ -85,14 +113,87 @@ struct LayoutBox {
     cv::Point2f center() const { return cv::Point2f((x0 + x1) / 2, (y0 + y1) / 2); }
 };
 
+/**
+ * @brief Read-only sequence of layout boxes: a whole vector, or a bucket's
+ * indices into one (see LayoutBuckets). Views never own boxes.
+ */
+class LayoutBoxView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = LayoutBox;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const LayoutBox*;
+        using reference = const LayoutBox&;
+
+        iterator(const LayoutBoxView* view, size_t pos) : view_(view), pos_(pos) {}
+        reference operator*() const { return (*view_)[pos_]; }
+        pointer operator->() const { return &(*view_)[pos_]; }
+        iterator& operator++() { ++pos_; return *this; }
+        iterator operator++(int) { iterator prev = *this; ++pos_; return prev; }
+        bool operator==(const iterator& other) const { return pos_ == other.pos_; }
+        bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
+
+    private:
+        const LayoutBoxView* view_;
+        size_t pos_;
+    };
+
+    LayoutBoxView() = default;
+    LayoutBoxView(const std::vector<LayoutBox>& boxes)  // NOLINT: implicit on purpose
+        : boxes_(boxes.data()), size_(boxes.size()) {}
+    LayoutBoxView(const LayoutBox* boxes, const uint32_t* indices, size_t size)
+        : boxes_(boxes), indices_(indices), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const LayoutBox& operator[](size_t i) const { return boxes_[indices_ ? indices_[i] : i]; }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size_); }
+
+private:
+    const LayoutBox* boxes_ = nullptr;
+    const uint32_t* indices_ = nullptr;     // null: boxes_[0, size_)
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Boxes of a LayoutResult grouped by LayoutBucket in one pass.
+ *
+ * Holds indices only, in detection order within each bucket; views are
+ * valid while the boxes they were classified from are neither modified
+ * nor destroyed.
+ */
+struct LayoutBuckets {
+    std::vector<uint32_t> order;                        // box indices, grouped by bucket
+    std::array<uint32_t, kLayoutBucketCount + 1> offsets{};  // bucket b is order[offsets[b], offsets[b + 1])
+
+    size_t size(LayoutBucket bucket) const {
+        const auto b = static_cast<size_t>(bucket);
+        return offsets[b + 1] - offsets[b];
+    }
+    LayoutBoxView view(const std::vector<LayoutBox>& boxes, LayoutBucket bucket) const {
+        const auto b = static_cast<size_t>(bucket);
+        return LayoutBoxView(boxes.data(), order.data() + offsets[b], size(bucket));
+    }
+};
+
 /**
  * @brief Layout detection result for a single page
  */
 struct LayoutResult {
     std::vector<LayoutBox> boxes;
     double inferenceTimeMs = 0.0;
+    // This image's share of its detector batch's NPU admission wait and
+    // hold; set only when the detector batches internally
+    double npuWaitMs = 0.0;
+    double npuHoldMs = 0.0;
 
-    // Filter helpers
+    /// Single-pass bucketing of boxes; view the buckets against this->boxes
+    LayoutBuckets classify() const;
+
+    // Filter helpers (copying)
     std::vector<LayoutBox> getBoxesByCategory(LayoutCategory cat) const;
     std::vector<LayoutBox> getTextBoxes() const;
     std::vector<LayoutBox> getTableBoxes() const;
@@ -140,6 +241,17 @@ struct TableResult {
 // Page-Level Types
 // ========================================
 
+/**
+ * @brief One word of a PDF's embedded text layer, in page-image pixels
+ */
+struct TextSpan {
+    float x0 = 0.0f;
+    float y0 = 0.0f;
+    float x1 = 0.0f;
+    float y1 = 0.0f;
+    std::string text;   // UTF-8
+};
+
 /**
  * @brief Rendered page image from PDF
  */
@@ -150,6 +262,17 @@ struct PageImage {
     double scaleFactor;     // Scale relative to PDF coordinates
     int pdfWidth;           // Original PDF page width (points)
     int pdfHeight;          // Original PDF page height (points)
+
+    // Two-resolution rendering (runtime.layoutDpi): image is at the layout
+    // DPI, and renderRegion re-rasterizes an ROI given in image pixels at
+    // regionScale times that resolution (empty Mat on failure). Unset for
+    // single-resolution pages and decoded images.
+    std::function<cv::Mat(const cv::Rect& roi)> renderRegion;
+    double regionScale = 1.0;
+
+    // Embedded text layer (runtime.useTextLayer); empty for images and
+    // pages without text.
+    std::vector<TextSpan> textLayer;
 };
 
 /**
@@ -201,8 +324,28 @@ struct PageStageStats {
     // Non-overlapping observability slices for Phase 2 lock-splitting prep.
     double npuSerialTimeMs = 0.0;
     double cpuOnlyTimeMs = 0.0;
+    // cpuOnlyTimeMs by stage: CPU work on the layout/OCR/table stage threads,
+    // which holds back the next page's NPU work, and in post-processing.
+    double npuStageCpuTimeMs = 0.0;
+    double postprocessCpuTimeMs = 0.0;
     double npuLockWaitTimeMs = 0.0;
     double npuLockHoldTimeMs = 0.0;
+    // Per-engine NPU admission split; each pair sums into npuLockWait/Hold.
+    double layoutNpuWaitTimeMs = 0.0;
+    double layoutNpuHoldTimeMs = 0.0;
+    double ocrNpuWaitTimeMs = 0.0;
+    double ocrNpuHoldTimeMs = 0.0;
+    double tableNpuWaitTimeMs = 0.0;
+    double tableNpuHoldTimeMs = 0.0;
+    // Recognition cache lookups (see RuntimeConfig::recognitionCacheMb).
+    int layoutCacheHits = 0;
+    int layoutCacheMisses = 0;
+    int ocrCacheHits = 0;
+    int ocrCacheMisses = 0;
+    // Text regions read from the PDF text layer instead of OCR.
+    int textLayerRegions = 0;
+    // Pages skipped as blank (see RuntimeConfig::blankPageInkRatio).
+    int blankPages = 0;
 };
 
 /**
@@ -225,19 +368,28 @@ struct PageResult {
     std::vector<TableResult> tableResults;
     PageStageStats stats;
     double totalTimeMs = 0.0;
+    bool blank = false;                    // No ink found; layout and recognition were skipped
+};
+
+/**
+ * @brief Encoded region crop kept in memory (PipelineRunOverrides::keepEncodedImages)
+ */
+struct EncodedImage {
+    std::string path;                       // Same relative path as ContentElement::imagePath
+    std::vector<uint8_t> data;              // Bytes in the configured image format
 };
 
 /**
  * @brief Complete document processing result
  */
 struct DocumentResult {
-    std::vector<PageResult> pages;
-    std::string markdown;                   // Generated Markdown
-    std::string contentListJson;            // Structured JSON output
+    std::vector<PageResult> pages;          // Markdown / content list are streamed, see OutputSink
+    std::vector<EncodedImage> images;       // Sorted by path; empty unless kept
     double totalTimeMs = 0.0;
     int totalPages = 0;
     int processedPages = 0;
     int skippedElements = 0;                // Elements skipped due to NPU limitations
+    bool cancelled = false;                 // Stopped by the run's cancellation or deadline; pages are partial
     DocumentStageStats stats;
 };
 
@@ -13,14 +13,25 @@
  * 
  * Input:  NHWC image tensor (uint8 or float32)
  * Output: LayoutResult with detected boxes and categories
+ *
+ * With batchSize > 1, detect()/detectAsync() calls from any thread are
+ * coalesced for up to batchMaxDelayMs into one batch: the DX engine runs the
+ * batch through RunAsync, and the ONNX sub-model decodes it in a single
+ * Session::Run when its inputs have a dynamic batch dimension. NPU admission
+ * (setBatchAdmission) is taken per formed batch, so callers never hold an
+ * NPU slot while their images wait to be batched.
  */
 
+#include "common/buffer_pool.h"
 #include "common/types.h"
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <future>
 
 namespace rapid_doc {
 
@@ -34,6 +45,16 @@ struct LayoutDetectorConfig {
     float confThreshold = 0.5f;     // Detection confidence threshold
     bool useAsync = false;          // Enable async inference
     int deviceId = -1;              // DXRT device affinity (-1 = runtime default)
+    int batchSize = 1;              // Max images coalesced per batch (1 = no batching)
+    int batchMaxDelayMs = 2;        // Max time the first queued image waits for a full batch
+    bool fastResize = false;        // Box-filter downscale (layout_resize.h) instead of Python-exact INTER_CUBIC
+
+    // ONNX Runtime (NMS sub-model)
+    int ortIntraOpThreads = 1;              // Intra-op threads (per session, or global pool size)
+    int ortInterOpThreads = 1;              // Inter-op threads (per session, or global pool size)
+    std::string ortOptimizationLevel = "all";  // disable | basic | extended | all
+    std::string ortOptimizedModelPath;      // Optimized-model cache ("" = off)
+    bool ortGlobalThreadPool = false;       // Share process-wide ORT pools across sessions
 };
 
 /**
@@ -62,26 +83,69 @@ public:
     LayoutResult detect(const cv::Mat& image);
 
     /**
-     * @brief Async detection with callback
-     * @param image Input page image
-     * @param callback Called when detection completes
+     * @brief Queue a page image for detection
+     * @param image Input page image; must stay alive until the future is ready
+     * @return Future for the layout result (exceptions are propagated)
+     */
+    std::future<LayoutResult> detectAsync(const cv::Mat& image);
+
+    /**
+     * @brief Detect a group of images as one DX/ONNX batch
      */
-    using DetectionCallback = std::function<void(const LayoutResult&)>;
-    void detectAsync(const cv::Mat& image, DetectionCallback callback);
+    std::vector<LayoutResult> detectBatch(const std::vector<cv::Mat>& images);
 
     /**
      * @brief Check if detector is initialized
      */
     bool isInitialized() const { return initialized_; }
 
+    /// Reuse counters of the model input buffers
+    BufferPool::Stats inputPoolStats() const;
+
+    /**
+     * @brief Gate for one formed batch's run: calls @p run once the NPU admits
+     * it and returns the time spent waiting for admission in ms
+     */
+    using BatchAdmission = std::function<double(const std::function<void()>& run)>;
+
+    /// Admission hook for the batching worker; set before initialize()
+    void setBatchAdmission(BatchAdmission admission) { batchAdmission_ = std::move(admission); }
+
+    /// True when detect()/detectAsync() go through the batching worker
+    bool batchesInternally() const { return initialized_ && config_.batchSize > 1; }
+
+    /// Batch window for batches opened from now on (config batchMaxDelayMs until set)
+    void setBatchMaxDelayMs(int ms) { batchMaxDelayMs_.store(std::max(0, ms), std::memory_order_relaxed); }
+    int batchMaxDelayMs() const { return batchMaxDelayMs_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Decode ONNX sub-model output into layout boxes (CPU only)
+     *
+     * Per-category score filter, class-aware NMS, large image-box filter and
+     * clamping to @p imShape.
+     * @param boxData [totalBoxes, 6] rows of [cls_id, score, x0, y0, x1, y1]
+     */
+    static std::vector<LayoutBox> decodeBoxes(
+        const float* boxData, int totalBoxes, const cv::Size& imShape);
+
 private:
+    friend class LayoutDetectorTestAccess;
+
     /**
      * @brief Preprocess image for layout model
      * @param image Input BGR image
+     * @param out Model input tensor, written in place when already allocated
      * @param scaleFactor Output scale factor for post-processing
-     * @return Preprocessed image tensor
      */
-    cv::Mat preprocess(const cv::Mat& image, cv::Point2f& scaleFactor);
+    void preprocess(const cv::Mat& image, cv::Mat& out, cv::Point2f& scaleFactor);
+
+    /**
+     * @brief Read-only view of one DX engine output tensor (not owned)
+     */
+    struct TensorView {
+        const float* data = nullptr;
+        size_t count = 0;
+    };
 
     /**
      * @brief Run ONNX post-processing (NMS + bbox decode)
@@ -91,14 +155,30 @@ private:
      * @return Decoded layout boxes
      */
     std::vector<LayoutBox> postprocess(
-        const std::vector<std::vector<float>>& dxOutputs,
+        const std::vector<TensorView>& dxOutputs,
         const cv::Size& imShape,
         const cv::Point2f& scaleFactor
     );
 
+    /**
+     * @brief Batched postprocess(); one ONNX run when the sub-model allows it
+     */
+    std::vector<std::vector<LayoutBox>> postprocessBatch(
+        const std::vector<std::vector<TensorView>>& dxOutputs,
+        const std::vector<cv::Size>& imShapes,
+        const std::vector<cv::Point2f>& scaleFactors
+    );
+
+    void startBatchWorker();
+    void runBatchWorker();
+
     struct Impl;
     std::unique_ptr<Impl> impl_;
     LayoutDetectorConfig config_;
+    BatchAdmission batchAdmission_;
+    /// Replaces detectBatch() in the batching worker (tests only)
+    std::function<std::vector<LayoutResult>(const std::vector<cv::Mat>&)> batchRunHook_;
+    std::atomic<int> batchMaxDelayMs_;
     bool initialized_ = false;
 };
 
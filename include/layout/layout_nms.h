@@ -0,0 +1,240 @@
+#pragma once
+
+/**
+ * @file layout_nms.h
+ * @brief Structure-of-arrays candidate boxes and class-aware NMS for layout decode
+ *
+ * Semantics match Python post_process.py nms(): candidates are visited in
+ * descending score order; each kept box suppresses later boxes whose IoU
+ * (with the +1 pixel convention) is not below iouSame for the same class or
+ * iouDiff for a different class.
+ *
+ * The IoU of one kept box against the remaining candidates is evaluated
+ * several lanes at a time (AVX2 / SSE2 / NEON, scalar otherwise). Candidates
+ * are padded to the lane width so every pair goes through the same kernel.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace rapid_doc {
+
+/**
+ * @brief Layout candidates as parallel arrays ([cls_id, score, x0, y0, x1, y1] per box)
+ */
+struct LayoutCandidates {
+    std::vector<float> clsId;
+    std::vector<float> score;
+    std::vector<float> x0;
+    std::vector<float> y0;
+    std::vector<float> x1;
+    std::vector<float> y1;
+
+    size_t size() const { return score.size(); }
+    bool empty() const { return score.empty(); }
+
+    void clear() {
+        clsId.clear(); score.clear();
+        x0.clear(); y0.clear(); x1.clear(); y1.clear();
+    }
+
+    void reserve(size_t n) {
+        clsId.reserve(n); score.reserve(n);
+        x0.reserve(n); y0.reserve(n); x1.reserve(n); y1.reserve(n);
+    }
+
+    void push(const float* row) {
+        clsId.push_back(row[0]);
+        score.push_back(row[1]);
+        x0.push_back(row[2]);
+        y0.push_back(row[3]);
+        x1.push_back(row[4]);
+        y1.push_back(row[5]);
+    }
+};
+
+namespace nms_detail {
+
+#if defined(__AVX2__)
+constexpr size_t kLanes = 8;
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+constexpr size_t kLanes = 4;
+#else
+constexpr size_t kLanes = 1;
+#endif
+
+/// Candidates in score order, padded to a multiple of kLanes.
+struct SortedBoxes {
+    std::vector<float> cls, x0, y0, x1, y1, area;
+    std::vector<uint8_t> suppressed;
+};
+
+/**
+ * Mark suppressed[j] for j in [begin, begin + kLanes) when
+ * !(IoU(cur, j) < (cls[j] == curCls ? iouSame : iouDiff)).
+ */
+inline void suppressLanes(SortedBoxes& s, size_t cur, size_t begin, float iouSame, float iouDiff) {
+#if defined(__AVX2__)
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 cx0 = _mm256_set1_ps(s.x0[cur]);
+    const __m256 cy0 = _mm256_set1_ps(s.y0[cur]);
+    const __m256 cx1 = _mm256_set1_ps(s.x1[cur]);
+    const __m256 cy1 = _mm256_set1_ps(s.y1[cur]);
+    const __m256 carea = _mm256_set1_ps(s.area[cur]);
+    const __m256 ix0 = _mm256_max_ps(cx0, _mm256_loadu_ps(&s.x0[begin]));
+    const __m256 iy0 = _mm256_max_ps(cy0, _mm256_loadu_ps(&s.y0[begin]));
+    const __m256 ix1 = _mm256_min_ps(cx1, _mm256_loadu_ps(&s.x1[begin]));
+    const __m256 iy1 = _mm256_min_ps(cy1, _mm256_loadu_ps(&s.y1[begin]));
+    const __m256 w = _mm256_max_ps(zero, _mm256_add_ps(_mm256_sub_ps(ix1, ix0), one));
+    const __m256 h = _mm256_max_ps(zero, _mm256_add_ps(_mm256_sub_ps(iy1, iy0), one));
+    const __m256 inter = _mm256_mul_ps(w, h);
+    const __m256 uni = _mm256_sub_ps(_mm256_add_ps(carea, _mm256_loadu_ps(&s.area[begin])), inter);
+    const __m256 iou = _mm256_div_ps(inter, uni);
+    const __m256 sameCls = _mm256_cmp_ps(_mm256_loadu_ps(&s.cls[begin]),
+                                         _mm256_set1_ps(s.cls[cur]), _CMP_EQ_OQ);
+    const __m256 thr = _mm256_blendv_ps(_mm256_set1_ps(iouDiff), _mm256_set1_ps(iouSame), sameCls);
+    const int mask = _mm256_movemask_ps(_mm256_cmp_ps(iou, thr, _CMP_NLT_UQ));
+    for (size_t k = 0; k < kLanes; ++k) {
+        s.suppressed[begin + k] |= static_cast<uint8_t>((mask >> k) & 1);
+    }
+#elif defined(__SSE2__)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 ix0 = _mm_max_ps(_mm_set1_ps(s.x0[cur]), _mm_loadu_ps(&s.x0[begin]));
+    const __m128 iy0 = _mm_max_ps(_mm_set1_ps(s.y0[cur]), _mm_loadu_ps(&s.y0[begin]));
+    const __m128 ix1 = _mm_min_ps(_mm_set1_ps(s.x1[cur]), _mm_loadu_ps(&s.x1[begin]));
+    const __m128 iy1 = _mm_min_ps(_mm_set1_ps(s.y1[cur]), _mm_loadu_ps(&s.y1[begin]));
+    const __m128 w = _mm_max_ps(zero, _mm_add_ps(_mm_sub_ps(ix1, ix0), one));
+    const __m128 h = _mm_max_ps(zero, _mm_add_ps(_mm_sub_ps(iy1, iy0), one));
+    const __m128 inter = _mm_mul_ps(w, h);
+    const __m128 uni = _mm_sub_ps(
+        _mm_add_ps(_mm_set1_ps(s.area[cur]), _mm_loadu_ps(&s.area[begin])), inter);
+    const __m128 iou = _mm_div_ps(inter, uni);
+    const __m128 sameCls = _mm_cmpeq_ps(_mm_loadu_ps(&s.cls[begin]), _mm_set1_ps(s.cls[cur]));
+    const __m128 thr = _mm_or_ps(_mm_and_ps(sameCls, _mm_set1_ps(iouSame)),
+                                 _mm_andnot_ps(sameCls, _mm_set1_ps(iouDiff)));
+    const int mask = _mm_movemask_ps(_mm_cmpnlt_ps(iou, thr));
+    for (size_t k = 0; k < kLanes; ++k) {
+        s.suppressed[begin + k] |= static_cast<uint8_t>((mask >> k) & 1);
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t ix0 = vmaxq_f32(vdupq_n_f32(s.x0[cur]), vld1q_f32(&s.x0[begin]));
+    const float32x4_t iy0 = vmaxq_f32(vdupq_n_f32(s.y0[cur]), vld1q_f32(&s.y0[begin]));
+    const float32x4_t ix1 = vminq_f32(vdupq_n_f32(s.x1[cur]), vld1q_f32(&s.x1[begin]));
+    const float32x4_t iy1 = vminq_f32(vdupq_n_f32(s.y1[cur]), vld1q_f32(&s.y1[begin]));
+    const float32x4_t w = vmaxq_f32(zero, vaddq_f32(vsubq_f32(ix1, ix0), one));
+    const float32x4_t h = vmaxq_f32(zero, vaddq_f32(vsubq_f32(iy1, iy0), one));
+    const float32x4_t inter = vmulq_f32(w, h);
+    const float32x4_t uni = vsubq_f32(
+        vaddq_f32(vdupq_n_f32(s.area[cur]), vld1q_f32(&s.area[begin])), inter);
+    const float32x4_t iou = vdivq_f32(inter, uni);
+    const uint32x4_t sameCls = vceqq_f32(vld1q_f32(&s.cls[begin]), vdupq_n_f32(s.cls[cur]));
+    const float32x4_t thr = vbslq_f32(sameCls, vdupq_n_f32(iouSame), vdupq_n_f32(iouDiff));
+    const uint32x4_t keep = vcltq_f32(iou, thr);
+    uint32_t lanes[4];
+    vst1q_u32(lanes, keep);
+    for (size_t k = 0; k < kLanes; ++k) {
+        s.suppressed[begin + k] |= static_cast<uint8_t>(lanes[k] == 0);
+    }
+#else
+    const float ix0 = std::max(s.x0[cur], s.x0[begin]);
+    const float iy0 = std::max(s.y0[cur], s.y0[begin]);
+    const float ix1 = std::min(s.x1[cur], s.x1[begin]);
+    const float iy1 = std::min(s.y1[cur], s.y1[begin]);
+    const float inter = std::max(0.0f, ix1 - ix0 + 1) * std::max(0.0f, iy1 - iy0 + 1);
+    const float iou = inter / (s.area[cur] + s.area[begin] - inter);
+    const float thr = (s.cls[begin] == s.cls[cur]) ? iouSame : iouDiff;
+    s.suppressed[begin] |= static_cast<uint8_t>(!(iou < thr));
+#endif
+}
+
+} // namespace nms_detail
+
+/**
+ * @brief Class-aware greedy NMS
+ * @return Indices into @p boxes of the kept candidates, in descending score order
+ */
+inline std::vector<int> layoutNms(const LayoutCandidates& boxes,
+                                  float iouSame = 0.6f, float iouDiff = 0.98f) {
+    using nms_detail::kLanes;
+    const size_t n = boxes.size();
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return boxes.score[a] > boxes.score[b];
+    });
+
+    const size_t padded = (n + kLanes - 1) / kLanes * kLanes;
+    nms_detail::SortedBoxes s;
+    s.cls.assign(padded, 0.0f);
+    s.x0.assign(padded, 0.0f);
+    s.y0.assign(padded, 0.0f);
+    s.x1.assign(padded, 0.0f);
+    s.y1.assign(padded, 0.0f);
+    s.area.assign(padded, 1.0f);
+    s.suppressed.assign(padded, 1);  // padding lanes never survive
+    for (size_t i = 0; i < n; ++i) {
+        const int src = order[i];
+        s.cls[i] = boxes.clsId[src];
+        s.x0[i] = boxes.x0[src];
+        s.y0[i] = boxes.y0[src];
+        s.x1[i] = boxes.x1[src];
+        s.y1[i] = boxes.y1[src];
+        s.area[i] = (s.x1[i] - s.x0[i] + 1) * (s.y1[i] - s.y0[i] + 1);
+        s.suppressed[i] = 0;
+    }
+
+    std::vector<int> selected;
+    for (size_t i = 0; i < n; ++i) {
+        if (s.suppressed[i]) {
+            continue;
+        }
+        selected.push_back(order[i]);
+
+        // Sweep the lower-scored candidates a block at a time; a block whose
+        // lanes are all suppressed already is skipped.
+        const size_t first = i + 1;
+        size_t begin = first / kLanes * kLanes;
+        bool anyLive = false;
+        for (; begin < padded; begin += kLanes) {
+            bool blockLive = false;
+            for (size_t k = std::max(begin, first); k < begin + kLanes; ++k) {
+                blockLive |= (s.suppressed[k] == 0);
+            }
+            if (!blockLive) {
+                continue;
+            }
+            anyLive = true;
+            // Lanes before `first` belong to already-decided boxes; keep their state.
+            uint8_t saved[kLanes];
+            for (size_t k = 0; k < kLanes; ++k) {
+                saved[k] = s.suppressed[begin + k];
+            }
+            nms_detail::suppressLanes(s, i, begin, iouSame, iouDiff);
+            for (size_t k = begin; k < first && k < begin + kLanes; ++k) {
+                s.suppressed[k] = saved[k - begin];
+            }
+        }
+        if (!anyLive) {
+            break;  // every remaining candidate is suppressed
+        }
+    }
+    return selected;
+}
+
+} // namespace rapid_doc
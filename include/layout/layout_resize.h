@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * @file layout_resize.h
+ * @brief Single-pass box-filter downscale into a preallocated model input
+ *
+ * The layout model takes a fixed square input, so every page is squeezed
+ * from ~1700x2200 (or larger) to 640x640. INTER_CUBIC does that with a
+ * 16-tap kernel per output pixel plus an intermediate buffer; a box filter
+ * reads each source pixel once. Output rows are split across threads with
+ * cv::parallel_for_, and the result is written straight into @p dst, which
+ * for the detector is a pooled NHWC input tensor.
+ */
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace rapid_doc {
+
+/**
+ * @brief Downscale 8-bit @p src to @p size by averaging each output pixel's source box
+ *
+ * Box edges are the integer source coordinates floor(i * src / size), so an
+ * integer factor gives the exact mean like INTER_AREA. Images that would grow
+ * on either side, or are not 8-bit, fall back to cv::resize(INTER_LINEAR).
+ * @param dst Reused when it already has @p size and the type of @p src
+ */
+inline void resizeAreaInto(const cv::Mat& src, cv::Mat& dst, const cv::Size& size) {
+    dst.create(size, src.type());
+    if (src.depth() != CV_8U || size.width > src.cols || size.height > src.rows) {
+        cv::resize(src, dst, size, 0, 0, cv::INTER_LINEAR);
+        return;
+    }
+
+    const int cn = src.channels();
+    std::vector<int> xs(static_cast<size_t>(size.width) + 1);
+    for (int x = 0; x <= size.width; ++x) {
+        xs[static_cast<size_t>(x)] =
+            static_cast<int>(static_cast<int64_t>(x) * src.cols / size.width);
+    }
+
+    cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+        std::vector<uint32_t> rowSum(static_cast<size_t>(src.cols) * cn);
+        for (int oy = range.start; oy < range.end; ++oy) {
+            const int sy0 = static_cast<int>(static_cast<int64_t>(oy) * src.rows / size.height);
+            const int sy1 = static_cast<int>(static_cast<int64_t>(oy + 1) * src.rows / size.height);
+            std::fill(rowSum.begin(), rowSum.end(), 0u);
+            for (int sy = sy0; sy < sy1; ++sy) {
+                const uint8_t* s = src.ptr<uint8_t>(sy);
+                for (size_t i = 0; i < rowSum.size(); ++i) {
+                    rowSum[i] += s[i];
+                }
+            }
+
+            uint8_t* d = dst.ptr<uint8_t>(oy);
+            const uint32_t rows = static_cast<uint32_t>(sy1 - sy0);
+            for (int ox = 0; ox < size.width; ++ox) {
+                const int sx0 = xs[static_cast<size_t>(ox)];
+                const int sx1 = xs[static_cast<size_t>(ox) + 1];
+                const uint32_t count = rows * static_cast<uint32_t>(sx1 - sx0);
+                for (int c = 0; c < cn; ++c) {
+                    uint32_t sum = 0;
+                    for (int sx = sx0; sx < sx1; ++sx) {
+                        sum += rowSum[static_cast<size_t>(sx) * cn + c];
+                    }
+                    d[ox * cn + c] = static_cast<uint8_t>((sum + count / 2) / count);
+                }
+            }
+        }
+    });
+}
+
+} // namespace rapid_doc
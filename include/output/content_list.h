@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/types.h"
+#include "output/output_sink.h"
 #include <string>
 
 namespace rapid_doc {
@@ -8,6 +9,30 @@ namespace rapid_doc {
 class ContentListWriter {
 public:
     std::string generate(const DocumentResult& result) const;
+
+    /// Append one page's element array, pretty-printed as an entry of the document array
+    void appendPage(const PageResult& page, std::string& out) const;
+};
+
+/**
+ * @brief Content list written to a sink as each page completes
+ *
+ * The bytes written are identical to ContentListWriter::generate() for the
+ * same pages; finish() closes the top-level array.
+ */
+class ContentListStream {
+public:
+    explicit ContentListStream(OutputSink sink);
+
+    void appendPage(const PageResult& page);
+    void finish();
+
+private:
+    ContentListWriter writer_;
+    OutputSink sink_;
+    std::string buffer_;
+    size_t pages_ = 0;
+    bool finished_ = false;
 };
 
-} // namespace rapid_doc
\ No newline at end of file
+} // namespace rapid_doc
@@ -0,0 +1,202 @@
+#pragma once
+
+/**
+ * @file image_writer.h
+ * @brief Asynchronous encoding and writing of region crops and visualizations
+ *
+ * Page threads hand crops to an ImageWriteBatch, which encodes them on the
+ * shared ImageWriter workers and writes them to disk. wait() joins the batch
+ * before the document result is returned, and can hand back the encoded
+ * bytes so callers that inline images do not read the files back.
+ *
+ * Region crops that repeat (logos, stamps, letterheads) are keyed by their
+ * pixel digest: a run stores each distinct crop once and later copies refer
+ * to that file, and the writer remembers recently encoded crops so other
+ * runs skip the encode. Pages that finish out of order stage their crops
+ * and claim them in page order, so the stored copy is always the first.
+ *
+ * cv::Mat is reference counted, so a submitted crop keeps its page pixels
+ * alive until it is written; callers must not modify the image afterwards.
+ */
+
+#include "common/content_hash.h"
+#include "common/memo_cache.h"
+#include "common/types.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace rapid_doc {
+
+enum class ImageCodec {
+    PNG,
+    JPEG,
+    WEBP,
+};
+
+/**
+ * @brief Codec and compression setting for written images
+ */
+struct ImageEncoding {
+    ImageCodec codec = ImageCodec::PNG;
+    int quality = -1;   // PNG zlib level 0-9, JPEG/WebP quality 1-100 (-1 = codec default)
+
+    /**
+     * @brief Parse "png" | "jpg" | "jpeg" | "webp" (case-insensitive)
+     * @return false (and PNG) for an unknown format
+     */
+    static bool parse(const std::string& format, int quality, ImageEncoding& out);
+
+    /// File extension including the dot, e.g. ".png"
+    const char* extension() const;
+
+    /// cv::imencode parameters; PNG defaults to the fastest zlib level
+    std::vector<int> params() const;
+
+    /// @return false if OpenCV could not encode (e.g. built without WebP)
+    bool encode(const cv::Mat& image, std::vector<uint8_t>& out) const;
+};
+
+/**
+ * @brief Fixed-size worker pool that runs image encode/write tasks.
+ *
+ * post() never blocks: with no workers, or once the backlog reaches
+ * maxPending, the task runs on the caller so memory held by queued crops
+ * stays bounded.
+ */
+class ImageWriter {
+public:
+    using EncodedCache = MemoCache<std::shared_ptr<const std::vector<uint8_t>>>;
+
+    /**
+     * @param threads Worker threads (0 = every task runs inline in post())
+     * @param encodedCacheBytes Budget for encoded crops shared by every batch (0 = off)
+     */
+    explicit ImageWriter(size_t threads, size_t encodedCacheBytes = 0);
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    size_t threadCount() const { return workers_.size(); }
+
+    void post(std::function<void()> task);
+
+    /// Encoded bytes by pixel digest and encoding, or null when disabled
+    EncodedCache* encodedCache() { return encodedCache_.get(); }
+
+private:
+    void workerLoop();
+
+    std::unique_ptr<EncodedCache> encodedCache_;
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable taskReady_;
+    std::deque<std::function<void()>> tasks_;
+    size_t maxPending_ = 0;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief The image writes of one run, joined by wait().
+ *
+ * Always held by shared_ptr: queued tasks keep the batch alive, so a run
+ * that fails before wait() does not leave them pointing at freed state.
+ */
+class ImageWriteBatch : public std::enable_shared_from_this<ImageWriteBatch> {
+public:
+    /**
+     * @param writer Pool the writes run on
+     * @param encoding Codec for every image in the batch
+     * @param keepEncoded Retain the bytes of submit() calls that pass a key
+     */
+    ImageWriteBatch(ImageWriter& writer, ImageEncoding encoding, bool keepEncoded);
+
+    const ImageEncoding& encoding() const { return encoding_; }
+
+    /**
+     * @brief Encode @p image and write it to @p filePath in the background.
+     * @param key Relative path the encoded bytes are kept under (empty = not kept)
+     */
+    void submit(cv::Mat image, std::string filePath, std::string key = {});
+
+    /**
+     * @brief submit() for a crop that may repeat within the run.
+     *
+     * The first image with @p digest (see digestImage()) is written; later
+     * ones are dropped and refer to its file. A later copy submitted while
+     * that write is under way waits for it, and writes itself if it failed.
+     * @return Key of the stored copy: @p key, or that of the earlier image
+     */
+    std::string submitDeduplicated(cv::Mat image, const ContentDigest& digest,
+                                   std::string filePath, std::string key);
+
+    /**
+     * @brief Hold a crop that may repeat until claim() decides where it is stored.
+     * Crops staged but never claimed are dropped by wait().
+     */
+    void stageDeduplicated(cv::Mat image, const ContentDigest& digest,
+                           std::string filePath, std::string key);
+
+    /**
+     * @brief submitDeduplicated() for the crop staged under @p key.
+     * @return Key of the stored copy; @p key itself if nothing is staged under it
+     */
+    std::string claim(const std::string& key);
+
+    /// Images submitDeduplicated() did not write because an earlier copy was stored
+    size_t duplicateCount() const;
+
+    /**
+     * @brief Block until every submitted image is written.
+     * @return Images kept since the previous wait(), sorted by path
+     */
+    std::vector<EncodedImage> wait();
+
+private:
+    /// The first copy of a deduplicated crop, and whether it reached disk
+    struct StoredCopy {
+        enum class State { WRITING, STORED, FAILED };
+        std::string key;
+        State state = State::WRITING;
+    };
+
+    /// @param dedupDigest Settles that digest's StoredCopy once written
+    void enqueue(cv::Mat image, std::string filePath, std::string key,
+                 std::optional<ContentDigest> cacheKey,
+                 std::optional<ContentDigest> dedupDigest = std::nullopt);
+    /// @return false if the image could not be encoded or written
+    bool write(const cv::Mat& image, const std::string& filePath, std::string& key,
+               const std::optional<ContentDigest>& cacheKey);
+
+    ImageWriter& writer_;
+    const ImageEncoding encoding_;
+    const bool keepEncoded_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::condition_variable settled_;   // a StoredCopy left WRITING
+    size_t pending_ = 0;
+    std::vector<EncodedImage> kept_;
+    std::unordered_map<ContentDigest, StoredCopy, ContentDigestHash> stored_;
+    struct StagedCrop {
+        cv::Mat image;
+        ContentDigest digest;
+        std::string filePath;
+    };
+    std::unordered_map<std::string, StagedCrop> staged_;  // by key
+    size_t duplicates_ = 0;
+};
+
+} // namespace rapid_doc
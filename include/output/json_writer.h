@@ -0,0 +1,27 @@
+#pragma once
+
+/**
+ * @file json_writer.h
+ * @brief Direct JSON text emission without building a DOM
+ *
+ * Values are formatted the way nlohmann::json::dump() formats them, so
+ * streamed documents read the same as the DOM-based output they replace.
+ */
+
+#include <string>
+
+namespace rapid_doc {
+
+/// Append @p value as a quoted, escaped JSON string (UTF-8 passed through)
+void appendJsonString(std::string& out, const std::string& value);
+
+/// Append a floating-point value (shortest round-trip form, "null" if not finite)
+void appendJsonNumber(std::string& out, double value);
+
+/// Append an integer value
+void appendJsonNumber(std::string& out, long long value);
+
+/// Append "\n" and @p indent * @p level spaces; nothing when @p indent <= 0 (compact)
+void appendJsonNewline(std::string& out, int indent, int level);
+
+} // namespace rapid_doc
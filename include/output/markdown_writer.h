@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/types.h"
+#include "output/output_sink.h"
 #include <string>
 
 namespace rapid_doc {
@@ -9,8 +10,27 @@ class MarkdownWriter {
 public:
     std::string generate(const DocumentResult& result) const;
 
+    /// Append one page's Markdown, preceded by the page separator unless it is the first
+    void appendPage(const PageResult& page, bool firstPage, std::string& out) const;
+
 private:
     std::string elementToMarkdown(const ContentElement& elem) const;
 };
 
-} // namespace rapid_doc
\ No newline at end of file
+/**
+ * @brief Markdown written to a sink as each page completes
+ */
+class MarkdownStream {
+public:
+    explicit MarkdownStream(OutputSink sink);
+
+    void appendPage(const PageResult& page);
+
+private:
+    MarkdownWriter writer_;
+    OutputSink sink_;
+    std::string buffer_;
+    size_t pages_ = 0;
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file output_sink.h
+ * @brief Destination for document output written page by page
+ *
+ * Writers call the sink with consecutive chunks of the output (usually one
+ * per page), so it can be backed by a file, a socket or a chunked HTTP body
+ * without the whole document ever being held in memory.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace rapid_doc {
+
+using OutputSink = std::function<void(const char* data, size_t size)>;
+
+/// Sink appending to @p out, which must outlive the sink
+inline OutputSink makeStringSink(std::string& out) {
+    return [&out](const char* data, size_t size) { out.append(data, size); };
+}
+
+/// Sink writing to @p stream, which must outlive the sink
+inline OutputSink makeStreamSink(std::ostream& stream) {
+    return [&stream](const char* data, size_t size) {
+        stream.write(data, static_cast<std::streamsize>(size));
+    };
+}
+
+/// Sink forwarding every chunk to @p first, then to @p second
+inline OutputSink teeSinks(OutputSink first, OutputSink second) {
+    return [first = std::move(first), second = std::move(second)](const char* data, size_t size) {
+        first(data, size);
+        second(data, size);
+    };
+}
+
+} // namespace rapid_doc
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file result_json.h
+ * @brief JSON DOM views of a DocumentResult returned by the HTTP API
+ *
+ * content_list, middle_json and model_json as they appear in /file_parse
+ * responses (and in the _middle.json / _model.json artifacts).
+ *
+ * The same DOMs can be encoded as CBOR (RFC 8949) instead of JSON text:
+ * identical keys, arrays and values, so the JSON schema is the binary one,
+ * with numbers kept binary (bboxes as float32 where that is exact) and no
+ * text to re-parse on the consumer side.
+ */
+
+#include "common/types.h"
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace rapid_doc {
+
+std::string contentElementTypeToString(ContentElement::Type type);
+
+/// Same shape as the content_list.json file written by ContentListStream
+nlohmann::json buildContentListJson(const DocumentResult& result);
+nlohmann::json buildMiddleJson(const DocumentResult& result);
+nlohmann::json buildModelJson(const DocumentResult& result);
+
+enum class ResultFormat {
+    JSON,
+    CBOR,
+};
+
+/// "json" or "cbor" (case-insensitive); @return false for anything else
+bool parseResultFormat(const std::string& name, ResultFormat& format);
+
+/// @p value as JSON text (indented by @p indent when >= 0) or as CBOR bytes
+std::string encodeResult(const nlohmann::json& value, ResultFormat format, int indent = -1);
+
+/// "application/json" or "application/cbor"
+const char* resultFormatMimeType(ResultFormat format);
+
+/// ".json" or ".cbor"
+const char* resultFormatExtension(ResultFormat format);
+
+} // namespace rapid_doc
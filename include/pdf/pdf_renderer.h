@@ -5,16 +5,25 @@
  * @brief PDF to image rendering using Poppler
  * 
  * Renders PDF pages as OpenCV Mat images for pipeline processing.
- * Supports parallel page rendering with concurrency control.
+ * Supports parallel page rendering with concurrency control: each render
+ * worker opens its own poppler::document, and pages are always delivered
+ * in page order.
+ * With layoutDpi set, pages are rasterized at that lower resolution (the
+ * layout model only sees 640x640 anyway) and each PageImage carries a
+ * renderRegion that rasterizes just an OCR/table region at dpi, through
+ * Poppler's crop-area rendering.
  * Reuses Poppler integration pattern from DXNN-OCR-cpp server.
  */
 
 #include "common/types.h"
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <memory>
 #include <cstdint>
+#include <functional>
 
 namespace rapid_doc {
 
@@ -23,19 +32,45 @@ namespace rapid_doc {
  */
 struct PdfRenderConfig {
     int dpi = 200;                  // Rendering resolution
+    int layoutDpi = 0;              // >0 and < dpi: pages at this DPI, regions on demand at dpi
+    bool extractTextLayer = false;  // Fill PageImage::textLayer from the page's text
     int maxPages = 0;               // Max pages to render (0 = all)
     int startPageId = 0;            // Inclusive start page (0-based)
     int endPageId = -1;             // Inclusive end page (-1 = all)
-    int maxConcurrentRenders = 4;   // Parallel rendering limit
+    int maxConcurrentRenders = 4;   // Parallel rendering workers (1 = serial)
     int maxDpi = 300;               // Safety limit
     size_t maxPixelsPerPage = 25000000; // 25M pixels safety limit
+    std::string traceId;            // Request/document id in render span details ("" = none)
 };
 
+/**
+ * @brief Region of the page rendered at full DPI that covers @p roi
+ *
+ * @p roi is in pixels of the page rendered at dpi / @p scale; the result is
+ * rounded outward, so a re-rendered crop never clips the layout box.
+ */
+inline cv::Rect scaledRegion(const cv::Rect& roi, double scale) {
+    const int x0 = static_cast<int>(std::floor(roi.x * scale));
+    const int y0 = static_cast<int>(std::floor(roi.y * scale));
+    const int x1 = static_cast<int>(std::ceil((roi.x + roi.width) * scale));
+    const int y1 = static_cast<int>(std::ceil((roi.y + roi.height) * scale));
+    return cv::Rect(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
 /**
  * @brief PDF page renderer using Poppler
  */
 class PdfRenderer {
 public:
+    /**
+     * @brief Per-page sink for streaming renders.
+     *
+     * Receives each page as soon as it is rasterized, together with the number
+     * of pages selected by the configured page range. Return false to stop
+     * rendering early.
+     */
+    using PageCallback = std::function<bool(PageImage&& page, int pagesPlanned)>;
+
     explicit PdfRenderer(const PdfRenderConfig& config = {});
     ~PdfRenderer();
 
@@ -54,6 +89,32 @@ public:
      */
     std::vector<PageImage> renderFromMemory(const uint8_t* data, size_t size);
 
+    /**
+     * @brief Render pages from a PDF file one at a time
+     * @param pdfPath Path to PDF file
+     * @param onPage Called in page order for every rendered page
+     * @return Number of pages delivered to onPage
+     */
+    int renderFileEach(const std::string& pdfPath, const PageCallback& onPage);
+
+    /**
+     * @brief Render pages from PDF data in memory one at a time
+     * @param data Raw PDF bytes (must outlive the call, and with layoutDpi
+     *             set every delivered page's renderRegion calls)
+     * @param size Data size in bytes
+     * @param onPage Called in page order for every rendered page
+     * @return Number of pages delivered to onPage
+     */
+    int renderEach(const uint8_t* data, size_t size, const PageCallback& onPage);
+
+    /**
+     * @brief Number of pages renderEach() would deliver, without rendering
+     * @param data Raw PDF bytes
+     * @param size Data size in bytes
+     * @return Pages in the configured range, or 0 if the PDF cannot be opened
+     */
+    int countSelectedPages(const uint8_t* data, size_t size);
+
     /**
      * @brief Get total page count without rendering
      * @param pdfPath Path to PDF file
@@ -62,6 +123,13 @@ public:
     int getPageCount(const std::string& pdfPath);
 
 private:
+    /// renderEach() body; @p keepAlive owns @p data for region renders, if anything does
+    int renderDocument(
+        const uint8_t* data,
+        size_t size,
+        std::shared_ptr<const void> keepAlive,
+        const PageCallback& onPage);
+
     struct Impl;
     std::unique_ptr<Impl> impl_;
     PdfRenderConfig config_;
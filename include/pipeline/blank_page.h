@@ -0,0 +1,93 @@
+#pragma once
+
+/**
+ * @file blank_page.h
+ * @brief Ink coverage of a rendered page, for skipping blank pages before layout.
+ *
+ * Scanned batches carry separator sheets and empty back sides that would
+ * otherwise cost a layout inference each. The page is reduced to the means
+ * of 4x4-pixel blocks, which also averages out scanner noise and JPEG
+ * speckle, and a block counts as ink when it is clearly darker than the
+ * paper. The paper level is the brightest tenth of the blocks, so grey or
+ * yellowed scans are judged against their own background. A thin outer
+ * margin is left out: scan edges, binder shadows and punch holes are dark
+ * but never content.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace rapid_doc {
+
+/**
+ * @brief Fraction of the page's blocks that carry ink, in [0, 1].
+ *
+ * Images that are not 8-bit, too small to judge, or without a light
+ * background (dark full-bleed scans and photos) report 1, so they are
+ * never taken for blank.
+ */
+inline double pageInkRatio(const cv::Mat& image) {
+    constexpr int kBlock = 4;
+    constexpr double kMargin = 0.03;    // per side
+    constexpr int kInkContrast = 40;    // a block this much darker than the paper is ink
+    constexpr int kMinPaperLevel = 128;
+
+    if (image.data == nullptr || image.depth() != CV_8U) {
+        return 1.0;
+    }
+    const int channels = image.channels();
+    const int x0 = static_cast<int>(image.cols * kMargin);
+    const int y0 = static_cast<int>(image.rows * kMargin);
+    const int blocksX = (image.cols - 2 * x0) / kBlock;
+    const int blocksY = (image.rows - 2 * y0) / kBlock;
+    if (blocksX <= 0 || blocksY <= 0) {
+        return 1.0;
+    }
+
+    std::array<uint32_t, 256> histogram{};
+    std::vector<uint32_t> blockSums(static_cast<size_t>(blocksX));
+    const uint32_t blockSamples = static_cast<uint32_t>(kBlock * kBlock * channels);
+    for (int by = 0; by < blocksY; ++by) {
+        std::fill(blockSums.begin(), blockSums.end(), 0u);
+        for (int dy = 0; dy < kBlock; ++dy) {
+            const uint8_t* row = image.ptr<uint8_t>(y0 + by * kBlock + dy) + x0 * channels;
+            for (int bx = 0; bx < blocksX; ++bx) {
+                const uint8_t* px = row + bx * kBlock * channels;
+                uint32_t sum = 0;
+                for (int i = 0; i < kBlock * channels; ++i) {
+                    sum += px[i];
+                }
+                blockSums[bx] += sum;
+            }
+        }
+        for (uint32_t sum : blockSums) {
+            ++histogram[sum / blockSamples];
+        }
+    }
+
+    const uint64_t blocks = static_cast<uint64_t>(blocksX) * static_cast<uint64_t>(blocksY);
+    int paper = 0;
+    uint64_t brighter = 0;
+    for (int level = 255; level >= 0; --level) {
+        brighter += histogram[level];
+        if (brighter * 10 >= blocks) {
+            paper = level;
+            break;
+        }
+    }
+    if (paper < kMinPaperLevel) {
+        return 1.0;
+    }
+
+    uint64_t inkBlocks = 0;
+    for (int level = 0; level < paper - kInkContrast; ++level) {
+        inkBlocks += histogram[level];
+    }
+    return static_cast<double>(inkBlocks) / static_cast<double>(blocks);
+}
+
+} // namespace rapid_doc
@@ -19,14 +19,22 @@
  */
 
 #include "common/types.h"
+#include "common/buffer_pool.h"
+#include "common/cancellation.h"
+#include "common/completion_table.h"
 #include "common/config.h"
+#include "common/npu_scheduler.h"
+#include "common/task_pool.h"
 #include "pdf/pdf_renderer.h"
 #include "layout/layout_detector.h"
 #include "table/table_recognizer.h"
 #include "reading_order/xycut.h"
 #include "output/markdown_writer.h"
 #include "output/content_list.h"
+#include "output/image_writer.h"
 #include "pipeline/ocr_pipeline.h"
+#include "pipeline/recognition_cache.h"
+#include "pipeline/replay_store.h"
 #include <string>
 #include <memory>
 #include <functional>
@@ -35,8 +43,8 @@
 #include <chrono>
 #include <optional>
 #include <mutex>
+#include <condition_variable>
 #include <unordered_map>
-#include <unordered_set>
 
 namespace rapid_doc {
 
@@ -64,8 +72,35 @@ struct PipelineRunOverrides {
     std::optional<bool> enableFormula;
     std::optional<bool> enableWiredTable;
     std::optional<bool> enableMarkdownOutput;
+    std::optional<bool> useTextLayer;
+    // Streamed output: each page's Markdown / content-list entry is written
+    // here as soon as the page completes, in page order. Unset = not generated.
+    OutputSink markdownSink;
+    OutputSink contentListSink;
+    // Per-run progress, called like the pipeline-wide callback ("Processing",
+    // pages done, pages planned) once each page has reached the sinks above.
+    ProgressCallback progress;
+    // Also return the saved region crops in DocumentResult::images.
+    bool keepEncodedImages = false;
+    // The run stops starting pages and NPU work once @c cancel is set or
+    // @c deadline passes; DocumentResult::cancelled then marks a result that
+    // holds only the pages completed by then.
+    std::shared_ptr<const CancellationToken> cancel;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    // Request/document id put in the run's trace span details ("" = none).
+    std::string traceId;
 };
 
+/**
+ * @brief Append each OCR line's text to the table cell it mostly overlaps
+ *
+ * A line goes to the cell covering the largest share of its box, if that
+ * share exceeds 30%; lines joining a non-empty cell are newline-separated.
+ */
+void matchTableOcrToCells(
+    TableResult& tableResult,
+    const std::vector<ocr::PipelineOCRResult>& ocrBoxes);
+
 /**
  * @brief Main document processing pipeline
  */
@@ -76,10 +111,25 @@ public:
 
     /**
      * @brief Initialize all pipeline components
+     *
+     * Enabled models load concurrently unless runtime.parallelModelInit is
+     * off; with runtime.warmupOnInit, warmup() runs before returning.
      * @return true if all enabled components initialized successfully
      */
     bool initialize();
 
+    /**
+     * @brief Run each loaded engine once on a synthetic page
+     *
+     * Pays first-inference costs up front so the first real request does
+     * not. Failures are logged, not fatal.
+     * @return true if every loaded engine ran
+     */
+    bool warmup();
+
+    /// Whether a warmup() run has succeeded
+    bool warmedUp() const { return warmedUp_.load(std::memory_order_acquire); }
+
     /**
      * @brief Process a PDF file
      * @param pdfPath Path to input PDF file
@@ -102,9 +152,36 @@ public:
         size_t size,
         const PipelineRunOverrides& overrides);
 
+    /**
+     * @brief Process one PDF on several pipelines (e.g. one per device).
+     *
+     * The document is rendered once on the calling thread and the pages go to
+     * a shared queue that every pipeline pulls from, so a faster device takes
+     * more pages. Pages are streamed to the overrides' sinks and returned in
+     * document order with stats merged as for a single pipeline. The first
+     * pipeline's config drives rendering and output. Each pipeline must be
+     * initialized and not used by anyone else for the duration of the call.
+     * @param pipelineStats If non-null, receives the summed page stats of each pipeline
+     */
+    static DocumentResult processPdfFromMemoryAcross(
+        const std::vector<DocPipeline*>& pipelines,
+        const uint8_t* data,
+        size_t size,
+        const PipelineRunOverrides& overrides,
+        std::vector<PageStageStats>* pipelineStats = nullptr);
+
+    /**
+     * @brief Pages a PDF run with @p overrides would process, without rendering
+     * @return 0 if the PDF cannot be opened
+     */
+    int plannedPageCount(
+        const uint8_t* data,
+        size_t size,
+        const PipelineRunOverrides& overrides) const;
+
     /**
      * @brief Process a single image as a single-page document.
-     * @param image Input image (BGR)
+     * @param image Input image (BGR); read in place, not copied
      * @param pageIndex Page number metadata
      * @return Complete single-page document result
      */
@@ -114,9 +191,23 @@ public:
         int pageIndex,
         const PipelineRunOverrides& overrides);
 
+    /**
+     * @brief Process several images as the pages of one document.
+     *
+     * The images take the same staged path as rendered PDF pages (batched
+     * layout, overlapped OCR/table and post-processing), so a multi-page
+     * scan hands the NPU engines over once per stage rather than once per
+     * image. Page i of the merged result is images[i].
+     * @param images Page images (BGR); read in place, not copied
+     */
+    DocumentResult processImagesAsDocument(const std::vector<cv::Mat>& images);
+    DocumentResult processImagesAsDocumentWithOverrides(
+        const std::vector<cv::Mat>& images,
+        const PipelineRunOverrides& overrides);
+
     /**
      * @brief Process a single page image (no PDF rendering)
-     * @param image Page image (BGR)
+     * @param image Page image (BGR); read in place, not copied
      * @param pageIndex Page number (for output metadata)
      * @return Page result
      */
@@ -146,6 +237,30 @@ public:
     }
     void setMaxPages(int maxPages) { config_.runtime.maxPages = maxPages; }
 
+    /**
+     * @brief Reuse counters of the transient buffer pools
+     *
+     * Contiguous OCR inputs copied out of page ROIs come from a per-pipeline
+     * pool of runtime.pageBufferPoolMb; model inputs and table line masks from pools
+     * owned by the detector and recognizer. Unloaded engines report zeros.
+     */
+    struct BufferPoolStats {
+        BufferPool::Stats pageCrops;
+        BufferPool::Stats layoutInputs;
+        BufferPool::Stats tableInputs;
+        BufferPool::Stats tableMasks;
+    };
+    BufferPoolStats bufferPoolStats() const;
+
+    /**
+     * @brief Retune the layout batch window of a running pipeline
+     *
+     * Only batches opened afterwards see it; a no-op without a layout detector.
+     */
+    void setLayoutBatchMaxDelayMs(int ms);
+    /// Current layout batch window (-1 without a layout detector)
+    int layoutBatchMaxDelayMs() const;
+
 private:
     friend class DocPipelineTestAccess;
     friend class DocServer;
@@ -153,14 +268,123 @@ private:
     struct ExecutionContext {
         PipelineStages stages;
         RuntimeConfig runtime;
+        OutputSink markdownSink;
+        OutputSink contentListSink;
+        std::shared_ptr<ImageWriteBatch> imageWrites;   // Set when images or visualization are saved
+        ProgressCallback progress;
+        std::shared_ptr<const CancellationToken> cancel;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        std::string traceId;
+
+        /// Whether the run was cancelled or has passed its deadline
+        bool stopRequested() const {
+            return (cancel && cancel->cancelled()) ||
+                   (deadline && std::chrono::steady_clock::now() >= *deadline);
+        }
     };
 
+    /**
+     * @brief Per-run writers feeding the context's output sinks page by page.
+     */
+    struct DocumentOutput {
+        std::optional<MarkdownStream> markdown;
+        std::optional<ContentListStream> contentList;
+        std::shared_ptr<ImageWriteBatch> images;
+        // Receives completed pages instead of result.pages when one document
+        // is split across pipelines (see processPdfFromMemoryAcross).
+        std::function<void(PageResult&&)> forward;
+        double elapsedMs = 0.0;
+
+        explicit DocumentOutput(const ExecutionContext& ctx);
+        void appendPage(const PageResult& page);
+        /// Count @p page as processed, then stream it and store it in result.pages (or forward it)
+        void addPage(PageResult&& page, DocumentResult& result);
+        /// Close the streams, join the image writes (moving kept images into
+        /// result.images) and record the time spent in result.stats.outputGenTimeMs
+        void finish(DocumentResult& result);
+    };
+
+    /**
+     * @brief Per-page state handed from one pipeline stage to the next.
+     * Defined in doc_pipeline.cpp.
+     */
+    struct PageWork;
+
+    /**
+     * @brief Pushes rendered pages into the staged pipeline; returns false to stop.
+     */
+    using PageSink = std::function<bool(PageImage&& page, int pagesPlanned)>;
+    using PageProducer = std::function<void(const PageSink& sink)>;
+
     /**
      * @brief Process a single page through the pipeline
      */
     PageResult processPage(const PageImage& pageImage);
     PageResult processPage(const PageImage& pageImage, const ExecutionContext& ctx);
 
+    /**
+     * @brief Page stages, in order. processPage() runs them back to back;
+     * runPagePipeline() runs each on its own thread so consecutive pages overlap.
+     */
+    void runLayoutStage(PageWork& work, const ExecutionContext& ctx);
+    void runLayoutBatch(const std::vector<PageWork*>& batch, const ExecutionContext& ctx);
+    void runRecognitionStage(PageWork& work, const ExecutionContext& ctx);
+    PageResult runPostprocessStage(PageWork& work, const ExecutionContext& ctx);
+    /**
+     * @brief Run @p fn once @p engine admits it (see NpuScheduler); adds the
+     * admission wait/hold to the page's per-engine and total lock stats.
+     * @return Time spent inside @p fn in ms
+     */
+    double runNpuStage(PageWork& work, NpuEngine engine, const std::function<void()>& fn);
+
+    /**
+     * @brief Feed rendered pages through the page stages, pipelined when
+     * runtime.pipelineQueueDepth > 0 and inline (one page alive) otherwise.
+     * Fills result.pages, result.processedPages and stats.pdfRenderTimeMs, and
+     * hands each finished page to @p output.
+     */
+    void processRenderedPages(
+        const PageProducer& producer,
+        const ExecutionContext& ctx,
+        DocumentResult& result,
+        DocumentOutput& output);
+
+    /**
+     * @brief processRenderedPages() over several pipelines sharing one producer.
+     *
+     * Every pipeline runs its own stages on a worker thread and pulls the next
+     * produced page when it has room. Finished pages are reordered into
+     * producer order before they reach @p output and result.pages; the first
+     * exception from any pipeline stops the run and is rethrown here.
+     * @param ctx Lead context; its sinks and image batch serve every pipeline
+     * @param overrides Applied to each pipeline's own context
+     */
+    static void processRenderedPagesAcross(
+        const std::vector<DocPipeline*>& pipelines,
+        const PageProducer& producer,
+        const ExecutionContext& ctx,
+        const PipelineRunOverrides& overrides,
+        DocumentResult& result,
+        DocumentOutput& output,
+        std::vector<PageStageStats>* pipelineStats);
+
+    /**
+     * @brief Run render → layout → OCR/table → CPU post-processing as a staged
+     * pipeline connected by bounded queues of depth runtime.pipelineQueueDepth.
+     * The renderer runs at most runtime.renderLookaheadPages pages ahead of
+     * layout, so peak page memory is bounded by the window, not the page count.
+     *
+     * The producer runs on the calling thread. Pages are appended to
+     * result.pages in the order the producer emits them. The first exception
+     * raised by any stage stops the pipeline and is rethrown here.
+     */
+    void runPagePipeline(
+        const PageProducer& producer,
+        const ExecutionContext& ctx,
+        DocumentResult& result,
+        DocumentOutput& output);
+
+    using LayoutDetectHook = std::function<LayoutResult(const cv::Mat&)>;
     using OcrSubmitHook = std::function<bool(const cv::Mat&, int64_t)>;
     using OcrFetchHook = std::function<bool(
         std::vector<ocr::PipelineOCRResult>&, int64_t&, bool&)>;
@@ -175,7 +399,7 @@ private:
      */
     std::vector<ContentElement> runOcrOnRegions(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& textBoxes,
+        LayoutBoxView textBoxes,
         int pageIndex
     );
 
@@ -187,12 +411,12 @@ private:
      */
     std::vector<ContentElement> runTableRecognition(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& tableBoxes,
+        LayoutBoxView tableBoxes,
         int pageIndex
     );
     std::vector<ContentElement> runTableRecognition(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& tableBoxes,
+        LayoutBoxView tableBoxes,
         int pageIndex,
         const ExecutionContext& ctx
     );
@@ -202,7 +426,7 @@ private:
      * Creates placeholder ContentElements
      */
     std::vector<ContentElement> handleUnsupportedElements(
-        const std::vector<LayoutBox>& unsupportedBoxes,
+        LayoutBoxView unsupportedBoxes,
         int pageIndex
     );
 
@@ -211,13 +435,13 @@ private:
      */
     void saveExtractedImages(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& figureBoxes,
+        LayoutBoxView figureBoxes,
         int pageIndex,
         std::vector<ContentElement>& elements
     );
     void saveExtractedImages(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& figureBoxes,
+        LayoutBoxView figureBoxes,
         int pageIndex,
         std::vector<ContentElement>& elements,
         const ExecutionContext& ctx
@@ -225,14 +449,25 @@ private:
 
     void saveFormulaImages(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& equationBoxes,
+        LayoutBoxView equationBoxes,
         int pageIndex,
         std::vector<ContentElement>& elements
     );
     void saveFormulaImages(
         const cv::Mat& image,
-        const std::vector<LayoutBox>& equationBoxes,
+        LayoutBoxView equationBoxes,
+        int pageIndex,
+        std::vector<ContentElement>& elements,
+        const ExecutionContext& ctx
+    );
+
+    /// Queue each in-page box crop as images/page<N><suffix><i>.<ext> and append its element
+    void saveRegionImages(
+        const cv::Mat& image,
+        LayoutBoxView boxes,
         int pageIndex,
+        const char* suffix,
+        ContentElement::Type type,
         std::vector<ContentElement>& elements,
         const ExecutionContext& ctx
     );
@@ -257,6 +492,8 @@ private:
      */
     std::string ocrOnCrop(const cv::Mat& crop, int64_t taskId);
     bool submitOcrTask(const cv::Mat& crop, int64_t taskId);
+    /// @p crop as the OCR backend takes it: ROI views become pooled contiguous copies
+    cv::Mat ocrInput(const cv::Mat& crop);
     bool fetchOcrResult(
         std::vector<ocr::PipelineOCRResult>& results,
         int64_t& resultId,
@@ -265,61 +502,93 @@ private:
         int64_t taskId,
         std::vector<ocr::PipelineOCRResult>& results,
         bool& success);
+    struct BufferedOcrResult {
+        std::vector<ocr::PipelineOCRResult> results;
+        bool success = false;
+    };
+    using OcrCompletionTable = CompletionTable<BufferedOcrResult>;
+    /**
+     * @brief Wait for a batch of submitted OCR tasks, accepting results in any order.
+     * @param taskIds Task IDs already pushed with submitOcrTask()
+     * @param completed Filled with one entry per task that finished before the timeout
+     * @param ctx When set, also stops waiting at its deadline or cancellation
+     * @return true if every task completed
+     */
+    bool waitForOcrResults(
+        const std::vector<int64_t>& taskIds,
+        std::unordered_map<int64_t, BufferedOcrResult>& completed,
+        const ExecutionContext* ctx = nullptr);
     int64_t allocateOcrTaskId();
 
     TableResult recognizeTable(const cv::Mat& tableCrop);
-    TableRecognizer::NpuStageResult recognizeTableNpuStage(const cv::Mat& tableCrop);
+    std::vector<TableRecognizer::NpuStageResult> recognizeTableNpuStageBatch(
+        const std::vector<cv::Mat>& tableCrops);
     TableResult finalizeTableRecognizePostprocess(
         const cv::Mat& tableCrop,
         const TableRecognizer::NpuStageResult& npuStage);
     std::string generateTableHtml(const std::vector<TableCell>& cells);
+
     ContentElement makeTableFallbackElement(
         const LayoutBox& box,
         int pageIndex,
         const std::string& reason) const;
     static std::string tableFallbackMessage(const std::string& reason);
 
-    ExecutionContext makeExecutionContext(const PipelineRunOverrides* overrides) const;
+    ExecutionContext makeExecutionContext(const PipelineRunOverrides* overrides);
     void resetOcrTransientStateForRun();
-    std::mutex& npuSerialMutex();
+    NpuScheduler& npuScheduler();
+    /// Shared CPU post-processing pool (the server's when one is attached)
+    TaskPool& postprocessPool();
+    /// Shared async image writer (the server's when one is attached)
+    ImageWriter& imageWriter();
+    /// Layout/OCR memo (the server's when one is attached); nullptr when off
+    RecognitionCache* recognitionCache();
     DocumentResult processPdfInternal(const std::string& pdfPath, const ExecutionContext& ctx);
     DocumentResult processPdfFromMemoryInternal(
         const uint8_t* data, size_t size, const ExecutionContext& ctx);
     DocumentResult processImageDocumentInternal(
         const cv::Mat& image, int pageIndex, const ExecutionContext& ctx);
+    DocumentResult processImagesAsDocumentInternal(
+        const std::vector<cv::Mat>& images, const ExecutionContext& ctx);
 
     void reportProgress(const std::string& stage, int current, int total);
+    void reportProgress(const ExecutionContext& ctx, const std::string& stage, int current, int total);
 
     PipelineConfig config_;
     bool initialized_ = false;
+    std::atomic<bool> warmedUp_{false};
 
     // Pipeline components
     std::unique_ptr<PdfRenderer> pdfRenderer_;
     std::unique_ptr<LayoutDetector> layoutDetector_;
     std::unique_ptr<TableRecognizer> tableRecognizer_;
     std::unique_ptr<ocr::OCRPipeline> ocrPipeline_;
-    std::mutex npuSerialMutex_;
-    std::mutex* externalNpuSerialMutex_ = nullptr;
-
+    NpuScheduler npuScheduler_;
+    NpuScheduler* externalNpuScheduler_ = nullptr;
+    std::once_flag postprocessPoolOnce_;
+    std::unique_ptr<TaskPool> postprocessPool_;
+    TaskPool* externalPostprocessPool_ = nullptr;
+    std::once_flag imageWriterOnce_;
+    std::unique_ptr<ImageWriter> imageWriter_;
+    ImageWriter* externalImageWriter_ = nullptr;
+    ImageEncoding imageEncoding_;
+    std::once_flag recognitionCacheOnce_;
+    std::unique_ptr<RecognitionCache> recognitionCache_;
+    RecognitionCache* externalRecognitionCache_ = nullptr;
+
+    std::unique_ptr<BufferPool> pageBuffers_;
+    std::unique_ptr<ReplaySession> replaySession_;   // runtime.recordDir / runtime.replayDir
+
+    LayoutDetectHook layoutDetectHook_;
     OcrSubmitHook ocrSubmitHook_;
     OcrFetchHook ocrFetchHook_;
     TableRecognizeHook tableRecognizeHook_;
     TableHtmlHook tableHtmlHook_;
 
-    struct BufferedOcrResult {
-        std::vector<ocr::PipelineOCRResult> results;
-        bool success = false;
-    };
-    mutable std::mutex ocrStateMutex_;
-    std::unordered_map<int64_t, BufferedOcrResult> bufferedOcrResults_;
-    std::unordered_set<int64_t> timedOutOcrTaskIds_;
+    OcrCompletionTable ocrCompletions_;    // submitted OCR tasks' results, by task id
     std::chrono::milliseconds ocrWaitTimeout_{30000};
     std::atomic<int64_t> nextOcrTaskId_{1};
 
-    // Output writers
-    MarkdownWriter markdownWriter_;
-    ContentListWriter contentListWriter_;
-
     // Callbacks
     ProgressCallback progressCallback_;
 };
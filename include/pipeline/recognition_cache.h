@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * @file recognition_cache.h
+ * @brief Opt-in memo of NPU results for pixels the pipeline has seen before.
+ *
+ * Template documents (invoices, forms) repeat whole pages and header/footer
+ * regions exactly across files. Layout results are memoized per rendered
+ * page and OCR text per text-region crop, both keyed by an exact digest of
+ * the pixels, so repeats are answered without reaching the NPU. Exact
+ * digests keep results identical to an uncached run; near-duplicates
+ * (re-scans, different DPI) simply miss.
+ */
+
+#include "common/memo_cache.h"
+#include "common/types.h"
+
+#include <cstddef>
+#include <string>
+
+namespace rapid_doc {
+
+struct RecognitionCache {
+    /// @param budgetBytes Split between the two memos; OCR text gets most of it
+    explicit RecognitionCache(size_t budgetBytes)
+        : layouts(budgetBytes / 4)
+        , ocrTexts(budgetBytes - budgetBytes / 4)
+    {}
+
+    MemoCache<LayoutResult> layouts;
+    MemoCache<std::string> ocrTexts;
+};
+
+/// Exact digest of an image's size, type and pixels (row by row, so ROIs work).
+inline ContentDigest digestImage(const cv::Mat& image) {
+    ContentHasher hasher;
+    hasher.update(static_cast<uint64_t>(image.rows));
+    hasher.update(static_cast<uint64_t>(image.cols));
+    hasher.update(static_cast<uint64_t>(image.type()));
+    const size_t rowBytes = static_cast<size_t>(image.cols) * image.elemSize();
+    for (int r = 0; r < image.rows; ++r) {
+        hasher.update(image.ptr(r), rowBytes);
+    }
+    return hasher.digest();
+}
+
+/// Approximate heap bytes of a cached layout result (labels are interned, not owned)
+inline size_t layoutResultBytes(const LayoutResult& layout) {
+    return sizeof(LayoutResult) + layout.boxes.size() * sizeof(LayoutBox);
+}
+
+} // namespace rapid_doc
@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * @file replay_store.h
+ * @brief Recorded layout / table / OCR outputs for NPU-free pipeline runs.
+ *
+ * With runtime.recordDir set, every result the real engines return is
+ * appended, with the latency it took, to layout.jsonl, table.jsonl and
+ * ocr.jsonl in that directory. With runtime.replayDir set, the pipeline
+ * loads no models: each engine answers from the recording, keyed by an
+ * exact digest of its input pixels like the recognition cache, after
+ * sleeping for the recorded latency (times runtime.replayLatencyScale).
+ * Scheduling, pipelining and server concurrency then behave as on the
+ * device, with the same timing distribution, on a CPU-only machine.
+ *
+ * Inputs the recording has not seen get an empty result and a latency
+ * drawn in turn from the engine's recorded latencies.
+ */
+
+#include "common/content_hash.h"
+#include "common/types.h"
+#include <pipeline/ocr_pipeline.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rapid_doc {
+
+class ReplayStore {
+public:
+    enum class Mode { RECORD, REPLAY };
+    enum class Engine { LAYOUT = 0, TABLE, OCR, COUNT };
+
+    /**
+     * @brief Store for @p dir, shared by every pipeline in the process
+     *
+     * Shards recording to one directory append to the same files, and
+     * replaying shards load it once.
+     * @throws std::runtime_error if the directory cannot be created or read
+     */
+    static std::shared_ptr<ReplayStore> open(const std::string& dir, Mode mode);
+
+    ReplayStore(const std::string& dir, Mode mode);
+
+    Mode mode() const { return mode_; }
+    const std::string& dir() const { return dir_; }
+
+    void recordLayout(const ContentDigest& key, const LayoutResult& result, double latencyMs);
+    void recordTable(const ContentDigest& key, const TableResult& result, double latencyMs);
+    void recordOcr(
+        const ContentDigest& key,
+        const std::vector<ocr::PipelineOCRResult>& lines,
+        bool success,
+        double latencyMs);
+
+    /// @return false on a miss; @p latencyMs is set either way
+    bool findLayout(const ContentDigest& key, LayoutResult& result, double& latencyMs);
+    bool findTable(const ContentDigest& key, TableResult& result, double& latencyMs);
+    bool findOcr(
+        const ContentDigest& key,
+        std::vector<ocr::PipelineOCRResult>& lines,
+        bool& success,
+        double& latencyMs);
+
+    size_t records(Engine engine) const;
+    uint64_t misses(Engine engine) const;
+
+private:
+    struct OcrRecord {
+        std::vector<ocr::PipelineOCRResult> lines;
+        bool success = false;
+    };
+
+    template <typename T>
+    struct Recorded {
+        T value;
+        double latencyMs = 0.0;
+    };
+
+    void load();
+    void append(Engine engine, const std::string& line);
+    double missLatency(Engine engine);
+    void noteMiss(Engine engine, const ContentDigest& key);
+
+    const std::string dir_;
+    const Mode mode_;
+
+    mutable std::mutex mutex_;
+    std::array<std::ofstream, static_cast<size_t>(Engine::COUNT)> files_;
+    std::unordered_map<ContentDigest, Recorded<LayoutResult>, ContentDigestHash> layouts_;
+    std::unordered_map<ContentDigest, Recorded<TableResult>, ContentDigestHash> tables_;
+    std::unordered_map<ContentDigest, Recorded<OcrRecord>, ContentDigestHash> ocr_;
+    std::array<std::vector<double>, static_cast<size_t>(Engine::COUNT)> latencies_;
+    std::array<size_t, static_cast<size_t>(Engine::COUNT)> nextMissLatency_{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Engine::COUNT)> misses_{};
+};
+
+/**
+ * @brief One pipeline's view of a ReplayStore
+ *
+ * Recording needs the crop digest of each in-flight OCR task, and replay
+ * models the pipeline's own OCR engine as a FIFO queue: a task completes
+ * its recorded latency after the previous one, so a burst of submissions
+ * drains at the recorded throughput instead of all at once.
+ */
+class ReplaySession {
+public:
+    ReplaySession(std::shared_ptr<ReplayStore> store, double latencyScale);
+
+    bool recording() const { return store_->mode() == ReplayStore::Mode::RECORD; }
+    bool replaying() const { return store_->mode() == ReplayStore::Mode::REPLAY; }
+    ReplayStore& store() { return *store_; }
+
+    // Record mode: called with the real engines' results.
+    void recordLayout(const cv::Mat& page, const LayoutResult& result, double latencyMs);
+    void recordTable(const cv::Mat& crop, const TableResult& result, double latencyMs);
+    void ocrSubmitted(const cv::Mat& crop, int64_t taskId);
+    void ocrCompleted(int64_t taskId, const std::vector<ocr::PipelineOCRResult>& lines, bool success);
+
+    // Replay mode: stand-ins for the engines; the first two block for the latency.
+    LayoutResult detectLayout(const cv::Mat& page);
+    TableResult recognizeTable(const cv::Mat& crop);
+    bool submitOcr(const cv::Mat& crop, int64_t taskId);
+    bool fetchOcr(std::vector<ocr::PipelineOCRResult>& lines, int64_t& taskId, bool& success);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingRecord {
+        ContentDigest key;
+        Clock::time_point submitted;
+    };
+
+    struct QueuedOcr {
+        Clock::time_point readyAt;
+        int64_t taskId = 0;
+        std::vector<ocr::PipelineOCRResult> lines;
+        bool success = false;
+    };
+
+    void sleepFor(double latencyMs) const;
+    Clock::duration scaled(double latencyMs) const;
+
+    std::shared_ptr<ReplayStore> store_;
+    const double latencyScale_;
+
+    std::mutex mutex_;
+    std::unordered_map<int64_t, PendingRecord> pendingRecords_;
+    Clock::time_point lastOcrCompletion_{};
+    std::deque<QueuedOcr> ocrQueue_;
+    Clock::time_point ocrBusyUntil_{};
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,134 @@
+#pragma once
+
+/**
+ * @file concurrency_tuner.h
+ * @brief AIMD controller for the server's concurrency knobs.
+ *
+ * Once per window the server measures request and queue-wait p95 and the
+ * share of time its shards spent in NPU stages, and asks tuneConcurrency()
+ * for new values of three knobs that can change on a running server:
+ * documents running at once, the per-shard OCR lane limit, and the layout
+ * batch window. The rules, first match wins:
+ *
+ *   1. p95 over target, spent mostly in service rather than the queue:
+ *      documents slow each other down, so halve the running documents and
+ *      the batch window (multiplicative decrease).
+ *   2. Work waiting and the NPU under-used: one more running document, or
+ *      once at the cap one more OCR lane (additive increase).
+ *   3. Work waiting and the NPU saturated: more concurrency only queues at
+ *      the NPU, so widen the batch window by 1 ms for fuller batches.
+ *   4. Nothing waiting: shrink the batch window by 1 ms toward its minimum.
+ *
+ * Every knob stays within its configured bounds.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace rapid_doc {
+
+struct ConcurrencyTunerConfig {
+    bool enabled = false;
+    int intervalMs = 5000;              // one decision per window
+    double targetP95Seconds = 0.0;      // request p95 above this backs off (0 = no latency target)
+    double npuBusyLow = 0.6;            // under this with work waiting: add concurrency
+    double npuBusyHigh = 0.9;           // at or above with work waiting: widen batches instead
+    size_t minWindowRequests = 4;       // completions a latency verdict needs
+    int minInflight = 1;
+    int maxInflight = 0;                // documents running at once (0 = one per shard)
+    int minOcrLanes = 1;
+    int maxOcrLanes = 3;                // per-shard OCR lane limit (one per DX-M1 core)
+    int minBatchDelayMs = 0;
+    int maxBatchDelayMs = 8;            // layout batch window
+};
+
+struct TunerKnobs {
+    int inflight = 1;
+    int ocrLanes = 1;
+    int batchDelayMs = -1;              // -1 = layout is not batched; left alone
+
+    bool operator==(const TunerKnobs& other) const {
+        return inflight == other.inflight && ocrLanes == other.ocrLanes &&
+               batchDelayMs == other.batchDelayMs;
+    }
+    bool operator!=(const TunerKnobs& other) const { return !(*this == other); }
+};
+
+/// What the server saw over one window
+struct TunerWindow {
+    size_t completed = 0;               // documents finished in the window
+    size_t queued = 0;                  // documents waiting at its end
+    double requestP95Seconds = 0.0;
+    double queueP95Seconds = 0.0;
+    double npuBusyShare = 0.0;          // NPU stage time per shard over the window, 0-1
+};
+
+struct TunerDecision {
+    TunerKnobs knobs;
+    std::string reason;                 // why the knobs moved, or why they held
+};
+
+/**
+ * @param shards Shard count, the running-document cap when maxInflight is 0
+ */
+inline TunerDecision tuneConcurrency(
+    const TunerKnobs& current,
+    const TunerWindow& window,
+    const ConcurrencyTunerConfig& config,
+    size_t shards)
+{
+    const int maxInflight = std::max(
+        config.minInflight, config.maxInflight > 0 ? config.maxInflight : static_cast<int>(shards));
+    TunerDecision decision;
+    TunerKnobs& next = decision.knobs;
+    next.inflight = std::clamp(current.inflight, config.minInflight, maxInflight);
+    const int maxOcrLanes = std::max(config.minOcrLanes, config.maxOcrLanes);
+    next.ocrLanes = std::clamp(current.ocrLanes, config.minOcrLanes, maxOcrLanes);
+    const bool batching = current.batchDelayMs >= 0;
+    const int maxBatchDelayMs = std::max(config.minBatchDelayMs, config.maxBatchDelayMs);
+    next.batchDelayMs =
+        batching ? std::clamp(current.batchDelayMs, config.minBatchDelayMs, maxBatchDelayMs) : -1;
+
+    std::ostringstream reason;
+    reason.precision(3);
+    // Every request waits a little for its worker; only count a wait worth a
+    // tenth of the latency.
+    const bool waiting =
+        window.queued > 0 ||
+        (window.queueP95Seconds > 0.0 && window.queueP95Seconds * 10.0 >= window.requestP95Seconds);
+    if (config.targetP95Seconds > 0.0 && window.completed >= config.minWindowRequests &&
+        window.requestP95Seconds > config.targetP95Seconds &&
+        window.queueP95Seconds * 2.0 < window.requestP95Seconds) {
+        next.inflight = std::max(config.minInflight, next.inflight / 2);
+        if (batching) {
+            next.batchDelayMs = std::max(config.minBatchDelayMs, next.batchDelayMs / 2);
+        }
+        reason << "p95 " << window.requestP95Seconds << " s over target " << config.targetP95Seconds
+               << " s, mostly in service";
+    } else if (waiting && window.npuBusyShare < config.npuBusyLow) {
+        if (next.inflight < maxInflight) {
+            ++next.inflight;
+        } else if (next.ocrLanes < maxOcrLanes) {
+            ++next.ocrLanes;
+        }
+        reason << "work waiting, NPU busy " << window.npuBusyShare;
+    } else if (waiting && window.npuBusyShare >= config.npuBusyHigh) {
+        if (batching) {
+            next.batchDelayMs = std::min(maxBatchDelayMs, next.batchDelayMs + 1);
+        }
+        reason << "NPU saturated (busy " << window.npuBusyShare << ") with work waiting";
+    } else if (!waiting) {
+        if (batching) {
+            next.batchDelayMs = std::max(config.minBatchDelayMs, next.batchDelayMs - 1);
+        }
+        reason << "nothing waiting";
+    } else {
+        reason << "NPU busy " << window.npuBusyShare << " within band";
+    }
+    decision.reason = reason.str();
+    return decision;
+}
+
+} // namespace rapid_doc
@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * @file device_health.h
+ * @brief NPU device telemetry and the admission state it maps to.
+ *
+ * The server samples each device's temperature, NPU clocks and memory, and
+ * the share of time its shards held the NPU. A device that is too hot or
+ * short of memory stops taking new documents before the runtime starts
+ * failing inferences; one whose clocks are held below their peak while it
+ * is warm (thermal DVFS) only takes work the healthy devices cannot.
+ */
+
+#include "server/request_scheduler.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace rapid_doc {
+
+struct DeviceTelemetry {
+    int deviceId = -1;
+    uint64_t memoryTotalBytes = 0;
+    std::optional<uint64_t> memoryLastUsedBytes;    // only when the runtime reports usage
+    std::optional<uint64_t> memoryPeakUsedBytes;
+    std::optional<int> temperatureC;                // hottest NPU core
+    std::optional<int> npuClockMhz;                 // slowest NPU core
+    int peakNpuClockMhz = 0;                        // fastest core clock seen since start
+    double npuUtilization = 0.0;                    // share of the last window shards held the NPU
+};
+
+/**
+ * @brief Admission limits; a limit of 0 is off.
+ */
+struct DeviceAdmissionLimits {
+    int maxTemperatureC = 0;            // paused at or above, resumed resumeMarginC below
+    int resumeMarginC = 5;
+    double maxMemoryUsedRatio = 0.95;   // paused at or above this share of device memory
+    double throttleClockRatio = 0.85;   // degraded below this share of the peak clock ...
+    int throttleMinTemperatureC = 70;   // ... while at least this warm (idle DVFS is not throttling)
+};
+
+enum class DeviceHealth : int {
+    OK = 0,
+    THROTTLED,
+    OVERHEATED,
+    MEMORY_PRESSURE,
+};
+
+inline const char* deviceHealthName(DeviceHealth health) {
+    switch (health) {
+    case DeviceHealth::THROTTLED:       return "throttled";
+    case DeviceHealth::OVERHEATED:      return "overheated";
+    case DeviceHealth::MEMORY_PRESSURE: return "memory_pressure";
+    case DeviceHealth::OK:
+    default:                            return "ok";
+    }
+}
+
+/**
+ * @brief Health of a device from its latest sample.
+ * @param previous Last verdict, for the temperature hysteresis
+ */
+inline DeviceHealth assessDevice(
+    const DeviceTelemetry& sample,
+    const DeviceAdmissionLimits& limits,
+    DeviceHealth previous = DeviceHealth::OK)
+{
+    if (limits.maxMemoryUsedRatio > 0.0 && sample.memoryLastUsedBytes && sample.memoryTotalBytes > 0 &&
+        static_cast<double>(*sample.memoryLastUsedBytes) >=
+            limits.maxMemoryUsedRatio * static_cast<double>(sample.memoryTotalBytes)) {
+        return DeviceHealth::MEMORY_PRESSURE;
+    }
+    if (limits.maxTemperatureC > 0 && sample.temperatureC) {
+        const int limit = previous == DeviceHealth::OVERHEATED
+                              ? limits.maxTemperatureC - limits.resumeMarginC
+                              : limits.maxTemperatureC;
+        if (*sample.temperatureC >= limit) {
+            return DeviceHealth::OVERHEATED;
+        }
+    }
+    if (limits.throttleClockRatio > 0.0 && sample.npuClockMhz && sample.peakNpuClockMhz > 0 &&
+        sample.temperatureC && *sample.temperatureC >= limits.throttleMinTemperatureC &&
+        static_cast<double>(*sample.npuClockMhz) <
+            limits.throttleClockRatio * static_cast<double>(sample.peakNpuClockMhz)) {
+        return DeviceHealth::THROTTLED;
+    }
+    return DeviceHealth::OK;
+}
+
+inline WorkerState admissionState(DeviceHealth health) {
+    switch (health) {
+    case DeviceHealth::OK:        return WorkerState::ACTIVE;
+    case DeviceHealth::THROTTLED: return WorkerState::DEGRADED;
+    default:                      return WorkerState::PAUSED;
+    }
+}
+
+} // namespace rapid_doc
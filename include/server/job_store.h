@@ -0,0 +1,330 @@
+#pragma once
+
+/**
+ * @file job_store.h
+ * @brief On-disk queue of asynchronous parse jobs with per-page checkpoints.
+ *
+ * Every job is a directory under the store's root holding the upload, a
+ * job.json manifest (file name, options, status) and one pages/<n>.json
+ * checkpoint per finished page. Files are written under a temporary name
+ * and renamed, so a crash never leaves half a checkpoint. A store reopened
+ * after a restart counts each job's consecutive page checkpoints, which is
+ * where its next run picks up; jobs that were queued or running come back
+ * through unfinished(). Finished jobs stay until remove() or
+ * expireFinished() deletes their directory.
+ */
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace rapid_doc {
+
+struct JobInfo {
+    std::string id;
+    std::string filename;
+    std::string status = "queued";      // queued | running | done | failed
+    std::string error;                  // set when failed
+    nlohmann::json options = nlohmann::json::object();  // parse options the job was submitted with
+    int64_t createdAtMs = 0;            // Unix epoch
+    int64_t finishedAtMs = 0;           // Unix epoch, once done or failed
+    int completedPages = 0;             // consecutive checkpoints from the first page
+    int totalPages = 0;                 // 0 until the first run reports it
+
+    bool finished() const { return status == "done" || status == "failed"; }
+};
+
+class JobStore {
+public:
+    /// Creates @p rootDir if needed and loads the jobs already in it.
+    explicit JobStore(std::string rootDir)
+        : rootDir_(std::move(rootDir))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(rootDir_, ec);
+        load();
+    }
+
+    JobStore(const JobStore&) = delete;
+    JobStore& operator=(const JobStore&) = delete;
+
+    /// Persist a new queued job for @p bytes; @return its id, or "" if it could not be written
+    std::string create(const std::string& filename, const std::string& bytes, nlohmann::json options) {
+        JobInfo info;
+        info.id = makeJobId();
+        info.filename = filename;
+        info.options = std::move(options);
+        info.createdAtMs = nowMs();
+
+        const std::filesystem::path dir = jobDir(info.id);
+        std::error_code ec;
+        std::filesystem::create_directories(dir / kPagesDir, ec);
+        if (ec || !writeAtomically(dir / kUploadFile, bytes) ||
+            !writeAtomically(dir / kManifestFile, manifest(info).dump())) {
+            std::filesystem::remove_all(dir, ec);
+            return {};
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_[info.id] = info;
+        return info.id;
+    }
+
+    std::optional<JobInfo> find(const std::string& id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    /// Ids of jobs still to run, oldest first
+    std::vector<std::string> unfinished() const {
+        std::vector<std::pair<int64_t, std::string>> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : jobs_) {
+                if (!entry.second.finished()) {
+                    pending.emplace_back(entry.second.createdAtMs, entry.first);
+                }
+            }
+        }
+        std::sort(pending.begin(), pending.end());
+        std::vector<std::string> ids;
+        ids.reserve(pending.size());
+        for (auto& job : pending) {
+            ids.push_back(std::move(job.second));
+        }
+        return ids;
+    }
+
+    bool readUpload(const std::string& id, std::string& bytes) const {
+        return readFile(jobDir(id) / kUploadFile, bytes);
+    }
+
+    /// Where a job's runs leave their parse directories
+    std::filesystem::path outputDir(const std::string& id) const { return jobDir(id) / "output"; }
+
+    /**
+     * @brief Record page @p ordinal (0-based within the job) as finished.
+     *
+     * Checkpoints are expected in page order; the job's completed count only
+     * advances over consecutive pages.
+     * @param totalPages The job's page count as known so far
+     */
+    bool checkpointPage(const std::string& id, int ordinal, const nlohmann::json& page, int totalPages) {
+        if (!writeAtomically(pagePath(id, ordinal), page.dump())) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) {
+            return false;
+        }
+        JobInfo& info = it->second;
+        if (ordinal == info.completedPages) {
+            info.completedPages = ordinal + 1;
+        }
+        if (info.status != "running" || info.totalPages != totalPages) {
+            info.status = "running";
+            info.totalPages = totalPages;
+            writeManifestLocked(info);
+        }
+        return true;
+    }
+
+    void markDone(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it != jobs_.end()) {
+            it->second.status = "done";
+            it->second.finishedAtMs = nowMs();
+            it->second.totalPages = it->second.completedPages;
+            writeManifestLocked(it->second);
+        }
+    }
+
+    void markFailed(const std::string& id, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it != jobs_.end()) {
+            it->second.status = "failed";
+            it->second.finishedAtMs = nowMs();
+            it->second.error = error;
+            writeManifestLocked(it->second);
+        }
+    }
+
+    /// Checkpoints of up to @p limit finished pages starting at @p fromOrdinal
+    std::vector<nlohmann::json> readPages(const std::string& id, int fromOrdinal, int limit) const {
+        int completed = 0;
+        if (auto info = find(id)) {
+            completed = info->completedPages;
+        }
+        std::vector<nlohmann::json> pages;
+        const int end = std::min(completed, fromOrdinal + std::max(0, limit));
+        for (int ordinal = std::max(0, fromOrdinal); ordinal < end; ++ordinal) {
+            std::string text;
+            if (!readFile(pagePath(id, ordinal), text)) {
+                break;
+            }
+            pages.push_back(nlohmann::json::parse(text, nullptr, false));
+        }
+        return pages;
+    }
+
+    /**
+     * @brief Forget job @p id and delete its upload, checkpoints and output.
+     * The caller makes sure no run of the job is under way.
+     * @return false if there was no such job
+     */
+    bool remove(const std::string& id) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (jobs_.erase(id) == 0) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(jobDir(id), ec);
+        return true;
+    }
+
+    /// Remove the jobs that finished before @p cutoffMs (Unix epoch); @return how many
+    size_t expireFinished(int64_t cutoffMs) {
+        std::vector<std::string> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : jobs_) {
+                if (entry.second.finished() && entry.second.finishedAtMs < cutoffMs) {
+                    expired.push_back(entry.first);
+                }
+            }
+        }
+        size_t removed = 0;
+        for (const auto& id : expired) {
+            removed += remove(id) ? 1 : 0;
+        }
+        return removed;
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static constexpr const char* kManifestFile = "job.json";
+    static constexpr const char* kUploadFile = "upload";
+    static constexpr const char* kPagesDir = "pages";
+
+    std::filesystem::path jobDir(const std::string& id) const { return std::filesystem::path(rootDir_) / id; }
+
+    std::filesystem::path pagePath(const std::string& id, int ordinal) const {
+        std::ostringstream name;
+        name << std::setw(6) << std::setfill('0') << ordinal << ".json";
+        return jobDir(id) / kPagesDir / name.str();
+    }
+
+    static nlohmann::json manifest(const JobInfo& info) {
+        return nlohmann::json{
+            {"id", info.id},
+            {"filename", info.filename},
+            {"status", info.status},
+            {"error", info.error},
+            {"options", info.options},
+            {"created_at_ms", info.createdAtMs},
+            {"finished_at_ms", info.finishedAtMs},
+            {"total_pages", info.totalPages},
+        };
+    }
+
+    // Caller holds mutex_; a failed write only costs the status change on restart.
+    void writeManifestLocked(const JobInfo& info) {
+        writeAtomically(jobDir(info.id) / kManifestFile, manifest(info).dump());
+    }
+
+    void load() {
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(rootDir_, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string text;
+            if (!it->is_directory() || !readFile(it->path() / kManifestFile, text)) {
+                continue;
+            }
+            const auto meta = nlohmann::json::parse(text, nullptr, false);
+            if (!meta.is_object()) {
+                continue;
+            }
+            JobInfo info;
+            info.id = it->path().filename().string();
+            info.filename = meta.value("filename", std::string("upload.bin"));
+            info.status = meta.value("status", std::string("queued"));
+            info.error = meta.value("error", std::string());
+            info.options = meta.value("options", nlohmann::json::object());
+            info.createdAtMs = meta.value("created_at_ms", int64_t{0});
+            info.finishedAtMs = meta.value("finished_at_ms", info.createdAtMs);
+            info.totalPages = meta.value("total_pages", 0);
+            // A job interrupted mid-run is queued again after its last checkpoint.
+            if (info.status == "running") {
+                info.status = "queued";
+            }
+            while (std::filesystem::exists(pagePath(info.id, info.completedPages), ec)) {
+                ++info.completedPages;
+            }
+            jobs_[info.id] = std::move(info);
+        }
+    }
+
+    std::string makeJobId() {
+        std::ostringstream out;
+        out << "job_" << nowMs() << "_pid" << ::getpid() << "_" << nextId_.fetch_add(1);
+        return out.str();
+    }
+
+    static bool readFile(const std::filesystem::path& path, std::string& out) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !in.bad();
+    }
+
+    static bool writeAtomically(const std::filesystem::path& path, const std::string& data) {
+        const std::filesystem::path tmp = path.string() + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!out) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+
+    const std::string rootDir_;
+    std::atomic<uint64_t> nextId_{0};
+    mutable std::mutex mutex_;
+    std::map<std::string, JobInfo> jobs_;
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @file lb_headers.h
+ * @brief HTTP headers shared by the topology LB and the backends it fronts.
+ *
+ * The LB forwards request bodies untouched and asks the backend, through
+ * request headers, to stamp the LB's routing metadata into its own JSON.
+ * A backend that did so answers with kLbMetadataApplied; for any other
+ * backend the LB falls back to parsing and rewriting the response.
+ */
+
+namespace rapid_doc {
+namespace lb_headers {
+
+// LB -> backend
+constexpr const char* kBackendId = "X-RapidDoc-Lb-Backend-Id";
+constexpr const char* kServerId = "X-RapidDoc-Lb-Server-Id";
+constexpr const char* kOverheadMs = "X-RapidDoc-Lb-Overhead-Ms";   // LB time before forwarding
+constexpr const char* kDeadlineMs = "X-RapidDoc-Deadline-Ms";       // time left before the LB gives up
+
+// Either direction, same-host only: the body is in this file (see shm_transport.h)
+constexpr const char* kShmBody = "X-RapidDoc-Shm-Body";
+constexpr const char* kShmSecret = "X-RapidDoc-Shm-Secret";        // LB -> backend, with kShmBody
+
+// backend -> LB
+constexpr const char* kLbMetadataApplied = "X-RapidDoc-Lb-Metadata";
+
+// LB -> client
+constexpr const char* kProxyMs = "X-RapidDoc-Lb-Proxy-Ms";          // full LB round trip
+constexpr const char* kServedBy = "X-RapidDoc-Backend-Id";
+
+} // namespace lb_headers
+} // namespace rapid_doc
@@ -0,0 +1,250 @@
+#pragma once
+
+/**
+ * @file lb_routing.h
+ * @brief Backend selection for the topology LB.
+ *
+ * Every backend carries a BackendLoad: what the LB itself has in flight
+ * there, what the backend last reported on /status (queued and running
+ * requests, mean service time) and whether it is currently healthy. A
+ * BackendRouter picks among the healthy ones with one of:
+ *
+ *  - least_inflight_rr: fewest LB requests in flight, ties broken round-robin
+ *  - least_work: smallest estimated time until the new request would finish,
+ *    from in-flight upload bytes times a learned ms-per-byte rate, or the
+ *    backend's reported queue times its mean service time if that is larger
+ *  - p2c: power of two choices over in-flight plus reported queue
+ *  - consistent_hash: by upload content on a ring of virtual nodes, so
+ *    repeats land on the backend whose result cache already holds them
+ *
+ * A backend is ejected after ejectAfterFailures consecutive failed status
+ * polls or proxy attempts, and readmitted by the next successful poll.
+ */
+
+#include "common/content_hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rapid_doc {
+
+enum class RoutingPolicy {
+    LEAST_INFLIGHT_RR,
+    LEAST_WORK,
+    POWER_OF_TWO,
+    CONSISTENT_HASH,
+};
+
+inline bool parseRoutingPolicy(const std::string& name, RoutingPolicy& policy) {
+    if (name == "least_inflight_rr") { policy = RoutingPolicy::LEAST_INFLIGHT_RR; return true; }
+    if (name == "least_work") { policy = RoutingPolicy::LEAST_WORK; return true; }
+    if (name == "p2c") { policy = RoutingPolicy::POWER_OF_TWO; return true; }
+    if (name == "consistent_hash") { policy = RoutingPolicy::CONSISTENT_HASH; return true; }
+    return false;
+}
+
+inline const char* routingPolicyName(RoutingPolicy policy) {
+    switch (policy) {
+        case RoutingPolicy::LEAST_INFLIGHT_RR: return "least_inflight_rr";
+        case RoutingPolicy::LEAST_WORK: return "least_work";
+        case RoutingPolicy::POWER_OF_TWO: return "p2c";
+        case RoutingPolicy::CONSISTENT_HASH: return "consistent_hash";
+    }
+    return "least_inflight_rr";
+}
+
+class BackendLoad {
+public:
+    static constexpr double kDefaultMsPerByte = 1e-3;   // ~1 s per MB until measured
+
+    void beginRequest(size_t bytes) {
+        inflight_.fetch_add(1, std::memory_order_relaxed);
+        inflightBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /// @p elapsedMs < 0 marks a failed attempt, which teaches no rate.
+    void endRequest(size_t bytes, double elapsedMs) {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        inflightBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        if (elapsedMs >= 0.0 && bytes > 0) {
+            const double sample = elapsedMs / static_cast<double>(bytes);
+            double current = msPerByte_.load(std::memory_order_relaxed);
+            while (!msPerByte_.compare_exchange_weak(
+                current, current * 0.8 + sample * 0.2, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    /// A successful /status poll: readmits the backend.
+    void reportStatus(uint64_t queued, uint64_t running, double meanServiceMs) {
+        reportedBacklog_.store(queued + running, std::memory_order_relaxed);
+        reportedServiceMs_.store(meanServiceMs, std::memory_order_relaxed);
+        failures_.store(0, std::memory_order_relaxed);
+        healthy_.store(true, std::memory_order_relaxed);
+    }
+
+    /// @return true when this failure ejected the backend
+    bool reportFailure(int ejectAfterFailures) {
+        const int failures = failures_.fetch_add(1, std::memory_order_relaxed) + 1;
+        return failures >= std::max(1, ejectAfterFailures) &&
+               healthy_.exchange(false, std::memory_order_relaxed);
+    }
+
+    bool healthy() const { return healthy_.load(std::memory_order_relaxed); }
+    uint64_t inflight() const { return inflight_.load(std::memory_order_relaxed); }
+    uint64_t reportedBacklog() const { return reportedBacklog_.load(std::memory_order_relaxed); }
+    double msPerByte() const { return msPerByte_.load(std::memory_order_relaxed); }
+
+    /// Milliseconds until a new request of @p bytes would be done here.
+    double estimatedWorkMs(size_t bytes) const {
+        const double rate = msPerByte();
+        const double local =
+            static_cast<double>(inflightBytes_.load(std::memory_order_relaxed)) * rate;
+        const double reported = static_cast<double>(reportedBacklog()) *
+                                reportedServiceMs_.load(std::memory_order_relaxed);
+        return std::max(local, reported) + static_cast<double>(bytes) * rate;
+    }
+
+private:
+    std::atomic<uint64_t> inflight_{0};
+    std::atomic<uint64_t> inflightBytes_{0};
+    std::atomic<double> msPerByte_{kDefaultMsPerByte};
+    std::atomic<uint64_t> reportedBacklog_{0};
+    std::atomic<double> reportedServiceMs_{0.0};
+    std::atomic<int> failures_{0};
+    std::atomic<bool> healthy_{true};
+};
+
+class BackendRouter {
+public:
+    /**
+     * @param policy Selection policy
+     * @param backendIds Stable backend ids; consistent hashing places them by id
+     * @param virtualNodes Ring points per backend for consistent_hash
+     */
+    BackendRouter(RoutingPolicy policy, const std::vector<std::string>& backendIds, int virtualNodes = 64)
+        : policy_(policy)
+    {
+        loads_.reserve(backendIds.size());
+        for (size_t i = 0; i < backendIds.size(); ++i) {
+            loads_.push_back(std::make_unique<BackendLoad>());
+            for (int v = 0; v < std::max(1, virtualNodes); ++v) {
+                ring_.emplace_back(hashString(backendIds[i] + "#" + std::to_string(v)), i);
+            }
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+
+    BackendRouter(const BackendRouter&) = delete;
+    BackendRouter& operator=(const BackendRouter&) = delete;
+
+    RoutingPolicy policy() const { return policy_; }
+    size_t size() const { return loads_.size(); }
+    BackendLoad& load(size_t index) { return *loads_.at(index); }
+    const BackendLoad& load(size_t index) const { return *loads_.at(index); }
+
+    /// Whether select() uses its content key (so callers can skip hashing the body).
+    bool needsContentKey() const { return policy_ == RoutingPolicy::CONSISTENT_HASH; }
+
+    /// @return Backend index, or -1 when every backend is ejected
+    int select(size_t requestBytes, uint64_t contentKey = 0) {
+        std::vector<size_t> healthy;
+        healthy.reserve(loads_.size());
+        for (size_t i = 0; i < loads_.size(); ++i) {
+            if (loads_[i]->healthy()) {
+                healthy.push_back(i);
+            }
+        }
+        if (healthy.empty()) {
+            return -1;
+        }
+
+        switch (policy_) {
+            case RoutingPolicy::LEAST_WORK:
+                return pickMin(healthy, [&](size_t i) { return loads_[i]->estimatedWorkMs(requestBytes); });
+            case RoutingPolicy::POWER_OF_TWO:
+                return pickTwoChoices(healthy);
+            case RoutingPolicy::CONSISTENT_HASH:
+                return pickOnRing(contentKey);
+            case RoutingPolicy::LEAST_INFLIGHT_RR:
+                break;
+        }
+        return pickMin(healthy, [&](size_t i) { return static_cast<double>(loads_[i]->inflight()); });
+    }
+
+    /// Content key of an upload for consistent_hash.
+    static uint64_t hashBytes(const char* data, size_t size) {
+        ContentHasher hasher;
+        hasher.update(data, size);
+        return hasher.digest().a;
+    }
+
+private:
+    static uint64_t hashString(const std::string& value) { return hashBytes(value.data(), value.size()); }
+
+    // Lowest score wins; the scan starts at a rotating offset so ties go round-robin.
+    template <typename Score>
+    int pickMin(const std::vector<size_t>& candidates, Score score) {
+        const size_t start = static_cast<size_t>(
+            cursor_.fetch_add(1, std::memory_order_relaxed) % candidates.size());
+        size_t best = candidates[start];
+        double bestScore = score(best);
+        for (size_t offset = 1; offset < candidates.size(); ++offset) {
+            const size_t idx = candidates[(start + offset) % candidates.size()];
+            const double value = score(idx);
+            if (value < bestScore) {
+                bestScore = value;
+                best = idx;
+            }
+        }
+        return static_cast<int>(best);
+    }
+
+    int pickTwoChoices(const std::vector<size_t>& candidates) {
+        if (candidates.size() == 1) {
+            return static_cast<int>(candidates.front());
+        }
+        thread_local std::minstd_rand rng(std::random_device{}());
+        std::uniform_int_distribution<size_t> pick(0, candidates.size() - 1);
+        const size_t first = pick(rng);
+        size_t second = pick(rng);
+        if (second == first) {
+            second = (first + 1) % candidates.size();
+        }
+        const size_t a = candidates[first];
+        const size_t b = candidates[second];
+        const uint64_t loadA = loads_[a]->inflight() + loads_[a]->reportedBacklog();
+        const uint64_t loadB = loads_[b]->inflight() + loads_[b]->reportedBacklog();
+        return static_cast<int>(loadB < loadA ? b : a);
+    }
+
+    // First healthy backend clockwise from the key. Ejecting one backend only
+    // moves the keys it owned.
+    int pickOnRing(uint64_t key) const {
+        auto it = std::lower_bound(
+            ring_.begin(), ring_.end(), std::make_pair(key, size_t{0}));
+        for (size_t step = 0; step < ring_.size(); ++step, ++it) {
+            if (it == ring_.end()) {
+                it = ring_.begin();
+            }
+            if (loads_[it->second]->healthy()) {
+                return static_cast<int>(it->second);
+            }
+        }
+        return -1;
+    }
+
+    const RoutingPolicy policy_;
+    std::vector<std::unique_ptr<BackendLoad>> loads_;
+    std::vector<std::pair<uint64_t, size_t>> ring_;
+    std::atomic<uint64_t> cursor_{0};
+};
+
+} // namespace rapid_doc
@@ -0,0 +1,287 @@
+#pragma once
+
+/**
+ * @file metrics_registry.h
+ * @brief Counters, gauges and fixed-bucket histograms exported in Prometheus
+ *        text format on /metrics.
+ *
+ * Series are registered once, at startup or on first use, under a mutex;
+ * recording into a registered series is a handful of relaxed atomic adds, so
+ * the hot path never takes a lock. Histograms use fixed, roughly
+ * logarithmic buckets (see exponentialBuckets) instead of keeping samples,
+ * which is what lets Prometheus compute p50/p99 from the scrape.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rapid_doc {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// @p count upper bounds starting at @p start, each @p factor times the last
+inline std::vector<double> exponentialBuckets(double start, double factor, int count) {
+    std::vector<double> bounds;
+    bounds.reserve(static_cast<size_t>(std::max(0, count)));
+    double bound = start;
+    for (int i = 0; i < count; ++i) {
+        bounds.push_back(bound);
+        bound *= factor;
+    }
+    return bounds;
+}
+
+/// 100 us to ~7 min in powers of two: page stages through whole documents
+inline std::vector<double> latencySecondsBuckets() {
+    return exponentialBuckets(1e-4, 2.0, 22);
+}
+
+/**
+ * @brief Quantile @p q of the observations counted in @p counts
+ *
+ * @p counts has one entry per bound plus +Inf, e.g. the difference of two
+ * reads of a histogram for the quantile over that window. Interpolates
+ * linearly inside the bucket, like Prometheus histogram_quantile(); the
+ * +Inf bucket reports the last finite bound. 0 when nothing was counted.
+ */
+inline double histogramQuantile(
+    const std::vector<double>& bounds, const std::vector<uint64_t>& counts, double q)
+{
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0 || bounds.empty()) {
+        return 0.0;
+    }
+    const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(total);
+    uint64_t below = 0;
+    for (size_t i = 0; i < counts.size() && i < bounds.size(); ++i) {
+        if (counts[i] > 0 && static_cast<double>(below + counts[i]) >= rank) {
+            const double lower = i == 0 ? 0.0 : bounds[i - 1];
+            return lower + (bounds[i] - lower) * (rank - static_cast<double>(below)) /
+                               static_cast<double>(counts[i]);
+        }
+        below += counts[i];
+    }
+    return bounds.back();
+}
+
+class MetricCounter {
+public:
+    void add(uint64_t value = 1) { value_.fetch_add(value, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class MetricHistogram {
+public:
+    /// @param bounds Ascending bucket upper bounds; +Inf is implicit
+    explicit MetricHistogram(std::vector<double> bounds)
+        : bounds_(std::move(bounds))
+        , buckets_(new std::atomic<uint64_t>[bounds_.size() + 1])
+    {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void observe(double value) {
+        if (!(value >= 0.0)) {
+            value = 0.0;   // negative or NaN durations count as zero
+        }
+        const size_t bucket = static_cast<size_t>(
+            std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumNano_.fetch_add(static_cast<uint64_t>(std::llround(value * 1e9)), std::memory_order_relaxed);
+    }
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    /// Observations in bucket @p index alone (index bounds().size() is +Inf)
+    uint64_t bucketCount(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    /// Every bucket's count, +Inf last (for histogramQuantile)
+    std::vector<uint64_t> bucketCounts() const {
+        std::vector<uint64_t> counts(bounds_.size() + 1);
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] = bucketCount(i);
+        }
+        return counts;
+    }
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double sum() const { return static_cast<double>(sumNano_.load(std::memory_order_relaxed)) / 1e9; }
+
+private:
+    const std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumNano_{0};   // fixed point, so the sum is one atomic add
+};
+
+class MetricsRegistry {
+public:
+    /// @return The series for @p name and @p labels, created on first call
+    MetricCounter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Series& series = findOrAdd(name, help, "counter", labels);
+        if (!series.counter) {
+            series.counter = std::make_unique<MetricCounter>();
+        }
+        return *series.counter;
+    }
+
+    MetricHistogram& histogram(
+        const std::string& name,
+        const std::string& help,
+        const MetricLabels& labels = {},
+        const std::vector<double>& bounds = latencySecondsBuckets())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Series& series = findOrAdd(name, help, "histogram", labels);
+        if (!series.histogram) {
+            series.histogram = std::make_unique<MetricHistogram>(bounds);
+        }
+        return *series.histogram;
+    }
+
+    /// A gauge read from @p read at scrape time
+    void gauge(
+        const std::string& name,
+        const std::string& help,
+        const MetricLabels& labels,
+        std::function<double()> read)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        findOrAdd(name, help, "gauge", labels).read = std::move(read);
+    }
+
+    /// Prometheus text exposition format 0.0.4
+    std::string renderPrometheus() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream out;
+        out.precision(9);
+        for (const auto& [name, family] : families_) {
+            out << "# HELP " << name << " " << family.help << "\n";
+            out << "# TYPE " << name << " " << family.type << "\n";
+            for (const auto& series : family.series) {
+                if (series->counter) {
+                    out << name << formatLabels(series->labels) << " " << series->counter->value() << "\n";
+                } else if (series->read) {
+                    out << name << formatLabels(series->labels) << " " << series->read() << "\n";
+                } else if (series->histogram) {
+                    renderHistogram(out, name, series->labels, *series->histogram);
+                }
+            }
+        }
+        return out.str();
+    }
+
+private:
+    struct Series {
+        MetricLabels labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricHistogram> histogram;
+        std::function<double()> read;
+    };
+
+    struct Family {
+        std::string help;
+        std::string type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    // Caller holds mutex_.
+    Series& findOrAdd(
+        const std::string& name,
+        const std::string& help,
+        const char* type,
+        const MetricLabels& labels)
+    {
+        Family& family = families_[name];
+        if (family.type.empty()) {
+            family.help = help;
+            family.type = type;
+        }
+        for (auto& series : family.series) {
+            if (series->labels == labels) {
+                return *series;
+            }
+        }
+        family.series.push_back(std::make_unique<Series>());
+        family.series.back()->labels = labels;
+        return *family.series.back();
+    }
+
+    static std::string escapeLabelValue(const std::string& value) {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char ch : value) {
+            if (ch == '\\' || ch == '"') {
+                escaped += '\\';
+                escaped += ch;
+            } else if (ch == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += ch;
+            }
+        }
+        return escaped;
+    }
+
+    static std::string formatLabels(const MetricLabels& labels, const std::string& le = {}) {
+        if (labels.empty() && le.empty()) {
+            return {};
+        }
+        std::string text = "{";
+        for (const auto& [key, value] : labels) {
+            if (text.size() > 1) {
+                text += ",";
+            }
+            text += key + "=\"" + escapeLabelValue(value) + "\"";
+        }
+        if (!le.empty()) {
+            text += std::string(text.size() > 1 ? "," : "") + "le=\"" + le + "\"";
+        }
+        return text + "}";
+    }
+
+    static void renderHistogram(
+        std::ostringstream& out,
+        const std::string& name,
+        const MetricLabels& labels,
+        const MetricHistogram& histogram)
+    {
+        // Buckets are read one by one while observations continue, so the
+        // cumulative counts, not count(), end at +Inf to stay monotonic.
+        uint64_t cumulative = 0;
+        const auto& bounds = histogram.bounds();
+        for (size_t i = 0; i < bounds.size(); ++i) {
+            cumulative += histogram.bucketCount(i);
+            std::ostringstream le;
+            le.precision(9);
+            le << bounds[i];
+            out << name << "_bucket" << formatLabels(labels, le.str()) << " " << cumulative << "\n";
+        }
+        cumulative += histogram.bucketCount(bounds.size());
+        out << name << "_bucket" << formatLabels(labels, "+Inf") << " " << cumulative << "\n";
+        out << name << "_sum" << formatLabels(labels) << " " << histogram.sum() << "\n";
+        out << name << "_count" << formatLabels(labels) << " " << cumulative << "\n";
+    }
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+} // namespace rapid_doc
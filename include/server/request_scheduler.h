@@ -0,0 +1,330 @@
+#pragma once
+
+/**
+ * @file request_scheduler.h
+ * @brief Admission queue feeding one worker thread per pipeline shard.
+ *
+ * Requests wait in a bounded queue instead of on a shard's mutex, so
+ * whichever shard frees up first takes the next request. Interactive
+ * requests (single images) go ahead of batch requests (PDFs), but at most
+ * interactiveBurst in a row while batch work is waiting, so batch traffic
+ * cannot starve. When the queue is full, trySubmit() fails and the caller
+ * rejects the request with retryAfterSeconds() as its back-off hint.
+ *
+ * Idle workers can also be reserved by a running job (reserveIdle) so it
+ * can spread one large document over their shards; a reserved worker takes
+ * no queued job until it is released.
+ *
+ * Device health narrows admission per worker (setWorkerState): a DEGRADED
+ * worker only takes a job no ACTIVE worker is idle for, a PAUSED one takes
+ * none, and once every worker is paused new jobs are rejected. A running
+ * limit (setRunningLimit) caps how many workers run jobs at once, so the
+ * server can trade concurrency for latency without restarting shards.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rapid_doc {
+
+enum class RequestPriority : int {
+    INTERACTIVE = 0,
+    BATCH = 1,
+};
+
+constexpr size_t kRequestPriorityCount = 2;
+
+enum class WorkerState : int {
+    ACTIVE = 0,
+    DEGRADED = 1,     // takes only overflow work
+    PAUSED = 2,       // takes no new work
+};
+
+class RequestScheduler {
+public:
+    /// Runs on worker @p worker; must not throw.
+    using Job = std::function<void(size_t worker)>;
+
+    struct Stats {
+        std::array<size_t, kRequestPriorityCount> queued{};
+        size_t running = 0;
+        size_t runningLimit = 0;
+        size_t pausedWorkers = 0;
+        uint64_t admitted = 0;
+        uint64_t rejected = 0;
+        uint64_t completed = 0;
+        double meanServiceMs = 0.0;
+    };
+
+    /**
+     * @param workers Worker threads, one per shard (at least one)
+     * @param maxQueued Queued (not yet running) jobs admitted at once (0 = unbounded)
+     * @param interactiveBurst Interactive jobs taken in a row while batch jobs wait
+     * @param onWorkerStart Runs first on each worker thread, with its index (e.g. to pin it)
+     */
+    RequestScheduler(
+        size_t workers,
+        size_t maxQueued,
+        size_t interactiveBurst = 4,
+        std::function<void(size_t worker)> onWorkerStart = {})
+        : maxQueued_(maxQueued)
+        , interactiveBurst_(std::max<size_t>(1, interactiveBurst))
+        , reserved_(std::max<size_t>(1, workers), false)
+        , idle_(std::max<size_t>(1, workers), true)
+        , states_(std::max<size_t>(1, workers), WorkerState::ACTIVE)
+        , runningLimit_(std::max<size_t>(1, workers))
+    {
+        const size_t count = std::max<size_t>(1, workers);
+        workers_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back([this, i, onWorkerStart]() {
+                if (onWorkerStart) {
+                    onWorkerStart(i);
+                }
+                workerLoop(i);
+            });
+        }
+    }
+
+    /// Finishes running jobs; jobs still queued are dropped.
+    ~RequestScheduler() { stop(); }
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    size_t workerCount() const { return workers_.size(); }
+
+    /**
+     * @brief Queue one job.
+     * @return false if the queue is full or stopped (the job is not run)
+     */
+    bool trySubmit(RequestPriority priority, Job job) {
+        std::vector<Job> jobs;
+        jobs.push_back(std::move(job));
+        return trySubmitAll(priority, std::move(jobs));
+    }
+
+    /**
+     * @brief Queue several jobs of one request, all or none.
+     * @return false if they do not all fit (none are queued)
+     */
+    bool trySubmitAll(RequestPriority priority, std::vector<Job> jobs) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const size_t queued = queues_[0].size() + queues_[1].size();
+            if (stopping_ || pausedCountLocked() == workers_.size() ||
+                (maxQueued_ > 0 && queued + jobs.size() > maxQueued_)) {
+                rejected_ += jobs.size();
+                return false;
+            }
+            auto& queue = queues_[static_cast<size_t>(priority)];
+            for (auto& job : jobs) {
+                queue.push_back(std::move(job));
+            }
+            admitted_ += jobs.size();
+        }
+        changed_.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Reserve up to @p count idle workers other than @p self.
+     * @return Indices of the reserved workers; give them back with release()
+     */
+    std::vector<size_t> reserveIdle(size_t self, size_t count) {
+        std::vector<size_t> reserved;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t offset = 1; offset < workers_.size() && reserved.size() < count; ++offset) {
+            const size_t index = (self + offset) % workers_.size();
+            if (idle_[index] && !reserved_[index] && states_[index] == WorkerState::ACTIVE) {
+                reserved_[index] = true;
+                reserved.push_back(index);
+            }
+        }
+        return reserved;
+    }
+
+    /// Narrow or restore what worker @p index may take; its running job is unaffected.
+    void setWorkerState(size_t index, WorkerState state) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (index >= states_.size() || states_[index] == state) {
+                return;
+            }
+            states_[index] = state;
+        }
+        changed_.notify_all();
+    }
+
+    /// Cap on jobs running at once, below the worker count (0 = one per worker)
+    void setRunningLimit(size_t limit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            runningLimit_ = limit == 0 ? workers_.size() : std::min(limit, workers_.size());
+        }
+        changed_.notify_all();
+    }
+
+    WorkerState workerState(size_t index) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return index < states_.size() ? states_[index] : WorkerState::ACTIVE;
+    }
+
+    void release(const std::vector<size_t>& workers) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t index : workers) {
+                reserved_[index] = false;
+            }
+        }
+        changed_.notify_all();
+    }
+
+    /**
+     * @brief Back-off hint for a rejected request: the time for the queue
+     * ahead of it to drain across all workers, rounded up (at least 1 s).
+     */
+    int retryAfterSeconds() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const double queued = static_cast<double>(queues_[0].size() + queues_[1].size() + running_);
+        const double drainMs = queued * meanServiceMs_ / static_cast<double>(workers_.size());
+        return std::max(1, static_cast<int>(std::ceil(drainMs / 1000.0)));
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats;
+        stats.queued = {queues_[0].size(), queues_[1].size()};
+        stats.running = running_;
+        stats.runningLimit = runningLimit_;
+        stats.pausedWorkers = pausedCountLocked();
+        stats.admitted = admitted_;
+        stats.rejected = rejected_;
+        stats.completed = completed_;
+        stats.meanServiceMs = meanServiceMs_;
+        return stats;
+    }
+
+    /// Stop taking jobs and join the workers after their current job.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            queues_[0].clear();
+            queues_[1].clear();
+        }
+        changed_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+private:
+    // Caller holds mutex_.
+    size_t pausedCountLocked() const {
+        return static_cast<size_t>(std::count(states_.begin(), states_.end(), WorkerState::PAUSED));
+    }
+
+    // Caller holds mutex_.
+    bool mayTakeLocked(size_t index) const {
+        if (reserved_[index] || running_ >= runningLimit_ ||
+            (queues_[0].empty() && queues_[1].empty())) {
+            return false;
+        }
+        switch (states_[index]) {
+        case WorkerState::ACTIVE:
+            return true;
+        case WorkerState::DEGRADED:
+            for (size_t other = 0; other < states_.size(); ++other) {
+                if (other != index && idle_[other] && !reserved_[other] &&
+                    states_[other] == WorkerState::ACTIVE) {
+                    return false;
+                }
+            }
+            return true;
+        case WorkerState::PAUSED:
+        default:
+            return false;
+        }
+    }
+
+    // Caller holds mutex_ and at least one queue is non-empty.
+    Job popLocked() {
+        auto& interactive = queues_[static_cast<size_t>(RequestPriority::INTERACTIVE)];
+        auto& batch = queues_[static_cast<size_t>(RequestPriority::BATCH)];
+        const bool takeInteractive =
+            !interactive.empty() && (batch.empty() || interactiveStreak_ < interactiveBurst_);
+        auto& queue = takeInteractive ? interactive : batch;
+        interactiveStreak_ = takeInteractive ? interactiveStreak_ + 1 : 0;
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        return job;
+    }
+
+    void workerLoop(size_t index) {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [this, index]() { return stopping_ || mayTakeLocked(index); });
+                if (stopping_) {
+                    return;
+                }
+                job = popLocked();
+                idle_[index] = false;
+                ++running_;
+            }
+            // Degraded workers wait for the active ones to be busy.
+            changed_.notify_all();
+
+            const auto start = std::chrono::steady_clock::now();
+            job(index);
+            const double serviceMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle_[index] = true;
+                --running_;
+                ++completed_;
+                meanServiceMs_ = (completed_ == 1) ? serviceMs : 0.8 * meanServiceMs_ + 0.2 * serviceMs;
+            }
+            // A worker held back by the running limit may go now.
+            changed_.notify_all();
+        }
+    }
+
+    const size_t maxQueued_;
+    const size_t interactiveBurst_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::array<std::deque<Job>, kRequestPriorityCount> queues_;
+    std::vector<bool> reserved_;
+    std::vector<bool> idle_;
+    std::vector<WorkerState> states_;
+    size_t interactiveStreak_ = 0;
+    size_t running_ = 0;
+    size_t runningLimit_ = 0;
+    uint64_t admitted_ = 0;
+    uint64_t rejected_ = 0;
+    uint64_t completed_ = 0;
+    double meanServiceMs_ = 0.0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace rapid_doc
@@ -8,7 +8,13 @@
 
 #pragma once
 
+#include "common/result_cache.h"
 #include "pipeline/doc_pipeline.h"
+#include "server/concurrency_tuner.h"
+#include "server/device_health.h"
+#include "server/metrics_registry.h"
+#include "server/request_scheduler.h"
+#include <array>
 #include <memory>
 #include <string>
 #include <functional>
@@ -20,7 +26,11 @@
 namespace rapid_doc {
 
 class DocServerTestAccess;
+class DocumentDispatch;
+class ConcurrencyAutotuner;
 class DeviceMetricsSampler;
+class JobStore;
+class JobRunner;
 
 /**
  * @brief HTTP server configuration
@@ -35,6 +45,40 @@ struct ServerConfig {
     std::string routingPolicy = "least_inflight_rr";
     std::string serverId;
     std::vector<int> deviceIds;
+    bool writeJsonArtifacts = false;  // Default for /file_parse write_json_artifacts
+    bool saveVisualization = false;   // Default for /file_parse save_visualization
+    bool saveOriginUploads = true;    // Default for /file_parse save_origin
+    // Split one PDF across idle shards, one shard per this many pages, so
+    // small documents stay on one shard (0 = never split).
+    int fanoutPagesPerShard = 8;
+    // Requests waiting for a free shard before new ones are answered with
+    // 429 (0 = unbounded), and how many image requests may jump ahead of a
+    // waiting PDF in a row.
+    size_t maxQueuedRequests = 64;
+    size_t interactiveBurst = 4;
+    // Reuse results of identical uploads: in-memory LRU tier and an on-disk
+    // tier under uploadDir/result_cache (0 = tier off).
+    size_t resultCacheMemoryBytes = 0;
+    size_t resultCacheDiskBytes = 0;
+    // /file_parse stops starting pages this long after a request arrives and
+    // answers with the pages done so far, flagged partial (0 = no limit).
+    int requestTimeoutSeconds = 0;
+    // Finished /jobs are deleted with their checkpoints this long after they
+    // end (0 = kept until DELETE /jobs/{id}).
+    int jobRetentionSeconds = 7 * 24 * 3600;
+    // Directory a same-host topology LB passes /file_parse bodies through
+    // (see shm_transport.h); "" = bodies only arrive over HTTP.
+    std::string shmDir;
+    // Pin each shard's threads to the CPUs of its device's NUMA node, or to
+    // shardCpuLists[i] (a cpulist such as "0-15,32-47") where given.
+    bool numaPlacement = false;
+    std::vector<std::string> shardCpuLists;
+    // Device temperature/memory limits past which a shard stops taking
+    // documents (see device_health.h); all devices past them means 429.
+    DeviceAdmissionLimits deviceLimits;
+    // Retune running documents, OCR lanes and the layout batch window from
+    // queue wait, p95 latency and NPU busy share (see concurrency_tuner.h).
+    ConcurrencyTunerConfig autotune;
     
     // Pipeline config
     PipelineConfig pipelineConfig;
@@ -46,11 +90,15 @@ struct ServerConfig {
  * 
  * REST API endpoints:
  *   POST /file_parse        - Python RapidDoc-compatible batch parsing API
+ *   POST /jobs              - Queue one document as a checkpointed async job
+ *   GET  /jobs/{id}         - Job status and progress
+ *   GET  /jobs/{id}/result  - Finished pages of a job, from ?from_page= on
  *   POST /v1/images:annotate- Vision API-compatible image annotation
  *   POST /process           - Legacy single-file PDF processing
  *   POST /process/base64    - Legacy base64 PDF processing
  *   GET  /health            - Health check
  *   GET  /status            - Server status and statistics
+ *   GET  /metrics           - Prometheus metrics
  */
 class DocServer {
 public:
@@ -74,25 +122,54 @@ public:
 
 private:
     friend class DocServerTestAccess;
+    friend class DocumentDispatch;
+    friend class JobRunner;
 
     struct PipelineShard {
         std::string shardId;
         int deviceId = -1;
+        int numaNode = -1;                 // of the device, -1 when unknown
+        std::vector<int> cpus;             // threads pinned here (empty = unpinned)
         std::unique_ptr<DocPipeline> pipeline;
-        std::mutex npuSerialMutex;
-        std::mutex requestMutex;
+        std::unique_ptr<NpuScheduler> npuScheduler;
         std::atomic<uint64_t> inflight{0};
         std::atomic<uint64_t> requestCount{0};
         std::atomic<uint64_t> busyUsTotal{0};
         std::atomic<uint64_t> npuBusyUsTotal{0};
         std::atomic<uint64_t> routeQueueUsTotal{0};
+        // This shard's series in metrics_, resolved once so recording never locks.
+        struct Metrics {
+            std::vector<MetricHistogram*> pageTimes;      // same order as kPageTimeMetrics
+            std::vector<MetricCounter*> cacheLookups;     // same order as kCacheLookupMetrics
+            MetricHistogram* requestSeconds = nullptr;
+            MetricHistogram* queueSeconds = nullptr;
+            MetricHistogram* requestPages = nullptr;
+        } metrics;
     };
 
     ServerConfig config_;
+    std::unique_ptr<MetricsRegistry> metrics_;
+    // Declared before shards_ so they outlive every pipeline that borrows them.
+    std::unique_ptr<TaskPool> postprocessPool_;
+    std::unique_ptr<ImageWriter> imageWriter_;
+    std::unique_ptr<RecognitionCache> recognitionCache_;
     std::vector<std::unique_ptr<PipelineShard>> shards_;
+    std::unique_ptr<ResultCache> resultCache_;
+    std::string modelFingerprint_;
+    // Declared after shards_ and resultCache_ so its workers are joined
+    // before anything a running job touches goes away.
+    std::unique_ptr<RequestScheduler> scheduler_;
     std::unique_ptr<DeviceMetricsSampler> deviceMetricsSampler_;
+    std::unique_ptr<ConcurrencyAutotuner> autotuner_;
+    // Async jobs under uploadDir/jobs; the runner submits them to scheduler_.
+    std::unique_ptr<JobStore> jobStore_;
+    std::unique_ptr<JobRunner> jobRunner_;
+    // Secret a request must carry for its --shm-dir body path to be trusted
+    // (see shm_transport.h), and when that directory was last swept.
+    std::string shmSecret_;
+    std::atomic<int64_t> shmSweptAtMs_{0};
     std::atomic<bool> running_{false};
-    std::atomic<uint64_t> routingCursor_{0};
+    double startupMs_ = 0.0;
     
     // Statistics
     std::atomic<uint64_t> requestCount_{0};
@@ -106,15 +183,29 @@ private:
     std::atomic<uint64_t> lockHoldUsTotal_{0};
     std::atomic<uint64_t> lockWaitUsMax_{0};
     std::atomic<uint64_t> lockHoldUsMax_{0};
+    std::array<std::atomic<uint64_t>, kNpuEngineCount> engineLockWaitUsTotal_{};
+    std::array<std::atomic<uint64_t>, kNpuEngineCount> engineLockHoldUsTotal_{};
     std::atomic<uint64_t> npuStageUsTotal_{0};
     std::atomic<uint64_t> cpuStageUsTotal_{0};
 
     // Internal handlers
     void setupRoutes();
     std::string handleProcess(const std::string& pdfData, const std::string& filename);
-    size_t selectShardIndex();
+    /// Shards worth splitting this document across (1 = keep it on one shard)
+    size_t fanoutShardCount(
+        const std::string& bytes,
+        const std::string& filename,
+        int startPageId,
+        int endPageId,
+        const DocPipeline& pipeline) const;
     std::string buildStatusJson();
+    // Creates metrics_ and every shard's series; called once the shards exist.
+    void registerMetrics();
+    // Per-device telemetry gauges, read from deviceMetricsSampler_.
+    void registerDeviceMetrics(const std::vector<int>& deviceIds);
     std::string resolvedTopology() const;
+    /// Drop --shm-dir files nobody took, at most once a minute
+    void sweepShmDir();
     void recordPipelineLockStats(const DocumentResult& result);
 };
 
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file shm_transport.h
+ * @brief Same-host hand-off of LB request and response bodies through files.
+ *
+ * When the topology LB and its backends share a host and a tmpfs directory
+ * (typically /dev/shm), the LB writes the upload once into a file there and
+ * forwards only its path in lb_headers::kShmBody; the backend reads it
+ * without a second pass through loopback TCP and the HTTP parser, and hands
+ * its response back the same way. Both sides accept only files with the
+ * transport's prefix directly inside the directory they were configured
+ * with, and the reader removes a file once it has taken the body.
+ *
+ * A path in a request header is only trusted alongside the directory's
+ * secret (lb_headers::kShmSecret), kept in a file only the user running
+ * the LB and backends can read; a client without it cannot make the
+ * backend read or delete files there. Files nobody took (the response to
+ * an LB that gave up) are removed by sweepStale().
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rapid_doc {
+namespace shm_transport {
+
+constexpr const char* kFilePrefix = "rapiddoc-lb-";
+constexpr const char* kResponseSuffix = ".response";
+constexpr const char* kSecretFile = "rapiddoc-shm.key";     // no kFilePrefix: never a body path
+
+/// A fresh body file in @p dir; @p tag identifies the writer (e.g. its server id)
+inline std::string makeBodyPath(const std::string& dir, const std::string& tag) {
+    static std::atomic<uint64_t> sequence{0};
+    return (std::filesystem::path(dir) /
+            (std::string(kFilePrefix) + tag + "-" + std::to_string(::getpid()) + "-" +
+             std::to_string(sequence.fetch_add(1)) + ".body")).string();
+}
+
+/// Whether @p path names a transport file directly inside @p dir
+inline bool isBodyPath(const std::string& dir, const std::string& path) {
+    if (dir.empty() || path.empty()) {
+        return false;
+    }
+    const std::filesystem::path file = std::filesystem::path(path).lexically_normal();
+    std::error_code ec;
+    const auto parent = std::filesystem::weakly_canonical(file.parent_path(), ec);
+    const auto root = std::filesystem::weakly_canonical(dir, ec);
+    return !ec && parent == root &&
+           file.filename().string().rfind(kFilePrefix, 0) == 0;
+}
+
+inline bool writeBody(const std::string& path, std::string_view data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief The secret shared by everyone using @p dir, created on first use.
+ * Whichever of the LB and backends starts first writes it (mode 0600);
+ * the others read it back.
+ * @return "" if it could be neither created nor read
+ */
+inline std::string loadOrCreateSecret(const std::string& dir) {
+    const std::string path = (std::filesystem::path(dir) / kSecretFile).string();
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        std::random_device random;
+        std::ostringstream hex;
+        for (int i = 0; i < 8; ++i) {
+            hex << std::hex << std::setw(8) << std::setfill('0') << random();
+        }
+        const std::string secret = hex.str();
+        const bool written =
+            ::write(fd, secret.data(), secret.size()) == static_cast<ssize_t>(secret.size());
+        ::close(fd);
+        if (written) {
+            return secret;
+        }
+        ::unlink(path.c_str());
+        return {};
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::string secret;
+    std::getline(in, secret);
+    return secret;
+}
+
+/// Compare secrets without leaking how much of @p given matched
+inline bool secretMatches(const std::string& expected, const std::string& given) {
+    if (expected.empty() || expected.size() != given.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        diff |= static_cast<unsigned char>(expected[i] ^ given[i]);
+    }
+    return diff == 0;
+}
+
+/// Remove transport files in @p dir not modified for @p maxAge; @return how many
+inline size_t sweepStale(const std::string& dir, std::chrono::seconds maxAge) {
+    const auto cutoff = std::filesystem::file_time_type::clock::now() - maxAge;
+    size_t removed = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code fileEc;
+        if (it->path().filename().string().rfind(kFilePrefix, 0) != 0 ||
+            !it->is_regular_file(fileEc) || it->last_write_time(fileEc) >= cutoff || fileEc) {
+            continue;
+        }
+        removed += std::filesystem::remove(it->path(), fileEc) ? 1 : 0;
+    }
+    return removed;
+}
+
+/// Read the body in @p path into @p out with one allocation, then remove the file.
+inline bool takeBody(const std::string& path, std::string& out) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    if (ec || !in) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(size));
+    in.read(out.data(), static_cast<std::streamsize>(size));
+    const bool ok = static_cast<bool>(in);
+    in.close();
+    std::filesystem::remove(path, ec);
+    return ok;
+}
+
+} // namespace shm_transport
+} // namespace rapid_doc
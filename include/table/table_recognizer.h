@@ -14,6 +14,7 @@
  * Pipeline should skip wireless tables or output raw cropped images as fallback.
  */
 
+#include "common/buffer_pool.h"
 #include "common/types.h"
 #include <opencv2/opencv.hpp>
 #include <string>
@@ -41,7 +42,8 @@ public:
     struct NpuStageResult {
         TableType type = TableType::UNKNOWN;
         bool supported = false;
-        cv::Mat mask;
+        cv::Mat hMask;      // Horizontal-line mask, un-padded, at mask resolution
+        cv::Mat vMask;      // Vertical-line mask, un-padded, at mask resolution
         float scale = 1.0f;
         int padTop = 0;
         int padLeft = 0;
@@ -80,6 +82,16 @@ public:
      */
     NpuStageResult recognizeNpuStage(const cv::Mat& tableImage);
 
+    /**
+     * @brief recognizeNpuStage() for several tables, keeping the NPU busy.
+     *
+     * Table k+1 is preprocessed while table k runs on the NPU (RunAsync), with
+     * input buffers taken from a small reusable pool.
+     * @param tableImages Cropped table regions (BGR)
+     * @return One result per input, in input order
+     */
+    std::vector<NpuStageResult> recognizeNpuStageBatch(const std::vector<cv::Mat>& tableImages);
+
     /**
      * @brief Finish table recognition by running CPU postprocess on NPU artifacts.
      * @param tableImage Original cropped table image (BGR)
@@ -100,19 +112,44 @@ public:
      */
     static TableType estimateTableType(const cv::Mat& tableImage);
 
+    /**
+     * @brief estimateTableType() on a downscaled copy of a crop
+     * @param level The crop resized to any scale (BGR or grayscale)
+     * @param fullSize Size of the original crop the decision refers to
+     *
+     * Works on an edge map of at most 512 px per side and stops as soon as
+     * the line-pixel budget is met or cannot be met.
+     */
+    static TableType estimateTableType(const cv::Mat& level, const cv::Size& fullSize);
+
     bool isInitialized() const { return initialized_; }
 
+    /// Reuse counters of the model input and line-mask buffers
+    BufferPool::Stats inputPoolStats() const;
+    BufferPool::Stats maskPoolStats() const;
+
     /**
      * @brief Generate HTML from recognized cells (public for re-generation after OCR fill)
      */
     std::string generateHtml(const std::vector<TableCell>& cells);
 
 private:
-    cv::Mat preprocess(const cv::Mat& image);
+    friend class TableRecognizerTestAccess;
+
+    /// Size of @p image scaled so its longer side is inputSize
+    cv::Size modelResizeSize(const cv::Mat& image) const;
+    /**
+     * Letterbox into @p out (inputSize x inputSize RGB, reused when already allocated).
+     * @p image is resized to @p newSize unless it is already at model scale.
+     */
+    void preprocess(const cv::Mat& image, const cv::Size& newSize, cv::Mat& out);
+    /// Estimate/preprocess phase; false if the table does not go to the NPU
+    bool prepareNpuStage(const cv::Mat& tableImage, NpuStageResult& npuStage, cv::Mat& input);
 
     // Line extraction (aligned with Python get_table_line + adjust/extend)
     struct LineSeg { float x1, y1, x2, y2; };
-    std::vector<LineSeg> getTableLine(const cv::Mat& binImg, int axis, int lineW);
+    std::vector<LineSeg> getTableLine(
+        const cv::Mat& binImg, int axis, int lineW, const cv::Size& outSize);
     std::vector<LineSeg> adjustLines(const std::vector<LineSeg>& lines, float alph, float angle);
     void finalAdjustLines(std::vector<LineSeg>& rowboxes, std::vector<LineSeg>& colboxes);
     static LineSeg lineToLine(LineSeg pts1, const LineSeg& pts2, float alpha, float angle);
@@ -128,10 +165,10 @@ private:
         std::vector<LogicPoint>& logicPoints,
         float rowThresh = 10.0f, float colThresh = 15.0f);
 
-    // Full postprocess (dxengine path)
+    // Full postprocess (dxengine path); line masks come from recognizeNpuStage()
     std::vector<TableCell> postprocessDxEngine(
-        const cv::Mat& img, const cv::Mat& pred,
-        float scale, int padTop, int padLeft, int origH, int origW);
+        const cv::Mat& img, const cv::Mat& hpred, const cv::Mat& vpred,
+        int origH, int origW);
 
     struct Impl;
     TableRecognizerConfig config_;
@@ -27,6 +27,19 @@ PipelineConfig PipelineConfig::Default(const std::string& projectRoot) {
 }
 
 std::string PipelineConfig::validate() const {
+    if (!runtime.recordDir.empty() && !runtime.replayDir.empty())
+        return "Record and replay directories are mutually exclusive";
+    if (runtime.replayLatencyScale < 0.0)
+        return "Replay latency scale must be non-negative";
+    if (runtime.layoutDpi < 0)
+        return "Layout DPI must be non-negative";
+    if (!runtime.replayDir.empty()) {
+        // Replay answers every engine from the recording; no model is loaded.
+        if (!fs::is_directory(runtime.replayDir))
+            return "Replay directory not found: " + runtime.replayDir;
+        return "";
+    }
+
     // Layout model check
     if (stages.enableLayout) {
         if (!fs::exists(models.layoutDxnnModel))
@@ -73,11 +86,48 @@ void PipelineConfig::show() const {
     LOG_INFO("  OCR model dir:    {}", models.ocrModelDir);
     LOG_INFO("Runtime:");
     LOG_INFO("  PDF DPI:          {}", runtime.pdfDpi);
+    LOG_INFO("  Layout DPI:       {}", runtime.layoutDpi > 0 && runtime.layoutDpi < runtime.pdfDpi
+             ? std::to_string(runtime.layoutDpi) + " (regions at PDF DPI)" : std::string("PDF DPI"));
+    LOG_INFO("  PDF text layer:   {}", runtime.useTextLayer ? "ON (OCR fallback)" : "OFF");
     LOG_INFO("  Max pages:        {}", runtime.maxPages);
     LOG_INFO("  Start page:       {}", runtime.startPageId);
     LOG_INFO("  End page:         {}", runtime.endPageId);
     LOG_INFO("  Device ID:        {}", runtime.deviceId);
+    LOG_INFO("  Pipeline depth:   {} ({} post-process workers)",
+             runtime.pipelineQueueDepth, runtime.postprocessStageThreads);
+    LOG_INFO("  Render lookahead: {}", runtime.renderLookaheadPages);
+    LOG_INFO("  Layout batch:     {} (max delay {} ms)",
+             runtime.layoutBatchSize, runtime.layoutBatchMaxDelayMs);
+    LOG_INFO("  Layout resize:    {}", runtime.layoutFastResize ? "box filter (fast)" : "INTER_CUBIC");
+    if (runtime.blankPageInkRatio > 0.0) {
+        LOG_INFO("  Blank page skip:  ink <= {}", runtime.blankPageInkRatio);
+    }
+    LOG_INFO("  Layout ORT:       intra={} inter={} opt={} global_pool={}",
+             runtime.layoutOrtIntraOpThreads, runtime.layoutOrtInterOpThreads,
+             runtime.layoutOrtOptLevel, runtime.layoutOrtGlobalThreadPool ? "ON" : "OFF");
+    if (!runtime.layoutOrtOptimizedModelPath.empty()) {
+        LOG_INFO("  Layout ORT cache: {}", runtime.layoutOrtOptimizedModelPath);
+    }
+    LOG_INFO("  NPU concurrency:  layout={} ocr={} table={}",
+             runtime.npuLayoutConcurrency, runtime.npuOcrConcurrency,
+             runtime.npuTableConcurrency);
+    LOG_INFO("  Postprocess pool: {}", runtime.postprocessThreads);
     LOG_INFO("  Output dir:       {}", runtime.outputDir);
+    LOG_INFO("  Image output:     {} (quality {}, {} writers, {} MB encoded cache)",
+             runtime.imageFormat, runtime.imageQuality, runtime.imageWriteThreads,
+             runtime.imageCacheMb);
+    LOG_INFO("  Recognition memo: {}", runtime.recognitionCacheMb > 0
+             ? std::to_string(runtime.recognitionCacheMb) + " MB" : std::string("OFF"));
+    LOG_INFO("  Page buffer pool: {}", runtime.pageBufferPoolMb > 0
+             ? std::to_string(runtime.pageBufferPoolMb) + " MB" : std::string("OFF"));
+    LOG_INFO("  Model init:       {}{}", runtime.parallelModelInit ? "parallel" : "serial",
+             runtime.warmupOnInit ? " + warmup" : "");
+    if (!runtime.recordDir.empty()) {
+        LOG_INFO("  Record to:        {}", runtime.recordDir);
+    }
+    if (!runtime.replayDir.empty()) {
+        LOG_INFO("  Replay from:      {} (latency x{})", runtime.replayDir, runtime.replayLatencyScale);
+    }
     LOG_INFO("========================================");
 }
 
@@ -20,6 +20,8 @@ double percentileFromSorted(const std::vector<double>& values, double percentile
     return values[lower] + (values[upper] - values[lower]) * weight;
 }
 
+} // namespace
+
 void accumulatePageStats(PageStageStats& target, const PageStageStats& source) {
     target.layoutTimeMs += source.layoutTimeMs;
     target.ocrTimeMs += source.ocrTimeMs;
@@ -30,12 +32,24 @@ void accumulatePageStats(PageStageStats& target, const PageStageStats& source) {
     target.readingOrderTimeMs += source.readingOrderTimeMs;
     target.npuSerialTimeMs += source.npuSerialTimeMs;
     target.cpuOnlyTimeMs += source.cpuOnlyTimeMs;
+    target.npuStageCpuTimeMs += source.npuStageCpuTimeMs;
+    target.postprocessCpuTimeMs += source.postprocessCpuTimeMs;
     target.npuLockWaitTimeMs += source.npuLockWaitTimeMs;
     target.npuLockHoldTimeMs += source.npuLockHoldTimeMs;
+    target.layoutNpuWaitTimeMs += source.layoutNpuWaitTimeMs;
+    target.layoutNpuHoldTimeMs += source.layoutNpuHoldTimeMs;
+    target.ocrNpuWaitTimeMs += source.ocrNpuWaitTimeMs;
+    target.ocrNpuHoldTimeMs += source.ocrNpuHoldTimeMs;
+    target.tableNpuWaitTimeMs += source.tableNpuWaitTimeMs;
+    target.tableNpuHoldTimeMs += source.tableNpuHoldTimeMs;
+    target.layoutCacheHits += source.layoutCacheHits;
+    target.layoutCacheMisses += source.layoutCacheMisses;
+    target.ocrCacheHits += source.ocrCacheHits;
+    target.ocrCacheMisses += source.ocrCacheMisses;
+    target.textLayerRegions += source.textLayerRegions;
+    target.blankPages += source.blankPages;
 }
 
-} // namespace
-
 PercentileSummary summarizeSamples(std::vector<double> samples) {
     PercentileSummary summary;
     summary.sampleCount = samples.size();
@@ -50,6 +64,7 @@ PercentileSummary summarizeSamples(std::vector<double> samples) {
                      static_cast<double>(samples.size());
     summary.p50Ms = percentileFromSorted(samples, 50.0);
     summary.p95Ms = percentileFromSorted(samples, 95.0);
+    summary.p99Ms = percentileFromSorted(samples, 99.0);
     return summary;
 }
 
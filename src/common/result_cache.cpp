@@ -0,0 +1,280 @@
+#include "common/result_cache.h"
+#include "common/content_hash.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace rapid_doc {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* kMetaFile = "meta";
+constexpr const char* kFilesDir = "files";
+
+bool readFile(const fs::path& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+bool writeFile(const fs::path& path, const std::string& data) {
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+std::shared_ptr<const CachedParse> readEntry(const fs::path& dir) {
+    auto parse = std::make_shared<CachedParse>();
+    if (!readFile(dir / kMetaFile, parse->meta)) {
+        return nullptr;
+    }
+    const fs::path filesDir = dir / kFilesDir;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(filesDir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        CachedFile file;
+        file.path = fs::relative(it->path(), filesDir).generic_string();
+        if (!readFile(it->path(), file.data)) {
+            return nullptr;
+        }
+        parse->files.push_back(std::move(file));
+    }
+    if (ec) {
+        return nullptr;
+    }
+    std::sort(parse->files.begin(), parse->files.end(),
+              [](const CachedFile& x, const CachedFile& y) { return x.path < y.path; });
+    return parse;
+}
+
+// Bytes an entry takes on disk, matching what loadDiskIndex() counts.
+size_t diskSize(const CachedParse& parse) {
+    size_t bytes = parse.meta.size();
+    for (const auto& file : parse.files) {
+        bytes += file.data.size();
+    }
+    return bytes;
+}
+
+// Written under a temporary name and renamed, so readers never see half an entry.
+bool writeEntry(const fs::path& diskDir, const std::string& key, const CachedParse& parse) {
+    std::ostringstream tmpName;
+    tmpName << ".tmp-" << key << "-" << std::hash<std::thread::id>{}(std::this_thread::get_id())
+            << "-" << std::chrono::steady_clock::now().time_since_epoch().count();
+    const fs::path tmpDir = diskDir / tmpName.str();
+    std::error_code ec;
+    fs::remove_all(tmpDir, ec);
+
+    bool ok = writeFile(tmpDir / kMetaFile, parse.meta);
+    for (const auto& file : parse.files) {
+        ok = ok && writeFile(tmpDir / kFilesDir / fs::path(file.path), file.data);
+    }
+    if (ok) {
+        const fs::path target = diskDir / key;
+        fs::remove_all(target, ec);
+        fs::rename(tmpDir, target, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        fs::remove_all(tmpDir, ec);
+    }
+    return ok;
+}
+
+} // namespace
+
+size_t CachedParse::byteSize() const {
+    size_t bytes = meta.size();
+    for (const auto& file : files) {
+        bytes += file.path.size() + file.data.size();
+    }
+    return bytes;
+}
+
+ResultCache::ResultCache(size_t memoryBudgetBytes, const std::string& diskDir, size_t diskBudgetBytes)
+    : memoryBudget_(memoryBudgetBytes)
+    , diskBudget_(diskDir.empty() ? 0 : diskBudgetBytes)
+    , diskDir_(diskDir)
+{
+    if (diskBudget_ > 0) {
+        loadDiskIndex();
+    }
+}
+
+std::string ResultCache::makeKey(const std::string& bytes, const std::string& salt) {
+    ContentHasher hasher;
+    hasher.update(bytes);
+    hasher.update(salt);
+    return hasher.digest().hex();
+}
+
+std::shared_ptr<const CachedParse> ResultCache::lookup(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            ++counters_.memoryHits;
+            return it->second->second;
+        }
+        const auto diskIt = diskIndex_.find(key);
+        if (diskIt == diskIndex_.end()) {
+            ++counters_.misses;
+            return nullptr;
+        }
+        diskIt->second.lastUse = ++useTick_;
+    }
+
+    // Read outside the lock; an entry evicted meanwhile reads as a miss.
+    std::shared_ptr<const CachedParse> parse = readEntry(fs::path(diskDir_) / key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!parse) {
+        ++counters_.misses;
+        return nullptr;
+    }
+    ++counters_.diskHits;
+    insertMemoryLocked(key, parse);
+    return parse;
+}
+
+void ResultCache::store(const std::string& key, std::shared_ptr<const CachedParse> parse) {
+    if (!parse) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++counters_.stores;
+        insertMemoryLocked(key, parse);
+    }
+
+    const size_t bytes = diskSize(*parse);
+    if (diskBudget_ == 0 || bytes > diskBudget_) {
+        return;
+    }
+    if (!writeEntry(diskDir_, key, *parse)) {
+        LOG_WARN("Result cache: failed to write entry {}", key);
+        return;
+    }
+
+    std::vector<std::string> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = diskIndex_[key];
+        diskBytes_ = diskBytes_ - entry.bytes + bytes;
+        entry.bytes = bytes;
+        entry.lastUse = ++useTick_;
+        victims = evictDiskLocked();
+    }
+    std::error_code ec;
+    for (const auto& victim : victims) {
+        fs::remove_all(fs::path(diskDir_) / victim, ec);
+    }
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = counters_;
+    stats.memoryEntries = memoryIndex_.size();
+    stats.memoryBytes = memoryBytes_;
+    stats.diskEntries = diskIndex_.size();
+    stats.diskBytes = diskBytes_;
+    return stats;
+}
+
+void ResultCache::insertMemoryLocked(const std::string& key, std::shared_ptr<const CachedParse> parse) {
+    const size_t bytes = parse->byteSize();
+    const auto existing = memoryIndex_.find(key);
+    if (existing != memoryIndex_.end()) {
+        memoryBytes_ -= existing->second->second->byteSize();
+        lru_.erase(existing->second);
+        memoryIndex_.erase(existing);
+    }
+    if (bytes > memoryBudget_) {
+        return;
+    }
+    lru_.emplace_front(key, std::move(parse));
+    memoryIndex_[key] = lru_.begin();
+    memoryBytes_ += bytes;
+    while (memoryBytes_ > memoryBudget_) {
+        auto& victim = lru_.back();
+        memoryBytes_ -= victim.second->byteSize();
+        memoryIndex_.erase(victim.first);
+        lru_.pop_back();
+        ++counters_.evictions;
+    }
+}
+
+std::vector<std::string> ResultCache::evictDiskLocked() {
+    std::vector<std::string> victims;
+    while (diskBytes_ > diskBudget_ && !diskIndex_.empty()) {
+        auto oldest = std::min_element(
+            diskIndex_.begin(), diskIndex_.end(),
+            [](const auto& x, const auto& y) { return x.second.lastUse < y.second.lastUse; });
+        diskBytes_ -= oldest->second.bytes;
+        victims.push_back(oldest->first);
+        diskIndex_.erase(oldest);
+        ++counters_.evictions;
+    }
+    return victims;
+}
+
+void ResultCache::loadDiskIndex() {
+    std::error_code ec;
+    fs::create_directories(diskDir_, ec);
+
+    // Oldest entries get the lowest ticks, so they are evicted first.
+    std::vector<std::pair<fs::file_time_type, std::pair<std::string, size_t>>> found;
+    for (fs::directory_iterator it(diskDir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (!it->is_directory()) {
+            continue;
+        }
+        if (name.rfind(".tmp-", 0) == 0) {
+            std::error_code removeEc;
+            fs::remove_all(it->path(), removeEc);
+            continue;
+        }
+        size_t bytes = 0;
+        std::error_code walkEc;
+        for (fs::recursive_directory_iterator file(it->path(), walkEc), fileEnd;
+             !walkEc && file != fileEnd; file.increment(walkEc)) {
+            if (file->is_regular_file()) {
+                bytes += static_cast<size_t>(file->file_size());
+            }
+        }
+        found.push_back({fs::last_write_time(it->path(), walkEc), {name, bytes}});
+    }
+    std::sort(found.begin(), found.end(),
+              [](const auto& x, const auto& y) { return x.first < y.first; });
+    for (const auto& item : found) {
+        diskIndex_[item.second.first] = DiskEntry{item.second.second, ++useTick_};
+        diskBytes_ += item.second.second;
+    }
+    for (const auto& victim : evictDiskLocked()) {
+        fs::remove_all(fs::path(diskDir_) / victim, ec);
+    }
+    if (!diskIndex_.empty()) {
+        LOG_INFO("Result cache: {} entries ({} bytes) on disk in {}",
+                 diskIndex_.size(), diskBytes_, diskDir_);
+    }
+}
+
+} // namespace rapid_doc
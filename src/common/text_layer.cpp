@@ -0,0 +1,167 @@
+#include "common/text_layer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace rapid_doc {
+
+namespace {
+
+float centreX(const TextSpan& span) { return 0.5f * (span.x0 + span.x1); }
+float centreY(const TextSpan& span) { return 0.5f * (span.y0 + span.y1); }
+
+// A gap wider than this share of the word height is a space.
+constexpr float kSpaceGapRatio = 0.15f;
+
+} // namespace
+
+TextLayerIndex::TextLayerIndex(const std::vector<TextSpan>& spans) {
+    spans_.reserve(spans.size());
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+    for (const auto& span : spans) {
+        if (span.text.empty() || span.x1 <= span.x0 || span.y1 <= span.y0) {
+            continue;
+        }
+        const float cx = centreX(span);
+        const float cy = centreY(span);
+        minX = spans_.empty() ? cx : std::min(minX, cx);
+        minY = spans_.empty() ? cy : std::min(minY, cy);
+        maxX = spans_.empty() ? cx : std::max(maxX, cx);
+        maxY = spans_.empty() ? cy : std::max(maxY, cy);
+        spans_.push_back(&span);
+    }
+    if (spans_.empty()) {
+        return;
+    }
+
+    const int side = std::clamp(
+        static_cast<int>(std::ceil(std::sqrt(static_cast<double>(spans_.size())))), 1, 64);
+    originX_ = minX;
+    originY_ = minY;
+    cols_ = side;
+    rows_ = side;
+    binW_ = std::max(1.0f, (maxX - minX) / side);
+    binH_ = std::max(1.0f, (maxY - minY) / side);
+    bins_.resize(static_cast<size_t>(cols_ * rows_));
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        const int bx = std::clamp(static_cast<int>((centreX(*spans_[i]) - originX_) / binW_), 0, cols_ - 1);
+        const int by = std::clamp(static_cast<int>((centreY(*spans_[i]) - originY_) / binH_), 0, rows_ - 1);
+        bins_[static_cast<size_t>(by * cols_ + bx)].push_back(static_cast<int>(i));
+    }
+}
+
+bool TextLayerIndex::textIn(const LayoutBox& box, std::string& text) const {
+    text.clear();
+    if (spans_.empty() || box.x1 <= box.x0 || box.y1 <= box.y0) {
+        return false;
+    }
+
+    const int bx0 = std::clamp(static_cast<int>(std::floor((box.x0 - originX_) / binW_)), 0, cols_ - 1);
+    const int by0 = std::clamp(static_cast<int>(std::floor((box.y0 - originY_) / binH_)), 0, rows_ - 1);
+    const int bx1 = std::clamp(static_cast<int>(std::floor((box.x1 - originX_) / binW_)), 0, cols_ - 1);
+    const int by1 = std::clamp(static_cast<int>(std::floor((box.y1 - originY_) / binH_)), 0, rows_ - 1);
+    std::vector<const TextSpan*> words;
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            for (int i : bins_[static_cast<size_t>(by * cols_ + bx)]) {
+                const TextSpan* span = spans_[static_cast<size_t>(i)];
+                const float cx = centreX(*span);
+                const float cy = centreY(*span);
+                if (cx >= box.x0 && cx < box.x1 && cy >= box.y0 && cy < box.y1) {
+                    words.push_back(span);
+                }
+            }
+        }
+    }
+    if (words.empty()) {
+        return false;
+    }
+
+    // Lines: a word whose centre is above the current line's bottom edge
+    // joins it; otherwise it starts the next line.
+    std::sort(words.begin(), words.end(), [](const TextSpan* a, const TextSpan* b) {
+        return centreY(*a) < centreY(*b);
+    });
+    std::vector<std::vector<const TextSpan*>> lines;
+    float lineY1 = 0.0f;
+    for (const TextSpan* word : words) {
+        const float cy = centreY(*word);
+        if (lines.empty() || cy > lineY1) {
+            lines.emplace_back();
+            lineY1 = word->y1;
+        } else {
+            lineY1 = std::max(lineY1, word->y1);
+        }
+        lines.back().push_back(word);
+    }
+
+    for (auto& line : lines) {
+        std::sort(line.begin(), line.end(), [](const TextSpan* a, const TextSpan* b) {
+            return a->x0 < b->x0;
+        });
+        if (!text.empty()) {
+            text += '\n';
+        }
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (i > 0) {
+                const TextSpan& prev = *line[i - 1];
+                const float height = std::min(prev.y1 - prev.y0, line[i]->y1 - line[i]->y0);
+                if (line[i]->x0 - prev.x1 > kSpaceGapRatio * height) {
+                    text += ' ';
+                }
+            }
+            text += line[i]->text;
+        }
+    }
+    return isUsableText(text);
+}
+
+bool isUsableText(const std::string& text) {
+    size_t codePoints = 0;
+    size_t bad = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        size_t length = 0;
+        uint32_t cp = 0;
+        if (lead < 0x80) {
+            length = 1;
+            cp = lead;
+        } else if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            cp = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            cp = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            cp = lead & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > text.size()) {
+            return false;
+        }
+        for (size_t k = 1; k < length; ++k) {
+            const unsigned char next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80) {
+                return false;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        i += length;
+
+        if (cp == ' ' || cp == '\n' || cp == '\t') {
+            continue;
+        }
+        ++codePoints;
+        if (cp == 0xFFFD || cp < 0x20 || cp == 0x7F ||
+            (cp >= 0xE000 && cp <= 0xF8FF) || cp >= 0xF0000) {
+            ++bad;
+        }
+    }
+    return codePoints > 0 && bad * 10 <= codePoints;
+}
+
+} // namespace rapid_doc
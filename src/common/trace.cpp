@@ -0,0 +1,169 @@
+#include "common/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace rapid_doc {
+
+namespace {
+
+// Spans of one thread. Only that thread writes; the lock is uncontended
+// except while an export copies the buffer out.
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t next = 0;   // slot the next event overwrites once the ring is full
+    uint32_t threadId = 0;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;   // outlive their threads
+    // Buffers of exited threads, handed to the next new thread so per-page
+    // stage threads do not add a buffer each.
+    std::vector<std::shared_ptr<ThreadBuffer>> idle;
+    std::atomic<size_t> eventsPerThread{Tracer::kDefaultEventsPerThread};
+    uint32_t nextThreadId = 1;
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+// A thread's claim on a buffer, returned to the idle list when it exits.
+struct BufferLease {
+    BufferLease() {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (!reg.idle.empty()) {
+            buffer = std::move(reg.idle.back());
+            reg.idle.pop_back();
+            return;
+        }
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadId = reg.nextThreadId++;
+        reg.buffers.push_back(buffer);
+    }
+
+    ~BufferLease() {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.idle.push_back(std::move(buffer));
+    }
+
+    std::shared_ptr<ThreadBuffer> buffer;
+};
+
+ThreadBuffer& threadBuffer() {
+    thread_local BufferLease lease;
+    return *lease.buffer;
+}
+
+void appendJsonString(std::ostringstream& out, const char* text) {
+    out << '"';
+    for (const char* p = text; *p != '\0'; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void Tracer::enable(size_t eventsPerThread) {
+    registry().eventsPerThread.store(std::max<size_t>(1, eventsPerThread));
+    clear();
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable() {
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::clear() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        std::vector<TraceEvent>().swap(buffer->events);   // re-sized on the next record
+        buffer->next = 0;
+    }
+}
+
+void Tracer::record(
+    const char* name, const char* category, const char* detail,
+    int64_t startUs, int64_t durationUs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    TraceEvent event{name, category, detail != nullptr ? detail : "",
+                     startUs, durationUs, buffer.threadId};
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.capacity() == 0) {
+        buffer.events.reserve(registry().eventsPerThread.load());
+    }
+    if (buffer.events.size() < buffer.events.capacity()) {
+        buffer.events.push_back(std::move(event));
+    } else {
+        buffer.events[buffer.next] = std::move(event);
+        buffer.next = (buffer.next + 1) % buffer.events.size();
+    }
+}
+
+std::string Tracer::chromeTraceJson() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffers = reg.buffers;
+    }
+
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        std::vector<TraceEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            // Oldest first: once the ring has wrapped, that is the slot at next.
+            events.reserve(buffer->events.size());
+            events.insert(events.end(), buffer->events.begin() + buffer->next, buffer->events.end());
+            events.insert(events.end(), buffer->events.begin(), buffer->events.begin() + buffer->next);
+        }
+        for (const auto& event : events) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            appendJsonString(out, event.name);
+            out << ",\"cat\":";
+            appendJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+                << ",\"pid\":1,\"tid\":" << event.threadId;
+            if (!event.detail.empty()) {
+                out << ",\"args\":{\"detail\":";
+                appendJsonString(out, event.detail.c_str());
+                out << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool Tracer::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << chromeTraceJson();
+    return static_cast<bool>(out);
+}
+
+} // namespace rapid_doc
@@ -1,5 +1,7 @@
 #include "common/types.h"
 #include <algorithm>
+#include <mutex>
+#include <set>
 
 namespace rapid_doc {
 
@@ -40,6 +42,68 @@ bool isCategorySupported(LayoutCategory cat) {
     }
 }
 
+LayoutBucket layoutBucket(LayoutCategory cat) {
+    switch (cat) {
+        case LayoutCategory::TABLE:
+            return LayoutBucket::TABLE;
+        case LayoutCategory::FIGURE:
+            return LayoutBucket::FIGURE;
+        case LayoutCategory::EQUATION:
+        case LayoutCategory::INTERLINE_EQUATION:
+            return LayoutBucket::EQUATION;
+        case LayoutCategory::TEXT:
+        case LayoutCategory::TITLE:
+        case LayoutCategory::CONTENT:
+        case LayoutCategory::LIST:
+        case LayoutCategory::CODE:
+        case LayoutCategory::ABSTRACT:
+        case LayoutCategory::REFERENCE:
+        case LayoutCategory::INDEX:
+        case LayoutCategory::HEADER:
+        case LayoutCategory::FOOTER:
+        case LayoutCategory::TABLE_CAPTION:
+        case LayoutCategory::TABLE_FOOTNOTE:
+        case LayoutCategory::FIGURE_CAPTION:
+        case LayoutCategory::STAMP:
+            return LayoutBucket::TEXT;
+        default:
+            return LayoutBucket::UNSUPPORTED;
+    }
+}
+
+std::string_view internLayoutLabel(std::string_view label) {
+    // Nodes of a std::set never move, so views into them stay valid.
+    static std::mutex mutex;
+    static std::set<std::string, std::less<>> labels;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = labels.find(label);
+    if (it == labels.end()) {
+        it = labels.emplace(label).first;
+    }
+    return *it;
+}
+
+LayoutBuckets LayoutResult::classify() const {
+    LayoutBuckets buckets;
+    std::vector<uint8_t> bucketOf(boxes.size());
+    std::array<uint32_t, kLayoutBucketCount> counts{};
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        bucketOf[i] = static_cast<uint8_t>(layoutBucket(boxes[i].category));
+        ++counts[bucketOf[i]];
+    }
+    for (size_t b = 0; b < kLayoutBucketCount; ++b) {
+        buckets.offsets[b + 1] = buckets.offsets[b] + counts[b];
+    }
+    // Counting sort: each bucket keeps detection order.
+    std::array<uint32_t, kLayoutBucketCount> next{};
+    std::copy(buckets.offsets.begin(), buckets.offsets.end() - 1, next.begin());
+    buckets.order.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        buckets.order[next[bucketOf[i]]++] = static_cast<uint32_t>(i);
+    }
+    return buckets;
+}
+
 std::vector<LayoutBox> LayoutResult::getBoxesByCategory(LayoutCategory cat) const {
     std::vector<LayoutBox> result;
     std::copy_if(boxes.begin(), boxes.end(), std::back_inserter(result),
@@ -50,22 +114,7 @@ std::vector<LayoutBox> LayoutResult::getBoxesByCategory(LayoutCategory cat) cons
 std::vector<LayoutBox> LayoutResult::getTextBoxes() const {
     std::vector<LayoutBox> result;
     std::copy_if(boxes.begin(), boxes.end(), std::back_inserter(result),
-        [](const LayoutBox& b) {
-            return b.category == LayoutCategory::TEXT ||
-                   b.category == LayoutCategory::TITLE ||
-                   b.category == LayoutCategory::CONTENT ||
-                   b.category == LayoutCategory::LIST ||
-                   b.category == LayoutCategory::CODE ||
-                   b.category == LayoutCategory::ABSTRACT ||
-                   b.category == LayoutCategory::REFERENCE ||
-                   b.category == LayoutCategory::INDEX ||
-                   b.category == LayoutCategory::HEADER ||
-                   b.category == LayoutCategory::FOOTER ||
-                   b.category == LayoutCategory::TABLE_CAPTION ||
-                   b.category == LayoutCategory::TABLE_FOOTNOTE ||
-                   b.category == LayoutCategory::FIGURE_CAPTION ||
-                   b.category == LayoutCategory::STAMP;
-        });
+        [](const LayoutBox& b) { return layoutBucket(b.category) == LayoutBucket::TEXT; });
     return result;
 }
 
@@ -76,10 +125,7 @@ std::vector<LayoutBox> LayoutResult::getTableBoxes() const {
 std::vector<LayoutBox> LayoutResult::getEquationBoxes() const {
     std::vector<LayoutBox> result;
     std::copy_if(boxes.begin(), boxes.end(), std::back_inserter(result),
-        [](const LayoutBox& b) {
-            return b.category == LayoutCategory::EQUATION ||
-                   b.category == LayoutCategory::INTERLINE_EQUATION;
-        });
+        [](const LayoutBox& b) { return layoutBucket(b.category) == LayoutBucket::EQUATION; });
     return result;
 }
 
@@ -9,7 +9,10 @@
  */
 
 #include "layout/layout_detector.h"
+#include "layout/layout_nms.h"
+#include "layout/layout_resize.h"
 #include "common/logger.h"
+#include "common/trace.h"
 
 #include <dxrt/inference_engine.h>
 
@@ -18,12 +21,22 @@
 #endif
 
 #include <algorithm>
+#include <array>
 #include <numeric>
+#include <string_view>
 #include <cmath>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 namespace rapid_doc {
 
+namespace fs = std::filesystem;
+
 // ---------------------------------------------------------------------------
 // DXEngine label list (matches Python PPDocLayoutModelHandler for DXENGINE)
 // ---------------------------------------------------------------------------
@@ -63,7 +76,7 @@ static const std::unordered_map<int, float> kPerCategoryConfThres = {
 };
 
 // Map DXEngine label string -> LayoutCategory enum
-static LayoutCategory labelToCategory(const std::string& label) {
+static LayoutCategory labelToCategory(std::string_view label) {
     if (label == "text" || label == "content" || label == "reference" ||
         label == "footnote" || label == "number" || label == "abstract" ||
         label == "aside_text")
@@ -91,75 +104,124 @@ static LayoutCategory labelToCategory(const std::string& label) {
     return LayoutCategory::UNKNOWN;
 }
 
+#ifdef HAS_ONNXRUNTIME
 // ---------------------------------------------------------------------------
-// IoU helpers (matches Python post_process.py iou())
+// ONNX Runtime environment — one per process, shared by every detector (and
+// so by every pipeline shard). With global thread pools the sessions use the
+// env's pools instead of creating their own.
 // ---------------------------------------------------------------------------
-static float computeIoU(const float* a, const float* b) {
-    float x1 = std::max(a[0], b[0]);
-    float y1 = std::max(a[1], b[1]);
-    float x2 = std::min(a[2], b[2]);
-    float y2 = std::min(a[3], b[3]);
-    float interArea = std::max(0.0f, x2 - x1 + 1) * std::max(0.0f, y2 - y1 + 1);
-    float area1 = (a[2] - a[0] + 1) * (a[3] - a[1] + 1);
-    float area2 = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
-    return interArea / (area1 + area2 - interArea);
-}
+struct SharedOrtEnv {
+    std::unique_ptr<Ort::Env> env;
+    bool globalPools = false;
+};
 
-// NMS with different IoU thresholds for same/different class (Python nms())
-static std::vector<int> nms(const std::vector<std::vector<float>>& boxes,
-                            float iouSame = 0.6f, float iouDiff = 0.98f) {
-    std::vector<int> indices(boxes.size());
-    std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
-        return boxes[a][1] > boxes[b][1];
+static SharedOrtEnv& sharedOrtEnv(const LayoutDetectorConfig& config) {
+    static std::once_flag once;
+    static SharedOrtEnv shared;
+    std::call_once(once, [&config]() {
+        shared.globalPools = config.ortGlobalThreadPool;
+        if (shared.globalPools) {
+            Ort::ThreadingOptions threading;
+            threading.SetGlobalIntraOpNumThreads(std::max(1, config.ortIntraOpThreads));
+            threading.SetGlobalInterOpNumThreads(std::max(1, config.ortInterOpThreads));
+            shared.env = std::make_unique<Ort::Env>(
+                threading, ORT_LOGGING_LEVEL_WARNING, "layout_nms");
+        } else {
+            shared.env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "layout_nms");
+        }
     });
+    if (config.ortGlobalThreadPool != shared.globalPools) {
+        LOG_WARN("ORT env already created with global_pool={}; ignoring global_pool={}",
+                 shared.globalPools ? "ON" : "OFF", config.ortGlobalThreadPool ? "ON" : "OFF");
+    }
+    return shared;
+}
 
-    std::vector<int> selected;
-    while (!indices.empty()) {
-        int current = indices.front();
-        selected.push_back(current);
-        const auto& curBox = boxes[current];
-        float curClass = curBox[0];
-        const float* curCoords = curBox.data() + 2;
-
-        std::vector<int> remaining;
-        for (size_t i = 1; i < indices.size(); ++i) {
-            int idx = indices[i];
-            const auto& box = boxes[idx];
-            float threshold = (box[0] == curClass) ? iouSame : iouDiff;
-            if (computeIoU(curCoords, box.data() + 2) < threshold) {
-                remaining.push_back(idx);
-            }
-        }
-        indices = std::move(remaining);
+static GraphOptimizationLevel parseOptimizationLevel(const std::string& level) {
+    if (level == "disable") return GraphOptimizationLevel::ORT_DISABLE_ALL;
+    if (level == "basic") return GraphOptimizationLevel::ORT_ENABLE_BASIC;
+    if (level == "extended") return GraphOptimizationLevel::ORT_ENABLE_EXTENDED;
+    if (level != "all") {
+        LOG_WARN("Unknown ORT optimization level '{}', using 'all'", level);
     }
-    return selected;
+    return GraphOptimizationLevel::ORT_ENABLE_ALL;
 }
+#endif // HAS_ONNXRUNTIME
 
 // ---------------------------------------------------------------------------
 // Pimpl
 // ---------------------------------------------------------------------------
 struct LayoutDetector::Impl {
+    explicit Impl(size_t inputPoolBytes) : inputPool(inputPoolBytes) {}
+
     std::unique_ptr<dxrt::InferenceEngine> dxEngine;
 
+    // Resized model inputs, recycled once the DX run that read them is done
+    BufferPool inputPool;
+
 #ifdef HAS_ONNXRUNTIME
-    Ort::Env ortEnv{ORT_LOGGING_LEVEL_WARNING, "layout_nms"};
     std::unique_ptr<Ort::Session> ortSession;
     Ort::MemoryInfo memInfo = Ort::MemoryInfo::CreateCpu(
         OrtArenaAllocator, OrtMemTypeDefault);
+    bool ortBatchable = false;  // every sub-model input has a dynamic batch dim
+
+    // Sub-model I/O, resolved once in initialize()
+    enum class InputRole { DX_OUT0, DX_OUT1, IM_SHAPE, SCALE_FACTOR };
+    std::vector<std::string> inputNames;
+    std::vector<InputRole> inputRoles;
+    std::vector<std::vector<int64_t>> inputShapes;   // model shapes, -1 = dynamic
+    std::vector<std::string> outputNames;
+    std::unique_ptr<Ort::IoBinding> ioBinding;
+
+    // Reused per-run buffers; guarded by ortMutex together with ioBinding
+    std::mutex ortMutex;
+    std::vector<std::vector<int64_t>> boundShapes;
+    std::vector<float> imShapeData;
+    std::vector<float> scaleData;
+    std::vector<float> stackedOut0;
+    std::vector<float> stackedOut1;
 #endif
+
+    // Cross-caller batching (config.batchSize > 1)
+    struct PendingDetection {
+        cv::Mat image;
+        std::promise<LayoutResult> promise;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+    std::mutex batchMutex;
+    std::condition_variable batchCv;
+    std::deque<PendingDetection> pending;
+    bool stopping = false;
+    std::thread batchWorker;
 };
 
 // ---------------------------------------------------------------------------
 // Constructor / Destructor
 // ---------------------------------------------------------------------------
 LayoutDetector::LayoutDetector(const LayoutDetectorConfig& config)
-    : impl_(std::make_unique<Impl>())
+    // One batch in flight plus the next being preprocessed.
+    : impl_(std::make_unique<Impl>(
+          BufferPool::capacityFor(config.inputSize, config.inputSize, CV_8UC3) *
+          static_cast<size_t>(2 * std::max(1, config.batchSize))))
     , config_(config)
+    , batchMaxDelayMs_(std::max(0, config.batchMaxDelayMs))
 {
 }
 
-LayoutDetector::~LayoutDetector() = default;
+BufferPool::Stats LayoutDetector::inputPoolStats() const {
+    return impl_->inputPool.stats();
+}
+
+LayoutDetector::~LayoutDetector() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->batchMutex);
+        impl_->stopping = true;
+    }
+    impl_->batchCv.notify_all();
+    if (impl_->batchWorker.joinable()) {
+        impl_->batchWorker.join();
+    }
+}
 
 // ---------------------------------------------------------------------------
 // Initialization — load DX Engine + ONNX Runtime session
@@ -185,11 +247,90 @@ bool LayoutDetector::initialize() {
 
 #ifdef HAS_ONNXRUNTIME
     try {
+        SharedOrtEnv& shared = sharedOrtEnv(config_);
         Ort::SessionOptions opts;
-        opts.SetIntraOpNumThreads(1);
-        opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        impl_->ortSession = std::make_unique<Ort::Session>(
-            impl_->ortEnv, config_.onnxSubModelPath.c_str(), opts);
+        if (shared.globalPools) {
+            opts.DisablePerSessionThreads();
+        } else {
+            opts.SetIntraOpNumThreads(std::max(1, config_.ortIntraOpThreads));
+            opts.SetInterOpNumThreads(std::max(1, config_.ortInterOpThreads));
+        }
+
+        // A cached optimized model (newer than the source) loads without
+        // re-running graph optimization; otherwise ORT writes the cache.
+        std::string modelPath = config_.onnxSubModelPath;
+        const std::string& cachePath = config_.ortOptimizedModelPath;
+        bool cacheFresh = false;
+        if (!cachePath.empty()) {
+            std::error_code ec;
+            const auto cacheTime = fs::last_write_time(cachePath, ec);
+            if (!ec) {
+                const auto modelTime = fs::last_write_time(modelPath, ec);
+                cacheFresh = !ec && cacheTime >= modelTime;
+            }
+        }
+        if (cacheFresh) {
+            modelPath = cachePath;
+            opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            LOG_INFO("  ONNX optimized model: {} (cached)", cachePath);
+        } else {
+            opts.SetGraphOptimizationLevel(parseOptimizationLevel(config_.ortOptimizationLevel));
+            if (!cachePath.empty()) {
+                opts.SetOptimizedModelFilePath(cachePath.c_str());
+                LOG_INFO("  ONNX optimized model: {} (writing)", cachePath);
+            }
+        }
+
+        impl_->ortSession = std::make_unique<Ort::Session>(*shared.env, modelPath.c_str(), opts);
+
+        // Resolve input roles/shapes and output names once; postprocess only
+        // rebinds data pointers.
+        Ort::AllocatorWithDefaultOptions allocator;
+        const size_t numInputs = impl_->ortSession->GetInputCount();
+        impl_->ortBatchable = numInputs > 0;
+        for (size_t i = 0; i < numInputs; ++i) {
+            std::string name(impl_->ortSession->GetInputNameAllocated(i, allocator).get());
+            Impl::InputRole role;
+            if (name.find("concat") != std::string::npos) {
+                role = Impl::InputRole::DX_OUT0;
+            } else if (name.find("layer_norm") != std::string::npos) {
+                role = Impl::InputRole::DX_OUT1;
+            } else if (name == "im_shape") {
+                role = Impl::InputRole::IM_SHAPE;
+            } else if (name == "scale_factor") {
+                role = Impl::InputRole::SCALE_FACTOR;
+            } else {
+                LOG_ERROR("Unexpected layout ONNX sub-model input: {}", name);
+                return false;
+            }
+
+            auto shape = impl_->ortSession->GetInputTypeInfo(i)
+                             .GetTensorTypeAndShapeInfo().GetShape();
+            // Batched NMS needs a dynamic leading dim (and no other) on every input.
+            const auto dynamicDims = std::count_if(
+                shape.begin(), shape.end(), [](int64_t d) { return d <= 0; });
+            if (shape.empty() || shape[0] > 0 || dynamicDims != 1) {
+                impl_->ortBatchable = false;
+            }
+
+            impl_->inputNames.push_back(std::move(name));
+            impl_->inputRoles.push_back(role);
+            impl_->inputShapes.push_back(std::move(shape));
+        }
+        impl_->boundShapes = impl_->inputShapes;
+
+        impl_->ioBinding = std::make_unique<Ort::IoBinding>(*impl_->ortSession);
+        for (size_t i = 0; i < impl_->ortSession->GetOutputCount(); ++i) {
+            impl_->outputNames.emplace_back(
+                impl_->ortSession->GetOutputNameAllocated(i, allocator).get());
+            // Box count is data dependent, so ORT allocates the outputs.
+            impl_->ioBinding->BindOutput(impl_->outputNames.back().c_str(), impl_->memInfo);
+        }
+
+        const size_t maxBatch = static_cast<size_t>(std::max(1, config_.batchSize));
+        impl_->imShapeData.reserve(maxBatch * 2);
+        impl_->scaleData.reserve(maxBatch * 2);
+        LOG_INFO("  ONNX batched NMS: {}", impl_->ortBatchable ? "yes" : "no (per image)");
     } catch (const Ort::Exception& e) {
         LOG_ERROR("Failed to load ONNX sub-model: {}", e.what());
         return false;
@@ -199,6 +340,11 @@ bool LayoutDetector::initialize() {
 #endif
 
     initialized_ = true;
+    if (config_.batchSize > 1) {
+        startBatchWorker();
+        LOG_INFO("  Batching: up to {} images / {} ms",
+                 config_.batchSize, config_.batchMaxDelayMs);
+    }
     LOG_INFO("Layout detector initialized successfully");
     return true;
 }
@@ -207,148 +353,37 @@ bool LayoutDetector::initialize() {
 // Preprocessing — matches Python PPPreProcess for DXENGINE path
 //   resize to (inputSize, inputSize) with INTER_CUBIC
 //   keep uint8, NHWC, no normalization
+// With fastResize the resize is a one-pass parallel box filter instead; the
+// model takes BGR here, so there is no channel swap to fuse.
 // ---------------------------------------------------------------------------
-cv::Mat LayoutDetector::preprocess(const cv::Mat& image, cv::Point2f& scaleFactor) {
+void LayoutDetector::preprocess(const cv::Mat& image, cv::Mat& out, cv::Point2f& scaleFactor) {
     int targetH = config_.inputSize;
     int targetW = config_.inputSize;
 
-    cv::Mat resized;
-    cv::resize(image, resized, cv::Size(targetW, targetH), 0, 0, cv::INTER_CUBIC);
+    if (config_.fastResize) {
+        resizeAreaInto(image, out, cv::Size(targetW, targetH));
+    } else {
+        cv::resize(image, out, cv::Size(targetW, targetH), 0, 0, cv::INTER_CUBIC);
+    }
 
     // scale_factor = [target_h / orig_h, target_w / orig_w]
     scaleFactor.x = static_cast<float>(targetW) / image.cols;  // w_scale
     scaleFactor.y = static_cast<float>(targetH) / image.rows;  // h_scale
-
-    return resized;
 }
 
 // ---------------------------------------------------------------------------
-// Post-processing — matches Python PPPostProcess + PPDocLayoutModelHandler
+// Box decode — matches Python PPPostProcess + PPDocLayoutModelHandler
 //   1. Per-category confidence filter
 //   2. NMS (iou_same=0.6, iou_diff=0.98)
 //   3. Large image-box filter (area_thres 0.82/0.93)
 //   4. Coordinate clamping & LayoutCategory mapping
 // ---------------------------------------------------------------------------
-std::vector<LayoutBox> LayoutDetector::postprocess(
-    const std::vector<std::vector<float>>& dxOutputs,
-    const cv::Size& imShape,
-    const cv::Point2f& scaleFactor)
+std::vector<LayoutBox> LayoutDetector::decodeBoxes(
+    const float* boxData, int totalBoxes, const cv::Size& imShape)
 {
-#ifndef HAS_ONNXRUNTIME
-    LOG_WARN("ONNX Runtime not available — cannot run NMS post-processing");
-    return {};
-#else
-    if (!impl_->ortSession) return {};
-
-    // ---- Run ONNX sub-model ----
-    // dxOutputs[0] and dxOutputs[1] are the two DX Engine output tensors.
-    // We build the ONNX feed dict with 4 inputs.
-    int64_t inputH = config_.inputSize;
-    int64_t inputW = config_.inputSize;
-
-    // im_shape = [[inputH, inputW]]  float32
-    std::vector<float> imShapeData = {static_cast<float>(inputH),
-                                      static_cast<float>(inputW)};
-    std::vector<int64_t> imShapeDims = {1, 2};
-
-    // scale_factor = [[h_scale, w_scale]]
-    std::vector<float> scaleData = {scaleFactor.y, scaleFactor.x};
-    std::vector<int64_t> scaleDims = {1, 2};
-
-    auto imShapeTensor = Ort::Value::CreateTensor<float>(
-        impl_->memInfo, imShapeData.data(), imShapeData.size(),
-        imShapeDims.data(), imShapeDims.size());
-    auto scaleTensor = Ort::Value::CreateTensor<float>(
-        impl_->memInfo, scaleData.data(), scaleData.size(),
-        scaleDims.data(), scaleDims.size());
-
-    // Determine DX output tensor shapes from the ONNX model input metadata
-    Ort::AllocatorWithDefaultOptions allocator;
-    size_t numInputs = impl_->ortSession->GetInputCount();
-    std::vector<const char*> inputNames;
-    std::vector<Ort::AllocatedStringPtr> inputNamePtrs;
-    for (size_t i = 0; i < numInputs; ++i) {
-        auto namePtr = impl_->ortSession->GetInputNameAllocated(i, allocator);
-        inputNames.push_back(namePtr.get());
-        inputNamePtrs.push_back(std::move(namePtr));
-    }
-
-    size_t numOutputs = impl_->ortSession->GetOutputCount();
-    std::vector<const char*> outputNames;
-    std::vector<Ort::AllocatedStringPtr> outputNamePtrs;
-    for (size_t i = 0; i < numOutputs; ++i) {
-        auto namePtr = impl_->ortSession->GetOutputNameAllocated(i, allocator);
-        outputNames.push_back(namePtr.get());
-        outputNamePtrs.push_back(std::move(namePtr));
-    }
-
-    // Build tensors for DX outputs, matching the ONNX input names
-    // We need mutable copies because CreateTensor takes non-const pointers
-    std::vector<float> dxOut0 = dxOutputs[0];
-    std::vector<float> dxOut1 = dxOutputs[1];
-
-    // Get expected shapes from the ONNX model
-    auto getInputShape = [&](size_t idx) -> std::vector<int64_t> {
-        auto typeInfo = impl_->ortSession->GetInputTypeInfo(idx);
-        auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
-        return tensorInfo.GetShape();
-    };
-
-    std::vector<int64_t> shape0 = getInputShape(0);
-    std::vector<int64_t> shape1 = getInputShape(1);
-
-    // Fix dynamic dimensions (-1) based on actual data size
-    auto fixDynamic = [](std::vector<int64_t>& shape, size_t dataSize) {
-        int64_t known = 1;
-        int dynIdx = -1;
-        for (size_t i = 0; i < shape.size(); ++i) {
-            if (shape[i] > 0) known *= shape[i];
-            else dynIdx = static_cast<int>(i);
-        }
-        if (dynIdx >= 0 && known > 0) {
-            shape[dynIdx] = static_cast<int64_t>(dataSize) / known;
-        }
-    };
-
-    fixDynamic(shape0, dxOut0.size());
-    fixDynamic(shape1, dxOut1.size());
-
-    auto dxTensor0 = Ort::Value::CreateTensor<float>(
-        impl_->memInfo, dxOut0.data(), dxOut0.size(),
-        shape0.data(), shape0.size());
-    auto dxTensor1 = Ort::Value::CreateTensor<float>(
-        impl_->memInfo, dxOut1.data(), dxOut1.size(),
-        shape1.data(), shape1.size());
-
-    // Arrange tensors in the order expected by the ONNX model
-    std::vector<Ort::Value> ortInputs;
-    for (size_t i = 0; i < numInputs; ++i) {
-        std::string name(inputNames[i]);
-        if (name.find("concat") != std::string::npos) {
-            ortInputs.push_back(std::move(dxTensor0));
-        } else if (name.find("layer_norm") != std::string::npos) {
-            ortInputs.push_back(std::move(dxTensor1));
-        } else if (name == "im_shape") {
-            ortInputs.push_back(std::move(imShapeTensor));
-        } else if (name == "scale_factor") {
-            ortInputs.push_back(std::move(scaleTensor));
-        }
-    }
-
-    auto ortOutputs = impl_->ortSession->Run(
-        Ort::RunOptions{nullptr},
-        inputNames.data(), ortInputs.data(), ortInputs.size(),
-        outputNames.data(), outputNames.size());
-
-    // ---- Parse ONNX output: boxes and box_num ----
-    // Output format follows PaddleDetection: pred[0] = boxes, pred[1] = box_nums
     // boxes: [N, 6]  each row = [cls_id, score, xmin, ymin, xmax, ymax]
-    const float* boxData = ortOutputs[0].GetTensorData<float>();
-    auto boxShape = ortOutputs[0].GetTensorTypeAndShapeInfo().GetShape();
-    int totalBoxes = static_cast<int>(boxShape[0]);
-
-    // Collect raw boxes as vector of 6-element vectors
-    std::vector<std::vector<float>> rawBoxes;
+    // Collect raw boxes as parallel arrays
+    LayoutCandidates rawBoxes;
     rawBoxes.reserve(totalBoxes);
     for (int i = 0; i < totalBoxes; ++i) {
         const float* row = boxData + i * 6;
@@ -360,11 +395,11 @@ std::vector<LayoutBox> LayoutDetector::postprocess(
         float threshold = (it != kPerCategoryConfThres.end()) ? it->second : 0.5f;
         if (score < threshold) continue;
 
-        rawBoxes.push_back({row[0], row[1], row[2], row[3], row[4], row[5]});
+        rawBoxes.push(row);
     }
 
     // ---- NMS (same-class IoU=0.6, diff-class IoU=0.98) ----
-    auto selected = nms(rawBoxes, 0.6f, 0.98f);
+    auto selected = layoutNms(rawBoxes, 0.6f, 0.98f);
 
     // ---- Large image box filter ----
     float imgW = static_cast<float>(imShape.width);
@@ -380,41 +415,41 @@ std::vector<LayoutBox> LayoutDetector::postprocess(
         }
     }
 
-    std::vector<std::vector<float>> filteredBoxes;
+    std::vector<int> filteredBoxes;
+    filteredBoxes.reserve(selected.size());
     for (int idx : selected) {
-        const auto& box = rawBoxes[idx];
-        int clsId = static_cast<int>(box[0]);
+        int clsId = static_cast<int>(rawBoxes.clsId[idx]);
         if (clsId == imageClsIdx && selected.size() > 1) {
-            float xmin = std::max(0.0f, box[2]);
-            float ymin = std::max(0.0f, box[3]);
-            float xmax = std::min(imgW, box[4]);
-            float ymax = std::min(imgH, box[5]);
+            float xmin = std::max(0.0f, rawBoxes.x0[idx]);
+            float ymin = std::max(0.0f, rawBoxes.y0[idx]);
+            float xmax = std::min(imgW, rawBoxes.x1[idx]);
+            float ymax = std::min(imgH, rawBoxes.y1[idx]);
             float boxArea = (xmax - xmin) * (ymax - ymin);
             if (boxArea > areaThreshold * imgArea) continue;
         }
-        filteredBoxes.push_back(box);
+        filteredBoxes.push_back(idx);
     }
     if (filteredBoxes.empty() && !selected.empty()) {
-        for (int idx : selected)
-            filteredBoxes.push_back(rawBoxes[idx]);
+        filteredBoxes = selected;
     }
 
     // ---- Map to LayoutBox ----
     std::vector<LayoutBox> result;
     result.reserve(filteredBoxes.size());
     for (size_t i = 0; i < filteredBoxes.size(); ++i) {
-        const auto& box = filteredBoxes[i];
-        int clsId = static_cast<int>(box[0]);
-        float score = box[1];
-        float xmin = std::max(0.0f, box[2]);
-        float ymin = std::max(0.0f, box[3]);
-        float xmax = std::min(imgW, box[4]);
-        float ymax = std::min(imgH, box[5]);
+        const int idx = filteredBoxes[i];
+        int clsId = static_cast<int>(rawBoxes.clsId[idx]);
+        float score = rawBoxes.score[idx];
+        float xmin = std::max(0.0f, rawBoxes.x0[idx]);
+        float ymin = std::max(0.0f, rawBoxes.y0[idx]);
+        float xmax = std::min(imgW, rawBoxes.x1[idx]);
+        float ymax = std::min(imgH, rawBoxes.y1[idx]);
         if (xmax <= xmin || ymax <= ymin) continue;
 
-        std::string label = (clsId >= 0 && clsId < static_cast<int>(kDxEngineLabels.size()))
-                            ? kDxEngineLabels[clsId]
-                            : "unknown";
+        // Views the static label table, so boxes carry no string copies.
+        const std::string_view label = (clsId >= 0 && clsId < static_cast<int>(kDxEngineLabels.size()))
+                                       ? std::string_view(kDxEngineLabels[clsId])
+                                       : std::string_view("unknown");
 
         LayoutBox lb;
         lb.x0 = xmin;
@@ -430,6 +465,158 @@ std::vector<LayoutBox> LayoutDetector::postprocess(
     }
 
     return result;
+}
+
+// ---------------------------------------------------------------------------
+// Post-processing — ONNX sub-model (bbox decode) + decodeBoxes()
+// ---------------------------------------------------------------------------
+std::vector<LayoutBox> LayoutDetector::postprocess(
+    const std::vector<TensorView>& dxOutputs,
+    const cv::Size& imShape,
+    const cv::Point2f& scaleFactor)
+{
+    return postprocessBatch({dxOutputs}, {imShape}, {scaleFactor}).front();
+}
+
+std::vector<std::vector<LayoutBox>> LayoutDetector::postprocessBatch(
+    const std::vector<std::vector<TensorView>>& dxOutputs,
+    const std::vector<cv::Size>& imShapes,
+    const std::vector<cv::Point2f>& scaleFactors)
+{
+    const size_t batch = dxOutputs.size();
+    std::vector<std::vector<LayoutBox>> results(batch);
+#ifndef HAS_ONNXRUNTIME
+    LOG_WARN("ONNX Runtime not available — cannot run NMS post-processing");
+    return results;
+#else
+    if (!impl_->ortSession || batch == 0) return results;
+
+    if (batch > 1 && !impl_->ortBatchable) {
+        for (size_t b = 0; b < batch; ++b) {
+            results[b] = postprocess(dxOutputs[b], imShapes[b], scaleFactors[b]);
+        }
+        return results;
+    }
+
+    std::unique_lock<std::mutex> ortLock(impl_->ortMutex);
+
+    // ---- Run ONNX sub-model ----
+    // dxOutputs[b][0] and dxOutputs[b][1] are the two DX Engine output tensors
+    // of image b. A single image is bound in place; a batch is stacked along
+    // the batch dim into reused buffers for one run.
+    // We build the ONNX feed dict with 4 inputs.
+    int64_t inputH = config_.inputSize;
+    int64_t inputW = config_.inputSize;
+    const int64_t batchDim = static_cast<int64_t>(batch);
+
+    // im_shape = [[inputH, inputW], ...]  float32
+    // scale_factor = [[h_scale, w_scale], ...]
+    impl_->imShapeData.clear();
+    impl_->scaleData.clear();
+    for (size_t b = 0; b < batch; ++b) {
+        impl_->imShapeData.push_back(static_cast<float>(inputH));
+        impl_->imShapeData.push_back(static_cast<float>(inputW));
+        impl_->scaleData.push_back(scaleFactors[b].y);
+        impl_->scaleData.push_back(scaleFactors[b].x);
+    }
+    const std::array<int64_t, 2> pairDims = {batchDim, 2};
+
+    // CreateTensor takes non-const pointers; ORT only reads model inputs.
+    TensorView dxOut0 = dxOutputs[0][0];
+    TensorView dxOut1 = dxOutputs[0][1];
+    if (batch > 1) {
+        impl_->stackedOut0.clear();
+        impl_->stackedOut1.clear();
+        for (size_t b = 0; b < batch; ++b) {
+            impl_->stackedOut0.insert(impl_->stackedOut0.end(),
+                dxOutputs[b][0].data, dxOutputs[b][0].data + dxOutputs[b][0].count);
+            impl_->stackedOut1.insert(impl_->stackedOut1.end(),
+                dxOutputs[b][1].data, dxOutputs[b][1].data + dxOutputs[b][1].count);
+        }
+        dxOut0 = {impl_->stackedOut0.data(), impl_->stackedOut0.size()};
+        dxOut1 = {impl_->stackedOut1.data(), impl_->stackedOut1.size()};
+    }
+
+    // Fix dynamic dimensions (-1) based on actual data size
+    auto fixDynamic = [](std::vector<int64_t>& shape, const std::vector<int64_t>& modelShape,
+                         size_t dataSize) {
+        shape = modelShape;
+        int64_t known = 1;
+        int dynIdx = -1;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            if (shape[i] > 0) known *= shape[i];
+            else dynIdx = static_cast<int>(i);
+        }
+        if (dynIdx >= 0 && known > 0) {
+            shape[dynIdx] = static_cast<int64_t>(dataSize) / known;
+        }
+    };
+
+    std::vector<Ort::Value> boundInputs;
+    boundInputs.reserve(impl_->inputNames.size());
+    for (size_t i = 0; i < impl_->inputNames.size(); ++i) {
+        std::vector<int64_t>& shape = impl_->boundShapes[i];
+        switch (impl_->inputRoles[i]) {
+            case Impl::InputRole::DX_OUT0:
+            case Impl::InputRole::DX_OUT1: {
+                const TensorView& view =
+                    impl_->inputRoles[i] == Impl::InputRole::DX_OUT0 ? dxOut0 : dxOut1;
+                fixDynamic(shape, impl_->inputShapes[i], view.count);
+                boundInputs.push_back(Ort::Value::CreateTensor<float>(
+                    impl_->memInfo, const_cast<float*>(view.data), view.count,
+                    shape.data(), shape.size()));
+                break;
+            }
+            case Impl::InputRole::IM_SHAPE:
+                boundInputs.push_back(Ort::Value::CreateTensor<float>(
+                    impl_->memInfo, impl_->imShapeData.data(), impl_->imShapeData.size(),
+                    pairDims.data(), pairDims.size()));
+                break;
+            case Impl::InputRole::SCALE_FACTOR:
+                boundInputs.push_back(Ort::Value::CreateTensor<float>(
+                    impl_->memInfo, impl_->scaleData.data(), impl_->scaleData.size(),
+                    pairDims.data(), pairDims.size()));
+                break;
+        }
+        impl_->ioBinding->BindInput(impl_->inputNames[i].c_str(), boundInputs.back());
+    }
+
+    impl_->ortSession->Run(Ort::RunOptions{nullptr}, *impl_->ioBinding);
+    std::vector<Ort::Value> ortOutputs = impl_->ioBinding->GetOutputValues();
+    impl_->ioBinding->ClearBoundInputs();
+    ortLock.unlock();  // outputs are owned values; decode needs no shared state
+
+    // ---- Parse ONNX output: boxes and box_num ----
+    // Output format follows PaddleDetection: pred[0] = boxes, pred[1] = box_nums
+    // boxes: [N, 6] for the whole batch, box_num: [B] rows belonging to each image
+    const float* boxData = ortOutputs[0].GetTensorData<float>();
+    auto boxShape = ortOutputs[0].GetTensorTypeAndShapeInfo().GetShape();
+    int totalBoxes = static_cast<int>(boxShape[0]);
+
+    std::vector<int> boxCounts(batch, 0);
+    if (batch == 1) {
+        boxCounts[0] = totalBoxes;
+    } else {
+        if (ortOutputs.size() < 2) {
+            LOG_ERROR("Layout ONNX sub-model has no box_num output; batched decode unavailable");
+            return results;
+        }
+        auto numInfo = ortOutputs[1].GetTensorTypeAndShapeInfo();
+        const size_t numCount = std::min(batch, numInfo.GetElementCount());
+        for (size_t b = 0; b < numCount; ++b) {
+            boxCounts[b] = numInfo.GetElementType() == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64
+                               ? static_cast<int>(ortOutputs[1].GetTensorData<int64_t>()[b])
+                               : static_cast<int>(ortOutputs[1].GetTensorData<int32_t>()[b]);
+        }
+    }
+
+    int offset = 0;
+    for (size_t b = 0; b < batch; ++b) {
+        const int count = std::max(0, std::min(boxCounts[b], totalBoxes - offset));
+        results[b] = decodeBoxes(boxData + offset * 6, count, imShapes[b]);
+        offset += count;
+    }
+    return results;
 #endif // HAS_ONNXRUNTIME
 }
 
@@ -437,54 +624,192 @@ std::vector<LayoutBox> LayoutDetector::postprocess(
 // Detect — full pipeline
 // ---------------------------------------------------------------------------
 LayoutResult LayoutDetector::detect(const cv::Mat& image) {
-    LayoutResult result;
+    TRACE_SPAN("LayoutDetector::detect", "layout");
+    if (initialized_ && config_.batchSize > 1) {
+        // Join whatever other callers are submitting right now.
+        return detectAsync(image).get();
+    }
+    return std::move(detectBatch({image}).front());
+}
+
+std::vector<LayoutResult> LayoutDetector::detectBatch(const std::vector<cv::Mat>& images) {
+    TRACE_SPAN("LayoutDetector::detectBatch", "layout");
+    std::vector<LayoutResult> results(images.size());
 
     if (!initialized_) {
         LOG_ERROR("Layout detector not initialized");
-        return result;
+        return results;
+    }
+    if (images.empty()) {
+        return results;
     }
 
     auto tStart = std::chrono::steady_clock::now();
+    const size_t batch = images.size();
 
     // 1. Preprocess
-    cv::Point2f scaleFactor;
-    cv::Mat preprocessed = preprocess(image, scaleFactor);
+    std::vector<cv::Mat> preprocessed(batch);
+    std::vector<cv::Point2f> scaleFactors(batch);
+    std::vector<cv::Size> origShapes(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        preprocessed[i] = impl_->inputPool.acquire(config_.inputSize, config_.inputSize, CV_8UC3);
+        preprocess(images[i], preprocessed[i], scaleFactors[i]);
+        origShapes[i] = cv::Size(images[i].cols, images[i].rows);
+    }
 
     // 2. DX Engine inference — input is NHWC uint8
-    // DX Engine Run() takes void* pointing to the raw data buffer.
-    auto dxRawOutputs = impl_->dxEngine->Run(
-        static_cast<void*>(preprocessed.data));
-
-    // Convert raw DX outputs to float vectors
-    std::vector<std::vector<float>> dxOutputs;
-    for (auto& outPtr : dxRawOutputs) {
-        const float* ptr = reinterpret_cast<const float*>(outPtr->data());
-        size_t count = 1;
-        for (auto d : outPtr->shape()) count *= d;
-        dxOutputs.emplace_back(ptr, ptr + count);
+    // DX Engine Run() takes void* pointing to the raw data buffer. A batch is
+    // queued with RunAsync so the runtime can keep every NPU core busy.
+    // The returned tensors are held until post-processing is done and are
+    // read through views rather than copied.
+    std::vector<dxrt::TensorPtrs> dxRawOutputs(batch);
+    if (batch == 1) {
+        dxRawOutputs[0] = impl_->dxEngine->Run(static_cast<void*>(preprocessed[0].data));
+    } else {
+        std::vector<int> jobIds;
+        jobIds.reserve(batch);
+        for (size_t i = 0; i < batch; ++i) {
+            jobIds.push_back(impl_->dxEngine->RunAsync(static_cast<void*>(preprocessed[i].data)));
+        }
+        for (size_t i = 0; i < batch; ++i) {
+            dxRawOutputs[i] = impl_->dxEngine->Wait(jobIds[i]);
+        }
+    }
+
+    std::vector<std::vector<TensorView>> dxOutputs(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        if (dxRawOutputs[i].size() < 2) {
+            LOG_ERROR("Layout DX engine returned {} outputs, expected 2", dxRawOutputs[i].size());
+            return results;
+        }
+        dxOutputs[i].reserve(dxRawOutputs[i].size());
+        for (auto& outPtr : dxRawOutputs[i]) {
+            TensorView view;
+            view.data = reinterpret_cast<const float*>(outPtr->data());
+            view.count = 1;
+            for (auto d : outPtr->shape()) view.count *= d;
+            dxOutputs[i].push_back(view);
+        }
     }
 
     // 3. Post-process (ONNX NMS + category mapping)
-    cv::Size origShape(image.cols, image.rows);
-    result.boxes = postprocess(dxOutputs, origShape, scaleFactor);
+    auto boxes = postprocessBatch(dxOutputs, origShapes, scaleFactors);
 
     auto tEnd = std::chrono::steady_clock::now();
-    result.inferenceTimeMs =
-        std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+    const double elapsedMs = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+    for (size_t i = 0; i < batch; ++i) {
+        results[i].boxes = std::move(boxes[i]);
+        results[i].inferenceTimeMs = elapsedMs;
+    }
 
-    LOG_INFO("Layout detection: {} boxes in {:.1f}ms",
-             result.boxes.size(), result.inferenceTimeMs);
+    if (batch == 1) {
+        LOG_INFO("Layout detection: {} boxes in {:.1f}ms",
+                 results[0].boxes.size(), elapsedMs);
+    } else {
+        LOG_INFO("Layout detection: batch of {} in {:.1f}ms", batch, elapsedMs);
+    }
 
-    return result;
+    return results;
 }
 
 // ---------------------------------------------------------------------------
-// Async detect — runs synchronously for now, async DX Engine integration later
+// Async detect — queued for the batch worker, or run on its own thread when
+// batching is off
 // ---------------------------------------------------------------------------
-void LayoutDetector::detectAsync(const cv::Mat& image, DetectionCallback callback) {
-    auto result = detect(image);
-    if (callback) {
-        callback(result);
+std::future<LayoutResult> LayoutDetector::detectAsync(const cv::Mat& image) {
+    if (!initialized_ || config_.batchSize <= 1) {
+        return std::async(std::launch::async, [this, image]() {
+            return std::move(detectBatch({image}).front());
+        });
+    }
+
+    Impl::PendingDetection pending;
+    pending.image = image;
+    pending.enqueued = std::chrono::steady_clock::now();
+    std::future<LayoutResult> future = pending.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(impl_->batchMutex);
+        impl_->pending.push_back(std::move(pending));
+    }
+    impl_->batchCv.notify_one();
+    return future;
+}
+
+void LayoutDetector::startBatchWorker() {
+    impl_->batchWorker = std::thread(&LayoutDetector::runBatchWorker, this);
+}
+
+void LayoutDetector::runBatchWorker() {
+    const size_t maxBatch = static_cast<size_t>(std::max(1, config_.batchSize));
+
+    while (true) {
+        std::vector<Impl::PendingDetection> batch;
+        {
+            std::unique_lock<std::mutex> lock(impl_->batchMutex);
+            impl_->batchCv.wait(lock, [this]() {
+                return impl_->stopping || !impl_->pending.empty();
+            });
+            if (impl_->pending.empty()) {
+                return;  // stopping and drained
+            }
+
+            // Hold the batch open until it is full or its oldest image has
+            // waited batchMaxDelayMs.
+            const auto deadline = impl_->pending.front().enqueued +
+                                  std::chrono::milliseconds(batchMaxDelayMs());
+            impl_->batchCv.wait_until(lock, deadline, [&]() {
+                return impl_->stopping || impl_->pending.size() >= maxBatch;
+            });
+
+            const size_t take = std::min(maxBatch, impl_->pending.size());
+            batch.reserve(take);
+            for (size_t i = 0; i < take; ++i) {
+                batch.push_back(std::move(impl_->pending.front()));
+                impl_->pending.pop_front();
+            }
+        }
+
+        std::vector<cv::Mat> images;
+        images.reserve(batch.size());
+        for (const auto& item : batch) {
+            images.push_back(item.image);
+        }
+
+        size_t delivered = 0;
+        try {
+            // Admission is per formed batch, so images from callers that
+            // never held the NPU still share one run.
+            std::vector<LayoutResult> results;
+            double waitMs = 0.0;
+            double holdMs = 0.0;
+            auto run = [&]() {
+                auto runStart = std::chrono::steady_clock::now();
+                results = batchRunHook_ ? batchRunHook_(images) : detectBatch(images);
+                holdMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - runStart).count();
+            };
+            if (batchAdmission_) {
+                waitMs = batchAdmission_(run);
+            } else {
+                run();
+            }
+            if (results.size() != batch.size()) {
+                throw std::runtime_error("layout batch returned " +
+                                         std::to_string(results.size()) + " results for " +
+                                         std::to_string(batch.size()) + " images");
+            }
+            const double share = 1.0 / static_cast<double>(batch.size());
+            for (; delivered < batch.size(); ++delivered) {
+                results[delivered].npuWaitMs = waitMs * share;
+                results[delivered].npuHoldMs = holdMs * share;
+                batch[delivered].promise.set_value(std::move(results[delivered]));
+            }
+        } catch (...) {
+            // Only promises that have not been given a result yet.
+            for (size_t i = delivered; i < batch.size(); ++i) {
+                batch[i].promise.set_exception(std::current_exception());
+            }
+        }
     }
 }
 
@@ -1,7 +1,6 @@
 #include "output/content_list.h"
-#include <nlohmann/json.hpp>
-
-using json = nlohmann::json;
+#include "output/json_writer.h"
+#include <utility>
 
 namespace rapid_doc {
 
@@ -21,30 +20,104 @@ static const char* typeToString(ContentElement::Type t) {
     }
 }
 
-std::string ContentListWriter::generate(const DocumentResult& result) const {
-    json doc = json::array();
+namespace {
 
-    for (const auto& page : result.pages) {
-        json pageArr = json::array();
-        for (const auto& elem : page.elements) {
-            json item;
-            item["type"]    = typeToString(elem.type);
-            item["text"]    = elem.text;
-            item["page"]    = elem.pageIndex;
-            item["order"]   = elem.readingOrder;
-            item["skipped"] = elem.skipped;
-            item["bbox"]    = {elem.layoutBox.x0, elem.layoutBox.y0,
+constexpr int kIndent = 2;
+
+void appendKey(std::string& out, const char* key, bool first) {
+    if (!first) out.push_back(',');
+    appendJsonNewline(out, kIndent, 3);
+    out.push_back('"');
+    out += key;
+    out += "\": ";
+}
+
+}  // namespace
+
+// Layout matches the former nlohmann DOM dump(2): keys in sorted order.
+void ContentListWriter::appendPage(const PageResult& page, std::string& out) const {
+    if (page.elements.empty()) {
+        out += "[]";
+        return;
+    }
+
+    out.push_back('[');
+    bool firstElem = true;
+    for (const auto& elem : page.elements) {
+        if (!firstElem) out.push_back(',');
+        firstElem = false;
+        appendJsonNewline(out, kIndent, 2);
+        out.push_back('{');
+
+        appendKey(out, "bbox", true);
+        out.push_back('[');
+        const float bbox[4] = {elem.layoutBox.x0, elem.layoutBox.y0,
                                elem.layoutBox.x1, elem.layoutBox.y1};
-            if (!elem.html.empty())
-                item["html"] = elem.html;
-            if (!elem.imagePath.empty())
-                item["image_path"] = elem.imagePath;
-            pageArr.push_back(std::move(item));
+        for (int i = 0; i < 4; ++i) {
+            if (i > 0) out.push_back(',');
+            appendJsonNewline(out, kIndent, 4);
+            appendJsonNumber(out, static_cast<double>(bbox[i]));
+        }
+        appendJsonNewline(out, kIndent, 3);
+        out.push_back(']');
+
+        if (!elem.html.empty()) {
+            appendKey(out, "html", false);
+            appendJsonString(out, elem.html);
         }
-        doc.push_back(std::move(pageArr));
+        if (!elem.imagePath.empty()) {
+            appendKey(out, "image_path", false);
+            appendJsonString(out, elem.imagePath);
+        }
+        appendKey(out, "order", false);
+        appendJsonNumber(out, static_cast<long long>(elem.readingOrder));
+        appendKey(out, "page", false);
+        appendJsonNumber(out, static_cast<long long>(elem.pageIndex));
+        appendKey(out, "skipped", false);
+        out += elem.skipped ? "true" : "false";
+        appendKey(out, "text", false);
+        appendJsonString(out, elem.text);
+        appendKey(out, "type", false);
+        appendJsonString(out, typeToString(elem.type));
+
+        appendJsonNewline(out, kIndent, 2);
+        out.push_back('}');
+    }
+    appendJsonNewline(out, kIndent, 1);
+    out.push_back(']');
+}
+
+std::string ContentListWriter::generate(const DocumentResult& result) const {
+    std::string out;
+    ContentListStream stream(makeStringSink(out));
+    for (const auto& page : result.pages) {
+        stream.appendPage(page);
     }
+    stream.finish();
+    return out;
+}
+
+ContentListStream::ContentListStream(OutputSink sink)
+    : sink_(std::move(sink))
+{}
 
-    return doc.dump(2);
+void ContentListStream::appendPage(const PageResult& page) {
+    buffer_.clear();
+    buffer_ += (pages_ == 0) ? "[" : ",";
+    appendJsonNewline(buffer_, kIndent, 1);
+    writer_.appendPage(page, buffer_);
+    ++pages_;
+    sink_(buffer_.data(), buffer_.size());
+}
+
+void ContentListStream::finish() {
+    if (finished_) return;
+    finished_ = true;
+    if (pages_ == 0) {
+        sink_("[]", 2);
+    } else {
+        sink_("\n]", 2);
+    }
 }
 
 } // namespace rapid_doc
@@ -130,8 +130,16 @@ std::string buildDetailReport(
     appendStageLine(out, "output_gen", result.stats.outputGenTimeMs);
     appendStageLine(out, "npu_serial", result.stats.npuSerialTimeMs);
     appendStageLine(out, "cpu_only", result.stats.cpuOnlyTimeMs);
+    appendStageLine(out, "  npu_stage_cpu", result.stats.npuStageCpuTimeMs);
+    appendStageLine(out, "  postprocess_cpu", result.stats.postprocessCpuTimeMs);
     appendStageLine(out, "npu_lock_wait", result.stats.npuLockWaitTimeMs);
     appendStageLine(out, "npu_lock_hold", result.stats.npuLockHoldTimeMs);
+    appendStageLine(out, "  layout_npu_wait", result.stats.layoutNpuWaitTimeMs);
+    appendStageLine(out, "  layout_npu_hold", result.stats.layoutNpuHoldTimeMs);
+    appendStageLine(out, "  ocr_npu_wait", result.stats.ocrNpuWaitTimeMs);
+    appendStageLine(out, "  ocr_npu_hold", result.stats.ocrNpuHoldTimeMs);
+    appendStageLine(out, "  table_npu_wait", result.stats.tableNpuWaitTimeMs);
+    appendStageLine(out, "  table_npu_hold", result.stats.tableNpuHoldTimeMs);
 
     out << "Per-page\n";
     for (const auto& page : result.pages) {
@@ -168,6 +176,8 @@ std::string buildDetailReport(
         appendStageLine(out, "    reading_order", page.stats.readingOrderTimeMs);
         appendStageLine(out, "    npu_serial", page.stats.npuSerialTimeMs);
         appendStageLine(out, "    cpu_only", page.stats.cpuOnlyTimeMs);
+        appendStageLine(out, "      npu_stage_cpu", page.stats.npuStageCpuTimeMs);
+        appendStageLine(out, "      postprocess_cpu", page.stats.postprocessCpuTimeMs);
         appendStageLine(out, "    npu_lock_wait", page.stats.npuLockWaitTimeMs);
         appendStageLine(out, "    npu_lock_hold", page.stats.npuLockHoldTimeMs);
 
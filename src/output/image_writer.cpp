@@ -0,0 +1,259 @@
+#include "output/image_writer.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <utility>
+
+namespace rapid_doc {
+
+namespace {
+
+constexpr int kFastPngLevel = 1;
+constexpr int kDefaultLossyQuality = 90;
+// Queued tasks per worker before post() falls back to running inline.
+constexpr size_t kPendingPerWorker = 16;
+
+} // namespace
+
+bool ImageEncoding::parse(const std::string& format, int quality, ImageEncoding& out) {
+    std::string lower = format;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    out.quality = quality;
+    if (lower == "png") {
+        out.codec = ImageCodec::PNG;
+    } else if (lower == "jpg" || lower == "jpeg") {
+        out.codec = ImageCodec::JPEG;
+    } else if (lower == "webp") {
+        out.codec = ImageCodec::WEBP;
+    } else {
+        out.codec = ImageCodec::PNG;
+        return false;
+    }
+    return true;
+}
+
+const char* ImageEncoding::extension() const {
+    switch (codec) {
+    case ImageCodec::JPEG: return ".jpg";
+    case ImageCodec::WEBP: return ".webp";
+    case ImageCodec::PNG:
+    default:               return ".png";
+    }
+}
+
+std::vector<int> ImageEncoding::params() const {
+    switch (codec) {
+    case ImageCodec::JPEG:
+        return {cv::IMWRITE_JPEG_QUALITY,
+                quality >= 0 ? std::clamp(quality, 1, 100) : kDefaultLossyQuality};
+    case ImageCodec::WEBP:
+        return {cv::IMWRITE_WEBP_QUALITY,
+                quality >= 0 ? std::clamp(quality, 1, 100) : kDefaultLossyQuality};
+    case ImageCodec::PNG:
+    default:
+        return {cv::IMWRITE_PNG_COMPRESSION,
+                quality >= 0 ? std::clamp(quality, 0, 9) : kFastPngLevel};
+    }
+}
+
+bool ImageEncoding::encode(const cv::Mat& image, std::vector<uint8_t>& out) const {
+    try {
+        return cv::imencode(extension(), image, out, params());
+    } catch (const cv::Exception& e) {
+        LOG_WARN("Image encode ({}) failed: {}", extension(), e.what());
+        return false;
+    }
+}
+
+ImageWriter::ImageWriter(size_t threads, size_t encodedCacheBytes)
+    : maxPending_(threads * kPendingPerWorker)
+{
+    if (encodedCacheBytes > 0) {
+        encodedCache_ = std::make_unique<EncodedCache>(encodedCacheBytes);
+    }
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ImageWriter::~ImageWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskReady_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ImageWriter::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!workers_.empty() && tasks_.size() < maxPending_) {
+            tasks_.push_back(std::move(task));
+            taskReady_.notify_one();
+            return;
+        }
+    }
+    task();
+}
+
+void ImageWriter::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskReady_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;  // stopping, and every queued write has run
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+ImageWriteBatch::ImageWriteBatch(ImageWriter& writer, ImageEncoding encoding, bool keepEncoded)
+    : writer_(writer)
+    , encoding_(encoding)
+    , keepEncoded_(keepEncoded)
+{}
+
+void ImageWriteBatch::submit(cv::Mat image, std::string filePath, std::string key) {
+    enqueue(std::move(image), std::move(filePath), std::move(key), std::nullopt);
+}
+
+std::string ImageWriteBatch::submitDeduplicated(
+    cv::Mat image, const ContentDigest& digest, std::string filePath, std::string key)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Node references survive rehashing, and copies are never erased.
+        const auto inserted = stored_.emplace(digest, StoredCopy{key});
+        StoredCopy& stored = inserted.first->second;
+        if (!inserted.second) {
+            settled_.wait(lock, [&stored]() { return stored.state != StoredCopy::State::WRITING; });
+            if (stored.state == StoredCopy::State::STORED) {
+                ++duplicates_;
+                return stored.key;
+            }
+            // The earlier copy never reached disk; this one takes its place.
+            stored = StoredCopy{key};
+        }
+    }
+    // The cross-run cache also keys on the encoding, which may differ per run.
+    ContentHasher hasher;
+    hasher.update(digest.a);
+    hasher.update(digest.b);
+    hasher.update(static_cast<uint64_t>(encoding_.codec));
+    hasher.update(static_cast<uint64_t>(static_cast<int64_t>(encoding_.quality)));
+    enqueue(std::move(image), std::move(filePath), key, hasher.digest(), digest);
+    return key;
+}
+
+void ImageWriteBatch::stageDeduplicated(
+    cv::Mat image, const ContentDigest& digest, std::string filePath, std::string key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    staged_[std::move(key)] = StagedCrop{std::move(image), digest, std::move(filePath)};
+}
+
+std::string ImageWriteBatch::claim(const std::string& key) {
+    StagedCrop crop;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = staged_.find(key);
+        if (it == staged_.end()) {
+            return key;
+        }
+        crop = std::move(it->second);
+        staged_.erase(it);
+    }
+    return submitDeduplicated(std::move(crop.image), crop.digest, std::move(crop.filePath), key);
+}
+
+size_t ImageWriteBatch::duplicateCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return duplicates_;
+}
+
+void ImageWriteBatch::enqueue(
+    cv::Mat image, std::string filePath, std::string key, std::optional<ContentDigest> cacheKey,
+    std::optional<ContentDigest> dedupDigest)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    auto self = shared_from_this();
+    writer_.post([self, image = std::move(image), filePath = std::move(filePath),
+                  key = std::move(key), cacheKey, dedupDigest]() mutable {
+        // write() may move the key into the kept images.
+        const std::string storedKey = dedupDigest ? key : std::string();
+        const bool written = self->write(image, filePath, key, cacheKey);
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (dedupDigest) {
+            StoredCopy& stored = self->stored_.at(*dedupDigest);
+            if (stored.key == storedKey) {
+                stored.state = written ? StoredCopy::State::STORED : StoredCopy::State::FAILED;
+                self->settled_.notify_all();
+            }
+        }
+        if (--self->pending_ == 0) {
+            self->idle_.notify_all();
+        }
+    });
+}
+
+bool ImageWriteBatch::write(const cv::Mat& image, const std::string& filePath, std::string& key,
+                            const std::optional<ContentDigest>& cacheKey) {
+    ImageWriter::EncodedCache* cache = cacheKey ? writer_.encodedCache() : nullptr;
+    std::shared_ptr<const std::vector<uint8_t>> bytes;
+    if (cache == nullptr || !cache->get(*cacheKey, bytes)) {
+        auto encoded = std::make_shared<std::vector<uint8_t>>();
+        if (!encoding_.encode(image, *encoded)) {
+            LOG_WARN("Failed to encode image {}", filePath);
+            return false;
+        }
+        if (cache != nullptr) {
+            cache->put(*cacheKey, encoded, encoded->size());
+        }
+        bytes = std::move(encoded);
+    }
+    bool written = true;
+    {
+        std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes->data()),
+                  static_cast<std::streamsize>(bytes->size()));
+        if (!out) {
+            LOG_WARN("Failed to write image {}", filePath);
+            written = false;
+        }
+    }
+    if (keepEncoded_ && !key.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        kept_.push_back(EncodedImage{std::move(key), *bytes});
+    }
+    return written;
+}
+
+std::vector<EncodedImage> ImageWriteBatch::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return pending_ == 0; });
+    std::vector<EncodedImage> images = std::move(kept_);
+    kept_.clear();
+    staged_.clear();
+    lock.unlock();
+
+    std::sort(images.begin(), images.end(),
+              [](const EncodedImage& a, const EncodedImage& b) { return a.path < b.path; });
+    return images;
+}
+
+} // namespace rapid_doc
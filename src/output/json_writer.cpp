@@ -0,0 +1,98 @@
+#include "output/json_writer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace rapid_doc {
+
+void appendJsonString(std::string& out, const std::string& value) {
+    static const char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (unsigned char c : value) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out.push_back(kHex[c >> 4]);
+                out.push_back(kHex[c & 0xF]);
+            } else {
+                out.push_back(static_cast<char>(c));
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+void appendJsonNumber(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    if (value == 0.0) {
+        out += std::signbit(value) ? "-0.0" : "0.0";
+        return;
+    }
+
+    // Shortest precision that round-trips, as "d.ddde<exp>"
+    char buf[32];
+    for (int precision = 0; precision < 17; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*e", precision, value);
+        if (std::strtod(buf, nullptr) == value) break;
+    }
+
+    const char* p = buf;
+    if (*p == '-') {
+        out.push_back('-');
+        ++p;
+    }
+    std::string digits;
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') digits.push_back(*p);
+    }
+    const int exponent = std::atoi(p + 1);
+
+    // Layout of nlohmann's dtoa format_buffer (min_exp = -4, max_exp = 15)
+    const int k = static_cast<int>(digits.size());
+    const int n = exponent + 1;  // position of the decimal point
+    if (k <= n && n <= 15) {
+        out += digits;
+        out.append(static_cast<size_t>(n - k), '0');
+        out += ".0";
+    } else if (0 < n && n <= 15) {
+        out.append(digits, 0, static_cast<size_t>(n));
+        out.push_back('.');
+        out.append(digits, static_cast<size_t>(n), std::string::npos);
+    } else if (-4 < n && n <= 0) {
+        out += "0.";
+        out.append(static_cast<size_t>(-n), '0');
+        out += digits;
+    } else {
+        out.push_back(digits[0]);
+        if (k > 1) {
+            out.push_back('.');
+            out.append(digits, 1, std::string::npos);
+        }
+        std::snprintf(buf, sizeof(buf), "e%c%02d", n - 1 < 0 ? '-' : '+', std::abs(n - 1));
+        out += buf;
+    }
+}
+
+void appendJsonNumber(std::string& out, long long value) {
+    out += std::to_string(value);
+}
+
+void appendJsonNewline(std::string& out, int indent, int level) {
+    if (indent <= 0) return;
+    out.push_back('\n');
+    out.append(static_cast<size_t>(indent * level), ' ');
+}
+
+} // namespace rapid_doc
@@ -1,5 +1,5 @@
 #include "output/markdown_writer.h"
-#include <sstream>
+#include <utility>
 
 namespace rapid_doc {
 
@@ -55,23 +55,33 @@ std::string MarkdownWriter::elementToMarkdown(const ContentElement& elem) const
     }
 }
 
-std::string MarkdownWriter::generate(const DocumentResult& result) const {
-    std::ostringstream out;
-
-    for (size_t pi = 0; pi < result.pages.size(); ++pi) {
-        const auto& page = result.pages[pi];
+void MarkdownWriter::appendPage(const PageResult& page, bool firstPage, std::string& out) const {
+    if (!firstPage)
+        out += "\n---\n\n";
 
-        if (result.pages.size() > 1 && pi > 0)
-            out << "\n---\n\n";
+    for (const auto& elem : page.elements) {
+        out += elementToMarkdown(elem);
+    }
+}
 
-        for (const auto& elem : page.elements) {
-            std::string md = elementToMarkdown(elem);
-            if (!md.empty())
-                out << md;
-        }
+std::string MarkdownWriter::generate(const DocumentResult& result) const {
+    std::string out;
+    for (size_t pi = 0; pi < result.pages.size(); ++pi) {
+        appendPage(result.pages[pi], pi == 0, out);
     }
+    return out;
+}
+
+MarkdownStream::MarkdownStream(OutputSink sink)
+    : sink_(std::move(sink))
+{}
 
-    return out.str();
+void MarkdownStream::appendPage(const PageResult& page) {
+    buffer_.clear();
+    writer_.appendPage(page, pages_ == 0, buffer_);
+    ++pages_;
+    if (!buffer_.empty())
+        sink_(buffer_.data(), buffer_.size());
 }
 
 } // namespace rapid_doc
@@ -0,0 +1,157 @@
+#include "output/result_json.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace rapid_doc {
+
+using json = nlohmann::json;
+
+std::string contentElementTypeToString(ContentElement::Type type) {
+    switch (type) {
+        case ContentElement::Type::TEXT: return "text";
+        case ContentElement::Type::TITLE: return "title";
+        case ContentElement::Type::IMAGE: return "image";
+        case ContentElement::Type::TABLE: return "table";
+        case ContentElement::Type::EQUATION: return "equation";
+        case ContentElement::Type::CODE: return "code";
+        case ContentElement::Type::LIST: return "list";
+        case ContentElement::Type::HEADER: return "header";
+        case ContentElement::Type::FOOTER: return "footer";
+        case ContentElement::Type::REFERENCE: return "reference";
+        default: return "unknown";
+    }
+}
+
+json buildContentListJson(const DocumentResult& result) {
+    json doc = json::array();
+    for (const auto& page : result.pages) {
+        json pageArr = json::array();
+        for (const auto& elem : page.elements) {
+            json item{
+                {"type", contentElementTypeToString(elem.type)},
+                {"text", elem.text},
+                {"page", elem.pageIndex},
+                {"order", elem.readingOrder},
+                {"skipped", elem.skipped},
+                {"bbox", {elem.layoutBox.x0, elem.layoutBox.y0, elem.layoutBox.x1, elem.layoutBox.y1}},
+            };
+            if (!elem.html.empty()) {
+                item["html"] = elem.html;
+            }
+            if (!elem.imagePath.empty()) {
+                item["image_path"] = elem.imagePath;
+            }
+            pageArr.push_back(std::move(item));
+        }
+        doc.push_back(std::move(pageArr));
+    }
+    return doc;
+}
+
+json buildMiddleJson(const DocumentResult& result) {
+    json pdfInfo = json::array();
+
+    for (const auto& page : result.pages) {
+        json elements = json::array();
+        for (const auto& elem : page.elements) {
+            json item{
+                {"type", contentElementTypeToString(elem.type)},
+                {"bbox", {elem.layoutBox.x0, elem.layoutBox.y0, elem.layoutBox.x1, elem.layoutBox.y1}},
+                {"score", elem.confidence},
+                {"page_idx", elem.pageIndex},
+                {"reading_order", elem.readingOrder},
+                {"skipped", elem.skipped},
+            };
+            if (!elem.text.empty()) {
+                item["text"] = elem.text;
+            }
+            if (!elem.html.empty()) {
+                item["html"] = elem.html;
+            }
+            if (!elem.imagePath.empty()) {
+                item["image_path"] = elem.imagePath;
+            }
+            elements.push_back(std::move(item));
+        }
+
+        json pageInfo{
+            {"page_idx", page.pageIndex},
+            {"page_size", {page.pageWidth, page.pageHeight}},
+            {"elements", std::move(elements)},
+        };
+        if (page.blank) {
+            pageInfo["blank"] = true;
+        }
+        pdfInfo.push_back(std::move(pageInfo));
+    }
+
+    return json{{"pdf_info", std::move(pdfInfo)}};
+}
+
+json buildModelJson(const DocumentResult& result) {
+    json pages = json::array();
+
+    for (const auto& page : result.pages) {
+        json layoutDetections = json::array();
+        for (const auto& box : page.layoutResult.boxes) {
+            layoutDetections.push_back(json{
+                {"category_id", box.clsId >= 0 ? box.clsId : static_cast<int>(box.category)},
+                {"label", box.label.empty() ? layoutCategoryToString(box.category) : box.label},
+                {"poly", {
+                    static_cast<int>(box.x0), static_cast<int>(box.y0),
+                    static_cast<int>(box.x1), static_cast<int>(box.y0),
+                    static_cast<int>(box.x1), static_cast<int>(box.y1),
+                    static_cast<int>(box.x0), static_cast<int>(box.y1)
+                }},
+                {"bbox", {box.x0, box.y0, box.x1, box.y1}},
+                {"score", box.confidence},
+            });
+        }
+
+        pages.push_back(json{
+            {"layout_dets", std::move(layoutDetections)},
+            {"page_info", {
+                {"page_no", page.pageIndex},
+                {"width", page.pageWidth},
+                {"height", page.pageHeight},
+            }},
+        });
+    }
+
+    return pages;
+}
+
+bool parseResultFormat(const std::string& name, ResultFormat& format) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "json") {
+        format = ResultFormat::JSON;
+        return true;
+    }
+    if (lower == "cbor") {
+        format = ResultFormat::CBOR;
+        return true;
+    }
+    return false;
+}
+
+std::string encodeResult(const json& value, ResultFormat format, int indent) {
+    if (format == ResultFormat::CBOR) {
+        std::string bytes;
+        json::to_cbor(value, bytes);
+        return bytes;
+    }
+    return value.dump(indent);
+}
+
+const char* resultFormatMimeType(ResultFormat format) {
+    return format == ResultFormat::CBOR ? "application/cbor" : "application/json";
+}
+
+const char* resultFormatExtension(ResultFormat format) {
+    return format == ResultFormat::CBOR ? ".cbor" : ".json";
+}
+
+} // namespace rapid_doc
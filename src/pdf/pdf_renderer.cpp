@@ -7,19 +7,290 @@
 
 #include "pdf/pdf_renderer.h"
 #include "common/logger.h"
+#include "common/trace.h"
 
 #include <poppler/cpp/poppler-document.h>
 #include <poppler/cpp/poppler-page.h>
 #include <poppler/cpp/poppler-page-renderer.h>
 #include <poppler/cpp/poppler-image.h>
 
-#include <fstream>
 #include <filesystem>
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace rapid_doc {
 
+namespace {
+
+/**
+ * Read-only memory mapping of a whole file; poppler reads straight from the
+ * page cache instead of a heap copy of the PDF.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            return;
+        }
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0 || st.st_size <= 0) {
+            return;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr == MAP_FAILED) {
+            size_ = 0;
+            return;
+        }
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(addr);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    int fd_ = -1;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+std::unique_ptr<poppler::document> loadDocument(const uint8_t* data, size_t size) {
+    return std::unique_ptr<poppler::document>(
+        poppler::document::load_from_raw_data(
+            reinterpret_cast<const char*>(data), static_cast<int>(size)));
+}
+
+/**
+ * Colour-convert a poppler image into @p out (BGR). The conversion is the only
+ * copy: it writes straight into the Mat's own buffer, which then travels by
+ * refcount to the NPU stages.
+ */
+void toBgr(const poppler::image& img, cv::Mat& out) {
+    const int imgW = img.width();
+    const int imgH = img.height();
+    const int bpr  = img.bytes_per_row();
+    const char* raw = img.const_data();
+
+    // The wrappers below alias poppler's buffer and must not outlive img.
+    if (img.format() == poppler::image::format_rgb24) {
+        cv::Mat rgb(imgH, imgW, CV_8UC3, const_cast<char*>(raw), bpr);
+        cv::cvtColor(rgb, out, cv::COLOR_RGB2BGR);
+    } else {
+        cv::Mat bgra(imgH, imgW, CV_8UC4, const_cast<char*>(raw), bpr);
+        cv::cvtColor(bgra, out, cv::COLOR_BGRA2BGR);
+    }
+}
+
+void setRenderHints(poppler::page_renderer& renderer) {
+    renderer.set_render_hint(poppler::page_renderer::antialiasing, true);
+    renderer.set_render_hint(poppler::page_renderer::text_antialiasing, true);
+}
+
+/**
+ * Re-rasterizes regions of one document's pages at the full DPI, after the
+ * pages themselves were rendered at the layout DPI. One instance serves every
+ * page of a render call, possibly after the call returned, and holds
+ * @p keepAlive, the file mapping, when there is one. poppler::document is not
+ * thread-safe, so it keeps up to @p slots documents (opened on first use),
+ * each behind its own lock: concurrent region renders of the document, from
+ * the recognition threads of every pipeline sharing it, only wait once all
+ * slots are busy.
+ */
+class RegionRenderer {
+public:
+    RegionRenderer(const uint8_t* data, size_t size, std::shared_ptr<const void> keepAlive,
+                   std::string traceId, int slots)
+        : keepAlive_(std::move(keepAlive)), data_(data), size_(size), traceId_(std::move(traceId))
+        , slotCount_(static_cast<size_t>(std::max(1, slots)))
+        , slots_(std::make_unique<Slot[]>(slotCount_)) {
+        for (size_t i = 0; i < slotCount_; ++i) {
+            setRenderHints(slots_[i].renderer);
+        }
+    }
+
+    /// @p roi in pixels of the page at dpi / @p scale
+    cv::Mat render(int pageNo, const cv::Rect& roi, double scale, int dpi) {
+        TRACE_SPAN("PdfRenderer::renderRegion", "pdf", traceDetail(traceId_, pageNo));
+        const cv::Rect region = scaledRegion(roi, scale);
+        if (region.width <= 0 || region.height <= 0) {
+            return {};
+        }
+
+        // Take the first free slot from a rotating start; wait only when all are busy.
+        const size_t start = nextSlot_.fetch_add(1, std::memory_order_relaxed) % slotCount_;
+        std::unique_lock<std::mutex> lock;
+        Slot* slot = nullptr;
+        for (size_t k = 0; k < slotCount_ && slot == nullptr; ++k) {
+            Slot& candidate = slots_[(start + k) % slotCount_];
+            std::unique_lock<std::mutex> attempt(candidate.mutex, std::try_to_lock);
+            if (attempt.owns_lock()) {
+                lock = std::move(attempt);
+                slot = &candidate;
+            }
+        }
+        if (slot == nullptr) {
+            slot = &slots_[start];
+            lock = std::unique_lock<std::mutex>(slot->mutex);
+        }
+
+        if (!slot->doc) {
+            slot->doc = loadDocument(data_, size_);
+            if (!slot->doc) {
+                LOG_WARN("Region render: failed to load document");
+                return {};
+            }
+        }
+        // Regions arrive page by page, so keep the last page open.
+        if (pageNo != slot->pageNo) {
+            slot->page.reset(slot->doc->create_page(pageNo));
+            slot->pageNo = pageNo;
+        }
+        if (!slot->page) {
+            return {};
+        }
+
+        poppler::image img = slot->renderer.render_page(
+            slot->page.get(), dpi, dpi, region.x, region.y, region.width, region.height);
+        if (!img.is_valid()) {
+            LOG_WARN("Region render failed on page {}", pageNo);
+            return {};
+        }
+        cv::Mat out;
+        toBgr(img, out);
+        return out;
+    }
+
+private:
+    struct Slot {
+        std::mutex mutex;
+        std::unique_ptr<poppler::document> doc;
+        std::unique_ptr<poppler::page> page;
+        int pageNo = -1;
+        poppler::page_renderer renderer;
+    };
+
+    const std::shared_ptr<const void> keepAlive_;
+    const uint8_t* data_;
+    const size_t size_;
+    const std::string traceId_;
+
+    const size_t slotCount_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> nextSlot_{0};
+};
+
+/// Words of @p page's text layer, scaled from points to pixels at @p scale.
+std::vector<TextSpan> extractTextLayer(const poppler::page& page, double scale) {
+    std::vector<TextSpan> spans;
+    for (const poppler::text_box& word : page.text_list()) {
+        const poppler::rectf box = word.bbox();
+        const poppler::byte_array utf8 = word.text().to_utf8();
+        TextSpan span;
+        span.x0 = static_cast<float>(box.left() * scale);
+        span.y0 = static_cast<float>(box.top() * scale);
+        span.x1 = static_cast<float>(box.right() * scale);
+        span.y1 = static_cast<float>(box.bottom() * scale);
+        span.text.assign(utf8.begin(), utf8.end());
+        spans.push_back(std::move(span));
+    }
+    return spans;
+}
+
+/**
+ * Rasterize one page into a BGR PageImage.
+ * Only touches @p doc, so callers may render concurrently on separate documents.
+ * With @p regions set the page is rendered at config.layoutDpi and gets a
+ * renderRegion for OCR/table crops at config.dpi.
+ */
+bool renderPage(
+    poppler::document& doc,
+    int pageNo,
+    const PdfRenderConfig& config,
+    const std::shared_ptr<RegionRenderer>& regions,
+    PageImage& out)
+{
+    TRACE_SPAN("PdfRenderer::renderPage", "pdf", traceDetail(config.traceId, pageNo));
+    const int dpi = config.dpi;
+    std::unique_ptr<poppler::page> page(doc.create_page(pageNo));
+    if (!page) {
+        LOG_WARN("Failed to create page {}", pageNo);
+        return false;
+    }
+
+    poppler::rectf rect = page->page_rect();
+    const int renderDpi = regions ? config.layoutDpi : dpi;
+
+    poppler::page_renderer renderer;
+    setRenderHints(renderer);
+    poppler::image img = renderer.render_page(page.get(), renderDpi, renderDpi);
+    if (!img.is_valid()) {
+        LOG_WARN("Failed to render page {}", pageNo);
+        return false;
+    }
+    toBgr(img, out.image);
+
+    out.pageIndex   = pageNo;
+    out.dpi         = renderDpi;
+    out.scaleFactor = renderDpi / 72.0;
+    out.pdfWidth    = static_cast<int>(rect.width());
+    out.pdfHeight   = static_cast<int>(rect.height());
+    if (regions) {
+        const double scale = static_cast<double>(dpi) / renderDpi;
+        out.regionScale = scale;
+        out.renderRegion = [regions, pageNo, scale, dpi](const cv::Rect& roi) {
+            return regions->render(pageNo, roi, scale, dpi);
+        };
+    }
+    // text_list() reports unrotated page space; rotated pages are left to OCR.
+    if (config.extractTextLayer && page->orientation() == poppler::page::portrait) {
+        out.textLayer = extractTextLayer(*page, out.scaleFactor);
+    }
+
+    LOG_DEBUG("Page {}: {}x{} px at {} dpi (pdf {}x{} pt)", pageNo, out.image.cols,
+              out.image.rows, renderDpi, out.pdfWidth, out.pdfHeight);
+    return true;
+}
+
+/// Inclusive page range @p config selects from a document; false if it is empty.
+bool selectPageRange(const PdfRenderConfig& config, int totalPages, int& startPage, int& endPage) {
+    startPage = std::max(0, config.startPageId);
+    endPage = (config.endPageId < 0)
+                  ? (totalPages - 1)
+                  : std::min(config.endPageId, totalPages - 1);
+    if (config.maxPages > 0) {
+        endPage = std::min(endPage, startPage + config.maxPages - 1);
+    }
+    return startPage < totalPages && endPage >= startPage;
+}
+
+} // namespace
+
 struct PdfRenderer::Impl {
     // stateless — each call creates its own poppler objects
 };
@@ -32,63 +303,84 @@ PdfRenderer::PdfRenderer(const PdfRenderConfig& config)
 PdfRenderer::~PdfRenderer() = default;
 
 std::vector<PageImage> PdfRenderer::renderFile(const std::string& pdfPath) {
+    std::vector<PageImage> results;
+    renderFileEach(pdfPath, [&results](PageImage&& page, int pagesPlanned) {
+        if (results.empty()) {
+            results.reserve(static_cast<size_t>(pagesPlanned));
+        }
+        results.push_back(std::move(page));
+        return true;
+    });
+    return results;
+}
+
+std::vector<PageImage> PdfRenderer::renderFromMemory(const uint8_t* data, size_t size) {
+    std::vector<PageImage> results;
+    renderEach(data, size, [&results](PageImage&& page, int pagesPlanned) {
+        if (results.empty()) {
+            results.reserve(static_cast<size_t>(pagesPlanned));
+        }
+        results.push_back(std::move(page));
+        return true;
+    });
+    return results;
+}
+
+int PdfRenderer::renderFileEach(const std::string& pdfPath, const PageCallback& onPage) {
     LOG_INFO("PDF render: loading file {}", pdfPath);
 
     if (!std::filesystem::exists(pdfPath)) {
         LOG_ERROR("PDF file not found: {}", pdfPath);
-        return {};
+        return 0;
     }
 
-    std::ifstream file(pdfPath, std::ios::binary);
-    if (!file.is_open()) {
+    // Shared so region renders of pages still in flight keep the mapping.
+    auto file = std::make_shared<MappedFile>(pdfPath);
+    if (!file->valid()) {
         LOG_ERROR("Cannot open PDF file: {}", pdfPath);
-        return {};
+        return 0;
     }
 
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    std::vector<uint8_t> data(size);
-    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size));
+    return renderDocument(file->data(), file->size(), file, onPage);
+}
 
-    return renderFromMemory(data.data(), data.size());
+int PdfRenderer::renderEach(const uint8_t* data, size_t size, const PageCallback& onPage) {
+    return renderDocument(data, size, nullptr, onPage);
 }
 
-std::vector<PageImage> PdfRenderer::renderFromMemory(const uint8_t* data, size_t size) {
-    LOG_INFO("PDF render: {} bytes, dpi={}", size, config_.dpi);
+int PdfRenderer::renderDocument(
+    const uint8_t* data,
+    size_t size,
+    std::shared_ptr<const void> keepAlive,
+    const PageCallback& onPage)
+{
+    const bool twoResolution = config_.layoutDpi > 0 && config_.layoutDpi < config_.dpi;
+    if (twoResolution) {
+        LOG_INFO("PDF render: {} bytes, dpi={} (OCR/table regions at {})",
+                 size, config_.layoutDpi, config_.dpi);
+    } else {
+        LOG_INFO("PDF render: {} bytes, dpi={}", size, config_.dpi);
+    }
 
-    std::unique_ptr<poppler::document> doc(
-        poppler::document::load_from_raw_data(
-            reinterpret_cast<const char*>(data), static_cast<int>(size)));
+    std::unique_ptr<poppler::document> doc = loadDocument(data, size);
 
     if (!doc) {
         LOG_ERROR("Failed to load PDF document");
-        return {};
+        return 0;
     }
 
     if (doc->is_locked()) {
         LOG_ERROR("PDF is password protected");
-        return {};
+        return 0;
     }
 
     int totalPages = doc->pages();
-    int startPage = std::max(0, config_.startPageId);
-    if (startPage >= totalPages) {
-        LOG_WARN("Start page {} exceeds total pages {}", startPage, totalPages);
-        return {};
-    }
-
-    int endPage = (config_.endPageId < 0)
-                      ? (totalPages - 1)
-                      : std::min(config_.endPageId, totalPages - 1);
-    if (endPage < startPage) {
-        LOG_WARN("Invalid page range: start={}, end={}", startPage, endPage);
-        return {};
-    }
-
-    if (config_.maxPages > 0) {
-        endPage = std::min(endPage, startPage + config_.maxPages - 1);
+    int startPage = 0;
+    int endPage = 0;
+    if (!selectPageRange(config_, totalPages, startPage, endPage)) {
+        LOG_WARN("Empty page range: start={}, end={}, total pages {}",
+                 config_.startPageId, config_.endPageId, totalPages);
+        return 0;
     }
 
     int pagesToRender = endPage - startPage + 1;
@@ -96,74 +388,147 @@ std::vector<PageImage> PdfRenderer::renderFromMemory(const uint8_t* data, size_t
     LOG_INFO("PDF: {} total pages, rendering {} pages ({}-{})",
              totalPages, pagesToRender, startPage, endPage);
 
-    std::vector<PageImage> results;
-    results.reserve(pagesToRender);
+    std::shared_ptr<RegionRenderer> regions;
+    if (twoResolution) {
+        regions = std::make_shared<RegionRenderer>(data, size, std::move(keepAlive),
+                                                   config_.traceId, config_.maxConcurrentRenders);
+    }
 
-    for (int pageNo = startPage; pageNo <= endPage; ++pageNo) {
-        std::unique_ptr<poppler::page> page(doc->create_page(pageNo));
-        if (!page) {
-            LOG_WARN("Failed to create page {}", pageNo);
-            continue;
+    const int workers = std::min(std::max(1, config_.maxConcurrentRenders), pagesToRender);
+    if (workers <= 1) {
+        int delivered = 0;
+        for (int pageNo = startPage; pageNo <= endPage; ++pageNo) {
+            PageImage pi;
+            if (!renderPage(*doc, pageNo, config_, regions, pi)) {
+                continue;
+            }
+            ++delivered;
+            if (!onPage(std::move(pi), pagesToRender)) {
+                LOG_DEBUG("PDF render stopped by consumer after page {}", pageNo);
+                break;
+            }
         }
+        return delivered;
+    }
 
-        poppler::rectf rect = page->page_rect();
-
-        poppler::page_renderer renderer;
-        renderer.set_render_hint(poppler::page_renderer::antialiasing, true);
-        renderer.set_render_hint(poppler::page_renderer::text_antialiasing, true);
-
-        poppler::image img = renderer.render_page(page.get(), config_.dpi, config_.dpi);
-        if (!img.is_valid()) {
-            LOG_WARN("Failed to render page {}", pageNo);
+    // Parallel path: poppler documents are not thread-safe, so every worker
+    // opens its own document over the shared (read-only) bytes. Workers claim
+    // page slots in order and may run at most `workers` slots ahead of the
+    // consumer; the calling thread hands pages to onPage strictly in order.
+    struct Slot {
+        bool done = false;
+        bool ok = false;
+        PageImage page;
+    };
+    std::mutex mutex;
+    std::condition_variable slotReady;
+    std::condition_variable windowOpen;
+    std::map<int, Slot> slots;
+    int nextSlot = 0;
+    int emitted = 0;
+    bool stop = false;
+
+    auto worker = [&](std::unique_ptr<poppler::document> workerDoc) {
+        while (true) {
+            int slot = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowOpen.wait(lock, [&]() {
+                    return stop || nextSlot >= pagesToRender || nextSlot < emitted + workers;
+                });
+                if (stop || nextSlot >= pagesToRender) {
+                    return;
+                }
+                slot = nextSlot++;
+            }
+
+            Slot rendered;
+            rendered.done = true;
+            rendered.ok = workerDoc &&
+                          renderPage(*workerDoc, startPage + slot, config_, regions,
+                                     rendered.page);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[slot] = std::move(rendered);
+            slotReady.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(static_cast<size_t>(workers));
+    pool.emplace_back(worker, std::move(doc));
+    for (int i = 1; i < workers; ++i) {
+        std::unique_ptr<poppler::document> workerDoc = loadDocument(data, size);
+        if (!workerDoc) {
+            LOG_WARN("PDF render worker {} failed to load document", i);
             continue;
         }
+        pool.emplace_back(worker, std::move(workerDoc));
+    }
 
-        int imgW = img.width();
-        int imgH = img.height();
-        int bpr  = img.bytes_per_row();
-        const char* raw = img.const_data();
-        auto fmt = img.format();
-
-        cv::Mat bgr;
-        if (fmt == poppler::image::format_argb32) {
-            cv::Mat bgra(imgH, imgW, CV_8UC4, const_cast<char*>(raw), bpr);
-            cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
-        } else if (fmt == poppler::image::format_rgb24) {
-            cv::Mat rgb(imgH, imgW, CV_8UC3, const_cast<char*>(raw), bpr);
-            cv::cvtColor(rgb, bgr, cv::COLOR_RGB2BGR);
-        } else {
-            cv::Mat bgra(imgH, imgW, CV_8UC4, const_cast<char*>(raw), bpr);
-            cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
+    auto stopWorkers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        windowOpen.notify_all();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    };
+
+    int delivered = 0;
+    try {
+        for (int slot = 0; slot < pagesToRender; ++slot) {
+            Slot ready;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotReady.wait(lock, [&]() {
+                    auto it = slots.find(slot);
+                    return it != slots.end() && it->second.done;
+                });
+                ready = std::move(slots[slot]);
+                slots.erase(slot);
+                emitted = slot + 1;
+            }
+            windowOpen.notify_all();
+
+            if (!ready.ok) {
+                continue;
+            }
+            ++delivered;
+            if (!onPage(std::move(ready.page), pagesToRender)) {
+                LOG_DEBUG("PDF render stopped by consumer after page {}", startPage + slot);
+                break;
+            }
         }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+    stopWorkers();
 
-        PageImage pi;
-        pi.image       = bgr.clone();
-        pi.pageIndex   = pageNo;
-        pi.dpi         = config_.dpi;
-        pi.scaleFactor = config_.dpi / 72.0;
-        pi.pdfWidth    = static_cast<int>(rect.width());
-        pi.pdfHeight   = static_cast<int>(rect.height());
+    return delivered;
+}
 
-        results.push_back(std::move(pi));
-        LOG_DEBUG("Page {}: {}x{} px (pdf {}x{} pt)", pageNo, imgW, imgH,
-                  pi.pdfWidth, pi.pdfHeight);
+int PdfRenderer::countSelectedPages(const uint8_t* data, size_t size) {
+    std::unique_ptr<poppler::document> doc = loadDocument(data, size);
+    if (!doc || doc->is_locked()) {
+        return 0;
     }
-
-    return results;
+    int startPage = 0;
+    int endPage = 0;
+    if (!selectPageRange(config_, doc->pages(), startPage, endPage)) {
+        return 0;
+    }
+    return endPage - startPage + 1;
 }
 
 int PdfRenderer::getPageCount(const std::string& pdfPath) {
-    std::ifstream file(pdfPath, std::ios::binary);
-    if (!file.is_open()) return -1;
-
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    std::vector<char> data(size);
-    file.read(data.data(), static_cast<std::streamsize>(size));
+    MappedFile file(pdfPath);
+    if (!file.valid()) return -1;
 
-    std::unique_ptr<poppler::document> doc(
-        poppler::document::load_from_raw_data(data.data(), static_cast<int>(size)));
+    std::unique_ptr<poppler::document> doc = loadDocument(file.data(), file.size());
     return doc ? doc->pages() : -1;
 }
 
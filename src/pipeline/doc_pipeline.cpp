@@ -9,12 +9,26 @@
 #include "pipeline/doc_pipeline.h"
 #include "common/logger.h"
 #include "common/perf_utils.h"
+#include "common/bounded_queue.h"
+#include "common/cpu_affinity.h"
+#include "common/text_layer.h"
+#include "common/trace.h"
+#include "pipeline/blank_page.h"
 #include <filesystem>
 #include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
 #include <thread>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
 #include <iomanip>
+#include <map>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 
@@ -30,12 +44,27 @@ void finalizeDocumentStats(DocumentResult& result) {
     result.stats.outputGenTimeMs = outputGenTimeMs;
 }
 
+PdfRenderConfig makePdfRenderConfig(const RuntimeConfig& runtime, const std::string& traceId = {}) {
+    PdfRenderConfig pdfCfg;
+    pdfCfg.traceId = traceId;
+    pdfCfg.dpi = runtime.pdfDpi;
+    pdfCfg.layoutDpi = runtime.layoutDpi;
+    pdfCfg.extractTextLayer = runtime.useTextLayer;
+    pdfCfg.maxPages = runtime.maxPages;
+    pdfCfg.startPageId = runtime.startPageId;
+    pdfCfg.endPageId = runtime.endPageId;
+    pdfCfg.maxConcurrentRenders = runtime.maxConcurrentPages;
+    return pdfCfg;
+}
+
 struct OcrWorkItem {
     LayoutBox box;
     ContentElement::Type type = ContentElement::Type::TEXT;
     int pageIndex = 0;
     float confidence = 0.0f;
-    cv::Mat crop;
+    cv::Rect roi;               // of box, clipped to the page image
+    cv::Mat crop;               // empty when the text layer answered; a page view until re-rendered
+    std::optional<std::string> layerText;
     bool skipped = false;
 };
 
@@ -50,6 +79,7 @@ struct TableWorkItem {
     LayoutBox box;
     int pageIndex = 0;
     cv::Mat crop;
+    cv::Mat ocrCrop;  // contiguous copy for crop-mode OCR
     bool invalidRoi = false;
 };
 
@@ -64,11 +94,49 @@ struct TableNpuResult {
     std::vector<ocr::PipelineOCRResult> ocrBoxes;
 };
 
+/**
+ * Crop of @p roi for the OCR/table engines: re-rendered at the OCR DPI on
+ * two-resolution pages, otherwise a view into the page image (which outlives
+ * every work item built from it).
+ */
+cv::Mat regionCrop(const PageImage& page, const cv::Rect& roi) {
+    if (page.renderRegion) {
+        cv::Mat crop = page.renderRegion(roi);
+        if (!crop.empty()) {
+            return crop;
+        }
+    }
+    return page.image(roi);
+}
+
+/**
+ * Recognition-cache key of a text region. A region the page re-renders at
+ * the OCR DPI is keyed by its layout-DPI pixels and the scale, so a hit
+ * needs no re-render; others by the crop the OCR engine reads.
+ */
+ContentDigest regionDigest(const PageImage& page, const cv::Mat& pageCrop) {
+    if (!page.renderRegion) {
+        return digestImage(pageCrop);
+    }
+    ContentHasher hasher;
+    const ContentDigest pixels = digestImage(pageCrop);
+    hasher.update(pixels.a);
+    hasher.update(pixels.b);
+    hasher.update(&page.regionScale, sizeof(page.regionScale));
+    return hasher.digest();
+}
+
+/**
+ * @param textLayer The page's text layer, or null to OCR every region
+ * Crops are views into the page image; regions still to be OCRed are
+ * re-rendered (see regionCrop) once the recognition cache has been asked.
+ */
 std::vector<OcrWorkItem> buildOcrWorkItems(
-    const cv::Mat& image,
-    const std::vector<LayoutBox>& textBoxes,
-    int pageIndex)
+    const PageImage& page,
+    LayoutBoxView textBoxes,
+    const TextLayerIndex* textLayer)
 {
+    const cv::Mat& image = page.image;
     std::vector<OcrWorkItem> items;
     items.reserve(textBoxes.size());
 
@@ -78,15 +146,17 @@ std::vector<OcrWorkItem> buildOcrWorkItems(
         item.type = (box.category == LayoutCategory::TITLE)
                         ? ContentElement::Type::TITLE
                         : ContentElement::Type::TEXT;
-        item.pageIndex = pageIndex;
+        item.pageIndex = page.pageIndex;
         item.confidence = box.confidence;
 
-        cv::Rect roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
-        if (roi.width <= 0 || roi.height <= 0) {
+        item.roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
+        std::string text;
+        if (item.roi.width <= 0 || item.roi.height <= 0) {
             item.skipped = true;
+        } else if (textLayer != nullptr && textLayer->textIn(box, text)) {
+            item.layerText = std::move(text);
         } else {
-            // CPU-only crop clone: safe outside NPU serial lock.
-            item.crop = image(roi).clone();
+            item.crop = image(item.roi);
         }
         items.push_back(std::move(item));
     }
@@ -104,6 +174,105 @@ std::string combineOcrTextLines(const std::vector<ocr::PipelineOCRResult>& ocrRe
     return combined;
 }
 
+/**
+ * Uniform grid over the cell rectangles of one table, so each OCR line is
+ * only tested against the cells sharing a bin with it instead of every cell.
+ */
+class TableCellGrid {
+public:
+    explicit TableCellGrid(const std::vector<TableCell>& cells) {
+        rects_.reserve(cells.size());
+        int minX = 0, minY = 0, maxX = 0, maxY = 0;
+        bool any = false;
+        for (const auto& c : cells) {
+            cv::Rect r(static_cast<int>(c.x0), static_cast<int>(c.y0),
+                       static_cast<int>(c.x1 - c.x0),
+                       static_cast<int>(c.y1 - c.y0));
+            rects_.push_back(r);
+            if (r.width <= 0 || r.height <= 0) {
+                continue;
+            }
+            minX = any ? std::min(minX, r.x) : r.x;
+            minY = any ? std::min(minY, r.y) : r.y;
+            maxX = any ? std::max(maxX, r.x + r.width) : r.x + r.width;
+            maxY = any ? std::max(maxY, r.y + r.height) : r.y + r.height;
+            any = true;
+        }
+        if (!any) {
+            return;
+        }
+
+        const int side = std::clamp(
+            static_cast<int>(std::ceil(std::sqrt(static_cast<double>(cells.size())))), 1, 64);
+        originX_ = minX;
+        originY_ = minY;
+        cols_ = side;
+        rows_ = side;
+        binW_ = std::max(1, (maxX - minX + side - 1) / side);
+        binH_ = std::max(1, (maxY - minY + side - 1) / side);
+        bins_.resize(static_cast<size_t>(cols_ * rows_));
+        for (size_t ci = 0; ci < rects_.size(); ++ci) {
+            const cv::Rect& r = rects_[ci];
+            if (r.width <= 0 || r.height <= 0) {
+                continue;
+            }
+            forEachBin(r, [&](size_t bin) { bins_[bin].push_back(static_cast<int>(ci)); });
+        }
+    }
+
+    const cv::Rect& rect(int ci) const { return rects_[static_cast<size_t>(ci)]; }
+
+    /// Cells that may intersect @p query, in ascending cell order.
+    void candidates(const cv::Rect& query, std::vector<int>& out) const {
+        out.clear();
+        if (bins_.empty() || query.width <= 0 || query.height <= 0) {
+            return;
+        }
+        forEachBin(query, [&](size_t bin) {
+            out.insert(out.end(), bins_[bin].begin(), bins_[bin].end());
+        });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+private:
+    template <typename Fn>
+    void forEachBin(const cv::Rect& r, Fn&& fn) const {
+        const int bx0 = std::clamp((r.x - originX_) / binW_, 0, cols_ - 1);
+        const int by0 = std::clamp((r.y - originY_) / binH_, 0, rows_ - 1);
+        const int bx1 = std::clamp((r.x + r.width - 1 - originX_) / binW_, 0, cols_ - 1);
+        const int by1 = std::clamp((r.y + r.height - 1 - originY_) / binH_, 0, rows_ - 1);
+        for (int by = by0; by <= by1; ++by) {
+            for (int bx = bx0; bx <= bx1; ++bx) {
+                fn(static_cast<size_t>(by * cols_ + bx));
+            }
+        }
+    }
+
+    std::vector<cv::Rect> rects_;
+    std::vector<std::vector<int>> bins_;
+    int originX_ = 0;
+    int originY_ = 0;
+    int cols_ = 0;
+    int rows_ = 0;
+    int binW_ = 1;
+    int binH_ = 1;
+};
+
+/// Point each staged region crop of @p elements at its stored copy (see saveRegionImages)
+void claimRegionImages(ImageWriteBatch* images, std::vector<ContentElement>& elements) {
+    if (images == nullptr) {
+        return;
+    }
+    for (auto& elem : elements) {
+        if (!elem.imagePath.empty()) {
+            elem.imagePath = images->claim(elem.imagePath);
+        }
+    }
+}
+
+} // namespace
+
 void matchTableOcrToCells(
     TableResult& tableResult,
     const std::vector<ocr::PipelineOCRResult>& ocrBoxes)
@@ -112,6 +281,8 @@ void matchTableOcrToCells(
         return;
     }
 
+    const TableCellGrid grid(tableResult.cells);
+    std::vector<int> candidates;
     for (const auto& ocrRes : ocrBoxes) {
         if (ocrRes.text.empty()) {
             continue;
@@ -121,12 +292,9 @@ void matchTableOcrToCells(
         int bestCell = -1;
         float bestOverlap = 0.0f;
 
-        for (size_t ci = 0; ci < tableResult.cells.size(); ++ci) {
-            auto& c = tableResult.cells[ci];
-            cv::Rect cellRect(static_cast<int>(c.x0), static_cast<int>(c.y0),
-                              static_cast<int>(c.x1 - c.x0),
-                              static_cast<int>(c.y1 - c.y0));
-            cv::Rect inter = ocrRect & cellRect;
+        grid.candidates(ocrRect, candidates);
+        for (int ci : candidates) {
+            cv::Rect inter = ocrRect & grid.rect(ci);
             if (inter.width <= 0 || inter.height <= 0) {
                 continue;
             }
@@ -135,7 +303,7 @@ void matchTableOcrToCells(
             float overlap = interArea / ocrArea;
             if (overlap > bestOverlap) {
                 bestOverlap = overlap;
-                bestCell = static_cast<int>(ci);
+                bestCell = ci;
             }
         }
 
@@ -149,10 +317,67 @@ void matchTableOcrToCells(
     }
 }
 
-} // namespace
+struct DocPipeline::PageWork {
+    PageImage page;
+    PageResult result;
+    size_t sequence = 0;        // producer order, for the post-processing stage's reordering
+
+    // Per-stage index spans into result.layoutResult.boxes, which stays
+    // untouched once layout is done.
+    LayoutBuckets buckets;
+
+    std::array<double, kNpuEngineCount> npuWaitMs{};
+    std::array<double, kNpuEngineCount> npuHoldMs{};
+    double npuSerialTotalMs = 0.0;
+    double cpuOnlyTotalMs = 0.0;
+    double activeTimeMs = 0.0;
+};
+
+DocPipeline::DocumentOutput::DocumentOutput(const ExecutionContext& ctx)
+    : images(ctx.imageWrites)
+{
+    if (ctx.markdownSink && ctx.stages.enableMarkdownOutput) {
+        markdown.emplace(ctx.markdownSink);
+    }
+    if (ctx.contentListSink) {
+        contentList.emplace(ctx.contentListSink);
+    }
+}
+
+void DocPipeline::DocumentOutput::appendPage(const PageResult& page) {
+    auto start = std::chrono::steady_clock::now();
+    if (markdown) markdown->appendPage(page);
+    if (contentList) contentList->appendPage(page);
+    elapsedMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void DocPipeline::DocumentOutput::addPage(PageResult&& page, DocumentResult& result) {
+    result.processedPages++;
+    if (forward) {
+        forward(std::move(page));
+        return;
+    }
+    // Pages arrive here in page order whatever order they finished in.
+    claimRegionImages(images.get(), page.elements);
+    appendPage(page);
+    result.pages.push_back(std::move(page));
+}
+
+void DocPipeline::DocumentOutput::finish(DocumentResult& result) {
+    auto start = std::chrono::steady_clock::now();
+    if (contentList) contentList->finish();
+    if (images) result.images = images->wait();
+    elapsedMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    result.stats.outputGenTimeMs = elapsedMs;
+}
 
 DocPipeline::DocPipeline(const PipelineConfig& config)
     : config_(config)
+    , npuScheduler_(makeNpuSchedulerConfig(config.runtime))
+    , pageBuffers_(std::make_unique<BufferPool>(
+          static_cast<size_t>(std::max(0, config.runtime.pageBufferPoolMb)) << 20))
 {
 }
 
@@ -175,81 +400,188 @@ bool DocPipeline::initialize() {
 
     // Initialize PDF renderer
     if (config_.stages.enablePdfRender) {
-        PdfRenderConfig pdfCfg;
-        pdfCfg.dpi = config_.runtime.pdfDpi;
-        pdfCfg.maxPages = config_.runtime.maxPages;
-        pdfCfg.startPageId = config_.runtime.startPageId;
-        pdfCfg.endPageId = config_.runtime.endPageId;
-        pdfCfg.maxConcurrentRenders = config_.runtime.maxConcurrentPages;
-        pdfRenderer_ = std::make_unique<PdfRenderer>(pdfCfg);
+        pdfRenderer_ = std::make_unique<PdfRenderer>(makePdfRenderConfig(config_.runtime));
         LOG_INFO("PDF renderer initialized");
     }
 
-    // Initialize Layout detector
-    if (config_.stages.enableLayout) {
-        LayoutDetectorConfig layoutCfg;
-        layoutCfg.dxnnModelPath = config_.models.layoutDxnnModel;
-        layoutCfg.onnxSubModelPath = config_.models.layoutOnnxSubModel;
-        layoutCfg.inputSize = config_.runtime.layoutInputSize;
-        layoutCfg.confThreshold = config_.runtime.layoutConfThreshold;
-        layoutCfg.deviceId = config_.runtime.deviceId;
-        layoutDetector_ = std::make_unique<LayoutDetector>(layoutCfg);
-        if (!layoutDetector_->initialize()) {
-            LOG_ERROR("Failed to initialize layout detector");
-            return false;
+    // Record / replay of engine outputs (pipeline/replay_store.h)
+    const bool replay = !config_.runtime.replayDir.empty();
+    try {
+        if (replay) {
+            replaySession_ = std::make_unique<ReplaySession>(
+                ReplayStore::open(config_.runtime.replayDir, ReplayStore::Mode::REPLAY),
+                config_.runtime.replayLatencyScale);
+        } else if (!config_.runtime.recordDir.empty()) {
+            replaySession_ = std::make_unique<ReplaySession>(
+                ReplayStore::open(config_.runtime.recordDir, ReplayStore::Mode::RECORD), 1.0);
         }
-        LOG_INFO("Layout detector initialized");
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to open replay store: {}", e.what());
+        return false;
+    }
+    if (replay) {
+        // The engines are stood in for by the recording; nothing touches the NPU.
+        ReplaySession* session = replaySession_.get();
+        if (config_.stages.enableLayout) {
+            layoutDetectHook_ = [session](const cv::Mat& page) { return session->detectLayout(page); };
+        }
+        if (config_.stages.enableWiredTable) {
+            tableRecognizeHook_ = [session](const cv::Mat& crop) { return session->recognizeTable(crop); };
+            // Unloaded: only the CPU-side HTML generation is used.
+            tableRecognizer_ = std::make_unique<TableRecognizer>(TableRecognizerConfig{});
+        }
+        if (config_.stages.enableOcr) {
+            ocrSubmitHook_ = [session](const cv::Mat& crop, int64_t taskId) {
+                return session->submitOcr(crop, taskId);
+            };
+            ocrFetchHook_ = [session](std::vector<ocr::PipelineOCRResult>& lines, int64_t& taskId, bool& success) {
+                return session->fetchOcr(lines, taskId, success);
+            };
+        }
+        LOG_INFO("Replaying engine outputs from {}", config_.runtime.replayDir);
+    }
+
+    // Each enabled model loads in its own task; they touch disjoint members.
+    std::vector<std::pair<const char*, std::function<bool()>>> modelLoads;
+
+    // Initialize Layout detector
+    if (config_.stages.enableLayout && !replay) {
+        modelLoads.emplace_back("layout detector", [this]() {
+            LayoutDetectorConfig layoutCfg;
+            layoutCfg.dxnnModelPath = config_.models.layoutDxnnModel;
+            layoutCfg.onnxSubModelPath = config_.models.layoutOnnxSubModel;
+            layoutCfg.inputSize = config_.runtime.layoutInputSize;
+            layoutCfg.confThreshold = config_.runtime.layoutConfThreshold;
+            layoutCfg.deviceId = config_.runtime.deviceId;
+            layoutCfg.batchSize = config_.runtime.layoutBatchSize;
+            layoutCfg.batchMaxDelayMs = config_.runtime.layoutBatchMaxDelayMs;
+            layoutCfg.fastResize = config_.runtime.layoutFastResize;
+            layoutCfg.ortIntraOpThreads = config_.runtime.layoutOrtIntraOpThreads;
+            layoutCfg.ortInterOpThreads = config_.runtime.layoutOrtInterOpThreads;
+            layoutCfg.ortOptimizationLevel = config_.runtime.layoutOrtOptLevel;
+            layoutCfg.ortOptimizedModelPath = config_.runtime.layoutOrtOptimizedModelPath;
+            layoutCfg.ortGlobalThreadPool = config_.runtime.layoutOrtGlobalThreadPool;
+            layoutDetector_ = std::make_unique<LayoutDetector>(layoutCfg);
+            // A batching detector takes the layout lane per batch it forms,
+            // so pages of concurrent requests can share one batch.
+            layoutDetector_->setBatchAdmission([this](const std::function<void()>& run) {
+                auto waitStart = std::chrono::steady_clock::now();
+                NpuScheduler::Ticket ticket;
+                {
+                    TRACE_SPAN("npu_wait", "npu", npuEngineName(NpuEngine::LAYOUT));
+                    ticket = npuScheduler().admit(NpuEngine::LAYOUT);
+                }
+                const double waitMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - waitStart).count();
+                TRACE_SPAN("npu_hold", "npu", npuEngineName(NpuEngine::LAYOUT));
+                run();
+                return waitMs;
+            });
+            if (!layoutDetector_->initialize()) {
+                return false;
+            }
+            LOG_INFO("Layout detector initialized");
+            return true;
+        });
     }
 
     // Initialize Table recognizer (wired tables only)
-    if (config_.stages.enableWiredTable) {
-        TableRecognizerConfig tableCfg;
-        tableCfg.unetDxnnModelPath = config_.models.tableUnetDxnnModel;
-        tableCfg.threshold = config_.runtime.tableConfThreshold;
-        tableCfg.deviceId = config_.runtime.deviceId;
-        tableRecognizer_ = std::make_unique<TableRecognizer>(tableCfg);
-        if (!tableRecognizer_->initialize()) {
-            LOG_ERROR("Failed to initialize table recognizer");
-            return false;
-        }
-        LOG_INFO("Table recognizer initialized (wired tables only)");
+    if (config_.stages.enableWiredTable && !replay) {
+        modelLoads.emplace_back("table recognizer", [this]() {
+            TableRecognizerConfig tableCfg;
+            tableCfg.unetDxnnModelPath = config_.models.tableUnetDxnnModel;
+            tableCfg.threshold = config_.runtime.tableConfThreshold;
+            tableCfg.deviceId = config_.runtime.deviceId;
+            tableRecognizer_ = std::make_unique<TableRecognizer>(tableCfg);
+            if (!tableRecognizer_->initialize()) {
+                return false;
+            }
+            LOG_INFO("Table recognizer initialized (wired tables only)");
+            return true;
+        });
     }
 
     // Initialize OCR pipeline (from DXNN-OCR-cpp)
-    if (config_.stages.enableOcr) {
-        ocr::OCRPipelineConfig ocrCfg;
-
-        // Detection model paths — use only 640 model to conserve NPU memory
-        ocrCfg.detectorConfig.model640Path = config_.models.ocrModelDir + "/det_v5_640.dxnn";
-        ocrCfg.detectorConfig.model960Path = "";
-        ocrCfg.detectorConfig.sizeThreshold = 99999;
-        ocrCfg.detectorConfig.deviceId = config_.runtime.deviceId;
-
-        // Recognition model paths
-        std::string mdir = config_.models.ocrModelDir;
-        ocrCfg.recognizerConfig.modelPaths = {
-            {3,  mdir + "/rec_v5_ratio_3.dxnn"},
-            {5,  mdir + "/rec_v5_ratio_5.dxnn"},
-            {10, mdir + "/rec_v5_ratio_10.dxnn"},
-            {15, mdir + "/rec_v5_ratio_15.dxnn"},
-            {25, mdir + "/rec_v5_ratio_25.dxnn"},
-            {35, mdir + "/rec_v5_ratio_35.dxnn"},
-        };
-        ocrCfg.recognizerConfig.dictPath = config_.models.ocrDictPath;
-        ocrCfg.recognizerConfig.deviceId = config_.runtime.deviceId;
-
-        // Disable heavy document-level preprocessing for per-region OCR
-        ocrCfg.useDocPreprocessing = false;
-        ocrCfg.useClassification = false;
-        ocrCfg.enableVisualization = false;
-
-        ocrPipeline_ = std::make_unique<ocr::OCRPipeline>(ocrCfg);
-        if (!ocrPipeline_->initialize()) {
-            LOG_ERROR("Failed to initialize OCR pipeline");
-            return false;
+    if (config_.stages.enableOcr && !replay) {
+        modelLoads.emplace_back("OCR pipeline", [this]() {
+            ocr::OCRPipelineConfig ocrCfg;
+
+            // Detection model paths — use only 640 model to conserve NPU memory
+            ocrCfg.detectorConfig.model640Path = config_.models.ocrModelDir + "/det_v5_640.dxnn";
+            ocrCfg.detectorConfig.model960Path = "";
+            ocrCfg.detectorConfig.sizeThreshold = 99999;
+            ocrCfg.detectorConfig.deviceId = config_.runtime.deviceId;
+
+            // Recognition model paths
+            std::string mdir = config_.models.ocrModelDir;
+            ocrCfg.recognizerConfig.modelPaths = {
+                {3,  mdir + "/rec_v5_ratio_3.dxnn"},
+                {5,  mdir + "/rec_v5_ratio_5.dxnn"},
+                {10, mdir + "/rec_v5_ratio_10.dxnn"},
+                {15, mdir + "/rec_v5_ratio_15.dxnn"},
+                {25, mdir + "/rec_v5_ratio_25.dxnn"},
+                {35, mdir + "/rec_v5_ratio_35.dxnn"},
+            };
+            ocrCfg.recognizerConfig.dictPath = config_.models.ocrDictPath;
+            ocrCfg.recognizerConfig.deviceId = config_.runtime.deviceId;
+
+            // Disable heavy document-level preprocessing for per-region OCR
+            ocrCfg.useDocPreprocessing = false;
+            ocrCfg.useClassification = false;
+            ocrCfg.enableVisualization = false;
+
+            ocrPipeline_ = std::make_unique<ocr::OCRPipeline>(ocrCfg);
+            if (!ocrPipeline_->initialize()) {
+                return false;
+            }
+            ocrPipeline_->start();
+            LOG_INFO("OCR pipeline initialized (DXNN-OCR-cpp)");
+            return true;
+        });
+    }
+
+    const auto loadStart = std::chrono::steady_clock::now();
+    bool modelsLoaded = true;
+    if (config_.runtime.parallelModelInit && modelLoads.size() > 1) {
+        std::vector<std::future<bool>> loads;
+        loads.reserve(modelLoads.size());
+        for (auto& load : modelLoads) {
+            loads.push_back(std::async(std::launch::async, load.second));
+        }
+        // Every load is joined before reporting, so none outlives a failure.
+        for (size_t i = 0; i < loads.size(); ++i) {
+            if (!loads[i].get()) {
+                LOG_ERROR("Failed to initialize {}", modelLoads[i].first);
+                modelsLoaded = false;
+            }
         }
-        ocrPipeline_->start();
-        LOG_INFO("OCR pipeline initialized (DXNN-OCR-cpp)");
+    } else {
+        for (auto& load : modelLoads) {
+            if (!load.second()) {
+                LOG_ERROR("Failed to initialize {}", load.first);
+                modelsLoaded = false;
+                break;
+            }
+        }
+    }
+    if (!modelsLoaded) {
+        return false;
+    }
+    LOG_INFO("Models loaded in {:.1f} ms{}",
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count(),
+             config_.runtime.parallelModelInit && modelLoads.size() > 1 ? " (parallel)" : "");
+
+    if (!ImageEncoding::parse(config_.runtime.imageFormat, config_.runtime.imageQuality,
+                              imageEncoding_)) {
+        LOG_WARN("Unknown image format '{}', using png", config_.runtime.imageFormat);
+    }
+    // OpenCV builds may lack a codec (WebP is optional); probe once up front
+    // rather than failing every crop.
+    std::vector<uint8_t> probe;
+    if (!imageEncoding_.encode(cv::Mat(1, 1, CV_8UC3, cv::Scalar::all(0)), probe)) {
+        LOG_WARN("Image format '{}' is not supported by this OpenCV build, using png",
+                 config_.runtime.imageFormat);
+        imageEncoding_ = ImageEncoding{ImageCodec::PNG, -1};
     }
 
     // Create output directory
@@ -258,43 +590,148 @@ bool DocPipeline::initialize() {
     }
 
     initialized_ = true;
+    if (config_.runtime.warmupOnInit && !replay) {
+        warmup();
+    }
     LOG_INFO("RapidDoc pipeline initialized successfully");
     return true;
 }
 
+DocPipeline::BufferPoolStats DocPipeline::bufferPoolStats() const {
+    BufferPoolStats stats;
+    stats.pageCrops = pageBuffers_->stats();
+    if (layoutDetector_) {
+        stats.layoutInputs = layoutDetector_->inputPoolStats();
+    }
+    if (tableRecognizer_) {
+        stats.tableInputs = tableRecognizer_->inputPoolStats();
+        stats.tableMasks = tableRecognizer_->maskPoolStats();
+    }
+    return stats;
+}
+
+void DocPipeline::setLayoutBatchMaxDelayMs(int ms) {
+    if (layoutDetector_) {
+        layoutDetector_->setBatchMaxDelayMs(ms);
+    }
+}
+
+int DocPipeline::layoutBatchMaxDelayMs() const {
+    return layoutDetector_ ? layoutDetector_->batchMaxDelayMs() : -1;
+}
+
+bool DocPipeline::warmup() {
+    const auto start = std::chrono::steady_clock::now();
+    // A synthetic page: white with dark bars, so each engine gets real input
+    // and first-call costs (allocations, kernels, lazy graph setup) are paid here.
+    const int side = std::max(64, config_.runtime.layoutInputSize);
+    cv::Mat page(side, side, CV_8UC3, cv::Scalar::all(255));
+    for (int y = side / 8; y + side / 32 < side * 7 / 8; y += side / 12) {
+        page(cv::Rect(side / 8, y, side * 3 / 4, side / 32)).setTo(cv::Scalar::all(0));
+    }
+
+    try {
+        if (layoutDetector_) {
+            layoutDetector_->detect(page);
+        }
+        if (ocrPipeline_) {
+            ocrOnCrop(page(cv::Rect(side / 8 - 4, side / 8 - 4, side * 3 / 4 + 8, side / 32 + 8)),
+                      allocateOcrTaskId());
+        }
+        if (tableRecognizer_) {
+            tableRecognizer_->recognize(page(cv::Rect(0, 0, side / 2, side / 2)));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("Pipeline warmup failed: {}", e.what());
+        return false;
+    }
+    LOG_INFO("Pipeline warmup finished in {:.1f} ms",
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    warmedUp_.store(true, std::memory_order_release);
+    return true;
+}
+
 DocPipeline::ExecutionContext DocPipeline::makeExecutionContext(
-    const PipelineRunOverrides* overrides) const
+    const PipelineRunOverrides* overrides)
 {
-    ExecutionContext ctx{config_.stages, config_.runtime};
-    if (overrides == nullptr) {
-        return ctx;
-    }
-
-    if (overrides->outputDir.has_value()) ctx.runtime.outputDir = *overrides->outputDir;
-    if (overrides->saveImages.has_value()) ctx.runtime.saveImages = *overrides->saveImages;
-    if (overrides->saveVisualization.has_value()) ctx.runtime.saveVisualization = *overrides->saveVisualization;
-    if (overrides->startPageId.has_value()) ctx.runtime.startPageId = *overrides->startPageId;
-    if (overrides->endPageId.has_value()) ctx.runtime.endPageId = *overrides->endPageId;
-    if (overrides->maxPages.has_value()) ctx.runtime.maxPages = *overrides->maxPages;
-    if (overrides->enableFormula.has_value()) ctx.stages.enableFormula = *overrides->enableFormula;
-    if (overrides->enableWiredTable.has_value()) ctx.stages.enableWiredTable = *overrides->enableWiredTable;
-    if (overrides->enableMarkdownOutput.has_value()) {
-        ctx.stages.enableMarkdownOutput = *overrides->enableMarkdownOutput;
+    ExecutionContext ctx{config_.stages, config_.runtime, {}, {}, {}, {}};
+    if (overrides != nullptr) {
+        ctx.markdownSink = overrides->markdownSink;
+        ctx.contentListSink = overrides->contentListSink;
+        ctx.progress = overrides->progress;
+        ctx.cancel = overrides->cancel;
+        ctx.deadline = overrides->deadline;
+        ctx.traceId = overrides->traceId;
+
+        if (overrides->outputDir.has_value()) ctx.runtime.outputDir = *overrides->outputDir;
+        if (overrides->saveImages.has_value()) ctx.runtime.saveImages = *overrides->saveImages;
+        if (overrides->saveVisualization.has_value()) ctx.runtime.saveVisualization = *overrides->saveVisualization;
+        if (overrides->startPageId.has_value()) ctx.runtime.startPageId = *overrides->startPageId;
+        if (overrides->endPageId.has_value()) ctx.runtime.endPageId = *overrides->endPageId;
+        if (overrides->maxPages.has_value()) ctx.runtime.maxPages = *overrides->maxPages;
+        if (overrides->enableFormula.has_value()) ctx.stages.enableFormula = *overrides->enableFormula;
+        if (overrides->enableWiredTable.has_value()) ctx.stages.enableWiredTable = *overrides->enableWiredTable;
+        if (overrides->enableMarkdownOutput.has_value()) {
+            ctx.stages.enableMarkdownOutput = *overrides->enableMarkdownOutput;
+        }
+        if (overrides->useTextLayer.has_value()) ctx.runtime.useTextLayer = *overrides->useTextLayer;
+    }
+
+    if (ctx.runtime.saveImages || ctx.runtime.saveVisualization) {
+        ctx.imageWrites = std::make_shared<ImageWriteBatch>(
+            imageWriter(), imageEncoding_, overrides != nullptr && overrides->keepEncodedImages);
     }
     return ctx;
 }
 
 void DocPipeline::resetOcrTransientStateForRun() {
-    std::lock_guard<std::mutex> lock(ocrStateMutex_);
-    bufferedOcrResults_.clear();
-    timedOutOcrTaskIds_.clear();
+    ocrCompletions_.clear();
 }
 
-std::mutex& DocPipeline::npuSerialMutex() {
-    if (externalNpuSerialMutex_ != nullptr) {
-        return *externalNpuSerialMutex_;
+NpuScheduler& DocPipeline::npuScheduler() {
+    if (externalNpuScheduler_ != nullptr) {
+        return *externalNpuScheduler_;
     }
-    return npuSerialMutex_;
+    return npuScheduler_;
+}
+
+TaskPool& DocPipeline::postprocessPool() {
+    if (externalPostprocessPool_ != nullptr) {
+        return *externalPostprocessPool_;
+    }
+    // Created on first use so pipelines that never post-process (or that get
+    // the server's pool) do not spawn threads.
+    std::call_once(postprocessPoolOnce_, [this]() {
+        postprocessPool_ = std::make_unique<TaskPool>(
+            resolveTaskPoolThreads(config_.runtime.postprocessThreads));
+    });
+    return *postprocessPool_;
+}
+
+ImageWriter& DocPipeline::imageWriter() {
+    if (externalImageWriter_ != nullptr) {
+        return *externalImageWriter_;
+    }
+    std::call_once(imageWriterOnce_, [this]() {
+        imageWriter_ = std::make_unique<ImageWriter>(
+            static_cast<size_t>(std::max(0, config_.runtime.imageWriteThreads)),
+            static_cast<size_t>(std::max(0, config_.runtime.imageCacheMb)) * 1024 * 1024);
+    });
+    return *imageWriter_;
+}
+
+RecognitionCache* DocPipeline::recognitionCache() {
+    if (externalRecognitionCache_ != nullptr) {
+        return externalRecognitionCache_;
+    }
+    if (config_.runtime.recognitionCacheMb <= 0) {
+        return nullptr;
+    }
+    std::call_once(recognitionCacheOnce_, [this]() {
+        recognitionCache_ = std::make_unique<RecognitionCache>(
+            static_cast<size_t>(config_.runtime.recognitionCacheMb) * 1024 * 1024);
+    });
+    return recognitionCache_.get();
 }
 
 DocumentResult DocPipeline::processPdf(const std::string& pdfPath) {
@@ -323,51 +760,31 @@ DocumentResult DocPipeline::processPdfInternal(
     }
 
     reportProgress("PDF Render", 0, 1);
-    auto renderStart = std::chrono::steady_clock::now();
-
-    std::vector<PageImage> pageImages;
-    if (ctx.stages.enablePdfRender) {
-        PdfRenderConfig pdfCfg;
-        pdfCfg.dpi = ctx.runtime.pdfDpi;
-        pdfCfg.maxPages = ctx.runtime.maxPages;
-        pdfCfg.startPageId = ctx.runtime.startPageId;
-        pdfCfg.endPageId = ctx.runtime.endPageId;
-        pdfCfg.maxConcurrentRenders = ctx.runtime.maxConcurrentPages;
-        PdfRenderer renderer(pdfCfg);
-        pageImages = renderer.renderFile(pdfPath);
-    }
-
-    auto renderEnd = std::chrono::steady_clock::now();
-    result.stats.pdfRenderTimeMs =
-        std::chrono::duration<double, std::milli>(renderEnd - renderStart).count();
-    result.totalPages = static_cast<int>(pageImages.size());
-
-    if (pageImages.empty()) {
+
+    DocumentOutput output(ctx);
+    processRenderedPages(
+        [&](const PageSink& sink) {
+            if (!ctx.stages.enablePdfRender) {
+                return;
+            }
+            PdfRenderer renderer(makePdfRenderConfig(ctx.runtime, ctx.traceId));
+            result.totalPages = renderer.renderFileEach(pdfPath, sink);
+        },
+        ctx,
+        result,
+        output);
+
+    if (result.pages.empty()) {
         LOG_WARN("No pages rendered from PDF");
+        output.finish(result);
         return result;
     }
 
-    LOG_INFO("Rendered {} pages from PDF", pageImages.size());
-
-    for (size_t i = 0; i < pageImages.size(); i++) {
-        reportProgress("Processing", static_cast<int>(i + 1), static_cast<int>(pageImages.size()));
-
-        PageResult pageResult = processPage(pageImages[i], ctx);
-        result.pages.push_back(std::move(pageResult));
-        result.processedPages++;
-    }
-
-    finalizeDocumentStats(result);
+    LOG_INFO("Rendered and processed {} pages from PDF", result.pages.size());
 
     reportProgress("Output", 0, 1);
-    auto outputStart = std::chrono::steady_clock::now();
-    if (ctx.stages.enableMarkdownOutput) {
-        result.markdown = markdownWriter_.generate(result);
-    }
-    result.contentListJson = contentListWriter_.generate(result);
-    auto outputEnd = std::chrono::steady_clock::now();
-    result.stats.outputGenTimeMs =
-        std::chrono::duration<double, std::milli>(outputEnd - outputStart).count();
+    output.finish(result);
+    finalizeDocumentStats(result);
 
     auto endTime = std::chrono::steady_clock::now();
     result.totalTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
@@ -384,6 +801,236 @@ DocumentResult DocPipeline::processPdfInternal(
     return result;
 }
 
+void DocPipeline::processRenderedPages(
+    const PageProducer& producer,
+    const ExecutionContext& ctx,
+    DocumentResult& result,
+    DocumentOutput& output)
+{
+    if (ctx.runtime.pipelineQueueDepth > 0) {
+        runPagePipeline(producer, ctx, result, output);
+        return;
+    }
+
+    // Serial mode: process each page inline as it is rendered, so only one
+    // page image is alive at a time.
+    double processMs = 0.0;
+    auto produceStart = std::chrono::steady_clock::now();
+    producer([&](PageImage&& page, int pagesPlanned) {
+        if (ctx.stopRequested()) {
+            result.cancelled = true;
+            return false;
+        }
+        auto pageStart = std::chrono::steady_clock::now();
+        PageResult pageResult = processPage(page, ctx);
+        processMs += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - pageStart).count();
+        // A stop during the page may have cut its OCR short; only whole pages are returned.
+        if (ctx.stopRequested()) {
+            result.cancelled = true;
+            return false;
+        }
+        output.addPage(std::move(pageResult), result);
+        reportProgress(ctx, "Processing", result.processedPages, pagesPlanned);
+        return true;
+    });
+    auto produceEnd = std::chrono::steady_clock::now();
+    result.stats.pdfRenderTimeMs = std::max(
+        0.0,
+        std::chrono::duration<double, std::milli>(produceEnd - produceStart).count() - processMs);
+}
+
+void DocPipeline::runPagePipeline(
+    const PageProducer& producer,
+    const ExecutionContext& ctx,
+    DocumentResult& result,
+    DocumentOutput& output)
+{
+    const size_t depth = static_cast<size_t>(std::max(1, ctx.runtime.pipelineQueueDepth));
+    const size_t lookahead = static_cast<size_t>(std::max(1, ctx.runtime.renderLookaheadPages));
+    const size_t layoutBatch = static_cast<size_t>(std::max(1, ctx.runtime.layoutBatchSize));
+    BoundedQueue<PageWork> layoutQueue(std::max(lookahead, layoutBatch));
+    BoundedQueue<PageWork> recognitionQueue(depth);
+    BoundedQueue<PageWork> postprocessQueue(depth);
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    auto abortPipeline = [&](std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = error;
+            }
+        }
+        layoutQueue.close(true);
+        recognitionQueue.close(true);
+        postprocessQueue.close(true);
+    };
+    // Cancellation drops every queued page, like an error, but is not rethrown.
+    std::atomic<bool> stopped{false};
+    auto stopIfRequested = [&]() {
+        if (!ctx.stopRequested()) {
+            return false;
+        }
+        stopped.store(true);
+        layoutQueue.close(true);
+        recognitionQueue.close(true);
+        postprocessQueue.close(true);
+        return true;
+    };
+
+    // Each stage owns one thread so page N+1 can enter layout while page N is
+    // still in OCR/table; each NPU engine is admitted separately by npuScheduler().
+    auto runStage = [&](BoundedQueue<PageWork>& in,
+                        BoundedQueue<PageWork>& out,
+                        void (DocPipeline::*stage)(PageWork&, const ExecutionContext&)) {
+        try {
+            PageWork work;
+            while (in.pop(work)) {
+                if (stopIfRequested()) {
+                    break;
+                }
+                (this->*stage)(work, ctx);
+                if (!out.push(std::move(work))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            abortPipeline(std::current_exception());
+        }
+        out.close();
+    };
+
+    // Layout takes every rendered page already waiting (up to layoutBatchSize)
+    // so the detector can run them as one batch.
+    auto runLayout = [&]() {
+        try {
+            PageWork first;
+            while (layoutQueue.pop(first)) {
+                std::vector<PageWork> batch;
+                batch.push_back(std::move(first));
+                PageWork next;
+                while (batch.size() < layoutBatch && layoutQueue.tryPop(next)) {
+                    batch.push_back(std::move(next));
+                }
+
+                if (stopIfRequested()) {
+                    break;
+                }
+                std::vector<PageWork*> pages;
+                pages.reserve(batch.size());
+                for (auto& work : batch) {
+                    pages.push_back(&work);
+                }
+                runLayoutBatch(pages, ctx);
+
+                bool accepted = true;
+                for (auto& work : batch) {
+                    if (!recognitionQueue.push(std::move(work))) {
+                        accepted = false;
+                        break;
+                    }
+                }
+                if (!accepted) {
+                    break;
+                }
+            }
+        } catch (...) {
+            abortPipeline(std::current_exception());
+        }
+        recognitionQueue.close();
+    };
+
+    std::atomic<int> pagesPlanned{0};
+
+    // Post-processing (crops, visualization, reading order) is CPU only, so
+    // several workers take pages from the NPU stages as soon as they are
+    // done; the NPU threads never wait on it. Pages finish out of order and
+    // are streamed in producer order: a finished page (its result, not its
+    // pixels) is held until every page before it has been streamed.
+    const size_t postprocessWorkers = static_cast<size_t>(std::max(1, ctx.runtime.postprocessStageThreads));
+    std::mutex mergeMutex;
+    std::map<size_t, PageResult> finished;
+    size_t nextSequence = 0;
+    auto mergePage = [&](size_t sequence, PageResult&& page) {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        finished.emplace(sequence, std::move(page));
+        for (auto it = finished.find(nextSequence); it != finished.end();
+             it = finished.find(nextSequence)) {
+            output.addPage(std::move(it->second), result);
+            finished.erase(it);
+            ++nextSequence;
+            reportProgress(ctx, "Processing", result.processedPages, pagesPlanned.load());
+        }
+    };
+    auto runPostprocess = [&]() {
+        try {
+            PageWork work;
+            while (postprocessQueue.pop(work)) {
+                PageResult page = runPostprocessStage(work, ctx);
+                // Only whole pages are returned; see processRenderedPages().
+                if (stopIfRequested()) {
+                    break;
+                }
+                mergePage(work.sequence, std::move(page));
+            }
+        } catch (...) {
+            abortPipeline(std::current_exception());
+        }
+    };
+
+    std::thread layoutThread(runLayout);
+    std::thread recognitionThread(
+        runStage, std::ref(recognitionQueue), std::ref(postprocessQueue),
+        &DocPipeline::runRecognitionStage);
+    std::vector<std::thread> postprocessThreads;
+    postprocessThreads.reserve(postprocessWorkers);
+    for (size_t i = 0; i < postprocessWorkers; ++i) {
+        postprocessThreads.emplace_back(runPostprocess);
+    }
+
+    // Render time excludes time blocked on a full layout queue.
+    double sinkBlockedMs = 0.0;
+    size_t producedPages = 0;
+    auto produceStart = std::chrono::steady_clock::now();
+    try {
+        producer([&](PageImage&& page, int planned) {
+            pagesPlanned.store(planned);
+            if (stopIfRequested()) {
+                return false;
+            }
+            PageWork work;
+            work.page = std::move(page);
+            work.sequence = producedPages++;
+            auto pushStart = std::chrono::steady_clock::now();
+            const bool accepted = layoutQueue.push(std::move(work));
+            sinkBlockedMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - pushStart).count();
+            return accepted;
+        });
+    } catch (...) {
+        abortPipeline(std::current_exception());
+    }
+    auto produceEnd = std::chrono::steady_clock::now();
+    result.stats.pdfRenderTimeMs = std::max(
+        0.0,
+        std::chrono::duration<double, std::milli>(produceEnd - produceStart).count() - sinkBlockedMs);
+    layoutQueue.close();
+
+    layoutThread.join();
+    recognitionThread.join();
+    for (auto& thread : postprocessThreads) {
+        thread.join();
+    }
+
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+    if (stopped.load()) {
+        result.cancelled = true;
+    }
+}
+
 DocumentResult DocPipeline::processPdfFromMemory(const uint8_t* data, size_t size) {
     return processPdfFromMemoryInternal(data, size, makeExecutionContext(nullptr));
 }
@@ -411,40 +1058,84 @@ DocumentResult DocPipeline::processPdfFromMemoryInternal(
 
     auto startTime = std::chrono::steady_clock::now();
 
-    std::vector<PageImage> pageImages;
-    auto renderStart = std::chrono::steady_clock::now();
-    if (ctx.stages.enablePdfRender) {
-        PdfRenderConfig pdfCfg;
-        pdfCfg.dpi = ctx.runtime.pdfDpi;
-        pdfCfg.maxPages = ctx.runtime.maxPages;
-        pdfCfg.startPageId = ctx.runtime.startPageId;
-        pdfCfg.endPageId = ctx.runtime.endPageId;
-        pdfCfg.maxConcurrentRenders = ctx.runtime.maxConcurrentPages;
-        PdfRenderer renderer(pdfCfg);
-        pageImages = renderer.renderFromMemory(data, size);
+    DocumentOutput output(ctx);
+    processRenderedPages(
+        [&](const PageSink& sink) {
+            if (!ctx.stages.enablePdfRender) {
+                return;
+            }
+            PdfRenderer renderer(makePdfRenderConfig(ctx.runtime, ctx.traceId));
+            result.totalPages = renderer.renderEach(data, size, sink);
+        },
+        ctx,
+        result,
+        output);
+
+    output.finish(result);
+    finalizeDocumentStats(result);
+
+    for (const auto& page : result.pages) {
+        for (const auto& elem : page.elements) {
+            if (elem.skipped) result.skippedElements++;
+        }
     }
-    auto renderEnd = std::chrono::steady_clock::now();
 
-    result.stats.pdfRenderTimeMs =
-        std::chrono::duration<double, std::milli>(renderEnd - renderStart).count();
-    result.totalPages = static_cast<int>(pageImages.size());
+    auto endTime = std::chrono::steady_clock::now();
+    result.totalTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    return result;
+}
 
-    for (size_t i = 0; i < pageImages.size(); i++) {
-        PageResult pageResult = processPage(pageImages[i], ctx);
-        result.pages.push_back(std::move(pageResult));
-        result.processedPages++;
+DocumentResult DocPipeline::processPdfFromMemoryAcross(
+    const std::vector<DocPipeline*>& pipelines,
+    const uint8_t* data,
+    size_t size,
+    const PipelineRunOverrides& overrides,
+    std::vector<PageStageStats>* pipelineStats)
+{
+    if (pipelines.empty()) {
+        throw std::invalid_argument("processPdfFromMemoryAcross needs at least one pipeline");
+    }
+    DocPipeline& lead = *pipelines.front();
+    if (pipelines.size() == 1) {
+        DocumentResult result = lead.processPdfFromMemoryWithOverrides(data, size, overrides);
+        if (pipelineStats != nullptr) {
+            *pipelineStats = {result.stats};
+        }
+        return result;
     }
 
-    finalizeDocumentStats(result);
+    LOG_INFO("Processing PDF from memory: {} bytes across {} pipelines", size, pipelines.size());
 
-    auto outputStart = std::chrono::steady_clock::now();
-    if (ctx.stages.enableMarkdownOutput) {
-        result.markdown = markdownWriter_.generate(result);
+    DocumentResult result;
+    for (const DocPipeline* pipeline : pipelines) {
+        if (!pipeline->initialized_) {
+            LOG_ERROR("Pipeline not initialized");
+            return result;
+        }
     }
-    result.contentListJson = contentListWriter_.generate(result);
-    auto outputEnd = std::chrono::steady_clock::now();
-    result.stats.outputGenTimeMs =
-        std::chrono::duration<double, std::milli>(outputEnd - outputStart).count();
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    const ExecutionContext ctx = lead.makeExecutionContext(&overrides);
+    DocumentOutput output(ctx);
+    processRenderedPagesAcross(
+        pipelines,
+        [&](const PageSink& sink) {
+            if (!ctx.stages.enablePdfRender) {
+                return;
+            }
+            PdfRenderer renderer(makePdfRenderConfig(ctx.runtime, ctx.traceId));
+            result.totalPages = renderer.renderEach(data, size, sink);
+        },
+        ctx,
+        overrides,
+        result,
+        output,
+        pipelineStats);
+
+    output.finish(result);
+    finalizeDocumentStats(result);
 
     for (const auto& page : result.pages) {
         for (const auto& elem : page.elements) {
@@ -454,10 +1145,167 @@ DocumentResult DocPipeline::processPdfFromMemoryInternal(
 
     auto endTime = std::chrono::steady_clock::now();
     result.totalTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
-
     return result;
 }
 
+void DocPipeline::processRenderedPagesAcross(
+    const std::vector<DocPipeline*>& pipelines,
+    const PageProducer& producer,
+    const ExecutionContext& ctx,
+    const PipelineRunOverrides& overrides,
+    DocumentResult& result,
+    DocumentOutput& output,
+    std::vector<PageStageStats>* pipelineStats)
+{
+    // Pages finish out of order across pipelines; each is held until every
+    // page rendered before it has been streamed.
+    std::mutex mergeMutex;
+    std::deque<int> renderOrder;
+    std::map<int, PageResult> finished;
+    std::atomic<int> pagesPlanned{0};
+    auto mergePage = [&](PageResult&& page) {
+        std::lock_guard<std::mutex> lock(mergeMutex);
+        const int pageIndex = page.pageIndex;
+        finished.emplace(pageIndex, std::move(page));
+        while (!renderOrder.empty()) {
+            auto it = finished.find(renderOrder.front());
+            if (it == finished.end()) {
+                break;
+            }
+            output.addPage(std::move(it->second), result);
+            finished.erase(it);
+            renderOrder.pop_front();
+            if (ctx.progress) {
+                ctx.progress("Processing", result.processedPages, pagesPlanned.load());
+            }
+        }
+    };
+
+    const size_t lookahead = static_cast<size_t>(std::max(1, ctx.runtime.renderLookaheadPages));
+    BoundedQueue<PageImage> pages(lookahead * pipelines.size());
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    auto abortRun = [&](std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = error;
+            }
+        }
+        pages.close(true);
+    };
+    // A pipeline that stops on cancellation closes the page queue so the
+    // producer cannot block on pipelines that are no longer reading it.
+    std::atomic<bool> cancelled{false};
+    auto cancelRun = [&]() {
+        cancelled.store(true);
+        pages.close(true);
+    };
+
+    // Helper pipelines write into the lead's output and image batch; only the
+    // lead streams Markdown / content list.
+    PipelineRunOverrides shardOverrides = overrides;
+    shardOverrides.markdownSink = nullptr;
+    shardOverrides.contentListSink = nullptr;
+    shardOverrides.progress = nullptr;
+    shardOverrides.keepEncodedImages = false;
+
+    std::vector<PageStageStats> stats(pipelines.size());
+    std::vector<std::thread> workers;
+    workers.reserve(pipelines.size());
+    for (size_t i = 0; i < pipelines.size(); ++i) {
+        workers.emplace_back([&, i]() {
+            DocPipeline& pipeline = *pipelines[i];
+            // Each pipeline's pages run on its own device's node, not the lead's.
+            pinCurrentThread(parseCpuList(pipeline.config().runtime.cpuAffinity));
+            try {
+                ExecutionContext shardCtx = pipeline.makeExecutionContext(&shardOverrides);
+                shardCtx.imageWrites = ctx.imageWrites;
+                DocumentOutput shardOutput(shardCtx);
+                shardOutput.forward = [&, i](PageResult&& page) {
+                    accumulatePageStats(stats[i], page.stats);
+                    mergePage(std::move(page));
+                };
+
+                DocumentResult shardResult;
+                pipeline.processRenderedPages(
+                    [&](const PageSink& sink) {
+                        PageImage page;
+                        while (pages.pop(page)) {
+                            if (!sink(std::move(page), pagesPlanned.load())) {
+                                break;
+                            }
+                        }
+                    },
+                    shardCtx,
+                    shardResult,
+                    shardOutput);
+                if (shardResult.cancelled) {
+                    cancelRun();
+                }
+            } catch (...) {
+                abortRun(std::current_exception());
+            }
+        });
+    }
+
+    // Render time excludes time blocked on a full page queue.
+    double sinkBlockedMs = 0.0;
+    auto produceStart = std::chrono::steady_clock::now();
+    try {
+        producer([&](PageImage&& page, int planned) {
+            pagesPlanned.store(planned);
+            if (ctx.stopRequested()) {
+                cancelRun();
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mergeMutex);
+                renderOrder.push_back(page.pageIndex);
+            }
+            auto pushStart = std::chrono::steady_clock::now();
+            const bool accepted = pages.push(std::move(page));
+            sinkBlockedMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - pushStart).count();
+            return accepted;
+        });
+    } catch (...) {
+        abortRun(std::current_exception());
+    }
+    auto produceEnd = std::chrono::steady_clock::now();
+    pages.close();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+    // Pages finished after a gap left by a dropped page stay unmerged.
+    result.cancelled = cancelled.load();
+
+    result.stats.pdfRenderTimeMs = std::max(
+        0.0,
+        std::chrono::duration<double, std::milli>(produceEnd - produceStart).count() - sinkBlockedMs);
+    if (pipelineStats != nullptr) {
+        *pipelineStats = std::move(stats);
+    }
+}
+
+int DocPipeline::plannedPageCount(
+    const uint8_t* data,
+    size_t size,
+    const PipelineRunOverrides& overrides) const
+{
+    RuntimeConfig runtime = config_.runtime;
+    if (overrides.startPageId.has_value()) runtime.startPageId = *overrides.startPageId;
+    if (overrides.endPageId.has_value()) runtime.endPageId = *overrides.endPageId;
+    if (overrides.maxPages.has_value()) runtime.maxPages = *overrides.maxPages;
+    PdfRenderer renderer(makePdfRenderConfig(runtime));
+    return renderer.countSelectedPages(data, size);
+}
+
 DocumentResult DocPipeline::processImageDocument(const cv::Mat& image, int pageIndex) {
     return processImageDocumentInternal(image, pageIndex, makeExecutionContext(nullptr));
 }
@@ -483,32 +1331,97 @@ DocumentResult DocPipeline::processImageDocumentInternal(
         return result;
     }
 
+    // The page shares the caller's pixels: every stage only reads the page
+    // image (crops and visualization copy out what they need).
     PageImage pageImage;
-    pageImage.image = image.clone();
+    pageImage.image = image;
     pageImage.pageIndex = pageIndex;
     pageImage.dpi = ctx.runtime.pdfDpi;
     pageImage.scaleFactor = 1.0;
     pageImage.pdfWidth = image.cols;
     pageImage.pdfHeight = image.rows;
+    result.totalPages = 1;
+    DocumentOutput output(ctx);
+    if (ctx.stopRequested()) {
+        result.cancelled = true;
+        output.finish(result);
+        return result;
+    }
     PageResult pageResult = processPage(pageImage, ctx);
 
-    result.pages.push_back(std::move(pageResult));
-    result.totalPages = 1;
-    result.processedPages = 1;
+    claimRegionImages(ctx.imageWrites.get(), pageResult.elements);
+    output.appendPage(pageResult);
+    result.pages.push_back(std::move(pageResult));
+    result.processedPages = 1;
+    if (ctx.progress) {
+        ctx.progress("Processing", 1, 1);
+    }
+
+    output.finish(result);
+    finalizeDocumentStats(result);
+
+    for (const auto& elem : result.pages.front().elements) {
+        if (elem.skipped) result.skippedElements++;
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    result.totalTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+    return result;
+}
+
+DocumentResult DocPipeline::processImagesAsDocument(const std::vector<cv::Mat>& images) {
+    return processImagesAsDocumentInternal(images, makeExecutionContext(nullptr));
+}
+
+DocumentResult DocPipeline::processImagesAsDocumentWithOverrides(
+    const std::vector<cv::Mat>& images,
+    const PipelineRunOverrides& overrides)
+{
+    return processImagesAsDocumentInternal(images, makeExecutionContext(&overrides));
+}
+
+DocumentResult DocPipeline::processImagesAsDocumentInternal(
+    const std::vector<cv::Mat>& images,
+    const ExecutionContext& ctx)
+{
+    LOG_INFO("Processing {} images as one document", images.size());
+
+    DocumentResult result;
+    if (!initialized_) {
+        LOG_ERROR("Pipeline not initialized");
+        return result;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
 
-    finalizeDocumentStats(result);
+    DocumentOutput output(ctx);
+    result.totalPages = static_cast<int>(images.size());
+    processRenderedPages(
+        [&](const PageSink& sink) {
+            for (size_t i = 0; i < images.size(); ++i) {
+                PageImage page;
+                page.image = images[i];
+                page.pageIndex = static_cast<int>(i);
+                page.dpi = ctx.runtime.pdfDpi;
+                page.scaleFactor = 1.0;
+                page.pdfWidth = images[i].cols;
+                page.pdfHeight = images[i].rows;
+                if (!sink(std::move(page), result.totalPages)) {
+                    break;
+                }
+            }
+        },
+        ctx,
+        result,
+        output);
 
-    auto outputStart = std::chrono::steady_clock::now();
-    if (ctx.stages.enableMarkdownOutput) {
-        result.markdown = markdownWriter_.generate(result);
-    }
-    result.contentListJson = contentListWriter_.generate(result);
-    auto outputEnd = std::chrono::steady_clock::now();
-    result.stats.outputGenTimeMs =
-        std::chrono::duration<double, std::milli>(outputEnd - outputStart).count();
+    output.finish(result);
+    finalizeDocumentStats(result);
 
-    for (const auto& elem : result.pages.front().elements) {
-        if (elem.skipped) result.skippedElements++;
+    for (const auto& page : result.pages) {
+        for (const auto& elem : page.elements) {
+            if (elem.skipped) result.skippedElements++;
+        }
     }
 
     auto endTime = std::chrono::steady_clock::now();
@@ -520,7 +1433,7 @@ PageResult DocPipeline::processImage(const cv::Mat& image, int pageIndex) {
     LOG_INFO("Processing image: {}x{}, page {}", image.cols, image.rows, pageIndex);
 
     PageImage pageImage;
-    pageImage.image = image.clone();
+    pageImage.image = image;
     pageImage.pageIndex = pageIndex;
     pageImage.dpi = config_.runtime.pdfDpi;
     pageImage.scaleFactor = 1.0;
@@ -531,114 +1444,343 @@ PageResult DocPipeline::processImage(const cv::Mat& image, int pageIndex) {
 }
 
 PageResult DocPipeline::processPage(const PageImage& pageImage) {
-    return processPage(pageImage, makeExecutionContext(nullptr));
+    const auto ctx = makeExecutionContext(nullptr);
+    PageResult result = processPage(pageImage, ctx);
+    claimRegionImages(ctx.imageWrites.get(), result.elements);
+    if (ctx.imageWrites) ctx.imageWrites->wait();
+    return result;
 }
 
 PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionContext& ctx) {
-    auto startTime = std::chrono::steady_clock::now();
-    PageResult result;
-    result.pageIndex = pageImage.pageIndex;
-    result.pageWidth = pageImage.image.cols;
-    result.pageHeight = pageImage.image.rows;
+    TRACE_SPAN("DocPipeline::processPage", "pipeline",
+               traceDetail(ctx.traceId, pageImage.pageIndex));
+    PageWork work;
+    work.page = pageImage;
+    runLayoutStage(work, ctx);
+    runRecognitionStage(work, ctx);
+    return runPostprocessStage(work, ctx);
+}
 
-    const cv::Mat& image = pageImage.image;
-    int pageWidth = image.cols;
-    int pageHeight = image.rows;
+double DocPipeline::runNpuStage(
+    PageWork& work, NpuEngine engine, const std::function<void()>& fn)
+{
+    const size_t lane = static_cast<size_t>(engine);
+    auto lockWaitStart = std::chrono::steady_clock::now();
+    NpuScheduler::Ticket ticket;
+    {
+        TRACE_SPAN("npu_wait", "npu", npuEngineName(engine));
+        ticket = npuScheduler().admit(engine);
+    }
+    auto lockAcquired = std::chrono::steady_clock::now();
+    work.npuWaitMs[lane] +=
+        std::chrono::duration<double, std::milli>(lockAcquired - lockWaitStart).count();
 
-    std::vector<LayoutBox> textBoxes;
-    std::vector<LayoutBox> tableBoxes;
-    std::vector<LayoutBox> figureBoxes;
-    std::vector<LayoutBox> equationBoxes;
-    std::vector<LayoutBox> unsupportedBoxes;
+    auto serialStart = lockAcquired;
+    {
+        TRACE_SPAN("npu_hold", "npu", npuEngineName(engine));
+        fn();
+    }
+    auto serialEnd = std::chrono::steady_clock::now();
+
+    const double serialMs =
+        std::chrono::duration<double, std::milli>(serialEnd - serialStart).count();
+    work.npuSerialTotalMs += serialMs;
+    work.npuHoldMs[lane] +=
+        std::chrono::duration<double, std::milli>(serialEnd - lockAcquired).count();
+    return serialMs;
+}
 
-    double npuLockWaitTotalMs = 0.0;
-    double npuLockHoldTotalMs = 0.0;
-    double npuSerialTotalMs = 0.0;
-    double cpuOnlyTotalMs = 0.0;
+void DocPipeline::runLayoutStage(PageWork& work, const ExecutionContext& ctx) {
+    runLayoutBatch({&work}, ctx);
+}
 
-    auto runNpuSerialized = [&](auto&& fn) -> double {
-        auto lockWaitStart = std::chrono::steady_clock::now();
-        std::unique_lock<std::mutex> npuLock(npuSerialMutex());
-        auto lockAcquired = std::chrono::steady_clock::now();
-        npuLockWaitTotalMs +=
-            std::chrono::duration<double, std::milli>(lockAcquired - lockWaitStart).count();
+void DocPipeline::runLayoutBatch(const std::vector<PageWork*>& batch, const ExecutionContext& ctx) {
+    if (batch.empty()) {
+        return;
+    }
+    TRACE_SPAN("DocPipeline::runLayoutBatch", "pipeline");
+    auto stageStart = std::chrono::steady_clock::now();
+    for (PageWork* work : batch) {
+        const cv::Mat& image = work->page.image;
+        PageResult& result = work->result;
+        result.pageIndex = work->page.pageIndex;
+        result.pageWidth = image.cols;
+        result.pageHeight = image.rows;
+        // Blank pages keep an empty layout, so no later stage finds work on them.
+        if (ctx.runtime.blankPageInkRatio > 0.0) {
+            auto checkStart = std::chrono::steady_clock::now();
+            if (pageInkRatio(image) <= ctx.runtime.blankPageInkRatio) {
+                result.blank = true;
+                result.stats.blankPages = 1;
+                LOG_DEBUG("Page {}: blank, skipping layout", work->page.pageIndex);
+            }
+            work->cpuOnlyTotalMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - checkStart).count();
+        }
+    }
 
-        auto serialStart = lockAcquired;
-        fn();
-        auto serialEnd = std::chrono::steady_clock::now();
-
-        const double serialMs =
-            std::chrono::duration<double, std::milli>(serialEnd - serialStart).count();
-        npuSerialTotalMs += serialMs;
-        npuLockHoldTotalMs +=
-            std::chrono::duration<double, std::milli>(serialEnd - lockAcquired).count();
-        return serialMs;
-    };
+    // Step 1: Layout detection (NPU, layout lane). A batching detector admits
+    // each batch it forms itself and reports every page's share of the wait
+    // and hold; otherwise the group is admitted once (charged to its first
+    // page) and run as one DX/ONNX batch.
+    // Pages the recognition cache has seen pixel-for-pixel skip the NPU.
+    if ((layoutDetector_ || layoutDetectHook_) && ctx.stages.enableLayout) {
+        RecognitionCache* cache = recognitionCache();
+        std::vector<PageWork*> pending;
+        std::vector<ContentDigest> digests;
+        pending.reserve(batch.size());
+        for (PageWork* work : batch) {
+            if (work->result.blank) {
+                continue;
+            }
+            if (cache != nullptr) {
+                const ContentDigest digest = digestImage(work->page.image);
+                if (cache->layouts.get(digest, work->result.layoutResult)) {
+                    work->result.layoutResult.inferenceTimeMs = 0.0;
+                    work->result.stats.layoutCacheHits++;
+                    continue;
+                }
+                work->result.stats.layoutCacheMisses++;
+                digests.push_back(digest);
+            }
+            pending.push_back(work);
+        }
 
-    // Step 1: Layout detection (NPU, serialized)
-    if (layoutDetector_ && ctx.stages.enableLayout) {
-        runNpuSerialized([&]() {
-            auto layoutStart = std::chrono::steady_clock::now();
-            result.layoutResult = layoutDetector_->detect(image);
-            auto layoutEnd = std::chrono::steady_clock::now();
-            result.layoutResult.inferenceTimeMs =
-                std::chrono::duration<double, std::milli>(layoutEnd - layoutStart).count();
-            result.stats.layoutTimeMs = result.layoutResult.inferenceTimeMs;
-        });
+        if (!pending.empty()) {
+            auto detectPending = [&]() {
+                auto layoutStart = std::chrono::steady_clock::now();
+                if (layoutDetectHook_) {
+                    for (PageWork* work : pending) {
+                        work->result.layoutResult = layoutDetectHook_(work->page.image);
+                    }
+                } else if (pending.size() == 1) {
+                    pending.front()->result.layoutResult =
+                        layoutDetector_->detect(pending.front()->page.image);
+                } else {
+                    std::vector<std::future<LayoutResult>> results;
+                    results.reserve(pending.size());
+                    for (PageWork* work : pending) {
+                        results.push_back(layoutDetector_->detectAsync(work->page.image));
+                    }
+                    for (size_t i = 0; i < pending.size(); ++i) {
+                        pending[i]->result.layoutResult = results[i].get();
+                    }
+                }
+                auto layoutEnd = std::chrono::steady_clock::now();
+                const double perPageMs =
+                    std::chrono::duration<double, std::milli>(layoutEnd - layoutStart).count() /
+                    static_cast<double>(pending.size());
+                for (PageWork* work : pending) {
+                    work->result.layoutResult.inferenceTimeMs = perPageMs;
+                    work->result.stats.layoutTimeMs = perPageMs;
+                }
+            };
+            if (!layoutDetectHook_ && layoutDetector_->batchesInternally()) {
+                const size_t lane = static_cast<size_t>(NpuEngine::LAYOUT);
+                detectPending();
+                for (PageWork* work : pending) {
+                    const LayoutResult& layout = work->result.layoutResult;
+                    work->npuWaitMs[lane] += layout.npuWaitMs;
+                    work->npuHoldMs[lane] += layout.npuHoldMs;
+                    work->npuSerialTotalMs += layout.npuHoldMs;
+                }
+            } else {
+                runNpuStage(*pending.front(), NpuEngine::LAYOUT, detectPending);
+            }
+        }
+        if (cache != nullptr) {
+            for (size_t i = 0; i < pending.size(); ++i) {
+                const LayoutResult& layout = pending[i]->result.layoutResult;
+                cache->layouts.put(digests[i], layout, layoutResultBytes(layout));
+            }
+        }
+        if (replaySession_ && replaySession_->recording()) {
+            for (const PageWork* work : pending) {
+                const LayoutResult& layout = work->result.layoutResult;
+                replaySession_->recordLayout(work->page.image, layout, layout.inferenceTimeMs);
+            }
+        }
 
-        LOG_DEBUG("Page {}: detected {} layout boxes",
-                  pageImage.pageIndex, result.layoutResult.boxes.size());
+        for (const PageWork* work : batch) {
+            LOG_DEBUG("Page {}: detected {} layout boxes",
+                      work->page.pageIndex, work->result.layoutResult.boxes.size());
+        }
     }
 
     // Derive layout buckets from structure (CPU-only, outside NPU lock).
-    {
+    for (PageWork* work : batch) {
         auto bucketStart = std::chrono::steady_clock::now();
-        textBoxes = result.layoutResult.getTextBoxes();
-        tableBoxes = result.layoutResult.getTableBoxes();
-        figureBoxes = result.layoutResult.getBoxesByCategory(LayoutCategory::FIGURE);
-        equationBoxes = result.layoutResult.getEquationBoxes();
-        unsupportedBoxes = result.layoutResult.getUnsupportedBoxes();
+        work->buckets = work->result.layoutResult.classify();
         auto bucketEnd = std::chrono::steady_clock::now();
-        cpuOnlyTotalMs +=
+        work->cpuOnlyTotalMs +=
             std::chrono::duration<double, std::milli>(bucketEnd - bucketStart).count();
     }
 
-    // OCR on text regions: move ROI crop, element assembly, and text concatenation to CPU-only.
-    if (ctx.stages.enableOcr) {
-        std::vector<OcrWorkItem> ocrWorkItems;
-        {
-            auto prepStart = std::chrono::steady_clock::now();
-            ocrWorkItems = buildOcrWorkItems(image, textBoxes, pageImage.pageIndex);
-            auto prepEnd = std::chrono::steady_clock::now();
-            cpuOnlyTotalMs +=
-                std::chrono::duration<double, std::milli>(prepEnd - prepStart).count();
-        }
+    auto stageEnd = std::chrono::steady_clock::now();
+    const double perPageActiveMs =
+        std::chrono::duration<double, std::milli>(stageEnd - stageStart).count() /
+        static_cast<double>(batch.size());
+    for (PageWork* work : batch) {
+        work->activeTimeMs += perPageActiveMs;
+    }
+}
 
-        std::vector<OcrFetchResult> fetchResults(ocrWorkItems.size());
-        result.stats.ocrTimeMs = runNpuSerialized([&]() {
+void DocPipeline::runRecognitionStage(PageWork& work, const ExecutionContext& ctx) {
+    TRACE_SPAN("DocPipeline::runRecognitionStage", "pipeline");
+    auto stageStart = std::chrono::steady_clock::now();
+    const PageImage& pageImage = work.page;
+    const cv::Mat& image = pageImage.image;
+    PageResult& result = work.result;
+    const LayoutBoxView textBoxes = work.buckets.view(result.layoutResult.boxes, LayoutBucket::TEXT);
+    const LayoutBoxView tableBoxes = work.buckets.view(result.layoutResult.boxes, LayoutBucket::TABLE);
+    double& cpuOnlyTotalMs = work.cpuOnlyTotalMs;
+
+    const bool ocrAvailable = ocrPipeline_ || (ocrSubmitHook_ && ocrFetchHook_);
+    const bool tableOcrEnabled = ctx.stages.enableWiredTable && ctx.stages.enableOcr && ocrAvailable;
+
+    // CPU-only crop preparation for every OCR and table region on the page.
+    // Text crops the recognition cache has already read skip the OCR lanes.
+    RecognitionCache* cache = ctx.stages.enableOcr ? recognitionCache() : nullptr;
+    std::vector<OcrWorkItem> ocrWorkItems;
+    std::vector<TableWorkItem> tableWorkItems;
+    std::vector<ContentDigest> ocrDigests;
+    std::vector<std::optional<std::string>> cachedTexts;
+    {
+        auto prepStart = std::chrono::steady_clock::now();
+        if (ctx.stages.enableOcr) {
+            std::optional<TextLayerIndex> textLayer;
+            if (ctx.runtime.useTextLayer && !pageImage.textLayer.empty()) {
+                textLayer.emplace(pageImage.textLayer);
+            }
+            ocrWorkItems = buildOcrWorkItems(
+                pageImage, textBoxes, textLayer ? &*textLayer : nullptr);
+            for (const auto& item : ocrWorkItems) {
+                result.stats.textLayerRegions += item.layerText ? 1 : 0;
+            }
+        }
+        if (cache != nullptr) {
+            ocrDigests.resize(ocrWorkItems.size());
+            cachedTexts.resize(ocrWorkItems.size());
             for (size_t i = 0; i < ocrWorkItems.size(); ++i) {
                 const auto& item = ocrWorkItems[i];
                 if (item.skipped || item.crop.empty()) {
                     continue;
                 }
+                ocrDigests[i] = regionDigest(pageImage, item.crop);
+                std::string text;
+                if (cache->ocrTexts.get(ocrDigests[i], text)) {
+                    cachedTexts[i] = std::move(text);
+                    result.stats.ocrCacheHits++;
+                } else {
+                    result.stats.ocrCacheMisses++;
+                }
+            }
+        }
+        // Only crops the OCR backend will read are re-rendered and copied,
+        // and outside the NPU lanes.
+        for (size_t i = 0; i < ocrWorkItems.size(); ++i) {
+            auto& item = ocrWorkItems[i];
+            if (!item.skipped && !item.crop.empty() && !(cache != nullptr && cachedTexts[i])) {
+                item.crop = ocrInput(regionCrop(pageImage, item.roi));
+            }
+        }
+        if (ctx.stages.enableWiredTable) {
+            tableWorkItems.reserve(tableBoxes.size());
+            for (const auto& box : tableBoxes) {
+                TableWorkItem item;
+                item.box = box;
+                item.pageIndex = pageImage.pageIndex;
+                cv::Rect roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
+                if (roi.width <= 0 || roi.height <= 0) {
+                    item.invalidRoi = true;
+                } else {
+                    // The UNET preprocess resizes the crop straight into its input buffer.
+                    item.crop = regionCrop(pageImage, roi);
+                    if (tableOcrEnabled) {
+                        item.ocrCrop = ocrInput(item.crop);
+                    }
+                }
+                tableWorkItems.push_back(std::move(item));
+            }
+        }
+        auto prepEnd = std::chrono::steady_clock::now();
+        cpuOnlyTotalMs +=
+            std::chrono::duration<double, std::milli>(prepEnd - prepStart).count();
+    }
 
-                const int64_t taskId = allocateOcrTaskId();
-                auto& fetch = fetchResults[i];
-                fetch.submitted = false;
-                fetch.fetched = false;
-                fetch.success = false;
-                fetch.results.clear();
+    // OCR: submit every text crop and every table crop up front so the OCR
+    // pipeline's detection/recognition workers stay busy, then drain results
+    // in completion order. Table OCR does not depend on the UNET structure,
+    // so it is batched here too; results for tables that later fall back are
+    // simply dropped.
+    std::vector<OcrFetchResult> fetchResults(ocrWorkItems.size());
+    std::vector<OcrFetchResult> tableOcrResults(tableWorkItems.size());
+    if (ctx.stages.enableOcr) {
+        // With every text region answered by the text layer or the cache the
+        // OCR lane is not needed.
+        bool ocrLaneNeeded = tableOcrEnabled && !tableWorkItems.empty();
+        for (size_t i = 0; i < ocrWorkItems.size() && !ocrLaneNeeded; ++i) {
+            const auto& item = ocrWorkItems[i];
+            ocrLaneNeeded = !item.skipped && !item.crop.empty() &&
+                            !(cache != nullptr && cachedTexts[i]);
+        }
+        if (ocrLaneNeeded) {
+            result.stats.ocrTimeMs = runNpuStage(work, NpuEngine::OCR, [&]() {
+                std::vector<int64_t> submittedIds;
+                std::vector<std::pair<OcrFetchResult*, int64_t>> targets;
+                submittedIds.reserve(ocrWorkItems.size() + tableWorkItems.size());
+                targets.reserve(ocrWorkItems.size() + tableWorkItems.size());
+
+                auto submit = [&](const cv::Mat& crop, OcrFetchResult& fetch) {
+                    if (ctx.stopRequested()) {
+                        return;
+                    }
+                    const int64_t taskId = allocateOcrTaskId();
+                    fetch.submitted = submitOcrTask(crop, taskId);
+                    if (fetch.submitted) {
+                        submittedIds.push_back(taskId);
+                        targets.emplace_back(&fetch, taskId);
+                    }
+                };
+
+                {
+                    TRACE_SPAN("ocr_submit", "ocr");
+                    for (size_t i = 0; i < ocrWorkItems.size(); ++i) {
+                        const auto& item = ocrWorkItems[i];
+                        if (item.skipped || item.crop.empty() ||
+                            (cache != nullptr && cachedTexts[i])) {
+                            continue;
+                        }
+                        submit(item.crop, fetchResults[i]);
+                    }
+                    if (tableOcrEnabled) {
+                        for (size_t i = 0; i < tableWorkItems.size(); ++i) {
+                            const auto& item = tableWorkItems[i];
+                            if (item.invalidRoi || item.ocrCrop.empty()) {
+                                continue;
+                            }
+                            submit(item.ocrCrop, tableOcrResults[i]);
+                        }
+                    }
+                }
 
-                fetch.submitted = submitOcrTask(item.crop, taskId);
-                if (!fetch.submitted) {
-                    continue;
+                std::unordered_map<int64_t, BufferedOcrResult> completed;
+                {
+                    TRACE_SPAN("ocr_wait", "ocr");
+                    waitForOcrResults(submittedIds, completed, &ctx);
                 }
-                fetch.fetched = waitForOcrResult(taskId, fetch.results, fetch.success);
-                if (!fetch.fetched) {
-                    LOG_WARN("OCR timeout for task {}", taskId);
+                for (auto& target : targets) {
+                    auto done = completed.find(target.second);
+                    if (done == completed.end()) {
+                        LOG_WARN("OCR timeout for task {}", target.second);
+                        continue;
+                    }
+                    target.first->fetched = true;
+                    target.first->success = done->second.success;
+                    target.first->results = std::move(done->second.results);
                 }
-            }
-        });
+            });
+        }
 
         {
             auto assembleStart = std::chrono::steady_clock::now();
@@ -657,8 +1799,18 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
                 }
 
                 const auto& fetch = fetchResults[i];
-                if (fetch.fetched && fetch.success && !fetch.results.empty()) {
-                    elem.text = combineOcrTextLines(fetch.results);
+                if (item.layerText) {
+                    elem.text = *item.layerText;
+                } else if (cache != nullptr && cachedTexts[i]) {
+                    elem.text = std::move(*cachedTexts[i]);
+                } else {
+                    if (fetch.fetched && fetch.success && !fetch.results.empty()) {
+                        elem.text = combineOcrTextLines(fetch.results);
+                    }
+                    if (cache != nullptr && fetch.fetched && fetch.success) {
+                        cache->ocrTexts.put(
+                            ocrDigests[i], elem.text, sizeof(std::string) + elem.text.size());
+                    }
                 }
                 result.elements.push_back(std::move(elem));
             }
@@ -668,33 +1820,15 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
         }
     }
 
-    // Table recognition remains NPU-serialized.
+    // Table UNET runs on its own NPU lane.
     if (ctx.stages.enableWiredTable) {
-        std::vector<TableWorkItem> tableWorkItems;
-        {
-            auto prepStart = std::chrono::steady_clock::now();
-            tableWorkItems.reserve(tableBoxes.size());
-            for (const auto& box : tableBoxes) {
-                TableWorkItem item;
-                item.box = box;
-                item.pageIndex = pageImage.pageIndex;
-                cv::Rect roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
-                if (roi.width <= 0 || roi.height <= 0) {
-                    item.invalidRoi = true;
-                } else {
-                    // CPU-only crop clone: safe outside NPU serial lock.
-                    item.crop = image(roi).clone();
-                }
-                tableWorkItems.push_back(std::move(item));
-            }
-            auto prepEnd = std::chrono::steady_clock::now();
-            cpuOnlyTotalMs +=
-                std::chrono::duration<double, std::milli>(prepEnd - prepStart).count();
-        }
-
         std::vector<TableNpuResult> tableNpuResults;
-        const double tableNpuStageMs = runNpuSerialized([&]() {
+        const double tableNpuStageMs = runNpuStage(work, NpuEngine::TABLE, [&]() {
             tableNpuResults.reserve(tableWorkItems.size());
+            // UNET crops are collected and run as one batch so preprocessing
+            // of one table overlaps the NPU run of the previous one.
+            std::vector<cv::Mat> npuCrops;
+            std::vector<size_t> npuSlots;
             for (const auto& item : tableWorkItems) {
                 TableNpuResult npuResult;
                 npuResult.box = item.box;
@@ -727,28 +1861,37 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
                         continue;
                     }
                 } else {
-                    npuResult.npuStage = recognizeTableNpuStage(item.crop);
-                    if (!npuResult.npuStage.supported) {
-                        npuResult.hasFallback = true;
-                        npuResult.fallbackReason =
-                            (npuResult.npuStage.type == TableType::WIRELESS)
-                                ? "wireless_table"
-                                : "table_model_unavailable";
-                        tableNpuResults.push_back(std::move(npuResult));
-                        continue;
-                    }
+                    npuSlots.push_back(tableNpuResults.size());
+                    npuCrops.push_back(item.crop);
                 }
 
                 tableNpuResults.push_back(std::move(npuResult));
             }
+
+            if (npuCrops.empty()) {
+                return;
+            }
+            auto npuStages = recognizeTableNpuStageBatch(npuCrops);
+            for (size_t k = 0; k < npuSlots.size(); ++k) {
+                auto& npuResult = tableNpuResults[npuSlots[k]];
+                npuResult.npuStage = std::move(npuStages[k]);
+                if (!npuResult.npuStage.supported) {
+                    npuResult.hasFallback = true;
+                    npuResult.fallbackReason =
+                        (npuResult.npuStage.type == TableType::WIRELESS)
+                            ? "wireless_table"
+                            : "table_model_unavailable";
+                }
+            }
         });
 
         {
+            // Line extraction and structure recovery are independent per table.
             auto postprocessStart = std::chrono::steady_clock::now();
-            for (size_t i = 0; i < tableNpuResults.size(); ++i) {
+            postprocessPool().parallelFor(tableNpuResults.size(), [&](size_t i) {
                 auto& npuResult = tableNpuResults[i];
                 if (npuResult.hasFallback || npuResult.hasTableResult) {
-                    continue;
+                    return;
                 }
 
                 npuResult.tableResult =
@@ -761,53 +1904,38 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
                         (npuResult.tableResult.type == TableType::WIRELESS)
                             ? "wireless_table"
                             : "table_model_unavailable";
-                    continue;
+                    return;
                 }
 
                 if (npuResult.tableResult.cells.empty()) {
                     npuResult.hasFallback = true;
                     npuResult.fallbackReason = "no_cell_table";
-                    continue;
                 }
-            }
+            });
             auto postprocessEnd = std::chrono::steady_clock::now();
             cpuOnlyTotalMs +=
                 std::chrono::duration<double, std::milli>(postprocessEnd - postprocessStart).count();
         }
 
-        double tableOcrNpuMs = 0.0;
-        const bool tableOcrEnabled =
-            ctx.stages.enableOcr && (ocrPipeline_ || (ocrSubmitHook_ && ocrFetchHook_));
         if (tableOcrEnabled) {
-            tableOcrNpuMs = runNpuSerialized([&]() {
-                for (size_t i = 0; i < tableNpuResults.size(); ++i) {
-                    auto& npuResult = tableNpuResults[i];
-                    if (npuResult.hasFallback || !npuResult.hasTableResult) {
-                        continue;
-                    }
-
-                    const int64_t ocrTaskId = allocateOcrTaskId();
-                    if (submitOcrTask(tableWorkItems[i].crop, ocrTaskId)) {
-                        bool ok = false;
-                        if (!(waitForOcrResult(ocrTaskId, npuResult.ocrBoxes, ok) && ok)) {
-                            npuResult.ocrBoxes.clear();
-                        }
-                    }
+            for (size_t i = 0; i < tableNpuResults.size(); ++i) {
+                auto& fetch = tableOcrResults[i];
+                if (fetch.fetched && fetch.success) {
+                    tableNpuResults[i].ocrBoxes = std::move(fetch.results);
                 }
             }
-            );
         }
-        result.stats.tableTimeMs = tableNpuStageMs + tableOcrNpuMs;
+        result.stats.tableTimeMs = tableNpuStageMs;
 
-        std::vector<ContentElement> tableElements;
+        std::vector<ContentElement> tableElements(tableNpuResults.size());
         {
             auto assembleStart = std::chrono::steady_clock::now();
-            tableElements.reserve(tableNpuResults.size());
-            for (auto& npuResult : tableNpuResults) {
+            postprocessPool().parallelFor(tableNpuResults.size(), [&](size_t i) {
+                auto& npuResult = tableNpuResults[i];
                 if (npuResult.hasFallback) {
-                    tableElements.push_back(makeTableFallbackElement(
-                        npuResult.box, npuResult.pageIndex, npuResult.fallbackReason));
-                    continue;
+                    tableElements[i] = makeTableFallbackElement(
+                        npuResult.box, npuResult.pageIndex, npuResult.fallbackReason);
+                    return;
                 }
 
                 matchTableOcrToCells(npuResult.tableResult, npuResult.ocrBoxes);
@@ -822,31 +1950,58 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
                 } catch (const std::exception& ex) {
                     LOG_WARN("Illegal table structure at page {}: {}",
                              npuResult.pageIndex, ex.what());
-                    tableElements.push_back(makeTableFallbackElement(
-                        npuResult.box, npuResult.pageIndex, "illegal_table_structure"));
-                    continue;
+                    tableElements[i] = makeTableFallbackElement(
+                        npuResult.box, npuResult.pageIndex, "illegal_table_structure");
+                    return;
                 }
 
                 if (elem.html.empty()) {
-                    tableElements.push_back(makeTableFallbackElement(
-                        npuResult.box, npuResult.pageIndex, "empty_table_html"));
-                    continue;
+                    tableElements[i] = makeTableFallbackElement(
+                        npuResult.box, npuResult.pageIndex, "empty_table_html");
+                    return;
                 }
 
                 elem.skipped = false;
-                tableElements.push_back(std::move(elem));
-            }
+                tableElements[i] = std::move(elem);
+            });
             auto assembleEnd = std::chrono::steady_clock::now();
             cpuOnlyTotalMs +=
                 std::chrono::duration<double, std::milli>(assembleEnd - assembleStart).count();
         }
 
-        result.elements.insert(result.elements.end(), tableElements.begin(), tableElements.end());
+        result.elements.insert(result.elements.end(),
+                               std::make_move_iterator(tableElements.begin()),
+                               std::make_move_iterator(tableElements.end()));
     }
 
-    result.stats.npuLockWaitTimeMs = npuLockWaitTotalMs;
-    result.stats.npuLockHoldTimeMs = npuLockHoldTotalMs;
-    result.stats.npuSerialTimeMs = npuSerialTotalMs;
+    auto stageEnd = std::chrono::steady_clock::now();
+    work.activeTimeMs += std::chrono::duration<double, std::milli>(stageEnd - stageStart).count();
+}
+
+PageResult DocPipeline::runPostprocessStage(PageWork& work, const ExecutionContext& ctx) {
+    TRACE_SPAN("DocPipeline::runPostprocessStage", "pipeline");
+    auto stageStart = std::chrono::steady_clock::now();
+    const PageImage& pageImage = work.page;
+    const cv::Mat& image = pageImage.image;
+    PageResult& result = work.result;
+    int pageWidth = image.cols;
+    int pageHeight = image.rows;
+    const auto& boxes = result.layoutResult.boxes;
+    const LayoutBoxView figureBoxes = work.buckets.view(boxes, LayoutBucket::FIGURE);
+    const LayoutBoxView equationBoxes = work.buckets.view(boxes, LayoutBucket::EQUATION);
+    const LayoutBoxView unsupportedBoxes = work.buckets.view(boxes, LayoutBucket::UNSUPPORTED);
+
+    const auto& npuWait = work.npuWaitMs;
+    const auto& npuHold = work.npuHoldMs;
+    result.stats.layoutNpuWaitTimeMs = npuWait[static_cast<size_t>(NpuEngine::LAYOUT)];
+    result.stats.layoutNpuHoldTimeMs = npuHold[static_cast<size_t>(NpuEngine::LAYOUT)];
+    result.stats.ocrNpuWaitTimeMs = npuWait[static_cast<size_t>(NpuEngine::OCR)];
+    result.stats.ocrNpuHoldTimeMs = npuHold[static_cast<size_t>(NpuEngine::OCR)];
+    result.stats.tableNpuWaitTimeMs = npuWait[static_cast<size_t>(NpuEngine::TABLE)];
+    result.stats.tableNpuHoldTimeMs = npuHold[static_cast<size_t>(NpuEngine::TABLE)];
+    result.stats.npuLockWaitTimeMs = std::accumulate(npuWait.begin(), npuWait.end(), 0.0);
+    result.stats.npuLockHoldTimeMs = std::accumulate(npuHold.begin(), npuHold.end(), 0.0);
+    result.stats.npuSerialTimeMs = work.npuSerialTotalMs;
 
     // CPU-only region (safe to execute outside NPU serial lock).
     auto cpuStart = std::chrono::steady_clock::now();
@@ -905,14 +2060,20 @@ PageResult DocPipeline::processPage(const PageImage& pageImage, const ExecutionC
     }
 
     auto cpuEnd = std::chrono::steady_clock::now();
-    cpuOnlyTotalMs +=
+    const double postprocessCpuMs =
         std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
-    result.stats.cpuOnlyTimeMs = cpuOnlyTotalMs;
-
-    auto endTime = std::chrono::steady_clock::now();
-    result.totalTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
-
-    return result;
+    result.stats.npuStageCpuTimeMs = work.cpuOnlyTotalMs;
+    result.stats.postprocessCpuTimeMs = postprocessCpuMs;
+    work.cpuOnlyTotalMs += postprocessCpuMs;
+    result.stats.cpuOnlyTimeMs = work.cpuOnlyTotalMs;
+
+    auto stageEnd = std::chrono::steady_clock::now();
+    work.activeTimeMs += std::chrono::duration<double, std::milli>(stageEnd - stageStart).count();
+    // Time spent waiting in inter-stage queues is excluded so pipelined and
+    // serial runs report comparable per-page processing time.
+    result.totalTimeMs = work.activeTimeMs;
+
+    return std::move(result);
 }
 
 // ---------------------------------------------------------------------------
@@ -949,7 +2110,18 @@ bool DocPipeline::submitOcrTask(const cv::Mat& crop, int64_t taskId) {
     if (!ocrPipeline_) {
         return false;
     }
-    return ocrPipeline_->pushTask(crop, taskId);
+    if (replaySession_ && replaySession_->recording()) {
+        replaySession_->ocrSubmitted(crop, taskId);
+    }
+    return ocrPipeline_->pushTask(ocrInput(crop), taskId);
+}
+
+cv::Mat DocPipeline::ocrInput(const cv::Mat& crop) {
+    // Stand-in engines read ROI views fine; the OCR backend takes contiguous pixels.
+    if (ocrSubmitHook_ || crop.empty() || crop.isContinuous()) {
+        return crop;
+    }
+    return pageBuffers_->copyOf(crop);
 }
 
 bool DocPipeline::fetchOcrResult(
@@ -963,7 +2135,13 @@ bool DocPipeline::fetchOcrResult(
     if (!ocrPipeline_) {
         return false;
     }
-    return ocrPipeline_->getResult(results, resultId, nullptr, &success);
+    if (!ocrPipeline_->getResult(results, resultId, nullptr, &success)) {
+        return false;
+    }
+    if (replaySession_ && replaySession_->recording()) {
+        replaySession_->ocrCompleted(resultId, results, success);
+    }
+    return true;
 }
 
 bool DocPipeline::waitForOcrResult(
@@ -974,74 +2152,113 @@ bool DocPipeline::waitForOcrResult(
     results.clear();
     success = false;
 
-    {
-        std::lock_guard<std::mutex> lock(ocrStateMutex_);
-        // Keep OCR transient state bounded without clearing active request data.
-        const int64_t pruneBeforeTaskId = taskId - 4096;
-        if (pruneBeforeTaskId > 0) {
-            for (auto it = timedOutOcrTaskIds_.begin(); it != timedOutOcrTaskIds_.end();) {
-                if (*it < pruneBeforeTaskId) {
-                    it = timedOutOcrTaskIds_.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-            for (auto it = bufferedOcrResults_.begin(); it != bufferedOcrResults_.end();) {
-                if (it->first < pruneBeforeTaskId) {
-                    it = bufferedOcrResults_.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-        }
+    std::unordered_map<int64_t, BufferedOcrResult> completed;
+    if (!waitForOcrResults({taskId}, completed)) {
+        return false;
+    }
+    auto& done = completed.at(taskId);
+    results = std::move(done.results);
+    success = done.success;
+    return true;
+}
 
-        auto buffered = bufferedOcrResults_.find(taskId);
-        if (buffered != bufferedOcrResults_.end()) {
-            results = std::move(buffered->second.results);
-            success = buffered->second.success;
-            bufferedOcrResults_.erase(buffered);
-            return true;
-        }
+bool DocPipeline::waitForOcrResults(
+    const std::vector<int64_t>& taskIds,
+    std::unordered_map<int64_t, BufferedOcrResult>& completed,
+    const ExecutionContext* ctx)
+{
+    completed.clear();
+    if (taskIds.empty()) {
+        return true;
     }
 
-    auto deadline = std::chrono::steady_clock::now() + ocrWaitTimeout_;
-    while (std::chrono::steady_clock::now() <= deadline) {
-        std::vector<ocr::PipelineOCRResult> fetchedResults;
-        int64_t resultId = -1;
-        bool fetchedSuccess = false;
-        if (!fetchOcrResult(fetchedResults, resultId, fetchedSuccess)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    // Each task's result lands in its own completion slot, and this call
+    // sleeps on its own waiter: only results it is waiting for wake it.
+    OcrCompletionTable::Waiter waiter;
+    std::vector<int64_t> pending;
+    pending.reserve(taskIds.size());
+    bool lostAny = false;
+    for (int64_t taskId : taskIds) {
+        if (ocrCompletions_.watch(taskId, waiter) == OcrCompletionTable::Status::LOST) {
+            LOG_WARN("OCR task {} is stale; not waiting for it", taskId);
+            lostAny = true;
             continue;
         }
+        pending.push_back(taskId);
+    }
 
-        if (resultId == taskId) {
-            results = std::move(fetchedResults);
-            success = fetchedSuccess;
-            return true;
+    auto collect = [&]() {
+        for (auto it = pending.begin(); it != pending.end();) {
+            BufferedOcrResult done;
+            const auto status = ocrCompletions_.take(*it, done);
+            if (status == OcrCompletionTable::Status::PENDING) {
+                ++it;
+                continue;
+            }
+            if (status == OcrCompletionTable::Status::READY) {
+                completed[*it] = std::move(done);
+            } else {
+                LOG_WARN("OCR task {} lost: its completion slot went to a newer task", *it);
+                lostAny = true;
+            }
+            it = pending.erase(it);
         }
+    };
 
-        bool isStale = false;
-        {
-            std::lock_guard<std::mutex> lock(ocrStateMutex_);
-            isStale = (timedOutOcrTaskIds_.count(resultId) > 0 || resultId < taskId);
-            if (!isStale) {
-                bufferedOcrResults_[resultId] = {std::move(fetchedResults), fetchedSuccess};
+    // The OCR pipeline only offers a non-blocking getResult(). One waiter at
+    // a time moves everything it has finished into the slots, waking their
+    // owners; the others sleep on their waiters with a short, growing
+    // timeout in case the drainer leaves before their results are out.
+    auto drain = [&]() {
+        if (!ocrCompletions_.tryBeginDrain()) {
+            return false;
+        }
+        bool fetchedAny = false;
+        BufferedOcrResult fetched;
+        int64_t resultId = -1;
+        while (fetchOcrResult(fetched.results, resultId, fetched.success)) {
+            fetchedAny = true;
+            if (!ocrCompletions_.complete(resultId, std::move(fetched))) {
+                LOG_WARN("Discarding stale OCR result {}", resultId);
             }
+            fetched = BufferedOcrResult{};
+            resultId = -1;
         }
+        ocrCompletions_.endDrain();
+        return fetchedAny;
+    };
 
-        if (isStale) {
-            LOG_WARN("Discarding stale OCR result {} while waiting for {}", resultId, taskId);
-            continue;
-        }
+    constexpr auto kMinIdleWait = std::chrono::microseconds(100);
+    constexpr auto kMaxIdleWait = std::chrono::microseconds(2000);
+    auto idleWait = kMinIdleWait;
+    // Tasks abandoned at the run's deadline or cancellation are dropped like timed-out ones.
+    auto deadline = std::chrono::steady_clock::now() + ocrWaitTimeout_;
+    if (ctx != nullptr && ctx->deadline) {
+        deadline = std::min(deadline, *ctx->deadline);
+    }
+    auto cancelled = [ctx]() {
+        return ctx != nullptr && ctx->cancel && ctx->cancel->cancelled();
+    };
 
-        LOG_DEBUG("Buffered out-of-order OCR result {} while waiting for {}", resultId, taskId);
+    collect();
+    while (!pending.empty() && std::chrono::steady_clock::now() <= deadline && !cancelled()) {
+        const bool fetchedAny = drain();
+        collect();
+        if (pending.empty()) {
+            break;
+        }
+        if (fetchedAny || waiter.waitFor(idleWait)) {
+            idleWait = kMinIdleWait;
+        } else {
+            idleWait = std::min(idleWait * 2, kMaxIdleWait);
+        }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(ocrStateMutex_);
-        timedOutOcrTaskIds_.insert(taskId);
+    // A late result for an abandoned task is dropped on arrival.
+    for (int64_t taskId : pending) {
+        ocrCompletions_.abandon(taskId);
     }
-    return false;
+    return pending.empty() && !lostAny;
 }
 
 int64_t DocPipeline::allocateOcrTaskId() {
@@ -1053,7 +2270,7 @@ int64_t DocPipeline::allocateOcrTaskId() {
 // ---------------------------------------------------------------------------
 std::vector<ContentElement> DocPipeline::runOcrOnRegions(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& textBoxes,
+    LayoutBoxView textBoxes,
     int pageIndex)
 {
     std::vector<ContentElement> elements;
@@ -1075,7 +2292,7 @@ std::vector<ContentElement> DocPipeline::runOcrOnRegions(
             continue;
         }
 
-        elem.text = ocrOnCrop(image(roi).clone(), allocateOcrTaskId());
+        elem.text = ocrOnCrop(image(roi), allocateOcrTaskId());
         elements.push_back(elem);
     }
 
@@ -1087,7 +2304,7 @@ std::vector<ContentElement> DocPipeline::runOcrOnRegions(
 // ---------------------------------------------------------------------------
 std::vector<ContentElement> DocPipeline::runTableRecognition(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& tableBoxes,
+    LayoutBoxView tableBoxes,
     int pageIndex)
 {
     return runTableRecognition(image, tableBoxes, pageIndex, makeExecutionContext(nullptr));
@@ -1095,7 +2312,7 @@ std::vector<ContentElement> DocPipeline::runTableRecognition(
 
 std::vector<ContentElement> DocPipeline::runTableRecognition(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& tableBoxes,
+    LayoutBoxView tableBoxes,
     int pageIndex,
     const ExecutionContext& ctx)
 {
@@ -1135,7 +2352,7 @@ std::vector<ContentElement> DocPipeline::runTableRecognition(
         // 2. Match each OCR text box to the nearest cell by spatial overlap
         if (ctx.stages.enableOcr && (ocrPipeline_ || (ocrSubmitHook_ && ocrFetchHook_))) {
             const int64_t ocrTaskId = allocateOcrTaskId();
-            if (submitOcrTask(tableCrop.clone(), ocrTaskId)) {
+            if (submitOcrTask(tableCrop, ocrTaskId)) {
                 std::vector<ocr::PipelineOCRResult> ocrBoxes;
                 bool ok = false;
                 if (waitForOcrResult(ocrTaskId, ocrBoxes, ok) && ok && !ocrBoxes.empty()) {
@@ -1174,17 +2391,23 @@ TableResult DocPipeline::recognizeTable(const cv::Mat& tableCrop) {
         unavailable.supported = false;
         return unavailable;
     }
-    return tableRecognizer_->recognize(tableCrop);
+    TableResult result = tableRecognizer_->recognize(tableCrop);
+    if (replaySession_ && replaySession_->recording()) {
+        replaySession_->recordTable(tableCrop, result, result.inferenceTimeMs);
+    }
+    return result;
 }
 
-TableRecognizer::NpuStageResult DocPipeline::recognizeTableNpuStage(const cv::Mat& tableCrop) {
-    TableRecognizer::NpuStageResult unavailable;
-    unavailable.type = TableType::UNKNOWN;
-    unavailable.supported = false;
+std::vector<TableRecognizer::NpuStageResult> DocPipeline::recognizeTableNpuStageBatch(
+    const std::vector<cv::Mat>& tableCrops)
+{
     if (!tableRecognizer_) {
-        return unavailable;
+        TableRecognizer::NpuStageResult unavailable;
+        unavailable.type = TableType::UNKNOWN;
+        unavailable.supported = false;
+        return std::vector<TableRecognizer::NpuStageResult>(tableCrops.size(), unavailable);
     }
-    return tableRecognizer_->recognizeNpuStage(tableCrop);
+    return tableRecognizer_->recognizeNpuStageBatch(tableCrops);
 }
 
 TableResult DocPipeline::finalizeTableRecognizePostprocess(
@@ -1197,7 +2420,11 @@ TableResult DocPipeline::finalizeTableRecognizePostprocess(
         unavailable.supported = false;
         return unavailable;
     }
-    return tableRecognizer_->finalizeRecognizePostprocess(tableCrop, npuStage);
+    TableResult result = tableRecognizer_->finalizeRecognizePostprocess(tableCrop, npuStage);
+    if (replaySession_ && replaySession_->recording()) {
+        replaySession_->recordTable(tableCrop, result, result.inferenceTimeMs);
+    }
+    return result;
 }
 
 std::string DocPipeline::generateTableHtml(const std::vector<TableCell>& cells) {
@@ -1229,7 +2456,7 @@ ContentElement DocPipeline::makeTableFallbackElement(
 }
 
 std::vector<ContentElement> DocPipeline::handleUnsupportedElements(
-    const std::vector<LayoutBox>& unsupportedBoxes,
+    LayoutBoxView unsupportedBoxes,
     int pageIndex)
 {
     std::vector<ContentElement> elements;
@@ -1259,90 +2486,106 @@ std::vector<ContentElement> DocPipeline::handleUnsupportedElements(
 
 void DocPipeline::saveExtractedImages(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& figureBoxes,
+    LayoutBoxView figureBoxes,
     int pageIndex,
     std::vector<ContentElement>& elements)
 {
-    saveExtractedImages(image, figureBoxes, pageIndex, elements, makeExecutionContext(nullptr));
+    const auto ctx = makeExecutionContext(nullptr);
+    saveExtractedImages(image, figureBoxes, pageIndex, elements, ctx);
+    claimRegionImages(ctx.imageWrites.get(), elements);
+    if (ctx.imageWrites) ctx.imageWrites->wait();
 }
 
 void DocPipeline::saveExtractedImages(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& figureBoxes,
+    LayoutBoxView figureBoxes,
     int pageIndex,
     std::vector<ContentElement>& elements,
     const ExecutionContext& ctx)
 {
-    for (size_t i = 0; i < figureBoxes.size(); i++) {
-        const auto& box = figureBoxes[i];
-        cv::Rect roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
+    saveRegionImages(image, figureBoxes, pageIndex, "_fig", ContentElement::Type::IMAGE,
+                     elements, ctx);
+}
+
+void DocPipeline::saveRegionImages(
+    const cv::Mat& image,
+    LayoutBoxView boxes,
+    int pageIndex,
+    const char* suffix,
+    ContentElement::Type type,
+    std::vector<ContentElement>& elements,
+    const ExecutionContext& ctx)
+{
+    std::vector<size_t> kept;
+    std::vector<cv::Rect> rois;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        cv::Rect roi = boxes[i].toRect() & cv::Rect(0, 0, image.cols, image.rows);
         if (roi.width <= 0 || roi.height <= 0) continue;
+        kept.push_back(i);
+        rois.push_back(roi);
+    }
+    if (kept.empty()) {
+        return;
+    }
 
-        std::string filename = "images/page" + std::to_string(pageIndex) +
-                               "_fig" + std::to_string(i) + ".png";
+    const bool save = ctx.runtime.saveImages && ctx.imageWrites;
+    std::vector<std::string> filenames(kept.size());
+    if (save) {
+        const char* extension = ctx.imageWrites->encoding().extension();
+        for (size_t k = 0; k < kept.size(); ++k) {
+            filenames[k] = "images/page" + std::to_string(pageIndex) +
+                           suffix + std::to_string(kept[k]) + extension;
+        }
 
-        if (ctx.runtime.saveImages) {
-            cv::Mat figureCrop = image(roi);
-            std::string filepath = ctx.runtime.outputDir + "/" + filename;
-            std::filesystem::create_directories(
-                std::filesystem::path(filepath).parent_path());
-            cv::imwrite(filepath, figureCrop);
+        // Encoding runs on the image writer; the crops share the page pixels.
+        // A crop already stored in this run (a logo or stamp on every page)
+        // refers to that file instead. That is decided when the page is
+        // claimed in page order (claimRegionImages), not here, where pages
+        // may finish in any order.
+        std::filesystem::create_directories(
+            std::filesystem::path(ctx.runtime.outputDir) / "images");
+        for (size_t k = 0; k < kept.size(); ++k) {
+            const cv::Mat crop = image(rois[k]);
+            ctx.imageWrites->stageDeduplicated(
+                crop, digestImage(crop), ctx.runtime.outputDir + "/" + filenames[k], filenames[k]);
         }
+    }
 
+    for (size_t k = 0; k < kept.size(); ++k) {
         ContentElement elem;
-        elem.type = ContentElement::Type::IMAGE;
-        elem.layoutBox = box;
+        elem.type = type;
+        elem.layoutBox = boxes[kept[k]];
         elem.pageIndex = pageIndex;
-        if (ctx.runtime.saveImages) {
-            elem.imagePath = filename;
+        if (save) {
+            elem.imagePath = std::move(filenames[k]);
         }
-        elements.push_back(elem);
+        elements.push_back(std::move(elem));
     }
 }
 
 void DocPipeline::saveFormulaImages(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& equationBoxes,
+    LayoutBoxView equationBoxes,
     int pageIndex,
     std::vector<ContentElement>& elements)
 {
-    saveFormulaImages(image, equationBoxes, pageIndex, elements, makeExecutionContext(nullptr));
+    const auto ctx = makeExecutionContext(nullptr);
+    saveFormulaImages(image, equationBoxes, pageIndex, elements, ctx);
+    claimRegionImages(ctx.imageWrites.get(), elements);
+    if (ctx.imageWrites) ctx.imageWrites->wait();
 }
 
 void DocPipeline::saveFormulaImages(
     const cv::Mat& image,
-    const std::vector<LayoutBox>& equationBoxes,
+    LayoutBoxView equationBoxes,
     int pageIndex,
     std::vector<ContentElement>& elements,
     const ExecutionContext& ctx)
 {
     // Python behavior: formula regions are saved as images, rendered as ![]()
     // No LaTeX recognition (onnx model not available on NPU).
-    for (size_t i = 0; i < equationBoxes.size(); i++) {
-        const auto& box = equationBoxes[i];
-        cv::Rect roi = box.toRect() & cv::Rect(0, 0, image.cols, image.rows);
-        if (roi.width <= 0 || roi.height <= 0) continue;
-
-        std::string filename = "images/page" + std::to_string(pageIndex) +
-                               "_eq" + std::to_string(i) + ".png";
-
-        if (ctx.runtime.saveImages) {
-            cv::Mat crop = image(roi);
-            std::string filepath = ctx.runtime.outputDir + "/" + filename;
-            std::filesystem::create_directories(
-                std::filesystem::path(filepath).parent_path());
-            cv::imwrite(filepath, crop);
-        }
-
-        ContentElement elem;
-        elem.type = ContentElement::Type::EQUATION;
-        elem.layoutBox = box;
-        elem.pageIndex = pageIndex;
-        if (ctx.runtime.saveImages) {
-            elem.imagePath = filename;  // store path for image-based formula output
-        }
-        elements.push_back(elem);
-    }
+    saveRegionImages(image, equationBoxes, pageIndex, "_eq", ContentElement::Type::EQUATION,
+                     elements, ctx);
 }
 
 void DocPipeline::saveLayoutVisualization(
@@ -1350,7 +2593,9 @@ void DocPipeline::saveLayoutVisualization(
     const LayoutResult& layoutResult,
     int pageIndex)
 {
-    saveLayoutVisualization(image, layoutResult, pageIndex, makeExecutionContext(nullptr));
+    const auto ctx = makeExecutionContext(nullptr);
+    saveLayoutVisualization(image, layoutResult, pageIndex, ctx);
+    if (ctx.imageWrites) ctx.imageWrites->wait();
 }
 
 void DocPipeline::saveLayoutVisualization(
@@ -1359,7 +2604,7 @@ void DocPipeline::saveLayoutVisualization(
     int pageIndex,
     const ExecutionContext& ctx)
 {
-    if (image.empty()) {
+    if (image.empty() || !ctx.imageWrites) {
         return;
     }
 
@@ -1405,10 +2650,11 @@ void DocPipeline::saveLayoutVisualization(
     }
 
     std::ostringstream filename;
-    filename << "layout/page_" << std::setw(4) << std::setfill('0') << pageIndex << "_layout.png";
+    filename << "layout/page_" << std::setw(4) << std::setfill('0') << pageIndex << "_layout"
+             << ctx.imageWrites->encoding().extension();
     const std::string filepath = ctx.runtime.outputDir + "/" + filename.str();
     std::filesystem::create_directories(std::filesystem::path(filepath).parent_path());
-    cv::imwrite(filepath, vis);
+    ctx.imageWrites->submit(std::move(vis), filepath);
 }
 
 void DocPipeline::reportProgress(const std::string& stage, int current, int total) {
@@ -1417,4 +2663,13 @@ void DocPipeline::reportProgress(const std::string& stage, int current, int tota
     }
 }
 
+void DocPipeline::reportProgress(
+    const ExecutionContext& ctx, const std::string& stage, int current, int total)
+{
+    reportProgress(stage, current, total);
+    if (ctx.progress) {
+        ctx.progress(stage, current, total);
+    }
+}
+
 } // namespace rapid_doc
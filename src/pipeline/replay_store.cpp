@@ -0,0 +1,487 @@
+/**
+ * @file replay_store.cpp
+ * @brief JSONL record / replay of engine outputs
+ */
+
+#include "pipeline/replay_store.h"
+#include "pipeline/recognition_cache.h"
+#include "common/logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace rapid_doc {
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr const char* kEngineFiles[] = {"layout.jsonl", "table.jsonl", "ocr.jsonl"};
+constexpr const char* kEngineNames[] = {"layout", "table", "ocr"};
+
+size_t slot(ReplayStore::Engine engine) {
+    return static_cast<size_t>(engine);
+}
+
+bool parseDigest(const std::string& hex, ContentDigest& digest) {
+    if (hex.size() != 32) {
+        return false;
+    }
+    try {
+        digest.a = std::stoull(hex.substr(0, 16), nullptr, 16);
+        digest.b = std::stoull(hex.substr(16), nullptr, 16);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+json layoutToJson(const LayoutResult& result) {
+    json boxes = json::array();
+    for (const auto& box : result.boxes) {
+        boxes.push_back({
+            {"bbox", {box.x0, box.y0, box.x1, box.y1}},
+            {"category", static_cast<int>(box.category)},
+            {"score", box.confidence},
+            {"index", box.index},
+            {"cls_id", box.clsId},
+            {"label", box.label},
+        });
+    }
+    return boxes;
+}
+
+LayoutResult layoutFromJson(const json& boxes) {
+    LayoutResult result;
+    result.boxes.reserve(boxes.size());
+    for (const auto& item : boxes) {
+        LayoutBox box;
+        const auto& bbox = item.at("bbox");
+        box.x0 = bbox.at(0).get<float>();
+        box.y0 = bbox.at(1).get<float>();
+        box.x1 = bbox.at(2).get<float>();
+        box.y1 = bbox.at(3).get<float>();
+        box.category = static_cast<LayoutCategory>(item.at("category").get<int>());
+        box.confidence = item.at("score").get<float>();
+        box.index = item.value("index", 0);
+        box.clsId = item.value("cls_id", -1);
+        box.label = internLayoutLabel(item.value("label", std::string()));
+        result.boxes.push_back(std::move(box));
+    }
+    return result;
+}
+
+json tableToJson(const TableResult& result) {
+    json cells = json::array();
+    for (const auto& cell : result.cells) {
+        cells.push_back({
+            {"row", cell.row},
+            {"col", cell.col},
+            {"row_span", cell.rowSpan},
+            {"col_span", cell.colSpan},
+            {"bbox", {cell.x0, cell.y0, cell.x1, cell.y1}},
+            {"poly", std::vector<float>(cell.poly, cell.poly + 8)},
+            {"content", cell.content},
+        });
+    }
+    return {
+        {"type", static_cast<int>(result.type)},
+        {"supported", result.supported},
+        {"html", result.html},
+        {"cells", std::move(cells)},
+    };
+}
+
+TableResult tableFromJson(const json& item) {
+    TableResult result;
+    result.type = static_cast<TableType>(item.at("type").get<int>());
+    result.supported = item.at("supported").get<bool>();
+    result.html = item.at("html").get<std::string>();
+    for (const auto& c : item.at("cells")) {
+        TableCell cell{};
+        cell.row = c.at("row").get<int>();
+        cell.col = c.at("col").get<int>();
+        cell.rowSpan = c.at("row_span").get<int>();
+        cell.colSpan = c.at("col_span").get<int>();
+        const auto& bbox = c.at("bbox");
+        cell.x0 = bbox.at(0).get<float>();
+        cell.y0 = bbox.at(1).get<float>();
+        cell.x1 = bbox.at(2).get<float>();
+        cell.y1 = bbox.at(3).get<float>();
+        const auto& poly = c.at("poly");
+        for (size_t i = 0; i < 8 && i < poly.size(); ++i) {
+            cell.poly[i] = poly[i].get<float>();
+        }
+        cell.content = c.value("content", std::string());
+        result.cells.push_back(std::move(cell));
+    }
+    return result;
+}
+
+json ocrToJson(const std::vector<ocr::PipelineOCRResult>& lines) {
+    json out = json::array();
+    for (const auto& line : lines) {
+        json box = json::array();
+        for (const auto& point : line.box) {
+            box.push_back({point.x, point.y});
+        }
+        out.push_back({
+            {"text", line.text},
+            {"score", line.confidence},
+            {"index", line.index},
+            {"box", std::move(box)},
+        });
+    }
+    return out;
+}
+
+std::vector<ocr::PipelineOCRResult> ocrFromJson(const json& items) {
+    std::vector<ocr::PipelineOCRResult> lines;
+    lines.reserve(items.size());
+    for (const auto& item : items) {
+        ocr::PipelineOCRResult line;
+        line.text = item.at("text").get<std::string>();
+        line.confidence = item.at("score").get<float>();
+        line.index = item.value("index", 0);
+        std::array<cv::Point2f, 4> points{};
+        const auto& box = item.at("box");
+        for (size_t i = 0; i < points.size() && i < box.size(); ++i) {
+            points[i] = cv::Point2f(box[i].at(0).get<float>(), box[i].at(1).get<float>());
+        }
+        line.box = {points[0], points[1], points[2], points[3]};
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ReplayStore
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<ReplayStore> ReplayStore::open(const std::string& dir, Mode mode) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<ReplayStore>> stores;
+
+    const std::string key = fs::absolute(dir).lexically_normal().string();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto existing = stores[key].lock()) {
+        if (existing->mode() != mode) {
+            throw std::runtime_error("Replay directory already open in the other mode: " + dir);
+        }
+        return existing;
+    }
+    auto store = std::make_shared<ReplayStore>(dir, mode);
+    stores[key] = store;
+    return store;
+}
+
+ReplayStore::ReplayStore(const std::string& dir, Mode mode)
+    : dir_(dir)
+    , mode_(mode)
+{
+    if (mode_ == Mode::REPLAY) {
+        load();
+        LOG_INFO("Replay store {}: {} layout, {} table, {} OCR records",
+                 dir_, layouts_.size(), tables_.size(), ocr_.size());
+        return;
+    }
+
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create record directory " + dir_ + ": " + ec.message());
+    }
+    for (size_t i = 0; i < files_.size(); ++i) {
+        const std::string path = (fs::path(dir_) / kEngineFiles[i]).string();
+        files_[i].open(path, std::ios::app);
+        if (!files_[i].is_open()) {
+            throw std::runtime_error("Cannot open record file " + path);
+        }
+    }
+    LOG_INFO("Recording engine outputs to {}", dir_);
+}
+
+void ReplayStore::load() {
+    if (!fs::is_directory(dir_)) {
+        throw std::runtime_error("Replay directory not found: " + dir_);
+    }
+    for (size_t i = 0; i < files_.size(); ++i) {
+        const fs::path path = fs::path(dir_) / kEngineFiles[i];
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            continue;   // an engine that was disabled while recording
+        }
+        std::string line;
+        size_t lineNo = 0;
+        while (std::getline(in, line)) {
+            ++lineNo;
+            if (line.empty()) {
+                continue;
+            }
+            json item = json::parse(line, nullptr, false);
+            ContentDigest key;
+            if (item.is_discarded() || !item.is_object()
+                || !parseDigest(item.value("key", std::string()), key)) {
+                LOG_WARN("Skipping malformed replay record {}:{}", path.string(), lineNo);
+                continue;
+            }
+            const double ms = item.value("ms", 0.0);
+            try {
+                switch (static_cast<Engine>(i)) {
+                    case Engine::LAYOUT:
+                        layouts_[key] = {layoutFromJson(item.at("boxes")), ms};
+                        break;
+                    case Engine::TABLE:
+                        tables_[key] = {tableFromJson(item.at("table")), ms};
+                        break;
+                    case Engine::OCR:
+                        ocr_[key] = {{ocrFromJson(item.at("lines")), item.value("success", true)}, ms};
+                        break;
+                    case Engine::COUNT:
+                        break;
+                }
+            } catch (const json::exception& e) {
+                LOG_WARN("Skipping malformed replay record {}:{}: {}", path.string(), lineNo, e.what());
+                continue;
+            }
+            latencies_[i].push_back(ms);
+        }
+    }
+}
+
+void ReplayStore::append(Engine engine, const std::string& line) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream& out = files_[slot(engine)];
+    out << line << '\n';
+    out.flush();   // a crashed or killed recording keeps every finished line
+}
+
+void ReplayStore::recordLayout(const ContentDigest& key, const LayoutResult& result, double latencyMs) {
+    append(Engine::LAYOUT, json{
+        {"key", key.hex()}, {"ms", latencyMs}, {"boxes", layoutToJson(result)},
+    }.dump());
+}
+
+void ReplayStore::recordTable(const ContentDigest& key, const TableResult& result, double latencyMs) {
+    append(Engine::TABLE, json{
+        {"key", key.hex()}, {"ms", latencyMs}, {"table", tableToJson(result)},
+    }.dump());
+}
+
+void ReplayStore::recordOcr(
+    const ContentDigest& key,
+    const std::vector<ocr::PipelineOCRResult>& lines,
+    bool success,
+    double latencyMs)
+{
+    append(Engine::OCR, json{
+        {"key", key.hex()}, {"ms", latencyMs}, {"success", success}, {"lines", ocrToJson(lines)},
+    }.dump());
+}
+
+double ReplayStore::missLatency(Engine engine) {
+    // Caller holds mutex_. Cycling keeps misses on the recorded distribution
+    // without making the run depend on a random seed.
+    const auto& samples = latencies_[slot(engine)];
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t& next = nextMissLatency_[slot(engine)];
+    const double ms = samples[next % samples.size()];
+    ++next;
+    return ms;
+}
+
+void ReplayStore::noteMiss(Engine engine, const ContentDigest& key) {
+    if (misses_[slot(engine)].fetch_add(1) == 0) {
+        LOG_WARN("Replay {} has no {} record for input {}; returning an empty result "
+                 "(further misses are counted silently)", dir_, kEngineNames[slot(engine)], key.hex());
+    }
+}
+
+bool ReplayStore::findLayout(const ContentDigest& key, LayoutResult& result, double& latencyMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = layouts_.find(key);
+        if (it != layouts_.end()) {
+            result = it->second.value;
+            latencyMs = it->second.latencyMs;
+            return true;
+        }
+        latencyMs = missLatency(Engine::LAYOUT);
+    }
+    result = LayoutResult{};
+    noteMiss(Engine::LAYOUT, key);
+    return false;
+}
+
+bool ReplayStore::findTable(const ContentDigest& key, TableResult& result, double& latencyMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tables_.find(key);
+        if (it != tables_.end()) {
+            result = it->second.value;
+            latencyMs = it->second.latencyMs;
+            return true;
+        }
+        latencyMs = missLatency(Engine::TABLE);
+    }
+    result = TableResult{};
+    noteMiss(Engine::TABLE, key);
+    return false;
+}
+
+bool ReplayStore::findOcr(
+    const ContentDigest& key,
+    std::vector<ocr::PipelineOCRResult>& lines,
+    bool& success,
+    double& latencyMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ocr_.find(key);
+        if (it != ocr_.end()) {
+            lines = it->second.value.lines;
+            success = it->second.value.success;
+            latencyMs = it->second.latencyMs;
+            return true;
+        }
+        latencyMs = missLatency(Engine::OCR);
+    }
+    lines.clear();
+    success = true;
+    noteMiss(Engine::OCR, key);
+    return false;
+}
+
+size_t ReplayStore::records(Engine engine) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    switch (engine) {
+        case Engine::LAYOUT: return layouts_.size();
+        case Engine::TABLE: return tables_.size();
+        case Engine::OCR: return ocr_.size();
+        case Engine::COUNT: break;
+    }
+    return 0;
+}
+
+uint64_t ReplayStore::misses(Engine engine) const {
+    return misses_[slot(engine)].load();
+}
+
+// ---------------------------------------------------------------------------
+// ReplaySession
+// ---------------------------------------------------------------------------
+
+ReplaySession::ReplaySession(std::shared_ptr<ReplayStore> store, double latencyScale)
+    : store_(std::move(store))
+    , latencyScale_(std::max(0.0, latencyScale))
+{}
+
+ReplaySession::Clock::duration ReplaySession::scaled(double latencyMs) const {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(latencyMs * latencyScale_));
+}
+
+void ReplaySession::sleepFor(double latencyMs) const {
+    const auto duration = scaled(latencyMs);
+    if (duration > Clock::duration::zero()) {
+        std::this_thread::sleep_for(duration);
+    }
+}
+
+void ReplaySession::recordLayout(const cv::Mat& page, const LayoutResult& result, double latencyMs) {
+    store_->recordLayout(digestImage(page), result, latencyMs);
+}
+
+void ReplaySession::recordTable(const cv::Mat& crop, const TableResult& result, double latencyMs) {
+    store_->recordTable(digestImage(crop), result, latencyMs);
+}
+
+void ReplaySession::ocrSubmitted(const cv::Mat& crop, int64_t taskId) {
+    const ContentDigest key = digestImage(crop);
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingRecords_[taskId] = {key, Clock::now()};
+}
+
+void ReplaySession::ocrCompleted(
+    int64_t taskId, const std::vector<ocr::PipelineOCRResult>& lines, bool success)
+{
+    const Clock::time_point now = Clock::now();
+    ContentDigest key;
+    double ms = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pendingRecords_.find(taskId);
+        if (it == pendingRecords_.end()) {
+            return;
+        }
+        // Service time, not submit-to-completion: replay queues tasks behind
+        // each other itself, so time spent waiting for the previous task
+        // must not be counted twice.
+        const Clock::time_point start = std::max(it->second.submitted, lastOcrCompletion_);
+        ms = std::chrono::duration<double, std::milli>(now - start).count();
+        lastOcrCompletion_ = now;
+        key = it->second.key;
+        pendingRecords_.erase(it);
+    }
+    store_->recordOcr(key, lines, success, ms);
+}
+
+LayoutResult ReplaySession::detectLayout(const cv::Mat& page) {
+    LayoutResult result;
+    double ms = 0.0;
+    store_->findLayout(digestImage(page), result, ms);
+    sleepFor(ms);
+    result.inferenceTimeMs = ms * latencyScale_;
+    return result;
+}
+
+TableResult ReplaySession::recognizeTable(const cv::Mat& crop) {
+    TableResult result;
+    double ms = 0.0;
+    store_->findTable(digestImage(crop), result, ms);
+    sleepFor(ms);
+    result.inferenceTimeMs = ms * latencyScale_;
+    return result;
+}
+
+bool ReplaySession::submitOcr(const cv::Mat& crop, int64_t taskId) {
+    QueuedOcr task;
+    task.taskId = taskId;
+    double ms = 0.0;
+    store_->findOcr(digestImage(crop), task.lines, task.success, ms);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Clock::time_point start = std::max(Clock::now(), ocrBusyUntil_);
+    task.readyAt = start + scaled(ms);
+    ocrBusyUntil_ = task.readyAt;
+    ocrQueue_.push_back(std::move(task));
+    return true;
+}
+
+bool ReplaySession::fetchOcr(
+    std::vector<ocr::PipelineOCRResult>& lines, int64_t& taskId, bool& success)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ocrQueue_.empty() || ocrQueue_.front().readyAt > Clock::now()) {
+        return false;
+    }
+    QueuedOcr& task = ocrQueue_.front();
+    lines = std::move(task.lines);
+    taskId = task.taskId;
+    success = task.success;
+    ocrQueue_.pop_front();
+    return true;
+}
+
+} // namespace rapid_doc
@@ -0,0 +1,433 @@
+/**
+ * @file rapid_doc_module.cpp
+ * @brief In-process Python bindings for DocPipeline (pybind11)
+ *
+ * PDF bytes and page images reach the pipeline without a copy: any
+ * contiguous byte buffer (bytes, bytearray, memoryview, a uint8 array) is
+ * read in place, and an HxWx3 uint8 BGR array with packed pixels - rows may
+ * be strided, e.g. a slice of a larger frame - is wrapped in a cv::Mat
+ * header. Grey, BGRA or non-packed arrays are converted once.
+ *
+ * Results stay in C++. Layout boxes, scores and categories are read-only
+ * NumPy views into the page's LayoutBox array, kept alive by the page
+ * object; Markdown and the content list are collected from the run's
+ * streaming sinks. The GIL is released for the whole run (model loading
+ * too), so other Python threads keep running while the NPU works; each
+ * Pipeline runs one document at a time, so use one Pipeline per device to
+ * process documents in parallel.
+ *
+ *   import rapid_doc
+ *   config = rapid_doc.PipelineConfig.default("/opt/RapidDocCpp")
+ *   pipeline = rapid_doc.Pipeline(config)
+ *   doc = pipeline.process_pdf(open("a.pdf", "rb").read())
+ *   doc.markdown, doc.pages[0].boxes  # str, float32 (N, 4) view
+ */
+
+#include "pipeline/doc_pipeline.h"
+#include "common/config.h"
+#include "common/types.h"
+#include "output/output_sink.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace rapid_doc {
+namespace {
+
+/// Result of one run plus the documents its sinks received
+struct PyDocument {
+    DocumentResult result;
+    std::string markdown;
+    std::string contentList;    // JSON, as the content-list file
+};
+
+struct RunOptions {
+    bool markdown = true;
+    bool contentList = true;
+    bool saveImages = false;    // crops go to outputDir and come back in Document.images
+    std::optional<std::string> outputDir;
+    std::optional<int> startPage;
+    std::optional<int> endPage;
+    std::optional<int> maxPages;
+};
+
+/// Pixels of @p array as BGR, wrapped in place when already packed BGR
+cv::Mat imageFromArray(const py::array& array) {
+    if (array.dtype().kind() != 'u' || array.itemsize() != 1) {
+        throw py::type_error("image must be a uint8 array");
+    }
+    const py::ssize_t ndim = array.ndim();
+    const int channels = ndim == 2 ? 1 : ndim == 3 ? static_cast<int>(array.shape(2)) : 0;
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw py::value_error("image must be HxW grey, HxWx3 BGR or HxWx4 BGRA");
+    }
+    const int rows = static_cast<int>(array.shape(0));
+    const int cols = static_cast<int>(array.shape(1));
+    const bool packed = (ndim == 2 || array.strides(2) == 1) && array.strides(1) == channels &&
+                        array.strides(0) >= static_cast<py::ssize_t>(cols) * channels;
+
+    cv::Mat pixels;
+    if (packed) {
+        pixels = cv::Mat(rows, cols, CV_8UC(channels), const_cast<void*>(array.data()),
+                         static_cast<size_t>(array.strides(0)));
+    } else {
+        const auto contiguous = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>::ensure(array);
+        pixels = cv::Mat(rows, cols, CV_8UC(channels), const_cast<uint8_t*>(contiguous.data())).clone();
+    }
+    if (channels == 3) {
+        return pixels;
+    }
+    cv::Mat bgr;
+    cv::cvtColor(pixels, bgr, channels == 1 ? cv::COLOR_GRAY2BGR : cv::COLOR_BGRA2BGR);
+    return bgr;
+}
+
+/**
+ * @brief Read-only NumPy view of one LayoutBox field across @p boxes
+ * @param owner Python object that keeps @p boxes alive
+ */
+template <typename T>
+py::array boxFieldView(
+    const py::object& owner,
+    const std::vector<LayoutBox>& boxes,
+    size_t offset,
+    std::vector<py::ssize_t> shape,
+    std::vector<py::ssize_t> strides)
+{
+    if (boxes.empty()) {
+        return py::array(py::dtype::of<T>(), shape, strides);
+    }
+    const char* first = reinterpret_cast<const char*>(boxes.data()) + offset;
+    py::array view(py::dtype::of<T>(), shape, strides, first, owner);
+    view.attr("flags").attr("writeable") = false;
+    return view;
+}
+
+class PyPipeline {
+public:
+    explicit PyPipeline(const PipelineConfig& config)
+        : pipeline_(std::make_unique<DocPipeline>(config))
+    {
+        bool initialized = false;
+        {
+            py::gil_scoped_release release;
+            initialized = pipeline_->initialize();
+        }
+        if (!initialized) {
+            throw std::runtime_error("Failed to initialize document pipeline (see log)");
+        }
+    }
+
+    PyDocument processPdf(const py::buffer& data, const RunOptions& options) {
+        const py::buffer_info bytes = data.request();
+        if (bytes.itemsize != 1 || (bytes.ndim == 1 && bytes.strides[0] != 1) || bytes.ndim > 1) {
+            throw py::value_error("PDF data must be a contiguous byte buffer");
+        }
+        const auto* begin = static_cast<const uint8_t*>(bytes.ptr);
+        const size_t size = static_cast<size_t>(bytes.size);
+        return run(options, [&](const PipelineRunOverrides& overrides) {
+            return pipeline_->processPdfFromMemoryWithOverrides(begin, size, overrides);
+        });
+    }
+
+    PyDocument processImage(const py::array& image, int pageIndex, const RunOptions& options) {
+        const cv::Mat pixels = imageFromArray(image);
+        return run(options, [&](const PipelineRunOverrides& overrides) {
+            return pipeline_->processImageDocumentWithOverrides(pixels, pageIndex, overrides);
+        });
+    }
+
+    PyDocument processImages(const std::vector<py::array>& images, const RunOptions& options) {
+        std::vector<cv::Mat> pages;
+        pages.reserve(images.size());
+        for (const auto& image : images) {
+            pages.push_back(imageFromArray(image));
+        }
+        return run(options, [&](const PipelineRunOverrides& overrides) {
+            return pipeline_->processImagesAsDocumentWithOverrides(pages, overrides);
+        });
+    }
+
+private:
+    template <typename Call>
+    PyDocument run(const RunOptions& options, Call&& call) {
+        PyDocument document;
+        PipelineRunOverrides overrides;
+        overrides.saveImages = options.saveImages;
+        overrides.keepEncodedImages = options.saveImages;
+        overrides.outputDir = options.outputDir;
+        overrides.startPageId = options.startPage;
+        overrides.endPageId = options.endPage;
+        overrides.maxPages = options.maxPages;
+        if (options.markdown) {
+            overrides.markdownSink = makeStringSink(document.markdown);
+        }
+        if (options.contentList) {
+            overrides.contentListSink = makeStringSink(document.contentList);
+        }
+
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        document.result = call(overrides);
+        return document;
+    }
+
+    std::unique_ptr<DocPipeline> pipeline_;
+    std::mutex mutex_;     // one run at a time; the GIL is not held while waiting
+};
+
+/// Elements of @p items as Python objects that keep @p owner alive
+template <typename T>
+py::list referenceList(std::vector<T>& items, const py::object& owner) {
+    py::list list;
+    for (auto& item : items) {
+        list.append(py::cast(&item, py::return_value_policy::reference_internal, owner));
+    }
+    return list;
+}
+
+} // namespace
+} // namespace rapid_doc
+
+PYBIND11_MODULE(rapid_doc, m) {
+    using namespace rapid_doc;
+    m.doc() = "RapidDoc document analysis on DEEPX NPU, in process";
+
+    static_assert(sizeof(LayoutCategory) == sizeof(int32_t), "categories are viewed as int32");
+
+    py::enum_<LayoutCategory>(m, "LayoutCategory")
+        .value("TEXT", LayoutCategory::TEXT)
+        .value("TITLE", LayoutCategory::TITLE)
+        .value("FIGURE", LayoutCategory::FIGURE)
+        .value("FIGURE_CAPTION", LayoutCategory::FIGURE_CAPTION)
+        .value("TABLE", LayoutCategory::TABLE)
+        .value("TABLE_CAPTION", LayoutCategory::TABLE_CAPTION)
+        .value("TABLE_FOOTNOTE", LayoutCategory::TABLE_FOOTNOTE)
+        .value("HEADER", LayoutCategory::HEADER)
+        .value("FOOTER", LayoutCategory::FOOTER)
+        .value("REFERENCE", LayoutCategory::REFERENCE)
+        .value("EQUATION", LayoutCategory::EQUATION)
+        .value("INTERLINE_EQUATION", LayoutCategory::INTERLINE_EQUATION)
+        .value("STAMP", LayoutCategory::STAMP)
+        .value("CODE", LayoutCategory::CODE)
+        .value("TOC", LayoutCategory::TOC)
+        .value("ABSTRACT", LayoutCategory::ABSTRACT)
+        .value("CONTENT", LayoutCategory::CONTENT)
+        .value("LIST", LayoutCategory::LIST)
+        .value("INDEX", LayoutCategory::INDEX)
+        .value("SEPARATOR", LayoutCategory::SEPARATOR)
+        .value("UNKNOWN", LayoutCategory::UNKNOWN);
+
+    py::enum_<ContentElement::Type>(m, "ElementType")
+        .value("TEXT", ContentElement::Type::TEXT)
+        .value("TITLE", ContentElement::Type::TITLE)
+        .value("IMAGE", ContentElement::Type::IMAGE)
+        .value("TABLE", ContentElement::Type::TABLE)
+        .value("EQUATION", ContentElement::Type::EQUATION)
+        .value("CODE", ContentElement::Type::CODE)
+        .value("LIST", ContentElement::Type::LIST)
+        .value("HEADER", ContentElement::Type::HEADER)
+        .value("FOOTER", ContentElement::Type::FOOTER)
+        .value("REFERENCE", ContentElement::Type::REFERENCE)
+        .value("UNKNOWN", ContentElement::Type::UNKNOWN);
+
+    // ---- Configuration ----
+
+    py::class_<ModelPaths>(m, "ModelPaths")
+        .def(py::init<>())
+        .def_readwrite("layout_dxnn_model", &ModelPaths::layoutDxnnModel)
+        .def_readwrite("layout_onnx_sub_model", &ModelPaths::layoutOnnxSubModel)
+        .def_readwrite("table_unet_dxnn_model", &ModelPaths::tableUnetDxnnModel)
+        .def_readwrite("ocr_model_dir", &ModelPaths::ocrModelDir)
+        .def_readwrite("ocr_dict_path", &ModelPaths::ocrDictPath);
+
+    py::class_<PipelineStages>(m, "PipelineStages")
+        .def(py::init<>())
+        .def_readwrite("enable_layout", &PipelineStages::enableLayout)
+        .def_readwrite("enable_ocr", &PipelineStages::enableOcr)
+        .def_readwrite("enable_wired_table", &PipelineStages::enableWiredTable)
+        .def_readwrite("enable_reading_order", &PipelineStages::enableReadingOrder)
+        .def_readwrite("enable_markdown_output", &PipelineStages::enableMarkdownOutput)
+        .def_readwrite("enable_formula", &PipelineStages::enableFormula);
+
+    py::class_<RuntimeConfig>(m, "RuntimeConfig")
+        .def(py::init<>())
+        .def_readwrite("pdf_dpi", &RuntimeConfig::pdfDpi)
+        .def_readwrite("layout_dpi", &RuntimeConfig::layoutDpi)
+        .def_readwrite("use_text_layer", &RuntimeConfig::useTextLayer)
+        .def_readwrite("max_pages", &RuntimeConfig::maxPages)
+        .def_readwrite("blank_page_ink_ratio", &RuntimeConfig::blankPageInkRatio)
+        .def_readwrite("pipeline_queue_depth", &RuntimeConfig::pipelineQueueDepth)
+        .def_readwrite("postprocess_stage_threads", &RuntimeConfig::postprocessStageThreads)
+        .def_readwrite("npu_layout_concurrency", &RuntimeConfig::npuLayoutConcurrency)
+        .def_readwrite("npu_ocr_concurrency", &RuntimeConfig::npuOcrConcurrency)
+        .def_readwrite("npu_table_concurrency", &RuntimeConfig::npuTableConcurrency)
+        .def_readwrite("device_id", &RuntimeConfig::deviceId)
+        .def_readwrite("postprocess_threads", &RuntimeConfig::postprocessThreads)
+        .def_readwrite("layout_conf_threshold", &RuntimeConfig::layoutConfThreshold)
+        .def_readwrite("layout_batch_size", &RuntimeConfig::layoutBatchSize)
+        .def_readwrite("layout_fast_resize", &RuntimeConfig::layoutFastResize)
+        .def_readwrite("table_conf_threshold", &RuntimeConfig::tableConfThreshold)
+        .def_readwrite("output_dir", &RuntimeConfig::outputDir)
+        .def_readwrite("image_format", &RuntimeConfig::imageFormat)
+        .def_readwrite("recognition_cache_mb", &RuntimeConfig::recognitionCacheMb)
+        .def_readwrite("warmup_on_init", &RuntimeConfig::warmupOnInit);
+
+    py::class_<PipelineConfig>(m, "PipelineConfig")
+        .def(py::init<>())
+        .def_static("default", &PipelineConfig::Default, py::arg("project_root") = ".",
+                    "Standard model paths under project_root")
+        .def_readwrite("models", &PipelineConfig::models)
+        .def_readwrite("stages", &PipelineConfig::stages)
+        .def_readwrite("runtime", &PipelineConfig::runtime)
+        .def("validate", &PipelineConfig::validate, "Empty string if valid, the problem otherwise");
+
+    // ---- Results (views into C++ memory; never copied on access) ----
+
+    py::class_<ContentElement>(m, "Element")
+        .def_readonly("type", &ContentElement::type)
+        .def_readonly("text", &ContentElement::text)
+        .def_readonly("html", &ContentElement::html)
+        .def_readonly("image_path", &ContentElement::imagePath)
+        .def_readonly("page_index", &ContentElement::pageIndex)
+        .def_readonly("reading_order", &ContentElement::readingOrder)
+        .def_readonly("confidence", &ContentElement::confidence)
+        .def_readonly("skipped", &ContentElement::skipped)
+        .def_property_readonly("category", [](const ContentElement& e) { return e.layoutBox.category; })
+        .def_property_readonly("bbox", [](const ContentElement& e) {
+            return py::make_tuple(e.layoutBox.x0, e.layoutBox.y0, e.layoutBox.x1, e.layoutBox.y1);
+        });
+
+    py::class_<PageResult>(m, "Page")
+        .def_readonly("page_index", &PageResult::pageIndex)
+        .def_readonly("width", &PageResult::pageWidth)
+        .def_readonly("height", &PageResult::pageHeight)
+        .def_readonly("blank", &PageResult::blank)
+        .def_readonly("total_time_ms", &PageResult::totalTimeMs)
+        .def_property_readonly("boxes", [](py::object self) {
+            const auto& boxes = self.cast<const PageResult&>().layoutResult.boxes;
+            return boxFieldView<float>(
+                self, boxes, offsetof(LayoutBox, x0),
+                {static_cast<py::ssize_t>(boxes.size()), 4},
+                {static_cast<py::ssize_t>(sizeof(LayoutBox)), static_cast<py::ssize_t>(sizeof(float))});
+        }, "Layout boxes as a read-only float32 (N, 4) view of x0, y0, x1, y1")
+        .def_property_readonly("scores", [](py::object self) {
+            const auto& boxes = self.cast<const PageResult&>().layoutResult.boxes;
+            return boxFieldView<float>(
+                self, boxes, offsetof(LayoutBox, confidence),
+                {static_cast<py::ssize_t>(boxes.size())}, {static_cast<py::ssize_t>(sizeof(LayoutBox))});
+        }, "Layout box confidences, a read-only float32 (N,) view")
+        .def_property_readonly("categories", [](py::object self) {
+            const auto& boxes = self.cast<const PageResult&>().layoutResult.boxes;
+            return boxFieldView<int32_t>(
+                self, boxes, offsetof(LayoutBox, category),
+                {static_cast<py::ssize_t>(boxes.size())}, {static_cast<py::ssize_t>(sizeof(LayoutBox))});
+        }, "LayoutCategory values of the boxes, a read-only int32 (N,) view")
+        .def_property_readonly("labels", [](const PageResult& page) {
+            std::vector<std::string> labels;
+            labels.reserve(page.layoutResult.boxes.size());
+            for (const auto& box : page.layoutResult.boxes) {
+                labels.emplace_back(box.label);
+            }
+            return labels;
+        }, "Model label of each box")
+        .def_property_readonly("elements", [](py::object self) {
+            return referenceList(self.cast<PageResult&>().elements, self);
+        }, "Content elements in reading order")
+        .def_property_readonly("table_html", [](const PageResult& page) {
+            std::vector<std::string> html;
+            for (const auto& table : page.tableResults) {
+                html.push_back(table.html);
+            }
+            return html;
+        });
+
+    py::class_<PyDocument>(m, "Document")
+        .def_readonly("markdown", &PyDocument::markdown)
+        .def_readonly("content_list", &PyDocument::contentList, "Content list JSON text")
+        .def_property_readonly("pages", [](py::object self) {
+            return referenceList(self.cast<PyDocument&>().result.pages, self);
+        })
+        .def_property_readonly("total_pages", [](const PyDocument& d) { return d.result.totalPages; })
+        .def_property_readonly("processed_pages", [](const PyDocument& d) { return d.result.processedPages; })
+        .def_property_readonly("skipped_elements", [](const PyDocument& d) { return d.result.skippedElements; })
+        .def_property_readonly("total_time_ms", [](const PyDocument& d) { return d.result.totalTimeMs; })
+        .def_property_readonly("cancelled", [](const PyDocument& d) { return d.result.cancelled; })
+        .def_property_readonly("images", [](const PyDocument& d) {
+            py::dict images;
+            for (const auto& image : d.result.images) {
+                images[py::str(image.path)] = py::bytes(
+                    reinterpret_cast<const char*>(image.data.data()), image.data.size());
+            }
+            return images;
+        }, "Saved crops by relative path (save_images=True only)")
+        .def("__len__", [](const PyDocument& d) { return d.result.pages.size(); });
+
+    // ---- Pipeline ----
+
+    py::class_<PyPipeline>(m, "Pipeline")
+        .def(py::init<const PipelineConfig&>(), py::arg("config"),
+             "Load every enabled model; the GIL is released meanwhile")
+        .def("process_pdf",
+             [](PyPipeline& self, const py::buffer& data, bool markdown, bool contentList,
+                std::optional<int> startPage, std::optional<int> endPage, std::optional<int> maxPages,
+                bool saveImages, std::optional<std::string> outputDir) {
+                 RunOptions options;
+                 options.markdown = markdown;
+                 options.contentList = contentList;
+                 options.startPage = startPage;
+                 options.endPage = endPage;
+                 options.maxPages = maxPages;
+                 options.saveImages = saveImages;
+                 options.outputDir = std::move(outputDir);
+                 return self.processPdf(data, options);
+             },
+             py::arg("data"), py::kw_only(),
+             py::arg("markdown") = true, py::arg("content_list") = true,
+             py::arg("start_page") = py::none(), py::arg("end_page") = py::none(),
+             py::arg("max_pages") = py::none(),
+             py::arg("save_images") = false, py::arg("output_dir") = py::none(),
+             "Process PDF bytes (any contiguous buffer, read in place)")
+        .def("process_image",
+             [](PyPipeline& self, const py::array& image, int pageIndex, bool markdown, bool contentList,
+                bool saveImages, std::optional<std::string> outputDir) {
+                 RunOptions options;
+                 options.markdown = markdown;
+                 options.contentList = contentList;
+                 options.saveImages = saveImages;
+                 options.outputDir = std::move(outputDir);
+                 return self.processImage(image, pageIndex, options);
+             },
+             py::arg("image"), py::kw_only(), py::arg("page_index") = 0,
+             py::arg("markdown") = true, py::arg("content_list") = true,
+             py::arg("save_images") = false, py::arg("output_dir") = py::none(),
+             "Process one uint8 image (HxWx3 BGR is used in place)")
+        .def("process_images",
+             [](PyPipeline& self, const std::vector<py::array>& images, bool markdown, bool contentList,
+                bool saveImages, std::optional<std::string> outputDir) {
+                 RunOptions options;
+                 options.markdown = markdown;
+                 options.contentList = contentList;
+                 options.saveImages = saveImages;
+                 options.outputDir = std::move(outputDir);
+                 return self.processImages(images, options);
+             },
+             py::arg("images"), py::kw_only(),
+             py::arg("markdown") = true, py::arg("content_list") = true,
+             py::arg("save_images") = false, py::arg("output_dir") = py::none(),
+             "Process several images as the pages of one document");
+}
@@ -104,155 +104,264 @@ std::vector<std::pair<int, int>> splitProjectionProfile(
     return segments;
 }
 
-void recursiveXYCut(
-    const std::vector<LayoutBox>& boxes,
-    const std::vector<int>& indices,
-    int pageWidth,
-    int pageHeight,
-    const XYCutConfig& config,
-    std::vector<int>& result)
-{
-    if (indices.empty()) return;
+namespace {
 
-    if (indices.size() == 1) {
-        result.push_back(indices[0]);
-        return;
+/**
+ * Scratch storage shared by every level of one XY-Cut. Each level uses it
+ * only before recursing, apart from groupEnds, which is a stack: a level
+ * pushes its group boundaries and pops them once its children are done.
+ */
+struct CutWorkspace {
+    std::vector<std::pair<int, int>> events;     // (coordinate, +1/-1) coverage changes
+    std::vector<std::pair<int, int>> segments;   // splitProjectionProfile() output
+    std::vector<int> segmentOf;                  // segment per box, -1 = in no segment
+    std::vector<int> scratch;
+    std::vector<size_t> groupEnds;
+
+    explicit CutWorkspace(size_t boxCount) {
+        events.reserve(2 * boxCount);
+        segments.reserve(boxCount + 1);
+        segmentOf.reserve(boxCount);
+        scratch.reserve(boxCount);
+        groupEnds.reserve(2 * boxCount + 1);
     }
+};
 
-    // Gather boxes for current indices
-    std::vector<LayoutBox> subBoxes;
-    for (int idx : indices) {
-        subBoxes.push_back(boxes[idx]);
-    }
+struct CutParams {
+    int pageWidth;
+    int pageHeight;
+    int minGapX;
+    int minGapY;
+    int minValue;
+};
 
-    int minGapX = std::max(1, static_cast<int>(pageWidth * config.minGapRatio));
-    int minGapY = std::max(1, static_cast<int>(pageHeight * config.minGapRatio));
-    int minVal = static_cast<int>(config.minValueRatio);
-
-    // Try X-axis split first
-    auto xProj = projectionByBboxes(subBoxes, 0, pageWidth);
-    auto xSegments = splitProjectionProfile(xProj, minVal, minGapX);
-
-    if (xSegments.size() > 1) {
-        // Split into columns (left to right)
-        for (const auto& seg : xSegments) {
-            std::vector<int> group;
-            for (size_t i = 0; i < indices.size(); i++) {
-                float cx = subBoxes[i].center().x;
-                if (cx >= seg.first && cx < seg.second) {
-                    group.push_back(indices[i]);
-                }
-            }
-            recursiveXYCut(boxes, group, pageWidth, pageHeight, config, result);
+/**
+ * splitProjectionProfile(projectionByBboxes(...)) without the pixel array:
+ * the projection is constant between box edges, so it is walked as runs
+ * between the sorted edge coordinates of the boxes in @p idx.
+ */
+void projectSegments(
+    const std::vector<LayoutBox>& boxes,
+    const int* idx,
+    size_t count,
+    int axis,
+    int size,
+    int minValue,
+    int minGap,
+    CutWorkspace& ws)
+{
+    ws.events.clear();
+    ws.segments.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const LayoutBox& box = boxes[idx[i]];
+        const int start = std::max(0, static_cast<int>(axis == 0 ? box.x0 : box.y0));
+        const int end = std::min(size, static_cast<int>(axis == 0 ? box.x1 : box.y1));
+        if (start < end) {
+            ws.events.emplace_back(start, 1);
+            ws.events.emplace_back(end, -1);
         }
-        return;
     }
+    std::sort(ws.events.begin(), ws.events.end());
 
-    // Try Y-axis split
-    auto yProj = projectionByBboxes(subBoxes, 1, pageHeight);
-    auto ySegments = splitProjectionProfile(yProj, minVal, minGapY);
-
-    if (ySegments.size() > 1) {
-        // Split into rows (top to bottom)
-        for (const auto& seg : ySegments) {
-            std::vector<int> group;
-            for (size_t i = 0; i < indices.size(); i++) {
-                float cy = subBoxes[i].center().y;
-                if (cy >= seg.first && cy < seg.second) {
-                    group.push_back(indices[i]);
-                }
+    bool inSegment = false;
+    int segStart = 0;
+    int gapCount = 0;
+    int pos = 0;
+    int value = 0;
+    // Same state machine as splitProjectionProfile(), advanced one run at a time
+    auto advance = [&](int runEnd) {
+        const int len = runEnd - pos;
+        if (len <= 0) return;
+        if (value > minValue) {
+            if (!inSegment) {
+                segStart = pos;
+                inSegment = true;
+            }
+            gapCount = 0;
+        } else if (inSegment) {
+            if (gapCount + len >= minGap) {
+                ws.segments.emplace_back(segStart, pos - gapCount);
+                inSegment = false;
+                gapCount = 0;
+            } else {
+                gapCount += len;
             }
-            recursiveXYCut(boxes, group, pageWidth, pageHeight, config, result);
         }
-        return;
+        pos = runEnd;
+    };
+
+    for (const auto& event : ws.events) {
+        advance(event.first);
+        value += event.second;
+    }
+    advance(size);
+    if (inSegment) {
+        ws.segments.emplace_back(segStart, size);
     }
+}
 
-    // No split possible — add all indices sorted by position (top-to-bottom, left-to-right)
-    std::vector<int> sorted = indices;
-    std::sort(sorted.begin(), sorted.end(), [&boxes](int a, int b) {
-        float ya = boxes[a].center().y;
-        float yb = boxes[b].center().y;
-        float threshold = std::min(boxes[a].height(), boxes[b].height()) * 0.5f;
-        if (std::abs(ya - yb) < threshold) {
-            return boxes[a].center().x < boxes[b].center().x;
+/**
+ * Stable-partition idx[0, count) by the segment holding each box centre and
+ * push one end offset per segment onto ws.groupEnds. Boxes whose centre lies
+ * in no segment are moved past the last group and dropped.
+ */
+void partitionBySegment(
+    const std::vector<LayoutBox>& boxes,
+    int* idx,
+    size_t count,
+    int axis,
+    CutWorkspace& ws)
+{
+    const size_t segCount = ws.segments.size();
+    const size_t base = ws.groupEnds.size();
+    ws.groupEnds.resize(base + segCount, 0);
+    ws.segmentOf.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const cv::Point2f c = boxes[idx[i]].center();
+        const float v = (axis == 0) ? c.x : c.y;
+        auto it = std::upper_bound(
+            ws.segments.begin(), ws.segments.end(), v,
+            [](float value, const std::pair<int, int>& seg) { return value < seg.first; });
+        int seg = -1;
+        if (it != ws.segments.begin() && v < std::prev(it)->second) {
+            seg = static_cast<int>(std::distance(ws.segments.begin(), it)) - 1;
+            ws.groupEnds[base + seg]++;
         }
-        return ya < yb;
-    });
-    result.insert(result.end(), sorted.begin(), sorted.end());
+        ws.segmentOf[i] = seg;
+    }
+
+    size_t offset = 0;
+    for (size_t g = 0; g < segCount; ++g) {
+        const size_t groupSize = ws.groupEnds[base + g];
+        ws.groupEnds[base + g] = offset;  // write cursor while scattering
+        offset += groupSize;
+    }
+    ws.scratch.resize(count);
+    size_t dropped = offset;
+    for (size_t i = 0; i < count; ++i) {
+        const int seg = ws.segmentOf[i];
+        const size_t dst = (seg < 0) ? dropped++ : ws.groupEnds[base + seg]++;
+        ws.scratch[dst] = idx[i];
+    }
+    std::copy(ws.scratch.begin(), ws.scratch.end(), idx);
 }
 
-void recursiveYXCut(
+void cutSpan(
     const std::vector<LayoutBox>& boxes,
-    const std::vector<int>& indices,
-    int pageWidth,
-    int pageHeight,
-    const XYCutConfig& config,
+    int* idx,
+    size_t count,
+    bool xFirst,
+    const CutParams& params,
+    CutWorkspace& ws,
     std::vector<int>& result)
 {
-    if (indices.empty()) return;
+    if (count == 0) return;
 
-    if (indices.size() == 1) {
-        result.push_back(indices[0]);
+    if (count == 1) {
+        result.push_back(idx[0]);
         return;
     }
 
-    std::vector<LayoutBox> subBoxes;
-    for (int idx : indices) {
-        subBoxes.push_back(boxes[idx]);
-    }
+    const int axes[2] = {xFirst ? 0 : 1, xFirst ? 1 : 0};
+    for (int axis : axes) {
+        if (axis == 0) {
+            projectSegments(boxes, idx, count, 0, params.pageWidth,
+                            params.minValue, params.minGapX, ws);
+        } else {
+            projectSegments(boxes, idx, count, 1, params.pageHeight,
+                            params.minValue, params.minGapY, ws);
+        }
+        if (ws.segments.size() <= 1) {
+            continue;
+        }
 
-    int minGapX = std::max(1, static_cast<int>(pageWidth * config.minGapRatio));
-    int minGapY = std::max(1, static_cast<int>(pageHeight * config.minGapRatio));
-    int minVal = static_cast<int>(config.minValueRatio);
-
-    // Try Y-axis split first (for vertical text)
-    auto yProj = projectionByBboxes(subBoxes, 1, pageHeight);
-    auto ySegments = splitProjectionProfile(yProj, minVal, minGapY);
-
-    if (ySegments.size() > 1) {
-        for (const auto& seg : ySegments) {
-            std::vector<int> group;
-            for (size_t i = 0; i < indices.size(); i++) {
-                float cy = subBoxes[i].center().y;
-                if (cy >= seg.first && cy < seg.second) {
-                    group.push_back(indices[i]);
-                }
-            }
-            recursiveYXCut(boxes, group, pageWidth, pageHeight, config, result);
+        // Columns left to right / rows top to bottom
+        const size_t base = ws.groupEnds.size();
+        const size_t groupCount = ws.segments.size();
+        partitionBySegment(boxes, idx, count, axis, ws);
+        size_t begin = 0;
+        for (size_t g = 0; g < groupCount; ++g) {
+            const size_t end = ws.groupEnds[base + g];
+            cutSpan(boxes, idx + begin, end - begin, xFirst, params, ws, result);
+            begin = end;
         }
+        ws.groupEnds.resize(base);
         return;
     }
 
-    // Try X-axis split
-    auto xProj = projectionByBboxes(subBoxes, 0, pageWidth);
-    auto xSegments = splitProjectionProfile(xProj, minVal, minGapX);
-
-    if (xSegments.size() > 1) {
-        for (const auto& seg : xSegments) {
-            std::vector<int> group;
-            for (size_t i = 0; i < indices.size(); i++) {
-                float cx = subBoxes[i].center().x;
-                if (cx >= seg.first && cx < seg.second) {
-                    group.push_back(indices[i]);
-                }
+    // No split possible — sort by position
+    if (xFirst) {
+        // Top-to-bottom, left-to-right
+        std::sort(idx, idx + count, [&boxes](int a, int b) {
+            float ya = boxes[a].center().y;
+            float yb = boxes[b].center().y;
+            float threshold = std::min(boxes[a].height(), boxes[b].height()) * 0.5f;
+            if (std::abs(ya - yb) < threshold) {
+                return boxes[a].center().x < boxes[b].center().x;
             }
-            recursiveYXCut(boxes, group, pageWidth, pageHeight, config, result);
-        }
-        return;
+            return ya < yb;
+        });
+    } else {
+        std::sort(idx, idx + count, [&boxes](int a, int b) {
+            float xa = boxes[a].center().x;
+            float xb = boxes[b].center().x;
+            float threshold = std::min(boxes[a].width(), boxes[b].width()) * 0.5f;
+            if (std::abs(xa - xb) < threshold) {
+                return boxes[a].center().y < boxes[b].center().y;
+            }
+            return xa > xb;  // Right to left for vertical text
+        });
     }
+    result.insert(result.end(), idx, idx + count);
+}
 
-    // No split — sort by position
-    std::vector<int> sorted = indices;
-    std::sort(sorted.begin(), sorted.end(), [&boxes](int a, int b) {
-        float xa = boxes[a].center().x;
-        float xb = boxes[b].center().x;
-        float threshold = std::min(boxes[a].width(), boxes[b].width()) * 0.5f;
-        if (std::abs(xa - xb) < threshold) {
-            return boxes[a].center().y < boxes[b].center().y;
-        }
-        return xa > xb;  // Right to left for vertical text
-    });
-    result.insert(result.end(), sorted.begin(), sorted.end());
+CutParams makeCutParams(int pageWidth, int pageHeight, const XYCutConfig& config) {
+    CutParams params;
+    params.pageWidth = pageWidth;
+    params.pageHeight = pageHeight;
+    params.minGapX = std::max(1, static_cast<int>(pageWidth * config.minGapRatio));
+    params.minGapY = std::max(1, static_cast<int>(pageHeight * config.minGapRatio));
+    params.minValue = static_cast<int>(config.minValueRatio);
+    return params;
+}
+
+void runCut(
+    const std::vector<LayoutBox>& boxes,
+    std::vector<int> indices,
+    bool xFirst,
+    int pageWidth,
+    int pageHeight,
+    const XYCutConfig& config,
+    std::vector<int>& result)
+{
+    CutWorkspace ws(indices.size());
+    cutSpan(boxes, indices.data(), indices.size(), xFirst,
+            makeCutParams(pageWidth, pageHeight, config), ws, result);
+}
+
+}  // namespace
+
+void recursiveXYCut(
+    const std::vector<LayoutBox>& boxes,
+    const std::vector<int>& indices,
+    int pageWidth,
+    int pageHeight,
+    const XYCutConfig& config,
+    std::vector<int>& result)
+{
+    runCut(boxes, indices, true, pageWidth, pageHeight, config, result);
+}
+
+void recursiveYXCut(
+    const std::vector<LayoutBox>& boxes,
+    const std::vector<int>& indices,
+    int pageWidth,
+    int pageHeight,
+    const XYCutConfig& config,
+    std::vector<int>& result)
+{
+    runCut(boxes, indices, false, pageWidth, pageHeight, config, result);
 }
 
 } // namespace detail
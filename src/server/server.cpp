@@ -4,7 +4,15 @@
  */
 
 #include "server/server.h"
+#include "server/concurrency_tuner.h"
+#include "server/device_health.h"
+#include "server/job_store.h"
+#include "server/lb_headers.h"
+#include "server/shm_transport.h"
+#include "common/cpu_affinity.h"
 #include "common/logger.h"
+#include "common/trace.h"
+#include "output/result_json.h"
 
 // Crow HTTP framework (header-only)
 #ifndef CROW_MAIN
@@ -17,17 +25,22 @@
 #include <opencv2/imgcodecs.hpp>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cctype>
+#include <condition_variable>
 #include <cstdlib>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <limits>
 #include <mutex>
 #include <optional>
 #include <sstream>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 
@@ -38,16 +51,29 @@ namespace fs = std::filesystem;
 namespace rapid_doc {
 
 struct DeviceMetricSample {
-    int deviceId = -1;
-    uint64_t memoryTotalBytes = 0;
-    std::optional<uint64_t> memoryLastUsedBytes;
-    std::optional<uint64_t> memoryPeakUsedBytes;
+    DeviceTelemetry telemetry;
+    DeviceHealth health = DeviceHealth::OK;
 };
 
+// DX-M1 reports three NPU cores; a core that reads 0 has no sensor or clock.
+constexpr int kNpuCoreCount = 3;
+
 class DeviceMetricsSampler {
 public:
-    explicit DeviceMetricsSampler(std::vector<int> deviceIds)
+    /// Cumulative NPU-occupied time of the shards on a device
+    using BusyTimeSource = std::function<std::chrono::steady_clock::duration(int deviceId)>;
+    /// Called after every sample, off the sampler's lock
+    using Listener = std::function<void(const DeviceMetricSample&)>;
+
+    DeviceMetricsSampler(
+        std::vector<int> deviceIds,
+        DeviceAdmissionLimits limits,
+        BusyTimeSource busyTime,
+        Listener listener)
         : deviceIds_(std::move(deviceIds))
+        , limits_(limits)
+        , busyTime_(std::move(busyTime))
+        , listener_(std::move(listener))
     {
         sampleOnce();
     }
@@ -89,39 +115,240 @@ public:
             result.push_back(sample);
         }
         std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.deviceId < rhs.deviceId;
+            return lhs.telemetry.deviceId < rhs.telemetry.deviceId;
         });
         return result;
     }
 
+    std::optional<DeviceMetricSample> find(int deviceId) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = samples_.find(deviceId);
+        if (it == samples_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
     std::string memoryTelemetryStatus() const {
         std::lock_guard<std::mutex> lock(mutex_);
         return memoryTelemetryStatus_;
     }
 
+    std::string thermalTelemetryStatus() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return thermalTelemetryStatus_;
+    }
+
 private:
     void sampleOnce() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (int deviceId : deviceIds_) {
-            try {
-                const auto status = dxrt::DeviceStatus::GetCurrentStatus(deviceId);
+        std::vector<DeviceMetricSample> sampled;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = std::chrono::steady_clock::now();
+            const auto window = now - lastSampleAt_;
+            for (int deviceId : deviceIds_) {
                 auto& sample = samples_[deviceId];
-                sample.deviceId = deviceId;
-                sample.memoryTotalBytes = static_cast<uint64_t>(status.MemorySize());
-            } catch (...) {
-                memoryTelemetryStatus_ = "blocked_memory_telemetry_unavailable";
+                DeviceTelemetry& telemetry = sample.telemetry;
+                telemetry.deviceId = deviceId;
+                try {
+                    const auto status = dxrt::DeviceStatus::GetCurrentStatus(deviceId);
+                    telemetry.memoryTotalBytes = static_cast<uint64_t>(status.MemorySize());
+                    readNpuCores(status, telemetry);
+                } catch (...) {
+                    telemetry.temperatureC.reset();
+                    telemetry.npuClockMhz.reset();
+                }
+                if (busyTime_) {
+                    const auto busy = busyTime_(deviceId);
+                    auto& last = lastBusy_[deviceId];
+                    if (window.count() > 0 && samplesTaken_ > 0) {
+                        telemetry.npuUtilization = std::clamp(
+                            std::chrono::duration<double>(busy - last).count() /
+                                std::chrono::duration<double>(window).count(),
+                            0.0, 1.0);
+                    }
+                    last = busy;
+                }
+                sample.health = assessDevice(telemetry, limits_, sample.health);
+                sampled.push_back(sample);
             }
+            // DXRT reports device capacity but no used-memory counter.
+            memoryTelemetryStatus_ = "blocked_memory_telemetry_unavailable";
+            thermalTelemetryStatus_ = std::any_of(sampled.begin(), sampled.end(), [](const auto& s) {
+                return s.telemetry.temperatureC.has_value();
+            }) ? "ok" : "unavailable";
+            lastSampleAt_ = now;
+            ++samplesTaken_;
         }
+        if (listener_) {
+            for (const auto& sample : sampled) {
+                listener_(sample);
+            }
+        }
+    }
+
+    static void readNpuCores(const dxrt::DeviceStatus& status, DeviceTelemetry& telemetry) {
+        std::optional<int> hottest;
+        std::optional<int> slowest;
+        for (int core = 0; core < kNpuCoreCount; ++core) {
+            const int temperature = static_cast<int>(status.GetTemperature(core));
+            const int clock = static_cast<int>(status.GetNpuClock(core));
+            if (temperature > 0) {
+                hottest = std::max(hottest.value_or(temperature), temperature);
+            }
+            if (clock > 0) {
+                slowest = std::min(slowest.value_or(clock), clock);
+                telemetry.peakNpuClockMhz = std::max(telemetry.peakNpuClockMhz, clock);
+            }
+        }
+        telemetry.temperatureC = hottest;
+        telemetry.npuClockMhz = slowest;
     }
 
     std::vector<int> deviceIds_;
+    const DeviceAdmissionLimits limits_;
+    BusyTimeSource busyTime_;
+    Listener listener_;
     mutable std::mutex mutex_;
     std::unordered_map<int, DeviceMetricSample> samples_;
+    std::unordered_map<int, std::chrono::steady_clock::duration> lastBusy_;
+    std::chrono::steady_clock::time_point lastSampleAt_ = std::chrono::steady_clock::now();
+    uint64_t samplesTaken_ = 0;
     std::string memoryTelemetryStatus_ = "blocked_memory_telemetry_unavailable";
+    std::string thermalTelemetryStatus_ = "unavailable";
     std::atomic<bool> running_{false};
     std::thread worker_;
 };
 
+// Cumulative counters the autotuner differences into a TunerWindow.
+struct AutotuneCounters {
+    std::vector<uint64_t> requestBuckets;   // rapiddoc_request_seconds, summed over shards
+    std::vector<uint64_t> queueBuckets;     // rapiddoc_request_queue_seconds, likewise
+    uint64_t npuBusyUs = 0;
+    size_t queued = 0;
+};
+
+class ConcurrencyAutotuner {
+public:
+    using Read = std::function<AutotuneCounters()>;
+    using Apply = std::function<void(const TunerKnobs&)>;
+
+    ConcurrencyAutotuner(
+        const ConcurrencyTunerConfig& config,
+        size_t shards,
+        const TunerKnobs& initial,
+        Read read,
+        Apply apply)
+        : config_(config)
+        , shards_(std::max<size_t>(1, shards))
+        , bounds_(latencySecondsBuckets())
+        , read_(std::move(read))
+        , apply_(std::move(apply))
+        , knobs_(initial)
+        , reason_("not tuned yet")
+    {
+    }
+
+    ~ConcurrencyAutotuner() {
+        stop();
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (worker_.joinable()) {
+            return;
+        }
+        stopping_ = false;
+        worker_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    TunerDecision current() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return TunerDecision{knobs_, reason_};
+    }
+
+private:
+    static std::vector<uint64_t> delta(const std::vector<uint64_t>& now, const std::vector<uint64_t>& last) {
+        std::vector<uint64_t> result(now.size());
+        for (size_t i = 0; i < now.size(); ++i) {
+            result[i] = now[i] - (i < last.size() ? last[i] : 0);
+        }
+        return result;
+    }
+
+    void run() {
+        AutotuneCounters last = read_();
+        auto lastAt = std::chrono::steady_clock::now();
+        const auto interval = std::chrono::milliseconds(std::max(100, config_.intervalMs));
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_for(lock, interval, [this]() { return stopping_; })) {
+                    return;
+                }
+            }
+            AutotuneCounters now = read_();
+            const auto at = std::chrono::steady_clock::now();
+            const double windowUs = std::chrono::duration<double, std::micro>(at - lastAt).count();
+
+            TunerWindow window;
+            const auto requests = delta(now.requestBuckets, last.requestBuckets);
+            for (uint64_t count : requests) {
+                window.completed += static_cast<size_t>(count);
+            }
+            window.queued = now.queued;
+            window.requestP95Seconds = histogramQuantile(bounds_, requests, 0.95);
+            window.queueP95Seconds = histogramQuantile(bounds_, delta(now.queueBuckets, last.queueBuckets), 0.95);
+            window.npuBusyShare = windowUs > 0.0
+                ? std::clamp(static_cast<double>(now.npuBusyUs - last.npuBusyUs) /
+                                 (windowUs * static_cast<double>(shards_)), 0.0, 1.0)
+                : 0.0;
+            last = std::move(now);
+            lastAt = at;
+
+            const TunerKnobs previous = current().knobs;
+            const TunerDecision decision = tuneConcurrency(previous, window, config_, shards_);
+            if (decision.knobs != previous) {
+                LOG_INFO("Autotune: running documents {} -> {}, OCR lanes {} -> {}, "
+                         "layout batch window {} -> {} ms ({})",
+                         previous.inflight, decision.knobs.inflight, previous.ocrLanes,
+                         decision.knobs.ocrLanes, previous.batchDelayMs, decision.knobs.batchDelayMs,
+                         decision.reason);
+                apply_(decision.knobs);
+            } else {
+                LOG_DEBUG("Autotune: holding ({}; {} done, {} queued, p95 {:.3f} s)",
+                          decision.reason, window.completed, window.queued, window.requestP95Seconds);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            knobs_ = decision.knobs;
+            reason_ = decision.reason;
+        }
+    }
+
+    const ConcurrencyTunerConfig config_;
+    const size_t shards_;
+    const std::vector<double> bounds_;
+    Read read_;
+    Apply apply_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    TunerKnobs knobs_;
+    std::string reason_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
 namespace {
 
 using json = nlohmann::json;
@@ -146,22 +373,6 @@ bool isImageExtension(const std::string& extension) {
     return std::find(kImageSuffixes.begin(), kImageSuffixes.end(), lower) != kImageSuffixes.end();
 }
 
-std::string contentElementTypeToString(ContentElement::Type type) {
-    switch (type) {
-        case ContentElement::Type::TEXT: return "text";
-        case ContentElement::Type::TITLE: return "title";
-        case ContentElement::Type::IMAGE: return "image";
-        case ContentElement::Type::TABLE: return "table";
-        case ContentElement::Type::EQUATION: return "equation";
-        case ContentElement::Type::CODE: return "code";
-        case ContentElement::Type::LIST: return "list";
-        case ContentElement::Type::HEADER: return "header";
-        case ContentElement::Type::FOOTER: return "footer";
-        case ContentElement::Type::REFERENCE: return "reference";
-        default: return "unknown";
-    }
-}
-
 std::string safeFilename(std::string filename) {
     filename = fs::path(filename).filename().string();
     if (filename.empty()) {
@@ -230,6 +441,7 @@ std::string mimeTypeForPath(const fs::path& path) {
     const std::string ext = toLower(path.extension().string());
     if (ext == ".png") return "image/png";
     if (ext == ".jpg" || ext == ".jpeg") return "image/jpeg";
+    if (ext == ".webp") return "image/webp";
     if (ext == ".bmp") return "image/bmp";
     if (ext == ".tif" || ext == ".tiff") return "image/tiff";
     if (ext == ".pdf") return "application/pdf";
@@ -254,6 +466,15 @@ void writeTextFile(const fs::path& path, const std::string& data) {
     out << data;
 }
 
+std::ofstream openTextFile(const fs::path& path) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + path.string());
+    }
+    return out;
+}
+
 std::string readBinaryFile(const fs::path& path) {
     std::ifstream in(path, std::ios::binary);
     if (!in.is_open()) {
@@ -326,30 +547,36 @@ std::string makeServerId(const ServerConfig& config, const std::string& topology
     return out.str();
 }
 
-std::vector<uint8_t> base64Decode(const std::string& encoded) {
-    static const std::string kBase64Chars =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+// Decodes in one pass straight into the buffer the pipeline reads, so a
+// base64 upload is held once encoded and once decoded, never more.
+std::string base64Decode(std::string_view encoded) {
+    static const auto kBase64Values = []() {
+        std::array<int8_t, 256> values{};
+        values.fill(-1);
+        const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; ++i) {
+            values[static_cast<unsigned char>(chars[i])] = static_cast<int8_t>(i);
+        }
+        return values;
+    }();
 
-    std::vector<uint8_t> decoded;
-    decoded.reserve(encoded.size() * 3 / 4);
+    std::string decoded;
+    decoded.reserve(encoded.size() / 4 * 3 + 3);
 
-    int value = 0;
+    uint32_t value = 0;
     int bits = -8;
     for (unsigned char ch : encoded) {
-        if (std::isspace(ch)) {
-            continue;
-        }
         if (ch == '=') {
             break;
         }
-        const auto pos = kBase64Chars.find(static_cast<char>(ch));
-        if (pos == std::string::npos) {
-            continue;
+        const int8_t digit = kBase64Values[ch];
+        if (digit < 0) {
+            continue;   // whitespace and line breaks
         }
-        value = (value << 6) + static_cast<int>(pos);
+        value = (value << 6) | static_cast<uint32_t>(digit);
         bits += 6;
         if (bits >= 0) {
-            decoded.push_back(static_cast<uint8_t>((value >> bits) & 0xFF));
+            decoded.push_back(static_cast<char>((value >> bits) & 0xFF));
             bits -= 8;
         }
     }
@@ -357,13 +584,14 @@ std::vector<uint8_t> base64Decode(const std::string& encoded) {
     return decoded;
 }
 
-std::vector<crow::multipart::part> getMultipartParts(
+// Points into @p msg rather than copying, since each part holds a whole upload.
+std::vector<const crow::multipart::part*> getMultipartParts(
     const crow::multipart::message& msg,
     const std::string& name) {
-    std::vector<crow::multipart::part> parts;
+    std::vector<const crow::multipart::part*> parts;
     const auto range = msg.part_map.equal_range(name);
     for (auto it = range.first; it != range.second; ++it) {
-        parts.push_back(it->second);
+        parts.push_back(&it->second);
     }
     return parts;
 }
@@ -431,9 +659,33 @@ json makeStatsJson(
         {"table_ms", result.stats.tableTimeMs},
         {"npu_serial_ms", result.stats.npuSerialTimeMs},
         {"cpu_only_ms", result.stats.cpuOnlyTimeMs},
+        {"npu_stage_cpu_ms", result.stats.npuStageCpuTimeMs},
+        {"postprocess_cpu_ms", result.stats.postprocessCpuTimeMs},
         {"npu_lock_wait_ms", result.stats.npuLockWaitTimeMs},
         {"npu_lock_hold_ms", result.stats.npuLockHoldTimeMs},
+        {"npu_engines", {
+            {"layout", {
+                {"wait_ms", result.stats.layoutNpuWaitTimeMs},
+                {"hold_ms", result.stats.layoutNpuHoldTimeMs},
+            }},
+            {"ocr", {
+                {"wait_ms", result.stats.ocrNpuWaitTimeMs},
+                {"hold_ms", result.stats.ocrNpuHoldTimeMs},
+            }},
+            {"table", {
+                {"wait_ms", result.stats.tableNpuWaitTimeMs},
+                {"hold_ms", result.stats.tableNpuHoldTimeMs},
+            }},
+        }},
         {"output_gen_ms", result.stats.outputGenTimeMs},
+        {"recognition_cache", {
+            {"layout_hits", result.stats.layoutCacheHits},
+            {"layout_misses", result.stats.layoutCacheMisses},
+            {"ocr_hits", result.stats.ocrCacheHits},
+            {"ocr_misses", result.stats.ocrCacheMisses},
+        }},
+        {"text_layer_regions", result.stats.textLayerRegions},
+        {"blank_pages", result.stats.blankPages},
     };
 
     if (pipelineCallMs.has_value()) {
@@ -448,114 +700,20 @@ json makeStatsJson(
     return stats;
 }
 
-json buildContentListJson(const DocumentResult& result) {
-    if (result.contentListJson.empty()) {
-        return json::array();
-    }
-
-    try {
-        return json::parse(result.contentListJson);
-    }
-    catch (...) {
-        return json::array();
-    }
-}
-
-json buildMiddleJson(const DocumentResult& result) {
-    json pdfInfo = json::array();
-
-    for (const auto& page : result.pages) {
-        json elements = json::array();
-        for (const auto& elem : page.elements) {
-            json item{
-                {"type", contentElementTypeToString(elem.type)},
-                {"bbox", {elem.layoutBox.x0, elem.layoutBox.y0, elem.layoutBox.x1, elem.layoutBox.y1}},
-                {"score", elem.confidence},
-                {"page_idx", elem.pageIndex},
-                {"reading_order", elem.readingOrder},
-                {"skipped", elem.skipped},
-            };
-            if (!elem.text.empty()) {
-                item["text"] = elem.text;
-            }
-            if (!elem.html.empty()) {
-                item["html"] = elem.html;
-            }
-            if (!elem.imagePath.empty()) {
-                item["image_path"] = elem.imagePath;
-            }
-            elements.push_back(std::move(item));
-        }
-
-        pdfInfo.push_back(json{
-            {"page_idx", page.pageIndex},
-            {"page_size", {page.pageWidth, page.pageHeight}},
-            {"elements", std::move(elements)},
-        });
-    }
-
-    return json{{"pdf_info", std::move(pdfInfo)}};
-}
-
-json buildModelJson(const DocumentResult& result) {
-    json pages = json::array();
-
-    for (const auto& page : result.pages) {
-        json layoutDetections = json::array();
-        for (const auto& box : page.layoutResult.boxes) {
-            layoutDetections.push_back(json{
-                {"category_id", box.clsId >= 0 ? box.clsId : static_cast<int>(box.category)},
-                {"label", box.label.empty() ? layoutCategoryToString(box.category) : box.label},
-                {"poly", {
-                    static_cast<int>(box.x0), static_cast<int>(box.y0),
-                    static_cast<int>(box.x1), static_cast<int>(box.y0),
-                    static_cast<int>(box.x1), static_cast<int>(box.y1),
-                    static_cast<int>(box.x0), static_cast<int>(box.y1)
-                }},
-                {"bbox", {box.x0, box.y0, box.x1, box.y1}},
-                {"score", box.confidence},
-            });
-        }
-
-        pages.push_back(json{
-            {"layout_dets", std::move(layoutDetections)},
-            {"page_info", {
-                {"page_no", page.pageIndex},
-                {"width", page.pageWidth},
-                {"height", page.pageHeight},
-            }},
-        });
-    }
-
-    return pages;
-}
-
-json collectImagesAsDataUrls(const fs::path& imageDir) {
-    json images = json::object();
-    if (!fs::exists(imageDir)) {
-        return images;
-    }
-
-    std::vector<fs::path> files;
-    for (const auto& entry : fs::directory_iterator(imageDir)) {
-        if (entry.is_regular_file()) {
-            files.push_back(entry.path());
-        }
-    }
-    std::sort(files.begin(), files.end());
-
-    for (const auto& path : files) {
-        const std::string raw = readBinaryFile(path);
-        if (raw.empty()) {
+// Inline the crops the pipeline kept in memory, keyed by file name like the
+// images/ directory they were written to.
+json collectImagesAsDataUrls(const std::vector<EncodedImage>& images) {
+    json dataUrls = json::object();
+    for (const auto& image : images) {
+        if (image.data.empty()) {
             continue;
         }
-
-        images[path.filename().string()] =
+        const fs::path path(image.path);
+        dataUrls[path.filename().string()] =
             "data:" + mimeTypeForPath(path) + ";base64," +
-            base64Encode(reinterpret_cast<const unsigned char*>(raw.data()), raw.size());
+            base64Encode(image.data.data(), image.data.size());
     }
-
-    return images;
+    return dataUrls;
 }
 
 json collectAbsoluteFiles(const fs::path& dir) {
@@ -601,13 +759,26 @@ struct FileParseOptions {
     bool returnModelOutput = false;
     bool returnContentList = false;
     bool returnImages = false;
+    bool writeJsonArtifacts = false;   // pretty _middle.json / _model.json copies on disk
+    bool saveVisualization = false;    // layout/page_*_layout images
     int startPageId = 0;
     int endPageId = 99999;
+    std::string priority = "auto";     // "interactive" | "batch" | "auto" (by file type)
+    bool mergeImages = false;          // parse all uploaded images as one multi-page document
+    bool saveOrigin = true;            // keep a _origin copy of the upload in the parse directory
+    ResultFormat responseFormat = ResultFormat::JSON;   // body and JSON artifacts
     bool deepxRequested = true;
     std::string layoutEngine = "dxengine";
     std::string ocrEngine = "dxengine";
     std::string formulaEngine = "image_fallback";
     std::string tableEngine = "dxengine";
+    bool useResultCache = true;        // async jobs checkpoint pages, which a cache hit has none of
+    // Set by the handler, not the form: the async job's stop token, and the
+    // earlier of the server's request timeout and the LB's deadline. A sync
+    // handler blocks Crow's connection, so a client that hangs up is not
+    // noticed; its run ends at the deadline.
+    std::shared_ptr<CancellationToken> cancel;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
 };
 
 std::vector<std::string> collectRequestWarnings(const FileParseOptions& options) {
@@ -629,9 +800,6 @@ std::vector<std::string> collectRequestWarnings(const FileParseOptions& options)
         toLower(options.formulaEngine) != "image_fallback") {
         warnings.push_back("formula_engine request ignored; C++ backend uses image fallback.");
     }
-    if (options.parseMethod == "txt") {
-        warnings.push_back("parse_method=txt is not natively supported in C++; falling back to auto pipeline.");
-    }
     return warnings;
 }
 
@@ -643,15 +811,28 @@ PipelineRunOverrides makeRunOverrides(
     PipelineRunOverrides overrides;
     overrides.outputDir = outputDir.string();
     overrides.saveImages = true;
-    overrides.saveVisualization = true;
+    overrides.saveVisualization = options.saveVisualization;
+    overrides.keepEncodedImages = options.returnImages;
     overrides.startPageId = options.startPageId;
     overrides.endPageId = options.endPageId;
     overrides.enableFormula = options.formulaEnable;
     overrides.enableWiredTable = options.tableEnable;
     overrides.enableMarkdownOutput = pipeline.config().stages.enableMarkdownOutput;
+    overrides.cancel = options.cancel;
+    overrides.deadline = options.deadline;
+    // txt: text regions from the PDF text layer, OCR only where it has none;
+    // ocr: always OCR; auto: the server's runtime.useTextLayer.
+    if (options.parseMethod == "txt") {
+        overrides.useTextLayer = true;
+    } else if (options.parseMethod == "ocr") {
+        overrides.useTextLayer = false;
+    }
     return overrides;
 }
 
+// Receives the page records of an async job run: an event name and its JSON.
+using RecordSink = std::function<void(const std::string& event, json record)>;
+
 struct ProcessedDocument {
     std::string requestId;
     std::string filename;
@@ -666,11 +847,13 @@ struct ProcessedDocument {
     json contentList = json::array();
     json middleJson = json::object();
     json modelJson = json::array();
+    std::string markdown;
     DocumentResult result;
     std::vector<std::string> warnings;
     double prepareTimeMs = 0.0;
     double pipelineCallTimeMs = 0.0;
     double assemblyTimeMs = 0.0;
+    bool cacheHit = false;
 };
 
 struct DispatchMetadata {
@@ -687,21 +870,64 @@ struct RoutedProcessedDocument {
     DispatchMetadata dispatch;
 };
 
-ProcessedDocument processDocumentBytes(
-    DocPipeline& pipeline,
-    const std::string& bytes,
-    const std::string& filename,
-    const FileParseOptions& options) {
-    if (options.backend != "pipeline") {
-        throw std::runtime_error("Unsupported backend: " + options.backend);
+// Routing metadata a fronting topology LB asked us to stamp into the
+// response, so it can pass the body through without rewriting it.
+struct LbForwarding {
+    std::string backendId;
+    std::string serverId;
+    double overheadMs = 0.0;
+
+    bool present() const { return !backendId.empty(); }
+};
+
+LbForwarding readLbForwarding(const crow::request& req) {
+    LbForwarding lb;
+    lb.backendId = req.get_header_value(lb_headers::kBackendId);
+    lb.serverId = req.get_header_value(lb_headers::kServerId);
+    lb.overheadMs = std::atof(req.get_header_value(lb_headers::kOverheadMs).c_str());
+    return lb;
+}
+
+// The earlier of the server's request timeout and the time a fronting LB
+// still waits for the response, counted from @p receivedAt.
+std::optional<std::chrono::steady_clock::time_point> requestDeadline(
+    const crow::request& req,
+    const ServerConfig& config,
+    std::chrono::steady_clock::time_point receivedAt)
+{
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (config.requestTimeoutSeconds > 0) {
+        deadline = receivedAt + std::chrono::seconds(config.requestTimeoutSeconds);
+    }
+    const std::string lbBudget = req.get_header_value(lb_headers::kDeadlineMs);
+    if (!lbBudget.empty()) {
+        const auto lbDeadline =
+            receivedAt + std::chrono::milliseconds(std::max(0LL, std::atoll(lbBudget.c_str())));
+        if (!deadline || lbDeadline < *deadline) {
+            deadline = lbDeadline;
+        }
     }
+    return deadline;
+}
+
+void applyLbForwarding(const LbForwarding& lb, DispatchMetadata& dispatch) {
+    if (!lb.present()) {
+        return;
+    }
+    dispatch.topology = "front_lb";
+    dispatch.backendId = lb.backendId;
+    dispatch.lbProxyMs = lb.overheadMs;
+}
 
+// Fresh request directory layout for @p filename; creates the parse directory.
+ProcessedDocument prepareProcessedDocument(
+    const std::string& filename,
+    const FileParseOptions& options)
+{
     const std::string cleanName = safeFilename(filename);
     const std::string stem = safeStem(cleanName);
-    const std::string extension = toLower(fs::path(cleanName).extension().string());
 
     ProcessedDocument processed;
-    const auto prepareStart = std::chrono::steady_clock::now();
     processed.requestId = makeRequestId();
     processed.filename = cleanName;
     processed.requestDir = fs::absolute(fs::path(options.outputDir) / processed.requestId);
@@ -710,27 +936,130 @@ ProcessedDocument processDocumentBytes(
     processed.layoutDir = processed.parseDir / "layout";
     processed.markdownPath = processed.parseDir / (stem + ".md");
     processed.contentListPath = processed.parseDir / (stem + "_content_list.json");
-    processed.middleJsonPath = processed.parseDir / (stem + "_middle.json");
-    processed.modelJsonPath = processed.parseDir / (stem + "_model.json");
+    const std::string artifactExtension = resultFormatExtension(options.responseFormat);
+    processed.middleJsonPath = processed.parseDir / (stem + "_middle" + artifactExtension);
+    processed.modelJsonPath = processed.parseDir / (stem + "_model" + artifactExtension);
     processed.warnings = collectRequestWarnings(options);
 
     fs::create_directories(processed.parseDir);
-    writeBinaryFile(processed.parseDir / (stem + "_origin" + extension), bytes);
+    return processed;
+}
+
+// @p fanout, when it holds more than one pipeline (starting with @p pipeline),
+// splits a PDF's pages across all of them; @p fanoutStats then receives the
+// page stats each pipeline accumulated. @p morePages are further images that
+// follow @p bytes as pages of the same document. With @p records set, each
+// page's Markdown and content-list entry go out as a "page" record when the
+// page completes and are not collected into the ProcessedDocument.
+ProcessedDocument processDocumentBytes(
+    DocPipeline& pipeline,
+    const std::string& bytes,
+    const std::string& filename,
+    const FileParseOptions& options,
+    const std::vector<DocPipeline*>& fanout = {},
+    std::vector<PageStageStats>* fanoutStats = nullptr,
+    const std::vector<const std::string*>& morePages = {},
+    const RecordSink& records = {}) {
+    if (options.backend != "pipeline") {
+        throw std::runtime_error("Unsupported backend: " + options.backend);
+    }
+
+    const std::string cleanName = safeFilename(filename);
+    const std::string stem = safeStem(cleanName);
+    const std::string extension = toLower(fs::path(cleanName).extension().string());
+
+    const auto prepareStart = std::chrono::steady_clock::now();
+    ProcessedDocument processed = prepareProcessedDocument(filename, options);
+    // The _origin copy is written while the pipeline runs, and skipped when
+    // the directory is deleted right after the response anyway.
+    std::future<void> originWrite;
+    if (options.saveOrigin && !options.clearOutputFile) {
+        originWrite = std::async(
+            std::launch::async, writeBinaryFile,
+            processed.parseDir / (stem + "_origin" + extension), std::cref(bytes));
+    }
 
-    const PipelineRunOverrides overrides = makeRunOverrides(
+    PipelineRunOverrides overrides = makeRunOverrides(
         pipeline, options, processed.parseDir);
+    overrides.traceId = processed.requestId;
+
+    // Markdown and the content list go to disk page by page while the
+    // document is processed; the response keeps the only in-memory Markdown.
+    std::ofstream markdownFile = openTextFile(processed.markdownPath);
+    std::ofstream contentListFile = openTextFile(processed.contentListPath);
+    overrides.markdownSink = makeStreamSink(markdownFile);
+    overrides.contentListSink = makeStreamSink(contentListFile);
+    std::string pageMarkdown;
+    std::string pageContentList;
+    if (records) {
+        if (options.returnMd) {
+            overrides.markdownSink = teeSinks(
+                std::move(overrides.markdownSink), makeStringSink(pageMarkdown));
+        }
+        if (options.returnContentList) {
+            overrides.contentListSink = teeSinks(
+                std::move(overrides.contentListSink), makeStringSink(pageContentList));
+        }
+        overrides.progress = [&](const std::string& stage, int current, int total) {
+            if (stage != "Processing") {
+                return;
+            }
+            json record{
+                {"type", "page"},
+                {"filename", processed.filename},
+                {"page", current},
+                {"total_pages", total},
+            };
+            if (options.returnMd) {
+                // Chunks concatenate to the document's md_content.
+                record["md_content"] = std::move(pageMarkdown);
+                pageMarkdown.clear();
+            }
+            if (options.returnContentList && pageContentList.size() > 1) {
+                // The chunk opens with the array's '[' or ',' separator.
+                record["content_list"] = json::parse(pageContentList.begin() + 1, pageContentList.end());
+                pageContentList.clear();
+            }
+            records("page", std::move(record));
+        };
+    } else if (options.returnMd) {
+        overrides.markdownSink = teeSinks(
+            std::move(overrides.markdownSink), makeStringSink(processed.markdown));
+    }
 
     const bool isPdf = isPdfExtension(extension);
     const bool isImage = isImageExtension(extension);
-    cv::Mat decodedImage;
+    std::vector<cv::Mat> decodedImages;
     if (!isPdf && !isImage) {
         throw std::runtime_error("Unsupported file type: " + extension);
     }
+    if (!morePages.empty() && !isImage) {
+        throw std::runtime_error("Only images can be merged into one document: " + cleanName);
+    }
     if (isImage) {
-        std::vector<uint8_t> buffer(bytes.begin(), bytes.end());
-        decodedImage = cv::imdecode(buffer, cv::IMREAD_COLOR);
-        if (decodedImage.empty()) {
-            throw std::runtime_error("Failed to decode image: " + cleanName);
+        TRACE_SPAN("decode_images", "server");
+        // Each page decodes on its own thread; the first on this one.
+        auto decode = [&cleanName](const std::string& data, size_t page) {
+            // Decoded from a header over the upload bytes, without a copy.
+            const cv::Mat encoded(
+                1, static_cast<int>(data.size()), CV_8UC1, const_cast<char*>(data.data()));
+            cv::Mat image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+            if (image.empty()) {
+                throw std::runtime_error(
+                    "Failed to decode image: " + cleanName +
+                    (page > 0 ? " (page " + std::to_string(page + 1) + ")" : std::string()));
+            }
+            return image;
+        };
+        std::vector<std::future<cv::Mat>> pending;
+        pending.reserve(morePages.size());
+        for (size_t i = 0; i < morePages.size(); ++i) {
+            pending.push_back(std::async(std::launch::async, decode, std::cref(*morePages[i]), i + 1));
+        }
+        decodedImages.reserve(morePages.size() + 1);
+        decodedImages.push_back(decode(bytes, 0));
+        for (auto& page : pending) {
+            decodedImages.push_back(page.get());
         }
     }
     const auto prepareEnd = std::chrono::steady_clock::now();
@@ -738,27 +1067,46 @@ ProcessedDocument processDocumentBytes(
         std::chrono::duration<double, std::milli>(prepareEnd - prepareStart).count();
 
     const auto pipelineStart = std::chrono::steady_clock::now();
-    if (isPdf) {
+    if (isPdf && fanout.size() > 1) {
+        processed.result = DocPipeline::processPdfFromMemoryAcross(
+            fanout, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), overrides,
+            fanoutStats);
+    } else if (isPdf) {
         processed.result = pipeline.processPdfFromMemoryWithOverrides(
             reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), overrides);
+    } else if (decodedImages.size() > 1) {
+        processed.result = pipeline.processImagesAsDocumentWithOverrides(
+            decodedImages, overrides);
     } else if (isImage) {
         processed.result = pipeline.processImageDocumentWithOverrides(
-            decodedImage, 0, overrides);
+            decodedImages.front(), 0, overrides);
     }
     const auto pipelineEnd = std::chrono::steady_clock::now();
     processed.pipelineCallTimeMs =
         std::chrono::duration<double, std::milli>(pipelineEnd - pipelineStart).count();
 
+    TRACE_SPAN("assemble_response", "server");
     const auto assemblyStart = std::chrono::steady_clock::now();
-    writeTextFile(processed.markdownPath, processed.result.markdown);
-    writeTextFile(processed.contentListPath, processed.result.contentListJson);
-
-    processed.contentList = buildContentListJson(processed.result);
-    processed.middleJson = buildMiddleJson(processed.result);
-    processed.modelJson = buildModelJson(processed.result);
+    markdownFile.close();
+    contentListFile.close();
+    if (originWrite.valid()) {
+        originWrite.get();
+    }
 
-    writeTextFile(processed.middleJsonPath, processed.middleJson.dump(2));
-    writeTextFile(processed.modelJsonPath, processed.modelJson.dump(2));
+    // Only the artifacts this request returns (or writes to disk) are built.
+    if (options.returnContentList && !records) {
+        processed.contentList = buildContentListJson(processed.result);
+    }
+    if (options.returnMiddleJson || options.writeJsonArtifacts) {
+        processed.middleJson = buildMiddleJson(processed.result);
+    }
+    if (options.returnModelOutput || options.writeJsonArtifacts) {
+        processed.modelJson = buildModelJson(processed.result);
+    }
+    if (options.writeJsonArtifacts) {
+        writeBinaryFile(processed.middleJsonPath, encodeResult(processed.middleJson, options.responseFormat, 2));
+        writeBinaryFile(processed.modelJsonPath, encodeResult(processed.modelJson, options.responseFormat, 2));
+    }
     const auto assemblyEnd = std::chrono::steady_clock::now();
     processed.assemblyTimeMs =
         std::chrono::duration<double, std::milli>(assemblyEnd - assemblyStart).count();
@@ -780,11 +1128,158 @@ ProcessedDocument processDocumentBytes(
     return processed;
 }
 
+// Everything besides the input that shapes a parse: models, pipeline
+// settings and the server version. Part of every result cache key.
+std::string makeModelFingerprint(const PipelineConfig& config) {
+    std::ostringstream out;
+    out << "rapiddoc-0.1.0-cpp";
+    for (const std::string* path : {
+             &config.models.layoutDxnnModel, &config.models.layoutOnnxSubModel,
+             &config.models.tableUnetDxnnModel, &config.models.ocrModelDir,
+             &config.models.ocrDictPath}) {
+        std::error_code ec;
+        const auto size = fs::is_regular_file(*path, ec) ? fs::file_size(*path, ec) : 0;
+        const auto mtime = fs::last_write_time(*path, ec).time_since_epoch().count();
+        out << "|" << *path << ":" << size << ":" << mtime;
+    }
+    const auto& stages = config.stages;
+    const auto& runtime = config.runtime;
+    out << "|stages:" << stages.enableLayout << stages.enableOcr << stages.enableWiredTable
+        << stages.enableReadingOrder << stages.enableMarkdownOutput << stages.enableFormula
+        << "|dpi:" << runtime.pdfDpi << "|layout_dpi:" << runtime.layoutDpi
+        << "|text_layer:" << runtime.useTextLayer << "|layout_fast_resize:" << runtime.layoutFastResize
+        << "|max_pages:" << runtime.maxPages << "|blank_ink:" << runtime.blankPageInkRatio
+        << "|layout_conf:" << runtime.layoutConfThreshold
+        << "|table_conf:" << runtime.tableConfThreshold
+        << "|image:" << runtime.imageFormat << ":" << runtime.imageQuality;
+    return out.str();
+}
+
+// Request options that change what a parse returns or leaves on disk.
+std::string makeCacheSalt(
+    const std::string& modelFingerprint,
+    const std::string& filename,
+    const FileParseOptions& options)
+{
+    std::ostringstream out;
+    out << modelFingerprint
+        << "|ext:" << toLower(fs::path(safeFilename(filename)).extension().string())
+        << "|backend:" << options.backend << "|method:" << options.parseMethod
+        << "|formula:" << options.formulaEnable << "|table:" << options.tableEnable
+        << "|md:" << options.returnMd << "|middle:" << options.returnMiddleJson
+        << "|model:" << options.returnModelOutput << "|content:" << options.returnContentList
+        << "|images:" << options.returnImages << "|json_files:" << options.writeJsonArtifacts
+        << "|vis:" << options.saveVisualization
+        << "|format:" << resultFormatExtension(options.responseFormat)
+        << "|pages:" << options.startPageId << "-" << options.endPageId;
+    return out.str();
+}
+
+// Files named after the document stem are stored with the stem replaced by
+// this marker, so a re-upload under another name still hits.
+constexpr char kCachedStemMarker = '@';
+
+// Snapshot of a finished parse directory for the result cache. The
+// _origin copy is left out; a hit writes it from the uploaded bytes.
+std::shared_ptr<const CachedParse> captureCachedParse(const ProcessedDocument& processed) {
+    const std::string stem = safeStem(processed.filename);
+    const std::string origin = stem + "_origin";
+    auto parse = std::make_shared<CachedParse>();
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(processed.parseDir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        CachedFile file;
+        file.path = fs::relative(it->path(), processed.parseDir).generic_string();
+        const bool topLevel = file.path.find('/') == std::string::npos;
+        if (topLevel && file.path.rfind(origin, 0) == 0) {
+            continue;
+        }
+        if (topLevel && file.path.rfind(stem, 0) == 0) {
+            file.path = kCachedStemMarker + file.path.substr(stem.size());
+        }
+        file.data = readBinaryFile(it->path());
+        parse->files.push_back(std::move(file));
+    }
+    if (ec) {
+        return nullptr;
+    }
+
+    json meta{
+        {"processed_pages", processed.result.processedPages},
+        {"total_pages", processed.result.totalPages},
+        {"skipped", processed.result.skippedElements},
+        {"time_ms", processed.result.totalTimeMs},
+    };
+    if (!processed.middleJson.empty()) {
+        meta["middle_json"] = processed.middleJson;
+    }
+    if (!processed.modelJson.empty()) {
+        meta["model_json"] = processed.modelJson;
+    }
+    parse->meta = meta.dump();
+    return parse;
+}
+
+// Rebuilds a request from a cached parse without running the pipeline.
+ProcessedDocument restoreCachedParse(
+    const CachedParse& parse,
+    const std::string& bytes,
+    const std::string& filename,
+    const FileParseOptions& options)
+{
+    const auto restoreStart = std::chrono::steady_clock::now();
+    ProcessedDocument processed = prepareProcessedDocument(filename, options);
+    processed.cacheHit = true;
+    const std::string stem = safeStem(processed.filename);
+    const std::string extension = toLower(fs::path(processed.filename).extension().string());
+    if (options.saveOrigin && !options.clearOutputFile) {
+        writeBinaryFile(processed.parseDir / (stem + "_origin" + extension), bytes);
+    }
+
+    for (const auto& file : parse.files) {
+        std::string path = file.path;
+        if (!path.empty() && path.front() == kCachedStemMarker) {
+            path = stem + path.substr(1);
+        }
+        writeBinaryFile(processed.parseDir / fs::path(path), file.data);
+        if (options.returnImages && path.rfind("images/", 0) == 0) {
+            processed.result.images.push_back(EncodedImage{
+                path, std::vector<uint8_t>(file.data.begin(), file.data.end())});
+        }
+    }
+
+    const json meta = json::parse(parse.meta);
+    processed.result.processedPages = meta.value("processed_pages", 0);
+    processed.result.totalPages = meta.value("total_pages", 0);
+    processed.result.skippedElements = meta.value("skipped", 0);
+    processed.result.totalTimeMs = meta.value("time_ms", 0.0);
+    if (options.returnMd) {
+        processed.markdown = readBinaryFile(processed.markdownPath);
+    }
+    if (options.returnContentList) {
+        processed.contentList = json::parse(readBinaryFile(processed.contentListPath));
+    }
+    if (options.returnMiddleJson && meta.contains("middle_json")) {
+        processed.middleJson = meta["middle_json"];
+    }
+    if (options.returnModelOutput && meta.contains("model_json")) {
+        processed.modelJson = meta["model_json"];
+    }
+    processed.assemblyTimeMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - restoreStart).count();
+    return processed;
+}
+
+// Moves the requested JSON artifacts out of @p processed into the result.
 json buildFileResult(
-    const ProcessedDocument& processed,
+    ProcessedDocument& processed,
     const FileParseOptions& options,
     const DispatchMetadata& dispatch)
 {
+    TRACE_SPAN("build_file_result", "server");
     json result{
         {"filename", processed.filename},
         {"backend", options.backend},
@@ -802,29 +1297,38 @@ json buildFileResult(
         {"output_dir", processed.parseDir.string()},
         {"markdown_path", processed.markdownPath.string()},
         {"content_list_path", processed.contentListPath.string()},
-        {"middle_json_path", processed.middleJsonPath.string()},
-        {"model_output_path", processed.modelJsonPath.string()},
         {"layout_files", collectAbsoluteFiles(processed.layoutDir)},
     };
+    if (options.writeJsonArtifacts) {
+        result["middle_json_path"] = processed.middleJsonPath.string();
+        result["model_output_path"] = processed.modelJsonPath.string();
+    }
 
     if (options.returnMd) {
-        result["md_content"] = processed.result.markdown;
+        result["md_content"] = std::move(processed.markdown);
     }
     if (options.returnMiddleJson) {
-        result["middle_json"] = processed.middleJson;
+        result["middle_json"] = std::move(processed.middleJson);
     }
     if (options.returnModelOutput) {
-        result["model_output"] = processed.modelJson;
+        result["model_output"] = std::move(processed.modelJson);
     }
     if (options.returnContentList) {
-        result["content_list"] = processed.contentList;
+        result["content_list"] = std::move(processed.contentList);
     }
     if (options.returnImages) {
-        result["images"] = collectImagesAsDataUrls(processed.imagesDir);
+        result["images"] = collectImagesAsDataUrls(processed.result.images);
     }
     if (!processed.warnings.empty()) {
         result["warnings"] = processed.warnings;
     }
+    if (processed.cacheHit) {
+        result["cache_hit"] = true;
+    }
+    if (processed.result.cancelled) {
+        // Stopped at the request deadline: only the leading pages that finished are here.
+        result["partial"] = true;
+    }
 
     return result;
 }
@@ -849,7 +1353,10 @@ json buildHealthJson() {
     };
 }
 
-FileParseOptions parseFileParseOptions(const crow::multipart::message& msg) {
+FileParseOptions parseFileParseOptions(
+    const crow::multipart::message& msg,
+    const ServerConfig& config)
+{
     FileParseOptions options;
     options.outputDir = getMultipartField(msg, "output_dir", options.outputDir);
     options.clearOutputFile = parseBool(getMultipartField(msg, "clear_output_file"), false);
@@ -874,26 +1381,625 @@ FileParseOptions parseFileParseOptions(const crow::multipart::message& msg) {
     options.returnModelOutput = parseBool(getMultipartField(msg, "return_model_output"), false);
     options.returnContentList = parseBool(getMultipartField(msg, "return_content_list"), false);
     options.returnImages = parseBool(getMultipartField(msg, "return_images"), false);
+    options.writeJsonArtifacts = parseBool(
+        getMultipartField(msg, "write_json_artifacts"), config.writeJsonArtifacts);
+    options.saveVisualization = parseBool(
+        getMultipartField(msg, "save_visualization"), config.saveVisualization);
     options.startPageId = parseInt(getMultipartField(msg, "start_page_id"), 0);
     options.endPageId = parseInt(getMultipartField(msg, "end_page_id"), 99999);
+    options.mergeImages = parseBool(getMultipartField(msg, "merge_images"), false);
+    options.saveOrigin = parseBool(getMultipartField(msg, "save_origin"), config.saveOriginUploads);
+    const std::string priority = getMultipartField(msg, "priority");
+    if (!priority.empty()) {
+        options.priority = priority;
+    }
     return options;
 }
 
-} // namespace
+// Parse options an async job is stored with, so a restarted server reruns
+// it the same way.
+json jobOptionsToJson(const FileParseOptions& options) {
+    return json{
+        {"backend", options.backend},
+        {"parse_method", options.parseMethod},
+        {"lang_list", options.langList},
+        {"formula_enable", options.formulaEnable},
+        {"table_enable", options.tableEnable},
+        {"write_json_artifacts", options.writeJsonArtifacts},
+        {"save_visualization", options.saveVisualization},
+        {"start_page_id", options.startPageId},
+        {"end_page_id", options.endPageId},
+    };
+}
 
-DocServer::DocServer(const ServerConfig& config)
-    : config_(config)
-{
-    fs::create_directories(config_.uploadDir);
+// Options for one run of a stored job. Pages come back through the page
+// records, so Markdown and the content list are always on.
+FileParseOptions jobParseOptions(const json& stored, const fs::path& outputDir) {
+    FileParseOptions options;
+    options.outputDir = outputDir.string();
+    options.backend = stored.value("backend", options.backend);
+    options.parseMethod = stored.value("parse_method", options.parseMethod);
+    options.langList = stored.value("lang_list", options.langList);
+    options.formulaEnable = stored.value("formula_enable", options.formulaEnable);
+    options.tableEnable = stored.value("table_enable", options.tableEnable);
+    options.writeJsonArtifacts = stored.value("write_json_artifacts", options.writeJsonArtifacts);
+    options.saveVisualization = stored.value("save_visualization", options.saveVisualization);
+    options.startPageId = stored.value("start_page_id", options.startPageId);
+    options.endPageId = stored.value("end_page_id", options.endPageId);
+    options.returnMd = true;
+    options.returnContentList = true;
+    options.saveOrigin = false;   // the job directory keeps the upload
+    options.useResultCache = false;
+    return options;
+}
 
-    std::string topology = toLower(config_.topology);
-    if (topology.empty()) {
-        topology = "single_pipeline";
-    }
-    if (topology == "single_pipeline" && config_.deviceIds.size() > 1) {
-        topology = "single_process_multi_device";
+json makeJobStatusJson(const JobInfo& info) {
+    json status{
+        {"job_id", info.id},
+        {"filename", info.filename},
+        {"status", info.status},
+        {"completed_pages", info.completedPages},
+        {"total_pages", info.totalPages},
+    };
+    if (!info.error.empty()) {
+        status["error"] = info.error;
     }
-    config_.topology = topology;
+    return status;
+}
+
+std::string multipartFilename(const crow::multipart::part& part) {
+    const auto disposition = part.get_header_object("Content-Disposition");
+    const auto filenameIt = disposition.params.find("filename");
+    return filenameIt != disposition.params.end() ? filenameIt->second : "upload.bin";
+}
+
+// Scheduling class of a request: images are interactive, anything that
+// includes a PDF is batch, unless the client asked for one explicitly.
+RequestPriority resolveRequestPriority(
+    const FileParseOptions& options,
+    const std::vector<std::string>& filenames)
+{
+    const std::string requested = toLower(options.priority);
+    if (requested == "interactive") {
+        return RequestPriority::INTERACTIVE;
+    }
+    if (requested == "batch") {
+        return RequestPriority::BATCH;
+    }
+    for (const auto& filename : filenames) {
+        if (isPdfExtension(toLower(fs::path(filename).extension().string()))) {
+            return RequestPriority::BATCH;
+        }
+    }
+    return RequestPriority::INTERACTIVE;
+}
+
+// Per-page timings exported as /metrics histograms, one series per shard.
+// A page is observed only if the stage ran on it: its time (or, for an NPU
+// wait, which is 0 when admission is uncontended, its hold) is > 0.
+struct PageTimeMetric {
+    const char* family;
+    const char* label;
+    const char* value;
+    double PageStageStats::*field;
+    double PageStageStats::*ranIf = nullptr;   // nullptr: field itself
+};
+
+const PageTimeMetric kPageTimeMetrics[] = {
+    {"rapiddoc_page_stage_seconds", "stage", "layout", &PageStageStats::layoutTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "ocr", &PageStageStats::ocrTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "table", &PageStageStats::tableTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "figure", &PageStageStats::figureTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "formula", &PageStageStats::formulaTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "unsupported", &PageStageStats::unsupportedTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "reading_order", &PageStageStats::readingOrderTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "npu_serial", &PageStageStats::npuSerialTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "cpu_only", &PageStageStats::cpuOnlyTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "npu_stage_cpu", &PageStageStats::npuStageCpuTimeMs},
+    {"rapiddoc_page_stage_seconds", "stage", "postprocess_cpu", &PageStageStats::postprocessCpuTimeMs},
+    {"rapiddoc_page_npu_wait_seconds", "engine", "all", &PageStageStats::npuLockWaitTimeMs,
+     &PageStageStats::npuLockHoldTimeMs},
+    {"rapiddoc_page_npu_wait_seconds", "engine", "layout", &PageStageStats::layoutNpuWaitTimeMs,
+     &PageStageStats::layoutNpuHoldTimeMs},
+    {"rapiddoc_page_npu_wait_seconds", "engine", "ocr", &PageStageStats::ocrNpuWaitTimeMs,
+     &PageStageStats::ocrNpuHoldTimeMs},
+    {"rapiddoc_page_npu_wait_seconds", "engine", "table", &PageStageStats::tableNpuWaitTimeMs,
+     &PageStageStats::tableNpuHoldTimeMs},
+    {"rapiddoc_page_npu_hold_seconds", "engine", "all", &PageStageStats::npuLockHoldTimeMs},
+    {"rapiddoc_page_npu_hold_seconds", "engine", "layout", &PageStageStats::layoutNpuHoldTimeMs},
+    {"rapiddoc_page_npu_hold_seconds", "engine", "ocr", &PageStageStats::ocrNpuHoldTimeMs},
+    {"rapiddoc_page_npu_hold_seconds", "engine", "table", &PageStageStats::tableNpuHoldTimeMs},
+};
+
+struct CacheLookupMetric {
+    const char* memo;
+    const char* result;
+    int PageStageStats::*field;
+};
+
+const CacheLookupMetric kCacheLookupMetrics[] = {
+    {"layout", "hit", &PageStageStats::layoutCacheHits},
+    {"layout", "miss", &PageStageStats::layoutCacheMisses},
+    {"ocr", "hit", &PageStageStats::ocrCacheHits},
+    {"ocr", "miss", &PageStageStats::ocrCacheMisses},
+};
+
+// Per-shard transient buffer pools exported as /metrics gauges.
+struct BufferPoolMetric {
+    const char* pool;
+    BufferPool::Stats DocPipeline::BufferPoolStats::*field;
+};
+
+const BufferPoolMetric kBufferPoolMetrics[] = {
+    {"page_crops", &DocPipeline::BufferPoolStats::pageCrops},
+    {"layout_inputs", &DocPipeline::BufferPoolStats::layoutInputs},
+    {"table_inputs", &DocPipeline::BufferPoolStats::tableInputs},
+    {"table_masks", &DocPipeline::BufferPoolStats::tableMasks},
+};
+
+const char* pageTimeMetricHelp(const std::string& family) {
+    if (family == "rapiddoc_page_npu_wait_seconds") {
+        return "Time a page waited for NPU admission, by engine.";
+    }
+    if (family == "rapiddoc_page_npu_hold_seconds") {
+        return "Time a page held NPU admission, by engine.";
+    }
+    return "Time a page spent in each pipeline stage.";
+}
+
+// Thrown when the admission queue is full; handlers answer 429.
+struct AdmissionRejected : std::runtime_error {
+    explicit AdmissionRejected(int retryAfter)
+        : std::runtime_error("Server busy: request queue is full")
+        , retryAfterSeconds(retryAfter) {}
+    int retryAfterSeconds;
+};
+
+crow::response makeBusyResponse(const AdmissionRejected& e, const json& body) {
+    crow::response resp(429, body.dump());
+    resp.set_header("Content-Type", "application/json");
+    resp.set_header("Retry-After", std::to_string(e.retryAfterSeconds));
+    return resp;
+}
+
+} // namespace
+
+/**
+ * @brief Runs documents on the server's shards through its admission queue.
+ *
+ * Handlers wait on the returned futures instead of on a shard, so a busy
+ * shard never pins an HTTP thread, and the bounded queue caps how many can
+ * be waiting at all.
+ */
+class DocumentDispatch {
+public:
+    struct Document {
+        const std::string* bytes;  // must stay valid until the future is ready
+        std::string filename;
+        std::vector<const std::string*> morePages;  // further images of the same document
+        RecordSink records;                   // set for async job runs
+    };
+
+    /**
+     * @brief Queue every document of one request, or none.
+     * @throws AdmissionRejected when they do not fit in the queue
+     */
+    static std::vector<std::future<RoutedProcessedDocument>> submit(
+        DocServer& server,
+        RequestPriority priority,
+        const std::vector<Document>& documents,
+        const FileParseOptions& options)
+    {
+        std::vector<std::future<RoutedProcessedDocument>> futures;
+        std::vector<RequestScheduler::Job> jobs;
+        std::vector<std::pair<size_t, std::shared_ptr<const CachedParse>>> hits;
+        const auto queuedAt = std::chrono::steady_clock::now();
+        for (const auto& document : documents) {
+            std::string cacheKey;
+            if (server.resultCache_->enabled() && options.useResultCache &&
+                options.backend == "pipeline") {
+                std::string salt = makeCacheSalt(server.modelFingerprint_, document.filename, options);
+                for (const std::string* page : document.morePages) {
+                    salt += "|page:" + ResultCache::makeKey(*page, "");
+                }
+                cacheKey = ResultCache::makeKey(*document.bytes, salt);
+                if (auto cached = server.resultCache_->lookup(cacheKey)) {
+                    hits.emplace_back(futures.size(), std::move(cached));
+                    futures.emplace_back();
+                    continue;
+                }
+            }
+
+            auto promise = std::make_shared<std::promise<RoutedProcessedDocument>>();
+            futures.push_back(promise->get_future());
+            jobs.push_back([&server, promise, bytes = document.bytes,
+                            filename = document.filename, morePages = document.morePages,
+                            records = document.records, options, queuedAt,
+                            cacheKey](size_t worker) {
+                const double queueMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - queuedAt).count();
+                RoutedProcessedDocument routed;
+                try {
+                    routed = runOnShard(
+                        server, worker, queueMs, *bytes, filename, options, morePages, records);
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                    return;
+                }
+                // Taken before the handler can clear the output directory.
+                // Partial results of a stopped run are never cached.
+                std::shared_ptr<const CachedParse> snapshot;
+                if (!cacheKey.empty() && !routed.processed.result.cancelled) {
+                    try {
+                        snapshot = captureCachedParse(routed.processed);
+                    } catch (const std::exception& e) {
+                        LOG_WARN("Result cache: could not capture {}: {}", filename, e.what());
+                    }
+                }
+                promise->set_value(std::move(routed));
+                server.resultCache_->store(cacheKey, std::move(snapshot));
+            });
+        }
+        if (!jobs.empty() && !server.scheduler_->trySubmitAll(priority, std::move(jobs))) {
+            throw AdmissionRejected(server.scheduler_->retryAfterSeconds());
+        }
+
+        // Hits are materialized only once the whole request is admitted.
+        for (auto& hit : hits) {
+            const Document& document = documents[hit.first];
+            std::promise<RoutedProcessedDocument> promise;
+            futures[hit.first] = promise.get_future();
+            try {
+                RoutedProcessedDocument routed;
+                routed.dispatch.topology = server.resolvedTopology();
+                routed.dispatch.shardId = "result_cache";
+                routed.dispatch.backendId = (routed.dispatch.topology == "single_card_backend")
+                    ? server.config_.serverId : std::string();
+                routed.processed = restoreCachedParse(
+                    *hit.second, *document.bytes, document.filename, options);
+                promise.set_value(std::move(routed));
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+        return futures;
+    }
+
+    static RoutedProcessedDocument execute(
+        DocServer& server,
+        const std::string& bytes,
+        const std::string& filename,
+        const FileParseOptions& options)
+    {
+        const RequestPriority priority = resolveRequestPriority(options, {filename});
+        return submit(server, priority, {Document{&bytes, filename, {}, {}}}, options).front().get();
+    }
+
+private:
+    // Lock-free: only atomic adds into series resolved at startup.
+    static void recordMetrics(
+        const DocServer::PipelineShard::Metrics& metrics,
+        const DocumentResult& result,
+        double queueMs,
+        double serviceMs)
+    {
+        for (const PageResult& page : result.pages) {
+            for (size_t i = 0; i < metrics.pageTimes.size(); ++i) {
+                const PageTimeMetric& metric = kPageTimeMetrics[i];
+                if (page.stats.*(metric.ranIf ? metric.ranIf : metric.field) > 0.0) {
+                    metrics.pageTimes[i]->observe(page.stats.*metric.field / 1000.0);
+                }
+            }
+            for (size_t i = 0; i < metrics.cacheLookups.size(); ++i) {
+                const int lookups = page.stats.*kCacheLookupMetrics[i].field;
+                if (lookups > 0) {
+                    metrics.cacheLookups[i]->add(static_cast<uint64_t>(lookups));
+                }
+            }
+        }
+        metrics.queueSeconds->observe(queueMs / 1000.0);
+        metrics.requestSeconds->observe((queueMs + serviceMs) / 1000.0);
+        metrics.requestPages->observe(static_cast<double>(result.processedPages));
+    }
+
+    // Runs on scheduler worker @p shardIndex, which owns that shard.
+    static RoutedProcessedDocument runOnShard(
+        DocServer& server,
+        size_t shardIndex,
+        double queueMs,
+        const std::string& bytes,
+        const std::string& filename,
+        const FileParseOptions& options,
+        const std::vector<const std::string*>& morePages,
+        const RecordSink& records)
+    {
+        auto& shard = *server.shards_.at(shardIndex);
+
+        DispatchMetadata dispatch;
+        dispatch.topology = server.resolvedTopology();
+        dispatch.deviceId = shard.deviceId;
+        dispatch.shardId = shard.shardId;
+        dispatch.backendId = (dispatch.topology == "single_card_backend")
+            ? server.config_.serverId : std::string();
+        dispatch.routeQueueMs = queueMs;
+
+        // Shards that take part in this request, the routed shard first.
+        // Helpers are idle shards whose workers stay reserved until release.
+        std::vector<DocServer::PipelineShard*> participants{&shard};
+        std::vector<size_t> helpers;
+        auto releaseShards = [&server, &participants, &helpers]() {
+            server.scheduler_->release(helpers);
+            for (DocServer::PipelineShard* participant : participants) {
+                participant->inflight.fetch_sub(1, std::memory_order_relaxed);
+            }
+        };
+
+        shard.inflight.fetch_add(1, std::memory_order_relaxed);
+        try {
+            const auto shardAcquired = std::chrono::steady_clock::now();
+            const size_t wantedShards = server.fanoutShardCount(
+                bytes, filename, options.startPageId, options.endPageId, *shard.pipeline);
+            if (wantedShards > 1) {
+                helpers = server.scheduler_->reserveIdle(shardIndex, wantedShards - 1);
+            }
+            for (size_t helperIndex : helpers) {
+                auto& helper = *server.shards_[helperIndex];
+                helper.inflight.fetch_add(1, std::memory_order_relaxed);
+                participants.push_back(&helper);
+                dispatch.shardId += "+" + helper.shardId;
+            }
+
+            std::vector<DocPipeline*> fanout;
+            if (participants.size() > 1) {
+                for (DocServer::PipelineShard* participant : participants) {
+                    fanout.push_back(participant->pipeline.get());
+                }
+            }
+            std::vector<PageStageStats> fanoutStats;
+
+            RoutedProcessedDocument routed;
+            routed.dispatch = dispatch;
+            routed.processed = processDocumentBytes(
+                *shard.pipeline, bytes, filename, options, fanout, &fanoutStats, morePages,
+                records);
+
+            const auto shardDone = std::chrono::steady_clock::now();
+            const auto busyUs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    shardDone - shardAcquired).count());
+            shard.routeQueueUsTotal.fetch_add(
+                msToUs(routed.dispatch.routeQueueMs),
+                std::memory_order_relaxed);
+            for (size_t i = 0; i < participants.size(); ++i) {
+                DocServer::PipelineShard& participant = *participants[i];
+                const double npuMs = (i < fanoutStats.size())
+                    ? fanoutStats[i].npuSerialTimeMs
+                    : routed.processed.result.stats.npuSerialTimeMs;
+                participant.busyUsTotal.fetch_add(busyUs, std::memory_order_relaxed);
+                participant.npuBusyUsTotal.fetch_add(msToUs(npuMs), std::memory_order_relaxed);
+                participant.requestCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            server.recordPipelineLockStats(routed.processed.result);
+            recordMetrics(
+                shard.metrics, routed.processed.result, queueMs,
+                static_cast<double>(busyUs) / 1000.0);
+            releaseShards();
+            return routed;
+        } catch (...) {
+            releaseShards();
+            throw;
+        }
+    }
+};
+
+/**
+ * @brief Runs the jobs of a JobStore one after another through DocumentDispatch.
+ *
+ * A job is admitted as a batch request, so a large PDF spreads over the
+ * idle shards like any other, and every page record it emits is written as
+ * that page's checkpoint. stop() cancels the running job between pages; it
+ * stays queued on disk and resumes after its last checkpoint on the next
+ * start. Finished jobs are swept from the store once they are older than
+ * the retention period.
+ */
+class JobRunner {
+public:
+    JobRunner(DocServer& server, JobStore& store, std::chrono::seconds retention)
+        : server_(server)
+        , store_(store)
+        , retention_(retention)
+    {
+        for (auto& id : store_.unfinished()) {
+            queue_.push_back(std::move(id));
+        }
+        if (!queue_.empty()) {
+            LOG_INFO("Resuming {} unfinished job(s)", queue_.size());
+        }
+        thread_ = std::thread([this]() { loop(); });
+    }
+
+    ~JobRunner() { stop(); }
+
+    JobRunner(const JobRunner&) = delete;
+    JobRunner& operator=(const JobRunner&) = delete;
+
+    void enqueue(const std::string& id) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(id);
+        }
+        wake_.notify_one();
+    }
+
+    /**
+     * @brief Delete job @p id; a running job is cancelled and deleted once its run stops.
+     * @return false if there is no such job
+     */
+    bool remove(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ && id == runningId_) {
+            running_->cancel();
+            removeRunning_ = true;
+            wake_.notify_all();
+            return true;
+        }
+        queue_.erase(std::remove(queue_.begin(), queue_.end(), id), queue_.end());
+        return store_.remove(id);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            if (running_) {
+                running_->cancel();
+            }
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void loop() {
+        constexpr auto kSweepInterval = std::chrono::minutes(1);
+        auto nextSweep = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            auto ready = [this]() { return stopping_ || !queue_.empty(); };
+            if (retention_.count() > 0) {
+                if (std::chrono::steady_clock::now() >= nextSweep) {
+                    lock.unlock();
+                    sweepExpired();
+                    lock.lock();
+                    nextSweep = std::chrono::steady_clock::now() + kSweepInterval;
+                }
+                wake_.wait_until(lock, nextSweep, ready);
+            } else {
+                wake_.wait(lock, ready);
+            }
+            if (stopping_) {
+                return;
+            }
+            if (queue_.empty()) {
+                continue;
+            }
+            const std::string id = std::move(queue_.front());
+            queue_.pop_front();
+            auto cancel = std::make_shared<CancellationToken>();
+            running_ = cancel;
+            runningId_ = id;
+            lock.unlock();
+            run(id, cancel);
+            lock.lock();
+            if (removeRunning_) {
+                store_.remove(id);
+                removeRunning_ = false;
+            }
+            running_.reset();
+            runningId_.clear();
+        }
+    }
+
+    // Runs on the job thread, so a job is never swept while it runs.
+    void sweepExpired() {
+        const int64_t cutoffMs = JobStore::nowMs() -
+            std::chrono::duration_cast<std::chrono::milliseconds>(retention_).count();
+        if (const size_t removed = store_.expireFinished(cutoffMs)) {
+            LOG_INFO("Removed {} finished job(s) past retention", removed);
+        }
+    }
+
+    void run(const std::string& id, const std::shared_ptr<CancellationToken>& cancel) {
+        const auto info = store_.find(id);
+        if (!info || info->finished()) {
+            return;
+        }
+        std::string bytes;
+        if (!store_.readUpload(id, bytes)) {
+            store_.markFailed(id, "Job upload is missing");
+            return;
+        }
+        const int done = info->completedPages;
+        if (info->totalPages > 0 && done >= info->totalPages) {
+            store_.markDone(id);
+            return;
+        }
+
+        FileParseOptions options = jobParseOptions(info->options, store_.outputDir(id));
+        options.startPageId += done;
+        options.cancel = cancel;
+        // Page numbers in the records count from this run's first page.
+        RecordSink records = [this, &id, done](const std::string& event, json record) {
+            if (event != "page") {
+                return;
+            }
+            const int page = done + record.value("page", 0);
+            json checkpoint{
+                {"page", page},
+                {"md_content", record.value("md_content", std::string())},
+                {"content_list", record.value("content_list", json::array())},
+            };
+            if (!store_.checkpointPage(id, page - 1, checkpoint, done + record.value("total_pages", 0))) {
+                LOG_WARN("Job {}: could not checkpoint page {}", id, page);
+            }
+        };
+
+        while (true) {
+            try {
+                auto pending = DocumentDispatch::submit(
+                    server_, RequestPriority::BATCH,
+                    {DocumentDispatch::Document{&bytes, info->filename, {}, records}}, options);
+                const RoutedProcessedDocument routed = pending.front().get();
+                if (!routed.processed.result.cancelled) {
+                    store_.markDone(id);
+                }
+                return;
+            } catch (const AdmissionRejected& e) {
+                // Waits for room in the admission queue like a client's retry would.
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_for(lock, std::chrono::seconds(std::max(1, e.retryAfterSeconds)),
+                                   [this, &cancel]() { return stopping_ || cancel->cancelled(); })) {
+                    return;
+                }
+            } catch (const std::exception& e) {
+                if (cancel->cancelled()) {
+                    return;
+                }
+                LOG_ERROR("Job {} failed: {}", id, e.what());
+                store_.markFailed(id, e.what());
+                return;
+            }
+        }
+    }
+
+    DocServer& server_;
+    JobStore& store_;
+    const std::chrono::seconds retention_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::string> queue_;
+    std::shared_ptr<CancellationToken> running_;
+    std::string runningId_;             // job run() is on
+    bool removeRunning_ = false;        // delete runningId_ once its run returns
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+DocServer::DocServer(const ServerConfig& config)
+    : config_(config)
+{
+    fs::create_directories(config_.uploadDir);
+
+    std::string topology = toLower(config_.topology);
+    if (topology.empty()) {
+        topology = "single_pipeline";
+    }
+    if (topology == "single_pipeline" && config_.deviceIds.size() > 1) {
+        topology = "single_process_multi_device";
+    }
+    config_.topology = topology;
     config_.serverId = makeServerId(config_, topology);
 
     std::vector<int> shardDeviceIds = config_.deviceIds;
@@ -921,22 +2027,122 @@ DocServer::DocServer(const ServerConfig& config)
         std::unique(shardDeviceIds.begin(), shardDeviceIds.end()),
         shardDeviceIds.end());
 
+    // One CPU post-processing pool for all shards, sized for the host.
+    postprocessPool_ = std::make_unique<TaskPool>(
+        resolveTaskPoolThreads(config_.pipelineConfig.runtime.postprocessThreads));
+    imageWriter_ = std::make_unique<ImageWriter>(
+        static_cast<size_t>(std::max(0, config_.pipelineConfig.runtime.imageWriteThreads)),
+        static_cast<size_t>(std::max(0, config_.pipelineConfig.runtime.imageCacheMb)) * 1024 * 1024);
+    // Shards share one memo so a repeat is caught whichever shard got the original.
+    if (config_.pipelineConfig.runtime.recognitionCacheMb > 0) {
+        recognitionCache_ = std::make_unique<RecognitionCache>(
+            static_cast<size_t>(config_.pipelineConfig.runtime.recognitionCacheMb) << 20);
+    }
+
+    const auto startupStart = std::chrono::steady_clock::now();
+    const bool shardsPinned = config_.numaPlacement || !config_.shardCpuLists.empty();
+    if (shardsPinned && config_.pipelineConfig.runtime.layoutOrtGlobalThreadPool) {
+        LOG_WARN("Global ORT thread pool runs on the CPUs of whichever shard initializes first");
+    }
     for (size_t i = 0; i < shardDeviceIds.size(); ++i) {
         auto shard = std::make_unique<PipelineShard>();
         shard->deviceId = shardDeviceIds[i];
         shard->shardId = "shard_" + std::to_string(i);
+        shard->numaNode = deviceNumaNode(shard->deviceId);
+        if (i < config_.shardCpuLists.size()) {
+            shard->cpus = parseCpuList(config_.shardCpuLists[i]);
+        } else if (config_.numaPlacement) {
+            shard->cpus = numaNodeCpus(shard->numaNode);
+        }
+        if (!shard->cpus.empty()) {
+            LOG_INFO("{} (device {}, NUMA node {}) pinned to CPUs {}",
+                     shard->shardId, shard->deviceId, shard->numaNode, formatCpuList(shard->cpus));
+        } else if (config_.numaPlacement) {
+            LOG_WARN("{}: NUMA node of device {} unknown; threads stay unpinned",
+                     shard->shardId, shard->deviceId);
+        }
 
         PipelineConfig shardConfig = config_.pipelineConfig;
         shardConfig.runtime.deviceId = shard->deviceId;
-        shard->pipeline = std::make_unique<DocPipeline>(shardConfig);
-        shard->pipeline->externalNpuSerialMutex_ = &shard->npuSerialMutex;
-        if (!shard->pipeline->initialize()) {
-            throw std::runtime_error(
-                "Failed to initialize document pipeline for " + shard->shardId);
+        shardConfig.runtime.cpuAffinity = formatCpuList(shard->cpus);
+        if (shardDeviceIds.size() > 1 && !shardsPinned) {
+            // Shards share one process-wide ORT pool instead of one pool each.
+            // Pinned shards keep their own: ORT starts a session's pool on the
+            // thread that creates it, so each lands on its shard's (pinned)
+            // init thread, while a shared pool would sit wherever the first
+            // shard to initialize is pinned.
+            shardConfig.runtime.layoutOrtGlobalThreadPool = true;
         }
+        shard->pipeline = std::make_unique<DocPipeline>(shardConfig);
+        shard->npuScheduler = std::make_unique<NpuScheduler>(
+            makeNpuSchedulerConfig(shardConfig.runtime));
+        shard->pipeline->externalNpuScheduler_ = shard->npuScheduler.get();
+        shard->pipeline->externalPostprocessPool_ = postprocessPool_.get();
+        shard->pipeline->externalImageWriter_ = imageWriter_.get();
+        shard->pipeline->externalRecognitionCache_ = recognitionCache_.get();
         shards_.push_back(std::move(shard));
     }
 
+    // Shards load (and warm up) concurrently, so a multi-card cold start
+    // costs about as much as one shard. The server only starts listening
+    // afterwards, so /health never reports a cold shard.
+    std::vector<std::future<bool>> shardInits;
+    const bool parallelInit = config_.pipelineConfig.runtime.parallelModelInit;
+    for (const auto& shard : shards_) {
+        DocPipeline* pipeline = shard->pipeline.get();
+        shardInits.push_back(std::async(
+            parallelInit ? std::launch::async : std::launch::deferred,
+            [pipeline, cpus = shard->cpus]() {
+                if (cpus.empty()) {
+                    return pipeline->initialize();
+                }
+                // Runtime and ORT threads started by initialize() inherit the
+                // pinned thread's affinity; the caller's own is left alone.
+                return std::async(std::launch::async, [pipeline, &cpus]() {
+                    pinCurrentThread(cpus);
+                    return pipeline->initialize();
+                }).get();
+            }));
+    }
+    std::string failedShard;
+    for (size_t i = 0; i < shardInits.size(); ++i) {
+        bool ok = false;
+        try {
+            ok = shardInits[i].get();
+        } catch (const std::exception& e) {
+            LOG_ERROR("{} initialization threw: {}", shards_[i]->shardId, e.what());
+        }
+        if (!ok && failedShard.empty()) {
+            failedShard = shards_[i]->shardId;
+        }
+    }
+    if (!failedShard.empty()) {
+        throw std::runtime_error("Failed to initialize document pipeline for " + failedShard);
+    }
+    startupMs_ = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startupStart).count();
+    LOG_INFO("{} shard(s) ready in {:.1f} ms", shards_.size(), startupMs_);
+    // Worker i runs shard i's requests, and the pipeline threads it starts inherit its CPUs.
+    scheduler_ = std::make_unique<RequestScheduler>(
+        shards_.size(), config_.maxQueuedRequests, config_.interactiveBurst,
+        [this](size_t worker) { pinCurrentThread(shards_[worker]->cpus); });
+    registerMetrics();
+    modelFingerprint_ = makeModelFingerprint(config_.pipelineConfig);
+    resultCache_ = std::make_unique<ResultCache>(
+        config_.resultCacheMemoryBytes,
+        (fs::path(config_.uploadDir) / "result_cache").string(),
+        config_.resultCacheDiskBytes);
+    if (!config_.shmDir.empty()) {
+        shmSecret_ = shm_transport::loadOrCreateSecret(config_.shmDir);
+        if (shmSecret_.empty()) {
+            LOG_WARN("No shm secret in {}; bodies are only accepted over HTTP", config_.shmDir);
+        }
+        sweepShmDir();
+    }
+    jobStore_ = std::make_unique<JobStore>((fs::path(config_.uploadDir) / "jobs").string());
+    jobRunner_ = std::make_unique<JobRunner>(
+        *this, *jobStore_, std::chrono::seconds(config_.jobRetentionSeconds));
+
     std::vector<int> telemetryDeviceIds;
     for (const auto& shard : shards_) {
         if (shard->deviceId >= 0) {
@@ -944,7 +2150,80 @@ DocServer::DocServer(const ServerConfig& config)
         }
     }
     if (!telemetryDeviceIds.empty()) {
-        deviceMetricsSampler_ = std::make_unique<DeviceMetricsSampler>(telemetryDeviceIds);
+        // Hot or memory-starved devices stop taking documents; throttled ones
+        // only take what the others leave queued.
+        deviceMetricsSampler_ = std::make_unique<DeviceMetricsSampler>(
+            telemetryDeviceIds, config_.deviceLimits,
+            [this](int deviceId) {
+                std::chrono::steady_clock::duration busy{0};
+                for (const auto& shard : shards_) {
+                    if (shard->deviceId == deviceId) {
+                        busy += shard->npuScheduler->busyTime();
+                    }
+                }
+                return busy;
+            },
+            [this](const DeviceMetricSample& sample) {
+                const WorkerState state = admissionState(sample.health);
+                for (size_t i = 0; i < shards_.size(); ++i) {
+                    if (shards_[i]->deviceId != sample.telemetry.deviceId ||
+                        scheduler_->workerState(i) == state) {
+                        continue;
+                    }
+                    if (state == WorkerState::ACTIVE) {
+                        LOG_INFO("Device {} healthy again; shard {} takes documents",
+                                 sample.telemetry.deviceId, shards_[i]->shardId);
+                    } else {
+                        LOG_WARN("Device {} {} ({} C); shard {} {}",
+                                 sample.telemetry.deviceId, deviceHealthName(sample.health),
+                                 sample.telemetry.temperatureC.value_or(-1), shards_[i]->shardId,
+                                 state == WorkerState::PAUSED ? "paused" : "takes overflow only");
+                    }
+                    scheduler_->setWorkerState(i, state);
+                }
+            });
+        registerDeviceMetrics(telemetryDeviceIds);
+    }
+
+    if (config_.autotune.enabled) {
+        const RuntimeConfig& runtime = config_.pipelineConfig.runtime;
+        TunerKnobs initial;
+        initial.inflight = static_cast<int>(shards_.size());
+        initial.ocrLanes = std::max(1, runtime.npuOcrConcurrency);
+        initial.batchDelayMs = runtime.layoutBatchSize > 1 ? std::max(0, runtime.layoutBatchMaxDelayMs) : -1;
+        autotuner_ = std::make_unique<ConcurrencyAutotuner>(
+            config_.autotune, shards_.size(), initial,
+            [this]() {
+                AutotuneCounters counters;
+                for (const auto& shard : shards_) {
+                    const auto requests = shard->metrics.requestSeconds->bucketCounts();
+                    const auto queue = shard->metrics.queueSeconds->bucketCounts();
+                    counters.requestBuckets.resize(requests.size());
+                    counters.queueBuckets.resize(queue.size());
+                    for (size_t i = 0; i < requests.size(); ++i) {
+                        counters.requestBuckets[i] += requests[i];
+                        counters.queueBuckets[i] += queue[i];
+                    }
+                    counters.npuBusyUs += shard->npuBusyUsTotal.load(std::memory_order_relaxed);
+                }
+                const RequestScheduler::Stats admission = scheduler_->stats();
+                counters.queued = admission.queued[0] + admission.queued[1];
+                return counters;
+            },
+            [this](const TunerKnobs& knobs) {
+                scheduler_->setRunningLimit(static_cast<size_t>(knobs.inflight));
+                for (const auto& shard : shards_) {
+                    shard->npuScheduler->setLimit(NpuEngine::OCR, knobs.ocrLanes);
+                    if (knobs.batchDelayMs >= 0) {
+                        shard->pipeline->setLayoutBatchMaxDelayMs(knobs.batchDelayMs);
+                    }
+                }
+            });
+        LOG_INFO("Autotune every {} ms: running documents 1-{}, OCR lanes {}-{}, layout batch window {}-{} ms",
+                 config_.autotune.intervalMs,
+                 config_.autotune.maxInflight > 0 ? config_.autotune.maxInflight : static_cast<int>(shards_.size()),
+                 config_.autotune.minOcrLanes, config_.autotune.maxOcrLanes,
+                 config_.autotune.minBatchDelayMs, config_.autotune.maxBatchDelayMs);
     }
 }
 
@@ -952,26 +2231,134 @@ DocServer::~DocServer() {
     stop();
 }
 
-size_t DocServer::selectShardIndex() {
-    if (shards_.empty()) {
-        throw std::runtime_error("No pipeline shards configured");
+void DocServer::registerMetrics() {
+    metrics_ = std::make_unique<MetricsRegistry>();
+    for (const auto& shard : shards_) {
+        const MetricLabels labels{
+            {"shard", shard->shardId},
+            {"device", std::to_string(shard->deviceId)},
+        };
+        auto& metrics = shard->metrics;
+        for (const auto& metric : kPageTimeMetrics) {
+            MetricLabels series = labels;
+            series.emplace_back(metric.label, metric.value);
+            metrics.pageTimes.push_back(&metrics_->histogram(
+                metric.family, pageTimeMetricHelp(metric.family), series));
+        }
+        for (const auto& metric : kCacheLookupMetrics) {
+            MetricLabels series = labels;
+            series.emplace_back("memo", metric.memo);
+            series.emplace_back("result", metric.result);
+            metrics.cacheLookups.push_back(&metrics_->counter(
+                "rapiddoc_recognition_cache_lookups_total",
+                "Recognition cache lookups per memo and outcome.", series));
+        }
+        metrics.requestSeconds = &metrics_->histogram(
+            "rapiddoc_request_seconds",
+            "Document time from admission to result, queue wait included.", labels);
+        metrics.queueSeconds = &metrics_->histogram(
+            "rapiddoc_request_queue_seconds",
+            "Time a document waited in the admission queue for its shard.", labels);
+        metrics.requestPages = &metrics_->histogram(
+            "rapiddoc_request_pages", "Pages processed per document.", labels,
+            exponentialBuckets(1.0, 2.0, 12));
+
+        PipelineShard* raw = shard.get();
+        metrics_->gauge(
+            "rapiddoc_shard_inflight", "Documents running on the shard.", labels,
+            [raw]() { return static_cast<double>(raw->inflight.load(std::memory_order_relaxed)); });
+        for (const auto& metric : kBufferPoolMetrics) {
+            const auto field = metric.field;
+            const auto poolGauge = [&](const char* name, const char* help, const char* key,
+                                       const char* value, auto read) {
+                MetricLabels series = labels;
+                series.emplace_back("pool", metric.pool);
+                series.emplace_back(key, value);
+                metrics_->gauge(name, help, series, [raw, field, read]() {
+                    return static_cast<double>(read(raw->pipeline->bufferPoolStats().*field));
+                });
+            };
+            const char* acquires = "Buffer pool acquires served from a recycled buffer or allocated.";
+            const char* bytes = "Buffer pool capacity referenced by live Mats, its high-water mark, and idle.";
+            poolGauge("rapiddoc_buffer_pool_acquires", acquires, "result", "hit",
+                      [](const BufferPool::Stats& s) { return s.hits; });
+            poolGauge("rapiddoc_buffer_pool_acquires", acquires, "result", "miss",
+                      [](const BufferPool::Stats& s) { return s.misses; });
+            poolGauge("rapiddoc_buffer_pool_bytes", bytes, "state", "in_use",
+                      [](const BufferPool::Stats& s) { return s.inUseBytes; });
+            poolGauge("rapiddoc_buffer_pool_bytes", bytes, "state", "high_water",
+                      [](const BufferPool::Stats& s) { return s.inUseHighWaterBytes; });
+            poolGauge("rapiddoc_buffer_pool_bytes", bytes, "state", "retained",
+                      [](const BufferPool::Stats& s) { return s.retainedBytes; });
+        }
     }
 
-    const size_t shardCount = shards_.size();
-    const size_t start = static_cast<size_t>(
-        routingCursor_.fetch_add(1, std::memory_order_relaxed) % shardCount);
+    for (size_t i = 0; i < kRequestPriorityCount; ++i) {
+        metrics_->gauge(
+            "rapiddoc_queued_requests", "Documents waiting for admission to a shard.",
+            {{"priority", i == static_cast<size_t>(RequestPriority::INTERACTIVE) ? "interactive" : "batch"}},
+            [this, i]() { return static_cast<double>(scheduler_->stats().queued[i]); });
+    }
+}
 
-    size_t bestIndex = start;
-    uint64_t bestInflight = shards_[start]->inflight.load(std::memory_order_relaxed);
-    for (size_t offset = 1; offset < shardCount; ++offset) {
-        const size_t idx = (start + offset) % shardCount;
-        const uint64_t inflight = shards_[idx]->inflight.load(std::memory_order_relaxed);
-        if (inflight < bestInflight) {
-            bestInflight = inflight;
-            bestIndex = idx;
+void DocServer::registerDeviceMetrics(const std::vector<int>& deviceIds) {
+    DeviceMetricsSampler* sampler = deviceMetricsSampler_.get();
+    for (int deviceId : deviceIds) {
+        const MetricLabels labels{{"device", std::to_string(deviceId)}};
+        // Readings the device does not report (and devices not sampled yet) read 0.
+        const auto deviceGauge = [&](const char* name, const char* help, auto read) {
+            metrics_->gauge(name, help, labels, [sampler, deviceId, read]() {
+                const auto sample = sampler->find(deviceId);
+                return sample ? read(*sample) : 0.0;
+            });
+        };
+        deviceGauge("rapiddoc_device_temperature_celsius", "Hottest NPU core temperature.",
+                    [](const DeviceMetricSample& s) { return s.telemetry.temperatureC.value_or(0) * 1.0; });
+        deviceGauge("rapiddoc_device_npu_clock_mhz", "Slowest NPU core clock.",
+                    [](const DeviceMetricSample& s) { return s.telemetry.npuClockMhz.value_or(0) * 1.0; });
+        deviceGauge("rapiddoc_device_npu_utilization",
+                    "Share of the last sample window the device's shards held the NPU.",
+                    [](const DeviceMetricSample& s) { return s.telemetry.npuUtilization; });
+        deviceGauge("rapiddoc_device_memory_total_bytes", "Device memory capacity.",
+                    [](const DeviceMetricSample& s) {
+                        return static_cast<double>(s.telemetry.memoryTotalBytes);
+                    });
+        deviceGauge("rapiddoc_device_memory_used_bytes", "Device memory in use, when the runtime reports it.",
+                    [](const DeviceMetricSample& s) {
+                        return static_cast<double>(s.telemetry.memoryLastUsedBytes.value_or(0));
+                    });
+        for (DeviceHealth health : {DeviceHealth::OK, DeviceHealth::THROTTLED,
+                                    DeviceHealth::OVERHEATED, DeviceHealth::MEMORY_PRESSURE}) {
+            MetricLabels series = labels;
+            series.emplace_back("state", deviceHealthName(health));
+            metrics_->gauge("rapiddoc_device_health", "1 for the device's current health state.", series,
+                            [sampler, deviceId, health]() {
+                                const auto sample = sampler->find(deviceId);
+                                return sample && sample->health == health ? 1.0 : 0.0;
+                            });
         }
     }
-    return bestIndex;
+}
+
+size_t DocServer::fanoutShardCount(
+    const std::string& bytes,
+    const std::string& filename,
+    int startPageId,
+    int endPageId,
+    const DocPipeline& pipeline) const
+{
+    if (shards_.size() < 2 || config_.fanoutPagesPerShard <= 0 ||
+        !isPdfExtension(toLower(fs::path(filename).extension().string()))) {
+        return 1;
+    }
+
+    PipelineRunOverrides range;
+    range.startPageId = startPageId;
+    range.endPageId = endPageId;
+    const int planned = pipeline.plannedPageCount(
+        reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), range);
+    const size_t byPages = static_cast<size_t>(planned / config_.fanoutPagesPerShard);
+    return std::max<size_t>(1, std::min(shards_.size(), byPages));
 }
 
 std::string DocServer::resolvedTopology() const {
@@ -981,6 +2368,23 @@ std::string DocServer::resolvedTopology() const {
     return (shards_.size() > 1) ? "single_process_multi_device" : "single_pipeline";
 }
 
+void DocServer::sweepShmDir() {
+    // The LB takes a response file as soon as the response arrives, so one
+    // this old belongs to an LB that timed out or went away.
+    constexpr auto kStaleAfter = std::chrono::minutes(10);
+    constexpr int64_t kSweepIntervalMs = 60 * 1000;
+    const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t sweptAtMs = shmSweptAtMs_.load();
+    if ((sweptAtMs != 0 && nowMs - sweptAtMs < kSweepIntervalMs) ||
+        !shmSweptAtMs_.compare_exchange_strong(sweptAtMs, nowMs)) {
+        return;
+    }
+    if (const size_t removed = shm_transport::sweepStale(config_.shmDir, kStaleAfter)) {
+        LOG_INFO("Removed {} stale file(s) from {}", removed, config_.shmDir);
+    }
+}
+
 void DocServer::run() {
     LOG_INFO("Starting RapidDoc HTTP server on {}:{}", config_.host, config_.port);
 
@@ -988,58 +2392,34 @@ void DocServer::run() {
     if (deviceMetricsSampler_) {
         deviceMetricsSampler_->start();
     }
+    if (autotuner_) {
+        autotuner_->start();
+    }
 
     auto executeDocument = [this](
         const std::string& bytes,
         const std::string& filename,
         const FileParseOptions& options) -> RoutedProcessedDocument
     {
-        const size_t shardIndex = selectShardIndex();
-        auto& shard = *shards_.at(shardIndex);
-
-        DispatchMetadata dispatch;
-        dispatch.topology = resolvedTopology();
-        dispatch.deviceId = shard.deviceId;
-        dispatch.shardId = shard.shardId;
-        dispatch.backendId =
-            (dispatch.topology == "single_card_backend") ? config_.serverId : std::string();
-
-        shard.inflight.fetch_add(1, std::memory_order_relaxed);
-        try {
-            const auto queueStart = std::chrono::steady_clock::now();
-            std::unique_lock<std::mutex> shardLock(shard.requestMutex);
-            const auto shardAcquired = std::chrono::steady_clock::now();
-            dispatch.routeQueueMs =
-                std::chrono::duration<double, std::milli>(shardAcquired - queueStart).count();
-
-            RoutedProcessedDocument routed;
-            routed.dispatch = dispatch;
-            routed.processed = processDocumentBytes(*shard.pipeline, bytes, filename, options);
-
-            const auto shardDone = std::chrono::steady_clock::now();
-            shard.routeQueueUsTotal.fetch_add(
-                msToUs(routed.dispatch.routeQueueMs),
-                std::memory_order_relaxed);
-            shard.busyUsTotal.fetch_add(
-                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
-                    shardDone - shardAcquired).count()),
-                std::memory_order_relaxed);
-            shard.npuBusyUsTotal.fetch_add(
-                msToUs(routed.processed.result.stats.npuSerialTimeMs),
-                std::memory_order_relaxed);
-            shard.requestCount.fetch_add(1, std::memory_order_relaxed);
-            recordPipelineLockStats(routed.processed.result);
-            shard.inflight.fetch_sub(1, std::memory_order_relaxed);
-            return routed;
-        } catch (...) {
-            shard.inflight.fetch_sub(1, std::memory_order_relaxed);
-            throw;
-        }
+        return DocumentDispatch::execute(*this, bytes, filename, options);
     };
 
     CROW_ROUTE(app, "/health")
     ([this]() {
-        crow::response resp(200, buildHealthJson().dump());
+        json health = buildHealthJson();
+        health["ready"] = true;
+        // Whether warmup actually ran on every shard, not just whether it was asked for.
+        bool warmedUp = !shards_.empty();
+        json shardWarmup = json::object();
+        for (const auto& shard : shards_) {
+            const bool shardWarm = shard->pipeline && shard->pipeline->warmedUp();
+            shardWarmup[shard->shardId] = shardWarm;
+            warmedUp = warmedUp && shardWarm;
+        }
+        health["warmed_up"] = warmedUp;
+        health["shard_warmed_up"] = shardWarmup;
+        health["startup_ms"] = startupMs_;
+        crow::response resp(200, health.dump());
         resp.set_header("Content-Type", "application/json");
         return resp;
     });
@@ -1051,6 +2431,13 @@ void DocServer::run() {
         return resp;
     });
 
+    CROW_ROUTE(app, "/metrics")
+    ([this]() {
+        crow::response resp(200, metrics_->renderPrometheus());
+        resp.set_header("Content-Type", "text/plain; version=0.0.4");
+        return resp;
+    });
+
     CROW_ROUTE(app, "/process").methods("POST"_method)
     ([this, &executeDocument](const crow::request& req) {
         requestCount_++;
@@ -1072,7 +2459,7 @@ void DocServer::run() {
                 return crow::response(400, R"({"error":"No file field found"})");
             }
 
-            const auto& filePart = parts.front();
+            const auto& filePart = *parts.front();
             std::string filename = "upload.pdf";
             const auto disposition = filePart.get_header_object("Content-Disposition");
             const auto filenameIt = disposition.params.find("filename");
@@ -1086,8 +2473,8 @@ void DocServer::run() {
             options.returnContentList = true;
             options.clearOutputFile = true;
 
-            const RoutedProcessedDocument routed = executeDocument(filePart.body, filename, options);
-            const auto& processed = routed.processed;
+            RoutedProcessedDocument routed = executeDocument(filePart.body, filename, options);
+            auto& processed = routed.processed;
             json legacyResponse{
                 {"pages", processed.result.processedPages},
                 {"total_pages", processed.result.totalPages},
@@ -1102,8 +2489,8 @@ void DocServer::run() {
                     processed.pipelineCallTimeMs,
                     routed.dispatch.routeQueueMs,
                     routed.dispatch.lbProxyMs)},
-                {"markdown", processed.result.markdown},
-                {"content_list", processed.contentList},
+                {"markdown", processed.markdown},
+                {"content_list", std::move(processed.contentList)},
                 {"output_dir", processed.parseDir.string()},
             };
             fs::remove_all(processed.requestDir);
@@ -1113,6 +2500,11 @@ void DocServer::run() {
             resp.set_header("Content-Type", "application/json");
             return resp;
         }
+        catch (const AdmissionRejected& e) {
+            errorCount_++;
+            return makeBusyResponse(
+                e, json{{"error", e.what()}, {"retry_after_s", e.retryAfterSeconds}});
+        }
         catch (const std::exception& e) {
             errorCount_++;
             LOG_ERROR("Processing error: {}", e.what());
@@ -1131,7 +2523,8 @@ void DocServer::run() {
                 return crow::response(400, R"({"error":"Missing 'data' field"})");
             }
 
-            const auto decoded = base64Decode(requestBody["data"].get<std::string>());
+            const std::string decoded =
+                base64Decode(requestBody["data"].get_ref<const std::string&>());
             if (decoded.empty()) {
                 errorCount_++;
                 return crow::response(400, R"({"error":"Invalid base64 data"})");
@@ -1144,11 +2537,8 @@ void DocServer::run() {
             options.returnContentList = true;
             options.clearOutputFile = true;
 
-            const RoutedProcessedDocument routed = executeDocument(
-                std::string(reinterpret_cast<const char*>(decoded.data()), decoded.size()),
-                filename,
-                options);
-            const auto& processed = routed.processed;
+            RoutedProcessedDocument routed = executeDocument(decoded, filename, options);
+            auto& processed = routed.processed;
             json legacyResponse{
                 {"pages", processed.result.processedPages},
                 {"total_pages", processed.result.totalPages},
@@ -1163,8 +2553,8 @@ void DocServer::run() {
                     processed.pipelineCallTimeMs,
                     routed.dispatch.routeQueueMs,
                     routed.dispatch.lbProxyMs)},
-                {"markdown", processed.result.markdown},
-                {"content_list", processed.contentList},
+                {"markdown", processed.markdown},
+                {"content_list", std::move(processed.contentList)},
                 {"output_dir", processed.parseDir.string()},
             };
             fs::remove_all(processed.requestDir);
@@ -1174,6 +2564,11 @@ void DocServer::run() {
             resp.set_header("Content-Type", "application/json");
             return resp;
         }
+        catch (const AdmissionRejected& e) {
+            errorCount_++;
+            return makeBusyResponse(
+                e, json{{"error", e.what()}, {"retry_after_s", e.retryAfterSeconds}});
+        }
         catch (const std::exception& e) {
             errorCount_++;
             LOG_ERROR("Base64 processing error: {}", e.what());
@@ -1182,7 +2577,181 @@ void DocServer::run() {
     });
 
     CROW_ROUTE(app, "/file_parse").methods("POST"_method)
-    ([this, &executeDocument](const crow::request& req) {
+    ([this](const crow::request& req, crow::response& res) {
+        // The response handle is taken so a body handed over in a file can be
+        // answered the same way.
+        const auto receivedAt = std::chrono::steady_clock::now();
+        // A same-host LB may hand the body over in a file (see shm_transport.h).
+        const std::string shmBodyPath = req.get_header_value(lb_headers::kShmBody);
+        const bool shmTrusted = shm_transport::secretMatches(
+            shmSecret_, req.get_header_value(lb_headers::kShmSecret));
+        const bool viaShm = !shmBodyPath.empty() && shmTrusted &&
+            shm_transport::isBodyPath(config_.shmDir, shmBodyPath);
+        res = [&]() -> crow::response {
+            requestCount_++;
+
+            try {
+                const auto contentType = req.get_header_value("Content-Type");
+                if (contentType.find("multipart/form-data") == std::string::npos) {
+                    errorCount_++;
+                    return crow::response(400, R"({"error":"Expected multipart/form-data"})");
+                }
+                if (!shmBodyPath.empty() && !shmTrusted) {
+                    errorCount_++;
+                    return crow::response(403, R"({"error":"Body file handed over without the shm secret"})");
+                }
+                if (!shmBodyPath.empty() && !viaShm) {
+                    errorCount_++;
+                    return crow::response(400, R"({"error":"Body file is outside --shm-dir"})");
+                }
+                std::optional<crow::request> shmRequest;
+                if (viaShm) {
+                    shmRequest.emplace(req);
+                    if (!shm_transport::takeBody(shmBodyPath, shmRequest->body)) {
+                        errorCount_++;
+                        return crow::response(400, R"({"error":"Body file could not be read"})");
+                    }
+                }
+
+                crow::multipart::message msg(shmRequest ? *shmRequest : req);
+                auto fileParts = getMultipartParts(msg, "files");
+                if (fileParts.empty()) {
+                    fileParts = getMultipartParts(msg, "file");
+                }
+                if (fileParts.empty()) {
+                    errorCount_++;
+                    return crow::response(400, R"({"error":"No files provided"})");
+                }
+
+                if (!getMultipartField(msg, "records").empty()) {
+                    // Crow sends a whole response body at once, so per-page
+                    // delivery goes through the job API instead.
+                    errorCount_++;
+                    return crow::response(
+                        400, R"({"error":"records is not supported; submit to POST /jobs and read pages from GET /jobs/{id}/result?from_page=n"})");
+                }
+                FileParseOptions options = parseFileParseOptions(msg, config_);
+                const std::string responseFormat = getMultipartField(msg, "response_format", "json");
+                if (!parseResultFormat(responseFormat, options.responseFormat)) {
+                    errorCount_++;
+                    return crow::response(400, R"({"error":"response_format must be json or cbor"})");
+                }
+                options.deadline = requestDeadline(req, config_, receivedAt);
+                const LbForwarding lb = readLbForwarding(req);
+                json results = json::array();
+                int successFiles = 0;
+                const auto requestWarnings = collectRequestWarnings(options);
+
+                std::vector<DocumentDispatch::Document> documents;
+                std::vector<std::string> filenames;
+                // With merge_images, every image joins the first image's document
+                // as its next page; PDFs remain documents of their own.
+                int mergedDocument = -1;
+                std::vector<std::string> mergedFiles;
+                for (const auto* partPtr : fileParts) {
+                    const auto& part = *partPtr;
+                    std::string filename = "upload.bin";
+                    const auto disposition = part.get_header_object("Content-Disposition");
+                    const auto filenameIt = disposition.params.find("filename");
+                    if (filenameIt != disposition.params.end()) {
+                        filename = filenameIt->second;
+                    }
+                    const bool mergeable = options.mergeImages &&
+                        isImageExtension(toLower(fs::path(safeFilename(filename)).extension().string()));
+                    if (mergeable && mergedDocument >= 0) {
+                        documents[mergedDocument].morePages.push_back(&part.body);
+                        mergedFiles.push_back(safeFilename(filename));
+                        continue;
+                    }
+                    if (mergeable) {
+                        mergedDocument = static_cast<int>(documents.size());
+                        mergedFiles.push_back(safeFilename(filename));
+                    }
+                    documents.push_back(DocumentDispatch::Document{
+                        &part.body, filename, {}, {}});
+                    filenames.push_back(std::move(filename));
+                }
+
+                // All files are admitted together and spread over the shards;
+                // every future is waited on before the parts go out of scope.
+                auto pending = DocumentDispatch::submit(
+                    *this, resolveRequestPriority(options, filenames), documents, options);
+                for (size_t i = 0; i < pending.size(); ++i) {
+                    try {
+                        RoutedProcessedDocument routed = pending[i].get();
+                        applyLbForwarding(lb, routed.dispatch);
+                        json fileResult = buildFileResult(routed.processed, options, routed.dispatch);
+                        if (static_cast<int>(i) == mergedDocument && mergedFiles.size() > 1) {
+                            fileResult["merged_files"] = mergedFiles;
+                        }
+                        if (!requestWarnings.empty()) {
+                            fileResult["request_warnings"] = requestWarnings;
+                        }
+                        results.push_back(std::move(fileResult));
+                        successFiles++;
+
+                        if (options.clearOutputFile) {
+                            fs::remove_all(routed.processed.requestDir);
+                        }
+                    }
+                    catch (const std::exception& e) {
+                        results.push_back(json{
+                            {"filename", safeFilename(filenames[i])},
+                            {"error", e.what()},
+                        });
+                    }
+                }
+
+                json responseData{
+                    {"total_files", static_cast<int>(fileParts.size())},
+                    {"successful_files", successFiles},
+                    {"mode", "closed_environment"},
+                    {"deepx", true},
+                    {"engines_used", makeEngineJson(options.tableEnable, options.formulaEnable)},
+                };
+                if (!requestWarnings.empty()) {
+                    responseData["warnings"] = requestWarnings;
+                }
+                if (lb.present()) {
+                    responseData["topology"] = "front_lb";
+                    responseData["backend_id"] = lb.backendId;
+                    responseData["lb_server_id"] = lb.serverId;
+                }
+
+                successCount_++;
+                crow::response resp(200);
+                responseData["results"] = std::move(results);
+                resp.body = encodeResult(responseData, options.responseFormat);
+                resp.set_header("Content-Type", resultFormatMimeType(options.responseFormat));
+                if (lb.present()) {
+                    resp.set_header(lb_headers::kLbMetadataApplied, "1");
+                }
+                return resp;
+            }
+            catch (const AdmissionRejected& e) {
+                errorCount_++;
+                return makeBusyResponse(
+                    e, json{{"error", e.what()}, {"retry_after_s", e.retryAfterSeconds}});
+            }
+            catch (const std::exception& e) {
+                errorCount_++;
+                LOG_ERROR("file_parse error: {}", e.what());
+                return crow::response(500, json{{"error", e.what()}}.dump());
+            }
+        }();
+        if (viaShm) {
+            const std::string responsePath = shmBodyPath + shm_transport::kResponseSuffix;
+            if (shm_transport::writeBody(responsePath, res.body)) {
+                res.set_header(lb_headers::kShmBody, responsePath);
+                res.body.clear();
+            }
+            sweepShmDir();
+        }
+        res.end();
+    });
+
+    CROW_ROUTE(app, "/jobs").methods("POST"_method)
+    ([this](const crow::request& req) {
         requestCount_++;
 
         try {
@@ -1197,69 +2766,92 @@ void DocServer::run() {
             if (fileParts.empty()) {
                 fileParts = getMultipartParts(msg, "file");
             }
-            if (fileParts.empty()) {
+            if (fileParts.size() != 1) {
                 errorCount_++;
-                return crow::response(400, R"({"error":"No files provided"})");
-            }
-
-            FileParseOptions options = parseFileParseOptions(msg);
-            json results = json::array();
-            int successFiles = 0;
-            const auto requestWarnings = collectRequestWarnings(options);
-
-            for (const auto& part : fileParts) {
-                std::string filename = "upload.bin";
-                const auto disposition = part.get_header_object("Content-Disposition");
-                const auto filenameIt = disposition.params.find("filename");
-                if (filenameIt != disposition.params.end()) {
-                    filename = filenameIt->second;
-                }
-
-                try {
-                    RoutedProcessedDocument routed = executeDocument(part.body, filename, options);
-                    json fileResult = buildFileResult(routed.processed, options, routed.dispatch);
-                    if (!requestWarnings.empty()) {
-                        fileResult["request_warnings"] = requestWarnings;
-                    }
-                    results.push_back(std::move(fileResult));
-                    successFiles++;
-
-                    if (options.clearOutputFile) {
-                        fs::remove_all(routed.processed.requestDir);
-                    }
-                }
-                catch (const std::exception& e) {
-                    results.push_back(json{
-                        {"filename", safeFilename(filename)},
-                        {"error", e.what()},
-                    });
-                }
+                return crow::response(400, R"({"error":"A job takes exactly one file"})");
             }
-
-            json responseData{
-                {"results", std::move(results)},
-                {"total_files", static_cast<int>(fileParts.size())},
-                {"successful_files", successFiles},
-                {"mode", "closed_environment"},
-                {"deepx", true},
-                {"engines_used", makeEngineJson(options.tableEnable, options.formulaEnable)},
-            };
-            if (!requestWarnings.empty()) {
-                responseData["warnings"] = requestWarnings;
+            const FileParseOptions options = parseFileParseOptions(msg, config_);
+            const std::string id = jobStore_->create(
+                safeFilename(multipartFilename(*fileParts.front())),
+                fileParts.front()->body,
+                jobOptionsToJson(options));
+            if (id.empty()) {
+                errorCount_++;
+                return crow::response(500, R"({"error":"Could not store the job"})");
             }
+            jobRunner_->enqueue(id);
 
             successCount_++;
-            crow::response resp(200, responseData.dump());
+            crow::response resp(202, json{{"job_id", id}, {"status", "queued"}}.dump());
             resp.set_header("Content-Type", "application/json");
+            resp.set_header("Location", "/jobs/" + id);
             return resp;
         }
         catch (const std::exception& e) {
             errorCount_++;
-            LOG_ERROR("file_parse error: {}", e.what());
+            LOG_ERROR("jobs error: {}", e.what());
             return crow::response(500, json{{"error", e.what()}}.dump());
         }
     });
 
+    CROW_ROUTE(app, "/jobs/<string>")
+    ([this](const std::string& id) {
+        const auto info = jobStore_->find(id);
+        if (!info) {
+            return crow::response(404, R"({"error":"Unknown job"})");
+        }
+        crow::response resp(200, makeJobStatusJson(*info).dump());
+        resp.set_header("Content-Type", "application/json");
+        return resp;
+    });
+
+    // Cancels the job if it is running and deletes its upload and checkpoints.
+    CROW_ROUTE(app, "/jobs/<string>").methods("DELETE"_method)
+    ([this](const std::string& id) {
+        if (!jobRunner_->remove(id)) {
+            return crow::response(404, R"({"error":"Unknown job"})");
+        }
+        crow::response resp(200, json{{"job_id", id}, {"status", "deleted"}}.dump());
+        resp.set_header("Content-Type", "application/json");
+        return resp;
+    });
+
+    // Pages are returned as they are checkpointed, so a client can poll with
+    // from_page=next_page until the job is done.
+    CROW_ROUTE(app, "/jobs/<string>/result")
+    ([this](const crow::request& req, const std::string& id) {
+        const auto info = jobStore_->find(id);
+        if (!info) {
+            return crow::response(404, R"({"error":"Unknown job"})");
+        }
+        const char* fromParam = req.url_params.get("from_page");
+        const char* maxParam = req.url_params.get("max_pages");
+        const int fromPage = std::max(1, parseInt(fromParam ? fromParam : "", 1));
+        const int maxPages = parseInt(maxParam ? maxParam : "", 0);
+        const auto pages = jobStore_->readPages(
+            id, fromPage - 1, maxPages > 0 ? maxPages : std::numeric_limits<int>::max());
+
+        std::string markdown;
+        json contentList = json::array();
+        for (const auto& page : pages) {
+            markdown += page.value("md_content", std::string());
+            for (const auto& entry : page.value("content_list", json::array())) {
+                contentList.push_back(entry);
+            }
+        }
+        json body = makeJobStatusJson(*info);
+        body["from_page"] = fromPage;
+        body["next_page"] = fromPage + static_cast<int>(pages.size());
+        body["md_content"] = std::move(markdown);
+        body["content_list"] = std::move(contentList);
+        if (info->status != "done") {
+            body["partial"] = true;
+        }
+        crow::response resp(200, body.dump());
+        resp.set_header("Content-Type", "application/json");
+        return resp;
+    });
+
     CROW_ROUTE(app, "/v1/images:annotate").methods("POST"_method)
     ([this, &executeDocument](const crow::request& req) {
         requestCount_++;
@@ -1273,6 +2865,7 @@ void DocServer::run() {
 
             const bool globalDeepx = requestBody.value("deepx", true);
             json responses = json::array();
+            int retryAfterSeconds = 0;
 
             size_t index = 0;
             for (const auto& requestItem : requestBody["requests"]) {
@@ -1283,8 +2876,8 @@ void DocServer::run() {
                     if (requestItem.contains("image") &&
                         requestItem["image"].contains("content") &&
                         requestItem["image"]["content"].is_string()) {
-                        const auto decoded = base64Decode(requestItem["image"]["content"].get<std::string>());
-                        imageBytes.assign(reinterpret_cast<const char*>(decoded.data()), decoded.size());
+                        imageBytes = base64Decode(
+                            requestItem["image"]["content"].get_ref<const std::string&>());
                     } else if (requestItem.contains("image") &&
                                requestItem["image"].contains("source") &&
                                requestItem["image"]["source"].contains("imageUri") &&
@@ -1357,26 +2950,26 @@ void DocServer::run() {
                     options.clearOutputFile = true;
                     options.deepxRequested = requestItem.value("deepx", globalDeepx);
 
-                    const RoutedProcessedDocument routed = executeDocument(
+                    RoutedProcessedDocument routed = executeDocument(
                         imageBytes, imageName, options);
-                    const auto& processed = routed.processed;
+                    auto& processed = routed.processed;
 
                     json responseItem;
                     if (textDetection) {
                         responseItem["textAnnotations"] = json::array({
                             {
-                                {"description", processed.result.markdown},
+                                {"description", processed.markdown},
                                 {"locale", "auto"},
                             }
                         });
                     }
                     responseItem["fullTextAnnotation"] = json{
-                        {"text", processed.result.markdown},
+                        {"text", processed.markdown},
                     };
 
                     if (documentTextDetection) {
-                        responseItem["middleJson"] = processed.middleJson;
-                        responseItem["contentList"] = processed.contentList;
+                        responseItem["middleJson"] = std::move(processed.middleJson);
+                        responseItem["contentList"] = std::move(processed.contentList);
                     }
 
                     responseItem["topology"] = routed.dispatch.topology;
@@ -1392,6 +2985,16 @@ void DocServer::run() {
                     responses.push_back(std::move(responseItem));
                     fs::remove_all(processed.requestDir);
                 }
+                catch (const AdmissionRejected& e) {
+                    retryAfterSeconds = std::max(retryAfterSeconds, e.retryAfterSeconds);
+                    responses.push_back(json{
+                        {"error", {
+                            {"code", 429},
+                            {"message", e.what()},
+                            {"status", "RESOURCE_EXHAUSTED"},
+                        }},
+                    });
+                }
                 catch (const std::exception& e) {
                     responses.push_back(json{
                         {"error", {
@@ -1406,6 +3009,9 @@ void DocServer::run() {
             successCount_++;
             crow::response resp(200, json{{"responses", std::move(responses)}}.dump());
             resp.set_header("Content-Type", "application/json");
+            if (retryAfterSeconds > 0) {
+                resp.set_header("Retry-After", std::to_string(retryAfterSeconds));
+            }
             return resp;
         }
         catch (const std::exception& e) {
@@ -1427,6 +3033,12 @@ void DocServer::run() {
 
 void DocServer::stop() {
     running_ = false;
+    if (jobRunner_) {
+        jobRunner_->stop();
+    }
+    if (autotuner_) {
+        autotuner_->stop();
+    }
     if (deviceMetricsSampler_) {
         deviceMetricsSampler_->stop();
     }
@@ -1440,45 +3052,9 @@ std::string DocServer::handleProcess(const std::string& pdfData, const std::stri
     options.returnContentList = true;
     options.clearOutputFile = true;
 
-    const size_t shardIndex = selectShardIndex();
-    auto& shard = *shards_.at(shardIndex);
-    DispatchMetadata dispatch;
-    dispatch.topology = resolvedTopology();
-    dispatch.deviceId = shard.deviceId;
-    dispatch.shardId = shard.shardId;
-    dispatch.backendId =
-        (dispatch.topology == "single_card_backend") ? config_.serverId : std::string();
-
-    shard.inflight.fetch_add(1, std::memory_order_relaxed);
-    RoutedProcessedDocument routed;
-    try {
-        const auto queueStart = std::chrono::steady_clock::now();
-        std::unique_lock<std::mutex> lock(shard.requestMutex);
-        const auto shardAcquired = std::chrono::steady_clock::now();
-        dispatch.routeQueueMs =
-            std::chrono::duration<double, std::milli>(shardAcquired - queueStart).count();
-        routed.dispatch = dispatch;
-        routed.processed = processDocumentBytes(*shard.pipeline, pdfData, filename, options);
-        const auto shardDone = std::chrono::steady_clock::now();
-        shard.routeQueueUsTotal.fetch_add(
-            msToUs(dispatch.routeQueueMs),
-            std::memory_order_relaxed);
-        shard.busyUsTotal.fetch_add(
-            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
-                shardDone - shardAcquired).count()),
-            std::memory_order_relaxed);
-        shard.npuBusyUsTotal.fetch_add(
-            msToUs(routed.processed.result.stats.npuSerialTimeMs),
-            std::memory_order_relaxed);
-        shard.requestCount.fetch_add(1, std::memory_order_relaxed);
-        recordPipelineLockStats(routed.processed.result);
-        shard.inflight.fetch_sub(1, std::memory_order_relaxed);
-    } catch (...) {
-        shard.inflight.fetch_sub(1, std::memory_order_relaxed);
-        throw;
-    }
-
-    const auto& processed = routed.processed;
+    RoutedProcessedDocument routed =
+        DocumentDispatch::execute(*this, pdfData, filename, options);
+    auto& processed = routed.processed;
 
     json response{
         {"pages", processed.result.processedPages},
@@ -1494,8 +3070,8 @@ std::string DocServer::handleProcess(const std::string& pdfData, const std::stri
             processed.pipelineCallTimeMs,
             routed.dispatch.routeQueueMs,
             routed.dispatch.lbProxyMs)},
-        {"markdown", processed.result.markdown},
-        {"content_list", processed.contentList},
+        {"markdown", processed.markdown},
+        {"content_list", std::move(processed.contentList)},
         {"output_dir", processed.parseDir.string()},
     };
 
@@ -1512,12 +3088,26 @@ std::string DocServer::buildStatusJson() {
     const double holdAvgMs = samples == 0 ? 0.0 :
         static_cast<double>(holdUsTotal) / static_cast<double>(samples) / 1000.0;
 
+    json perEngine = json::object();
+    for (size_t i = 0; i < kNpuEngineCount; ++i) {
+        const NpuEngine engine = static_cast<NpuEngine>(i);
+        perEngine[npuEngineName(engine)] = {
+            {"concurrency", shards_.empty() ? 0 : shards_.front()->npuScheduler->limit(engine)},
+            {"wait_total_ms",
+                static_cast<double>(engineLockWaitUsTotal_[i].load(std::memory_order_relaxed)) / 1000.0},
+            {"hold_total_ms",
+                static_cast<double>(engineLockHoldUsTotal_[i].load(std::memory_order_relaxed)) / 1000.0},
+        };
+    }
+
     std::unordered_map<int, DeviceMetricSample> metricsByDevice;
     std::string memoryTelemetryStatus = "blocked_memory_telemetry_unavailable";
+    std::string thermalTelemetryStatus = "unavailable";
     if (deviceMetricsSampler_) {
         memoryTelemetryStatus = deviceMetricsSampler_->memoryTelemetryStatus();
+        thermalTelemetryStatus = deviceMetricsSampler_->thermalTelemetryStatus();
         for (const auto& sample : deviceMetricsSampler_->snapshot()) {
-            metricsByDevice[sample.deviceId] = sample;
+            metricsByDevice[sample.telemetry.deviceId] = sample;
         }
     }
 
@@ -1560,6 +3150,8 @@ std::string DocServer::buildStatusJson() {
         json item{
             {"device_id", shard->deviceId},
             {"shard_id", shard->shardId},
+            {"numa_node", shard->numaNode},
+            {"cpus", formatCpuList(shard->cpus)},
             {"request_count", requestCount},
             {"inflight", shard->inflight.load(std::memory_order_relaxed)},
             {"busy_time_ms", static_cast<double>(busyUs) / 1000.0},
@@ -1570,17 +3162,77 @@ std::string DocServer::buildStatusJson() {
             {"memory_total_bytes", nullptr},
             {"memory_last_used_bytes", nullptr},
             {"memory_peak_used_bytes", nullptr},
+            {"temperature_c", nullptr},
+            {"npu_clock_mhz", nullptr},
+            {"npu_utilization", nullptr},
+            {"health", "unknown"},
+            {"admission", "active"},
             {"load_imbalance_flag", loadImbalance},
         };
 
         if (metricsIt != metricsByDevice.end()) {
-            item["memory_total_bytes"] = metricsIt->second.memoryTotalBytes;
-            item["memory_last_used_bytes"] = maybeUIntToJson(metricsIt->second.memoryLastUsedBytes);
-            item["memory_peak_used_bytes"] = maybeUIntToJson(metricsIt->second.memoryPeakUsedBytes);
+            const DeviceTelemetry& telemetry = metricsIt->second.telemetry;
+            item["memory_total_bytes"] = telemetry.memoryTotalBytes;
+            item["memory_last_used_bytes"] = maybeUIntToJson(telemetry.memoryLastUsedBytes);
+            item["memory_peak_used_bytes"] = maybeUIntToJson(telemetry.memoryPeakUsedBytes);
+            if (telemetry.temperatureC) {
+                item["temperature_c"] = *telemetry.temperatureC;
+            }
+            if (telemetry.npuClockMhz) {
+                item["npu_clock_mhz"] = *telemetry.npuClockMhz;
+                item["peak_npu_clock_mhz"] = telemetry.peakNpuClockMhz;
+            }
+            item["npu_utilization"] = telemetry.npuUtilization;
+            item["health"] = deviceHealthName(metricsIt->second.health);
+        }
+        const size_t worker = static_cast<size_t>(&shard - shards_.data());
+        switch (scheduler_->workerState(worker)) {
+        case WorkerState::DEGRADED: item["admission"] = "degraded"; break;
+        case WorkerState::PAUSED:   item["admission"] = "paused"; break;
+        case WorkerState::ACTIVE:   break;
         }
         perDevice.push_back(std::move(item));
     }
 
+    const RequestScheduler::Stats admission = scheduler_->stats();
+    const ResultCache::Stats cache = resultCache_->stats();
+    json autotune{{"enabled", autotuner_ != nullptr}};
+    if (autotuner_) {
+        const TunerDecision tuned = autotuner_->current();
+        autotune["running_documents"] = tuned.knobs.inflight;
+        autotune["ocr_lanes"] = tuned.knobs.ocrLanes;
+        autotune["layout_batch_delay_ms"] =
+            tuned.knobs.batchDelayMs >= 0 ? json(tuned.knobs.batchDelayMs) : json(nullptr);
+        autotune["last_decision"] = tuned.reason;
+    }
+    json recognitionMemo{{"enabled", recognitionCache_ != nullptr}};
+    if (recognitionCache_) {
+        const auto layouts = recognitionCache_->layouts.stats();
+        const auto ocrTexts = recognitionCache_->ocrTexts.stats();
+        recognitionMemo["layout"] = {
+            {"hits", layouts.hits}, {"misses", layouts.misses},
+            {"entries", layouts.entries}, {"bytes", layouts.bytes}};
+        recognitionMemo["ocr"] = {
+            {"hits", ocrTexts.hits}, {"misses", ocrTexts.misses},
+            {"entries", ocrTexts.entries}, {"bytes", ocrTexts.bytes}};
+    }
+    json bufferPools = json::object();
+    for (const auto& metric : kBufferPoolMetrics) {
+        BufferPool::Stats total;
+        for (const auto& shard : shards_) {
+            const BufferPool::Stats s = shard->pipeline->bufferPoolStats().*metric.field;
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.inUseBytes += s.inUseBytes;
+            total.inUseHighWaterBytes += s.inUseHighWaterBytes;
+            total.retainedBytes += s.retainedBytes;
+        }
+        bufferPools[metric.pool] = {
+            {"hits", total.hits}, {"misses", total.misses},
+            {"in_use_bytes", total.inUseBytes},
+            {"in_use_high_water_bytes", total.inUseHighWaterBytes},
+            {"retained_bytes", total.retainedBytes}};
+    }
     json status{
         {"status", running_.load() ? "running" : "stopped"},
         {"requests", requestCount_.load()},
@@ -1594,8 +3246,36 @@ std::string DocServer::buildStatusJson() {
             {"shard_count", shards_.size()},
             {"configured_device_ids", configuredDeviceIds},
             {"memory_telemetry_status", memoryTelemetryStatus},
+            {"thermal_telemetry_status", thermalTelemetryStatus},
         }},
         {"per_device", std::move(perDevice)},
+        {"admission", {
+            {"max_queued", config_.maxQueuedRequests},
+            {"queued_interactive", admission.queued[static_cast<size_t>(RequestPriority::INTERACTIVE)]},
+            {"queued_batch", admission.queued[static_cast<size_t>(RequestPriority::BATCH)]},
+            {"running", admission.running},
+            {"running_limit", admission.runningLimit},
+            {"paused_workers", admission.pausedWorkers},
+            {"admitted", admission.admitted},
+            {"rejected", admission.rejected},
+            {"completed", admission.completed},
+            {"mean_service_ms", admission.meanServiceMs},
+        }},
+        {"autotune", std::move(autotune)},
+        {"result_cache", {
+            {"enabled", resultCache_->enabled()},
+            {"memory_hits", cache.memoryHits},
+            {"disk_hits", cache.diskHits},
+            {"misses", cache.misses},
+            {"stores", cache.stores},
+            {"evictions", cache.evictions},
+            {"memory_entries", cache.memoryEntries},
+            {"memory_bytes", cache.memoryBytes},
+            {"disk_entries", cache.diskEntries},
+            {"disk_bytes", cache.diskBytes},
+        }},
+        {"recognition_cache", std::move(recognitionMemo)},
+        {"buffer_pools", std::move(bufferPools)},
         {"pipeline_lock", {
             {"samples", samples},
             {"wait_total_ms", static_cast<double>(waitUsTotal) / 1000.0},
@@ -1604,6 +3284,7 @@ std::string DocServer::buildStatusJson() {
             {"hold_total_ms", static_cast<double>(holdUsTotal) / 1000.0},
             {"hold_avg_ms", holdAvgMs},
             {"hold_max_ms", static_cast<double>(lockHoldUsMax_.load(std::memory_order_relaxed)) / 1000.0},
+            {"per_engine", std::move(perEngine)},
         }},
         {"pipeline_stage_totals", {
             {"npu_serial_ms", static_cast<double>(npuStageUsTotal_.load(std::memory_order_relaxed)) / 1000.0},
@@ -1640,6 +3321,16 @@ void DocServer::recordPipelineLockStats(const DocumentResult& result) {
     cpuStageUsTotal_.fetch_add(cpuUs, std::memory_order_relaxed);
     updateAtomicMax(lockWaitUsMax_, waitUs);
     updateAtomicMax(lockHoldUsMax_, holdUs);
+
+    const std::array<std::pair<double, double>, kNpuEngineCount> perEngine{{
+        {result.stats.layoutNpuWaitTimeMs, result.stats.layoutNpuHoldTimeMs},
+        {result.stats.ocrNpuWaitTimeMs, result.stats.ocrNpuHoldTimeMs},
+        {result.stats.tableNpuWaitTimeMs, result.stats.tableNpuHoldTimeMs},
+    }};
+    for (size_t i = 0; i < kNpuEngineCount; ++i) {
+        engineLockWaitUsTotal_[i].fetch_add(msToUs(perEngine[i].first), std::memory_order_relaxed);
+        engineLockHoldUsTotal_[i].fetch_add(msToUs(perEngine[i].second), std::memory_order_relaxed);
+    }
 }
 
 } // namespace rapid_doc
@@ -6,6 +6,8 @@
 #include "server/server.h"
 #include "common/config.h"
 #include "common/logger.h"
+#include "common/trace.h"
+#include <algorithm>
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
@@ -31,11 +33,49 @@ void printUsage(const char* programName) {
     std::cout << "  -w, --workers <num>   Worker threads (default: 4)\n";
     std::cout << "      --device-id <id>  Pin this server to one DXRT device\n";
     std::cout << "      --device-ids <a,b> Configure multi-device shards in one process\n";
+    std::cout << "      --numa-placement  Pin each shard's threads to its device's NUMA node\n";
+    std::cout << "      --shard-cpus <list> Pin the next shard to a cpulist such as 0-15,32-47 (repeatable)\n";
     std::cout << "      --topology <mode> single_pipeline|single_process_multi_device|single_card_backend\n";
     std::cout << "      --routing-policy <p> Routing policy (default: least_inflight_rr)\n";
     std::cout << "      --server-id <id>  Stable server/backend identifier\n";
     std::cout << "      --no-ocr          Disable OCR stage\n";
     std::cout << "      --no-table        Disable wired table stage\n";
+    std::cout << "      --ort-threads <n> Layout NMS ONNX Runtime intra-op threads (default: 1)\n";
+    std::cout << "      --skip-blank-pages <x> Skip layout/OCR for pages with ink coverage <= x (e.g. 0.001; default: 0 = off)\n";
+    std::cout << "      --postprocess-threads <n> Shared CPU post-processing workers (default: -1 = hw threads)\n";
+    std::cout << "      --postprocess-stage-threads <n> Per-shard page post-processing workers off the NPU stages (default: 1)\n";
+    std::cout << "      --json-artifacts  Write pretty _middle.json/_model.json copies for every request\n";
+    std::cout << "      --save-visualization Write layout visualization images for every request\n";
+    std::cout << "      --no-save-origin  Do not keep a _origin copy of uploads unless a request asks\n";
+    std::cout << "      --trace-out <file> Record trace spans and write a Chrome trace on shutdown\n";
+    std::cout << "      --record <dir>    Record layout/table/OCR outputs and latencies to <dir>\n";
+    std::cout << "      --replay <dir>    Serve layout/table/OCR from a --record directory (no NPU)\n";
+    std::cout << "      --replay-latency-scale <x> Multiply replayed latencies (default: 1.0)\n";
+    std::cout << "      --image-format <f> png|jpg|webp for saved crops (default: png)\n";
+    std::cout << "      --image-quality <q> PNG level 0-9 or JPEG/WebP quality 1-100 (default: fast)\n";
+    std::cout << "      --fanout-pages <n> Split a PDF across idle shards, one per n pages (default: 8, 0 = off)\n";
+    std::cout << "      --max-queue <n>   Requests waiting for a shard before 429 (default: 64, 0 = unbounded)\n";
+    std::cout << "      --interactive-burst <n> Image requests served ahead of a waiting PDF (default: 4)\n";
+    std::cout << "      --result-cache-mb <n> In-memory result cache for repeated uploads (default: 0 = off)\n";
+    std::cout << "      --result-cache-disk-mb <n> On-disk result cache under the upload dir (default: 0 = off)\n";
+    std::cout << "      --request-timeout-s <n> Answer /file_parse with the pages done after n seconds (default: 0 = off)\n";
+    std::cout << "      --job-retention-s <n> Delete finished /jobs n seconds after they end (default: 604800, 0 = keep)\n";
+    std::cout << "      --shm-dir <dir>   Accept bodies a same-host topology LB passes as files in <dir>\n";
+    std::cout << "      --recognition-cache-mb <n> Layout/OCR memo for repeated pages and crops (default: 0 = off)\n";
+    std::cout << "      --text-layer      parse_method=auto reads text regions from the PDF text layer\n";
+    std::cout << "      --layout-fast-resize Box-filter layout resize instead of Python-exact bicubic\n";
+    std::cout << "      --page-buffer-pool-mb <n> Idle crop/input buffers kept per shard for reuse (default: 64, 0 = off)\n";
+    std::cout << "      --image-cache-mb <n> Encoded figure crops reused across requests (default: 16, 0 = off)\n";
+    std::cout << "      --npu-max-temp-c <c> Stop admitting to a device at this NPU temperature (default: 0 = off)\n";
+    std::cout << "      --npu-max-memory-ratio <r> Stop admitting to a device using this share of its memory (default: 0.95)\n";
+    std::cout << "      --autotune          Retune running documents, OCR lanes and layout batch window at runtime\n";
+    std::cout << "      --autotune-interval-ms <n> Autotune decision window (default: 5000)\n";
+    std::cout << "      --autotune-target-p95-ms <n> Request p95 the autotuner backs off above (default: 0 = none)\n";
+    std::cout << "      --autotune-max-inflight <n> Most documents running at once (default: 0 = one per shard)\n";
+    std::cout << "      --autotune-max-ocr-lanes <n> Most concurrent OCR batches per shard (default: 3)\n";
+    std::cout << "      --autotune-max-batch-delay-ms <n> Widest layout batch window (default: 8)\n";
+    std::cout << "      --no-warmup       Skip the synthetic warmup page at startup\n";
+    std::cout << "      --serial-init     Load models and shards one after another\n";
     std::cout << "  -h, --help            Show this help\n";
     std::cout << "\n";
     std::cout << "API Endpoints:\n";
@@ -45,6 +85,7 @@ void printUsage(const char* programName) {
     std::cout << "  POST /process/base64    - Legacy base64 PDF processing\n";
     std::cout << "  GET  /health            - Health check\n";
     std::cout << "  GET  /status            - Server statistics\n";
+    std::cout << "  GET  /metrics           - Prometheus metrics\n";
 }
 
 std::vector<int> parseDeviceIds(const std::string& raw) {
@@ -61,7 +102,9 @@ std::vector<int> parseDeviceIds(const std::string& raw) {
 
 int main(int argc, char* argv[]) {
     rapid_doc::ServerConfig config;
+    std::string traceOutPath;
     config.pipelineConfig = rapid_doc::PipelineConfig::Default(PROJECT_ROOT_DIR);
+    config.pipelineConfig.runtime.warmupOnInit = true;
 
     // Parse arguments using getopt_long
     static const struct option longOpts[] = {
@@ -75,6 +118,44 @@ int main(int argc, char* argv[]) {
         {"server-id", required_argument, nullptr, 260},
         {"no-ocr", no_argument, nullptr, 261},
         {"no-table", no_argument, nullptr, 262},
+        {"ort-threads", required_argument, nullptr, 263},
+        {"postprocess-threads", required_argument, nullptr, 265},
+        {"json-artifacts", no_argument, nullptr, 266},
+        {"save-visualization", no_argument, nullptr, 267},
+        {"image-format", required_argument, nullptr, 268},
+        {"image-quality", required_argument, nullptr, 269},
+        {"fanout-pages", required_argument, nullptr, 270},
+        {"max-queue", required_argument, nullptr, 271},
+        {"interactive-burst", required_argument, nullptr, 272},
+        {"result-cache-mb", required_argument, nullptr, 273},
+        {"result-cache-disk-mb", required_argument, nullptr, 274},
+        {"recognition-cache-mb", required_argument, nullptr, 275},
+        {"no-warmup", no_argument, nullptr, 276},
+        {"serial-init", no_argument, nullptr, 277},
+        {"no-save-origin", no_argument, nullptr, 278},
+        {"trace-out", required_argument, nullptr, 279},
+        {"record", required_argument, nullptr, 280},
+        {"replay", required_argument, nullptr, 281},
+        {"replay-latency-scale", required_argument, nullptr, 282},
+        {"page-buffer-pool-mb", required_argument, nullptr, 283},
+        {"text-layer", no_argument, nullptr, 284},
+        {"layout-fast-resize", no_argument, nullptr, 285},
+        {"request-timeout-s", required_argument, nullptr, 287},
+        {"shm-dir", required_argument, nullptr, 288},
+        {"numa-placement", no_argument, nullptr, 289},
+        {"shard-cpus", required_argument, nullptr, 290},
+        {"skip-blank-pages", required_argument, nullptr, 291},
+        {"image-cache-mb", required_argument, nullptr, 292},
+        {"npu-max-temp-c", required_argument, nullptr, 293},
+        {"npu-max-memory-ratio", required_argument, nullptr, 294},
+        {"autotune", no_argument, nullptr, 295},
+        {"autotune-interval-ms", required_argument, nullptr, 296},
+        {"autotune-target-p95-ms", required_argument, nullptr, 297},
+        {"autotune-max-inflight", required_argument, nullptr, 298},
+        {"autotune-max-ocr-lanes", required_argument, nullptr, 299},
+        {"autotune-max-batch-delay-ms", required_argument, nullptr, 300},
+        {"postprocess-stage-threads", required_argument, nullptr, 301},
+        {"job-retention-s", required_argument, nullptr, 302},
         {"help",    no_argument,       nullptr, 'h'},
         {nullptr,   0,                 nullptr, 0}
     };
@@ -107,6 +188,74 @@ int main(int argc, char* argv[]) {
             case 262:
                 config.pipelineConfig.stages.enableWiredTable = false;
                 break;
+            case 263:
+                config.pipelineConfig.runtime.layoutOrtIntraOpThreads = std::atoi(optarg);
+                break;
+            case 265:
+                config.pipelineConfig.runtime.postprocessThreads = std::atoi(optarg);
+                break;
+            case 266:
+                config.writeJsonArtifacts = true;
+                break;
+            case 267:
+                config.saveVisualization = true;
+                break;
+            case 268:
+                config.pipelineConfig.runtime.imageFormat = optarg;
+                break;
+            case 269:
+                config.pipelineConfig.runtime.imageQuality = std::atoi(optarg);
+                break;
+            case 270:
+                config.fanoutPagesPerShard = std::atoi(optarg);
+                break;
+            case 271:
+                config.maxQueuedRequests = static_cast<size_t>(std::max(0, std::atoi(optarg)));
+                break;
+            case 272:
+                config.interactiveBurst = static_cast<size_t>(std::max(1, std::atoi(optarg)));
+                break;
+            case 273:
+                config.resultCacheMemoryBytes =
+                    static_cast<size_t>(std::max(0, std::atoi(optarg))) * 1024 * 1024;
+                break;
+            case 274:
+                config.resultCacheDiskBytes =
+                    static_cast<size_t>(std::max(0, std::atoi(optarg))) * 1024 * 1024;
+                break;
+            case 275:
+                config.pipelineConfig.runtime.recognitionCacheMb = std::max(0, std::atoi(optarg));
+                break;
+            case 276: config.pipelineConfig.runtime.warmupOnInit = false; break;
+            case 277: config.pipelineConfig.runtime.parallelModelInit = false; break;
+            case 278: config.saveOriginUploads = false; break;
+            case 279: traceOutPath = optarg; break;
+            case 280: config.pipelineConfig.runtime.recordDir = optarg; break;
+            case 281: config.pipelineConfig.runtime.replayDir = optarg; break;
+            case 282: config.pipelineConfig.runtime.replayLatencyScale = std::atof(optarg); break;
+            case 283:
+                config.pipelineConfig.runtime.pageBufferPoolMb = std::max(0, std::atoi(optarg));
+                break;
+            case 284: config.pipelineConfig.runtime.useTextLayer = true; break;
+            case 285: config.pipelineConfig.runtime.layoutFastResize = true; break;
+            case 287: config.requestTimeoutSeconds = std::max(0, std::atoi(optarg)); break;
+            case 288: config.shmDir = optarg; break;
+            case 289: config.numaPlacement = true; break;
+            case 290: config.shardCpuLists.push_back(optarg); break;
+            case 291:
+                config.pipelineConfig.runtime.blankPageInkRatio = std::max(0.0, std::atof(optarg));
+                break;
+            case 292: config.pipelineConfig.runtime.imageCacheMb = std::max(0, std::atoi(optarg)); break;
+            case 293: config.deviceLimits.maxTemperatureC = std::max(0, std::atoi(optarg)); break;
+            case 294: config.deviceLimits.maxMemoryUsedRatio = std::max(0.0, std::atof(optarg)); break;
+            case 295: config.autotune.enabled = true; break;
+            case 296: config.autotune.intervalMs = std::max(100, std::atoi(optarg)); break;
+            case 297: config.autotune.targetP95Seconds = std::max(0.0, std::atof(optarg) / 1000.0); break;
+            case 298: config.autotune.maxInflight = std::max(0, std::atoi(optarg)); break;
+            case 299: config.autotune.maxOcrLanes = std::max(1, std::atoi(optarg)); break;
+            case 300: config.autotune.maxBatchDelayMs = std::max(0, std::atoi(optarg)); break;
+            case 301: config.pipelineConfig.runtime.postprocessStageThreads = std::max(1, std::atoi(optarg)); break;
+            case 302: config.jobRetentionSeconds = std::max(0, std::atoi(optarg)); break;
             case 'h': printUsage(argv[0]); return 0;
             default:  printUsage(argv[0]); return 1;
         }
@@ -119,6 +268,10 @@ int main(int argc, char* argv[]) {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
+    if (!traceOutPath.empty()) {
+        rapid_doc::Tracer::enable();
+    }
+
     try {
         rapid_doc::DocServer server(config);
         g_server = &server;
@@ -140,5 +293,14 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (!traceOutPath.empty()) {
+        rapid_doc::Tracer::disable();
+        if (!rapid_doc::Tracer::writeChromeTrace(traceOutPath)) {
+            LOG_ERROR("Could not write trace: {}", traceOutPath);
+            return 1;
+        }
+        LOG_INFO("Trace saved to: {}", traceOutPath);
+    }
+
     return 0;
 }
@@ -1,11 +1,18 @@
+#include "server/lb_headers.h"
+#include "server/lb_routing.h"
+#include "server/shm_transport.h"
+
 #include <crow.h>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <filesystem>
 #include <getopt.h>
 #include <iostream>
 #include <limits>
@@ -13,22 +20,92 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using json = nlohmann::json;
+namespace lb_headers = rapid_doc::lb_headers;
+namespace shm_transport = rapid_doc::shm_transport;
+using rapid_doc::BackendLoad;
+using rapid_doc::BackendRouter;
+using rapid_doc::RoutingPolicy;
 
 namespace {
 
+// Easy handles kept per backend. curl_easy_reset() leaves a handle's
+// connection cache alone, so a reused handle skips the TCP handshake.
+class CurlHandlePool {
+public:
+    CurlHandlePool() = default;
+    CurlHandlePool(const CurlHandlePool&) = delete;
+    CurlHandlePool& operator=(const CurlHandlePool&) = delete;
+
+    ~CurlHandlePool() {
+        for (CURL* handle : idle_) {
+            curl_easy_cleanup(handle);
+        }
+    }
+
+    CURL* acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                CURL* handle = idle_.back();
+                idle_.pop_back();
+                return handle;
+            }
+        }
+        return curl_easy_init();
+    }
+
+    void release(CURL* handle) {
+        if (handle == nullptr) {
+            return;
+        }
+        curl_easy_reset(handle);
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(handle);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<CURL*> idle_;
+};
+
+class PooledHandle {
+public:
+    explicit PooledHandle(CurlHandlePool& pool) : pool_(pool), handle_(pool.acquire()) {}
+    ~PooledHandle() { pool_.release(handle_); }
+
+    PooledHandle(const PooledHandle&) = delete;
+    PooledHandle& operator=(const PooledHandle&) = delete;
+
+    CURL* get() const { return handle_; }
+
+private:
+    CurlHandlePool& pool_;
+    CURL* handle_;
+};
+
 struct Backend {
     std::string id;
     std::string baseUrl;
-    std::atomic<uint64_t> inflight{0};
+    CurlHandlePool handles;
 };
 
 struct CurlResponse {
     long httpCode = 0;
     std::string body;
     std::string error;
+    std::unordered_map<std::string, std::string> headers;   // lower-case names
+
+    std::string header(const std::string& lowerName) const {
+        const auto it = headers.find(lowerName);
+        return it == headers.end() ? std::string() : it->second;
+    }
 };
 
 std::string normalizeBaseUrl(std::string url) {
@@ -38,77 +115,100 @@ std::string normalizeBaseUrl(std::string url) {
     return url;
 }
 
+std::string toLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
 size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
     auto* out = static_cast<std::string*>(userdata);
     out->append(ptr, size * nmemb);
     return size * nmemb;
 }
 
-CurlResponse curlGetJson(const std::string& url) {
-    CurlResponse response;
-    CURL* curl = curl_easy_init();
-    if (curl == nullptr) {
-        response.error = "curl_init_failed";
-        return response;
+size_t headerCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* headers = static_cast<std::unordered_map<std::string, std::string>*>(userdata);
+    const std::string line(ptr, size * nmemb);
+    if (line.rfind("HTTP/", 0) == 0) {
+        headers->clear();   // a new response (e.g. after a redirect) starts over
+        return size * nmemb;
+    }
+    const size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+        const size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        const size_t valueEnd = line.find_last_not_of(" \t\r\n");
+        (*headers)[toLower(line.substr(0, colon))] =
+            (valueStart == std::string::npos || valueEnd < valueStart)
+                ? std::string()
+                : line.substr(valueStart, valueEnd - valueStart + 1);
     }
+    return size * nmemb;
+}
 
+// Options every backend call shares; the handle comes from the backend's pool.
+void performRequest(CURL* curl, const std::string& url, long timeoutSeconds, CurlResponse& response) {
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeoutSeconds);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
 
     const CURLcode code = curl_easy_perform(curl);
     if (code != CURLE_OK) {
         response.error = curl_easy_strerror(code);
     }
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.httpCode);
-    curl_easy_cleanup(curl);
+}
+
+CurlResponse curlGetJson(Backend& backend, const std::string& path, long timeoutSeconds = 30L) {
+    CurlResponse response;
+    PooledHandle curl(backend.handles);
+    if (curl.get() == nullptr) {
+        response.error = "curl_init_failed";
+        return response;
+    }
+    performRequest(curl.get(), backend.baseUrl + path, timeoutSeconds, response);
     return response;
 }
 
-CurlResponse forwardMultipartRequest(
-    const crow::multipart::message& msg,
-    const std::string& url)
+// Sends the client's body as received, so multipart uploads are neither
+// parsed nor re-encoded on the way through. @p body is empty when it went
+// through the shm directory instead.
+CurlResponse forwardRequest(
+    Backend& backend,
+    const std::string& path,
+    const std::string& contentType,
+    std::string_view body,
+    const std::vector<std::string>& extraHeaders,
+    long timeoutSeconds)
 {
     CurlResponse response;
-    CURL* curl = curl_easy_init();
-    if (curl == nullptr) {
+    PooledHandle curl(backend.handles);
+    if (curl.get() == nullptr) {
         response.error = "curl_init_failed";
         return response;
     }
 
-    curl_mime* mime = curl_mime_init(curl);
-    for (const auto& entry : msg.part_map) {
-        const auto& part = entry.second;
-        curl_mimepart* mimePart = curl_mime_addpart(mime);
-        curl_mime_name(mimePart, entry.first.c_str());
-        curl_mime_data(mimePart, part.body.data(), part.body.size());
-
-        const auto disposition = part.get_header_object("Content-Disposition");
-        const auto filenameIt = disposition.params.find("filename");
-        if (filenameIt != disposition.params.end()) {
-            curl_mime_filename(mimePart, filenameIt->second.c_str());
-        }
-
-        const std::string contentType = part.get_header_object("Content-Type").value;
-        if (!contentType.empty()) {
-            curl_mime_type(mimePart, contentType.c_str());
-        }
+    curl_slist* headers = nullptr;
+    headers = curl_slist_append(
+        headers, ("Content-Type: " + contentType).c_str());
+    // No "Expect: 100-continue" round trip before large bodies.
+    headers = curl_slist_append(headers, "Expect:");
+    for (const auto& header : extraHeaders) {
+        headers = curl_slist_append(headers, header.c_str());
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 300L);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
-
-    const CURLcode code = curl_easy_perform(curl);
-    if (code != CURLE_OK) {
-        response.error = curl_easy_strerror(code);
-    }
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.httpCode);
-    curl_mime_free(mime);
-    curl_easy_cleanup(curl);
+    curl_easy_setopt(curl.get(), CURLOPT_POST, 1L);
+    curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(curl.get(), CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(curl.get(), CURLOPT_HTTPHEADER, headers);
+    performRequest(curl.get(), backend.baseUrl + path, timeoutSeconds, response);
+    curl_slist_free_all(headers);
     return response;
 }
 
@@ -122,25 +222,33 @@ std::vector<std::string> parseRepeatableBackendUrls(int argc, char* argv[]) {
     return urls;
 }
 
-size_t selectBackendIndex(
-    const std::vector<std::unique_ptr<Backend>>& backends,
-    std::atomic<uint64_t>& cursor)
-{
-    const size_t count = backends.size();
-    const size_t start = static_cast<size_t>(
-        cursor.fetch_add(1, std::memory_order_relaxed) % count);
-
-    size_t bestIndex = start;
-    uint64_t bestInflight = backends[start]->inflight.load(std::memory_order_relaxed);
-    for (size_t offset = 1; offset < count; ++offset) {
-        const size_t idx = (start + offset) % count;
-        const uint64_t inflight = backends[idx]->inflight.load(std::memory_order_relaxed);
-        if (inflight < bestInflight) {
-            bestInflight = inflight;
-            bestIndex = idx;
+// Refreshes @p load from the backend's /status; repeated failures eject it.
+void pollBackendStatus(Backend& backend, BackendLoad& load, int ejectAfterFailures) {
+    const CurlResponse resp = curlGetJson(backend, "/status", 5L);
+    const json payload = (resp.error.empty() && resp.httpCode == 200)
+        ? json::parse(resp.body, nullptr, false)
+        : json(json::value_t::discarded);
+    if (payload.is_discarded()) {
+        if (load.reportFailure(ejectAfterFailures)) {
+            std::cerr << "Ejecting " << backend.id << " (" << backend.baseUrl << "): "
+                      << (resp.error.empty() ? "http_" + std::to_string(resp.httpCode) : resp.error)
+                      << "\n";
         }
+        return;
+    }
+
+    const bool wasHealthy = load.healthy();
+    json admission = json::object();
+    if (payload.contains("admission") && payload["admission"].is_object()) {
+        admission = payload["admission"];
+    }
+    load.reportStatus(
+        admission.value("queued_interactive", 0ULL) + admission.value("queued_batch", 0ULL),
+        admission.value("running", 0ULL),
+        admission.value("mean_service_ms", 0.0));
+    if (!wasHealthy) {
+        std::cerr << "Readmitting " << backend.id << " (" << backend.baseUrl << ")\n";
     }
-    return bestIndex;
 }
 
 double maxMinRatio(const std::vector<double>& values) {
@@ -175,9 +283,9 @@ void recomputeLoadImbalance(json& perDevice) {
 
 json aggregateStatus(
     const std::vector<std::unique_ptr<Backend>>& backends,
+    const BackendRouter& router,
     const std::string& serverId,
-    int workers,
-    const std::string& routingPolicy)
+    int workers)
 {
     uint64_t requests = 0;
     uint64_t success = 0;
@@ -193,14 +301,23 @@ json aggregateStatus(
     json backendStatuses = json::array();
     std::string memoryStatus = "blocked_memory_telemetry_unavailable";
 
-    for (const auto& backend : backends) {
-        const CurlResponse resp = curlGetJson(backend->baseUrl + "/status");
+    for (size_t i = 0; i < backends.size(); ++i) {
+        const auto& backend = backends[i];
+        const BackendLoad& load = router.load(i);
+        const json routing{
+            {"healthy", load.healthy()},
+            {"inflight", load.inflight()},
+            {"reported_backlog", load.reportedBacklog()},
+            {"estimated_work_ms", load.estimatedWorkMs(0)},
+        };
+        const CurlResponse resp = curlGetJson(*backend, "/status");
         if (!resp.error.empty() || resp.httpCode != 200) {
             backendStatuses.push_back(json{
                 {"backend_id", backend->id},
                 {"base_url", backend->baseUrl},
                 {"status", "error"},
                 {"error", resp.error.empty() ? ("http_" + std::to_string(resp.httpCode)) : resp.error},
+                {"routing", routing},
             });
             continue;
         }
@@ -212,6 +329,7 @@ json aggregateStatus(
                 {"base_url", backend->baseUrl},
                 {"status", "error"},
                 {"error", "invalid_json"},
+                {"routing", routing},
             });
             continue;
         }
@@ -248,6 +366,7 @@ json aggregateStatus(
             {"backend_id", backend->id},
             {"base_url", backend->baseUrl},
             {"status", "ok"},
+            {"routing", routing},
         });
     }
 
@@ -269,7 +388,7 @@ json aggregateStatus(
         {"topology", {
             {"mode", "front_lb"},
             {"server_id", serverId},
-            {"routing_policy", routingPolicy},
+            {"routing_policy", rapid_doc::routingPolicyName(router.policy())},
             {"worker_count", workers},
             {"shard_count", backends.size()},
             {"configured_device_ids", configuredDeviceIds},
@@ -293,6 +412,9 @@ json aggregateStatus(
     };
 }
 
+// Part of a forwarded request's curl timeout left for the backend's reply
+constexpr long kDeadlineMarginMs = 1000L;
+
 void printUsage(const char* programName) {
     std::cout << "RapidDoc Topology LB\n\n";
     std::cout << "Usage: " << programName << " [options]\n\n";
@@ -302,7 +424,13 @@ void printUsage(const char* programName) {
     std::cout << "  -w, --workers <num>     Worker threads (default: 1)\n";
     std::cout << "      --backend-url <u>   Backend base URL (repeatable)\n";
     std::cout << "      --server-id <id>    Stable LB identifier\n";
-    std::cout << "      --routing-policy <p> Routing policy (default: least_inflight_rr)\n";
+    std::cout << "      --routing-policy <p> least_inflight_rr|least_work|p2c|consistent_hash\n";
+    std::cout << "                          (default: least_inflight_rr)\n";
+    std::cout << "      --status-interval-ms <n> Backend /status poll period (default: 1000)\n";
+    std::cout << "      --eject-after <n>   Consecutive failures before a backend is ejected (default: 3)\n";
+    std::cout << "      --request-timeout-s <n> Give up on a forwarded parse after n seconds (default: 300)\n";
+    std::cout << "      --shm-dir <dir>     Pass bodies to same-host backends as files in <dir>, e.g. /dev/shm\n";
+    std::cout << "                          (backends need the same --shm-dir)\n";
     std::cout << "  -h, --help              Show this help\n";
 }
 
@@ -314,6 +442,10 @@ int main(int argc, char* argv[]) {
     int workers = 1;
     std::string serverId = "front_lb";
     std::string routingPolicy = "least_inflight_rr";
+    int statusIntervalMs = 1000;
+    int ejectAfterFailures = 3;
+    long requestTimeoutSeconds = 300L;
+    std::string shmDir;
     std::vector<std::string> backendUrls = parseRepeatableBackendUrls(argc, argv);
 
     static const option longOpts[] = {
@@ -323,6 +455,10 @@ int main(int argc, char* argv[]) {
         {"backend-url", required_argument, nullptr, 256},
         {"server-id", required_argument, nullptr, 257},
         {"routing-policy", required_argument, nullptr, 258},
+        {"status-interval-ms", required_argument, nullptr, 259},
+        {"eject-after", required_argument, nullptr, 260},
+        {"request-timeout-s", required_argument, nullptr, 261},
+        {"shm-dir", required_argument, nullptr, 262},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0},
     };
@@ -336,6 +472,10 @@ int main(int argc, char* argv[]) {
             case 256: break;
             case 257: serverId = optarg; break;
             case 258: routingPolicy = optarg; break;
+            case 259: statusIntervalMs = std::max(50, std::atoi(optarg)); break;
+            case 260: ejectAfterFailures = std::max(1, std::atoi(optarg)); break;
+            case 261: requestTimeoutSeconds = std::max(1L, std::atol(optarg)); break;
+            case 262: shmDir = optarg; break;
             case 'h': printUsage(argv[0]); return 0;
             default: printUsage(argv[0]); return 1;
         }
@@ -345,19 +485,57 @@ int main(int argc, char* argv[]) {
         std::cerr << "At least one --backend-url is required\n";
         return 1;
     }
+    RoutingPolicy policy = RoutingPolicy::LEAST_INFLIGHT_RR;
+    if (!rapid_doc::parseRoutingPolicy(routingPolicy, policy)) {
+        std::cerr << "Unknown --routing-policy: " << routingPolicy << "\n";
+        return 1;
+    }
+
+    std::string shmSecret;
+    if (!shmDir.empty()) {
+        shmSecret = shm_transport::loadOrCreateSecret(shmDir);
+        if (shmSecret.empty()) {
+            std::cerr << "No shm secret in " << shmDir << "; bodies go over HTTP\n";
+            shmDir.clear();
+        }
+    }
 
     curl_global_init(CURL_GLOBAL_DEFAULT);
 
     std::vector<std::unique_ptr<Backend>> backends;
+    std::vector<std::string> backendIds;
     backends.reserve(backendUrls.size());
     for (size_t i = 0; i < backendUrls.size(); ++i) {
         auto backend = std::make_unique<Backend>();
         backend->id = "backend_" + std::to_string(i);
         backend->baseUrl = normalizeBaseUrl(backendUrls[i]);
+        backendIds.push_back(backend->id);
         backends.push_back(std::move(backend));
     }
+    BackendRouter router(policy, backendIds);
+    // A backend only listens once its shards are loaded and warm, so one that
+    // does not answer yet starts ejected and joins on its first good poll.
+    for (size_t i = 0; i < backends.size(); ++i) {
+        pollBackendStatus(*backends[i], router.load(i), 1);
+    }
+
+    // Keeps each backend's reported load and health fresh for the router.
+    std::mutex pollerMutex;
+    std::condition_variable pollerWake;
+    bool pollerStop = false;
+    std::thread poller([&]() {
+        std::unique_lock<std::mutex> lock(pollerMutex);
+        while (!pollerStop) {
+            lock.unlock();
+            for (size_t i = 0; i < backends.size(); ++i) {
+                pollBackendStatus(*backends[i], router.load(i), ejectAfterFailures);
+            }
+            lock.lock();
+            pollerWake.wait_for(lock, std::chrono::milliseconds(statusIntervalMs),
+                                [&]() { return pollerStop; });
+        }
+    });
 
-    std::atomic<uint64_t> cursor{0};
     crow::SimpleApp app;
 
     CROW_ROUTE(app, "/health")
@@ -375,7 +553,7 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/status")
     ([&]() {
-        const json payload = aggregateStatus(backends, serverId, workers, routingPolicy);
+        const json payload = aggregateStatus(backends, router, serverId, workers);
         crow::response resp(200, payload.dump());
         resp.set_header("Content-Type", "application/json");
         return resp;
@@ -383,43 +561,122 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/file_parse").methods("POST"_method)
     ([&](const crow::request& req) {
+        const auto receivedAt = std::chrono::steady_clock::now();
         const auto contentType = req.get_header_value("Content-Type");
         if (contentType.find("multipart/form-data") == std::string::npos) {
             return crow::response(400, R"({"error":"Expected multipart/form-data"})");
         }
 
-        crow::multipart::message msg(req);
-        if (msg.part_map.empty()) {
-            return crow::response(400, R"({"error":"No multipart parts provided"})");
+        const size_t requestBytes = req.body.size();
+        const uint64_t contentKey = router.needsContentKey()
+            ? BackendRouter::hashBytes(req.body.data(), req.body.size())
+            : 0;
+        const int backendIndex = router.select(requestBytes, contentKey);
+        if (backendIndex < 0) {
+            crow::response resp(503, R"({"error":"no_healthy_backend"})");
+            resp.set_header("Retry-After", std::to_string(std::max(1, statusIntervalMs / 1000)));
+            return resp;
         }
-
-        const size_t backendIndex = selectBackendIndex(backends, cursor);
-        auto& backend = *backends.at(backendIndex);
-        backend.inflight.fetch_add(1, std::memory_order_relaxed);
+        auto& backend = *backends.at(static_cast<size_t>(backendIndex));
+        BackendLoad& load = router.load(static_cast<size_t>(backendIndex));
 
         try {
             const auto proxyStart = std::chrono::steady_clock::now();
-            CurlResponse backendResp = forwardMultipartRequest(
-                msg,
-                backend.baseUrl + "/file_parse");
+            const double overheadMs =
+                std::chrono::duration<double, std::milli>(proxyStart - receivedAt).count();
+            // The backend stops a little before curl gives up, so its partial
+            // result still makes it back.
+            const long deadlineMs =
+                std::max(0L, requestTimeoutSeconds * 1000L - kDeadlineMarginMs);
+            std::vector<std::string> headers{
+                std::string(lb_headers::kBackendId) + ": " + backend.id,
+                std::string(lb_headers::kServerId) + ": " + serverId,
+                std::string(lb_headers::kOverheadMs) + ": " + std::to_string(overheadMs),
+                std::string(lb_headers::kDeadlineMs) + ": " + std::to_string(deadlineMs),
+            };
+            // The upload is written to the shm directory once and only its
+            // path crosses the socket; the backend removes the file on read.
+            std::string shmRequestPath;
+            if (!shmDir.empty()) {
+                shmRequestPath = shm_transport::makeBodyPath(shmDir, serverId);
+                if (shm_transport::writeBody(shmRequestPath, req.body)) {
+                    headers.push_back(std::string(lb_headers::kShmBody) + ": " + shmRequestPath);
+                    headers.push_back(std::string(lb_headers::kShmSecret) + ": " + shmSecret);
+                } else {
+                    std::error_code ec;
+                    std::filesystem::remove(shmRequestPath, ec);
+                    shmRequestPath.clear();
+                }
+            }
+            auto dropShmRequest = [&shmRequestPath]() {
+                if (!shmRequestPath.empty()) {
+                    std::error_code ec;
+                    std::filesystem::remove(shmRequestPath, ec);
+                }
+            };
+            CurlResponse backendResp;
+            load.beginRequest(requestBytes);
+            try {
+                backendResp = forwardRequest(
+                    backend,
+                    "/file_parse",
+                    contentType,
+                    shmRequestPath.empty() ? std::string_view(req.body) : std::string_view(),
+                    headers,
+                    requestTimeoutSeconds);
+            } catch (...) {
+                dropShmRequest();
+                load.endRequest(requestBytes, -1.0);
+                throw;
+            }
+            dropShmRequest();
+            const std::string shmResponsePath = backendResp.header(toLower(lb_headers::kShmBody));
+            if (backendResp.error.empty() && !shmResponsePath.empty() &&
+                (!shm_transport::isBodyPath(shmDir, shmResponsePath) ||
+                 !shm_transport::takeBody(shmResponsePath, backendResp.body))) {
+                backendResp.error = "shm_response_unreadable";
+            }
             const auto proxyEnd = std::chrono::steady_clock::now();
-            backend.inflight.fetch_sub(1, std::memory_order_relaxed);
+            const double lbProxyMs =
+                std::chrono::duration<double, std::milli>(proxyEnd - proxyStart).count();
+            // Only completed parses teach the per-byte rate; quick 429s would skew it.
+            load.endRequest(
+                requestBytes,
+                (backendResp.error.empty() && backendResp.httpCode == 200) ? lbProxyMs : -1.0);
 
             if (!backendResp.error.empty()) {
+                if (load.reportFailure(ejectAfterFailures)) {
+                    std::cerr << "Ejecting " << backend.id << " (" << backend.baseUrl << "): "
+                              << backendResp.error << "\n";
+                }
                 return crow::response(
                     502,
                     json{{"error", "backend_proxy_failed"}, {"detail", backendResp.error}}.dump());
             }
 
+            crow::response resp(static_cast<int>(backendResp.httpCode));
+            resp.set_header(lb_headers::kServedBy, backend.id);
+            resp.set_header(lb_headers::kProxyMs, std::to_string(lbProxyMs));
+            const std::string retryAfter = backendResp.header("retry-after");
+            if (!retryAfter.empty()) {
+                resp.set_header("Retry-After", retryAfter);
+            }
+
+            if (!backendResp.header(toLower(lb_headers::kLbMetadataApplied)).empty()) {
+                // The backend already stamped our metadata: pass the body through.
+                const std::string backendType = backendResp.header("content-type");
+                resp.set_header("Content-Type", backendType.empty() ? "application/json" : backendType);
+                resp.body = std::move(backendResp.body);
+                return resp;
+            }
+
+            // Older backends: inject the metadata into the JSON ourselves.
             json payload = json::parse(backendResp.body, nullptr, false);
             if (payload.is_discarded()) {
                 return crow::response(
                     502,
                     json{{"error", "backend_invalid_json"}, {"body", backendResp.body}}.dump());
             }
-
-            const double lbProxyMs =
-                std::chrono::duration<double, std::milli>(proxyEnd - proxyStart).count();
             if (payload.contains("results") && payload["results"].is_array()) {
                 for (auto& item : payload["results"]) {
                     item["topology"] = "front_lb";
@@ -433,11 +690,10 @@ int main(int argc, char* argv[]) {
             payload["backend_id"] = backend.id;
             payload["lb_server_id"] = serverId;
 
-            crow::response resp(static_cast<int>(backendResp.httpCode), payload.dump());
+            resp.body = payload.dump();
             resp.set_header("Content-Type", "application/json");
             return resp;
         } catch (const std::exception& e) {
-            backend.inflight.fetch_sub(1, std::memory_order_relaxed);
             return crow::response(
                 500,
                 json{{"error", "lb_internal_error"}, {"detail", e.what()}}.dump());
@@ -449,6 +705,15 @@ int main(int argc, char* argv[]) {
        .concurrency(static_cast<uint16_t>(workers))
        .run();
 
+    {
+        std::lock_guard<std::mutex> lock(pollerMutex);
+        pollerStop = true;
+    }
+    pollerWake.notify_all();
+    poller.join();
+
+    // Pooled handles go before libcurl itself.
+    backends.clear();
     curl_global_cleanup();
     return 0;
 }
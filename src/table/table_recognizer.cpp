@@ -11,7 +11,9 @@
  */
 
 #include "table/table_recognizer.h"
+#include "table/table_mask.h"
 #include "common/logger.h"
+#include "common/trace.h"
 
 #include <dxrt/inference_engine.h>
 
@@ -19,7 +21,9 @@
 #include <cmath>
 #include <chrono>
 #include <numeric>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <set>
 #include <stdexcept>
 #include <tuple>
@@ -30,17 +34,49 @@ namespace rapid_doc {
 // Pimpl
 // ============================================================================
 struct TableRecognizer::Impl {
+    Impl(size_t inputPoolBytes, size_t maskPoolBytes)
+        : inputPool(inputPoolBytes)
+        , maskPool(maskPoolBytes)
+    {}
+
     std::unique_ptr<dxrt::InferenceEngine> dxEngine;
+
+    // Model inputs and decoded line masks reused across tables instead of
+    // one allocation per crop; a buffer returns once its last Mat is gone.
+    BufferPool inputPool;
+    BufferPool maskPool;
 };
 
+namespace {
+
+// Tables in flight on the NPU per recognizeNpuStageBatch() call: one running
+// while the next is preprocessed.
+constexpr size_t kTableNpuPipelineDepth = 2;
+
+}  // namespace
+
 // ============================================================================
 // Constructor / Destructor / Initialize
 // ============================================================================
 TableRecognizer::TableRecognizer(const TableRecognizerConfig& config)
-    : config_(config), impl_(std::make_unique<Impl>())
+    : config_(config)
+    // Inputs: the tables in flight plus one being preprocessed. Masks: an
+    // h/v pair per table of a page waiting for post-processing.
+    , impl_(std::make_unique<Impl>(
+          BufferPool::capacityFor(config.inputSize, config.inputSize, CV_8UC3) *
+              (kTableNpuPipelineDepth + 1),
+          BufferPool::capacityFor(config.inputSize, config.inputSize, CV_8UC1) * 16))
 {
 }
 
+BufferPool::Stats TableRecognizer::inputPoolStats() const {
+    return impl_->inputPool.stats();
+}
+
+BufferPool::Stats TableRecognizer::maskPoolStats() const {
+    return impl_->maskPool.stats();
+}
+
 TableRecognizer::~TableRecognizer() = default;
 
 bool TableRecognizer::initialize() {
@@ -69,24 +105,27 @@ bool TableRecognizer::initialize() {
 // ============================================================================
 // Preprocess — resize_with_padding → BGR→RGB → NHWC uint8
 // ============================================================================
-cv::Mat TableRecognizer::preprocess(const cv::Mat& image) {
+cv::Size TableRecognizer::modelResizeSize(const cv::Mat& image) const {
+    float scale = static_cast<float>(config_.inputSize) / std::max(image.rows, image.cols);
+    return cv::Size(static_cast<int>(image.cols * scale), static_cast<int>(image.rows * scale));
+}
+
+void TableRecognizer::preprocess(const cv::Mat& image, const cv::Size& newSize, cv::Mat& out) {
     int targetSize = config_.inputSize;
-    int h = image.rows, w = image.cols;
-    float scale = static_cast<float>(targetSize) / std::max(h, w);
-    int newH = static_cast<int>(h * scale);
-    int newW = static_cast<int>(w * scale);
-    int interpolation = (scale < 1.0f) ? cv::INTER_AREA : cv::INTER_CUBIC;
-    cv::Mat resized;
-    cv::resize(image, resized, cv::Size(newW, newH), 0, 0, interpolation);
-    int padH = targetSize - newH, padW = targetSize - newW;
-    int padTop = padH / 2, padBottom = padH - padTop;
-    int padLeft = padW / 2, padRight = padW - padLeft;
-    cv::Mat padded;
-    cv::copyMakeBorder(resized, padded, padTop, padBottom, padLeft, padRight,
-                       cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
-    cv::Mat rgb;
-    cv::cvtColor(padded, rgb, cv::COLOR_BGR2RGB);
-    return rgb;
+    int newH = newSize.height, newW = newSize.width;
+    cv::Mat resized = image;
+    if (image.size() != newSize) {
+        int interpolation = (newW < image.cols) ? cv::INTER_AREA : cv::INTER_CUBIC;
+        cv::resize(image, resized, newSize, 0, 0, interpolation);
+    }
+    int padTop = (targetSize - newH) / 2;
+    int padLeft = (targetSize - newW) / 2;
+    // White padding is the same in BGR and RGB, so the colour conversion
+    // writes straight into the centre of the letterboxed buffer.
+    out.create(targetSize, targetSize, CV_8UC3);
+    out.setTo(cv::Scalar::all(255));
+    cv::Mat centre = out(cv::Rect(padLeft, padTop, newW, newH));
+    cv::cvtColor(resized, centre, cv::COLOR_BGR2RGB);
 }
 
 // ============================================================================
@@ -137,47 +176,92 @@ BoxInfo calcBoxInfo(const float box[8]) {
     return {angle, w, h, cx, cy};
 }
 
+/**
+ * Leftmost and rightmost pixel per row of every component accepted by
+ * @p keep, gathered in one sweep of the label image. They include every
+ * convex-hull vertex of the component, so minAreaRect over them equals
+ * minAreaRect over all of its pixels.
+ */
+template <typename Keep>
+std::vector<std::vector<cv::Point>> collectComponentOutlines(
+    const cv::Mat& labels, const cv::Mat& stats, int numLabels, Keep&& keep)
+{
+    std::vector<std::vector<cv::Point>> outlines(numLabels);
+    std::vector<uint8_t> wanted(numLabels, 0);
+    for (int i = 1; i < numLabels; ++i) {
+        if (keep(i)) {
+            wanted[i] = 1;
+            outlines[i].reserve(2 * static_cast<size_t>(stats.at<int>(i, cv::CC_STAT_HEIGHT)));
+        }
+    }
+
+    std::vector<int> seenRow(numLabels, -1);
+    std::vector<int> first(numLabels, 0);
+    std::vector<int> last(numLabels, 0);
+    std::vector<int> touched;
+    for (int r = 0; r < labels.rows; ++r) {
+        const int* labelRow = labels.ptr<int>(r);
+        touched.clear();
+        for (int c = 0; c < labels.cols; ++c) {
+            const int label = labelRow[c];
+            if (label <= 0 || !wanted[label]) continue;
+            if (seenRow[label] != r) {
+                seenRow[label] = r;
+                first[label] = c;
+                touched.push_back(label);
+            }
+            last[label] = c;
+        }
+        for (int label : touched) {
+            outlines[label].emplace_back(first[label], r);
+            if (last[label] != first[label]) {
+                outlines[label].emplace_back(last[label], r);
+            }
+        }
+    }
+    return outlines;
+}
+
 } // anonymous namespace
 
 // ============================================================================
 // get_table_line (Python utils_table_line_rec.py)
 // Uses connected component analysis on the binary h/v pred mask,
 // extracts line segments as (x1,y1,x2,y2) from min-area rectangle.
+// binImg is at mask resolution; segments and the length filters are in
+// outSize (original crop) pixels.
 // ============================================================================
 std::vector<TableRecognizer::LineSeg> TableRecognizer::getTableLine(
-    const cv::Mat& binImg, int axis, int lineW)
+    const cv::Mat& binImg, int axis, int lineW, const cv::Size& outSize)
 {
+    const float sx = static_cast<float>(binImg.cols) / static_cast<float>(outSize.width);
+    const float sy = static_cast<float>(binImg.rows) / static_cast<float>(outSize.height);
+
     // Connected component analysis (Python: measure.label + regionprops)
     cv::Mat labels, stats, centroids;
     int numLabels = cv::connectedComponentsWithStats(binImg, labels, stats, centroids, 8);
 
+    // Python filter: axis=1(vertical): bbox height > lineW; axis=0(horizontal): bbox width > lineW
+    auto outlines = collectComponentOutlines(labels, stats, numLabels, [&](int i) {
+        if (axis == 1) return stats.at<int>(i, cv::CC_STAT_HEIGHT) / sy > lineW;
+        return stats.at<int>(i, cv::CC_STAT_WIDTH) / sx > lineW;
+    });
+
     std::vector<LineSeg> lines;
     for (int i = 1; i < numLabels; ++i) {
-        int bx = stats.at<int>(i, cv::CC_STAT_LEFT);
-        int by = stats.at<int>(i, cv::CC_STAT_TOP);
-        int bw = stats.at<int>(i, cv::CC_STAT_WIDTH);
-        int bh = stats.at<int>(i, cv::CC_STAT_HEIGHT);
-
-        // Python filter: axis=1(vertical): bbox height > lineW; axis=0(horizontal): bbox width > lineW
-        if (axis == 1 && bh <= lineW) continue;
-        if (axis == 0 && bw <= lineW) continue;
-
-        // Get the pixel coordinates of this component for minAreaRect
-        std::vector<cv::Point> coords;
-        for (int r = by; r < by + bh; ++r) {
-            const int* labelRow = labels.ptr<int>(r);
-            for (int c = bx; c < bx + bw; ++c) {
-                if (labelRow[c] == i) coords.emplace_back(c, r);
-            }
-        }
+        const auto& coords = outlines[i];
         if (coords.empty()) continue;
 
         // Python: min_area_rect(region.coords[:, ::-1]) — note coords are (row,col), reversed to (x,y)
         cv::RotatedRect rr = cv::minAreaRect(coords);
         cv::Point2f boxPts[4];
         rr.points(boxPts);
+        // Mask pixel centres → original crop pixel centres
         float rawBox[8];
-        for (int k = 0; k < 4; ++k) { rawBox[2*k] = boxPts[k].x; rawBox[2*k+1] = boxPts[k].y; }
+        for (int k = 0; k < 4; ++k) {
+            rawBox[2*k] = (boxPts[k].x + 0.5f) / sx - 0.5f;
+            rawBox[2*k+1] = (boxPts[k].y + 0.5f) / sy - 0.5f;
+        }
 
         // Order points: tl, tr, br, bl
         Pt2f pts4[4] = {{rawBox[0],rawBox[1]},{rawBox[2],rawBox[3]},{rawBox[4],rawBox[5]},{rawBox[6],rawBox[7]}};
@@ -197,7 +281,7 @@ std::vector<TableRecognizer::LineSeg> TableRecognizer::getTableLine(
         }
         // Drop very short segments to reduce spurious grid boundaries (table misalignment)
         float segLen = dist2({seg.x1, seg.y1}, {seg.x2, seg.y2});
-        int imgDim = (axis == 1) ? binImg.rows : binImg.cols;
+        int imgDim = (axis == 1) ? outSize.height : outSize.width;
         // Min length for vertical lines: 0.07 to target ~20 cols (Python); 0.06→25, 0.08/0.10→17
         float minRatio = (axis == 1) ? 0.07f : 0.06f;
         float minLen = std::max(static_cast<float>(lineW), minRatio * static_cast<float>(imgDim));
@@ -318,24 +402,15 @@ std::vector<TableRecognizer::Polygon8> TableRecognizer::extractCellPolygons(
     std::vector<Polygon8> polygons;
     float maxArea = static_cast<float>(H) * W * 0.75f;
 
-    for (int i = 1; i < numLabels; ++i) {
-        int bx = stats.at<int>(i, cv::CC_STAT_LEFT);
-        int by = stats.at<int>(i, cv::CC_STAT_TOP);
+    // Python: bbox_area > H * W * 3/4 → skip
+    auto outlines = collectComponentOutlines(labels, stats, numLabels, [&](int i) {
         int bw = stats.at<int>(i, cv::CC_STAT_WIDTH);
         int bh = stats.at<int>(i, cv::CC_STAT_HEIGHT);
-        int area = stats.at<int>(i, cv::CC_STAT_AREA);
-
-        // Python: bbox_area > H * W * 3/4 → skip
-        if (static_cast<float>(bw * bh) > maxArea) continue;
-
-        // Collect component pixel coords
-        std::vector<cv::Point> coords;
-        coords.reserve(area);
-        for (int r = by; r < by + bh; ++r) {
-            const int* lr = labels.ptr<int>(r);
-            for (int c = bx; c < bx + bw; ++c)
-                if (lr[c] == i) coords.emplace_back(c, r);
-        }
+        return static_cast<float>(bw * bh) <= maxArea;
+    });
+
+    for (int i = 1; i < numLabels; ++i) {
+        const auto& coords = outlines[i];
         if (coords.empty()) continue;
 
         cv::RotatedRect rr = cv::minAreaRect(coords);
@@ -554,39 +629,36 @@ void TableRecognizer::recoverTableStructure(
 // postprocessDxEngine — full pipeline matching Python _postprocess_dxengine
 // ============================================================================
 std::vector<TableCell> TableRecognizer::postprocessDxEngine(
-    const cv::Mat& /*img*/, const cv::Mat& pred,
-    float scale, int padTop, int padLeft, int origH, int origW)
+    const cv::Mat& /*img*/, const cv::Mat& hpred, const cv::Mat& vpred,
+    int origH, int origW)
 {
-    cv::Mat predU8 = pred.clone();
-
-    // Separate horizontal (1) and vertical (2) predictions
-    cv::Mat hpred = (predU8 == 1);
-    cv::Mat vpred = (predU8 == 2);
-
-    // Remove padding
-    int hEnd = std::min(padTop + static_cast<int>(origH * scale), predU8.rows);
-    int wEnd = std::min(padLeft + static_cast<int>(origW * scale), predU8.cols);
-    hpred = hpred(cv::Range(padTop, hEnd), cv::Range(padLeft, wEnd));
-    vpred = vpred(cv::Range(padTop, hEnd), cv::Range(padLeft, wEnd));
+    if (hpred.empty() || vpred.empty() || origH <= 0 || origW <= 0) return {};
 
     // Morphological kernel sizes (Python: sqrt(w)*1.2, sqrt(h)*1.2 on pred shape)
     int h = hpred.rows, w = hpred.cols;
     int hors_k = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(w)) * 1.2f));
     int vert_k = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(h)) * 1.2f));
 
-    // Resize to original
-    cv::resize(hpred, hpred, cv::Size(origW, origH));
-    cv::resize(vpred, vpred, cv::Size(origW, origH));
+    // Python resizes both masks to the original size and closes them there.
+    // Closing and line extraction run at mask resolution here instead, with
+    // the kernels scaled down to match; getTableLine() maps the segments back
+    // to original pixels.
+    const float sx = static_cast<float>(w) / static_cast<float>(origW);
+    const float sy = static_cast<float>(h) / static_cast<float>(origH);
+    const int horsKMask = std::max(1, static_cast<int>(std::lround(hors_k * sx)));
+    const int vertKMask = std::max(1, static_cast<int>(std::lround(vert_k * sy)));
 
     // Morphological operations
-    cv::Mat hKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(hors_k, 1));
-    cv::Mat vKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(1, vert_k));
-    cv::morphologyEx(vpred, vpred, cv::MORPH_CLOSE, vKernel, cv::Point(-1, -1), 1);
-    cv::morphologyEx(hpred, hpred, cv::MORPH_CLOSE, hKernel, cv::Point(-1, -1), 1);
+    cv::Mat hLines, vLines;
+    cv::Mat hKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(horsKMask, 1));
+    cv::Mat vKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(1, vertKMask));
+    cv::morphologyEx(vpred, vLines, cv::MORPH_CLOSE, vKernel, cv::Point(-1, -1), 1);
+    cv::morphologyEx(hpred, hLines, cv::MORPH_CLOSE, hKernel, cv::Point(-1, -1), 1);
 
     // Extract lines using get_table_line (Python defaults: row=50, col=30)
-    auto colboxes = getTableLine(vpred, 1, 30);  // vertical lines
-    auto rowboxes = getTableLine(hpred, 0, 50);  // horizontal lines
+    const cv::Size origSize(origW, origH);
+    auto colboxes = getTableLine(vLines, 1, 30, origSize);  // vertical lines
+    auto rowboxes = getTableLine(hLines, 0, 50, origSize);  // horizontal lines
 
     // adjust_lines: add bridge segments between nearby endpoints
     auto rboxesRow = adjustLines(rowboxes, 100.0f, 50.0f);
@@ -726,38 +798,78 @@ TableResult TableRecognizer::recognize(const cv::Mat& tableImage) {
     return finalizeRecognizePostprocess(tableImage, npuStage);
 }
 
-TableRecognizer::NpuStageResult TableRecognizer::recognizeNpuStage(const cv::Mat& tableImage) {
-    NpuStageResult npuStage;
-    auto tStart = std::chrono::steady_clock::now();
+namespace {
 
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * Narrow, split into h/v line classes and drop the letterbox padding in one
+ * pass over the int64 UNET output.
+ */
+void decodeNpuOutput(const dxrt::TensorPtrs& dxOutputs, int targetSize,
+                     BufferPool& maskPool, TableRecognizer::NpuStageResult& npuStage)
+{
+    auto& outTensor = dxOutputs[0];
+    int maskH = targetSize;
+    int maskW = targetSize;
+    auto& outShape = outTensor->shape();
+    if (outShape.size() >= 2) {
+        maskH = static_cast<int>(outShape[outShape.size() - 2]);
+        maskW = static_cast<int>(outShape[outShape.size() - 1]);
+    }
+
+    auto maskDecodeStart = std::chrono::steady_clock::now();
+    const int64_t* rawPtr = reinterpret_cast<const int64_t*>(outTensor->data());
+    const int cropTop = std::clamp(npuStage.padTop, 0, maskH);
+    const int cropLeft = std::clamp(npuStage.padLeft, 0, maskW);
+    const int cropBottom = std::clamp(
+        npuStage.padTop + static_cast<int>(npuStage.origH * npuStage.scale), cropTop, maskH);
+    const int cropRight = std::clamp(
+        npuStage.padLeft + static_cast<int>(npuStage.origW * npuStage.scale), cropLeft, maskW);
+    npuStage.hMask = maskPool.acquire(cropBottom - cropTop, cropRight - cropLeft, CV_8UC1);
+    npuStage.vMask = maskPool.acquire(cropBottom - cropTop, cropRight - cropLeft, CV_8UC1);
+    decodeTableLineMasks(
+        rawPtr + static_cast<size_t>(cropTop) * maskW + cropLeft, static_cast<size_t>(maskW),
+        npuStage.hMask.rows, npuStage.hMask.cols,
+        npuStage.hMask.data, npuStage.hMask.step,
+        npuStage.vMask.data, npuStage.vMask.step);
+    npuStage.maskDecodeMs = elapsedMs(maskDecodeStart);
+}
+
+}  // namespace
+
+bool TableRecognizer::prepareNpuStage(
+    const cv::Mat& tableImage, NpuStageResult& npuStage, cv::Mat& input)
+{
     if (tableImage.empty()) {
         npuStage.type = TableType::UNKNOWN;
         npuStage.supported = false;
-        npuStage.npuStageTimeMs = 0.0;
-        return npuStage;
+        return false;
     }
 
+    // Downscaled crops are resized to model scale once: the type estimate
+    // runs on that level and preprocess() letterboxes it without resizing again.
     auto estimateStart = std::chrono::steady_clock::now();
-    npuStage.type = estimateTableType(tableImage);
-    auto estimateEnd = std::chrono::steady_clock::now();
-    npuStage.estimateTableTypeMs =
-        std::chrono::duration<double, std::milli>(estimateEnd - estimateStart).count();
+    const cv::Size modelSize = modelResizeSize(tableImage);
+    cv::Mat level = tableImage;
+    if (modelSize.width < tableImage.cols) {
+        cv::resize(tableImage, level, modelSize, 0, 0, cv::INTER_AREA);
+    }
+    npuStage.type = estimateTableType(level, tableImage.size());
+    npuStage.estimateTableTypeMs = elapsedMs(estimateStart);
 
     if (npuStage.type == TableType::WIRELESS) {
         npuStage.supported = false;
-        auto tEnd = std::chrono::steady_clock::now();
-        npuStage.npuStageTimeMs =
-            std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-        return npuStage;
+        return false;
     }
 
     if (!initialized_) {
         LOG_ERROR("Table recognizer not initialized");
         npuStage.supported = false;
-        auto tEnd = std::chrono::steady_clock::now();
-        npuStage.npuStageTimeMs =
-            std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-        return npuStage;
+        return false;
     }
 
     npuStage.origH = tableImage.rows;
@@ -768,47 +880,105 @@ TableRecognizer::NpuStageResult TableRecognizer::recognizeNpuStage(const cv::Mat
     npuStage.padLeft = (targetSize - static_cast<int>(npuStage.origW * npuStage.scale)) / 2;
 
     auto preprocessStart = std::chrono::steady_clock::now();
-    cv::Mat preprocessed = preprocess(tableImage);
-    auto preprocessEnd = std::chrono::steady_clock::now();
-    npuStage.preprocessMs =
-        std::chrono::duration<double, std::milli>(preprocessEnd - preprocessStart).count();
+    preprocess(level, modelSize, input);
+    npuStage.preprocessMs = elapsedMs(preprocessStart);
+    return true;
+}
 
-    auto dxRunStart = std::chrono::steady_clock::now();
-    auto dxOutputs = impl_->dxEngine->Run(static_cast<void*>(preprocessed.data));
-    auto dxRunEnd = std::chrono::steady_clock::now();
-    npuStage.dxRunMs =
-        std::chrono::duration<double, std::milli>(dxRunEnd - dxRunStart).count();
+TableRecognizer::NpuStageResult TableRecognizer::recognizeNpuStage(const cv::Mat& tableImage) {
+    TRACE_SPAN("TableRecognizer::recognizeNpuStage", "table");
+    NpuStageResult npuStage;
+    auto tStart = std::chrono::steady_clock::now();
 
-    auto& outTensor = dxOutputs[0];
-    int maskH = targetSize;
-    int maskW = targetSize;
-    auto& outShape = outTensor->shape();
-    if (outShape.size() >= 2) {
-        maskH = static_cast<int>(outShape[outShape.size() - 2]);
-        maskW = static_cast<int>(outShape[outShape.size() - 1]);
+    cv::Mat input = impl_->inputPool.acquire(config_.inputSize, config_.inputSize, CV_8UC3);
+    if (!prepareNpuStage(tableImage, npuStage, input)) {
+        npuStage.npuStageTimeMs = tableImage.empty() ? 0.0 : elapsedMs(tStart);
+        return npuStage;
     }
 
-    auto maskDecodeStart = std::chrono::steady_clock::now();
-    const int64_t* rawPtr = reinterpret_cast<const int64_t*>(outTensor->data());
-    npuStage.mask = cv::Mat(maskH, maskW, CV_8UC1);
-    for (int i = 0; i < maskH * maskW; ++i) {
-        npuStage.mask.data[i] = static_cast<uint8_t>(rawPtr[i]);
-    }
-    auto maskDecodeEnd = std::chrono::steady_clock::now();
-    npuStage.maskDecodeMs =
-        std::chrono::duration<double, std::milli>(maskDecodeEnd - maskDecodeStart).count();
+    auto dxRunStart = std::chrono::steady_clock::now();
+    auto dxOutputs = impl_->dxEngine->Run(static_cast<void*>(input.data));
+    npuStage.dxRunMs = elapsedMs(dxRunStart);
+
+    decodeNpuOutput(dxOutputs, config_.inputSize, impl_->maskPool, npuStage);
 
     npuStage.supported = true;
-    auto tEnd = std::chrono::steady_clock::now();
-    npuStage.npuStageTimeMs =
-        std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+    npuStage.npuStageTimeMs = elapsedMs(tStart);
     return npuStage;
 }
 
+std::vector<TableRecognizer::NpuStageResult> TableRecognizer::recognizeNpuStageBatch(
+    const std::vector<cv::Mat>& tableImages)
+{
+    TRACE_SPAN("TableRecognizer::recognizeNpuStageBatch", "table");
+    std::vector<NpuStageResult> results(tableImages.size());
+    if (tableImages.size() == 1) {
+        results[0] = recognizeNpuStage(tableImages[0]);
+        return results;
+    }
+
+    struct InFlight {
+        size_t index = 0;
+        int jobId = -1;
+        cv::Mat input;
+        std::chrono::steady_clock::time_point submitted;
+        std::chrono::steady_clock::time_point started;
+    };
+    std::deque<InFlight> inFlight;
+
+    auto finishOldest = [&]() {
+        InFlight job = std::move(inFlight.front());
+        inFlight.pop_front();
+        NpuStageResult& npuStage = results[job.index];
+        auto dxOutputs = impl_->dxEngine->Wait(job.jobId);
+        npuStage.dxRunMs = elapsedMs(job.submitted);
+        decodeNpuOutput(dxOutputs, config_.inputSize, impl_->maskPool, npuStage);
+        npuStage.supported = true;
+        npuStage.npuStageTimeMs = elapsedMs(job.started);
+    };
+
+    try {
+        for (size_t i = 0; i < tableImages.size(); ++i) {
+            auto tStart = std::chrono::steady_clock::now();
+            InFlight job;
+            job.index = i;
+            job.started = tStart;
+            job.input = impl_->inputPool.acquire(config_.inputSize, config_.inputSize, CV_8UC3);
+            if (!prepareNpuStage(tableImages[i], results[i], job.input)) {
+                results[i].npuStageTimeMs = tableImages[i].empty() ? 0.0 : elapsedMs(tStart);
+                continue;
+            }
+
+            // The previous table is still running on the NPU while this one
+            // was preprocessed above.
+            job.submitted = std::chrono::steady_clock::now();
+            job.jobId = impl_->dxEngine->RunAsync(static_cast<void*>(job.input.data));
+            inFlight.push_back(std::move(job));
+            if (inFlight.size() >= kTableNpuPipelineDepth) {
+                finishOldest();
+            }
+        }
+        while (!inFlight.empty()) {
+            finishOldest();
+        }
+    } catch (...) {
+        // Drain submitted jobs so no input buffer is released while the NPU reads it.
+        for (auto& job : inFlight) {
+            try {
+                impl_->dxEngine->Wait(job.jobId);
+            } catch (...) {
+            }
+        }
+        throw;
+    }
+    return results;
+}
+
 TableResult TableRecognizer::finalizeRecognizePostprocess(
     const cv::Mat& tableImage,
     const NpuStageResult& npuStage)
 {
+    TRACE_SPAN("TableRecognizer::finalizeRecognizePostprocess", "table");
     TableResult result;
     result.type = npuStage.type;
 
@@ -833,10 +1003,8 @@ TableResult TableRecognizer::finalizeRecognizePostprocess(
     auto postprocessStart = std::chrono::steady_clock::now();
     result.cells = postprocessDxEngine(
         tableImage,
-        npuStage.mask,
-        npuStage.scale,
-        npuStage.padTop,
-        npuStage.padLeft,
+        npuStage.hMask,
+        npuStage.vMask,
         npuStage.origH,
         npuStage.origW);
     auto postprocessEnd = std::chrono::steady_clock::now();
@@ -863,24 +1031,86 @@ TableResult TableRecognizer::finalizeRecognizePostprocess(
 }
 
 // ============================================================================
-// estimateTableType (unchanged)
+// estimateTableType
 // ============================================================================
+namespace {
+
+// Edge maps are built at most this large; table rules survive the downscale.
+constexpr int kTableTypeMaxSide = 512;
+// Line pixels (in full-resolution units) per crop pixel above which a table is wired
+constexpr double kWiredLineRatio = 0.01;
+
+// Pixels of 8-bit mask row @p row that belong to non-zero runs of at least
+// @p minRun, i.e. what MORPH_OPEN with a 1 x minRun rectangle keeps.
+int countLongRuns(const uchar* row, int len, size_t step, int minRun) {
+    int kept = 0;
+    int run = 0;
+    for (int i = 0; i < len; ++i) {
+        if (row[static_cast<size_t>(i) * step] != 0) {
+            ++run;
+            continue;
+        }
+        if (run >= minRun) kept += run;
+        run = 0;
+    }
+    if (run >= minRun) kept += run;
+    return kept;
+}
+
+}  // namespace
+
 TableType TableRecognizer::estimateTableType(const cv::Mat& tableImage) {
-    if (tableImage.empty()) return TableType::UNKNOWN;
+    return estimateTableType(tableImage, tableImage.size());
+}
+
+TableType TableRecognizer::estimateTableType(const cv::Mat& level, const cv::Size& fullSize) {
+    if (level.empty() || fullSize.area() <= 0) return TableType::UNKNOWN;
+
+    cv::Mat small = level;
+    const int maxSide = std::max(level.rows, level.cols);
+    if (maxSide > kTableTypeMaxSide) {
+        const double f = static_cast<double>(kTableTypeMaxSide) / maxSide;
+        cv::resize(level, small, cv::Size(), f, f, cv::INTER_AREA);
+    }
     cv::Mat gray, edges;
-    cv::cvtColor(tableImage, gray, cv::COLOR_BGR2GRAY);
+    if (small.channels() == 3) {
+        cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = small;
+    }
     cv::Canny(gray, edges, 50, 150);
-    cv::Mat horizontal;
-    cv::Mat horizontalKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(tableImage.cols / 4, 1));
-    cv::morphologyEx(edges, horizontal, cv::MORPH_OPEN, horizontalKernel);
-    cv::Mat vertical;
-    cv::Mat verticalKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(1, tableImage.rows / 4));
-    cv::morphologyEx(edges, vertical, cv::MORPH_OPEN, verticalKernel);
-    int hLinePixels = cv::countNonZero(horizontal);
-    int vLinePixels = cv::countNonZero(vertical);
-    int totalPixels = tableImage.cols * tableImage.rows;
-    float lineRatio = static_cast<float>(hLinePixels + vLinePixels) / totalPixels;
-    return (lineRatio > 0.01f) ? TableType::WIRED : TableType::WIRELESS;
+
+    // Edge runs are counted at this level; dividing by the linear scale turns
+    // them back into full-resolution line lengths for the original threshold.
+    const double linearScale = static_cast<double>(edges.cols) / fullSize.width;
+    const double needed = kWiredLineRatio * fullSize.area() * linearScale;
+
+    // Opening only removes edge pixels, so too few edges is a sure reject.
+    const int edgePixels = cv::countNonZero(edges);
+    if (edgePixels <= needed) {
+        return TableType::WIRELESS;
+    }
+
+    // Per-row / per-column edge density bounds the longest run: lines shorter
+    // than a rule cannot hold one, so they are skipped without a scan.
+    cv::Mat rowSums, colSums;
+    cv::reduce(edges, rowSums, 1, cv::REDUCE_SUM, CV_32S);
+    cv::reduce(edges, colSums, 0, cv::REDUCE_SUM, CV_32S);
+    const int hRun = std::max(1, edges.cols / 4);
+    const int vRun = std::max(1, edges.rows / 4);
+
+    double linePixels = 0.0;
+    for (int r = 0; r < edges.rows; ++r) {
+        if (rowSums.at<int>(r, 0) / 255 < hRun) continue;
+        linePixels += countLongRuns(edges.ptr<uchar>(r), edges.cols, 1, hRun);
+        if (linePixels > needed) return TableType::WIRED;
+    }
+    for (int c = 0; c < edges.cols; ++c) {
+        if (colSums.at<int>(0, c) / 255 < vRun) continue;
+        linePixels += countLongRuns(edges.ptr<uchar>(0) + c, edges.rows, edges.step, vRun);
+        if (linePixels > needed) return TableType::WIRED;
+    }
+    return TableType::WIRELESS;
 }
 
 } // namespace rapid_doc
@@ -0,0 +1,337 @@
+/**
+ * @file bench_cpu_kernels.cpp
+ * @brief Google Benchmark suite for the CPU-only hot paths (rapiddoc_microbench).
+ *
+ * Replays the recorded tensors under test/fixtures (layout ONNX boxes, table
+ * UNET line masks) through the same code the pipeline runs after the NPU, so
+ * CPU regressions can be measured on any dev box without a device:
+ *
+ *   ./rapiddoc_microbench --benchmark_filter=Table
+ *
+ * Writer benchmarks use a synthetic document built from the decoded layout
+ * fixture, repeated over the page count given as the benchmark argument.
+ */
+
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+
+#include "npy_loader.h"
+#include "layout/layout_detector.h"
+#include "layout/layout_nms.h"
+#include "layout/layout_resize.h"
+#include "output/content_list.h"
+#include "output/markdown_writer.h"
+#include "output/result_json.h"
+#include "reading_order/xycut.h"
+#include "table/table_recognizer.h"
+#ifdef RAPIDDOC_MICROBENCH_HAS_PIPELINE
+#include "pipeline/doc_pipeline.h"
+#endif
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace rapid_doc;
+using namespace rapid_doc::test_utils;
+
+namespace rapid_doc {
+
+class TableRecognizerTestAccess {
+public:
+    static std::vector<TableCell> postprocessDxEngine(
+        TableRecognizer& recognizer,
+        const cv::Mat& hpred,
+        const cv::Mat& vpred,
+        int origH,
+        int origW)
+    {
+        return recognizer.postprocessDxEngine(cv::Mat(), hpred, vpred, origH, origW);
+    }
+};
+
+} // namespace rapid_doc
+
+namespace {
+
+const std::string kLayoutFixtureDir = std::string(PROJECT_ROOT_DIR) + "/test/fixtures/layout/";
+const std::string kTableFixtureDir = std::string(PROJECT_ROOT_DIR) + "/test/fixtures/table/";
+
+// Page the layout fixture was rendered at (preprocess_info.json).
+const cv::Size kLayoutPageSize(2383, 3500);
+// Table crop behind the UNET masks (table/preprocess_info.json).
+constexpr int kTableOrigH = 3500;
+constexpr int kTableOrigW = 2383;
+
+bool skipWithoutFixture(benchmark::State& state, const std::string& path) {
+    if (fs::exists(path)) {
+        return false;
+    }
+    state.SkipWithError(("missing fixture: " + path).c_str());
+    return true;
+}
+
+const NpyArray& layoutRawBoxes() {
+    static const NpyArray boxes = loadNpy(kLayoutFixtureDir + "onnx_boxes_raw.npy");
+    return boxes;
+}
+
+int rawBoxCount(const NpyArray& boxes) {
+    return boxes.shape.empty() ? 0 : static_cast<int>(boxes.shape[0]);
+}
+
+cv::Mat loadMask(const std::string& path) {
+    const NpyArray mask = loadNpy(path);
+    if (mask.shape.size() < 2) {
+        throw std::runtime_error("expected a 2-D mask: " + path);
+    }
+    const int rows = static_cast<int>(mask.shape[mask.shape.size() - 2]);
+    const int cols = static_cast<int>(mask.shape[mask.shape.size() - 1]);
+    return cv::Mat(rows, cols, CV_8UC1, const_cast<uint8_t*>(mask.asUint8())).clone();
+}
+
+std::vector<TableCell> fixtureTableCells() {
+    TableRecognizer recognizer(TableRecognizerConfig{});
+    return TableRecognizerTestAccess::postprocessDxEngine(
+        recognizer,
+        loadMask(kTableFixtureDir + "hpred.npy"),
+        loadMask(kTableFixtureDir + "vpred.npy"),
+        kTableOrigH,
+        kTableOrigW);
+}
+
+ContentElement::Type elementTypeFor(LayoutCategory category) {
+    switch (category) {
+        case LayoutCategory::TITLE: return ContentElement::Type::TITLE;
+        case LayoutCategory::FIGURE: return ContentElement::Type::IMAGE;
+        case LayoutCategory::TABLE: return ContentElement::Type::TABLE;
+        case LayoutCategory::EQUATION: return ContentElement::Type::EQUATION;
+        case LayoutCategory::HEADER: return ContentElement::Type::HEADER;
+        case LayoutCategory::FOOTER: return ContentElement::Type::FOOTER;
+        default: return ContentElement::Type::TEXT;
+    }
+}
+
+// The decoded layout fixture as @p pages identical pages of finished elements.
+DocumentResult syntheticDocument(int pages) {
+    const NpyArray& raw = layoutRawBoxes();
+    const std::vector<LayoutBox> boxes =
+        LayoutDetector::decodeBoxes(raw.asFloat32(), rawBoxCount(raw), kLayoutPageSize);
+    const std::vector<int> order = xycutPlusSort(boxes, kLayoutPageSize.width, kLayoutPageSize.height);
+
+    DocumentResult doc;
+    for (int p = 0; p < pages; ++p) {
+        PageResult page;
+        page.pageIndex = p;
+        page.pageWidth = kLayoutPageSize.width;
+        page.pageHeight = kLayoutPageSize.height;
+        page.layoutResult.boxes = boxes;
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            const LayoutBox& box = boxes[static_cast<size_t>(order[rank])];
+            ContentElement elem;
+            elem.type = elementTypeFor(box.category);
+            elem.layoutBox = box;
+            elem.pageIndex = p;
+            elem.readingOrder = static_cast<int>(rank);
+            elem.confidence = box.confidence;
+            if (elem.type == ContentElement::Type::TABLE) {
+                elem.html = "<table><tr><td>cell</td><td>\"quoted\" &amp; cell</td></tr></table>";
+            } else if (elem.type == ContentElement::Type::IMAGE) {
+                elem.imagePath = "images/page_" + std::to_string(p) + "_" + std::to_string(rank) + ".png";
+            } else {
+                elem.text = "Recognized line of body text, with punctuation; and some\n"
+                            "文字 in a second script to exercise UTF-8 escaping.";
+            }
+            page.elements.push_back(std::move(elem));
+        }
+        doc.pages.push_back(std::move(page));
+    }
+    doc.totalPages = pages;
+    doc.processedPages = pages;
+    return doc;
+}
+
+// ---------------------------------------------------------------------------
+// Layout decode
+// ---------------------------------------------------------------------------
+
+void BM_LayoutNms(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const NpyArray& raw = layoutRawBoxes();
+    LayoutCandidates candidates;
+    const int count = rawBoxCount(raw);
+    candidates.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        candidates.push(raw.asFloat32() + i * 6);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(layoutNms(candidates, 0.6f, 0.98f));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_LayoutNms);
+
+void BM_LayoutDecodeBoxes(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const NpyArray& raw = layoutRawBoxes();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            LayoutDetector::decodeBoxes(raw.asFloat32(), rawBoxCount(raw), kLayoutPageSize));
+    }
+}
+BENCHMARK(BM_LayoutDecodeBoxes);
+
+// Layout input resize of a synthetic 200 DPI A4 page: INTER_CUBIC (0) vs box filter (1).
+void BM_LayoutResize(benchmark::State& state) {
+    cv::Mat page(2339, 1654, CV_8UC3);
+    cv::randu(page, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat input(640, 640, CV_8UC3);
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            cv::resize(page, input, input.size(), 0, 0, cv::INTER_CUBIC);
+        } else {
+            resizeAreaInto(page, input, input.size());
+        }
+        benchmark::DoNotOptimize(input.data);
+    }
+}
+BENCHMARK(BM_LayoutResize)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// ---------------------------------------------------------------------------
+// Reading order
+// ---------------------------------------------------------------------------
+
+void BM_XycutPlusSort(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const NpyArray& raw = layoutRawBoxes();
+    const std::vector<LayoutBox> boxes =
+        LayoutDetector::decodeBoxes(raw.asFloat32(), rawBoxCount(raw), kLayoutPageSize);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            xycutPlusSort(boxes, kLayoutPageSize.width, kLayoutPageSize.height));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(boxes.size()));
+}
+BENCHMARK(BM_XycutPlusSort);
+
+// ---------------------------------------------------------------------------
+// Table post-processing
+// ---------------------------------------------------------------------------
+
+void BM_TablePostprocessDxEngine(benchmark::State& state) {
+    if (skipWithoutFixture(state, kTableFixtureDir + "hpred.npy") ||
+        skipWithoutFixture(state, kTableFixtureDir + "vpred.npy")) {
+        return;
+    }
+    const cv::Mat hpred = loadMask(kTableFixtureDir + "hpred.npy");
+    const cv::Mat vpred = loadMask(kTableFixtureDir + "vpred.npy");
+    TableRecognizer recognizer(TableRecognizerConfig{});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TableRecognizerTestAccess::postprocessDxEngine(
+            recognizer, hpred, vpred, kTableOrigH, kTableOrigW));
+    }
+}
+BENCHMARK(BM_TablePostprocessDxEngine)->Unit(benchmark::kMillisecond);
+
+void BM_TableGenerateHtml(benchmark::State& state) {
+    if (skipWithoutFixture(state, kTableFixtureDir + "hpred.npy")) {
+        return;
+    }
+    const std::vector<TableCell> cells = fixtureTableCells();
+    TableRecognizer recognizer(TableRecognizerConfig{});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(recognizer.generateHtml(cells));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(cells.size()));
+}
+BENCHMARK(BM_TableGenerateHtml);
+
+#ifdef RAPIDDOC_MICROBENCH_HAS_PIPELINE
+// One OCR line per cell, inset so each overlaps its own cell the most.
+void BM_MatchTableOcrToCells(benchmark::State& state) {
+    if (skipWithoutFixture(state, kTableFixtureDir + "hpred.npy")) {
+        return;
+    }
+    TableResult table;
+    table.cells = fixtureTableCells();
+    std::vector<ocr::PipelineOCRResult> lines;
+    lines.reserve(table.cells.size());
+    for (const auto& cell : table.cells) {
+        const float insetX = (cell.x1 - cell.x0) * 0.1f;
+        const float insetY = (cell.y1 - cell.y0) * 0.1f;
+        ocr::PipelineOCRResult line;
+        line.text = "cell text";
+        line.confidence = 0.99f;
+        line.box = {
+            cv::Point2f(cell.x0 + insetX, cell.y0 + insetY),
+            cv::Point2f(cell.x1 - insetX, cell.y0 + insetY),
+            cv::Point2f(cell.x1 - insetX, cell.y1 - insetY),
+            cv::Point2f(cell.x0 + insetX, cell.y1 - insetY),
+        };
+        lines.push_back(std::move(line));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        TableResult filled = table;
+        state.ResumeTiming();
+        matchTableOcrToCells(filled, lines);
+        benchmark::DoNotOptimize(filled);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines.size()));
+}
+BENCHMARK(BM_MatchTableOcrToCells);
+#endif
+
+// ---------------------------------------------------------------------------
+// Output writers
+// ---------------------------------------------------------------------------
+
+void BM_MarkdownWriter(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const DocumentResult doc = syntheticDocument(static_cast<int>(state.range(0)));
+    const MarkdownWriter writer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writer.generate(doc));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MarkdownWriter)->Arg(1)->Arg(16);
+
+void BM_ContentListWriter(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const DocumentResult doc = syntheticDocument(static_cast<int>(state.range(0)));
+    const ContentListWriter writer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writer.generate(doc));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ContentListWriter)->Arg(1)->Arg(16);
+
+void BM_BuildMiddleJson(benchmark::State& state) {
+    if (skipWithoutFixture(state, kLayoutFixtureDir + "onnx_boxes_raw.npy")) {
+        return;
+    }
+    const DocumentResult doc = syntheticDocument(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(buildMiddleJson(doc).dump());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildMiddleJson)->Arg(1)->Arg(16);
+
+} // namespace
+
+BENCHMARK_MAIN();
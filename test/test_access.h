@@ -20,9 +20,7 @@ public:
     static void clearOcrHooks(DocPipeline& pipeline) {
         pipeline.ocrSubmitHook_ = {};
         pipeline.ocrFetchHook_ = {};
-        std::lock_guard<std::mutex> lock(pipeline.ocrStateMutex_);
-        pipeline.bufferedOcrResults_.clear();
-        pipeline.timedOutOcrTaskIds_.clear();
+        pipeline.ocrCompletions_.clear();
     }
 
     static void setTableHooks(
@@ -39,6 +37,13 @@ public:
         pipeline.tableHtmlHook_ = {};
     }
 
+    static void setLayoutDetectHook(
+        DocPipeline& pipeline,
+        std::function<LayoutResult(const cv::Mat&)> detectHook)
+    {
+        pipeline.layoutDetectHook_ = std::move(detectHook);
+    }
+
     static void setOcrTimeout(DocPipeline& pipeline, std::chrono::milliseconds timeout) {
         if (timeout.count() <= 0) {
             pipeline.ocrWaitTimeout_ = std::chrono::milliseconds(1);
@@ -51,6 +56,23 @@ public:
         return pipeline.ocrOnCrop(crop, taskId);
     }
 
+    static std::unordered_map<int64_t, std::string> waitForOcrBatch(
+        DocPipeline& pipeline,
+        const std::vector<int64_t>& taskIds)
+    {
+        std::unordered_map<int64_t, DocPipeline::BufferedOcrResult> completed;
+        pipeline.waitForOcrResults(taskIds, completed);
+        std::unordered_map<int64_t, std::string> texts;
+        for (auto& entry : completed) {
+            std::string text;
+            for (const auto& line : entry.second.results) {
+                text += line.text;
+            }
+            texts[entry.first] = text;
+        }
+        return texts;
+    }
+
     static std::vector<ContentElement> runOcrOnRegions(
         DocPipeline& pipeline,
         const cv::Mat& image,
@@ -87,6 +109,57 @@ public:
         pipeline.saveExtractedImages(image, figureBoxes, pageIndex, elements);
     }
 
+    static DocumentResult runPagePipeline(
+        DocPipeline& pipeline,
+        std::vector<PageImage> pages)
+    {
+        DocumentResult result;
+        const int planned = static_cast<int>(pages.size());
+        const auto ctx = pipeline.makeExecutionContext(nullptr);
+        DocPipeline::DocumentOutput output(ctx);
+        pipeline.runPagePipeline(
+            [&pages, planned](const DocPipeline::PageSink& sink) {
+                for (auto& page : pages) {
+                    if (!sink(std::move(page), planned)) {
+                        break;
+                    }
+                }
+            },
+            ctx,
+            result,
+            output);
+        output.finish(result);
+        return result;
+    }
+
+    static DocumentResult runPagesAcross(
+        const std::vector<DocPipeline*>& pipelines,
+        std::vector<PageImage> pages,
+        const PipelineRunOverrides& overrides,
+        std::vector<PageStageStats>* pipelineStats = nullptr)
+    {
+        DocumentResult result;
+        const int planned = static_cast<int>(pages.size());
+        const auto ctx = pipelines.front()->makeExecutionContext(&overrides);
+        DocPipeline::DocumentOutput output(ctx);
+        DocPipeline::processRenderedPagesAcross(
+            pipelines,
+            [&pages, planned](const DocPipeline::PageSink& sink) {
+                for (auto& page : pages) {
+                    if (!sink(std::move(page), planned)) {
+                        break;
+                    }
+                }
+            },
+            ctx,
+            overrides,
+            result,
+            output,
+            pipelineStats);
+        output.finish(result);
+        return result;
+    }
+
     static void saveFormulaImages(
         DocPipeline& pipeline,
         const cv::Mat& image,
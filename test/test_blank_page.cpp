@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "pipeline/blank_page.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace rapid_doc;
+
+namespace {
+
+cv::Mat makePage(int gray) {
+    return cv::Mat(1100, 850, CV_8UC3, cv::Scalar::all(gray));
+}
+
+} // namespace
+
+TEST(BlankPageTest, EmptyScansHaveNoInk) {
+    cv::Mat page = makePage(255);
+    EXPECT_DOUBLE_EQ(pageInkRatio(page), 0.0);
+
+    // Grey paper with dust specks and a dark scan edge inside the margin.
+    page = makePage(190);
+    for (int i = 0; i < 200; ++i) {
+        page.at<cv::Vec3b>((i * 97) % page.rows, (i * 61) % page.cols) = cv::Vec3b(0, 0, 0);
+    }
+    page(cv::Rect(0, 0, 20, page.rows)).setTo(cv::Scalar::all(0));
+    EXPECT_LT(pageInkRatio(page), 0.001);
+}
+
+TEST(BlankPageTest, TextAndDarkPagesAreNotBlank) {
+    cv::Mat page = makePage(245);
+    for (int line = 0; line < 10; ++line) {
+        page(cv::Rect(100, 150 + line * 40, 600, 12)).setTo(cv::Scalar::all(20));
+    }
+    EXPECT_GT(pageInkRatio(page), 0.01);
+
+    // A single short line still clears a typical threshold.
+    page = makePage(245);
+    page(cv::Rect(300, 500, 200, 10)).setTo(cv::Scalar::all(30));
+    EXPECT_GT(pageInkRatio(page), 0.001);
+
+    // No light background to judge against: never blank.
+    EXPECT_DOUBLE_EQ(pageInkRatio(makePage(40)), 1.0);
+    EXPECT_DOUBLE_EQ(pageInkRatio(cv::Mat()), 1.0);
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "common/bounded_queue.h"
+
+#include <thread>
+#include <vector>
+
+using namespace rapid_doc;
+
+TEST(BoundedQueueTest, preservesFifoOrderAcrossThreads) {
+    BoundedQueue<int> queue(2);
+    std::thread producer([&queue]() {
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(queue.push(i));
+        }
+        queue.close();
+    });
+
+    std::vector<int> received;
+    int value = 0;
+    while (queue.pop(value)) {
+        EXPECT_LE(queue.size(), queue.capacity());
+        received.push_back(value);
+    }
+    producer.join();
+
+    ASSERT_EQ(received.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(received[i], i);
+    }
+}
+
+TEST(BoundedQueueTest, closeDrainsOrDiscardsPendingItems) {
+    BoundedQueue<int> drained(4);
+    ASSERT_TRUE(drained.push(1));
+    ASSERT_TRUE(drained.push(2));
+    drained.close();
+    EXPECT_FALSE(drained.push(3));
+
+    int value = 0;
+    ASSERT_TRUE(drained.pop(value));
+    EXPECT_EQ(value, 1);
+    ASSERT_TRUE(drained.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(drained.pop(value));
+
+    BoundedQueue<int> discarded(4);
+    ASSERT_TRUE(discarded.push(1));
+    discarded.close(true);
+    EXPECT_FALSE(discarded.pop(value));
+}
+
+TEST(BoundedQueueTest, tryPopReturnsOnlyQueuedItems) {
+    BoundedQueue<int> queue(2);
+    int value = 0;
+    EXPECT_FALSE(queue.tryPop(value));
+
+    ASSERT_TRUE(queue.push(7));
+    ASSERT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(value, 7);
+    EXPECT_FALSE(queue.tryPop(value));
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "common/buffer_pool.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace rapid_doc;
+
+TEST(BufferPoolTest, RecyclesBufferOnceLastReferenceDrops) {
+    BufferPool pool(1 << 20);
+    const uchar* first = nullptr;
+    {
+        cv::Mat a = pool.acquire(32, 32, CV_8UC3);
+        ASSERT_EQ(a.rows, 32);
+        ASSERT_EQ(a.cols, 32);
+        ASSERT_EQ(a.type(), CV_8UC3);
+        EXPECT_TRUE(a.isContinuous());
+        first = a.data;
+    }
+    cv::Mat b = pool.acquire(30, 30, CV_8UC3);  // same power-of-two bucket
+    EXPECT_EQ(b.data, first);
+
+    const auto stats = pool.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST(BufferPoolTest, DoesNotReuseBufferStillReferenced) {
+    BufferPool pool(1 << 20);
+    cv::Mat a = pool.acquire(16, 16, CV_8UC1);
+    cv::Mat alias = a;
+    a.release();
+    cv::Mat b = pool.acquire(16, 16, CV_8UC1);
+    EXPECT_NE(b.data, alias.data);
+    EXPECT_EQ(pool.stats().misses, 2u);
+}
+
+TEST(BufferPoolTest, CopyOfIsContinuousDeepCopy) {
+    BufferPool pool(1 << 20);
+    cv::Mat page(64, 64, CV_8UC3, cv::Scalar(1, 2, 3));
+    cv::Mat roi = page(cv::Rect(8, 8, 20, 10));
+    cv::Mat copy = pool.copyOf(roi);
+    EXPECT_TRUE(copy.isContinuous());
+    EXPECT_EQ(copy.size(), roi.size());
+    EXPECT_NE(copy.data, roi.data);
+    EXPECT_EQ(cv::norm(copy, roi, cv::NORM_INF), 0.0);
+}
+
+TEST(BufferPoolTest, TracksHighWaterAndRetainedBudget) {
+    const size_t bucket = BufferPool::capacityFor(64, 64, CV_8UC1);
+    BufferPool pool(bucket);
+    {
+        cv::Mat a = pool.acquire(64, 64, CV_8UC1);
+        cv::Mat b = pool.acquire(64, 64, CV_8UC1);
+        const auto busy = pool.stats();
+        EXPECT_EQ(busy.inUseBytes, 2 * bucket);
+        EXPECT_EQ(busy.inUseHighWaterBytes, 2 * bucket);
+    }
+    const auto idle = pool.stats();
+    EXPECT_EQ(idle.inUseBytes, 0u);
+    EXPECT_EQ(idle.inUseHighWaterBytes, 2 * bucket);
+    EXPECT_EQ(idle.retainedBytes, bucket);  // the second buffer is over budget and freed
+}
+
+TEST(BufferPoolTest, ZeroBudgetAndNonByteTypesAllocate) {
+    BufferPool off(0);
+    off.acquire(8, 8, CV_8UC1);
+    off.acquire(8, 8, CV_8UC1);
+    EXPECT_EQ(off.stats().hits, 0u);
+
+    BufferPool pool(1 << 20);
+    cv::Mat f = pool.acquire(8, 8, CV_32FC1);
+    EXPECT_EQ(f.type(), CV_32FC1);
+    EXPECT_EQ(pool.stats().inUseBytes, 0u);
+}
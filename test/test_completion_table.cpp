@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "common/completion_table.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace rapid_doc;
+
+using Table = CompletionTable<std::string>;
+
+TEST(CompletionTableTest, ResultDeliveredBeforeWatchIsKept) {
+    Table table(8);
+    EXPECT_TRUE(table.complete(5, "early"));
+
+    Table::Waiter waiter;
+    EXPECT_EQ(table.watch(5, waiter), Table::Status::READY);
+    std::string result;
+    EXPECT_EQ(table.take(5, result), Table::Status::READY);
+    EXPECT_EQ(result, "early");
+    EXPECT_EQ(table.take(5, result), Table::Status::LOST);
+    EXPECT_FALSE(table.complete(5, "duplicate"));
+}
+
+TEST(CompletionTableTest, CompletionWakesOnlyItsWaiter) {
+    Table table(8);
+    Table::Waiter first;
+    Table::Waiter second;
+    ASSERT_EQ(table.watch(1, first), Table::Status::PENDING);
+    ASSERT_EQ(table.watch(2, second), Table::Status::PENDING);
+
+    std::thread producer([&table] { table.complete(2, "two"); });
+    EXPECT_TRUE(second.waitFor(std::chrono::seconds(5)));
+    producer.join();
+    EXPECT_FALSE(first.waitFor(std::chrono::milliseconds(1)));
+
+    std::string result;
+    EXPECT_EQ(table.take(1, result), Table::Status::PENDING);
+    EXPECT_EQ(table.take(2, result), Table::Status::READY);
+    EXPECT_EQ(result, "two");
+}
+
+TEST(CompletionTableTest, AbandonedAndRecycledIdsAreStale) {
+    Table table(4);
+    Table::Waiter waiter;
+    ASSERT_EQ(table.watch(3, waiter), Table::Status::PENDING);
+    table.abandon(3);
+    EXPECT_FALSE(table.complete(3, "late"));
+
+    // 6 shares 2's slot: the newer id wins and a waiter on the older one is lost.
+    ASSERT_EQ(table.watch(2, waiter), Table::Status::PENDING);
+    EXPECT_TRUE(table.complete(6, "newer"));
+    EXPECT_TRUE(waiter.waitFor(std::chrono::milliseconds(1)));
+    std::string result;
+    EXPECT_EQ(table.take(2, result), Table::Status::LOST);
+    EXPECT_FALSE(table.complete(2, "older"));
+    EXPECT_EQ(table.watch(2, waiter), Table::Status::LOST);
+    EXPECT_EQ(table.take(6, result), Table::Status::READY);
+    EXPECT_EQ(result, "newer");
+}
+
+TEST(CompletionTableTest, OneDrainerAtATime) {
+    Table table;
+    EXPECT_TRUE(table.tryBeginDrain());
+    EXPECT_FALSE(table.tryBeginDrain());
+    table.endDrain();
+    EXPECT_TRUE(table.tryBeginDrain());
+}
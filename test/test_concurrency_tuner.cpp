@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "server/concurrency_tuner.h"
+
+using namespace rapid_doc;
+
+namespace {
+
+ConcurrencyTunerConfig tunerConfig() {
+    ConcurrencyTunerConfig config;
+    config.enabled = true;
+    config.targetP95Seconds = 2.0;
+    config.maxOcrLanes = 2;
+    config.maxBatchDelayMs = 4;
+    return config;
+}
+
+TunerKnobs knobs(int inflight, int ocrLanes, int batchDelayMs) {
+    TunerKnobs result;
+    result.inflight = inflight;
+    result.ocrLanes = ocrLanes;
+    result.batchDelayMs = batchDelayMs;
+    return result;
+}
+
+} // namespace
+
+TEST(ConcurrencyTunerTest, HalvesOnServiceLatencyOverTarget) {
+    TunerWindow window;
+    window.completed = 10;
+    window.requestP95Seconds = 3.0;
+    window.queueP95Seconds = 0.2;
+    const TunerDecision decision = tuneConcurrency(knobs(4, 2, 4), window, tunerConfig(), 4);
+    EXPECT_EQ(decision.knobs, knobs(2, 2, 2));
+    EXPECT_NE(decision.reason.find("over target"), std::string::npos);
+
+    // Latency spent in the queue is not contention; too few requests is no verdict.
+    window.queueP95Seconds = 2.0;
+    EXPECT_EQ(tuneConcurrency(knobs(4, 2, 4), window, tunerConfig(), 4).knobs.inflight, 4);
+    window.queueP95Seconds = 0.2;
+    window.completed = 2;
+    EXPECT_EQ(tuneConcurrency(knobs(4, 2, 4), window, tunerConfig(), 4).knobs.inflight, 4);
+}
+
+TEST(ConcurrencyTunerTest, AddsConcurrencyWhileTheNpuHasRoom) {
+    TunerWindow window;
+    window.completed = 10;
+    window.queued = 3;
+    window.requestP95Seconds = 1.0;
+    window.npuBusyShare = 0.3;
+    const ConcurrencyTunerConfig config = tunerConfig();
+
+    EXPECT_EQ(tuneConcurrency(knobs(1, 1, 2), window, config, 2).knobs, knobs(2, 1, 2));
+    EXPECT_EQ(tuneConcurrency(knobs(2, 1, 2), window, config, 2).knobs, knobs(2, 2, 2));
+    EXPECT_EQ(tuneConcurrency(knobs(2, 2, 2), window, config, 2).knobs, knobs(2, 2, 2));
+}
+
+TEST(ConcurrencyTunerTest, BatchWindowFollowsNpuSaturation) {
+    TunerWindow window;
+    window.queued = 3;
+    window.npuBusyShare = 0.95;
+    const ConcurrencyTunerConfig config = tunerConfig();
+    EXPECT_EQ(tuneConcurrency(knobs(2, 1, 3), window, config, 2).knobs, knobs(2, 1, 4));
+    EXPECT_EQ(tuneConcurrency(knobs(2, 1, 4), window, config, 2).knobs, knobs(2, 1, 4));
+    EXPECT_EQ(tuneConcurrency(knobs(2, 1, -1), window, config, 2).knobs, knobs(2, 1, -1));
+
+    window.queued = 0;
+    window.npuBusyShare = 0.1;
+    EXPECT_EQ(tuneConcurrency(knobs(2, 1, 3), window, config, 2).knobs, knobs(2, 1, 2));
+}
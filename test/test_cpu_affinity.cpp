@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "common/cpu_affinity.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+namespace fs = std::filesystem;
+
+TEST(CpuAffinityTest, CpuListsRoundTrip) {
+    EXPECT_EQ(parseCpuList("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parseCpuList("5,1-2,2\n"), (std::vector<int>{1, 2, 5}));
+    EXPECT_TRUE(parseCpuList("").empty());
+    EXPECT_EQ(formatCpuList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+    EXPECT_EQ(formatCpuList({}), "");
+}
+
+TEST(CpuAffinityTest, DeviceNodeCpusComeFromSysfs) {
+    const fs::path root = fs::temp_directory_path() / "rapiddoc_cpu_affinity_sysfs";
+    fs::remove_all(root);
+    fs::create_directories(root / "class/dxrt/dxrt1/device");
+    fs::create_directories(root / "devices/system/node/node1");
+    std::ofstream(root / "class/dxrt/dxrt1/device/numa_node") << "1\n";
+    std::ofstream(root / "devices/system/node/node1/cpulist") << "16-19,48\n";
+
+    EXPECT_EQ(deviceNumaNode(1, root.string()), 1);
+    EXPECT_EQ(deviceNumaNode(0, root.string()), -1);
+    EXPECT_EQ(deviceNumaNode(-1, root.string()), -1);
+    EXPECT_EQ(numaNodeCpus(1, root.string()), (std::vector<int>{16, 17, 18, 19, 48}));
+    EXPECT_TRUE(numaNodeCpus(-1, root.string()).empty());
+    EXPECT_TRUE(pinCurrentThread({}));
+    fs::remove_all(root);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "server/device_health.h"
+
+using namespace rapid_doc;
+
+namespace {
+
+DeviceTelemetry sample(int temperatureC, int clockMhz, int peakClockMhz = 1000) {
+    DeviceTelemetry telemetry;
+    telemetry.deviceId = 0;
+    telemetry.memoryTotalBytes = 4ull << 30;
+    telemetry.temperatureC = temperatureC;
+    telemetry.npuClockMhz = clockMhz;
+    telemetry.peakNpuClockMhz = peakClockMhz;
+    return telemetry;
+}
+
+} // namespace
+
+TEST(DeviceHealthTest, OverheatingPausesWithHysteresis) {
+    DeviceAdmissionLimits limits;
+    limits.maxTemperatureC = 90;
+
+    EXPECT_EQ(assessDevice(sample(85, 1000), limits), DeviceHealth::OK);
+    EXPECT_EQ(assessDevice(sample(90, 1000), limits), DeviceHealth::OVERHEATED);
+    EXPECT_EQ(assessDevice(sample(87, 1000), limits, DeviceHealth::OVERHEATED), DeviceHealth::OVERHEATED);
+    EXPECT_EQ(assessDevice(sample(84, 1000), limits, DeviceHealth::OVERHEATED), DeviceHealth::OK);
+    EXPECT_EQ(admissionState(DeviceHealth::OVERHEATED), WorkerState::PAUSED);
+}
+
+TEST(DeviceHealthTest, LowClockIsThrottlingOnlyWhenWarm) {
+    const DeviceAdmissionLimits limits;
+    EXPECT_EQ(assessDevice(sample(45, 400), limits), DeviceHealth::OK);
+    EXPECT_EQ(assessDevice(sample(75, 400), limits), DeviceHealth::THROTTLED);
+    EXPECT_EQ(assessDevice(sample(75, 900), limits), DeviceHealth::OK);
+    EXPECT_EQ(admissionState(DeviceHealth::THROTTLED), WorkerState::DEGRADED);
+    EXPECT_EQ(admissionState(DeviceHealth::OK), WorkerState::ACTIVE);
+}
+
+TEST(DeviceHealthTest, MemoryPressureNeedsReportedUsage) {
+    const DeviceAdmissionLimits limits;
+    DeviceTelemetry telemetry = sample(50, 1000);
+    EXPECT_EQ(assessDevice(telemetry, limits), DeviceHealth::OK);
+
+    telemetry.memoryLastUsedBytes = telemetry.memoryTotalBytes - (64ull << 20);
+    EXPECT_EQ(assessDevice(telemetry, limits), DeviceHealth::MEMORY_PRESSURE);
+    EXPECT_EQ(admissionState(DeviceHealth::MEMORY_PRESSURE), WorkerState::PAUSED);
+}
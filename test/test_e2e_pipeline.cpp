@@ -300,7 +300,7 @@ TEST_F(E2ENoDxrtPipelineTest, RenderOnlyPdfContentListShapeMatchesPages) {
     ASSERT_TRUE(pipeline_->initialize());
     const auto result = pipeline_->processPdf(kPdfFixture);
 
-    const auto contentList = json::parse(result.contentListJson);
+    const auto contentList = json::parse(ContentListWriter().generate(result));
     ASSERT_TRUE(contentList.is_array());
     EXPECT_EQ(static_cast<int>(contentList.size()), result.processedPages);
     for (const auto& pageItems : contentList) {
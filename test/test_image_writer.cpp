@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include "output/image_writer.h"
+#include "pipeline/recognition_cache.h"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+namespace fs = std::filesystem;
+
+namespace {
+
+cv::Mat makeGradient(int rows, int cols) {
+    cv::Mat image(rows, cols, CV_8UC3);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            image.at<cv::Vec3b>(r, c) = cv::Vec3b(
+                static_cast<uchar>(r * 3), static_cast<uchar>(c * 5), static_cast<uchar>(r + c));
+        }
+    }
+    return image;
+}
+
+fs::path makeTempDir(const std::string& name) {
+    const fs::path dir = fs::temp_directory_path() / ("rapiddoc_image_writer_" + name);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+} // namespace
+
+TEST(ImageEncodingTest, ParsesFormatsAndFallsBackToPng) {
+    ImageEncoding encoding;
+    EXPECT_TRUE(ImageEncoding::parse("JPEG", 80, encoding));
+    EXPECT_EQ(encoding.codec, ImageCodec::JPEG);
+    EXPECT_STREQ(encoding.extension(), ".jpg");
+    EXPECT_EQ(encoding.params(), (std::vector<int>{cv::IMWRITE_JPEG_QUALITY, 80}));
+
+    EXPECT_TRUE(ImageEncoding::parse("webp", -1, encoding));
+    EXPECT_STREQ(encoding.extension(), ".webp");
+
+    EXPECT_FALSE(ImageEncoding::parse("gif", 3, encoding));
+    EXPECT_EQ(encoding.codec, ImageCodec::PNG);
+    EXPECT_EQ(encoding.params(), (std::vector<int>{cv::IMWRITE_PNG_COMPRESSION, 3}));
+}
+
+TEST(ImageEncodingTest, PngRoundTripsLosslessly) {
+    const cv::Mat image = makeGradient(17, 23);
+    ImageEncoding encoding;
+    std::vector<uint8_t> bytes;
+    ASSERT_TRUE(encoding.encode(image, bytes));
+
+    const cv::Mat decoded = cv::imdecode(bytes, cv::IMREAD_COLOR);
+    ASSERT_EQ(decoded.size(), image.size());
+    EXPECT_EQ(cv::norm(decoded, image, cv::NORM_INF), 0.0);
+}
+
+TEST(ImageWriterTest, InlineWriterRunsOnCaller) {
+    ImageWriter writer(0);
+    int ran = 0;
+    writer.post([&ran]() { ++ran; });
+    EXPECT_EQ(ran, 1);
+}
+
+TEST(ImageWriterTest, DestructorDrainsQueuedTasks) {
+    std::atomic<int> ran{0};
+    {
+        ImageWriter writer(2);
+        for (int i = 0; i < 20; ++i) {
+            writer.post([&ran]() { ran.fetch_add(1); });
+        }
+    }
+    EXPECT_EQ(ran.load(), 20);
+}
+
+TEST(ImageWriteBatchTest, WritesFilesAndKeepsKeyedBytesSorted) {
+    const fs::path dir = makeTempDir("batch");
+    const cv::Mat page = makeGradient(40, 60);
+
+    ImageWriter writer(3);
+    auto batch = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, true);
+    for (int i = 4; i >= 0; --i) {
+        const std::string key = "images/crop" + std::to_string(i) + ".png";
+        batch->submit(page(cv::Rect(i * 10, 0, 10, 20)), (dir / fs::path(key).filename()).string(), key);
+    }
+    batch->submit(page, (dir / "vis.png").string());
+
+    const std::vector<EncodedImage> kept = batch->wait();
+    ASSERT_EQ(kept.size(), 5u);
+    for (size_t i = 0; i < kept.size(); ++i) {
+        EXPECT_EQ(kept[i].path, "images/crop" + std::to_string(i) + ".png");
+        const cv::Mat decoded = cv::imdecode(kept[i].data, cv::IMREAD_COLOR);
+        ASSERT_EQ(decoded.size(), cv::Size(10, 20));
+        EXPECT_EQ(cv::norm(decoded, page(cv::Rect(static_cast<int>(i) * 10, 0, 10, 20)),
+                           cv::NORM_INF), 0.0);
+        EXPECT_TRUE(fs::exists(dir / ("crop" + std::to_string(i) + ".png")));
+    }
+    EXPECT_TRUE(fs::exists(dir / "vis.png"));
+    EXPECT_TRUE(batch->wait().empty());
+
+    fs::remove_all(dir);
+}
+
+TEST(ImageWriteBatchTest, DropsBytesWhenNotKept) {
+    const fs::path dir = makeTempDir("nokeep");
+    ImageWriter writer(1);
+    auto batch = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, false);
+    batch->submit(makeGradient(8, 8), (dir / "a.png").string(), "images/a.png");
+
+    EXPECT_TRUE(batch->wait().empty());
+    EXPECT_TRUE(fs::exists(dir / "a.png"));
+
+    fs::remove_all(dir);
+}
+
+TEST(ImageWriteBatchTest, RepeatedCropsAreStoredOnceAndEncodedOnce) {
+    const fs::path dir = makeTempDir("dedup");
+    const cv::Mat logo = makeGradient(12, 16);
+    const cv::Mat copy = logo.clone();
+    const ContentDigest digest = digestImage(logo);
+    ASSERT_EQ(digestImage(copy), digest);
+
+    ImageWriter writer(2, 1024 * 1024);
+    auto first = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, true);
+    EXPECT_EQ(first->submitDeduplicated(logo, digest, (dir / "a.png").string(), "images/a.png"),
+              "images/a.png");
+    EXPECT_EQ(first->submitDeduplicated(copy, digest, (dir / "b.png").string(), "images/b.png"),
+              "images/a.png");
+    const std::vector<EncodedImage> kept = first->wait();
+    ASSERT_EQ(kept.size(), 1u);
+    EXPECT_EQ(first->duplicateCount(), 1u);
+    EXPECT_TRUE(fs::exists(dir / "a.png"));
+    EXPECT_FALSE(fs::exists(dir / "b.png"));
+
+    // Another run writes its own file but reuses the encoded bytes.
+    auto second = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, true);
+    second->submitDeduplicated(copy, digest, (dir / "c.png").string(), "images/c.png");
+    const std::vector<EncodedImage> again = second->wait();
+    ASSERT_EQ(again.size(), 1u);
+    EXPECT_EQ(again[0].data, kept[0].data);
+    EXPECT_TRUE(fs::exists(dir / "c.png"));
+    EXPECT_EQ(writer.encodedCache()->stats().hits, 1u);
+
+    // A different encoding is a different artifact.
+    ImageEncoding jpeg;
+    ImageEncoding::parse("jpg", 90, jpeg);
+    auto third = std::make_shared<ImageWriteBatch>(writer, jpeg, true);
+    third->submitDeduplicated(copy, digest, (dir / "d.jpg").string(), "images/d.jpg");
+    third->wait();
+    EXPECT_EQ(writer.encodedCache()->stats().hits, 1u);
+
+    fs::remove_all(dir);
+}
+
+TEST(ImageWriteBatchTest, DuplicateOfAFailedWriteStoresItsOwnCopy) {
+    const fs::path dir = makeTempDir("dedup_failed");
+    const cv::Mat logo = makeGradient(12, 16);
+    const ContentDigest digest = digestImage(logo);
+
+    ImageWriter writer(2);
+    auto batch = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, false);
+    // The first copy's directory does not exist, so its write fails.
+    EXPECT_EQ(batch->submitDeduplicated(
+                  logo, digest, (dir / "missing" / "a.png").string(), "images/a.png"),
+              "images/a.png");
+    EXPECT_EQ(batch->submitDeduplicated(logo, digest, (dir / "b.png").string(), "images/b.png"),
+              "images/b.png");
+    EXPECT_EQ(batch->submitDeduplicated(logo, digest, (dir / "c.png").string(), "images/c.png"),
+              "images/b.png");
+    batch->wait();
+    EXPECT_EQ(batch->duplicateCount(), 1u);
+    EXPECT_TRUE(fs::exists(dir / "b.png"));
+    EXPECT_FALSE(fs::exists(dir / "c.png"));
+
+    fs::remove_all(dir);
+}
+
+TEST(ImageWriteBatchTest, StagedCropsAreStoredInClaimOrder) {
+    const fs::path dir = makeTempDir("dedup_claim");
+    const cv::Mat logo = makeGradient(12, 16);
+    const ContentDigest digest = digestImage(logo);
+
+    ImageWriter writer(2);
+    auto batch = std::make_shared<ImageWriteBatch>(writer, ImageEncoding{}, false);
+    // Page 2 finishes first, but page 1 is claimed first and keeps the file.
+    batch->stageDeduplicated(logo, digest, (dir / "p2.png").string(), "images/p2.png");
+    batch->stageDeduplicated(logo, digest, (dir / "p1.png").string(), "images/p1.png");
+    batch->stageDeduplicated(logo, digest, (dir / "p3.png").string(), "images/p3.png");
+    EXPECT_EQ(batch->claim("images/p1.png"), "images/p1.png");
+    EXPECT_EQ(batch->claim("images/p2.png"), "images/p1.png");
+    EXPECT_EQ(batch->claim("images/vis.png"), "images/vis.png");
+    batch->wait();
+    EXPECT_TRUE(fs::exists(dir / "p1.png"));
+    EXPECT_FALSE(fs::exists(dir / "p2.png"));
+    // Never claimed (its page was dropped): never written.
+    EXPECT_FALSE(fs::exists(dir / "p3.png"));
+    EXPECT_EQ(batch->claim("images/p3.png"), "images/p3.png");
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "server/job_store.h"
+
+#include <filesystem>
+#include <string>
+
+using namespace rapid_doc;
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path makeTempDir(const std::string& name) {
+    const fs::path dir = fs::temp_directory_path() / ("rapiddoc_job_store_" + name);
+    fs::remove_all(dir);
+    return dir;
+}
+
+nlohmann::json makePage(int page) {
+    return nlohmann::json{{"page", page}, {"md_content", "page " + std::to_string(page) + "\n"}};
+}
+
+} // namespace
+
+TEST(JobStoreTest, ReopenedStoreResumesAfterLastCheckpoint) {
+    const fs::path dir = makeTempDir("resume");
+    std::string id;
+    {
+        JobStore store(dir.string());
+        id = store.create("scan.pdf", "pdf bytes", nlohmann::json{{"start_page_id", 0}});
+        ASSERT_FALSE(id.empty());
+        ASSERT_TRUE(store.checkpointPage(id, 0, makePage(1), 5));
+        ASSERT_TRUE(store.checkpointPage(id, 1, makePage(2), 5));
+        EXPECT_EQ(store.find(id)->status, "running");
+    }
+
+    JobStore reopened(dir.string());
+    const auto info = reopened.find(id);
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->status, "queued");
+    EXPECT_EQ(info->filename, "scan.pdf");
+    EXPECT_EQ(info->completedPages, 2);
+    EXPECT_EQ(info->totalPages, 5);
+    EXPECT_EQ(info->options.value("start_page_id", -1), 0);
+    EXPECT_EQ(reopened.unfinished(), std::vector<std::string>{id});
+
+    std::string bytes;
+    ASSERT_TRUE(reopened.readUpload(id, bytes));
+    EXPECT_EQ(bytes, "pdf bytes");
+
+    const auto pages = reopened.readPages(id, 1, 10);
+    ASSERT_EQ(pages.size(), 1u);
+    EXPECT_EQ(pages[0].value("md_content", std::string()), "page 2\n");
+    fs::remove_all(dir);
+}
+
+TEST(JobStoreTest, FinishedJobsAreNotResumed) {
+    const fs::path dir = makeTempDir("finished");
+    JobStore store(dir.string());
+    const std::string done = store.create("a.png", "a", nlohmann::json::object());
+    const std::string failed = store.create("b.pdf", "b", nlohmann::json::object());
+    const std::string queued = store.create("c.pdf", "c", nlohmann::json::object());
+    ASSERT_TRUE(store.checkpointPage(done, 0, makePage(1), 1));
+    store.markDone(done);
+    store.markFailed(failed, "bad pdf");
+
+    JobStore reopened(dir.string());
+    EXPECT_EQ(reopened.unfinished(), std::vector<std::string>{queued});
+    EXPECT_EQ(reopened.find(done)->totalPages, 1);
+    EXPECT_EQ(reopened.find(failed)->error, "bad pdf");
+    // A gap stops the completed count at the checkpoints before it.
+    ASSERT_TRUE(reopened.checkpointPage(queued, 1, makePage(2), 3));
+    EXPECT_EQ(reopened.find(queued)->completedPages, 0);
+    EXPECT_TRUE(reopened.readPages(queued, 0, 10).empty());
+    fs::remove_all(dir);
+}
+
+TEST(JobStoreTest, ExpiredFinishedJobsAreRemovedFromDisk) {
+    const fs::path dir = makeTempDir("expire");
+    JobStore store(dir.string());
+    const std::string done = store.create("a.pdf", "a", nlohmann::json::object());
+    const std::string failed = store.create("b.pdf", "b", nlohmann::json::object());
+    const std::string queued = store.create("c.pdf", "c", nlohmann::json::object());
+    ASSERT_TRUE(store.checkpointPage(done, 0, makePage(1), 1));
+    store.markDone(done);
+    store.markFailed(failed, "bad pdf");
+
+    EXPECT_EQ(store.expireFinished(store.find(done)->finishedAtMs), 0u);
+    EXPECT_EQ(store.expireFinished(JobStore::nowMs() + 1), 2u);
+    EXPECT_FALSE(store.find(done).has_value());
+    EXPECT_FALSE(store.find(failed).has_value());
+    EXPECT_FALSE(fs::exists(dir / done));
+    EXPECT_TRUE(store.find(queued).has_value());
+
+    EXPECT_TRUE(store.remove(queued));
+    EXPECT_FALSE(store.remove(queued));
+    EXPECT_FALSE(fs::exists(dir / queued));
+    JobStore reopened(dir.string());
+    EXPECT_TRUE(reopened.unfinished().empty());
+    fs::remove_all(dir);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file test_layout_batching.cpp
+ * @brief detectAsync() through the batching worker, with detectBatch()
+ *        replaced so no model is needed.
+ */
+
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+
+#include "layout/layout_detector.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+namespace rapid_doc {
+
+class LayoutDetectorTestAccess {
+public:
+    using BatchRun = std::function<std::vector<LayoutResult>(const std::vector<cv::Mat>&)>;
+
+    /// Start the batching worker as initialize() would, running @p run per batch
+    static void startBatchWorker(LayoutDetector& detector, BatchRun run) {
+        detector.batchRunHook_ = std::move(run);
+        detector.initialized_ = true;
+        detector.startBatchWorker();
+    }
+};
+
+} // namespace rapid_doc
+
+using namespace rapid_doc;
+
+namespace {
+
+// Image i is tagged by its width so results can be matched back to callers.
+cv::Mat taggedImage(int tag) {
+    return cv::Mat(4, tag, CV_8UC3, cv::Scalar(0, 0, 0));
+}
+
+LayoutResult resultFor(const cv::Mat& image) {
+    LayoutResult result;
+    LayoutBox box{};
+    box.index = image.cols;
+    result.boxes.push_back(box);
+    return result;
+}
+
+LayoutDetectorConfig batchingConfig(int batchSize) {
+    LayoutDetectorConfig config;
+    config.inputSize = 32;
+    config.batchSize = batchSize;
+    config.batchMaxDelayMs = 50;
+    return config;
+}
+
+} // namespace
+
+TEST(LayoutBatchingTest, DetectAsyncDeliversEachImageItsOwnResult) {
+    LayoutDetector detector(batchingConfig(4));
+    std::atomic<int> runs{0};
+    std::atomic<size_t> largestBatch{0};
+    LayoutDetectorTestAccess::startBatchWorker(detector,
+        [&](const std::vector<cv::Mat>& images) {
+            ++runs;
+            if (images.size() > largestBatch) largestBatch = images.size();
+            std::vector<LayoutResult> results;
+            for (const auto& image : images) results.push_back(resultFor(image));
+            return results;
+        });
+    ASSERT_TRUE(detector.batchesInternally());
+
+    const int kImages = 6;
+    std::vector<cv::Mat> images;
+    std::vector<std::future<LayoutResult>> futures;
+    for (int i = 1; i <= kImages; ++i) {
+        images.push_back(taggedImage(i));
+    }
+    for (const auto& image : images) {
+        futures.push_back(detector.detectAsync(image));
+    }
+
+    for (int i = 0; i < kImages; ++i) {
+        LayoutResult result = futures[i].get();
+        ASSERT_EQ(result.boxes.size(), 1u);
+        EXPECT_EQ(result.boxes[0].index, i + 1);
+    }
+    EXPECT_GT(largestBatch.load(), 1u);
+    EXPECT_LE(largestBatch.load(), 4u);
+    EXPECT_LT(runs.load(), kImages);
+}
+
+TEST(LayoutBatchingTest, FailedBatchPropagatesToEveryCaller) {
+    LayoutDetector detector(batchingConfig(3));
+    LayoutDetectorTestAccess::startBatchWorker(detector,
+        [](const std::vector<cv::Mat>&) -> std::vector<LayoutResult> {
+            throw std::runtime_error("npu fault");
+        });
+
+    std::vector<cv::Mat> images = {taggedImage(1), taggedImage(2), taggedImage(3)};
+    std::vector<std::future<LayoutResult>> futures;
+    for (const auto& image : images) {
+        futures.push_back(detector.detectAsync(image));
+    }
+    for (auto& future : futures) {
+        EXPECT_THROW(future.get(), std::runtime_error);
+    }
+}
+
+TEST(LayoutBatchingTest, ShortBatchResultFailsInsteadOfHanging) {
+    LayoutDetector detector(batchingConfig(2));
+    LayoutDetectorTestAccess::startBatchWorker(detector,
+        [](const std::vector<cv::Mat>& images) {
+            return std::vector<LayoutResult>(images.size() - 1);
+        });
+
+    std::vector<cv::Mat> images = {taggedImage(1), taggedImage(2)};
+    auto first = detector.detectAsync(images[0]);
+    auto second = detector.detectAsync(images[1]);
+    EXPECT_THROW(first.get(), std::runtime_error);
+    EXPECT_THROW(second.get(), std::runtime_error);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "common/types.h"
+
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+LayoutBox makeBox(LayoutCategory category, int index) {
+    LayoutBox box{};
+    box.x0 = static_cast<float>(index * 10);
+    box.y0 = 0.0f;
+    box.x1 = box.x0 + 5.0f;
+    box.y1 = 5.0f;
+    box.category = category;
+    box.index = index;
+    box.label = layoutCategoryToString(category);
+    return box;
+}
+
+std::vector<int> indicesOf(LayoutBoxView view) {
+    std::vector<int> indices;
+    for (const auto& box : view) {
+        indices.push_back(box.index);
+    }
+    return indices;
+}
+
+} // namespace
+
+TEST(LayoutBucketsTest, ClassifyMatchesFilterHelpers) {
+    LayoutResult layout;
+    const LayoutCategory categories[] = {
+        LayoutCategory::TABLE, LayoutCategory::TEXT, LayoutCategory::FIGURE,
+        LayoutCategory::INTERLINE_EQUATION, LayoutCategory::TITLE, LayoutCategory::SEPARATOR,
+        LayoutCategory::FIGURE_CAPTION, LayoutCategory::EQUATION, LayoutCategory::TABLE,
+    };
+    for (LayoutCategory category : categories) {
+        layout.boxes.push_back(makeBox(category, static_cast<int>(layout.boxes.size())));
+    }
+
+    const LayoutBuckets buckets = layout.classify();
+    EXPECT_EQ(buckets.order.size(), layout.boxes.size());
+    auto expectSame = [&](LayoutBucket bucket, const std::vector<LayoutBox>& expected) {
+        const LayoutBoxView view = buckets.view(layout.boxes, bucket);
+        ASSERT_EQ(view.size(), expected.size());
+        EXPECT_EQ(indicesOf(view), indicesOf(expected));
+        for (size_t i = 0; i < view.size(); ++i) {
+            EXPECT_EQ(&view[i], &layout.boxes[static_cast<size_t>(expected[i].index)]);
+        }
+    };
+    expectSame(LayoutBucket::TEXT, layout.getTextBoxes());
+    expectSame(LayoutBucket::TABLE, layout.getTableBoxes());
+    expectSame(LayoutBucket::FIGURE, layout.getBoxesByCategory(LayoutCategory::FIGURE));
+    expectSame(LayoutBucket::EQUATION, layout.getEquationBoxes());
+    expectSame(LayoutBucket::UNSUPPORTED, layout.getUnsupportedBoxes());
+
+    EXPECT_TRUE(LayoutResult{}.classify().view({}, LayoutBucket::TEXT).empty());
+}
+
+TEST(LayoutBucketsTest, InternedLabelsOutliveTheirSource) {
+    std::string_view first;
+    {
+        std::string label = "paragraph_title";
+        first = internLayoutLabel(label);
+        label = "overwritten";
+    }
+    EXPECT_EQ(first, "paragraph_title");
+    EXPECT_EQ(internLayoutLabel(std::string("paragraph_title")).data(), first.data());
+}
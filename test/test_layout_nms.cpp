@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include "layout/layout_nms.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+// Previous vector-of-vectors implementation, kept as the reference.
+float referenceIoU(const float* a, const float* b) {
+    float x1 = std::max(a[0], b[0]);
+    float y1 = std::max(a[1], b[1]);
+    float x2 = std::min(a[2], b[2]);
+    float y2 = std::min(a[3], b[3]);
+    float interArea = std::max(0.0f, x2 - x1 + 1) * std::max(0.0f, y2 - y1 + 1);
+    float area1 = (a[2] - a[0] + 1) * (a[3] - a[1] + 1);
+    float area2 = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+    return interArea / (area1 + area2 - interArea);
+}
+
+std::vector<int> referenceNms(const std::vector<std::vector<float>>& boxes,
+                              float iouSame, float iouDiff) {
+    std::vector<int> indices(boxes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
+        return boxes[a][1] > boxes[b][1];
+    });
+
+    std::vector<int> selected;
+    while (!indices.empty()) {
+        int current = indices.front();
+        selected.push_back(current);
+        const auto& curBox = boxes[current];
+        std::vector<int> remaining;
+        for (size_t i = 1; i < indices.size(); ++i) {
+            const auto& box = boxes[indices[i]];
+            float threshold = (box[0] == curBox[0]) ? iouSame : iouDiff;
+            if (referenceIoU(curBox.data() + 2, box.data() + 2) < threshold) {
+                remaining.push_back(indices[i]);
+            }
+        }
+        indices = std::move(remaining);
+    }
+    return selected;
+}
+
+} // namespace
+
+TEST(LayoutNmsTest, matchesReferenceOnDensePages) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(0.0f, 600.0f);
+    std::uniform_real_distribution<float> extent(2.0f, 120.0f);
+    std::uniform_int_distribution<int> cls(0, 3);
+    std::uniform_int_distribution<int> score(0, 40);  // coarse scores -> many ties
+
+    for (int trial = 0; trial < 50; ++trial) {
+        const int count = 1 + trial * 7;
+        std::vector<std::vector<float>> rows;
+        LayoutCandidates candidates;
+        for (int i = 0; i < count; ++i) {
+            const float x0 = coord(rng);
+            const float y0 = coord(rng);
+            std::vector<float> row = {
+                static_cast<float>(cls(rng)), score(rng) / 40.0f,
+                x0, y0, x0 + extent(rng), y0 + extent(rng)};
+            if (i > 0 && i % 5 == 0) {
+                // Near-duplicate of the previous box to exercise suppression.
+                row = rows.back();
+                row[1] = score(rng) / 40.0f;
+                row[4] += 1.0f;
+            }
+            candidates.push(row.data());
+            rows.push_back(std::move(row));
+        }
+
+        EXPECT_EQ(layoutNms(candidates, 0.6f, 0.98f), referenceNms(rows, 0.6f, 0.98f))
+            << "trial " << trial;
+    }
+}
+
+TEST(LayoutNmsTest, handlesEmptyAndSingleInputs) {
+    LayoutCandidates candidates;
+    EXPECT_TRUE(layoutNms(candidates).empty());
+
+    const float row[6] = {2.0f, 0.9f, 10.0f, 10.0f, 50.0f, 50.0f};
+    candidates.push(row);
+    EXPECT_EQ(layoutNms(candidates), std::vector<int>{0});
+}
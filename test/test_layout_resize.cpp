@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "layout/layout_resize.h"
+
+#include <opencv2/opencv.hpp>
+
+using namespace rapid_doc;
+
+namespace {
+
+cv::Mat randomImage(int rows, int cols, int type) {
+    cv::Mat image(rows, cols, type);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    return image;
+}
+
+} // namespace
+
+TEST(LayoutResizeTest, IntegerFactorMatchesInterArea) {
+    const cv::Mat src = randomImage(120, 160, CV_8UC3);
+    cv::Mat fast;
+    resizeAreaInto(src, fast, cv::Size(40, 30));
+    cv::Mat reference;
+    cv::resize(src, reference, cv::Size(40, 30), 0, 0, cv::INTER_AREA);
+    ASSERT_EQ(fast.size(), reference.size());
+    EXPECT_LE(cv::norm(fast, reference, cv::NORM_INF), 1.0);
+}
+
+TEST(LayoutResizeTest, FractionalFactorAveragesSourceBoxes) {
+    const cv::Mat src = randomImage(2200, 1700, CV_8UC3);
+    cv::Mat fast;
+    resizeAreaInto(src, fast, cv::Size(640, 640));
+    ASSERT_EQ(fast.rows, 640);
+    ASSERT_EQ(fast.cols, 640);
+
+    // Output pixel (oy, ox) is the mean of its integer-aligned source box.
+    for (const cv::Point p : {cv::Point(0, 0), cv::Point(321, 77), cv::Point(639, 639)}) {
+        const int x0 = p.x * 1700 / 640, x1 = (p.x + 1) * 1700 / 640;
+        const int y0 = p.y * 2200 / 640, y1 = (p.y + 1) * 2200 / 640;
+        const cv::Scalar mean = cv::mean(src(cv::Rect(x0, y0, x1 - x0, y1 - y0)));
+        const cv::Vec3b got = fast.at<cv::Vec3b>(p.y, p.x);
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_LE(std::abs(got[c] - mean[c]), 0.5 + 1e-6) << "pixel " << p << " channel " << c;
+        }
+    }
+}
+
+TEST(LayoutResizeTest, WritesIntoPreallocatedBuffer) {
+    const cv::Mat src = randomImage(1000, 800, CV_8UC3);
+    cv::Mat dst(640, 640, CV_8UC3);
+    const uchar* data = dst.data;
+    resizeAreaInto(src, dst, dst.size());
+    EXPECT_EQ(dst.data, data);
+}
+
+TEST(LayoutResizeTest, UpscaleFallsBackToInterpolation) {
+    const cv::Mat src = randomImage(100, 700, CV_8UC3);
+    cv::Mat dst;
+    resizeAreaInto(src, dst, cv::Size(640, 640));
+    EXPECT_EQ(dst.size(), cv::Size(640, 640));
+    EXPECT_EQ(dst.type(), CV_8UC3);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "server/lb_routing.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+std::vector<std::string> backendIds(size_t count) {
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < count; ++i) {
+        ids.push_back("backend_" + std::to_string(i));
+    }
+    return ids;
+}
+
+} // namespace
+
+TEST(LbRoutingTest, ParsesPolicyNames) {
+    RoutingPolicy policy = RoutingPolicy::LEAST_INFLIGHT_RR;
+    for (const char* name : {"least_inflight_rr", "least_work", "p2c", "consistent_hash"}) {
+        ASSERT_TRUE(parseRoutingPolicy(name, policy)) << name;
+        EXPECT_STREQ(routingPolicyName(policy), name);
+    }
+    EXPECT_FALSE(parseRoutingPolicy("random", policy));
+}
+
+TEST(LbRoutingTest, LeastInflightRotatesTiesAndAvoidsBusyBackends) {
+    BackendRouter router(RoutingPolicy::LEAST_INFLIGHT_RR, backendIds(3));
+    std::set<int> picked;
+    for (int i = 0; i < 3; ++i) {
+        picked.insert(router.select(100));
+    }
+    EXPECT_EQ(picked.size(), 3u);
+
+    router.load(0).beginRequest(100);
+    router.load(1).beginRequest(100);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(router.select(100), 2);
+    }
+}
+
+TEST(LbRoutingTest, LeastWorkWeighsBytesAndReportedBacklog) {
+    BackendRouter router(RoutingPolicy::LEAST_WORK, backendIds(2));
+    // One large upload in flight on 0 outweighs two small ones on 1.
+    router.load(0).beginRequest(50'000'000);
+    router.load(1).beginRequest(10'000);
+    router.load(1).beginRequest(10'000);
+    EXPECT_EQ(router.select(1'000), 1);
+
+    // Backend 1 reports a long queue from other clients.
+    router.load(1).reportStatus(40, 2, 5'000.0);
+    EXPECT_EQ(router.select(1'000), 0);
+}
+
+TEST(LbRoutingTest, LearnedRateUpdatesAsRequestsFinish) {
+    BackendLoad load;
+    load.beginRequest(1000);
+    load.endRequest(1000, 100.0);   // 0.1 ms per byte
+    EXPECT_GT(load.msPerByte(), BackendLoad::kDefaultMsPerByte);
+    EXPECT_EQ(load.inflight(), 0u);
+
+    const double learned = load.msPerByte();
+    load.beginRequest(1000);
+    load.endRequest(1000, -1.0);    // failures teach nothing
+    EXPECT_DOUBLE_EQ(load.msPerByte(), learned);
+}
+
+TEST(LbRoutingTest, PowerOfTwoPrefersLessLoadedOfPair) {
+    BackendRouter router(RoutingPolicy::POWER_OF_TWO, backendIds(2));
+    router.load(0).reportStatus(10, 1, 100.0);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(router.select(100), 1);
+    }
+}
+
+TEST(LbRoutingTest, ConsistentHashIsStableAndOnlyMovesEjectedKeys) {
+    BackendRouter router(RoutingPolicy::CONSISTENT_HASH, backendIds(4));
+    ASSERT_TRUE(router.needsContentKey());
+
+    std::vector<uint64_t> keys;
+    std::vector<int> owners;
+    std::set<int> used;
+    for (int i = 0; i < 200; ++i) {
+        const std::string doc = "document-" + std::to_string(i);
+        keys.push_back(BackendRouter::hashBytes(doc.data(), doc.size()));
+        owners.push_back(router.select(doc.size(), keys.back()));
+        EXPECT_EQ(router.select(doc.size(), keys.back()), owners.back());
+        used.insert(owners.back());
+    }
+    EXPECT_EQ(used.size(), 4u);
+
+    while (!router.load(2).reportFailure(1)) {
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const int owner = router.select(0, keys[i]);
+        EXPECT_NE(owner, 2);
+        if (owners[i] != 2) {
+            EXPECT_EQ(owner, owners[i]);
+        }
+    }
+}
+
+TEST(LbRoutingTest, EjectsAfterConsecutiveFailuresAndReadmitsOnStatus) {
+    BackendRouter router(RoutingPolicy::LEAST_INFLIGHT_RR, backendIds(2));
+    EXPECT_FALSE(router.load(0).reportFailure(3));
+    EXPECT_FALSE(router.load(0).reportFailure(3));
+    EXPECT_TRUE(router.load(0).reportFailure(3));
+    EXPECT_FALSE(router.load(0).reportFailure(3));   // already out
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(router.select(1), 1);
+    }
+
+    EXPECT_TRUE(router.load(1).reportFailure(1));
+    EXPECT_EQ(router.select(1), -1);
+
+    router.load(0).reportStatus(0, 0, 0.0);
+    EXPECT_EQ(router.select(1), 0);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "common/memo_cache.h"
+#include "pipeline/recognition_cache.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+
+using namespace rapid_doc;
+
+namespace {
+
+ContentDigest digestOf(const std::string& text) {
+    ContentHasher hasher;
+    hasher.update(text);
+    return hasher.digest();
+}
+
+} // namespace
+
+TEST(MemoCacheTest, CountsHitsAndMisses) {
+    MemoCache<std::string> cache(1024);
+    std::string out;
+    EXPECT_FALSE(cache.get(digestOf("a"), out));
+    cache.put(digestOf("a"), "alpha", 5);
+    ASSERT_TRUE(cache.get(digestOf("a"), out));
+    EXPECT_EQ(out, "alpha");
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.bytes, 5u);
+}
+
+TEST(MemoCacheTest, EvictsLeastRecentlyUsedOverBudget) {
+    MemoCache<std::string> cache(20);
+    cache.put(digestOf("a"), "a", 10);
+    cache.put(digestOf("b"), "b", 10);
+    std::string out;
+    ASSERT_TRUE(cache.get(digestOf("a"), out));   // "b" is now the oldest
+    cache.put(digestOf("c"), "c", 10);
+
+    EXPECT_TRUE(cache.get(digestOf("a"), out));
+    EXPECT_FALSE(cache.get(digestOf("b"), out));
+    EXPECT_TRUE(cache.get(digestOf("c"), out));
+    EXPECT_EQ(cache.stats().bytes, 20u);
+
+    cache.put(digestOf("huge"), "huge", 21);      // larger than the budget: not kept
+    EXPECT_FALSE(cache.get(digestOf("huge"), out));
+    EXPECT_EQ(cache.stats().entries, 2u);
+}
+
+TEST(MemoCacheTest, ImageDigestIgnoresStrideButNotPixels) {
+    cv::Mat page(40, 60, CV_8UC3, cv::Scalar::all(255));
+    page(cv::Rect(10, 5, 20, 10)).setTo(cv::Scalar(0, 0, 0));
+
+    const cv::Mat roi = page(cv::Rect(8, 4, 30, 20));
+    const cv::Mat copy = roi.clone();
+    EXPECT_EQ(digestImage(roi), digestImage(copy));
+
+    cv::Mat changed = copy.clone();
+    changed.at<cv::Vec3b>(19, 29)[0] = 1;
+    EXPECT_NE(digestImage(copy), digestImage(changed));
+
+    // Same bytes, different shape.
+    EXPECT_NE(digestImage(copy), digestImage(copy.reshape(3, 10)));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "server/metrics_registry.h"
+
+#include <string>
+
+using namespace rapid_doc;
+
+TEST(MetricsRegistryTest, HistogramBucketsAreUpperInclusive) {
+    MetricHistogram histogram({0.001, 0.01, 0.1});
+    histogram.observe(0.001);   // on a bound: that bucket
+    histogram.observe(0.005);
+    histogram.observe(0.5);     // past the last bound: +Inf
+    histogram.observe(-1.0);    // clamped to zero
+
+    EXPECT_EQ(histogram.bucketCount(0), 2u);
+    EXPECT_EQ(histogram.bucketCount(1), 1u);
+    EXPECT_EQ(histogram.bucketCount(2), 0u);
+    EXPECT_EQ(histogram.bucketCount(3), 1u);
+    EXPECT_EQ(histogram.count(), 4u);
+    EXPECT_NEAR(histogram.sum(), 0.506, 1e-9);
+}
+
+TEST(MetricsRegistryTest, SeriesAreSharedByNameAndLabels) {
+    MetricsRegistry registry;
+    MetricCounter& a = registry.counter("requests_total", "Requests.", {{"shard", "0"}});
+    MetricCounter& b = registry.counter("requests_total", "Requests.", {{"shard", "0"}});
+    MetricCounter& c = registry.counter("requests_total", "Requests.", {{"shard", "1"}});
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &c);
+}
+
+TEST(MetricsRegistryTest, RendersPrometheusText) {
+    MetricsRegistry registry;
+    registry.counter("lookups_total", "Cache lookups.", {{"result", "hit"}}).add(3);
+    registry.gauge("inflight", "In flight.", {}, []() { return 2.0; });
+    MetricHistogram& latency = registry.histogram(
+        "latency_seconds", "Latency.", {{"shard", "dev\"0"}}, {0.1, 1.0});
+    latency.observe(0.05);
+    latency.observe(0.5);
+    latency.observe(5.0);
+
+    const std::string text = registry.renderPrometheus();
+    EXPECT_NE(text.find("# TYPE lookups_total counter\nlookups_total{result=\"hit\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE inflight gauge\ninflight 2\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE latency_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{shard=\"dev\\\"0\",le=\"0.1\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{shard=\"dev\\\"0\",le=\"1\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{shard=\"dev\\\"0\",le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_sum{shard=\"dev\\\"0\"} 5.55\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_count{shard=\"dev\\\"0\"} 3\n"), std::string::npos);
+}
+
+TEST(MetricsRegistryTest, QuantileOfBucketDeltas) {
+    MetricHistogram latency({0.1, 1.0, 10.0});
+    for (int i = 0; i < 10; ++i) {
+        latency.observe(0.05);
+    }
+    const std::vector<uint64_t> before = latency.bucketCounts();
+    for (int i = 0; i < 10; ++i) {
+        latency.observe(i < 5 ? 0.5 : 5.0);
+    }
+    std::vector<uint64_t> window = latency.bucketCounts();
+    for (size_t i = 0; i < window.size(); ++i) {
+        window[i] -= before[i];
+    }
+
+    EXPECT_DOUBLE_EQ(histogramQuantile(latency.bounds(), window, 0.5), 1.0);
+    EXPECT_DOUBLE_EQ(histogramQuantile(latency.bounds(), window, 0.95), 1.0 + 9.0 * 4.5 / 5.0);
+    EXPECT_DOUBLE_EQ(histogramQuantile(latency.bounds(), {0, 0, 0, 3}, 0.9), 10.0);
+    EXPECT_DOUBLE_EQ(histogramQuantile(latency.bounds(), {0, 0, 0, 0}, 0.9), 0.0);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "common/npu_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace rapid_doc;
+
+TEST(NpuSchedulerTest, capsConcurrencyPerEngine) {
+    NpuSchedulerConfig config;
+    config.ocrConcurrency = 2;
+    NpuScheduler scheduler(config);
+    ASSERT_EQ(scheduler.limit(NpuEngine::OCR), 2);
+
+    std::atomic<int> inside{0};
+    std::atomic<int> peak{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            NpuScheduler::Ticket ticket = scheduler.admit(NpuEngine::OCR);
+            const int now = ++inside;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            --inside;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_LE(peak.load(), 2);
+    EXPECT_EQ(scheduler.active(NpuEngine::OCR), 0);
+}
+
+TEST(NpuSchedulerTest, enginesAdmitIndependently) {
+    NpuScheduler scheduler;
+    NpuScheduler::Ticket layout = scheduler.admit(NpuEngine::LAYOUT);
+
+    // The layout lane is full, but OCR and table must not wait on it.
+    NpuScheduler::Ticket ocr = scheduler.admit(NpuEngine::OCR);
+    NpuScheduler::Ticket table = scheduler.admit(NpuEngine::TABLE);
+    EXPECT_EQ(scheduler.active(NpuEngine::LAYOUT), 1);
+    EXPECT_EQ(scheduler.active(NpuEngine::OCR), 1);
+    EXPECT_EQ(scheduler.active(NpuEngine::TABLE), 1);
+
+    layout.release();
+    EXPECT_EQ(scheduler.active(NpuEngine::LAYOUT), 0);
+    NpuScheduler::Ticket next = scheduler.admit(NpuEngine::LAYOUT);
+    EXPECT_EQ(scheduler.active(NpuEngine::LAYOUT), 1);
+}
+
+TEST(NpuSchedulerTest, raisedLimitAdmitsWaiters) {
+    NpuScheduler scheduler;
+    NpuScheduler::Ticket first = scheduler.admit(NpuEngine::OCR);
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]() {
+        NpuScheduler::Ticket second = scheduler.admit(NpuEngine::OCR);
+        admitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(admitted.load());
+
+    scheduler.setLimit(NpuEngine::OCR, 2);
+    waiter.join();
+    EXPECT_TRUE(admitted.load());
+    EXPECT_EQ(scheduler.limit(NpuEngine::OCR), 2);
+    scheduler.setLimit(NpuEngine::OCR, 0);
+    EXPECT_EQ(scheduler.limit(NpuEngine::OCR), 1);
+}
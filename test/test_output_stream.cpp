@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include "output/content_list.h"
+#include "output/json_writer.h"
+#include "output/markdown_writer.h"
+#include "output/result_json.h"
+
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+PageResult makePage(int pageIndex, size_t elementCount) {
+    PageResult page;
+    page.pageIndex = pageIndex;
+    for (size_t i = 0; i < elementCount; ++i) {
+        ContentElement elem;
+        elem.type = (i % 2 == 0) ? ContentElement::Type::TEXT : ContentElement::Type::TABLE;
+        elem.text = "line \"" + std::to_string(i) + "\"\n";
+        elem.pageIndex = pageIndex;
+        elem.readingOrder = static_cast<int>(i);
+        elem.layoutBox.x0 = 10.5f;
+        elem.layoutBox.y0 = 0.1f;
+        elem.layoutBox.x1 = 200.0f;
+        elem.layoutBox.y1 = 1e-5f;
+        if (elem.type == ContentElement::Type::TABLE) {
+            elem.html = "<table><tr><td>x</td></tr></table>";
+        }
+        page.elements.push_back(elem);
+    }
+    return page;
+}
+
+std::string jsonNumber(double value) {
+    std::string out;
+    appendJsonNumber(out, value);
+    return out;
+}
+
+}  // namespace
+
+TEST(OutputStreamTest, ContentListStreamMatchesGenerate) {
+    DocumentResult doc;
+    doc.pages.push_back(makePage(0, 3));
+    doc.pages.push_back(makePage(1, 0));
+    doc.pages.push_back(makePage(2, 1));
+
+    std::vector<std::string> chunks;
+    ContentListStream stream([&chunks](const char* data, size_t size) {
+        chunks.emplace_back(data, size);
+    });
+    for (const auto& page : doc.pages) {
+        stream.appendPage(page);
+    }
+    stream.finish();
+
+    std::string streamed;
+    for (const auto& chunk : chunks) streamed += chunk;
+    EXPECT_EQ(chunks.size(), doc.pages.size() + 1);  // one per page plus the closing bracket
+    EXPECT_EQ(streamed, ContentListWriter().generate(doc));
+}
+
+TEST(OutputStreamTest, ContentListLayoutMatchesPrettyDump) {
+    DocumentResult empty;
+    EXPECT_EQ(ContentListWriter().generate(empty), "[]");
+
+    DocumentResult doc;
+    doc.pages.push_back(makePage(0, 0));
+    ContentElement elem;
+    elem.type = ContentElement::Type::IMAGE;
+    elem.imagePath = "images/page0_fig0.png";
+    elem.layoutBox.x0 = 1.0f;
+    elem.layoutBox.y0 = 2.0f;
+    elem.layoutBox.x1 = 3.0f;
+    elem.layoutBox.y1 = 4.5f;
+    PageResult page;
+    page.elements.push_back(elem);
+    doc.pages.push_back(page);
+
+    EXPECT_EQ(ContentListWriter().generate(doc),
+              "[\n"
+              "  [],\n"
+              "  [\n"
+              "    {\n"
+              "      \"bbox\": [\n"
+              "        1.0,\n"
+              "        2.0,\n"
+              "        3.0,\n"
+              "        4.5\n"
+              "      ],\n"
+              "      \"image_path\": \"images/page0_fig0.png\",\n"
+              "      \"order\": 0,\n"
+              "      \"page\": 0,\n"
+              "      \"skipped\": false,\n"
+              "      \"text\": \"\",\n"
+              "      \"type\": \"image\"\n"
+              "    }\n"
+              "  ]\n"
+              "]");
+}
+
+TEST(OutputStreamTest, MarkdownStreamMatchesGenerate) {
+    DocumentResult doc;
+    doc.pages.push_back(makePage(0, 2));
+    doc.pages.push_back(makePage(1, 2));
+
+    std::string streamed;
+    MarkdownStream stream(makeStringSink(streamed));
+    for (const auto& page : doc.pages) {
+        stream.appendPage(page);
+    }
+    EXPECT_EQ(streamed, MarkdownWriter().generate(doc));
+    EXPECT_NE(streamed.find("\n---\n\n"), std::string::npos);
+}
+
+TEST(OutputStreamTest, JsonValuesFormatLikeNlohmannDump) {
+    EXPECT_EQ(jsonNumber(0.0), "0.0");
+    EXPECT_EQ(jsonNumber(100.0), "100.0");
+    EXPECT_EQ(jsonNumber(-2.5), "-2.5");
+    EXPECT_EQ(jsonNumber(static_cast<double>(0.1f)), "0.10000000149011612");
+    EXPECT_EQ(jsonNumber(1e-5), "1e-05");
+    EXPECT_EQ(jsonNumber(0.0001), "0.0001");
+    EXPECT_EQ(jsonNumber(3e20), "3e+20");
+
+    std::string out;
+    appendJsonString(out, "a\"b\\c\n\t\x01/");
+    EXPECT_EQ(out, "\"a\\\"b\\\\c\\n\\t\\u0001/\"");
+}
+
+TEST(OutputStreamTest, CborResultDecodesToTheJsonDom) {
+    DocumentResult doc;
+    doc.pages.push_back(makePage(0, 3));
+    doc.pages.push_back(makePage(1, 2));
+    const nlohmann::json contentList = buildContentListJson(doc);
+
+    ResultFormat format = ResultFormat::JSON;
+    ASSERT_TRUE(parseResultFormat("CBOR", format));
+    EXPECT_EQ(format, ResultFormat::CBOR);
+    EXPECT_FALSE(parseResultFormat("msgpack", format));
+
+    const std::string cbor = encodeResult(contentList, ResultFormat::CBOR);
+    EXPECT_EQ(nlohmann::json::from_cbor(cbor), contentList);
+    EXPECT_LT(cbor.size(), encodeResult(contentList, ResultFormat::JSON).size());
+    EXPECT_EQ(encodeResult(contentList, ResultFormat::JSON, 2), contentList.dump(2));
+    EXPECT_STREQ(resultFormatMimeType(ResultFormat::CBOR), "application/cbor");
+    EXPECT_STREQ(resultFormatExtension(ResultFormat::JSON), ".json");
+}
@@ -13,6 +13,7 @@ TEST(PerfUtilsTest, summarizeSamplesComputesMeanAndPercentiles) {
     EXPECT_DOUBLE_EQ(summary.maxMs, 50.0);
     EXPECT_DOUBLE_EQ(summary.p50Ms, 30.0);
     EXPECT_DOUBLE_EQ(summary.p95Ms, 48.0);
+    EXPECT_DOUBLE_EQ(summary.p99Ms, 49.6);
 }
 
 TEST(PerfUtilsTest, accumulateDocumentStageStatsSumsPageStageStats) {
@@ -22,6 +23,8 @@ TEST(PerfUtilsTest, accumulateDocumentStageStatsSumsPageStageStats) {
     page0.stats.figureTimeMs = 2.5;
     page0.stats.npuSerialTimeMs = 30.0;
     page0.stats.cpuOnlyTimeMs = 4.0;
+    page0.stats.npuStageCpuTimeMs = 1.5;
+    page0.stats.postprocessCpuTimeMs = 2.5;
     page0.stats.npuLockWaitTimeMs = 1.0;
     page0.stats.npuLockHoldTimeMs = 31.0;
 
@@ -33,6 +36,8 @@ TEST(PerfUtilsTest, accumulateDocumentStageStatsSumsPageStageStats) {
     page1.stats.readingOrderTimeMs = 5.0;
     page1.stats.npuSerialTimeMs = 9.0;
     page1.stats.cpuOnlyTimeMs = 7.0;
+    page1.stats.npuStageCpuTimeMs = 3.0;
+    page1.stats.postprocessCpuTimeMs = 4.0;
     page1.stats.npuLockWaitTimeMs = 2.0;
     page1.stats.npuLockHoldTimeMs = 11.0;
 
@@ -47,6 +52,8 @@ TEST(PerfUtilsTest, accumulateDocumentStageStatsSumsPageStageStats) {
     EXPECT_DOUBLE_EQ(stats.readingOrderTimeMs, 5.0);
     EXPECT_DOUBLE_EQ(stats.npuSerialTimeMs, 39.0);
     EXPECT_DOUBLE_EQ(stats.cpuOnlyTimeMs, 11.0);
+    EXPECT_DOUBLE_EQ(stats.npuStageCpuTimeMs, 4.5);
+    EXPECT_DOUBLE_EQ(stats.postprocessCpuTimeMs, 6.5);
     EXPECT_DOUBLE_EQ(stats.npuLockWaitTimeMs, 3.0);
     EXPECT_DOUBLE_EQ(stats.npuLockHoldTimeMs, 42.0);
 }
@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include <opencv2/opencv.hpp>
 
+#include <cmath>
 #include <deque>
 #include <filesystem>
 #include <fstream>
@@ -11,6 +12,7 @@
 #include "common/config.h"
 #include "output/content_list.h"
 #include "output/markdown_writer.h"
+#include "pdf/pdf_renderer.h"
 #include "pipeline/doc_pipeline.h"
 #include "table/table_recognizer.h"
 #include "test_access.h"
@@ -137,6 +139,50 @@ TEST(Phase1CorrectnessContracts, ocr_result_must_match_task_id) {
     EXPECT_EQ(DocPipelineTestAccess::ocrOnCrop(pipeline, crop, 12), "future-task");
 }
 
+TEST(Phase1CorrectnessContracts, batched_ocr_wait_accepts_any_completion_order) {
+    struct ReversingOcrBackend {
+        std::vector<int64_t> pushed;
+        size_t expected = 0;
+        bool released = false;      // every task pushed; hand them back newest first
+
+        bool fetch(std::vector<ocr::PipelineOCRResult>& out, int64_t& id, bool& success) {
+            released = released || pushed.size() >= expected;
+            if (!released || pushed.empty()) {
+                return false;
+            }
+            id = pushed.back();
+            pushed.pop_back();
+            success = true;
+            out = {makeOcrResult("task-" + std::to_string(id))};
+            return true;
+        }
+    } fake;
+    fake.expected = 3;
+
+    auto cfg = makeContractConfig();
+    cfg.stages.enableOcr = true;
+    DocPipeline pipeline(cfg);
+    DocPipelineTestAccess::setOcrHooks(
+        pipeline,
+        [&fake](const cv::Mat&, int64_t id) {
+            fake.pushed.push_back(id);
+            return true;
+        },
+        [&fake](std::vector<ocr::PipelineOCRResult>& out, int64_t& id, bool& success) {
+            return fake.fetch(out, id, success);
+        });
+
+    for (int64_t id : {21, 22, 23}) {
+        fake.pushed.push_back(id);
+    }
+    const auto texts = DocPipelineTestAccess::waitForOcrBatch(pipeline, {21, 22, 23});
+
+    ASSERT_EQ(texts.size(), 3u);
+    EXPECT_EQ(texts.at(21), "task-21");
+    EXPECT_EQ(texts.at(22), "task-22");
+    EXPECT_EQ(texts.at(23), "task-23");
+}
+
 TEST(Phase1CorrectnessContracts, content_element_page_index_propagation) {
     struct EchoOcrBackend {
         std::deque<int64_t> pending;
@@ -307,6 +353,76 @@ TEST(Phase1CorrectnessContracts, no_cell_table_returns_defined_fallback) {
     EXPECT_EQ(elems[0].text, "[Unsupported table: no_cell_table]");
 }
 
+TEST(Phase1CorrectnessContracts, rerendered_region_matches_scaled_box_and_cache_skips_render) {
+    auto cfg = makeContractConfig();
+    cfg.stages.enableLayout = true;
+    cfg.stages.enableOcr = true;
+    cfg.runtime.recognitionCacheMb = 16;
+    DocPipeline pipeline(cfg);
+
+    const LayoutBox box = makeBox(LayoutCategory::TEXT, 10.4f, 20.0f, 90.6f, 31.0f);
+    DocPipelineTestAccess::setLayoutDetectHook(pipeline, [box](const cv::Mat&) {
+        LayoutResult layout;
+        layout.boxes = {box};
+        return layout;
+    });
+
+    std::vector<int64_t> pushed;
+    std::vector<cv::Size> submittedSizes;
+    DocPipelineTestAccess::setOcrHooks(
+        pipeline,
+        [&](const cv::Mat& crop, int64_t id) {
+            pushed.push_back(id);
+            submittedSizes.push_back(crop.size());
+            return true;
+        },
+        [&pushed](std::vector<ocr::PipelineOCRResult>& out, int64_t& id, bool& success) {
+            if (pushed.empty()) {
+                return false;
+            }
+            id = pushed.back();
+            pushed.pop_back();
+            success = true;
+            out = {makeOcrResult("region")};
+            return true;
+        });
+
+    // Layout-DPI page at scale 2.5; the region hook crops a full-DPI render.
+    constexpr double kScale = 2.5;
+    cv::Mat fullPage(400, 500, CV_8UC3, cv::Scalar::all(255));
+    std::vector<cv::Rect> renderedRegions;
+    PageImage page;
+    page.image = cv::Mat(160, 200, CV_8UC3, cv::Scalar::all(255));
+    page.image(cv::Rect(12, 22, 60, 6)).setTo(cv::Scalar::all(0));
+    page.regionScale = kScale;
+    page.renderRegion = [&](const cv::Rect& roi) {
+        const cv::Rect region = scaledRegion(roi, kScale);
+        renderedRegions.push_back(region);
+        return fullPage(region).clone();
+    };
+
+    PageResult first = pipeline.processPage(page);
+    const cv::Rect roi = box.toRect() & cv::Rect(0, 0, page.image.cols, page.image.rows);
+    const cv::Rect expected = scaledRegion(roi, kScale);
+    EXPECT_EQ(expected.x, static_cast<int>(std::floor(roi.x * kScale)));
+    EXPECT_EQ(expected.br().x, static_cast<int>(std::ceil(roi.br().x * kScale)));
+    EXPECT_EQ(expected.br().y, static_cast<int>(std::ceil(roi.br().y * kScale)));
+    ASSERT_EQ(renderedRegions.size(), 1u);
+    EXPECT_EQ(renderedRegions[0], expected);
+    ASSERT_EQ(submittedSizes.size(), 1u);
+    EXPECT_EQ(submittedSizes[0], expected.size());
+    ASSERT_EQ(first.elements.size(), 1u);
+    EXPECT_EQ(first.elements[0].text, "region");
+
+    // Same pixels again: answered by the cache before anything is re-rendered.
+    PageResult second = pipeline.processPage(page);
+    EXPECT_EQ(renderedRegions.size(), 1u);
+    EXPECT_EQ(submittedSizes.size(), 1u);
+    EXPECT_EQ(second.stats.ocrCacheHits, 1);
+    ASSERT_EQ(second.elements.size(), 1u);
+    EXPECT_EQ(second.elements[0].text, "region");
+}
+
 TEST(Phase1CorrectnessContracts, table_model_missing_fails_initialization) {
     auto cfg = makeContractConfig();
     cfg.stages.enableWiredTable = true;
@@ -475,3 +591,282 @@ TEST(Phase1CorrectnessContracts, request_local_overrides_do_not_mutate_shared_pi
     EXPECT_EQ(after.stages.enableWiredTable, before.stages.enableWiredTable);
     EXPECT_EQ(after.stages.enableMarkdownOutput, before.stages.enableMarkdownOutput);
 }
+
+TEST(Phase1CorrectnessContracts, pipelined_pages_return_in_producer_order) {
+    auto cfg = makeContractConfig();
+    cfg.stages.enableOcr = false;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = false;
+    cfg.runtime.pipelineQueueDepth = 1;
+    DocPipeline pipeline(cfg);
+
+    std::vector<PageImage> pages;
+    for (int i = 0; i < 6; ++i) {
+        PageImage page;
+        page.image = cv::Mat(20 + i, 30 + i, CV_8UC3, cv::Scalar::all(255));
+        page.pageIndex = 10 + i;
+        pages.push_back(page);
+    }
+
+    const DocumentResult result = DocPipelineTestAccess::runPagePipeline(pipeline, pages);
+
+    ASSERT_EQ(result.processedPages, 6);
+    ASSERT_EQ(result.pages.size(), 6u);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(result.pages[i].pageIndex, 10 + i);
+        EXPECT_EQ(result.pages[i].pageWidth, 30 + i);
+        EXPECT_EQ(result.pages[i].pageHeight, 20 + i);
+    }
+}
+
+TEST(Phase1CorrectnessContracts, parallel_postprocess_keeps_producer_order) {
+    auto cfg = makeContractConfig();
+    cfg.stages.enableOcr = false;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = false;
+    cfg.runtime.pipelineQueueDepth = 2;
+    cfg.runtime.postprocessStageThreads = 3;
+    DocPipeline pipeline(cfg);
+
+    std::vector<PageImage> pages;
+    for (int i = 0; i < 9; ++i) {
+        PageImage page;
+        page.image = cv::Mat(20 + i, 30 + i, CV_8UC3, cv::Scalar::all(255));
+        page.pageIndex = 5 + i;
+        pages.push_back(page);
+    }
+
+    const DocumentResult result = DocPipelineTestAccess::runPagePipeline(pipeline, pages);
+
+    ASSERT_EQ(result.processedPages, 9);
+    ASSERT_EQ(result.pages.size(), 9u);
+    for (int i = 0; i < 9; ++i) {
+        const PageResult& page = result.pages[i];
+        EXPECT_EQ(page.pageIndex, 5 + i);
+        EXPECT_EQ(page.pageWidth, 30 + i);
+        EXPECT_NEAR(page.stats.npuStageCpuTimeMs + page.stats.postprocessCpuTimeMs,
+                    page.stats.cpuOnlyTimeMs, 1e-9);
+    }
+}
+
+TEST(Phase1CorrectnessContracts, repeated_crops_refer_to_the_first_page_in_any_finish_order) {
+    const auto outputDir = std::filesystem::temp_directory_path() / "rapiddoc_contract_dedup";
+    std::filesystem::remove_all(outputDir);
+    auto cfg = makeContractConfig();
+    cfg.stages.enableLayout = true;
+    cfg.stages.enableOcr = false;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = true;
+    cfg.runtime.outputDir = outputDir.string();
+    cfg.runtime.pipelineQueueDepth = 2;
+    cfg.runtime.postprocessStageThreads = 3;
+    DocPipeline pipeline(cfg);
+
+    DocPipelineTestAccess::setLayoutDetectHook(pipeline, [](const cv::Mat&) {
+        LayoutResult layout;
+        layout.boxes = {makeBox(LayoutCategory::FIGURE, 10, 10, 40, 30)};
+        return layout;
+    });
+
+    std::vector<PageImage> pages;
+    for (int i = 0; i < 8; ++i) {
+        PageImage page;
+        page.image = cv::Mat(60, 80, CV_8UC3, cv::Scalar::all(255));
+        page.image(cv::Rect(15, 15, 10, 10)).setTo(cv::Scalar::all(0));
+        page.pageIndex = 3 + i;
+        pages.push_back(page);
+    }
+
+    const DocumentResult result = DocPipelineTestAccess::runPagePipeline(pipeline, pages);
+
+    ASSERT_EQ(result.pages.size(), 8u);
+    for (const auto& page : result.pages) {
+        ASSERT_EQ(page.elements.size(), 1u);
+        EXPECT_EQ(page.elements[0].imagePath, "images/page3_fig0.png");
+    }
+    EXPECT_TRUE(std::filesystem::exists(outputDir / "images" / "page3_fig0.png"));
+    EXPECT_FALSE(std::filesystem::exists(outputDir / "images" / "page4_fig0.png"));
+    std::filesystem::remove_all(outputDir);
+}
+
+TEST(Phase1CorrectnessContracts, images_as_document_merge_into_one_result) {
+    for (const int queueDepth : {0, 1}) {
+        auto cfg = makeContractConfig();
+        cfg.stages.enableOcr = false;
+        cfg.stages.enableWiredTable = false;
+        cfg.stages.enableFormula = false;
+        cfg.runtime.saveImages = false;
+        cfg.runtime.pipelineQueueDepth = queueDepth;
+        DocPipeline pipeline(cfg);
+        ASSERT_TRUE(pipeline.initialize());
+
+        std::vector<cv::Mat> images;
+        for (int i = 0; i < 4; ++i) {
+            images.emplace_back(40 + i, 50 + i, CV_8UC3, cv::Scalar::all(255));
+        }
+
+        const DocumentResult result = pipeline.processImagesAsDocument(images);
+
+        EXPECT_EQ(result.totalPages, 4) << "queue depth " << queueDepth;
+        ASSERT_EQ(result.processedPages, 4) << "queue depth " << queueDepth;
+        ASSERT_EQ(result.pages.size(), 4u);
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(result.pages[i].pageIndex, i);
+            EXPECT_EQ(result.pages[i].pageWidth, 50 + i);
+            EXPECT_EQ(result.pages[i].pageHeight, 40 + i);
+        }
+    }
+}
+
+TEST(Phase1CorrectnessContracts, pages_split_across_pipelines_return_in_producer_order) {
+    auto cfg = makeContractConfig();
+    cfg.stages.enableOcr = false;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = false;
+    cfg.runtime.pipelineQueueDepth = 1;
+    DocPipeline first(cfg);
+    DocPipeline second(cfg);
+    DocPipeline third(cfg);
+
+    std::vector<PageImage> pages;
+    for (int i = 0; i < 12; ++i) {
+        PageImage page;
+        page.image = cv::Mat(20 + i, 30 + i, CV_8UC3, cv::Scalar::all(255));
+        page.pageIndex = 3 + i;
+        pages.push_back(page);
+    }
+
+    std::string contentList;
+    PipelineRunOverrides overrides;
+    overrides.contentListSink = makeStringSink(contentList);
+    std::vector<PageStageStats> pipelineStats;
+    const DocumentResult result = DocPipelineTestAccess::runPagesAcross(
+        {&first, &second, &third}, pages, overrides, &pipelineStats);
+
+    ASSERT_EQ(result.processedPages, 12);
+    ASSERT_EQ(result.pages.size(), 12u);
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_EQ(result.pages[i].pageIndex, 3 + i);
+        EXPECT_EQ(result.pages[i].pageWidth, 30 + i);
+        EXPECT_EQ(result.pages[i].pageHeight, 20 + i);
+    }
+    EXPECT_EQ(pipelineStats.size(), 3u);
+    EXPECT_EQ(json::parse(contentList).size(), 12u);
+}
+
+TEST(Phase1CorrectnessContracts, run_progress_follows_each_streamed_page) {
+    auto cfg = makeContractConfig();
+    cfg.stages.enableOcr = false;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = false;
+    cfg.runtime.pipelineQueueDepth = 1;
+    DocPipeline first(cfg);
+    DocPipeline second(cfg);
+
+    std::vector<PageImage> pages;
+    for (int i = 0; i < 8; ++i) {
+        PageImage page;
+        page.image = cv::Mat(20 + i, 30 + i, CV_8UC3, cv::Scalar::all(255));
+        page.pageIndex = i;
+        pages.push_back(page);
+    }
+
+    int chunks = 0;
+    std::vector<int> reported;
+    PipelineRunOverrides overrides;
+    overrides.contentListSink = [&chunks](const char*, size_t) { ++chunks; };
+    overrides.progress = [&](const std::string& stage, int current, int total) {
+        EXPECT_EQ(stage, "Processing");
+        EXPECT_EQ(total, 8);
+        EXPECT_EQ(current, chunks);   // the page is already in the sink
+        reported.push_back(current);
+    };
+    const DocumentResult result = DocPipelineTestAccess::runPagesAcross(
+        {&first, &second}, pages, overrides);
+
+    ASSERT_EQ(result.processedPages, 8);
+    ASSERT_EQ(reported.size(), 8u);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(reported[i], i + 1);
+    }
+}
+
+TEST(Phase1CorrectnessContracts, replay_serves_recorded_layout_without_models) {
+    const std::string dir = std::string(PROJECT_ROOT_DIR) + "/test/fixtures/contract_output/replay";
+    std::filesystem::remove_all(dir);
+
+    cv::Mat page(64, 96, CV_8UC3, cv::Scalar::all(255));
+    page(cv::Rect(10, 20, 60, 12)).setTo(cv::Scalar::all(0));
+    LayoutResult recorded;
+    recorded.boxes.push_back(makeBox(LayoutCategory::TEXT, 8.0f, 18.0f, 72.0f, 34.0f));
+    {
+        ReplaySession session(ReplayStore::open(dir, ReplayStore::Mode::RECORD), 1.0);
+        session.recordLayout(page, recorded, 5.0);
+    }
+
+    auto cfg = makeContractConfig();
+    cfg.models = ModelPaths{};   // replay must not need any model file
+    cfg.stages.enableLayout = true;
+    cfg.stages.enableOcr = true;
+    cfg.stages.enableWiredTable = false;
+    cfg.stages.enableFormula = false;
+    cfg.runtime.saveImages = false;
+    cfg.runtime.replayDir = dir;
+    cfg.runtime.replayLatencyScale = 0.0;
+    DocPipeline pipeline(cfg);
+    ASSERT_TRUE(pipeline.initialize());
+
+    const DocumentResult result = pipeline.processImageDocument(page);
+
+    ASSERT_EQ(result.pages.size(), 1u);
+    const auto& boxes = result.pages[0].layoutResult.boxes;
+    ASSERT_EQ(boxes.size(), 1u);
+    EXPECT_EQ(boxes[0].category, LayoutCategory::TEXT);
+    EXPECT_FLOAT_EQ(boxes[0].x0, 8.0f);
+    EXPECT_FLOAT_EQ(boxes[0].y1, 34.0f);
+    EXPECT_EQ(boxes[0].label, recorded.boxes[0].label);
+}
+
+TEST(Phase1CorrectnessContracts, replayed_ocr_completes_in_submission_order) {
+    const std::string dir = std::string(PROJECT_ROOT_DIR) + "/test/fixtures/contract_output/replay_ocr";
+    std::filesystem::remove_all(dir);
+
+    const cv::Mat first(8, 32, CV_8UC3, cv::Scalar::all(0));
+    const cv::Mat second(8, 32, CV_8UC3, cv::Scalar::all(128));
+    {
+        ReplaySession session(ReplayStore::open(dir, ReplayStore::Mode::RECORD), 1.0);
+        session.ocrSubmitted(first, 1);
+        session.ocrSubmitted(second, 2);
+        session.ocrCompleted(2, {makeOcrResult("second")}, true);
+        session.ocrCompleted(1, {makeOcrResult("first")}, true);
+    }
+
+    ReplaySession replay(ReplayStore::open(dir, ReplayStore::Mode::REPLAY), 0.0);
+    EXPECT_EQ(replay.store().records(ReplayStore::Engine::OCR), 2u);
+    ASSERT_TRUE(replay.submitOcr(second, 7));
+    ASSERT_TRUE(replay.submitOcr(first, 8));
+    ASSERT_TRUE(replay.submitOcr(cv::Mat(4, 4, CV_8UC3, cv::Scalar::all(9)), 9));
+
+    std::vector<ocr::PipelineOCRResult> lines;
+    int64_t id = 0;
+    bool success = false;
+    ASSERT_TRUE(replay.fetchOcr(lines, id, success));
+    EXPECT_EQ(id, 7);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].text, "second");
+    ASSERT_TRUE(replay.fetchOcr(lines, id, success));
+    EXPECT_EQ(id, 8);
+    EXPECT_EQ(lines[0].text, "first");
+    // Unrecorded crops complete with no text.
+    ASSERT_TRUE(replay.fetchOcr(lines, id, success));
+    EXPECT_EQ(id, 9);
+    EXPECT_TRUE(success);
+    EXPECT_TRUE(lines.empty());
+    EXPECT_EQ(replay.store().misses(ReplayStore::Engine::OCR), 1u);
+    EXPECT_FALSE(replay.fetchOcr(lines, id, success));
+}
@@ -488,6 +488,12 @@ TEST_F(FileParseHttpIntegrationTest, status_reports_pipeline_lock_observability)
     ASSERT_TRUE(status["pipeline_lock"].contains("hold_total_ms"));
     EXPECT_GE(status["pipeline_lock"].value("wait_total_ms", -1.0), 0.0);
     EXPECT_GE(status["pipeline_lock"].value("hold_total_ms", -1.0), 0.0);
+    ASSERT_TRUE(status["pipeline_lock"].contains("per_engine"));
+    for (const char* engine : {"layout", "ocr", "table"}) {
+        ASSERT_TRUE(status["pipeline_lock"]["per_engine"].contains(engine)) << engine;
+        EXPECT_GE(status["pipeline_lock"]["per_engine"][engine].value("concurrency", 0), 1);
+        EXPECT_GE(status["pipeline_lock"]["per_engine"][engine].value("wait_total_ms", -1.0), 0.0);
+    }
 }
 
 TEST_F(FileParseHttpIntegrationTest, file_parse_concurrent_error_does_not_poison_followup) {
@@ -149,7 +149,7 @@ TEST(Phase1Integration, process_pdf_two_pages_preserves_page_indices) {
     EXPECT_EQ(result.pages[0].pageIndex, 0);
     EXPECT_EQ(result.pages[1].pageIndex, 1);
 
-    const json contentList = json::parse(result.contentListJson);
+    const json contentList = json::parse(ContentListWriter().generate(result));
     ASSERT_EQ(contentList.size(), 2u);
     EXPECT_TRUE(contentList[0].is_array());
     EXPECT_TRUE(contentList[1].is_array());
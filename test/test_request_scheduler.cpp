@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include "server/request_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+// Holds every worker inside a job until open() is called.
+class Gate {
+public:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        opened_.wait(lock, [this]() { return open_; });
+    }
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        opened_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable opened_;
+    bool open_ = false;
+};
+
+void waitUntilRunning(const RequestScheduler& scheduler, size_t running) {
+    while (scheduler.stats().running < running) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+TEST(RequestSchedulerTest, RunsJobsOnEveryWorker) {
+    Gate gate;
+    RequestScheduler scheduler(3, 0);
+    std::mutex mutex;
+    std::vector<size_t> workers;
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 3; ++i) {
+        auto promise = std::make_shared<std::promise<void>>();
+        done.push_back(promise->get_future());
+        ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&, promise](size_t worker) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                workers.push_back(worker);
+            }
+            gate.wait();
+            promise->set_value();
+        }));
+    }
+    waitUntilRunning(scheduler, 3);
+    gate.open();
+    for (auto& future : done) {
+        future.wait();
+    }
+
+    std::sort(workers.begin(), workers.end());
+    EXPECT_EQ(workers, (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST(RequestSchedulerTest, RejectsWhenQueueIsFull) {
+    Gate gate;
+    RequestScheduler scheduler(1, 2);
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { gate.wait(); }));
+    waitUntilRunning(scheduler, 1);
+
+    EXPECT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [](size_t) {}));
+    EXPECT_FALSE(scheduler.trySubmitAll(RequestPriority::BATCH,
+                                        {[](size_t) {}, [](size_t) {}}));
+    EXPECT_TRUE(scheduler.trySubmit(RequestPriority::INTERACTIVE, [](size_t) {}));
+    EXPECT_FALSE(scheduler.trySubmit(RequestPriority::INTERACTIVE, [](size_t) {}));
+
+    const auto stats = scheduler.stats();
+    EXPECT_EQ(stats.queued[0] + stats.queued[1], 2u);
+    EXPECT_EQ(stats.rejected, 3u);
+    EXPECT_GE(scheduler.retryAfterSeconds(), 1);
+    gate.open();
+}
+
+TEST(RequestSchedulerTest, InteractiveGoesFirstWithoutStarvingBatch) {
+    Gate gate;
+    RequestScheduler scheduler(1, 0, 2);
+    std::vector<char> order;
+    std::promise<void> done;
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { gate.wait(); }));
+    waitUntilRunning(scheduler, 1);
+
+    auto record = [&order](char tag) { return [&order, tag](size_t) { order.push_back(tag); }; };
+    scheduler.trySubmit(RequestPriority::BATCH, record('b'));
+    scheduler.trySubmit(RequestPriority::BATCH, record('b'));
+    for (int i = 0; i < 5; ++i) {
+        scheduler.trySubmit(RequestPriority::INTERACTIVE, record('i'));
+    }
+    scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { done.set_value(); });
+    gate.open();
+    done.get_future().wait();
+
+    EXPECT_EQ(std::string(order.begin(), order.end()), "iibiibi");
+}
+
+TEST(RequestSchedulerTest, ReservedWorkersTakeNoJobsUntilReleased) {
+    RequestScheduler scheduler(3, 0);
+    const std::vector<size_t> reserved = scheduler.reserveIdle(0, 5);
+    EXPECT_EQ(reserved, (std::vector<size_t>{1, 2}));
+    EXPECT_TRUE(scheduler.reserveIdle(0, 1).empty());
+
+    std::atomic<size_t> ranOn{99};
+    std::promise<void> done;
+    scheduler.trySubmit(RequestPriority::BATCH, [&](size_t worker) {
+        ranOn = worker;
+        done.set_value();
+    });
+    done.get_future().wait();
+    EXPECT_EQ(ranOn.load(), 0u);
+
+    scheduler.release(reserved);
+    EXPECT_EQ(scheduler.reserveIdle(0, 2).size(), 2u);
+}
+
+TEST(RequestSchedulerTest, StopDropsQueuedJobs) {
+    std::atomic<int> ran{0};
+    {
+        Gate gate;
+        RequestScheduler scheduler(1, 0);
+        scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { gate.wait(); ++ran; });
+        waitUntilRunning(scheduler, 1);
+        for (int i = 0; i < 4; ++i) {
+            scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { ++ran; });
+        }
+        std::thread opener([&gate]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.open();
+        });
+        scheduler.stop();
+        opener.join();
+        EXPECT_FALSE(scheduler.trySubmit(RequestPriority::BATCH, [](size_t) {}));
+    }
+    EXPECT_EQ(ran.load(), 1);
+}
+
+TEST(RequestSchedulerTest, DegradedWorkerTakesOnlyOverflow) {
+    Gate gate;
+    RequestScheduler scheduler(2, 0);
+    scheduler.setWorkerState(0, WorkerState::DEGRADED);
+
+    std::atomic<size_t> firstOn{99};
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t worker) {
+        firstOn = worker;
+        gate.wait();
+    }));
+    waitUntilRunning(scheduler, 1);
+    EXPECT_EQ(firstOn.load(), 1u);
+
+    std::atomic<size_t> secondOn{99};
+    std::promise<void> done;
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t worker) {
+        secondOn = worker;
+        done.set_value();
+    }));
+    done.get_future().wait();
+    EXPECT_EQ(secondOn.load(), 0u);
+    gate.open();
+}
+
+TEST(RequestSchedulerTest, RejectsOnceEveryWorkerIsPaused) {
+    RequestScheduler scheduler(2, 0);
+    scheduler.setWorkerState(0, WorkerState::PAUSED);
+    scheduler.setWorkerState(1, WorkerState::PAUSED);
+    EXPECT_EQ(scheduler.stats().pausedWorkers, 2u);
+    EXPECT_FALSE(scheduler.trySubmit(RequestPriority::BATCH, [](size_t) {}));
+
+    std::promise<void> done;
+    scheduler.setWorkerState(1, WorkerState::ACTIVE);
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { done.set_value(); }));
+    done.get_future().wait();
+}
+
+TEST(RequestSchedulerTest, RunningLimitHoldsBackIdleWorkers) {
+    Gate gate;
+    RequestScheduler scheduler(3, 0);
+    scheduler.setRunningLimit(1);
+    std::atomic<int> started{0};
+    std::promise<void> done;
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) { ++started; gate.wait(); }));
+    ASSERT_TRUE(scheduler.trySubmit(RequestPriority::BATCH, [&](size_t) {
+        ++started;
+        done.set_value();
+    }));
+    waitUntilRunning(scheduler, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(started.load(), 1);
+    EXPECT_EQ(scheduler.stats().runningLimit, 1u);
+
+    scheduler.setRunningLimit(0);
+    done.get_future().wait();
+    EXPECT_EQ(started.load(), 2);
+    EXPECT_EQ(scheduler.stats().runningLimit, 3u);
+    gate.open();
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "common/result_cache.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+using namespace rapid_doc;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::shared_ptr<const CachedParse> makeParse(const std::string& body) {
+    auto parse = std::make_shared<CachedParse>();
+    parse->files.push_back(CachedFile{"@.md", body});
+    parse->files.push_back(CachedFile{"images/a.png", std::string(16, 'x')});
+    parse->meta = "{\"pages\":1}";
+    return parse;
+}
+
+fs::path makeTempDir(const std::string& name) {
+    const fs::path dir = fs::temp_directory_path() / ("rapiddoc_result_cache_" + name);
+    fs::remove_all(dir);
+    return dir;
+}
+
+} // namespace
+
+TEST(ResultCacheTest, KeyDependsOnBytesAndSalt) {
+    const std::string key = ResultCache::makeKey("pdf bytes", "formula=1");
+    EXPECT_EQ(key.size(), 32u);
+    EXPECT_EQ(key, ResultCache::makeKey("pdf bytes", "formula=1"));
+    EXPECT_NE(key, ResultCache::makeKey("pdf bytes", "formula=0"));
+    EXPECT_NE(key, ResultCache::makeKey("pdf bytez", "formula=1"));
+    EXPECT_NE(ResultCache::makeKey(std::string(9, 'a'), ""), ResultCache::makeKey(std::string(10, 'a'), ""));
+}
+
+TEST(ResultCacheTest, MemoryTierEvictsLeastRecentlyUsed) {
+    const size_t entryBytes = makeParse("0123456789")->byteSize();
+    ResultCache cache(entryBytes * 2, "", 0);
+    cache.store("a", makeParse("0123456789"));
+    cache.store("b", makeParse("0123456789"));
+    ASSERT_NE(cache.lookup("a"), nullptr);  // b is now the oldest
+    cache.store("c", makeParse("0123456789"));
+
+    EXPECT_NE(cache.lookup("a"), nullptr);
+    EXPECT_EQ(cache.lookup("b"), nullptr);
+    EXPECT_NE(cache.lookup("c"), nullptr);
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.memoryEntries, 2u);
+    EXPECT_EQ(stats.memoryBytes, entryBytes * 2);
+    EXPECT_EQ(stats.memoryHits, 3u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.evictions, 1u);
+}
+
+TEST(ResultCacheTest, DiskTierSurvivesRestartAndPromotes) {
+    const fs::path dir = makeTempDir("disk");
+    {
+        ResultCache cache(0, dir.string(), 1 << 20);
+        cache.store("k1", makeParse("hello"));
+        EXPECT_EQ(cache.stats().diskEntries, 1u);
+    }
+
+    ResultCache cache(1 << 20, dir.string(), 1 << 20);
+    const auto parse = cache.lookup("k1");
+    ASSERT_NE(parse, nullptr);
+    ASSERT_EQ(parse->files.size(), 2u);
+    EXPECT_EQ(parse->files[0].path, "@.md");
+    EXPECT_EQ(parse->files[0].data, "hello");
+    EXPECT_EQ(parse->files[1].path, "images/a.png");
+    EXPECT_EQ(parse->meta, "{\"pages\":1}");
+
+    EXPECT_NE(cache.lookup("k1"), nullptr);
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.diskHits, 1u);
+    EXPECT_EQ(stats.memoryHits, 1u);
+
+    fs::remove_all(dir);
+}
+
+TEST(ResultCacheTest, DiskTierStaysWithinBudget) {
+    const fs::path dir = makeTempDir("budget");
+    const size_t entryBytes = makeParse("0123456789")->byteSize();
+    ResultCache cache(0, dir.string(), entryBytes * 2);
+    cache.store("a", makeParse("0123456789"));
+    cache.store("b", makeParse("0123456789"));
+    cache.store("c", makeParse("0123456789"));
+
+    EXPECT_EQ(cache.stats().diskEntries, 2u);
+    EXPECT_FALSE(fs::exists(dir / "a"));
+    EXPECT_EQ(cache.lookup("a"), nullptr);
+    EXPECT_NE(cache.lookup("c"), nullptr);
+
+    fs::remove_all(dir);
+}
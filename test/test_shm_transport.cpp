@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "server/shm_transport.h"
+
+#include <filesystem>
+#include <string>
+
+using namespace rapid_doc;
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path makeTempDir(const std::string& name) {
+    const fs::path dir = fs::temp_directory_path() / ("rapiddoc_shm_transport_" + name);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+} // namespace
+
+TEST(ShmTransportTest, BodyRoundTripsAndFileIsRemoved) {
+    const fs::path dir = makeTempDir("roundtrip");
+    const std::string path = shm_transport::makeBodyPath(dir.string(), "front_lb");
+    EXPECT_NE(path, shm_transport::makeBodyPath(dir.string(), "front_lb"));
+    const std::string body("multipart\0bytes", 15);
+    ASSERT_TRUE(shm_transport::writeBody(path, body));
+
+    std::string taken;
+    ASSERT_TRUE(shm_transport::takeBody(path, taken));
+    EXPECT_EQ(taken, body);
+    EXPECT_FALSE(fs::exists(path));
+    EXPECT_FALSE(shm_transport::takeBody(path, taken));
+    fs::remove_all(dir);
+}
+
+TEST(ShmTransportTest, OnlyPrefixedFilesInsideTheDirectoryAreAccepted) {
+    const fs::path dir = makeTempDir("paths");
+    const std::string path = shm_transport::makeBodyPath(dir.string(), "lb");
+    EXPECT_TRUE(shm_transport::isBodyPath(dir.string(), path));
+    EXPECT_TRUE(shm_transport::isBodyPath(dir.string(), path + shm_transport::kResponseSuffix));
+    EXPECT_FALSE(shm_transport::isBodyPath("", path));
+    EXPECT_FALSE(shm_transport::isBodyPath(dir.string(), (dir / "other.body").string()));
+    EXPECT_FALSE(shm_transport::isBodyPath(
+        dir.string(), (dir / "sub" / "rapiddoc-lb-x.body").string()));
+    EXPECT_FALSE(shm_transport::isBodyPath(
+        dir.string(), (dir / ".." / "rapiddoc-lb-x.body").string()));
+    fs::remove_all(dir);
+}
+
+TEST(ShmTransportTest, SecretIsCreatedOnceAndSharedThroughTheDirectory) {
+    const fs::path dir = makeTempDir("secret");
+    const std::string secret = shm_transport::loadOrCreateSecret(dir.string());
+    ASSERT_EQ(secret.size(), 64u);
+    EXPECT_EQ(shm_transport::loadOrCreateSecret(dir.string()), secret);
+    EXPECT_EQ(fs::status(dir / shm_transport::kSecretFile).permissions() & fs::perms::all,
+              fs::perms::owner_read | fs::perms::owner_write);
+    EXPECT_FALSE(shm_transport::isBodyPath(
+        dir.string(), (dir / shm_transport::kSecretFile).string()));
+
+    EXPECT_TRUE(shm_transport::secretMatches(secret, secret));
+    EXPECT_FALSE(shm_transport::secretMatches(secret, ""));
+    EXPECT_FALSE(shm_transport::secretMatches(secret, std::string(secret.size(), '0')));
+    EXPECT_FALSE(shm_transport::secretMatches("", ""));
+    fs::remove_all(dir);
+}
+
+TEST(ShmTransportTest, SweepRemovesOnlyStaleTransportFiles) {
+    const fs::path dir = makeTempDir("sweep");
+    const std::string stale = shm_transport::makeBodyPath(dir.string(), "lb") +
+                              shm_transport::kResponseSuffix;
+    const std::string fresh = shm_transport::makeBodyPath(dir.string(), "lb");
+    ASSERT_TRUE(shm_transport::writeBody(stale, "old"));
+    ASSERT_TRUE(shm_transport::writeBody(fresh, "new"));
+    ASSERT_FALSE(shm_transport::loadOrCreateSecret(dir.string()).empty());
+    fs::last_write_time(stale, fs::file_time_type::clock::now() - std::chrono::hours(1));
+    fs::last_write_time(dir / shm_transport::kSecretFile,
+                        fs::file_time_type::clock::now() - std::chrono::hours(1));
+
+    EXPECT_EQ(shm_transport::sweepStale(dir.string(), std::chrono::minutes(5)), 1u);
+    EXPECT_FALSE(fs::exists(stale));
+    EXPECT_TRUE(fs::exists(fresh));
+    EXPECT_TRUE(fs::exists(dir / shm_transport::kSecretFile));
+    fs::remove_all(dir);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "table/table_mask.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace rapid_doc;
+
+TEST(TableMaskDecode, MatchesNarrowThenCompareOnCroppedWindow) {
+    const int maskH = 37;
+    const int maskW = 53;
+    const int top = 3;
+    const int left = 5;
+    const int rows = 29;
+    const int cols = 41;  // not a multiple of the vector width
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> cls(0, 3);
+    std::vector<int64_t> pred(static_cast<size_t>(maskH * maskW));
+    for (auto& v : pred) {
+        v = cls(rng);
+    }
+    pred[static_cast<size_t>(top * maskW + left)] = 257;  // only the low byte counts
+
+    const size_t stride = 48;
+    std::vector<uint8_t> hMask(rows * stride, 7);
+    std::vector<uint8_t> vMask(rows * stride, 7);
+    decodeTableLineMasks(pred.data() + top * maskW + left, maskW, rows, cols,
+                         hMask.data(), stride, vMask.data(), stride);
+
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            const uint8_t narrowed =
+                static_cast<uint8_t>(pred[static_cast<size_t>((top + r) * maskW + left + c)]);
+            ASSERT_EQ(hMask[r * stride + c], narrowed == 1 ? 255 : 0) << r << "," << c;
+            ASSERT_EQ(vMask[r * stride + c], narrowed == 2 ? 255 : 0) << r << "," << c;
+        }
+        for (size_t c = cols; c < stride; ++c) {
+            ASSERT_EQ(hMask[r * stride + c], 7);  // row padding untouched
+        }
+    }
+}
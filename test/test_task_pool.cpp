@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "common/task_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace rapid_doc;
+
+TEST(TaskPoolTest, parallelForVisitsEveryIndexOnce) {
+    TaskPool pool(3);
+    std::vector<std::atomic<int>> hits(64);
+    std::atomic<int> inside{0};
+    std::atomic<int> peak{0};
+
+    pool.parallelFor(hits.size(), [&](size_t i) {
+        const int now = ++inside;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ++hits[i];
+        --inside;
+    });
+
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+    EXPECT_GT(peak.load(), 1);
+    EXPECT_LE(peak.load(), 4);  // three workers plus the caller
+}
+
+TEST(TaskPoolTest, zeroThreadPoolRunsInline) {
+    TaskPool pool(0);
+    const auto caller = std::this_thread::get_id();
+    int calls = 0;
+    pool.parallelFor(5, [&](size_t) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        ++calls;
+    });
+    EXPECT_EQ(calls, 5);
+}
+
+TEST(TaskPoolTest, parallelForRethrowsFirstError) {
+    TaskPool pool(2);
+    std::atomic<int> calls{0};
+    EXPECT_THROW(pool.parallelFor(16, [&](size_t i) {
+        ++calls;
+        if (i == 3) {
+            throw std::runtime_error("boom");
+        }
+    }), std::runtime_error);
+
+    // The pool stays usable afterwards.
+    std::atomic<int> after{0};
+    pool.parallelFor(4, [&](size_t) { ++after; });
+    EXPECT_EQ(after.load(), 4);
+}
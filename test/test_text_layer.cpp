@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "common/text_layer.h"
+
+#include <string>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+TextSpan word(float x0, float y0, float x1, float y1, const std::string& text) {
+    TextSpan span;
+    span.x0 = x0;
+    span.y0 = y0;
+    span.x1 = x1;
+    span.y1 = y1;
+    span.text = text;
+    return span;
+}
+
+LayoutBox box(float x0, float y0, float x1, float y1) {
+    LayoutBox b{};
+    b.x0 = x0;
+    b.y0 = y0;
+    b.x1 = x1;
+    b.y1 = y1;
+    b.category = LayoutCategory::TEXT;
+    return b;
+}
+
+} // namespace
+
+TEST(TextLayerTest, AssemblesWordsInsideBoxIntoLines) {
+    const std::vector<TextSpan> spans = {
+        word(60, 10, 100, 30, "world"),
+        word(10, 10, 50, 30, "Hello"),
+        word(10, 40, 40, 60, "next"),
+        word(500, 10, 540, 30, "elsewhere"),
+    };
+    TextLayerIndex index(spans);
+    std::string text;
+    ASSERT_TRUE(index.textIn(box(0, 0, 200, 100), text));
+    EXPECT_EQ(text, "Hello world\nnext");
+}
+
+TEST(TextLayerTest, JoinsTouchingGlyphsWithoutSpace) {
+    const std::vector<TextSpan> spans = {
+        word(10, 10, 30, 30, "\xe6\x96\x87"),
+        word(30, 10, 50, 30, "\xe6\x9c\xac"),
+    };
+    TextLayerIndex index(spans);
+    std::string text;
+    ASSERT_TRUE(index.textIn(box(0, 0, 100, 50), text));
+    EXPECT_EQ(text, "\xe6\x96\x87\xe6\x9c\xac");
+}
+
+TEST(TextLayerTest, BoxWithoutWordsIsLeftToOcr) {
+    const std::vector<TextSpan> spans = {word(10, 10, 50, 30, "Hello")};
+    TextLayerIndex index(spans);
+    std::string text;
+    EXPECT_FALSE(index.textIn(box(100, 100, 200, 200), text));
+    EXPECT_TRUE(text.empty());
+    EXPECT_FALSE(TextLayerIndex({}).textIn(box(0, 0, 10, 10), text));
+}
+
+TEST(TextLayerTest, RejectsGarbledText) {
+    EXPECT_TRUE(isUsableText("Plain text"));
+    EXPECT_FALSE(isUsableText(""));
+    EXPECT_FALSE(isUsableText("   "));
+    EXPECT_FALSE(isUsableText("\xef\xbf\xbd\xef\xbf\xbd" "ab"));   // U+FFFD
+    EXPECT_FALSE(isUsableText("\xee\x80\x81\xee\x80\x82" "ab"));   // private use
+    EXPECT_FALSE(isUsableText("ab\xff"));                           // invalid UTF-8
+}
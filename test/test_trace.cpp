@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include "common/trace.h"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <thread>
+
+using namespace rapid_doc;
+using json = nlohmann::json;
+
+namespace {
+
+json traceEvents() {
+    return json::parse(Tracer::chromeTraceJson())["traceEvents"];
+}
+
+} // namespace
+
+TEST(TraceTest, RecordsNothingWhileDisabled) {
+    Tracer::disable();
+    Tracer::clear();
+    {
+        TRACE_SPAN("idle", "test");
+    }
+    EXPECT_TRUE(traceEvents().empty());
+}
+
+TEST(TraceTest, ExportsNestedSpansAsCompleteEvents) {
+    Tracer::enable();
+    {
+        TRACE_SPAN("outer", "test");
+        TRACE_SPAN("inner", "test", "detail \"quoted\"");
+    }
+    std::thread([]() { TRACE_SPAN("worker", "test"); }).join();
+    Tracer::disable();
+
+    const json events = traceEvents();
+    ASSERT_EQ(events.size(), 3u);
+    // Inner closes first.
+    EXPECT_EQ(events[0]["name"], "inner");
+    EXPECT_EQ(events[0]["args"]["detail"], "detail \"quoted\"");
+    EXPECT_EQ(events[1]["name"], "outer");
+    EXPECT_EQ(events[1]["ph"], "X");
+    EXPECT_LE(events[1]["ts"].get<int64_t>(), events[0]["ts"].get<int64_t>());
+    EXPECT_GE(events[1]["dur"].get<int64_t>(), events[0]["dur"].get<int64_t>());
+    EXPECT_EQ(events[2]["name"], "worker");
+    EXPECT_NE(events[2]["tid"], events[0]["tid"]);
+}
+
+TEST(TraceTest, RingKeepsTheNewestSpansOldestFirst) {
+    Tracer::enable(4);
+    for (const char* name : {"a", "b", "c", "d", "e", "f"}) {
+        Tracer::record(name, "test", nullptr, Tracer::nowUs(), 0);
+    }
+    Tracer::disable();
+
+    const json events = traceEvents();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0]["name"], "c");
+    EXPECT_EQ(events[3]["name"], "f");
+}
+
+TEST(TraceTest, OwnedDetailNamesTheDocument) {
+    Tracer::disable();
+    EXPECT_TRUE(traceDetail("req-1", 3).empty());
+
+    Tracer::enable();
+    {
+        std::string id = "req-1";
+        TRACE_SPAN("render", "test", traceDetail(id, 3));
+        id = "overwritten";
+    }
+    {
+        TRACE_SPAN("no_id", "test", traceDetail(""));
+    }
+    Tracer::disable();
+
+    const json events = traceEvents();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0]["args"]["detail"], "req-1 page 3");
+    EXPECT_FALSE(events[1].contains("args"));
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "reading_order/xycut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace rapid_doc;
+
+namespace {
+
+LayoutBox makeBox(float x0, float y0, float x1, float y1) {
+    LayoutBox box{};
+    box.x0 = x0;
+    box.y0 = y0;
+    box.x1 = x1;
+    box.y1 = y1;
+    return box;
+}
+
+// Previous pixel-projection implementation, kept as the reference.
+void referenceCut(const std::vector<LayoutBox>& boxes, const std::vector<int>& indices,
+                  bool xFirst, int pageWidth, int pageHeight, const XYCutConfig& config,
+                  std::vector<int>& result) {
+    if (indices.empty()) return;
+    if (indices.size() == 1) {
+        result.push_back(indices[0]);
+        return;
+    }
+    std::vector<LayoutBox> subBoxes;
+    for (int idx : indices) subBoxes.push_back(boxes[idx]);
+
+    const int minGapX = std::max(1, static_cast<int>(pageWidth * config.minGapRatio));
+    const int minGapY = std::max(1, static_cast<int>(pageHeight * config.minGapRatio));
+    const int minVal = static_cast<int>(config.minValueRatio);
+
+    const int axes[2] = {xFirst ? 0 : 1, xFirst ? 1 : 0};
+    for (int axis : axes) {
+        auto proj = detail::projectionByBboxes(subBoxes, axis, axis == 0 ? pageWidth : pageHeight);
+        auto segments = detail::splitProjectionProfile(proj, minVal, axis == 0 ? minGapX : minGapY);
+        if (segments.size() <= 1) continue;
+        for (const auto& seg : segments) {
+            std::vector<int> group;
+            for (size_t i = 0; i < indices.size(); i++) {
+                const float c = axis == 0 ? subBoxes[i].center().x : subBoxes[i].center().y;
+                if (c >= seg.first && c < seg.second) group.push_back(indices[i]);
+            }
+            referenceCut(boxes, group, xFirst, pageWidth, pageHeight, config, result);
+        }
+        return;
+    }
+
+    std::vector<int> sorted = indices;
+    if (xFirst) {
+        std::sort(sorted.begin(), sorted.end(), [&boxes](int a, int b) {
+            float ya = boxes[a].center().y, yb = boxes[b].center().y;
+            float threshold = std::min(boxes[a].height(), boxes[b].height()) * 0.5f;
+            if (std::abs(ya - yb) < threshold) return boxes[a].center().x < boxes[b].center().x;
+            return ya < yb;
+        });
+    } else {
+        std::sort(sorted.begin(), sorted.end(), [&boxes](int a, int b) {
+            float xa = boxes[a].center().x, xb = boxes[b].center().x;
+            float threshold = std::min(boxes[a].width(), boxes[b].width()) * 0.5f;
+            if (std::abs(xa - xb) < threshold) return boxes[a].center().y < boxes[b].center().y;
+            return xa > xb;
+        });
+    }
+    result.insert(result.end(), sorted.begin(), sorted.end());
+}
+
+}  // namespace
+
+TEST(XYCutTest, TwoColumnsReadColumnByColumn) {
+    // Left column: 0 (top), 2 (bottom); right column: 1 (top), 3 (bottom)
+    std::vector<LayoutBox> boxes = {
+        makeBox(50, 100, 450, 140),
+        makeBox(550, 100, 950, 140),
+        makeBox(50, 300, 450, 340),
+        makeBox(550, 300, 950, 340),
+    };
+    XYCutConfig config;
+    config.direction = TextDirection::HORIZONTAL;
+    EXPECT_EQ(xycutPlusSort(boxes, 1000, 1400, config), (std::vector<int>{0, 2, 1, 3}));
+}
+
+TEST(XYCutTest, MatchesPixelProjectionReference) {
+    std::mt19937 rng(7);
+    for (int t = 0; t < 2000; ++t) {
+        const int w = 200 + static_cast<int>(rng() % 1500);
+        const int h = 200 + static_cast<int>(rng() % 2000);
+        const int n = static_cast<int>(rng() % (t % 10 == 0 ? 300 : 40));
+        std::vector<LayoutBox> boxes;
+        for (int i = 0; i < n; ++i) {
+            // Includes off-page and inverted boxes
+            const float x0 = static_cast<float>(static_cast<int>(rng() % (w + 40)) - 20) + (rng() % 100) / 100.0f;
+            const float y0 = static_cast<float>(static_cast<int>(rng() % (h + 40)) - 20) + (rng() % 100) / 100.0f;
+            const float x1 = x0 + static_cast<float>(rng() % (w / 3 + 1)) - (rng() % 10 == 0 ? 5.0f : 0.0f);
+            const float y1 = y0 + static_cast<float>(rng() % (h / 8 + 1));
+            boxes.push_back(makeBox(x0, y0, x1, y1));
+        }
+        XYCutConfig config;
+        config.direction = (t % 2 == 0) ? TextDirection::HORIZONTAL : TextDirection::VERTICAL;
+        config.minGapRatio = static_cast<float>(rng() % 5) * 0.02f;
+        config.minValueRatio = static_cast<float>(rng() % 3);
+
+        std::vector<int> indices(boxes.size());
+        for (int i = 0; i < n; ++i) indices[i] = i;
+        std::vector<int> expected;
+        referenceCut(boxes, indices, config.direction == TextDirection::HORIZONTAL,
+                     w, h, config, expected);
+        ASSERT_EQ(xycutPlusSort(boxes, w, h, config), expected) << "case " << t;
+    }
+}
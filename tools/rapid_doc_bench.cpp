@@ -1,27 +1,44 @@
 /**
  * @file rapid_doc_bench.cpp
  * @brief Phase 2 performance baseline runner for RapidDocCpp.
+ *
+ * By default each case runs its documents one after another on one
+ * pipeline (single-stream latency). --concurrency and --pipelines turn that
+ * into a closed loop of N clients sharing a pool of pipelines, and --rps
+ * into an open loop with Poisson arrivals, whose latency includes the time
+ * a request waited for a free pipeline. --replay runs the cases on
+ * outputs captured earlier with --record, so the scheduling can be measured
+ * deterministically without an NPU.
  */
 
 #include "common/config.h"
 #include "common/perf_utils.h"
+#include "common/trace.h"
 #include "pipeline/doc_pipeline.h"
 
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <random>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <sys/wait.h>
@@ -40,8 +57,25 @@ struct BenchmarkCaseDefinition {
     std::function<void(PipelineConfig&)> configure;
 };
 
+struct LoadOptions {
+    int concurrency = 1;            // closed-loop clients
+    int pipelines = 1;              // DocPipeline instances shared by the clients
+    double targetRps = 0.0;         // > 0: open loop with Poisson arrivals
+    std::vector<int> deviceIds;     // pipeline i uses deviceIds[i % size]
+    std::string recordDir;          // runtime.recordDir for every pipeline
+    std::string replayDir;          // runtime.replayDir for every pipeline
+
+    std::string mode() const {
+        if (targetRps > 0.0) {
+            return "open_loop";
+        }
+        return concurrency > 1 || pipelines > 1 ? "closed_loop" : "serial";
+    }
+};
+
 struct BenchmarkIterationResult {
     double totalTimeMs = 0.0;
+    double latencyMs = 0.0;         // from submission (or arrival) to completion
     int processedPages = 0;
     DocumentStageStats stageStats;
     std::vector<double> pageTimesMs;
@@ -52,9 +86,17 @@ struct BenchmarkCaseResult {
     int warmupIterations = 0;
     std::string status = "ok";
     std::string error;
+    LoadOptions load;
+    double wallTimeMs = 0.0;
     std::vector<BenchmarkIterationResult> iterations;
 };
 
+using SteadyClock = std::chrono::steady_clock;
+
+double elapsedMs(SteadyClock::time_point from, SteadyClock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
 std::string formatMs(double value) {
     std::ostringstream out;
     out << std::fixed << std::setprecision(2) << value << " ms";
@@ -69,6 +111,7 @@ json summaryToJson(const PercentileSummary& summary) {
         {"max_ms", summary.maxMs},
         {"p50_ms", summary.p50Ms},
         {"p95_ms", summary.p95Ms},
+        {"p99_ms", summary.p99Ms},
     };
 }
 
@@ -83,6 +126,8 @@ json stageStatsToJson(const DocumentStageStats& stats) {
         {"unsupported_ms", stats.unsupportedTimeMs},
         {"reading_order_ms", stats.readingOrderTimeMs},
         {"output_gen_ms", stats.outputGenTimeMs},
+        {"npu_serial_ms", stats.npuSerialTimeMs},
+        {"npu_lock_wait_ms", stats.npuLockWaitTimeMs},
         {"tracked_total_ms", totalTrackedStageTimeMs(stats)},
     };
 }
@@ -103,6 +148,8 @@ DocumentStageStats meanStageStats(const std::vector<BenchmarkIterationResult>& i
         mean.unsupportedTimeMs += iteration.stageStats.unsupportedTimeMs;
         mean.readingOrderTimeMs += iteration.stageStats.readingOrderTimeMs;
         mean.outputGenTimeMs += iteration.stageStats.outputGenTimeMs;
+        mean.npuSerialTimeMs += iteration.stageStats.npuSerialTimeMs;
+        mean.npuLockWaitTimeMs += iteration.stageStats.npuLockWaitTimeMs;
     }
 
     const double denom = static_cast<double>(iterations.size());
@@ -115,6 +162,8 @@ DocumentStageStats meanStageStats(const std::vector<BenchmarkIterationResult>& i
     mean.unsupportedTimeMs /= denom;
     mean.readingOrderTimeMs /= denom;
     mean.outputGenTimeMs /= denom;
+    mean.npuSerialTimeMs /= denom;
+    mean.npuLockWaitTimeMs /= denom;
     return mean;
 }
 
@@ -132,10 +181,161 @@ BenchmarkIterationResult runOnce(DocPipeline& pipeline, const std::string& input
     return iteration;
 }
 
+// Pipelines handed to one client at a time, like shards in the server.
+class PipelinePool {
+public:
+    PipelinePool(const PipelineConfig& base, const LoadOptions& load) {
+        for (int i = 0; i < std::max(1, load.pipelines); ++i) {
+            PipelineConfig config = base;
+            if (!load.deviceIds.empty()) {
+                config.runtime.deviceId = load.deviceIds[static_cast<size_t>(i) % load.deviceIds.size()];
+            }
+            pipelines_.push_back(std::make_unique<DocPipeline>(config));
+            idle_.push_back(static_cast<size_t>(i));
+        }
+    }
+
+    bool initialize() {
+        for (auto& pipeline : pipelines_) {
+            if (!pipeline->initialize()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t size() const { return pipelines_.size(); }
+    DocPipeline& at(size_t index) { return *pipelines_[index]; }
+
+    size_t acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !idle_.empty(); });
+        const size_t index = idle_.back();
+        idle_.pop_back();
+        return index;
+    }
+
+    void release(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_.push_back(index);
+        }
+        cv_.notify_one();
+    }
+
+private:
+    std::vector<std::unique_ptr<DocPipeline>> pipelines_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<size_t> idle_;
+};
+
+// Each of load.concurrency clients submits measureIterations documents
+// back to back; a client's latency includes waiting for a free pipeline.
+void runClosedLoop(
+    PipelinePool& pool,
+    const std::string& inputPath,
+    int measureIterations,
+    int concurrency,
+    BenchmarkCaseResult& result)
+{
+    std::mutex resultMutex;
+    std::exception_ptr firstError;
+    std::vector<std::thread> clients;
+    const auto start = SteadyClock::now();
+    for (int client = 0; client < std::max(1, concurrency); ++client) {
+        clients.emplace_back([&]() {
+            for (int i = 0; i < measureIterations; ++i) {
+                const auto submitted = SteadyClock::now();
+                const size_t index = pool.acquire();
+                BenchmarkIterationResult iteration;
+                try {
+                    iteration = runOnce(pool.at(index), inputPath);
+                } catch (...) {
+                    pool.release(index);
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!firstError) {
+                        firstError = std::current_exception();
+                    }
+                    return;
+                }
+                pool.release(index);
+                iteration.latencyMs = elapsedMs(submitted, SteadyClock::now());
+                std::lock_guard<std::mutex> lock(resultMutex);
+                result.iterations.push_back(std::move(iteration));
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    result.wallTimeMs = elapsedMs(start, SteadyClock::now());
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+// measureIterations arrivals at targetRps with exponential gaps, served in
+// arrival order by one worker per pipeline. Latency counts from the
+// scheduled arrival, so it grows with the backlog once the offered load
+// exceeds what the pipelines sustain.
+void runOpenLoop(
+    PipelinePool& pool,
+    const std::string& inputPath,
+    int measureIterations,
+    double targetRps,
+    BenchmarkCaseResult& result)
+{
+    std::mt19937_64 rng(0x5eed);   // fixed, so CI runs offer the same load
+    std::exponential_distribution<double> gapSeconds(targetRps);
+    const auto start = SteadyClock::now();
+    std::vector<SteadyClock::time_point> arrivals;
+    arrivals.reserve(static_cast<size_t>(measureIterations));
+    double offsetSeconds = 0.0;
+    for (int i = 0; i < measureIterations; ++i) {
+        arrivals.push_back(start + std::chrono::duration_cast<SteadyClock::duration>(
+            std::chrono::duration<double>(offsetSeconds)));
+        offsetSeconds += gapSeconds(rng);
+    }
+
+    std::atomic<size_t> next{0};
+    std::mutex resultMutex;
+    std::exception_ptr firstError;
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < pool.size(); ++index) {
+        workers.emplace_back([&, index]() {
+            for (size_t k = next.fetch_add(1); k < arrivals.size(); k = next.fetch_add(1)) {
+                std::this_thread::sleep_until(arrivals[k]);
+                BenchmarkIterationResult iteration;
+                try {
+                    iteration = runOnce(pool.at(index), inputPath);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!firstError) {
+                        firstError = std::current_exception();
+                    }
+                    return;
+                }
+                iteration.latencyMs = elapsedMs(arrivals[k], SteadyClock::now());
+                std::lock_guard<std::mutex> lock(resultMutex);
+                result.iterations.push_back(std::move(iteration));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    result.wallTimeMs = elapsedMs(start, SteadyClock::now());
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
 BenchmarkCaseResult runBenchmarkCase(
     const BenchmarkCaseDefinition& definition,
     int warmupIterations,
     int measureIterations,
+    const LoadOptions& load,
     const std::string& projectRoot,
     const std::string& outputRoot)
 {
@@ -144,24 +344,30 @@ BenchmarkCaseResult runBenchmarkCase(
     config.runtime.saveImages = false;
     config.runtime.saveVisualization = false;
     definition.configure(config);
+    config.runtime.recordDir = load.recordDir;
+    config.runtime.replayDir = load.replayDir;
 
-    DocPipeline pipeline(config);
-    if (!pipeline.initialize()) {
+    PipelinePool pool(config, load);
+    if (!pool.initialize()) {
         throw std::runtime_error("Failed to initialize pipeline for case: " + definition.name);
     }
 
     BenchmarkCaseResult result;
     result.definition = definition;
     result.warmupIterations = warmupIterations;
+    result.load = load;
 
-    for (int i = 0; i < warmupIterations; ++i) {
-        (void)runOnce(pipeline, definition.inputPath);
+    for (size_t index = 0; index < pool.size(); ++index) {
+        for (int i = 0; i < warmupIterations; ++i) {
+            (void)runOnce(pool.at(index), definition.inputPath);
+        }
     }
 
-    for (int i = 0; i < measureIterations; ++i) {
-        result.iterations.push_back(runOnce(pipeline, definition.inputPath));
+    if (load.targetRps > 0.0) {
+        runOpenLoop(pool, definition.inputPath, measureIterations, load.targetRps, result);
+    } else {
+        runClosedLoop(pool, definition.inputPath, measureIterations, load.concurrency, result);
     }
-
     return result;
 }
 
@@ -243,10 +449,41 @@ json buildJsonSummary(const BenchmarkCaseResult& result) {
         allPageTotals.insert(allPageTotals.end(), iteration.pageTimesMs.begin(), iteration.pageTimesMs.end());
     }
 
+    std::vector<double> latencies;
+    std::vector<double> lockWaits;
+    double npuSerialMs = 0.0;
+    int pages = 0;
+    for (const auto& iteration : result.iterations) {
+        latencies.push_back(iteration.latencyMs);
+        lockWaits.push_back(iteration.stageStats.npuLockWaitTimeMs);
+        npuSerialMs += iteration.stageStats.npuSerialTimeMs;
+        pages += iteration.processedPages;
+    }
+    const double wallSeconds = result.wallTimeMs / 1000.0;
+    const int pipelines = std::max(1, result.load.pipelines);
+    const json load{
+        {"mode", result.load.mode()},
+        {"concurrency", result.load.concurrency},
+        {"pipelines", pipelines},
+        {"target_rps", result.load.targetRps},
+        {"device_ids", result.load.deviceIds},
+        {"engines", result.load.replayDir.empty() ? "npu" : "replay"},
+        {"wall_time_ms", result.wallTimeMs},
+        {"documents", result.iterations.size()},
+        {"pages", pages},
+        {"documents_per_sec", wallSeconds > 0.0 ? result.iterations.size() / wallSeconds : 0.0},
+        {"pages_per_sec", wallSeconds > 0.0 ? pages / wallSeconds : 0.0},
+        {"latency", summaryToJson(summarizeSamples(latencies))},
+        // Share of the run each pipeline spent inside NPU-serialized work.
+        {"npu_utilization", result.wallTimeMs > 0.0 ? npuSerialMs / (result.wallTimeMs * pipelines) : 0.0},
+        {"npu_lock_wait", summaryToJson(summarizeSamples(lockWaits))},
+    };
+
     json rawIterations = json::array();
     for (const auto& iteration : result.iterations) {
         rawIterations.push_back(json{
             {"total_time_ms", iteration.totalTimeMs},
+            {"latency_ms", iteration.latencyMs},
             {"processed_pages", iteration.processedPages},
             {"page_times_ms", iteration.pageTimesMs},
             {"stage_stats", stageStatsToJson(iteration.stageStats)},
@@ -263,6 +500,7 @@ json buildJsonSummary(const BenchmarkCaseResult& result) {
         {"document_total", summaryToJson(summarizeSamples(documentTotals))},
         {"page_total", summaryToJson(summarizeSamples(allPageTotals))},
         {"mean_stage_breakdown", stageStatsToJson(meanStageStats(result.iterations))},
+        {"load", load},
         {"iterations", std::move(rawIterations)},
     };
 }
@@ -297,6 +535,19 @@ std::string buildHumanSummary(const json& summary) {
         ? 0
         : iterations.front().value("processed_pages", 0);
     out << "  pages_per_iteration: " << pagesPerIteration << "\n";
+    if (summary.contains("load")) {
+        const auto& load = summary.at("load");
+        const auto& latency = load.at("latency");
+        out << "  load: mode=" << load.value("mode", "serial")
+            << ", concurrency=" << load.value("concurrency", 1)
+            << ", pipelines=" << load.value("pipelines", 1)
+            << ", pages/s=" << std::fixed << std::setprecision(2) << load.value("pages_per_sec", 0.0)
+            << ", npu_utilization=" << load.value("npu_utilization", 0.0) << "\n";
+        out << "  latency: p50=" << formatMs(latency.value("p50_ms", 0.0))
+            << ", p95=" << formatMs(latency.value("p95_ms", 0.0))
+            << ", p99=" << formatMs(latency.value("p99_ms", 0.0))
+            << ", npu_lock_wait_mean=" << formatMs(load.at("npu_lock_wait").value("mean_ms", 0.0)) << "\n";
+    }
     out << "  mean_stage_breakdown:\n";
     out << "    pdf_render=" << formatMs(stageBreakdown.value("pdf_render_ms", 0.0))
         << ", layout=" << formatMs(stageBreakdown.value("layout_ms", 0.0))
@@ -327,9 +578,11 @@ int runWorkerMode(
     const std::string& caseName,
     int warmup,
     int iterations,
+    const LoadOptions& load,
     const std::string& projectRoot,
     const std::string& outputDir,
-    const std::string& jsonOutPath)
+    const std::string& jsonOutPath,
+    const std::string& traceOutPath)
 {
     const auto definitions = makeCases(projectRoot);
     const auto* definition = findCaseDefinition(definitions, caseName);
@@ -338,9 +591,13 @@ int runWorkerMode(
         return 1;
     }
 
+    if (!traceOutPath.empty()) {
+        Tracer::enable();
+    }
+
     BenchmarkCaseResult result;
     try {
-        result = runBenchmarkCase(*definition, warmup, iterations, projectRoot, outputDir);
+        result = runBenchmarkCase(*definition, warmup, iterations, load, projectRoot, outputDir);
     } catch (const std::exception& e) {
         result.definition = *definition;
         result.warmupIterations = warmup;
@@ -354,16 +611,32 @@ int runWorkerMode(
     }
     std::ofstream out(outputPath);
     out << buildJsonSummary(result).dump(2);
+
+    if (!traceOutPath.empty()) {
+        Tracer::disable();
+        if (!Tracer::writeChromeTrace(traceOutPath)) {
+            std::cerr << "Could not write trace: " << traceOutPath << "\n";
+        }
+    }
     return 0;
 }
 
+// One trace per case, since each case runs in its own worker process:
+// trace.json becomes trace.<case>.json.
+std::string caseTracePath(const std::string& traceOutPath, const std::string& caseName) {
+    const fs::path path(traceOutPath);
+    return (path.parent_path() / (path.stem().string() + "." + caseName + path.extension().string())).string();
+}
+
 json runCaseInSubprocess(
     const std::string& binaryPath,
     const BenchmarkCaseDefinition& definition,
     int warmup,
     int iterations,
+    const LoadOptions& load,
     const std::string& projectRoot,
-    const std::string& outputDir)
+    const std::string& outputDir,
+    const std::string& traceOutPath)
 {
     const fs::path workerJsonPath =
         fs::path(outputDir) / (definition.name + "_worker_summary.json");
@@ -380,7 +653,33 @@ json runCaseInSubprocess(
         "--warmup", std::to_string(warmup),
         "--output-dir", outputDir,
         "--project-root", projectRoot,
+        "--concurrency", std::to_string(load.concurrency),
+        "--pipelines", std::to_string(load.pipelines),
     };
+    if (load.targetRps > 0.0) {
+        args.push_back("--rps");
+        args.push_back(std::to_string(load.targetRps));
+    }
+    if (!load.deviceIds.empty()) {
+        std::string ids;
+        for (int id : load.deviceIds) {
+            ids += (ids.empty() ? "" : ",") + std::to_string(id);
+        }
+        args.push_back("--device-ids");
+        args.push_back(ids);
+    }
+    if (!load.recordDir.empty()) {
+        args.push_back("--record");
+        args.push_back(load.recordDir);
+    }
+    if (!load.replayDir.empty()) {
+        args.push_back("--replay");
+        args.push_back(load.replayDir);
+    }
+    if (!traceOutPath.empty()) {
+        args.push_back("--trace-out");
+        args.push_back(caseTracePath(traceOutPath, definition.name));
+    }
 
     pid_t pid = fork();
     if (pid == 0) {
@@ -437,10 +736,18 @@ void printUsage(const char* program) {
     std::cout << "RapidDoc Phase 2 Benchmark\n\n";
     std::cout << "Usage: " << program << " [options]\n\n";
     std::cout << "Options:\n";
-    std::cout << "  --iterations <n>   Measured iterations per case (default: 5)\n";
+    std::cout << "  --iterations <n>   Measured iterations per case and client (default: 5);\n";
+    std::cout << "                     with --rps, the number of arrivals\n";
     std::cout << "  --warmup <n>       Warmup iterations per case (default: 1)\n";
     std::cout << "  --case <name>      Run only the named case (repeatable)\n";
+    std::cout << "  --concurrency <n>  Closed-loop clients submitting back to back (default: 1)\n";
+    std::cout << "  --pipelines <n>    Pipelines shared by the clients (default: 1)\n";
+    std::cout << "  --rps <r>          Open loop: Poisson arrivals at r docs/s, one worker per pipeline\n";
+    std::cout << "  --device-ids <l>   Comma-separated device ids assigned to pipelines round-robin\n";
+    std::cout << "  --record <dir>     Record engine outputs and latencies to <dir>\n";
+    std::cout << "  --replay <dir>     Replay a --record directory instead of running the NPU\n";
     std::cout << "  --json-out <path>  Write JSON summary to file\n";
+    std::cout << "  --trace-out <path> Write a Chrome trace per case (path.<case>.json)\n";
     std::cout << "  --output-dir <p>   Benchmark scratch output dir (default: ./output-benchmark)\n";
     std::cout << "  --project-root <p> Override project root (internal/debug)\n";
     std::cout << "  --help             Show this help\n";
@@ -456,6 +763,8 @@ int main(int argc, char** argv) {
     std::string outputDir = (fs::path(projectRoot) / "output-benchmark").string();
     std::string workerCaseName;
     std::string workerJsonPath;
+    std::string traceOutPath;
+    LoadOptions load;
     std::set<std::string> requestedCases;
 
     for (int i = 1; i < argc; ++i) {
@@ -468,6 +777,25 @@ int main(int argc, char** argv) {
             requestedCases.insert(argv[++i]);
         } else if (arg == "--json-out" && i + 1 < argc) {
             jsonOutPath = argv[++i];
+        } else if (arg == "--concurrency" && i + 1 < argc) {
+            load.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--pipelines" && i + 1 < argc) {
+            load.pipelines = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rps" && i + 1 < argc) {
+            load.targetRps = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--device-ids" && i + 1 < argc) {
+            std::stringstream ids(argv[++i]);
+            for (std::string id; std::getline(ids, id, ',');) {
+                if (!id.empty()) {
+                    load.deviceIds.push_back(std::atoi(id.c_str()));
+                }
+            }
+        } else if (arg == "--record" && i + 1 < argc) {
+            load.recordDir = fs::absolute(argv[++i]).string();
+        } else if (arg == "--replay" && i + 1 < argc) {
+            load.replayDir = fs::absolute(argv[++i]).string();
+        } else if (arg == "--trace-out" && i + 1 < argc) {
+            traceOutPath = argv[++i];
         } else if (arg == "--output-dir" && i + 1 < argc) {
             outputDir = argv[++i];
         } else if (arg == "--project-root" && i + 1 < argc) {
@@ -494,7 +822,7 @@ int main(int argc, char** argv) {
             return 1;
         }
         return runWorkerMode(
-            workerCaseName, warmup, iterations, projectRoot, outputDir, workerJsonPath);
+            workerCaseName, warmup, iterations, load, projectRoot, outputDir, workerJsonPath, traceOutPath);
     }
 
     std::vector<BenchmarkCaseDefinition> selectedCases;
@@ -515,6 +843,7 @@ int main(int argc, char** argv) {
             std::chrono::system_clock::now().time_since_epoch()).count();
     root["iterations"] = iterations;
     root["warmup"] = warmup;
+    root["load_mode"] = load.mode();
     root["cases"] = json::array();
     const std::string binaryPath = fs::absolute(argv[0]).string();
 
@@ -526,7 +855,7 @@ int main(int argc, char** argv) {
         }
 
         const json summary = runCaseInSubprocess(
-            binaryPath, definition, warmup, iterations, projectRoot, outputDir);
+            binaryPath, definition, warmup, iterations, load, projectRoot, outputDir, traceOutPath);
         std::cout << buildHumanSummary(summary) << "\n";
         root["cases"].push_back(summary);
     }
@@ -6,12 +6,13 @@
  *   {output_dir}/{pdf_stem}/{pdf_stem}.md, content_list.json, layout_page_*.json, summary.json
  *
  * Usage:
- *   ./run_cpp_e2e [--pdf-dir test_files] [--output test/fixtures/e2e/cpp]
+ *   ./run_cpp_e2e [--pdf-dir test_files] [--output test/fixtures/e2e/cpp] [--trace-out trace.json]
  * Project root is set at build time (CMake PROJECT_ROOT_DIR); use --project-root to override.
  */
 
 #include "pipeline/doc_pipeline.h"
 #include "common/config.h"
+#include "common/trace.h"
 #include "output/markdown_writer.h"
 #include "output/content_list.h"
 
@@ -56,13 +57,14 @@ static void saveContentList(const DocumentResult& result, const std::string& out
     f << clJson;
 }
 
-static json makeSummary(const DocumentResult& result, const std::string& pdfName, double totalMs) {
+static json makeSummary(const DocumentResult& result, const std::string& pdfName, double totalMs,
+                        size_t markdownChars) {
     json summary;
     summary["pdf"] = pdfName;
     summary["stem"] = fs::path(pdfName).stem().string();
     summary["total_pages"] = result.processedPages;
     summary["total_time_ms"] = totalMs;
-    summary["markdown_chars"] = static_cast<int>(result.markdown.size());
+    summary["markdown_chars"] = static_cast<int>(markdownChars);
     summary["skipped_elements"] = result.skippedElements;
 
     json pages = json::array();
@@ -100,6 +102,7 @@ int main(int argc, char** argv) {
     std::string projectRoot = getDefaultProjectRoot();
     std::string pdfDir = "test_files";
     std::string outputDir = "test/fixtures/e2e/cpp";
+    std::string traceOutPath;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -109,6 +112,8 @@ int main(int argc, char** argv) {
             pdfDir = argv[++i];
         else if (arg == "--output" && i + 1 < argc)
             outputDir = argv[++i];
+        else if (arg == "--trace-out" && i + 1 < argc)
+            traceOutPath = argv[++i];
     }
 
     // Resolve relative paths against project root so CWD doesn't matter
@@ -124,6 +129,9 @@ int main(int argc, char** argv) {
     cfg.runtime.saveImages = true;
     cfg.runtime.outputDir = outputDir;
 
+    if (!traceOutPath.empty())
+        Tracer::enable();
+
     std::cerr << "Initializing pipeline..." << std::endl;
     DocPipeline pipeline(cfg);
     if (!pipeline.initialize()) {
@@ -161,8 +169,9 @@ int main(int argc, char** argv) {
             double totalMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
 
             // Save markdown
+            const std::string markdown = MarkdownWriter().generate(result);
             std::ofstream mdFile(outPath + "/" + stem + ".md");
-            mdFile << result.markdown;
+            mdFile << markdown;
 
             // Save layout per page
             savePageLayouts(result, outPath);
@@ -171,14 +180,14 @@ int main(int argc, char** argv) {
             saveContentList(result, outPath);
 
             // Save summary
-            json summary = makeSummary(result, pdf.filename().string(), totalMs);
+            json summary = makeSummary(result, pdf.filename().string(), totalMs, markdown.size());
             std::ofstream sumFile(outPath + "/summary.json");
             sumFile << summary.dump(2);
 
             allSummaries.push_back(summary);
 
             std::cerr << "  Pages: " << result.processedPages
-                      << ", MD: " << result.markdown.size() << " chars"
+                      << ", MD: " << markdown.size() << " chars"
                       << ", Time: " << totalMs << " ms" << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "  ERROR: " << e.what() << std::endl;
@@ -191,5 +200,14 @@ int main(int argc, char** argv) {
 
     std::cerr << "\nDone! " << allSummaries.size() << " PDFs processed" << std::endl;
     std::cerr << "Results saved to: " << outputDir << std::endl;
+
+    if (!traceOutPath.empty()) {
+        Tracer::disable();
+        if (!Tracer::writeChromeTrace(traceOutPath)) {
+            std::cerr << "ERROR: Could not write trace: " << traceOutPath << std::endl;
+            return 1;
+        }
+        std::cerr << "Trace saved to: " << traceOutPath << std::endl;
+    }
     return 0;
 }